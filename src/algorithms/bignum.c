@@ -0,0 +1,793 @@
+/*
+ * bignum.c - Arbitrary-Precision Integers for Factorials and Fibonacci (see bignum.h)
+ */
+
+#include "bignum.h"
+#include "../concurrency/scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned __int128 uint128;
+
+// ========== Limb Arrays ==========
+
+static uint64_t* allocLimbs(size_t count) {
+    uint64_t* limbs = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (limbs == NULL) {
+        printf("Memory allocation failed\n");
+    }
+    return limbs;
+}
+
+static size_t trimmedLength(const uint64_t* limbs, size_t length) {
+    while (length > 0 && limbs[length - 1] == 0) {
+        length--;
+    }
+    return length;
+}
+
+// Replace x's limbs with a new array (x takes ownership)
+static void adopt(BigNum* x, uint64_t* limbs, size_t length, size_t capacity) {
+    if (x->limbs != limbs) {
+        free(x->limbs);
+    }
+    x->limbs = limbs;
+    x->length = trimmedLength(limbs, length);
+    x->capacity = capacity;
+}
+
+// r = a + b for na >= nb, r has na limbs (may be a or b); returns the carry
+static uint64_t addLimbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < nb; i++) {
+        uint64_t sum;
+        uint64_t overflow = __builtin_add_overflow(a[i], b[i], &sum);
+        overflow |= __builtin_add_overflow(sum, carry, &sum);
+        r[i] = sum;
+        carry = overflow;
+    }
+    for (; i < na; i++) {
+        r[i] = a[i] + carry;
+        carry = r[i] < carry;
+    }
+    return carry;
+}
+
+// r = a - b for na >= nb; returns the borrow
+static uint64_t subLimbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < nb; i++) {
+        uint64_t difference;
+        uint64_t underflow = __builtin_sub_overflow(a[i], b[i], &difference);
+        underflow |= __builtin_sub_overflow(difference, borrow, &difference);
+        r[i] = difference;
+        borrow = underflow;
+    }
+    for (; i < na; i++) {
+        uint64_t before = a[i];
+        r[i] = before - borrow;
+        borrow = before < borrow;
+    }
+    return borrow;
+}
+
+// ========== Basics ==========
+
+bool bigInit(BigNum* x, uint64_t value) {
+    x->limbs = allocLimbs(1);
+    if (x->limbs == NULL) {
+        x->length = x->capacity = 0;
+        return false;
+    }
+    x->limbs[0] = value;
+    x->length = value != 0;
+    x->capacity = 1;
+    return true;
+}
+
+void bigFree(BigNum* x) {
+    free(x->limbs);
+    x->limbs = NULL;
+    x->length = x->capacity = 0;
+}
+
+bool bigCopy(BigNum* destination, const BigNum* source) {
+    if (destination == source) {
+        return true;
+    }
+    uint64_t* limbs = allocLimbs(source->length);
+    if (limbs == NULL) {
+        return false;
+    }
+    memcpy(limbs, source->limbs, source->length * sizeof(uint64_t));
+    adopt(destination, limbs, source->length, source->length);
+    return true;
+}
+
+int bigCompare(const BigNum* a, const BigNum* b) {
+    if (a->length != b->length) {
+        return a->length < b->length ? -1 : 1;
+    }
+    for (size_t i = a->length; i-- > 0;) {
+        if (a->limbs[i] != b->limbs[i]) {
+            return a->limbs[i] < b->limbs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+size_t bigBitLength(const BigNum* x) {
+    if (x->length == 0) {
+        return 0;
+    }
+    return 64 * x->length - (size_t)__builtin_clzll(x->limbs[x->length - 1]);
+}
+
+uint64_t bigModSmall(const BigNum* x, uint64_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = x->length; i-- > 0;) {
+        remainder = (uint64_t)((((uint128)remainder << 64) | x->limbs[i]) % divisor);
+    }
+    return remainder;
+}
+
+#define DECIMAL_CHUNK 10000000000000000000ull   // 10^19, the largest power of 10 in a limb
+
+char* bigToDecimal(const BigNum* x) {
+    size_t length = x->length;
+    size_t maxChunks = length * 64 / 63 + 1;   // 10^19 > 2^63
+    uint64_t* work = allocLimbs(length);
+    uint64_t* chunks = allocLimbs(maxChunks);
+    char* text = malloc(maxChunks * 19 + 2);
+    if (work == NULL || chunks == NULL || text == NULL) {
+        free(work);
+        free(chunks);
+        free(text);
+        return NULL;
+    }
+    memcpy(work, x->limbs, length * sizeof(uint64_t));
+
+    // Divide by 10^19 until nothing is left; the remainders are the chunks
+    size_t count = 0;
+    while (length > 0) {
+        uint64_t remainder = 0;
+        for (size_t i = length; i-- > 0;) {
+            uint128 current = ((uint128)remainder << 64) | work[i];
+            work[i] = (uint64_t)(current / DECIMAL_CHUNK);
+            remainder = (uint64_t)(current % DECIMAL_CHUNK);
+        }
+        chunks[count++] = remainder;
+        length = trimmedLength(work, length);
+    }
+
+    if (count == 0) {
+        strcpy(text, "0");
+    } else {
+        char* end = text + sprintf(text, "%llu", (unsigned long long)chunks[count - 1]);
+        for (size_t i = count - 1; i-- > 0;) {
+            end += sprintf(end, "%019llu", (unsigned long long)chunks[i]);
+        }
+    }
+    free(work);
+    free(chunks);
+    return text;
+}
+
+// ========== Addition, Subtraction and Shifts ==========
+
+bool bigAdd(BigNum* result, const BigNum* a, const BigNum* b) {
+    if (a->length < b->length) {
+        const BigNum* swap = a;
+        a = b;
+        b = swap;
+    }
+    uint64_t* limbs = allocLimbs(a->length + 1);
+    if (limbs == NULL) {
+        return false;
+    }
+    limbs[a->length] = addLimbs(limbs, a->limbs, a->length, b->limbs, b->length);
+    adopt(result, limbs, a->length + 1, a->length + 1);
+    return true;
+}
+
+bool bigSub(BigNum* result, const BigNum* a, const BigNum* b) {
+    uint64_t* limbs = allocLimbs(a->length);
+    if (limbs == NULL) {
+        return false;
+    }
+    subLimbs(limbs, a->limbs, a->length, b->limbs, b->length);
+    adopt(result, limbs, a->length, a->length);
+    return true;
+}
+
+bool bigShiftLeft(BigNum* result, const BigNum* a, size_t bits) {
+    size_t words = bits / 64;
+    unsigned shift = bits % 64;
+    size_t length = a->length + words + 1;
+    uint64_t* limbs = allocLimbs(length);
+    if (limbs == NULL) {
+        return false;
+    }
+    memset(limbs, 0, words * sizeof(uint64_t));
+    uint64_t carry = 0;
+    for (size_t i = 0; i < a->length; i++) {
+        limbs[words + i] = a->limbs[i] << shift | carry;
+        carry = shift != 0 ? a->limbs[i] >> (64 - shift) : 0;
+    }
+    limbs[length - 1] = carry;
+    adopt(result, limbs, length, length);
+    return true;
+}
+
+bool bigMulSmall(BigNum* result, const BigNum* a, uint64_t factor) {
+    size_t n = a->length;
+    uint64_t* limbs = result->limbs;
+    size_t capacity = result->capacity;
+    // In place when there is room; a growing product reserves extra space
+    if (result != a || capacity < n + 1) {
+        capacity = result == a ? 2 * n + 2 : n + 1;
+        limbs = allocLimbs(capacity);
+        if (limbs == NULL) {
+            return false;
+        }
+    }
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint128 product = (uint128)a->limbs[i] * factor + carry;
+        limbs[i] = (uint64_t)product;
+        carry = (uint64_t)(product >> 64);
+    }
+    limbs[n] = carry;
+    adopt(result, limbs, n + 1, capacity);
+    return true;
+}
+
+// ========== Schoolbook and Karatsuba ==========
+
+// r[0 .. na + nb) = a * b for na >= nb >= 1; r must not overlap a or b
+static void mulSchoolbook(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < na; i++) {
+        uint128 product = (uint128)a[i] * b[0] + carry;
+        r[i] = (uint64_t)product;
+        carry = (uint64_t)(product >> 64);
+    }
+    r[na] = carry;
+    for (size_t j = 1; j < nb; j++) {
+        carry = 0;
+        for (size_t i = 0; i < na; i++) {
+            uint128 product = (uint128)a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = (uint64_t)product;
+            carry = (uint64_t)(product >> 64);
+        }
+        r[na + j] = carry;
+    }
+}
+
+// Limbs of scratch space karatsuba() needs for n-limb operands
+static size_t karatsubaScratch(size_t n) {
+    size_t total = 0;
+    while (n >= KARATSUBA_THRESHOLD) {
+        size_t high = n - n / 2;
+        total += 4 * (high + 1);
+        n = high + 1;
+    }
+    return total;
+}
+
+// r[0 .. 2n) = a * b for two n-limb operands. With a = a1*B + a0 and
+// b = b1*B + b0: a*b = z2*B^2 + (z1 - z2 - z0)*B + z0, where z0 = a0*b0,
+// z2 = a1*b1 and z1 = (a0 + a1)(b0 + b1)
+static void karatsuba(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n, uint64_t* scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        mulSchoolbook(r, a, n, b, n);
+        return;
+    }
+    size_t low = n / 2;
+    size_t high = n - low;
+    uint64_t* sumA = scratch;
+    uint64_t* sumB = sumA + high + 1;
+    uint64_t* middle = sumB + high + 1;       // 2 * (high + 1) limbs
+    uint64_t* next = middle + 2 * (high + 1);
+
+    sumA[high] = addLimbs(sumA, a + low, high, a, low);
+    sumB[high] = addLimbs(sumB, b + low, high, b, low);
+    karatsuba(r, a, b, low, next);
+    karatsuba(r + 2 * low, a + low, b + low, high, next);
+    karatsuba(middle, sumA, sumB, high + 1, next);
+    subLimbs(middle, middle, 2 * high + 2, r, 2 * low);
+    subLimbs(middle, middle, 2 * high + 2, r + 2 * low, 2 * high);
+    addLimbs(r + low, r + low, 2 * n - low, middle, 2 * high + 2);
+}
+
+static bool multiplyLimbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb,
+                          BigMulMethod method);
+
+static bool mulKaratsuba(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    size_t scratchLength = karatsubaScratch(nb);
+    uint64_t* scratch = allocLimbs(scratchLength + 2 * nb);
+    if (scratch == NULL) {
+        return false;
+    }
+    bool ok = true;
+    if (na == nb) {
+        karatsuba(r, a, b, nb, scratch);
+    } else {
+        // Unbalanced: multiply b by each nb-limb piece of a and add at its offset
+        uint64_t* piece = scratch + scratchLength;
+        memset(r, 0, (na + nb) * sizeof(uint64_t));
+        for (size_t offset = 0; offset < na && ok; offset += nb) {
+            size_t chunk = na - offset < nb ? na - offset : nb;
+            if (chunk == nb) {
+                karatsuba(piece, a + offset, b, nb, scratch);
+            } else {
+                ok = multiplyLimbs(piece, b, nb, a + offset, chunk, BIG_MUL_AUTO);
+            }
+            addLimbs(r + offset, r + offset, na + nb - offset, piece, chunk + nb);
+        }
+    }
+    free(scratch);
+    return ok;
+}
+
+// ========== Number-Theoretic Transform ==========
+//
+// The limbs are cut into pieces of 16 to 30 bits and the pieces of the
+// product are the convolution of the pieces of a and b, computed with an
+// FFT over the integers modulo p = 2^64 - 2^32 + 1. The piece width is
+// chosen so that each convolution term stays below p and comes out exact:
+// wider for short numbers, 22 bits around a million digits. p has roots of unity of every
+// power-of-2 order up to 2^32, and reducing modulo p needs no division.
+
+#define NTT_PRIME 0xFFFFFFFF00000001ull
+#define NTT_GENERATOR 7             // generates the multiplicative group mod p
+#define NTT_BLOCK 1024              // transforms up to this size run as loops
+#define NTT_PARALLEL (1 << 16)      // larger transforms split into tasks
+
+// Branch-free: the conditions depend on the data and would mispredict
+static inline uint64_t modAdd(uint64_t a, uint64_t b) {
+    uint64_t sum;
+    uint64_t overflow = __builtin_add_overflow(a, b, &sum);
+    uint64_t reduce = overflow | (sum >= NTT_PRIME);
+    return sum - (NTT_PRIME & -reduce);
+}
+
+static inline uint64_t modSub(uint64_t a, uint64_t b) {
+    uint64_t difference;
+    uint64_t borrow = __builtin_sub_overflow(a, b, &difference);
+    return difference + (NTT_PRIME & -borrow);
+}
+
+// 2^64 = 2^32 - 1 and 2^96 = -1 (mod p)
+static inline uint64_t modMul(uint64_t a, uint64_t b) {
+    uint128 product = (uint128)a * b;
+    uint64_t low = (uint64_t)product;
+    uint64_t high = (uint64_t)(product >> 64);
+    uint64_t highHigh = high >> 32;
+    uint64_t highLow = high & 0xFFFFFFFF;
+    uint64_t value;
+    uint64_t borrow = __builtin_sub_overflow(low, highHigh, &value);
+    value -= 0xFFFFFFFF & -borrow;
+    uint64_t carry = __builtin_add_overflow(value, (highLow << 32) - highLow, &value);
+    value += 0xFFFFFFFF & -carry;
+    return value - (NTT_PRIME & -(uint64_t)(value >= NTT_PRIME));
+}
+
+static uint64_t modPow(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result = modMul(result, base);
+        }
+        base = modMul(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// twiddles[h + i] = w^i for i < h, w a root of unity of order 2h, for
+// every power of 2 h < n: each level of the transform reads a contiguous run
+static void buildTwiddles(uint64_t* twiddles, size_t n, bool inverse) {
+    for (size_t h = 1; h < n; h *= 2) {
+        uint64_t root = modPow(NTT_GENERATOR, (NTT_PRIME - 1) / (2 * h));
+        if (inverse) {
+            root = modPow(root, NTT_PRIME - 2);
+        }
+        uint64_t power = 1;
+        for (size_t i = 0; i < h; i++) {
+            twiddles[h + i] = power;
+            power = modMul(power, root);
+        }
+    }
+}
+
+typedef struct {
+    uint64_t* data;
+    size_t n;
+    const uint64_t* twiddles;
+} Transform;
+
+static void runHalves(TaskFunction function, Transform* left, Transform* right) {
+    if (left->n * 2 >= NTT_PARALLEL) {
+        TaskGroup group;
+        taskGroupInit(&group);
+        taskSpawn(&group, function, left);
+        function(right);
+        taskSync(&group);
+    } else {
+        function(left);
+        function(right);
+    }
+}
+
+// Decimation in frequency: butterflies over the whole array, then the two
+// halves are independent transforms. The output is in bit-reversed order,
+// which the pointwise product does not mind.
+static void nttForward(void* arg) {
+    Transform* job = arg;
+    uint64_t* a = job->data;
+    size_t n = job->n;
+    if (n <= NTT_BLOCK) {
+        for (size_t length = n; length >= 2; length /= 2) {
+            size_t h = length / 2;
+            const uint64_t* w = job->twiddles + h;
+            for (size_t block = 0; block < n; block += length) {
+                for (size_t i = 0; i < h; i++) {
+                    uint64_t u = a[block + i];
+                    uint64_t v = a[block + i + h];
+                    a[block + i] = modAdd(u, v);
+                    a[block + i + h] = modMul(modSub(u, v), w[i]);
+                }
+            }
+        }
+        return;
+    }
+    size_t h = n / 2;
+    const uint64_t* w = job->twiddles + h;
+    for (size_t i = 0; i < h; i++) {
+        uint64_t u = a[i];
+        uint64_t v = a[i + h];
+        a[i] = modAdd(u, v);
+        a[i + h] = modMul(modSub(u, v), w[i]);
+    }
+    Transform left = { a, h, job->twiddles };
+    Transform right = { a + h, h, job->twiddles };
+    runHalves(nttForward, &left, &right);
+}
+
+// The forward steps undone in reverse order (decimation in time): takes
+// bit-reversed input and leaves n times the natural-order result
+static void nttInverse(void* arg) {
+    Transform* job = arg;
+    uint64_t* a = job->data;
+    size_t n = job->n;
+    if (n <= NTT_BLOCK) {
+        for (size_t length = 2; length <= n; length *= 2) {
+            size_t h = length / 2;
+            const uint64_t* w = job->twiddles + h;
+            for (size_t block = 0; block < n; block += length) {
+                for (size_t i = 0; i < h; i++) {
+                    uint64_t u = a[block + i];
+                    uint64_t v = modMul(a[block + i + h], w[i]);
+                    a[block + i] = modAdd(u, v);
+                    a[block + i + h] = modSub(u, v);
+                }
+            }
+        }
+        return;
+    }
+    size_t h = n / 2;
+    Transform left = { a, h, job->twiddles };
+    Transform right = { a + h, h, job->twiddles };
+    runHalves(nttInverse, &left, &right);
+    const uint64_t* w = job->twiddles + h;
+    for (size_t i = 0; i < h; i++) {
+        uint64_t u = a[i];
+        uint64_t v = modMul(a[i + h], w[i]);
+        a[i] = modAdd(u, v);
+        a[i + h] = modSub(u, v);
+    }
+}
+
+// Pieces of `bits` bits each, zero-padded to n
+static void splitPieces(uint64_t* pieces, size_t n, const uint64_t* limbs, size_t length, int bits) {
+    size_t count = (64 * length + (size_t)bits - 1) / (size_t)bits;
+    uint64_t mask = (1ull << bits) - 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t position = i * (size_t)bits;
+        size_t word = position / 64;
+        unsigned offset = position % 64;
+        uint64_t value = limbs[word] >> offset;
+        if (offset + (unsigned)bits > 64 && word + 1 < length) {
+            value |= limbs[word + 1] << (64 - offset);
+        }
+        pieces[i] = value & mask;
+    }
+    memset(pieces + count, 0, (n - count) * sizeof(uint64_t));
+}
+
+static bool mulNtt(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+    bool square = a == b && na == nb;
+    // The widest pieces whose convolution terms, at most
+    // min(count) * (2^bits - 1)^2, stay below p
+    int bits = 30;
+    for (;; bits--) {
+        uint128 count = (64 * (uint128)nb + (unsigned)bits - 1) / (unsigned)bits;
+        uint128 largest = ((uint128)1 << bits) - 1;
+        if (bits == 16 || count * largest * largest < NTT_PRIME) {
+            break;
+        }
+    }
+    size_t pieces = (64 * na + (size_t)bits - 1) / (size_t)bits + (64 * nb + (size_t)bits - 1) / (size_t)bits;
+    size_t n = 1;
+    while (n < pieces) {
+        n *= 2;
+    }
+    uint64_t* fa = allocLimbs(n);
+    uint64_t* fb = square ? fa : allocLimbs(n);
+    uint64_t* twiddles = allocLimbs(n);
+    uint64_t* inverseTwiddles = allocLimbs(n);
+    bool ok = fa != NULL && fb != NULL && twiddles != NULL && inverseTwiddles != NULL;
+    if (ok) {
+        buildTwiddles(twiddles, n, false);
+        buildTwiddles(inverseTwiddles, n, true);
+        splitPieces(fa, n, a, na, bits);
+        Transform first = { fa, n, twiddles };
+        if (square) {
+            nttForward(&first);
+        } else {
+            splitPieces(fb, n, b, nb, bits);
+            Transform second = { fb, n, twiddles };
+            runHalves(nttForward, &first, &second);
+        }
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = modMul(fa[i], fb[i]);
+        }
+        Transform product = { fa, n, inverseTwiddles };
+        nttInverse(&product);
+
+        // Divide by n and add term k at bit k * bits. `pending` holds the
+        // bits from `base` up; the limbs below bit (k + 1) * bits are final.
+        uint64_t scale = modPow(n, NTT_PRIME - 2);
+        uint128 pending = 0;
+        size_t base = 0;
+        size_t limb = 0;
+        for (size_t k = 0; k < pieces && limb < na + nb; k++) {
+            pending += (uint128)modMul(fa[k], scale) << (k * (size_t)bits - base);
+            while ((k + 1) * (size_t)bits - base >= 64 && limb < na + nb) {
+                r[limb++] = (uint64_t)pending;
+                pending >>= 64;
+                base += 64;
+            }
+        }
+        while (limb < na + nb) {
+            r[limb++] = (uint64_t)pending;
+            pending >>= 64;
+        }
+    }
+    if (fb != fa) {
+        free(fb);
+    }
+    free(fa);
+    free(twiddles);
+    free(inverseTwiddles);
+    return ok;
+}
+
+// ========== Multiplication ==========
+
+static bool multiplyLimbs(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb,
+                          BigMulMethod method) {
+    if (method == BIG_MUL_AUTO) {
+        method = nb < KARATSUBA_THRESHOLD ? BIG_MUL_SCHOOLBOOK
+               : na + nb >= NTT_THRESHOLD ? BIG_MUL_NTT
+               : BIG_MUL_KARATSUBA;
+    }
+    switch (method) {
+        case BIG_MUL_KARATSUBA:
+            return mulKaratsuba(r, a, na, b, nb);
+        case BIG_MUL_NTT:
+            return mulNtt(r, a, na, b, nb);
+        default:
+            mulSchoolbook(r, a, na, b, nb);
+            return true;
+    }
+}
+
+bool bigMulWith(BigNum* result, const BigNum* a, const BigNum* b, BigMulMethod method) {
+    if (a->length < b->length) {
+        const BigNum* swap = a;
+        a = b;
+        b = swap;
+    }
+    if (b->length == 0) {
+        result->length = 0;
+        return true;
+    }
+    size_t length = a->length + b->length;
+    uint64_t* limbs = allocLimbs(length);
+    if (limbs == NULL) {
+        return false;
+    }
+    if (!multiplyLimbs(limbs, a->limbs, a->length, b->limbs, b->length, method)) {
+        free(limbs);
+        return false;
+    }
+    adopt(result, limbs, length, length);
+    return true;
+}
+
+bool bigMul(BigNum* result, const BigNum* a, const BigNum* b) {
+    return bigMulWith(result, a, b, BIG_MUL_AUTO);
+}
+
+// ========== Factorials ==========
+
+#define PRODUCT_LEAF 256            // ranges this short are multiplied one by one
+#define PRODUCT_PARALLEL 16384      // ranges this long split into tasks
+
+typedef struct {
+    uint64_t low;
+    uint64_t high;
+    BigNum product;   // of the odd parts of low..high
+    bool ok;
+} RangeProduct;
+
+static void rangeProduct(void* arg) {
+    RangeProduct* job = arg;
+    job->ok = bigInit(&job->product, 1);
+    if (!job->ok) {
+        return;
+    }
+    if (job->high - job->low < PRODUCT_LEAF) {
+        // Pack factors into one word until it would overflow
+        uint64_t word = 1;
+        for (uint64_t i = job->low; i <= job->high && job->ok; i++) {
+            uint64_t odd = i >> __builtin_ctzll(i);
+            uint64_t packed;
+            if (__builtin_mul_overflow(word, odd, &packed)) {
+                job->ok = bigMulSmall(&job->product, &job->product, word);
+                packed = odd;
+            }
+            word = packed;
+        }
+        job->ok = job->ok && bigMulSmall(&job->product, &job->product, word);
+        return;
+    }
+    uint64_t middle = job->low + (job->high - job->low) / 2;
+    RangeProduct left = { job->low, middle, { NULL, 0, 0 }, false };
+    RangeProduct right = { middle + 1, job->high, { NULL, 0, 0 }, false };
+    if (job->high - job->low >= PRODUCT_PARALLEL) {
+        TaskGroup group;
+        taskGroupInit(&group);
+        taskSpawn(&group, rangeProduct, &left);
+        rangeProduct(&right);
+        taskSync(&group);
+    } else {
+        rangeProduct(&left);
+        rangeProduct(&right);
+    }
+    job->ok = left.ok && right.ok && bigMul(&job->product, &left.product, &right.product);
+    bigFree(&left.product);
+    bigFree(&right.product);
+}
+
+bool bigFactorial(BigNum* result, uint64_t n) {
+    if (n < 2) {
+        bigFree(result);
+        return bigInit(result, 1);
+    }
+    RangeProduct all = { 1, n, { NULL, 0, 0 }, false };
+    rangeProduct(&all);
+    // 1..n hold n - popcount(n) factors of 2 in total
+    bool ok = all.ok && bigShiftLeft(result, &all.product, n - (uint64_t)__builtin_popcountll(n));
+    bigFree(&all.product);
+    return ok;
+}
+
+bool factorialTableInit(FactorialTable* table) {
+    table->values = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    return true;
+}
+
+bool factorialTableExtend(FactorialTable* table, size_t count) {
+    if (count > table->capacity) {
+        size_t capacity = table->capacity * 2 > count ? table->capacity * 2 : count;
+        BigNum* values = realloc(table->values, capacity * sizeof(BigNum));
+        if (values == NULL) {
+            printf("Memory allocation failed\n");
+            return false;
+        }
+        table->values = values;
+        table->capacity = capacity;
+    }
+    while (table->count < count) {
+        size_t i = table->count;
+        if (!bigInit(&table->values[i], 1)) {
+            return false;
+        }
+        if (i > 1 && !bigMulSmall(&table->values[i], &table->values[i - 1], i)) {
+            bigFree(&table->values[i]);
+            return false;
+        }
+        table->count++;
+    }
+    return true;
+}
+
+void factorialTableFree(FactorialTable* table) {
+    for (size_t i = 0; i < table->count; i++) {
+        bigFree(&table->values[i]);
+    }
+    free(table->values);
+    table->values = NULL;
+    table->count = table->capacity = 0;
+}
+
+// ========== Fibonacci ==========
+
+#define SQUARE_PARALLEL 2048   // limbs from which the squarings run as tasks
+
+typedef struct {
+    BigNum* result;
+    const BigNum* value;
+    bool ok;
+} Square;
+
+static void squareTask(void* arg) {
+    Square* job = arg;
+    job->ok = bigMul(job->result, job->value, job->value);
+}
+
+// From (F(k), F(k+1)), with A = F(k)^2, B = F(k+1)^2, C = (F(k) + F(k+1))^2:
+//   F(2k + 1) = A + B
+//   F(2k)     = F(k) * (2F(k+1) - F(k)) = C - 2A - B
+bool bigFibonacci(BigNum* result, uint64_t n) {
+    BigNum f, g, sum, a, b, c;
+    bool ok = bigInit(&f, 0) & bigInit(&g, 1) & bigInit(&sum, 0) &
+              bigInit(&a, 0) & bigInit(&b, 0) & bigInit(&c, 0);
+    for (int bit = n > 0 ? 63 - __builtin_clzll(n) : -1; bit >= 0 && ok; bit--) {
+        ok = bigAdd(&sum, &f, &g);
+        Square squares[3] = { { &a, &f, false }, { &b, &g, false }, { &c, &sum, false } };
+        if (sum.length >= SQUARE_PARALLEL) {
+            TaskGroup group;
+            taskGroupInit(&group);
+            taskSpawn(&group, squareTask, &squares[0]);
+            taskSpawn(&group, squareTask, &squares[1]);
+            squareTask(&squares[2]);
+            taskSync(&group);
+        } else {
+            for (int s = 0; s < 3; s++) {
+                squareTask(&squares[s]);
+            }
+        }
+        ok = ok && squares[0].ok && squares[1].ok && squares[2].ok &&
+             bigAdd(&g, &a, &b) && bigSub(&c, &c, &g) && bigSub(&f, &c, &a);
+        if (ok && (n >> bit & 1)) {
+            // Step to (F(2k + 1), F(2k + 2))
+            ok = bigAdd(&sum, &f, &g);
+            BigNum swap = f;
+            f = g;
+            g = sum;
+            sum = swap;
+        }
+    }
+    if (ok) {
+        BigNum swap = *result;
+        *result = f;
+        f = swap;
+    }
+    bigFree(&f);
+    bigFree(&g);
+    bigFree(&sum);
+    bigFree(&a);
+    bigFree(&b);
+    bigFree(&c);
+    return ok;
+}
@@ -0,0 +1,96 @@
+/*
+ * bignum.h - Arbitrary-Precision Integers for Factorials and Fibonacci
+ *
+ * "6. array/factorials with array and recursion.c" stores n! in a double:
+ * it calls fact(i + 1) from scratch for every entry (O(n^2)
+ * multiplications) and prints inf from 171! on. The Fibonacci functions
+ * in docs/12-algorithms/03-dynamic-programming.md overflow int at n = 47.
+ * This module keeps exact non-negative integers of any size:
+ *
+ * - 64-bit limbs, least significant first
+ * - multiplication chosen by size: schoolbook for short numbers, Karatsuba
+ *   (three half-size products instead of four) for medium ones, and a
+ *   number-theoretic transform (an FFT modulo the prime 2^64 - 2^32 + 1)
+ *   for large ones; squaring needs one transform fewer
+ * - an incremental factorial table: entry i is entry i - 1 times i, one
+ *   short multiplication per entry
+ * - n! as a balanced product tree over the odd parts of 1..n, so the big
+ *   multiplications have equal-sized operands; the factors of 2 become one
+ *   shift at the end
+ * - F(n) by fast doubling: three squarings per bit of n
+ * - large multiplications, transforms and product-tree halves run as tasks
+ *   on ../concurrency/scheduler.h when it is initialized (serially when not)
+ *
+ * Every BigNum must be set up with bigInit() before use. Functions that
+ * return bool fail only when memory runs out; `result` may be the same
+ * BigNum as an operand.
+ *
+ * Compile together with bignum.c and the scheduler:
+ *   gcc -O2 -pthread -o program program.c bignum.c ../concurrency/scheduler.c
+ */
+
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint64_t* limbs;     // least significant first
+    size_t length;       // limbs in use, no leading zero limbs; 0 for 0
+    size_t capacity;
+} BigNum;
+
+typedef enum {
+    BIG_MUL_AUTO,        // by size, see the thresholds below
+    BIG_MUL_SCHOOLBOOK,
+    BIG_MUL_KARATSUBA,
+    BIG_MUL_NTT
+} BigMulMethod;
+
+// Shorter operand (limbs) from which Karatsuba is used, and combined length
+// from which the transform is used
+#define KARATSUBA_THRESHOLD 40
+#define NTT_THRESHOLD 8000
+
+// ========== Basics ==========
+
+bool bigInit(BigNum* x, uint64_t value);
+void bigFree(BigNum* x);
+bool bigCopy(BigNum* destination, const BigNum* source);
+
+int bigCompare(const BigNum* a, const BigNum* b);   // -1, 0 or 1
+size_t bigBitLength(const BigNum* x);
+uint64_t bigModSmall(const BigNum* x, uint64_t divisor);   // divisor > 0
+
+// Decimal digits in a malloc'd string, or NULL. Quadratic: fine for
+// thousands of digits, slow for millions.
+char* bigToDecimal(const BigNum* x);
+
+// ========== Arithmetic ==========
+
+bool bigAdd(BigNum* result, const BigNum* a, const BigNum* b);
+bool bigSub(BigNum* result, const BigNum* a, const BigNum* b);   // requires a >= b
+bool bigShiftLeft(BigNum* result, const BigNum* a, size_t bits);
+bool bigMulSmall(BigNum* result, const BigNum* a, uint64_t factor);
+bool bigMul(BigNum* result, const BigNum* a, const BigNum* b);
+bool bigMulWith(BigNum* result, const BigNum* a, const BigNum* b, BigMulMethod method);
+
+// ========== Factorials and Fibonacci ==========
+
+bool bigFactorial(BigNum* result, uint64_t n);
+bool bigFibonacci(BigNum* result, uint64_t n);
+
+// values[i] = i! for i < count
+typedef struct {
+    BigNum* values;
+    size_t count;
+    size_t capacity;
+} FactorialTable;
+
+bool factorialTableInit(FactorialTable* table);
+bool factorialTableExtend(FactorialTable* table, size_t count);   // up to (count - 1)!
+void factorialTableFree(FactorialTable* table);
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Bignum Demo: Exact Factorials and Fibonacci Numbers of Any Size
+ *
+ * Builds the 1000-entry factorial table of
+ * "6. array/factorials with array and recursion.c" exactly, checks the
+ * three multiplication methods against each other, the product tree
+ * against the incremental table and fast doubling against repeated
+ * addition, checks n! and F(n) modulo a prime against a plain loop, then
+ * times each method and computes 1,000,000! and F(10^7).
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o bignum_demo bignum_demo.c bignum.c ../concurrency/scheduler.c
+ *   ./bignum_demo [factorial n] [fibonacci n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bignum.h"
+#include "../concurrency/scheduler.h"
+
+#define CHECK_PRIME 2305843009213693951ull   // 2^61 - 1
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Fills the limbs directly; the top limb is odd so it is never zero
+static bool randomBig(BigNum* x, size_t limbs, unsigned* seed) {
+    x->limbs = malloc(limbs * sizeof(uint64_t));
+    x->length = x->capacity = limbs;
+    if (x->limbs == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < limbs; i++) {
+        x->limbs[i] = (uint64_t)nextRandom(seed) << 32 | nextRandom(seed);
+    }
+    x->limbs[limbs - 1] |= 1;
+    return true;
+}
+
+// The original program: fact() recomputed from scratch for every entry
+static double fact(int n) {
+    if (n == 1) {
+        return 1;
+    }
+    return n * fact(n - 1);
+}
+
+static uint64_t mulMod(uint64_t a, uint64_t b) {
+    return (uint64_t)((unsigned __int128)a * b % CHECK_PRIME);
+}
+
+// ========== Checks ==========
+
+static bool checkMultiplication(unsigned* seed) {
+    const size_t sizes[][2] = { { 1, 1 }, { 3, 2 }, { 39, 39 }, { 40, 40 }, { 41, 17 }, { 100, 100 },
+                                { 257, 255 }, { 1000, 1000 }, { 1500, 700 }, { 3000, 41 },
+                                { 4096, 4096 } };
+    bool ok = true;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ok; s++) {
+        BigNum a, b, expected, actual;
+        ok = randomBig(&a, sizes[s][0], seed) && randomBig(&b, sizes[s][1], seed) &&
+             bigInit(&expected, 0) && bigInit(&actual, 0) &&
+             bigMulWith(&expected, &a, &b, BIG_MUL_SCHOOLBOOK);
+        const BigMulMethod methods[] = { BIG_MUL_KARATSUBA, BIG_MUL_NTT, BIG_MUL_AUTO };
+        for (int m = 0; m < 3 && ok; m++) {
+            ok = bigMulWith(&actual, &a, &b, methods[m]) && bigCompare(&actual, &expected) == 0;
+        }
+        // Squaring takes its own path through the transform
+        ok = ok && bigMulWith(&expected, &a, &a, BIG_MUL_SCHOOLBOOK) &&
+             bigMulWith(&actual, &a, &a, BIG_MUL_NTT) && bigCompare(&actual, &expected) == 0;
+        bigFree(&a);
+        bigFree(&b);
+        bigFree(&expected);
+        bigFree(&actual);
+    }
+    return ok;
+}
+
+static bool checkSmallValues(void) {
+    const char* expected[] = { "15511210043330985984000000", "354224848179261915075", "0", "1" };
+    BigNum x;
+    if (!bigInit(&x, 0)) {
+        return false;
+    }
+    bool ok = true;
+    for (int i = 0; i < 4 && ok; i++) {
+        ok = i == 0 ? bigFactorial(&x, 25) : i == 1 ? bigFibonacci(&x, 100)
+           : i == 2 ? bigFibonacci(&x, 0) : bigFactorial(&x, 0);
+        char* text = ok ? bigToDecimal(&x) : NULL;
+        ok = text != NULL && strcmp(text, expected[i]) == 0;
+        free(text);
+    }
+    // 1000! has 2568 digits
+    ok = ok && bigFactorial(&x, 1000);
+    char* text = ok ? bigToDecimal(&x) : NULL;
+    ok = text != NULL && strlen(text) == 2568 &&
+         strncmp(text, "402387260077093773543702433923003985719374864210", 48) == 0;
+    free(text);
+    bigFree(&x);
+    return ok;
+}
+
+static bool checkAgainstLoops(const FactorialTable* table) {
+    bool ok = true;
+    BigNum x, previous, current;
+    ok = bigInit(&x, 0) && bigInit(&previous, 0) && bigInit(&current, 1);
+    for (size_t n = 0; n < table->count && ok; n += n < 300 ? 1 : 97) {
+        ok = bigFactorial(&x, n) && bigCompare(&x, &table->values[n]) == 0;
+    }
+    // F(n) by repeated addition, every n up to 3000
+    for (uint64_t n = 0; n <= 3000 && ok; n++) {
+        ok = bigFibonacci(&x, n) && bigCompare(&x, &previous) == 0 &&
+             bigAdd(&x, &previous, &current);
+        BigNum swap = previous;
+        previous = current;
+        current = x;
+        x = swap;
+    }
+    bigFree(&x);
+    bigFree(&previous);
+    bigFree(&current);
+    return ok;
+}
+
+// n! and F(n) modulo 2^61 - 1 must match a loop over n steps
+static bool checkModulo(const BigNum* factorial, uint64_t factorialN,
+                        const BigNum* fibonacci, uint64_t fibonacciN) {
+    uint64_t product = 1;
+    for (uint64_t i = 2; i <= factorialN; i++) {
+        product = mulMod(product, i);
+    }
+    uint64_t f = 0, g = 1;
+    for (uint64_t i = 0; i < fibonacciN; i++) {
+        uint64_t next = (f + g) % CHECK_PRIME;
+        f = g;
+        g = next;
+    }
+    return bigModSmall(factorial, CHECK_PRIME) == product && bigModSmall(fibonacci, CHECK_PRIME) == f;
+}
+
+// ========== Benchmark ==========
+
+static void timeMultiplication(unsigned* seed) {
+    printf("\n=== Multiplying two n-limb numbers (ms) ===\n");
+    printf("%8s %12s %12s %12s\n", "limbs", "schoolbook", "Karatsuba", "NTT");
+    const BigMulMethod methods[] = { BIG_MUL_SCHOOLBOOK, BIG_MUL_KARATSUBA, BIG_MUL_NTT };
+    for (size_t limbs = 16; limbs <= 262144; limbs *= 4) {
+        BigNum a, b, product;
+        if (!randomBig(&a, limbs, seed) || !randomBig(&b, limbs, seed) || !bigInit(&product, 0)) {
+            return;
+        }
+        printf("%8zu", limbs);
+        for (int m = 0; m < 3; m++) {
+            if ((m == 0 && limbs > 4096) || (m == 1 && limbs > 65536)) {
+                printf(" %12s", "-");
+                continue;
+            }
+            int repeats = limbs <= 256 ? 1000 : limbs <= 4096 ? 10 : 1;
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int r = 0; r < repeats; r++) {
+                bigMulWith(&product, &a, &b, methods[m]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            printf(" %12.4f", elapsedSeconds(start, end) / repeats * 1e3);
+        }
+        printf("\n");
+        bigFree(&a);
+        bigFree(&b);
+        bigFree(&product);
+    }
+}
+
+static void benchmark(uint64_t factorialN, uint64_t fibonacciN, unsigned* seed) {
+    struct timespec start, end;
+
+    printf("\n=== The 1000-entry factorial table ===\n");
+    double sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 1000; i++) {
+        sink += fact(i + 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("double, fact(i + 1) each time:   %8.3f ms (171! and later are inf, sum %g)\n",
+           elapsedSeconds(start, end) * 1e3, sink);
+    FactorialTable table;
+    factorialTableInit(&table);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    factorialTableExtend(&table, 1001);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("bignum, table[i] = table[i-1]*i: %8.3f ms (exact)\n", elapsedSeconds(start, end) * 1e3);
+    size_t digits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 1; i <= 1000; i++) {
+        char* text = bigToDecimal(&table.values[i]);
+        digits += text != NULL ? strlen(text) : 0;
+        free(text);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("  all 1000 in decimal:           %8.3f ms (%zu digits)\n",
+           elapsedSeconds(start, end) * 1e3, digits);
+    factorialTableFree(&table);
+
+    timeMultiplication(seed);
+
+    printf("\n=== 100000! ===\n");
+    BigNum x, y;
+    bigInit(&x, 1);
+    bigInit(&y, 0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t i = 2; i <= 100000; i++) {
+        bigMulSmall(&x, &x, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("one factor at a time: %8.3f s\n", elapsedSeconds(start, end));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bigFactorial(&y, 100000);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("product tree:         %8.3f s  %s\n", elapsedSeconds(start, end),
+           bigCompare(&x, &y) == 0 ? "same" : "DIFFERENT");
+
+    printf("\n=== F(100000) ===\n");
+    bigFree(&x);
+    bigInit(&x, 0);
+    BigNum next;
+    bigInit(&next, 1);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 100000; i++) {
+        bigAdd(&x, &x, &next);
+        BigNum swap = x;
+        x = next;
+        next = swap;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("repeated addition:    %8.3f s\n", elapsedSeconds(start, end));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bigFibonacci(&y, 100000);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("fast doubling:        %8.3f s  %s\n", elapsedSeconds(start, end),
+           bigCompare(&x, &y) == 0 ? "same" : "DIFFERENT");
+    bigFree(&next);
+
+    printf("\n=== %llu! and F(%llu) on %d worker(s) ===\n", (unsigned long long)factorialN,
+           (unsigned long long)fibonacciN, schedulerWorkerCount());
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = bigFactorial(&x, factorialN);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%llu!: %zu bits (about %.0f digits), %.3f s\n", (unsigned long long)factorialN,
+           bigBitLength(&x), bigBitLength(&x) * 0.30103, elapsedSeconds(start, end));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ok = ok && bigFibonacci(&y, fibonacciN);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("F(%llu): %zu bits (about %.0f digits), %.3f s\n", (unsigned long long)fibonacciN,
+           bigBitLength(&y), bigBitLength(&y) * 0.30103, elapsedSeconds(start, end));
+    printf("Both modulo 2^61 - 1 vs a loop of n steps: %s\n",
+           ok && checkModulo(&x, factorialN, &y, fibonacciN) ? "all match" : "MISMATCH");
+    bigFree(&x);
+    bigFree(&y);
+}
+
+int main(int argc, char* argv[]) {
+    long long factorialN = argc > 1 ? atoll(argv[1]) : 1000000;
+    long long fibonacciN = argc > 2 ? atoll(argv[2]) : 10000000;
+    if (factorialN < 1 || fibonacciN < 1) {
+        printf("Usage: %s [factorial n] [fibonacci n]\n", argv[0]);
+        return 1;
+    }
+    if (schedulerInit(0, 0) != 0) {
+        return 1;
+    }
+
+    printf("=== Example: factorial[i] = i! ===\n");
+    FactorialTable table;
+    factorialTableInit(&table);
+    if (!factorialTableExtend(&table, 1001)) {
+        return 1;
+    }
+    const int shown[] = { 20, 25, 170, 171 };
+    for (int s = 0; s < 4; s++) {
+        char* text = bigToDecimal(&table.values[shown[s]]);
+        printf("factorial[%d] = %.40s%s (%zu digits; double: %e)\n", shown[s], text,
+               strlen(text) > 40 ? "..." : "", strlen(text), fact(shown[s]));
+        free(text);
+    }
+    BigNum f;
+    bigInit(&f, 0);
+    bigFibonacci(&f, 100);
+    char* text = bigToDecimal(&f);
+    printf("F(100) = %s (int overflows at F(47))\n", text);
+    free(text);
+    bigFree(&f);
+
+    unsigned seed = 2463534242u;
+    printf("\n=== Checks ===\n");
+    bool multiplyOk = checkMultiplication(&seed);
+    printf("Schoolbook vs Karatsuba vs NTT, 1 to 4096 limbs: %s\n", multiplyOk ? "all match" : "MISMATCH");
+    bool valuesOk = checkSmallValues();
+    printf("25!, F(100), 0!, F(0), digits of 1000!: %s\n", valuesOk ? "all match" : "MISMATCH");
+    bool loopsOk = checkAgainstLoops(&table);
+    printf("Product tree vs table up to 1000!, fast doubling vs addition up to F(3000): %s\n",
+           loopsOk ? "all match" : "MISMATCH");
+    factorialTableFree(&table);
+
+    benchmark((uint64_t)factorialN, (uint64_t)fibonacciN, &seed);
+    schedulerShutdown();
+    return multiplyOk && valuesOk && loopsOk ? 0 : 1;
+}
@@ -0,0 +1,376 @@
+/*
+ * linear_scan.c - Vectorized Linear Search, Count and Filter over int Arrays (see linear_scan.h)
+ */
+
+#include "linear_scan.h"
+#include "../concurrency/scheduler.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <immintrin.h>
+
+// ========== Kernels ==========
+//
+// Every kernel tests low <= value <= low + span as one unsigned compare:
+// value - low wraps above span when value < low. First kernels return
+// count when nothing matches; All kernels write base + index of each match.
+
+typedef size_t (*ScanFirstFunction)(const int32_t* values, size_t count, int32_t low, uint32_t span);
+typedef size_t (*ScanCountFunction)(const int32_t* values, size_t count, int32_t low, uint32_t span);
+typedef size_t (*ScanAllFunction)(const int32_t* values, size_t count, int32_t low, uint32_t span,
+                                  uint32_t base, uint32_t* indices);
+
+static inline bool inRange(int32_t value, int32_t low, uint32_t span) {
+    return (uint32_t)value - (uint32_t)low <= span;
+}
+
+static size_t scanFirstFrom(const int32_t* values, size_t i, size_t count, int32_t low, uint32_t span) {
+    for (; i < count; i++) {
+        if (inRange(values[i], low, span)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+static size_t scanCountFrom(const int32_t* values, size_t i, size_t count, int32_t low, uint32_t span) {
+    size_t n = 0;
+    for (; i < count; i++) {
+        n += inRange(values[i], low, span);
+    }
+    return n;
+}
+
+// Writes every index and advances only past matches: no branch
+static size_t scanAllFrom(const int32_t* values, size_t i, size_t count, int32_t low, uint32_t span,
+                          uint32_t base, uint32_t* indices, size_t n) {
+    for (; i < count; i++) {
+        indices[n] = base + (uint32_t)i;
+        n += inRange(values[i], low, span);
+    }
+    return n;
+}
+
+static size_t scanFirstScalar(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    return scanFirstFrom(values, 0, count, low, span);
+}
+
+static size_t scanCountScalar(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    return scanCountFrom(values, 0, count, low, span);
+}
+
+static size_t scanAllScalar(const int32_t* values, size_t count, int32_t low, uint32_t span,
+                            uint32_t base, uint32_t* indices) {
+    return scanAllFrom(values, 0, count, low, span, base, indices, 0);
+}
+
+// compressTable[mask] = the lanes set in an 8-bit mask, packed to the front
+static uint8_t compressTable[256][8];
+
+__attribute__((constructor)) static void buildCompressTable(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int n = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) {
+                compressTable[mask][n++] = (uint8_t)lane;
+            }
+        }
+    }
+}
+
+// AVX2 has no unsigned compare: x <= span exactly when min(x, span) == x
+__attribute__((target("avx2")))
+static inline __m256i inRangeAvx2(const int32_t* values, __m256i low, __m256i span) {
+    __m256i x = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)values), low);
+    return _mm256_cmpeq_epi32(_mm256_min_epu32(x, span), x);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned laneMaskAvx2(__m256i lanes) {
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(lanes));
+}
+
+__attribute__((target("avx2")))
+static size_t scanFirstAvx2(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i spanVector = _mm256_set1_epi32((int32_t)span);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = inRangeAvx2(values + i, lowVector, spanVector);
+        __m256i b = inRangeAvx2(values + i + 8, lowVector, spanVector);
+        __m256i c = inRangeAvx2(values + i + 16, lowVector, spanVector);
+        __m256i d = inRangeAvx2(values + i + 24, lowVector, spanVector);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (!_mm256_testz_si256(any, any)) {
+            uint32_t mask = laneMaskAvx2(a) | laneMaskAvx2(b) << 8 | laneMaskAvx2(c) << 16 | laneMaskAvx2(d) << 24;
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    for (; i + 8 <= count; i += 8) {
+        unsigned mask = laneMaskAvx2(inRangeAvx2(values + i, lowVector, spanVector));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return scanFirstFrom(values, i, count, low, span);
+}
+
+// A match is -1 in its lane, so subtracting the compare counts it; two
+// accumulators hide the latency of the adds
+__attribute__((target("avx2")))
+static size_t scanCountAvx2(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i spanVector = _mm256_set1_epi32((int32_t)span);
+    __m256i counts0 = _mm256_setzero_si256(), counts1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        counts0 = _mm256_sub_epi32(counts0, inRangeAvx2(values + i, lowVector, spanVector));
+        counts1 = _mm256_sub_epi32(counts1, inRangeAvx2(values + i + 8, lowVector, spanVector));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi32(counts0, counts1));
+    size_t n = 0;
+    for (int lane = 0; lane < 8; lane++) {
+        n += lanes[lane];
+    }
+    return n + scanCountFrom(values, i, count, low, span);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t scanAllAvx2(const int32_t* values, size_t count, int32_t low, uint32_t span,
+                          uint32_t base, uint32_t* indices) {
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i spanVector = _mm256_set1_epi32((int32_t)span);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32((int32_t)base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    size_t i = 0, n = 0;
+    for (; i + 8 <= count; i += 8) {
+        unsigned mask = laneMaskAvx2(inRangeAvx2(values + i, lowVector, spanVector));
+        __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)compressTable[mask]));
+        _mm256_storeu_si256((__m256i*)(indices + n), _mm256_permutevar8x32_epi32(index, lanes));
+        n += (size_t)__builtin_popcount(mask);
+        index = _mm256_add_epi32(index, step);
+    }
+    return scanAllFrom(values, i, count, low, span, base, indices, n);
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask16 inRangeAvx512(const int32_t* values, __m512i low, __m512i span) {
+    return _mm512_cmple_epu32_mask(_mm512_sub_epi32(_mm512_loadu_si512(values), low), span);
+}
+
+__attribute__((target("avx512f")))
+static size_t scanFirstAvx512(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    const __m512i lowVector = _mm512_set1_epi32(low);
+    const __m512i spanVector = _mm512_set1_epi32((int32_t)span);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        uint64_t mask = (uint64_t)inRangeAvx512(values + i, lowVector, spanVector) |
+                        (uint64_t)inRangeAvx512(values + i + 16, lowVector, spanVector) << 16 |
+                        (uint64_t)inRangeAvx512(values + i + 32, lowVector, spanVector) << 32 |
+                        (uint64_t)inRangeAvx512(values + i + 48, lowVector, spanVector) << 48;
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctzll(mask);
+        }
+    }
+    for (; i + 16 <= count; i += 16) {
+        unsigned mask = inRangeAvx512(values + i, lowVector, spanVector);
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return scanFirstFrom(values, i, count, low, span);
+}
+
+__attribute__((target("avx512f")))
+static size_t scanCountAvx512(const int32_t* values, size_t count, int32_t low, uint32_t span) {
+    const __m512i lowVector = _mm512_set1_epi32(low);
+    const __m512i spanVector = _mm512_set1_epi32((int32_t)span);
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512i counts0 = _mm512_setzero_si512(), counts1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        counts0 = _mm512_mask_add_epi32(counts0, inRangeAvx512(values + i, lowVector, spanVector), counts0, one);
+        counts1 = _mm512_mask_add_epi32(counts1, inRangeAvx512(values + i + 16, lowVector, spanVector), counts1, one);
+    }
+    // Summed as size_t: the total may not fit in 32 bits
+    uint32_t lanes[16];
+    _mm512_storeu_si512(lanes, _mm512_add_epi32(counts0, counts1));
+    size_t n = 0;
+    for (int lane = 0; lane < 16; lane++) {
+        n += lanes[lane];
+    }
+    return n + scanCountFrom(values, i, count, low, span);
+}
+
+// vpcompressd packs the lanes in a register; a plain store afterwards is
+// faster than the memory form of the instruction on some CPUs
+__attribute__((target("avx512f,popcnt")))
+static size_t scanAllAvx512(const int32_t* values, size_t count, int32_t low, uint32_t span,
+                            uint32_t base, uint32_t* indices) {
+    const __m512i lowVector = _mm512_set1_epi32(low);
+    const __m512i spanVector = _mm512_set1_epi32((int32_t)span);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i index = _mm512_add_epi32(_mm512_set1_epi32((int32_t)base),
+                                     _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    size_t i = 0, n = 0;
+    for (; i + 16 <= count; i += 16) {
+        __mmask16 mask = inRangeAvx512(values + i, lowVector, spanVector);
+        _mm512_storeu_si512(indices + n, _mm512_maskz_compress_epi32(mask, index));
+        n += (size_t)__builtin_popcount(mask);
+        index = _mm512_add_epi32(index, step);
+    }
+    return scanAllFrom(values, i, count, low, span, base, indices, n);
+}
+
+DISPATCH_KERNEL(ScanFirstFunction, scanFirstKernel,
+    DISPATCH_VARIANT(scanFirstAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(scanFirstAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(scanFirstScalar, 0))
+
+DISPATCH_KERNEL(ScanCountFunction, scanCountKernel,
+    DISPATCH_VARIANT(scanCountAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(scanCountAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(scanCountScalar, 0))
+
+DISPATCH_KERNEL(ScanAllFunction, scanAllKernel,
+    DISPATCH_VARIANT(scanAllAvx512, CPU_AVX512F | CPU_POPCNT),
+    DISPATCH_VARIANT(scanAllAvx2, CPU_AVX2 | CPU_POPCNT),
+    DISPATCH_VARIANT(scanAllScalar, 0))
+
+// ========== Chunked and Parallel Scans ==========
+
+typedef struct {
+    const int32_t* values;
+    size_t count;
+    int32_t low;
+    uint32_t span;
+    uint32_t* indices;
+    size_t* chunkMatches;      // scanAll: matches of each chunk, at indices + chunk start
+    atomic_size_t matches;     // scanCount
+    atomic_size_t first;       // scanFirst: smallest match so far, count if none
+} ScanJob;
+
+static inline size_t chunkLength(const ScanJob* job, long chunk) {
+    size_t start = (size_t)chunk * SCAN_CHUNK;
+    return (job->count - start < SCAN_CHUNK) ? job->count - start : SCAN_CHUNK;
+}
+
+// Chunks after a match already found elsewhere are skipped
+static void firstChunks(long begin, long end, void* arg) {
+    ScanJob* job = arg;
+    for (long c = begin; c < end; c++) {
+        size_t start = (size_t)c * SCAN_CHUNK;
+        size_t best = atomic_load_explicit(&job->first, memory_order_relaxed);
+        if (start >= best) {
+            return;
+        }
+        size_t length = chunkLength(job, c);
+        size_t found = scanFirstKernel(job->values + start, length, job->low, job->span);
+        if (found < length) {
+            size_t index = start + found;
+            while (index < best && !atomic_compare_exchange_weak(&job->first, &best, index)) {
+            }
+            return;
+        }
+    }
+}
+
+static void countChunks(long begin, long end, void* arg) {
+    ScanJob* job = arg;
+    size_t matches = 0;
+    for (long c = begin; c < end; c++) {
+        size_t start = (size_t)c * SCAN_CHUNK;
+        matches += scanCountKernel(job->values + start, chunkLength(job, c), job->low, job->span);
+    }
+    atomic_fetch_add_explicit(&job->matches, matches, memory_order_relaxed);
+}
+
+// A chunk never has more matches than values, and the kernels store only
+// below index + vector width <= chunk end, so chunks cannot overlap
+static void allChunks(long begin, long end, void* arg) {
+    ScanJob* job = arg;
+    for (long c = begin; c < end; c++) {
+        size_t start = (size_t)c * SCAN_CHUNK;
+        job->chunkMatches[c] = scanAllKernel(job->values + start, chunkLength(job, c), job->low, job->span,
+                                             (uint32_t)start, job->indices + start);
+    }
+}
+
+// low <= value < high as low <= value <= low + span; false if empty
+static bool toSpan(int64_t low, int64_t high, int32_t* start, uint32_t* span) {
+    low = (low < INT32_MIN) ? INT32_MIN : low;
+    high = (high > (int64_t)INT32_MAX + 1) ? (int64_t)INT32_MAX + 1 : high;
+    if (high <= low) {
+        return false;
+    }
+    *start = (int32_t)low;
+    *span = (uint32_t)(high - 1 - low);
+    return true;
+}
+
+static bool runParallel(size_t count) {
+    return count >= SCAN_PARALLEL_MIN && schedulerWorkerCount() > 1;
+}
+
+static long chunkCount(size_t count) {
+    return (long)((count + SCAN_CHUNK - 1) / SCAN_CHUNK);
+}
+
+long scanFirst(const int32_t* values, size_t count, int64_t low, int64_t high) {
+    ScanJob job = { .values = values, .count = count };
+    if (!toSpan(low, high, &job.low, &job.span)) {
+        return -1;
+    }
+    if (!runParallel(count)) {
+        size_t found = scanFirstKernel(values, count, job.low, job.span);
+        return (found < count) ? (long)found : -1;
+    }
+    atomic_init(&job.first, count);
+    parallelFor(0, chunkCount(count), 1, firstChunks, &job);
+    size_t found = atomic_load(&job.first);
+    return (found < count) ? (long)found : -1;
+}
+
+size_t scanCount(const int32_t* values, size_t count, int64_t low, int64_t high) {
+    ScanJob job = { .values = values, .count = count };
+    if (!toSpan(low, high, &job.low, &job.span)) {
+        return 0;
+    }
+    if (!runParallel(count)) {
+        return scanCountKernel(values, count, job.low, job.span);
+    }
+    atomic_init(&job.matches, 0);
+    parallelFor(0, chunkCount(count), 1, countChunks, &job);
+    return atomic_load(&job.matches);
+}
+
+size_t scanAll(const int32_t* values, size_t count, int64_t low, int64_t high, uint32_t* indices) {
+    ScanJob job = { .values = values, .count = count, .indices = indices };
+    if (!toSpan(low, high, &job.low, &job.span)) {
+        return 0;
+    }
+    if (!runParallel(count)) {
+        return scanAllKernel(values, count, job.low, job.span, 0, indices);
+    }
+    long chunks = chunkCount(count);
+    job.chunkMatches = malloc((size_t)chunks * sizeof(size_t));
+    if (job.chunkMatches == NULL) {
+        printf("Memory allocation failed\n");
+        return scanAllKernel(values, count, job.low, job.span, 0, indices);
+    }
+    parallelFor(0, chunks, 1, allChunks, &job);
+
+    // Close the gaps between the chunks' matches, front to back
+    size_t n = job.chunkMatches[0];
+    for (long c = 1; c < chunks; c++) {
+        memmove(indices + n, indices + (size_t)c * SCAN_CHUNK, job.chunkMatches[c] * sizeof(uint32_t));
+        n += job.chunkMatches[c];
+    }
+    free(job.chunkMatches);
+    return n;
+}
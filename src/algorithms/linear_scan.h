@@ -0,0 +1,61 @@
+/*
+ * linear_scan.h - Vectorized Linear Search, Count and Filter over int Arrays
+ *
+ * linearSearch() and linearSearchAll() in
+ * docs/12-algorithms/02-searching-algorithms.md compare one int per loop
+ * iteration, linearSearchAll() prints its hits instead of returning them,
+ * and countOccurrences() needs a sorted array. This module scans unsorted
+ * int32 arrays with the same answers:
+ *
+ * - the first index, the number of matches, or every matching index
+ * - for a value (x == target) or a half-open range (low <= x < high),
+ *   tested with one unsigned compare: x - low < high - low
+ * - 16 (AVX-512) or 8 (AVX2) values per compare. All matching indices are
+ *   packed to the front of a vector (vpcompressd, or a shuffle looked up
+ *   from the 8-bit match mask with AVX2) and stored at once, so the output
+ *   is written without a branch per element
+ * - scanFirst() tests 64 values (four vectors) per branch, which is
+ *   taken only at the match
+ * - arrays of SCAN_PARALLEL_MIN values or more are split into chunks
+ *   across the workers of ../concurrency/scheduler.h when it is running
+ *   (serially when not). scanFirst() skips chunks after an earlier match
+ *
+ * Indices are 32-bit, so arrays hold fewer than 2^32 values. The fastest
+ * variant for the CPU is picked at startup (see ../dispatch/cpu_dispatch.h).
+ * Compile together with linear_scan.c and the scheduler:
+ *   gcc -O2 -pthread -o program program.c linear_scan.c ../concurrency/scheduler.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef LINEAR_SCAN_H
+#define LINEAR_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCAN_CHUNK (1 << 16)              // values per parallel task
+#define SCAN_PARALLEL_MIN (4 * SCAN_CHUNK)
+
+// Index of the first value with low <= value < high, or -1
+long scanFirst(const int32_t* values, size_t count, int64_t low, int64_t high);
+
+size_t scanCount(const int32_t* values, size_t count, int64_t low, int64_t high);
+
+// Writes the indices of all values with low <= value < high to indices[],
+// in increasing order, and returns how many. indices needs room for count
+// entries: the vector kernels store whole vectors past the last match.
+size_t scanAll(const int32_t* values, size_t count, int64_t low, int64_t high, uint32_t* indices);
+
+// The docs' functions: value == target
+static inline long scanFirstEqual(const int32_t* values, size_t count, int32_t target) {
+    return scanFirst(values, count, target, (int64_t)target + 1);
+}
+
+static inline size_t scanCountEqual(const int32_t* values, size_t count, int32_t target) {
+    return scanCount(values, count, target, (int64_t)target + 1);
+}
+
+static inline size_t scanAllEqual(const int32_t* values, size_t count, int32_t target, uint32_t* indices) {
+    return scanAll(values, count, target, (int64_t)target + 1, indices);
+}
+
+#endif
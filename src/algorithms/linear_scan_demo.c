@@ -0,0 +1,312 @@
+/*
+ * Linear Scan Demo: linearSearch, linearSearchAll and Counting, Vectorized
+ *
+ * Runs the example array of docs/12-algorithms/02-searching-algorithms.md
+ * through scanFirst(), scanCount() and scanAll(), checks every variant (and
+ * the chunked parallel path) against plain loops on random arrays and
+ * ranges, including INT32_MIN / INT32_MAX and empty ranges, then measures
+ * each operation on N values at several selectivities.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o linear_scan_demo linear_scan_demo.c linear_scan.c \
+ *       ../concurrency/scheduler.c ../dispatch/cpu_dispatch.c
+ *   ./linear_scan_demo [values in millions] [workers]
+ *   CPU_DISPATCH=scalar ./linear_scan_demo      (no SIMD)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "linear_scan.h"
+#include "../concurrency/scheduler.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== Loops from the Docs ==========
+
+// linearSearch
+static long linearSearch(const int32_t* arr, size_t n, int64_t low, int64_t high) {
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] >= low && arr[i] < high) {
+            return (long)i;   // Return index if found
+        }
+    }
+    return -1;   // Return -1 if not found
+}
+
+static size_t countLoop(const int32_t* arr, size_t n, int64_t low, int64_t high) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] >= low && arr[i] < high) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// linearSearchAll, storing the indices instead of printing them
+static size_t linearSearchAll(const int32_t* arr, size_t n, int64_t low, int64_t high, uint32_t* indices) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] >= low && arr[i] < high) {
+            indices[found++] = (uint32_t)i;
+        }
+    }
+    return found;
+}
+
+// ========== Checks ==========
+
+static const char* kernelNames[] = { "scanFirstKernel", "scanCountKernel", "scanAllKernel" };
+
+// One range against every variant of the three kernels
+static bool checkRange(const int32_t* values, size_t count, int64_t low, int64_t high,
+                       uint32_t* expected, uint32_t* indices) {
+    long first = linearSearch(values, count, low, high);
+    size_t matches = linearSearchAll(values, count, low, high, expected);
+    bool ok = true;
+    for (int k = 0; k < 3; k++) {
+        const DispatchKernel* kernel = dispatchFind(kernelNames[k]);
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (!dispatchUseVariant(kernel, v)) {
+                continue;
+            }
+            bool same;
+            if (k == 0) {
+                same = scanFirst(values, count, low, high) == first;
+            } else if (k == 1) {
+                same = scanCount(values, count, low, high) == matches;
+            } else {
+                same = scanAll(values, count, low, high, indices) == matches &&
+                       memcmp(indices, expected, matches * sizeof(uint32_t)) == 0;
+            }
+            if (!same) {
+                if (ok) {
+                    printf("  %s differs (count %zu, range [%lld, %lld))\n", kernel->variants[v].name, count,
+                           (long long)low, (long long)high);
+                }
+                ok = false;
+            }
+        }
+        dispatchRestore(kernel);
+    }
+    return ok;
+}
+
+static int32_t randomValue(unsigned* seed) {
+    static const int32_t special[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX };
+    unsigned r = nextRandom(seed);
+    if (r % 8 == 0) {
+        return special[(r >> 3) % 7];
+    }
+    return (int32_t)(r % 64) - 32;
+}
+
+static void randomRange(unsigned* seed, int64_t* low, int64_t* high) {
+    static const int64_t special[] = { INT64_MIN, (int64_t)INT32_MIN - 1, INT32_MIN, INT32_MIN + 1, -1, 0, 1,
+                                       INT32_MAX, (int64_t)INT32_MAX + 1, INT64_MAX };
+    unsigned r = nextRandom(seed);
+    *low = (r % 4 == 0) ? special[(r >> 2) % 10] : (int64_t)(nextRandom(seed) % 80) - 40;
+    r = nextRandom(seed);
+    bool extreme = *low == INT64_MIN || *low == INT64_MAX;
+    *high = (r % 4 == 0 || extreme) ? special[(r >> 2) % 10] : *low + (int64_t)(r % 24) - 2;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against Plain Loops ===\n");
+    size_t maxCount = 2 * SCAN_PARALLEL_MIN + 1000;
+    int32_t* values = malloc(maxCount * sizeof(int32_t));
+    uint32_t* expected = malloc(maxCount * sizeof(uint32_t));
+    uint32_t* indices = malloc(maxCount * sizeof(uint32_t));
+    if (values == NULL || expected == NULL || indices == NULL) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(expected);
+        free(indices);
+        return false;
+    }
+
+    // Short arrays: every tail length, with random and extreme ranges
+    bool ok = true;
+    for (int trial = 0; trial < 4000 && ok; trial++) {
+        size_t count = (trial < 300) ? (size_t)trial : nextRandom(seed) % 1000;
+        for (size_t i = 0; i < count; i++) {
+            values[i] = randomValue(seed);
+        }
+        int64_t low, high;
+        randomRange(seed, &low, &high);
+        ok = checkRange(values, count, low, high, expected, indices);
+    }
+    printf("4000 arrays of 0..999 values, random ranges: %s\n", ok ? "all match" : "MISMATCH");
+
+    // Arrays split into chunks: first match in a late chunk, none at all,
+    // and matches everywhere
+    bool chunkedOk = true;
+    size_t counts[] = { SCAN_PARALLEL_MIN, SCAN_PARALLEL_MIN + 17, maxCount };
+    for (int c = 0; c < 3 && chunkedOk; c++) {
+        for (size_t i = 0; i < counts[c]; i++) {
+            values[i] = (int32_t)(nextRandom(seed) % 1000000);
+        }
+        values[counts[c] - 5] = -7;
+        chunkedOk = checkRange(values, counts[c], -7, -6, expected, indices) &&
+                    checkRange(values, counts[c], -100, -50, expected, indices) &&
+                    checkRange(values, counts[c], 0, 500000, expected, indices) &&
+                    checkRange(values, counts[c], 999990, 1000000, expected, indices);
+    }
+    printf("%zu to %zu values in chunks of %d, %d workers: %s\n", counts[0], counts[2], SCAN_CHUNK,
+           schedulerWorkerCount(), chunkedOk ? "all match" : "MISMATCH");
+
+    // The docs' example through the inline wrappers
+    int32_t docs[] = { 64, 34, 25, 12, 22, 11, 90, 45, 78, 33 };
+    bool wrappersOk = scanFirstEqual(docs, 10, 22) == 4 && scanFirstEqual(docs, 10, 23) == -1 &&
+                      scanCountEqual(docs, 10, 90) == 1 && scanAllEqual(docs, 10, 11, indices) == 1 &&
+                      indices[0] == 5 && scanFirst(docs, 10, 50, 40) == -1;
+    printf("docs example, equality wrappers, empty range: %s\n", wrappersOk ? "all match" : "MISMATCH");
+
+    free(values);
+    free(expected);
+    free(indices);
+    return ok && chunkedOk && wrappersOk;
+}
+
+// ========== Benchmark ==========
+
+typedef enum { OPERATION_FIRST, OPERATION_COUNT, OPERATION_ALL } Operation;
+
+static size_t runOperation(Operation operation, bool docsLoop, const int32_t* values, size_t count,
+                           int64_t low, int64_t high, uint32_t* indices) {
+    if (operation == OPERATION_FIRST) {
+        return (size_t)(docsLoop ? linearSearch(values, count, low, high) : scanFirst(values, count, low, high));
+    }
+    if (operation == OPERATION_COUNT) {
+        return docsLoop ? countLoop(values, count, low, high) : scanCount(values, count, low, high);
+    }
+    return docsLoop ? linearSearchAll(values, count, low, high, indices) : scanAll(values, count, low, high, indices);
+}
+
+static void benchmark(size_t count, int workers) {
+    int32_t* values = malloc(count * sizeof(int32_t));
+    uint32_t* indices = malloc(count * sizeof(uint32_t));
+    if (values == NULL || indices == NULL) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(indices);
+        return;
+    }
+    // Values 0..999999, so low <= x < low + k * 10000 selects about k%
+    unsigned seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (int32_t)(nextRandom(&seed) % 1000000);
+    }
+
+    struct {
+        const char* label;
+        Operation operation;
+        int64_t low;
+        int64_t high;
+    } cases[] = {
+        { "first, absent (full scan)", OPERATION_FIRST, -10, -5 },
+        { "count, 1%", OPERATION_COUNT, 0, 10000 },
+        { "count, 50%", OPERATION_COUNT, 0, 500000 },
+        { "all, 0.1%", OPERATION_ALL, 0, 1000 },
+        { "all, 10%", OPERATION_ALL, 0, 100000 },
+        { "all, 50%", OPERATION_ALL, 0, 500000 },
+    };
+
+    printf("\n=== %zu Million Values (%.0f MB), GB/s ===\n", count / 1000000, count * 4.0 / 1e6);
+    printf("%-28s %10s", "", "docs loop");
+    const DispatchKernel* kernel = dispatchFind("scanAllKernel");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        if (cpuHas(kernel->variants[v].required)) {
+            printf(" %10s", kernel->variants[v].name + strlen("scanAll"));
+        }
+    }
+    printf(" %7s %d\n", "workers", workers);
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        printf("%-28s", cases[c].label);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t expected = runOperation(cases[c].operation, true, values, count, cases[c].low, cases[c].high, indices);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf(" %10.2f", count * 4.0 / elapsedSeconds(start, end) / 1e9);
+
+        // Every variant on one thread, then the chosen one on all workers
+        bool agree = true;
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1) {
+                schedulerInit(workers, 0);
+            }
+            for (int v = kernel->variantCount - 1; v >= 0; v--) {
+                const DispatchKernel* used = dispatchFind(kernelNames[cases[c].operation]);
+                if ((pass == 1 && &used->variants[v] != used->chosen) || !dispatchUseVariant(used, v)) {
+                    continue;
+                }
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                size_t result = runOperation(cases[c].operation, false, values, count, cases[c].low, cases[c].high,
+                                             indices);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                dispatchRestore(used);
+                agree = agree && result == expected;
+                printf(" %10.2f", count * 4.0 / elapsedSeconds(start, end) / 1e9);
+            }
+            if (pass == 1) {
+                schedulerShutdown();
+            }
+        }
+        printf("%s\n", agree ? "" : "  MISMATCH");
+    }
+    free(values);
+    free(indices);
+}
+
+int main(int argc, char* argv[]) {
+    long millions = argc > 1 ? atol(argv[1]) : 64;
+    int workers = argc > 2 ? atoi(argv[2]) : 4;
+    if (millions < 1 || millions > 1000 || workers < 1 || workers > 256) {
+        printf("Usage: %s [values in millions, 1 to 1000] [workers, 1 to 256]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Examples ===\n");
+    int32_t arr[] = { 64, 34, 25, 12, 22, 11, 90, 45, 78, 33, 22 };
+    size_t n = sizeof(arr) / sizeof(arr[0]);
+    uint32_t indices[16 + 16];
+    printf("Element 22 found at index %ld\n", scanFirstEqual(arr, n, 22));
+    size_t found = scanAllEqual(arr, n, 22, indices);
+    printf("22 found %zu times, at indices:", scanCountEqual(arr, n, 22));
+    for (size_t i = 0; i < found; i++) {
+        printf(" %u", indices[i]);
+    }
+    found = scanAll(arr, n, 20, 50, indices);
+    printf("\n20 <= x < 50 at indices:");
+    for (size_t i = 0; i < found; i++) {
+        printf(" %u", indices[i]);
+    }
+    printf("\nElement 99 %s\n", scanFirstEqual(arr, n, 99) == -1 ? "not found" : "found");
+
+    unsigned seed = 2463534242u;
+    schedulerInit(workers, 0);
+    bool ok = runChecks(&seed);
+    schedulerShutdown();
+    bool serialOk = runChecks(&seed);
+
+    benchmark((size_t)millions * 1000000, workers);
+    return ok && serialOk ? 0 : 1;
+}
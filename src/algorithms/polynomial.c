@@ -0,0 +1,682 @@
+/*
+ * polynomial.c - Dense and Sparse Polynomials with NTT Multiplication (see polynomial.h)
+ */
+
+#include "polynomial.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#define P POLY_MODULUS
+#define P_GENERATOR 3               // generates the multiplicative group mod P
+#define P_MAX_TRANSFORM (1u << 23)  // P - 1 = 119 * 2^23: largest power-of-2 root of unity
+
+// Montgomery arithmetic with R = 2^32 for the vector kernels:
+// montgomery(a, b) = a * b / R mod P
+#define P_NEG_INVERSE 0x3B7FFFFFu   // -1/P mod 2^32
+#define P_R_SQUARED 932051910u      // R^2 mod P: montgomery(x, R^2) = x * R
+
+// ========== Modular Arithmetic ==========
+
+static inline uint32_t modAdd(uint32_t a, uint32_t b) {
+    uint32_t sum = a + b;   // below 2^31, no overflow
+    return sum >= P ? sum - P : sum;
+}
+
+static inline uint32_t modSub(uint32_t a, uint32_t b) {
+    return a >= b ? a - b : a + P - b;
+}
+
+static inline uint32_t modMul(uint32_t a, uint32_t b) {
+    return (uint32_t)((uint64_t)a * b % P);
+}
+
+static uint32_t modPow(uint32_t base, uint64_t exponent) {
+    uint32_t result = 1;
+    base %= P;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result = modMul(result, base);
+        }
+        base = modMul(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// ========== Dense Polynomials ==========
+
+static uint32_t* allocCoefficients(size_t count) {
+    uint32_t* coefficients = malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    if (coefficients == NULL) {
+        printf("Memory allocation failed\n");
+    }
+    return coefficients;
+}
+
+// Replace p's array with a new one (p takes ownership) and drop zero
+// leading coefficients
+static void adopt(Polynomial* p, uint32_t* coefficients, size_t length, size_t capacity) {
+    if (p->coefficients != coefficients) {
+        free(p->coefficients);
+    }
+    while (length > 0 && coefficients[length - 1] == 0) {
+        length--;
+    }
+    p->coefficients = coefficients;
+    p->length = length;
+    p->capacity = capacity;
+}
+
+bool polyInit(Polynomial* p, size_t capacity) {
+    p->coefficients = allocCoefficients(capacity);
+    p->length = 0;
+    p->capacity = capacity;
+    return p->coefficients != NULL;
+}
+
+void polyFree(Polynomial* p) {
+    free(p->coefficients);
+    p->coefficients = NULL;
+    p->length = p->capacity = 0;
+}
+
+bool polySetCoefficients(Polynomial* p, const int64_t* values, size_t length) {
+    uint32_t* coefficients = allocCoefficients(length);
+    if (coefficients == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        int64_t reduced = values[i] % (int64_t)P;
+        coefficients[i] = (uint32_t)(reduced < 0 ? reduced + P : reduced);
+    }
+    adopt(p, coefficients, length, length);
+    return true;
+}
+
+static bool addOrSubtract(Polynomial* result, const Polynomial* a, const Polynomial* b, bool subtract) {
+    size_t length = a->length > b->length ? a->length : b->length;
+    uint32_t* coefficients = allocCoefficients(length);
+    if (coefficients == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        uint32_t x = i < a->length ? a->coefficients[i] : 0;
+        uint32_t y = i < b->length ? b->coefficients[i] : 0;
+        coefficients[i] = subtract ? modSub(x, y) : modAdd(x, y);
+    }
+    adopt(result, coefficients, length, length);
+    return true;
+}
+
+bool polyAdd(Polynomial* result, const Polynomial* a, const Polynomial* b) {
+    return addOrSubtract(result, a, b, false);
+}
+
+bool polySub(Polynomial* result, const Polynomial* a, const Polynomial* b) {
+    return addOrSubtract(result, a, b, true);
+}
+
+// ========== Schoolbook Multiplication ==========
+
+// r[0 .. la + lb - 1) = a * b. Products are below 2^60, so sixteen of them
+// fit in a 64-bit sum: each row adds one product per sum, and the sums a
+// row touched are reduced every 16 rows.
+static bool mulSchoolbook(uint32_t* r, const uint32_t* a, size_t la, const uint32_t* b, size_t lb) {
+    size_t length = la + lb - 1;
+    uint64_t* sums = calloc(length, sizeof(uint64_t));
+    if (sums == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < la; i++) {
+        uint64_t factor = a[i];
+        uint64_t* row = sums + i;
+        for (size_t j = 0; j < lb; j++) {
+            row[j] += factor * b[j];
+        }
+        if (i % 16 == 15 || i == la - 1) {
+            size_t first = i - i % 16;
+            for (size_t k = first; k < i + lb; k++) {
+                sums[k] %= P;
+            }
+        }
+    }
+    for (size_t k = 0; k < length; k++) {
+        r[k] = (uint32_t)sums[k];
+    }
+    free(sums);
+    return true;
+}
+
+// ========== Number-Theoretic Transform ==========
+//
+// The same algorithm as the FFT, but with a root of unity modulo P instead
+// of e^(2 pi i / n), so every step is exact. P - 1 is divisible by 2^23,
+// which allows transforms (and products) up to 2^23 coefficients.
+
+#define NTT_BLOCK 2048   // transforms up to this size run as loops (8 KB, in L1)
+
+// twiddles[h + i] = w^i for i < h, w a root of unity of order 2h, for every
+// power of 2 h < n: each level of the transform reads a contiguous run
+static void buildTwiddles(uint32_t* twiddles, size_t n, bool inverse) {
+    for (size_t h = 1; h < n; h *= 2) {
+        uint32_t root = modPow(P_GENERATOR, (P - 1) / (2 * h));
+        if (inverse) {
+            root = modPow(root, P - 2);
+        }
+        uint32_t power = 1;
+        for (size_t i = 0; i < h; i++) {
+            twiddles[h + i] = power;
+            power = modMul(power, root);
+        }
+    }
+}
+
+// Decimation in frequency: butterflies over the whole array, then the two
+// halves are independent transforms (recursion keeps them in cache). The
+// output is in bit-reversed order, which the pointwise product does not mind.
+static void nttForward(uint32_t* a, size_t n, const uint32_t* twiddles) {
+    if (n <= NTT_BLOCK) {
+        for (size_t length = n; length >= 2; length /= 2) {
+            size_t h = length / 2;
+            const uint32_t* w = twiddles + h;
+            for (size_t block = 0; block < n; block += length) {
+                for (size_t i = 0; i < h; i++) {
+                    uint32_t u = a[block + i];
+                    uint32_t v = a[block + i + h];
+                    a[block + i] = modAdd(u, v);
+                    a[block + i + h] = modMul(modSub(u, v), w[i]);
+                }
+            }
+        }
+        return;
+    }
+    size_t h = n / 2;
+    const uint32_t* w = twiddles + h;
+    for (size_t i = 0; i < h; i++) {
+        uint32_t u = a[i];
+        uint32_t v = a[i + h];
+        a[i] = modAdd(u, v);
+        a[i + h] = modMul(modSub(u, v), w[i]);
+    }
+    nttForward(a, h, twiddles);
+    nttForward(a + h, h, twiddles);
+}
+
+// The forward steps undone in reverse order (decimation in time): takes
+// bit-reversed input and leaves n times the natural-order result
+static void nttInverse(uint32_t* a, size_t n, const uint32_t* twiddles) {
+    if (n <= NTT_BLOCK) {
+        for (size_t length = 2; length <= n; length *= 2) {
+            size_t h = length / 2;
+            const uint32_t* w = twiddles + h;
+            for (size_t block = 0; block < n; block += length) {
+                for (size_t i = 0; i < h; i++) {
+                    uint32_t u = a[block + i];
+                    uint32_t v = modMul(a[block + i + h], w[i]);
+                    a[block + i] = modAdd(u, v);
+                    a[block + i + h] = modSub(u, v);
+                }
+            }
+        }
+        return;
+    }
+    size_t h = n / 2;
+    nttInverse(a, h, twiddles);
+    nttInverse(a + h, h, twiddles);
+    const uint32_t* w = twiddles + h;
+    for (size_t i = 0; i < h; i++) {
+        uint32_t u = a[i];
+        uint32_t v = modMul(a[i + h], w[i]);
+        a[i] = modAdd(u, v);
+        a[i + h] = modSub(u, v);
+    }
+}
+
+static bool mulNtt(uint32_t* r, const uint32_t* a, size_t la, const uint32_t* b, size_t lb) {
+    size_t length = la + lb - 1;
+    if (length > P_MAX_TRANSFORM) {
+        printf("Product of %zu coefficients is too long for the transform\n", length);
+        return false;
+    }
+    bool square = a == b && la == lb;
+    size_t n = 1;
+    while (n < length) {
+        n *= 2;
+    }
+    uint32_t* fa = allocCoefficients(n);
+    uint32_t* fb = square ? fa : allocCoefficients(n);
+    uint32_t* twiddles = allocCoefficients(n);
+    bool ok = fa != NULL && fb != NULL && twiddles != NULL;
+    if (ok) {
+        buildTwiddles(twiddles, n, false);
+        memcpy(fa, a, la * sizeof(uint32_t));
+        memset(fa + la, 0, (n - la) * sizeof(uint32_t));
+        nttForward(fa, n, twiddles);
+        if (!square) {
+            memcpy(fb, b, lb * sizeof(uint32_t));
+            memset(fb + lb, 0, (n - lb) * sizeof(uint32_t));
+            nttForward(fb, n, twiddles);
+        }
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = modMul(fa[i], fb[i]);
+        }
+        buildTwiddles(twiddles, n, true);
+        nttInverse(fa, n, twiddles);
+        uint32_t scale = modPow((uint32_t)n, P - 2);
+        for (size_t k = 0; k < length; k++) {
+            r[k] = modMul(fa[k], scale);
+        }
+    }
+    if (fb != fa) {
+        free(fb);
+    }
+    free(fa);
+    free(twiddles);
+    return ok;
+}
+
+bool polyMulWith(Polynomial* result, const Polynomial* a, const Polynomial* b, PolyMulMethod method) {
+    if (a->length < b->length) {
+        const Polynomial* swap = a;
+        a = b;
+        b = swap;
+    }
+    if (b->length == 0) {
+        result->length = 0;
+        return true;
+    }
+    if (method == POLY_MUL_AUTO) {
+        method = b->length < POLY_NTT_THRESHOLD ? POLY_MUL_SCHOOLBOOK : POLY_MUL_NTT;
+    }
+    size_t length = a->length + b->length - 1;
+    uint32_t* coefficients = allocCoefficients(length);
+    if (coefficients == NULL) {
+        return false;
+    }
+    bool ok = method == POLY_MUL_NTT
+            ? mulNtt(coefficients, a->coefficients, a->length, b->coefficients, b->length)
+            : mulSchoolbook(coefficients, a->coefficients, a->length, b->coefficients, b->length);
+    if (!ok) {
+        free(coefficients);
+        return false;
+    }
+    adopt(result, coefficients, length, length);
+    return true;
+}
+
+bool polyMul(Polynomial* result, const Polynomial* a, const Polynomial* b) {
+    return polyMulWith(result, a, b, POLY_MUL_AUTO);
+}
+
+// ========== Evaluation ==========
+
+uint32_t polyEvaluate(const Polynomial* p, uint32_t x) {
+    uint64_t point = x % P;
+    uint64_t value = 0;
+    for (size_t k = p->length; k-- > 0;) {
+        value = (value * point + p->coefficients[k]) % P;
+    }
+    return (uint32_t)value;
+}
+
+// Horner's rule for many points: one pass over the coefficients serves a
+// whole vector of points, and several independent vectors hide the latency
+// of the multiply-reduce chain
+typedef void (*HornerFunction)(const uint32_t* coefficients, size_t length,
+                               const uint32_t* points, uint32_t* values, size_t count);
+
+static void hornerScalar(const uint32_t* coefficients, size_t length,
+                         const uint32_t* points, uint32_t* values, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint64_t x0 = points[i] % P, x1 = points[i + 1] % P;
+        uint64_t x2 = points[i + 2] % P, x3 = points[i + 3] % P;
+        uint64_t v0 = 0, v1 = 0, v2 = 0, v3 = 0;
+        for (size_t k = length; k-- > 0;) {
+            uint64_t c = coefficients[k];
+            v0 = (v0 * x0 + c) % P;
+            v1 = (v1 * x1 + c) % P;
+            v2 = (v2 * x2 + c) % P;
+            v3 = (v3 * x3 + c) % P;
+        }
+        values[i] = (uint32_t)v0;
+        values[i + 1] = (uint32_t)v1;
+        values[i + 2] = (uint32_t)v2;
+        values[i + 3] = (uint32_t)v3;
+    }
+    for (; i < count; i++) {
+        uint64_t x = points[i] % P;
+        uint64_t v = 0;
+        for (size_t k = length; k-- > 0;) {
+            v = (v * x + coefficients[k]) % P;
+        }
+        values[i] = (uint32_t)v;
+    }
+}
+
+// Montgomery product of each 32-bit lane: the 64-bit products of the even
+// and odd lanes are reduced separately and blended back. Any a works when
+// b < P; the result is below P.
+__attribute__((target("avx2")))
+static inline __m256i montgomeryAvx2(__m256i a, __m256i b) {
+    const __m256i p = _mm256_set1_epi32((int)P);
+    const __m256i negInverse = _mm256_set1_epi32((int)P_NEG_INVERSE);
+    __m256i productEven = _mm256_mul_epu32(a, b);
+    __m256i productOdd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i even = _mm256_add_epi64(productEven, _mm256_mul_epu32(_mm256_mul_epu32(productEven, negInverse), p));
+    __m256i odd = _mm256_add_epi64(productOdd, _mm256_mul_epu32(_mm256_mul_epu32(productOdd, negInverse), p));
+    __m256i result = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    return _mm256_min_epu32(result, _mm256_sub_epi32(result, p));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i hornerStepAvx2(__m256i value, __m256i point, __m256i coefficient) {
+    const __m256i p = _mm256_set1_epi32((int)P);
+    __m256i sum = _mm256_add_epi32(montgomeryAvx2(value, point), coefficient);
+    return _mm256_min_epu32(sum, _mm256_sub_epi32(sum, p));
+}
+
+// Points are kept as x * R, so montgomery(value, x * R) = value * x
+__attribute__((target("avx2")))
+static void hornerAvx2(const uint32_t* coefficients, size_t length,
+                       const uint32_t* points, uint32_t* values, size_t count) {
+    const __m256i rSquared = _mm256_set1_epi32((int)P_R_SQUARED);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i x[4], v[4];
+        for (int q = 0; q < 4; q++) {
+            x[q] = montgomeryAvx2(_mm256_loadu_si256((const __m256i*)(points + i + 8 * q)), rSquared);
+            v[q] = _mm256_setzero_si256();
+        }
+        for (size_t k = length; k-- > 0;) {
+            __m256i c = _mm256_set1_epi32((int)coefficients[k]);
+            v[0] = hornerStepAvx2(v[0], x[0], c);
+            v[1] = hornerStepAvx2(v[1], x[1], c);
+            v[2] = hornerStepAvx2(v[2], x[2], c);
+            v[3] = hornerStepAvx2(v[3], x[3], c);
+        }
+        for (int q = 0; q < 4; q++) {
+            _mm256_storeu_si256((__m256i*)(values + i + 8 * q), v[q]);
+        }
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = montgomeryAvx2(_mm256_loadu_si256((const __m256i*)(points + i)), rSquared);
+        __m256i v = _mm256_setzero_si256();
+        for (size_t k = length; k-- > 0;) {
+            v = hornerStepAvx2(v, x, _mm256_set1_epi32((int)coefficients[k]));
+        }
+        _mm256_storeu_si256((__m256i*)(values + i), v);
+    }
+    hornerScalar(coefficients, length, points + i, values + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i montgomeryAvx512(__m512i a, __m512i b) {
+    const __m512i p = _mm512_set1_epi32((int)P);
+    const __m512i negInverse = _mm512_set1_epi32((int)P_NEG_INVERSE);
+    __m512i productEven = _mm512_mul_epu32(a, b);
+    __m512i productOdd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+    __m512i even = _mm512_add_epi64(productEven, _mm512_mul_epu32(_mm512_mul_epu32(productEven, negInverse), p));
+    __m512i odd = _mm512_add_epi64(productOdd, _mm512_mul_epu32(_mm512_mul_epu32(productOdd, negInverse), p));
+    __m512i result = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+    return _mm512_min_epu32(result, _mm512_sub_epi32(result, p));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i hornerStepAvx512(__m512i value, __m512i point, __m512i coefficient) {
+    const __m512i p = _mm512_set1_epi32((int)P);
+    __m512i sum = _mm512_add_epi32(montgomeryAvx512(value, point), coefficient);
+    return _mm512_min_epu32(sum, _mm512_sub_epi32(sum, p));
+}
+
+__attribute__((target("avx512f")))
+static void hornerAvx512(const uint32_t* coefficients, size_t length,
+                         const uint32_t* points, uint32_t* values, size_t count) {
+    const __m512i rSquared = _mm512_set1_epi32((int)P_R_SQUARED);
+    size_t i = 0;
+    for (; i + 64 <= count; i += 64) {
+        __m512i x[4], v[4];
+        for (int q = 0; q < 4; q++) {
+            x[q] = montgomeryAvx512(_mm512_loadu_si512(points + i + 16 * q), rSquared);
+            v[q] = _mm512_setzero_si512();
+        }
+        for (size_t k = length; k-- > 0;) {
+            __m512i c = _mm512_set1_epi32((int)coefficients[k]);
+            v[0] = hornerStepAvx512(v[0], x[0], c);
+            v[1] = hornerStepAvx512(v[1], x[1], c);
+            v[2] = hornerStepAvx512(v[2], x[2], c);
+            v[3] = hornerStepAvx512(v[3], x[3], c);
+        }
+        for (int q = 0; q < 4; q++) {
+            _mm512_storeu_si512(values + i + 16 * q, v[q]);
+        }
+    }
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = montgomeryAvx512(_mm512_loadu_si512(points + i), rSquared);
+        __m512i v = _mm512_setzero_si512();
+        for (size_t k = length; k-- > 0;) {
+            v = hornerStepAvx512(v, x, _mm512_set1_epi32((int)coefficients[k]));
+        }
+        _mm512_storeu_si512(values + i, v);
+    }
+    hornerScalar(coefficients, length, points + i, values + i, count - i);
+}
+
+DISPATCH_KERNEL(HornerFunction, hornerMany,
+    DISPATCH_VARIANT(hornerAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(hornerAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(hornerScalar, 0))
+
+void polyEvaluateMany(const Polynomial* p, const uint32_t* points, uint32_t* values, size_t count) {
+    hornerMany(p->coefficients, p->length, points, values, count);
+}
+
+// ========== Sparse Polynomials ==========
+
+static SparseTerm* allocTerms(size_t count) {
+    SparseTerm* terms = malloc((count > 0 ? count : 1) * sizeof(SparseTerm));
+    if (terms == NULL) {
+        printf("Memory allocation failed\n");
+    }
+    return terms;
+}
+
+static void adoptTerms(SparsePolynomial* s, SparseTerm* terms, size_t count, size_t capacity) {
+    if (s->terms != terms) {
+        free(s->terms);
+    }
+    s->terms = terms;
+    s->count = count;
+    s->capacity = capacity;
+}
+
+bool sparseInit(SparsePolynomial* s, size_t capacity) {
+    s->terms = allocTerms(capacity);
+    s->count = 0;
+    s->capacity = capacity;
+    return s->terms != NULL;
+}
+
+void sparseFree(SparsePolynomial* s) {
+    free(s->terms);
+    s->terms = NULL;
+    s->count = s->capacity = 0;
+}
+
+static int compareExponents(const void* a, const void* b) {
+    uint64_t x = ((const SparseTerm*)a)->exponent;
+    uint64_t y = ((const SparseTerm*)b)->exponent;
+    return (x > y) - (x < y);
+}
+
+// Sort, add up equal exponents and drop zeros, in place; returns the count
+static size_t normalizeTerms(SparseTerm* terms, size_t count) {
+    qsort(terms, count, sizeof(SparseTerm), compareExponents);
+    size_t kept = 0;
+    for (size_t i = 0; i < count;) {
+        uint64_t exponent = terms[i].exponent;
+        uint32_t sum = 0;
+        for (; i < count && terms[i].exponent == exponent; i++) {
+            sum = modAdd(sum, terms[i].coefficient);
+        }
+        if (sum != 0) {
+            terms[kept].exponent = exponent;
+            terms[kept].coefficient = sum;
+            kept++;
+        }
+    }
+    return kept;
+}
+
+bool sparseSetTerms(SparsePolynomial* s, const SparseTerm* terms, size_t count) {
+    SparseTerm* copy = allocTerms(count);
+    if (copy == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        copy[i].exponent = terms[i].exponent;
+        copy[i].coefficient = terms[i].coefficient % P;
+    }
+    adoptTerms(s, copy, normalizeTerms(copy, count), count);
+    return true;
+}
+
+// The linked-list merge of the docs, into one array
+bool sparseAdd(SparsePolynomial* result, const SparsePolynomial* a, const SparsePolynomial* b) {
+    SparseTerm* terms = allocTerms(a->count + b->count);
+    if (terms == NULL) {
+        return false;
+    }
+    size_t i = 0, j = 0, count = 0;
+    while (i < a->count || j < b->count) {
+        if (j == b->count || (i < a->count && a->terms[i].exponent < b->terms[j].exponent)) {
+            terms[count++] = a->terms[i++];
+        } else if (i == a->count || b->terms[j].exponent < a->terms[i].exponent) {
+            terms[count++] = b->terms[j++];
+        } else {
+            uint32_t sum = modAdd(a->terms[i].coefficient, b->terms[j].coefficient);
+            if (sum != 0) {
+                terms[count].exponent = a->terms[i].exponent;
+                terms[count].coefficient = sum;
+                count++;
+            }
+            i++;
+            j++;
+        }
+    }
+    adoptTerms(result, terms, count, a->count + b->count);
+    return true;
+}
+
+// Every pair of terms, then sort and combine. When the exponents of the
+// product span fewer values than there are pairs, the dense transform is
+// cheaper: shift both to start at exponent 0, multiply, and shift back.
+bool sparseMul(SparsePolynomial* result, const SparsePolynomial* a, const SparsePolynomial* b) {
+    if (a->count == 0 || b->count == 0) {
+        result->count = 0;
+        return true;
+    }
+    uint64_t lowA = a->terms[0].exponent, lowB = b->terms[0].exponent;
+    uint64_t span = (a->terms[a->count - 1].exponent - lowA) + (b->terms[b->count - 1].exponent - lowB) + 1;
+    size_t pairs = a->count * b->count;
+
+    if (span <= pairs && span <= P_MAX_TRANSFORM) {
+        Polynomial denseA, denseB;
+        SparsePolynomial shiftedA = *a, shiftedB = *b;
+        bool ok = polyInit(&denseA, 0) && polyInit(&denseB, 0);
+        // Views with the lowest exponent subtracted
+        SparseTerm* termsA = allocTerms(a->count);
+        SparseTerm* termsB = allocTerms(b->count);
+        ok = ok && termsA != NULL && termsB != NULL;
+        if (ok) {
+            for (size_t i = 0; i < a->count; i++) {
+                termsA[i] = (SparseTerm){ a->terms[i].exponent - lowA, a->terms[i].coefficient };
+            }
+            for (size_t j = 0; j < b->count; j++) {
+                termsB[j] = (SparseTerm){ b->terms[j].exponent - lowB, b->terms[j].coefficient };
+            }
+            shiftedA.terms = termsA;
+            shiftedB.terms = termsB;
+            ok = sparseToDense(&denseA, &shiftedA) && sparseToDense(&denseB, &shiftedB) &&
+                 polyMul(&denseA, &denseA, &denseB) && denseToSparse(result, &denseA);
+        }
+        if (ok) {
+            for (size_t k = 0; k < result->count; k++) {
+                result->terms[k].exponent += lowA + lowB;
+            }
+        }
+        free(termsA);
+        free(termsB);
+        polyFree(&denseA);
+        polyFree(&denseB);
+        return ok;
+    }
+
+    SparseTerm* terms = allocTerms(pairs);
+    if (terms == NULL) {
+        return false;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < a->count; i++) {
+        for (size_t j = 0; j < b->count; j++) {
+            terms[count].exponent = a->terms[i].exponent + b->terms[j].exponent;
+            terms[count].coefficient = modMul(a->terms[i].coefficient, b->terms[j].coefficient);
+            count++;
+        }
+    }
+    adoptTerms(result, terms, normalizeTerms(terms, count), pairs);
+    return true;
+}
+
+// Horner's rule with gaps: x^gap by repeated squaring between terms
+uint32_t sparseEvaluate(const SparsePolynomial* s, uint32_t x) {
+    if (s->count == 0) {
+        return 0;
+    }
+    uint32_t value = s->terms[s->count - 1].coefficient;
+    for (size_t i = s->count - 1; i-- > 0;) {
+        uint64_t gap = s->terms[i + 1].exponent - s->terms[i].exponent;
+        value = modAdd(modMul(value, modPow(x, gap)), s->terms[i].coefficient);
+    }
+    return modMul(value, modPow(x, s->terms[0].exponent));
+}
+
+bool sparseToDense(Polynomial* dense, const SparsePolynomial* s) {
+    size_t length = s->count > 0 ? (size_t)s->terms[s->count - 1].exponent + 1 : 0;
+    uint32_t* coefficients = allocCoefficients(length);
+    if (coefficients == NULL) {
+        return false;
+    }
+    memset(coefficients, 0, length * sizeof(uint32_t));
+    for (size_t i = 0; i < s->count; i++) {
+        coefficients[s->terms[i].exponent] = s->terms[i].coefficient;
+    }
+    adopt(dense, coefficients, length, length);
+    return true;
+}
+
+bool denseToSparse(SparsePolynomial* s, const Polynomial* dense) {
+    size_t count = 0;
+    for (size_t i = 0; i < dense->length; i++) {
+        count += dense->coefficients[i] != 0;
+    }
+    SparseTerm* terms = allocTerms(count);
+    if (terms == NULL) {
+        return false;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < dense->length; i++) {
+        if (dense->coefficients[i] != 0) {
+            terms[k].exponent = i;
+            terms[k].coefficient = dense->coefficients[i];
+            k++;
+        }
+    }
+    adoptTerms(s, terms, count, count);
+    return true;
+}
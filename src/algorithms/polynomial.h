@@ -0,0 +1,95 @@
+/*
+ * polynomial.h - Dense and Sparse Polynomials with NTT Multiplication
+ *
+ * addPolynomials() in docs/11-data-structures/01-linked-lists.md keeps one
+ * malloc'd Term node per term and cannot multiply. This module keeps
+ * polynomials in arrays:
+ *
+ * - dense: coefficients[i] of x^i in one contiguous array
+ * - sparse: (exponent, coefficient) pairs sorted by exponent, for
+ *   polynomials like x^1000000 + 1 whose dense form would be mostly zeros
+ * - multiplication by schoolbook for short factors and by a number-theoretic
+ *   transform (an FFT in exact modular arithmetic) for long ones:
+ *   O(n log n) instead of O(n^2)
+ * - Horner evaluation at many points at once, 8 (AVX2) or 16 (AVX-512)
+ *   points per vector, chosen at startup (see ../dispatch/cpu_dispatch.h)
+ *
+ * Coefficients are integers modulo the prime p = 998244353 = 119 * 2^23 + 1,
+ * as in checksums and hashing: results are exact, never overflow and never
+ * round. A negative value c is stored as p + c; polySetCoefficients() does
+ * the reduction.
+ *
+ * Compile together with polynomial.c:
+ *   gcc -O2 -o program program.c polynomial.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POLY_MODULUS 998244353u
+
+// Shorter factor length from which polyMul() uses the transform
+#define POLY_NTT_THRESHOLD 64
+
+typedef struct {
+    uint32_t* coefficients;   // coefficients[i] multiplies x^i, each below POLY_MODULUS
+    size_t length;            // degree + 1, no zero leading coefficient; 0 for the zero polynomial
+    size_t capacity;
+} Polynomial;
+
+typedef struct {
+    uint64_t exponent;
+    uint32_t coefficient;
+} SparseTerm;
+
+typedef struct {
+    SparseTerm* terms;        // increasing exponents, no zero coefficients
+    size_t count;
+    size_t capacity;
+} SparsePolynomial;
+
+typedef enum {
+    POLY_MUL_AUTO,
+    POLY_MUL_SCHOOLBOOK,
+    POLY_MUL_NTT
+} PolyMulMethod;
+
+// ========== Dense Polynomials ==========
+
+bool polyInit(Polynomial* p, size_t capacity);
+void polyFree(Polynomial* p);
+
+// p = values[0] + values[1] x + ..., each value reduced modulo POLY_MODULUS
+bool polySetCoefficients(Polynomial* p, const int64_t* values, size_t length);
+
+// `result` may be the same Polynomial as an operand
+bool polyAdd(Polynomial* result, const Polynomial* a, const Polynomial* b);
+bool polySub(Polynomial* result, const Polynomial* a, const Polynomial* b);
+bool polyMul(Polynomial* result, const Polynomial* a, const Polynomial* b);
+bool polyMulWith(Polynomial* result, const Polynomial* a, const Polynomial* b, PolyMulMethod method);
+
+uint32_t polyEvaluate(const Polynomial* p, uint32_t x);
+
+// values[i] = p(points[i]) for every i < count
+void polyEvaluateMany(const Polynomial* p, const uint32_t* points, uint32_t* values, size_t count);
+
+// ========== Sparse Polynomials ==========
+
+bool sparseInit(SparsePolynomial* s, size_t capacity);
+void sparseFree(SparsePolynomial* s);
+
+// Terms in any order; equal exponents are added and zero terms dropped
+bool sparseSetTerms(SparsePolynomial* s, const SparseTerm* terms, size_t count);
+
+bool sparseAdd(SparsePolynomial* result, const SparsePolynomial* a, const SparsePolynomial* b);
+bool sparseMul(SparsePolynomial* result, const SparsePolynomial* a, const SparsePolynomial* b);
+uint32_t sparseEvaluate(const SparsePolynomial* s, uint32_t x);
+
+bool sparseToDense(Polynomial* dense, const SparsePolynomial* s);
+bool denseToSparse(SparsePolynomial* s, const Polynomial* dense);
+
+#endif
@@ -0,0 +1,451 @@
+/*
+ * Polynomial Demo: Dense and Sparse Polynomials with NTT Multiplication
+ *
+ * Adds and multiplies the small polynomials of the linked-list example,
+ * multiplies sparse polynomials with huge exponents, checks the transform
+ * against schoolbook multiplication, sparse against dense arithmetic and
+ * every Horner kernel against polyEvaluate(), then times schoolbook
+ * against the transform up to degree 10^6, the Term linked list against
+ * arrays, and batch evaluation per instruction set.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o polynomial_demo polynomial_demo.c polynomial.c ../dispatch/cpu_dispatch.c
+ *   ./polynomial_demo [degree]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "polynomial.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Random coefficients below the modulus, with a nonzero leading one
+static bool randomPoly(Polynomial* p, size_t length, unsigned* seed) {
+    if (!polyInit(p, length)) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        p->coefficients[i] = nextRandom(seed) % POLY_MODULUS;
+    }
+    p->coefficients[length - 1] |= 1;
+    p->length = length;
+    return true;
+}
+
+static bool samePoly(const Polynomial* a, const Polynomial* b) {
+    return a->length == b->length &&
+           memcmp(a->coefficients, b->coefficients, a->length * sizeof(uint32_t)) == 0;
+}
+
+// Coefficients above p / 2 printed as negative numbers
+static void printPoly(const char* name, const Polynomial* p) {
+    printf("%s =", name);
+    bool first = true;
+    for (size_t k = p->length; k-- > 0;) {
+        uint32_t c = p->coefficients[k];
+        if (c == 0) {
+            continue;
+        }
+        long long value = c > POLY_MODULUS / 2 ? (long long)c - POLY_MODULUS : c;
+        if (first) {
+            printf(" %s%lld", value < 0 ? "-" : "", value < 0 ? -value : value);
+        } else {
+            printf(" %s %lld", value < 0 ? "-" : "+", value < 0 ? -value : value);
+        }
+        if (k > 1) {
+            printf("x^%zu", k);
+        } else if (k == 1) {
+            printf("x");
+        }
+        first = false;
+    }
+    printf("%s\n", first ? " 0" : "");
+}
+
+// ========== The Linked List of the Docs ==========
+
+typedef struct Term {
+    int coefficient;
+    int exponent;
+    struct Term* next;
+} Term;
+
+// addPolynomials() from docs/11-data-structures/01-linked-lists.md, with
+// the leftover terms of the longer list copied as well
+static Term* addPolynomials(Term* poly1, Term* poly2) {
+    Term* result = NULL;
+    Term* current = NULL;
+
+    while (poly1 != NULL || poly2 != NULL) {
+        Term* newTerm = (Term*)malloc(sizeof(Term));
+        if (newTerm == NULL) {
+            printf("Memory allocation failed\n");
+            return result;
+        }
+
+        if (poly2 == NULL || (poly1 != NULL && poly1->exponent > poly2->exponent)) {
+            newTerm->coefficient = poly1->coefficient;
+            newTerm->exponent = poly1->exponent;
+            poly1 = poly1->next;
+        } else if (poly1 == NULL || poly1->exponent < poly2->exponent) {
+            newTerm->coefficient = poly2->coefficient;
+            newTerm->exponent = poly2->exponent;
+            poly2 = poly2->next;
+        } else {
+            newTerm->coefficient = poly1->coefficient + poly2->coefficient;
+            newTerm->exponent = poly1->exponent;
+            poly1 = poly1->next;
+            poly2 = poly2->next;
+        }
+
+        newTerm->next = NULL;
+
+        if (result == NULL) {
+            result = newTerm;
+            current = newTerm;
+        } else {
+            current->next = newTerm;
+            current = newTerm;
+        }
+    }
+
+    return result;
+}
+
+// Highest exponent first, as the list expects
+static Term* toTerms(const Polynomial* p) {
+    Term* head = NULL;
+    for (size_t k = 0; k < p->length; k++) {
+        Term* term = malloc(sizeof(Term));
+        if (term == NULL) {
+            printf("Memory allocation failed\n");
+            break;
+        }
+        term->coefficient = (int)(p->coefficients[k] % 1000);
+        term->exponent = (int)k;
+        term->next = head;
+        head = term;
+    }
+    return head;
+}
+
+static void freeTerms(Term* head) {
+    while (head != NULL) {
+        Term* next = head->next;
+        free(head);
+        head = next;
+    }
+}
+
+// ========== Checks ==========
+
+static bool checkMultiplication(unsigned* seed) {
+    const size_t sizes[][2] = { { 1, 1 }, { 2, 1 }, { 63, 63 }, { 64, 64 }, { 65, 3 }, { 100, 100 },
+                                { 1000, 999 }, { 1024, 1025 }, { 3000, 70 }, { 5000, 5000 } };
+    bool ok = true;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ok; s++) {
+        Polynomial a, b, expected, actual;
+        ok = randomPoly(&a, sizes[s][0], seed) && randomPoly(&b, sizes[s][1], seed) &&
+             polyInit(&expected, 0) && polyInit(&actual, 0) &&
+             polyMulWith(&expected, &a, &b, POLY_MUL_SCHOOLBOOK) &&
+             polyMulWith(&actual, &a, &b, POLY_MUL_NTT) && samePoly(&actual, &expected) &&
+             polyMul(&actual, &a, &b) && samePoly(&actual, &expected) &&
+             polyMulWith(&expected, &a, &a, POLY_MUL_SCHOOLBOOK) &&
+             polyMulWith(&actual, &a, &a, POLY_MUL_NTT) && samePoly(&actual, &expected);
+        polyFree(&a);
+        polyFree(&b);
+        polyFree(&expected);
+        polyFree(&actual);
+    }
+    return ok;
+}
+
+// Random sparse polynomials with small exponents, so the dense results
+// can be compared; the span decides which path sparseMul() takes
+static bool checkSparse(unsigned* seed) {
+    bool ok = true;
+    for (int round = 0; round < 200 && ok; round++) {
+        SparseTerm termsA[40], termsB[40];
+        size_t countA = 1 + nextRandom(seed) % 40, countB = 1 + nextRandom(seed) % 40;
+        uint64_t span = round % 2 == 0 ? 50 : 100000;
+        for (size_t i = 0; i < countA; i++) {
+            termsA[i] = (SparseTerm){ nextRandom(seed) % span, nextRandom(seed) % 5 };
+        }
+        for (size_t i = 0; i < countB; i++) {
+            termsB[i] = (SparseTerm){ nextRandom(seed) % span, nextRandom(seed) % 5 };
+        }
+        SparsePolynomial a, b, sum, product, converted;
+        Polynomial denseA, denseB, expected, actual;
+        ok = sparseInit(&a, 0) && sparseInit(&b, 0) && sparseInit(&sum, 0) &&
+             sparseInit(&product, 0) && sparseInit(&converted, 0) &&
+             polyInit(&denseA, 0) && polyInit(&denseB, 0) && polyInit(&expected, 0) && polyInit(&actual, 0) &&
+             sparseSetTerms(&a, termsA, countA) && sparseSetTerms(&b, termsB, countB) &&
+             sparseToDense(&denseA, &a) && sparseToDense(&denseB, &b) &&
+             sparseAdd(&sum, &a, &b) && polyAdd(&expected, &denseA, &denseB) &&
+             sparseToDense(&actual, &sum) && samePoly(&actual, &expected) &&
+             sparseMul(&product, &a, &b) && polyMul(&expected, &denseA, &denseB) &&
+             sparseToDense(&actual, &product) && samePoly(&actual, &expected) &&
+             denseToSparse(&converted, &expected) && converted.count == product.count &&
+             sparseEvaluate(&product, 12345) == polyEvaluate(&expected, 12345);
+        for (size_t i = 1; ok && i < product.count; i++) {
+            ok = product.terms[i - 1].exponent < product.terms[i].exponent && product.terms[i].coefficient != 0;
+        }
+        sparseFree(&a);
+        sparseFree(&b);
+        sparseFree(&sum);
+        sparseFree(&product);
+        sparseFree(&converted);
+        polyFree(&denseA);
+        polyFree(&denseB);
+        polyFree(&expected);
+        polyFree(&actual);
+    }
+    return ok;
+}
+
+// Every Horner variant this CPU can run against one polyEvaluate() per
+// point, with counts that leave tails for each vector width
+static bool checkHorner(unsigned* seed) {
+    const DispatchKernel* kernel = dispatchFind("hornerMany");
+    const size_t counts[] = { 0, 1, 7, 8, 31, 33, 64, 100, 257 };
+    Polynomial p;
+    if (!randomPoly(&p, 300, seed)) {
+        return false;
+    }
+    uint32_t points[257], values[257];
+    for (size_t i = 0; i < 257; i++) {
+        // include 0, p - 1 and values above p
+        points[i] = i == 0 ? 0 : i == 1 ? POLY_MODULUS - 1 : nextRandom(seed);
+    }
+    bool ok = true;
+    for (int v = 0; v < kernel->variantCount && ok; v++) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]) && ok; c++) {
+            polyEvaluateMany(&p, points, values, counts[c]);
+            for (size_t i = 0; i < counts[c] && ok; i++) {
+                ok = values[i] == polyEvaluate(&p, points[i]);
+            }
+        }
+        if (!ok) {
+            printf("  %s differs\n", kernel->variants[v].name);
+        }
+    }
+    dispatchRestore(kernel);
+    polyFree(&p);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static void timeAddition(unsigned* seed) {
+    const size_t length = 1000000;
+    struct timespec start, end;
+    printf("\n=== Adding two polynomials of %zu terms ===\n", length);
+    Polynomial a, b, sum;
+    SparsePolynomial sparseA, sparseB, sparseSum;
+    if (!randomPoly(&a, length, seed) || !randomPoly(&b, length, seed) || !polyInit(&sum, 0) ||
+        !sparseInit(&sparseA, 0) || !sparseInit(&sparseB, 0) || !sparseInit(&sparseSum, 0) ||
+        !denseToSparse(&sparseA, &a) || !denseToSparse(&sparseB, &b)) {
+        return;
+    }
+    Term* listA = toTerms(&a);
+    Term* listB = toTerms(&b);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Term* listSum = addPolynomials(listA, listB);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end);
+    printf("Term linked list: %8.3f ms\n", baseline * 1e3);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sparseAdd(&sparseSum, &sparseA, &sparseB);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsedSeconds(start, end);
+    printf("sparseAdd:        %8.3f ms (%.1fx)\n", seconds * 1e3, baseline / seconds);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    polyAdd(&sum, &a, &b);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("polyAdd:          %8.3f ms (%.1fx)\n", seconds * 1e3, baseline / seconds);
+
+    freeTerms(listA);
+    freeTerms(listB);
+    freeTerms(listSum);
+    polyFree(&a);
+    polyFree(&b);
+    polyFree(&sum);
+    sparseFree(&sparseA);
+    sparseFree(&sparseB);
+    sparseFree(&sparseSum);
+}
+
+static void timeMultiplication(size_t degree, unsigned* seed) {
+    struct timespec start, end;
+    printf("\n=== Multiplying two polynomials ===\n");
+    printf("%10s %14s %14s\n", "degree", "schoolbook", "NTT");
+    const size_t degrees[] = { 100, 1000, 10000, 100000, degree };
+    for (int d = 0; d < 5; d++) {
+        if (d == 4 && degree <= 100000) {
+            break;
+        }
+        Polynomial a, b, product;
+        if (!randomPoly(&a, degrees[d] + 1, seed) || !randomPoly(&b, degrees[d] + 1, seed) ||
+            !polyInit(&product, 0)) {
+            return;
+        }
+        printf("%10zu", degrees[d]);
+        if (degrees[d] <= 10000) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            polyMulWith(&product, &a, &b, POLY_MUL_SCHOOLBOOK);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            printf(" %12.3f ms", elapsedSeconds(start, end) * 1e3);
+        } else {
+            printf(" %15s", "-");
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool ok = polyMulWith(&product, &a, &b, POLY_MUL_NTT);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf(" %12.3f ms", elapsedSeconds(start, end) * 1e3);
+        // (a * b)(x) = a(x) * b(x) at a few points
+        for (uint32_t x = 2; x < 6 && ok; x++) {
+            ok = polyEvaluate(&product, x) ==
+                 (uint64_t)polyEvaluate(&a, x) * polyEvaluate(&b, x) % POLY_MODULUS;
+        }
+        printf("  %s\n", ok ? "(a*b)(x) = a(x)*b(x)" : "MISMATCH");
+        polyFree(&a);
+        polyFree(&b);
+        polyFree(&product);
+    }
+}
+
+static void timeEvaluation(unsigned* seed) {
+    const size_t length = 1000, count = 100000;
+    struct timespec start, end;
+    printf("\n=== Evaluating a degree-%zu polynomial at %zu points ===\n", length - 1, count);
+    Polynomial p;
+    uint32_t* points = malloc(count * sizeof(uint32_t));
+    uint32_t* values = malloc(count * sizeof(uint32_t));
+    if (points == NULL || values == NULL || !randomPoly(&p, length, seed)) {
+        printf("Memory allocation failed\n");
+        free(points);
+        free(values);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        points[i] = nextRandom(seed) % POLY_MODULUS;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t check = 0;
+    for (size_t i = 0; i < count; i++) {
+        check ^= polyEvaluate(&p, points[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end);
+    printf("polyEvaluate per point: %8.3f ms\n", baseline * 1e3);
+
+    const DispatchKernel* kernel = dispatchFind("hornerMany");
+    for (int v = 0; v < kernel->variantCount; v++) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        polyEvaluateMany(&p, points, values, count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        uint32_t batchCheck = 0;
+        for (size_t i = 0; i < count; i++) {
+            batchCheck ^= values[i];
+        }
+        printf("%-22s  %8.3f ms (%.1fx)%s\n", kernel->variants[v].name, seconds * 1e3,
+               baseline / seconds, batchCheck == check ? "" : "  MISMATCH");
+    }
+    dispatchRestore(kernel);
+    polyFree(&p);
+    free(points);
+    free(values);
+}
+
+int main(int argc, char* argv[]) {
+    long long degree = argc > 1 ? atoll(argv[1]) : 1000000;
+    if (degree < 1 || degree >= (1 << 22)) {
+        printf("Usage: %s [degree below 4194304]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Example: the linked-list polynomials as arrays ===\n");
+    const int64_t valuesA[] = { 5, 0, -3, 0, 2 };   // 2x^4 - 3x^2 + 5
+    const int64_t valuesB[] = { -1, 4, 3 };         // 3x^2 + 4x - 1
+    Polynomial a, b, result;
+    polyInit(&a, 0);
+    polyInit(&b, 0);
+    polyInit(&result, 0);
+    polySetCoefficients(&a, valuesA, 5);
+    polySetCoefficients(&b, valuesB, 3);
+    printPoly("a    ", &a);
+    printPoly("b    ", &b);
+    polyAdd(&result, &a, &b);
+    printPoly("a + b", &result);
+    polySub(&result, &a, &b);
+    printPoly("a - b", &result);
+    polyMul(&result, &a, &b);
+    printPoly("a * b", &result);
+    printf("(a * b)(2) = %u\n", polyEvaluate(&result, 2));
+    polyFree(&a);
+    polyFree(&b);
+    polyFree(&result);
+
+    const SparseTerm termsA[] = { { 1000000000000ull, 1 }, { 0, 1 } };
+    const SparseTerm termsB[] = { { 1000000000000ull, 1 }, { 0, POLY_MODULUS - 1 } };
+    SparsePolynomial sparseA, sparseB, sparseProduct;
+    sparseInit(&sparseA, 0);
+    sparseInit(&sparseB, 0);
+    sparseInit(&sparseProduct, 0);
+    sparseSetTerms(&sparseA, termsA, 2);
+    sparseSetTerms(&sparseB, termsB, 2);
+    sparseMul(&sparseProduct, &sparseA, &sparseB);
+    printf("(x^1000000000000 + 1)(x^1000000000000 - 1) =");
+    for (size_t i = sparseProduct.count; i-- > 0;) {
+        printf(" %+lld x^%llu", sparseProduct.terms[i].coefficient > POLY_MODULUS / 2
+               ? (long long)sparseProduct.terms[i].coefficient - POLY_MODULUS
+               : (long long)sparseProduct.terms[i].coefficient,
+               (unsigned long long)sparseProduct.terms[i].exponent);
+    }
+    printf(" (%zu terms)\n", sparseProduct.count);
+    sparseFree(&sparseA);
+    sparseFree(&sparseB);
+    sparseFree(&sparseProduct);
+
+    unsigned seed = 2463534242u;
+    printf("\n=== Checks ===\n");
+    bool multiplyOk = checkMultiplication(&seed);
+    printf("Schoolbook vs NTT, 1 to 5000 coefficients: %s\n", multiplyOk ? "all match" : "MISMATCH");
+    bool sparseOk = checkSparse(&seed);
+    printf("Sparse vs dense add, multiply and evaluate: %s\n", sparseOk ? "all match" : "MISMATCH");
+    bool hornerOk = checkHorner(&seed);
+    printf("Batch Horner (every variant) vs polyEvaluate: %s\n", hornerOk ? "all match" : "MISMATCH");
+
+    timeMultiplication((size_t)degree, &seed);
+    timeAddition(&seed);
+    timeEvaluation(&seed);
+    return multiplyOk && sparseOk && hornerOk ? 0 : 1;
+}
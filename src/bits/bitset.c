@@ -0,0 +1,507 @@
+/*
+ * bitset.c - Dynamically Sized Bitsets with Bulk Popcount, Rank and Select (see bitset.h)
+ */
+
+#include "bitset.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#define WORDS_PER_BLOCK 8   // 512 bits per rank counter: one cache line of words
+
+static size_t wordsFor(size_t bits) {
+    return (bits + 63) / 64;
+}
+
+// Mask of the valid bits in the last word (all ones when bits is a multiple of 64)
+static uint64_t tailMask(size_t bits) {
+    return (bits & 63) ? (1ULL << (bits & 63)) - 1 : ~0ULL;
+}
+
+// SWAR popcount: add neighbouring bit pairs, then nibbles, then bytes
+static inline uint64_t popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+// ========== Creation ==========
+
+bool bitsetInit(Bitset* bitset, size_t bits) {
+    bitset->bits = bits;
+    bitset->wordCount = wordsFor(bits);
+    bitset->rankIndex = NULL;
+    bitset->words = calloc(bitset->wordCount ? bitset->wordCount : 1, sizeof(uint64_t));
+    if (bitset->words == NULL) {
+        printf("Memory allocation failed\n");
+        bitset->bits = 0;
+        bitset->wordCount = 0;
+        return false;
+    }
+    return true;
+}
+
+void bitsetDestroy(Bitset* bitset) {
+    free(bitset->words);
+    free(bitset->rankIndex);
+    bitset->words = NULL;
+    bitset->rankIndex = NULL;
+    bitset->bits = 0;
+    bitset->wordCount = 0;
+}
+
+bool bitsetResize(Bitset* bitset, size_t bits) {
+    size_t wordCount = wordsFor(bits);
+    uint64_t* words = realloc(bitset->words, (wordCount ? wordCount : 1) * sizeof(uint64_t));
+    if (words == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    if (wordCount > bitset->wordCount) {
+        memset(words + bitset->wordCount, 0, (wordCount - bitset->wordCount) * sizeof(uint64_t));
+    }
+    bitset->words = words;
+    bitset->wordCount = wordCount;
+    bitset->bits = bits;
+    if (wordCount > 0) {
+        words[wordCount - 1] &= tailMask(bits);   // drop bits cut off by shrinking
+    }
+    free(bitset->rankIndex);   // stale now
+    bitset->rankIndex = NULL;
+    return true;
+}
+
+void bitsetClearAll(Bitset* bitset) {
+    memset(bitset->words, 0, bitset->wordCount * sizeof(uint64_t));
+}
+
+void bitsetSetAll(Bitset* bitset) {
+    if (bitset->wordCount == 0) {
+        return;
+    }
+    memset(bitset->words, 0xff, bitset->wordCount * sizeof(uint64_t));
+    bitset->words[bitset->wordCount - 1] = tailMask(bitset->bits);
+}
+
+// ========== Set Operations ==========
+
+// Plain word loops: GCC vectorizes them with the baseline SSE2 at -O2/-O3,
+// and they are memory-bound long before the ALU matters
+#define BITSET_BINARY_OP(name, expression)                              \
+    bool name(Bitset* dest, const Bitset* a, const Bitset* b) {         \
+        if (a->bits != b->bits || dest->bits != a->bits) {              \
+            return false;                                               \
+        }                                                               \
+        uint64_t* out = dest->words;                                    \
+        const uint64_t* x = a->words;                                   \
+        const uint64_t* y = b->words;                                   \
+        for (size_t i = 0; i < a->wordCount; i++) {                     \
+            out[i] = (expression);                                      \
+        }                                                               \
+        return true;                                                    \
+    }
+
+BITSET_BINARY_OP(bitsetAnd, x[i] & y[i])
+BITSET_BINARY_OP(bitsetOr, x[i] | y[i])
+BITSET_BINARY_OP(bitsetXor, x[i] ^ y[i])
+BITSET_BINARY_OP(bitsetAndNot, x[i] & ~y[i])
+
+size_t bitsetCount(const Bitset* bitset) {
+    return popcountWords(bitset->words, bitset->wordCount);
+}
+
+// Count in chunks that stay in L1, so the AND result is never written to memory
+size_t bitsetAndCount(const Bitset* a, const Bitset* b) {
+    uint64_t chunk[256];
+    size_t count = 0;
+    size_t n = a->wordCount < b->wordCount ? a->wordCount : b->wordCount;
+    for (size_t start = 0; start < n; start += 256) {
+        size_t length = n - start < 256 ? n - start : 256;
+        for (size_t i = 0; i < length; i++) {
+            chunk[i] = a->words[start + i] & b->words[start + i];
+        }
+        count += popcountWords(chunk, length);
+    }
+    return count;
+}
+
+bool bitsetEqual(const Bitset* a, const Bitset* b) {
+    return a->bits == b->bits && memcmp(a->words, b->words, a->wordCount * sizeof(uint64_t)) == 0;
+}
+
+// ========== Rank / Select ==========
+
+bool bitsetBuildRank(Bitset* bitset) {
+    size_t blocks = (bitset->wordCount + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+    uint64_t* index = realloc(bitset->rankIndex, (blocks + 1) * sizeof(uint64_t));
+    if (index == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    uint64_t total = 0;
+    for (size_t block = 0; block < blocks; block++) {
+        index[block] = total;
+        size_t start = block * WORDS_PER_BLOCK;
+        size_t length = bitset->wordCount - start < WORDS_PER_BLOCK ? bitset->wordCount - start : WORDS_PER_BLOCK;
+        total += popcountWords(bitset->words + start, length);
+    }
+    index[blocks] = total;   // sentinel: total set bits
+    bitset->rankIndex = index;
+    return true;
+}
+
+size_t bitsetRank(const Bitset* bitset, size_t index) {
+    size_t word = index >> 6;
+    size_t count = 0;
+    size_t i = 0;
+    if (bitset->rankIndex != NULL) {
+        count = (size_t)bitset->rankIndex[word / WORDS_PER_BLOCK];
+        i = word / WORDS_PER_BLOCK * WORDS_PER_BLOCK;
+    }
+    // At most 7 whole words with the index; the whole prefix without it
+    for (; i < word; i++) {
+        count += (size_t)popcount64(bitset->words[i]);
+    }
+    if (index & 63) {
+        count += (size_t)popcount64(bitset->words[word] & ((1ULL << (index & 63)) - 1));
+    }
+    return count;
+}
+
+// Position of set bit r (0-based) inside one word, r < popcount(word)
+
+// pdep deposits the single bit 1 << r at the position of the r-th set bit
+// of word. Fast on Intel since Haswell and on AMD since Zen 3 (microcoded
+// and slow on earlier AMD).
+__attribute__((target("bmi,bmi2")))
+static unsigned selectInWordBmi2(uint64_t word, unsigned r) {
+    return (unsigned)_tzcnt_u64(_pdep_u64(1ULL << r, word));
+}
+
+static unsigned selectInWordScalar(uint64_t word, unsigned r) {
+    for (unsigned i = 0; i < r; i++) {
+        word &= word - 1;   // Clears the least significant set bit
+    }
+    return (unsigned)__builtin_ctzll(word);
+}
+
+typedef unsigned (*SelectInWordFunction)(uint64_t word, unsigned r);
+DISPATCH_KERNEL(SelectInWordFunction, bitsetSelectInWord,
+    DISPATCH_VARIANT(selectInWordBmi2, CPU_BMI1 | CPU_BMI2),
+    DISPATCH_VARIANT(selectInWordScalar, 0))
+
+size_t bitsetSelect(const Bitset* bitset, size_t k) {
+    size_t word = 0;
+    if (bitset->rankIndex != NULL) {
+        // Last block whose count of earlier bits is <= k
+        size_t blocks = (bitset->wordCount + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+        if (k >= bitset->rankIndex[blocks]) {
+            return BITSET_NONE;
+        }
+        size_t low = 0;
+        size_t high = blocks - 1;
+        while (low < high) {
+            size_t mid = low + (high - low + 1) / 2;
+            if (bitset->rankIndex[mid] <= k) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        k -= (size_t)bitset->rankIndex[low];
+        word = low * WORDS_PER_BLOCK;
+    }
+    for (; word < bitset->wordCount; word++) {
+        size_t count = (size_t)popcount64(bitset->words[word]);
+        if (k < count) {
+            return word * 64 + bitsetSelectInWord(bitset->words[word], (unsigned)k);
+        }
+        k -= count;
+    }
+    return BITSET_NONE;
+}
+
+// ========== Iteration ==========
+
+size_t bitsetNext(const Bitset* bitset, size_t from) {
+    if (from >= bitset->bits) {
+        return BITSET_NONE;
+    }
+    size_t word = from >> 6;
+    uint64_t bits = bitset->words[word] & (~0ULL << (from & 63));
+    while (bits == 0) {
+        if (++word >= bitset->wordCount) {
+            return BITSET_NONE;
+        }
+        bits = bitset->words[word];
+    }
+    return word * 64 + (size_t)__builtin_ctzll(bits);
+}
+
+// tzcnt finds the lowest set bit, word &= word - 1 clears it: one step per
+// set bit, and empty words cost one compare
+void bitsetForEach(const Bitset* bitset, BitVisitor visit, void* context) {
+    for (size_t word = 0; word < bitset->wordCount; word++) {
+        uint64_t bits = bitset->words[word];
+        while (bits != 0) {
+            size_t index = word * 64 + (size_t)__builtin_ctzll(bits);
+            if (visit(index, context) != 0) {
+                return;
+            }
+            bits &= bits - 1;
+        }
+    }
+}
+
+size_t bitsetToIndices(const Bitset* bitset, uint32_t* out) {
+    size_t count = 0;
+    for (size_t word = 0; word < bitset->wordCount; word++) {
+        uint64_t bits = bitset->words[word];
+        while (bits != 0) {
+            out[count++] = (uint32_t)(word * 64 + (size_t)__builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
+// ========== Popcount Kernels ==========
+
+// count_set_bits() from loopholes/03_bitwise_tricks.c: one step per set bit
+size_t popcountKernighan(const uint64_t* words, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t word = words[i];
+        while (word) {
+            word &= word - 1;   // Clears the least significant set bit
+            count++;
+        }
+    }
+    return count;
+}
+
+// Carry-save adder: adds three bit vectors, giving a sum bit and a carry
+// bit per position, like a row of full adders
+#define CSA(high, low, a, b, c)           \
+    do {                                  \
+        uint64_t u = (a) ^ (b);           \
+        (high) = ((a) & (b)) | (u & (c)); \
+        (low) = u ^ (c);                  \
+    } while (0)
+
+// Harley-Seal: a tree of carry-save adders turns 16 words into one
+// "sixteens" word, so only one popcount is needed per 16 words
+size_t popcountHarleySeal(const uint64_t* words, size_t n) {
+    uint64_t total = 0;
+    uint64_t ones = 0, twos = 0, fours = 0, eights = 0, sixteens;
+    uint64_t twosA, twosB, foursA, foursB, eightsA, eightsB;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        CSA(twosA, ones, ones, words[i + 0], words[i + 1]);
+        CSA(twosB, ones, ones, words[i + 2], words[i + 3]);
+        CSA(foursA, twos, twos, twosA, twosB);
+        CSA(twosA, ones, ones, words[i + 4], words[i + 5]);
+        CSA(twosB, ones, ones, words[i + 6], words[i + 7]);
+        CSA(foursB, twos, twos, twosA, twosB);
+        CSA(eightsA, fours, fours, foursA, foursB);
+        CSA(twosA, ones, ones, words[i + 8], words[i + 9]);
+        CSA(twosB, ones, ones, words[i + 10], words[i + 11]);
+        CSA(foursA, twos, twos, twosA, twosB);
+        CSA(twosA, ones, ones, words[i + 12], words[i + 13]);
+        CSA(twosB, ones, ones, words[i + 14], words[i + 15]);
+        CSA(foursB, twos, twos, twosA, twosB);
+        CSA(eightsB, fours, fours, foursA, foursB);
+        CSA(sixteens, eights, eights, eightsA, eightsB);
+        total += popcount64(sixteens);
+    }
+    total = 16 * total + 8 * popcount64(eights) + 4 * popcount64(fours)
+          + 2 * popcount64(twos) + popcount64(ones);
+    for (; i < n; i++) {
+        total += popcount64(words[i]);
+    }
+    return (size_t)total;
+}
+
+// Four independent accumulators, so the adds do not wait on each other
+__attribute__((target("popcnt")))
+static size_t popcountHardware(const uint64_t* words, size_t n) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += (uint64_t)_mm_popcnt_u64(words[i + 0]);
+        c1 += (uint64_t)_mm_popcnt_u64(words[i + 1]);
+        c2 += (uint64_t)_mm_popcnt_u64(words[i + 2]);
+        c3 += (uint64_t)_mm_popcnt_u64(words[i + 3]);
+    }
+    for (; i < n; i++) {
+        c0 += (uint64_t)_mm_popcnt_u64(words[i]);
+    }
+    return (size_t)(c0 + c1 + c2 + c3);
+}
+
+// Bit count of each byte: look up both nibbles with vpshufb
+__attribute__((target("avx2")))
+static inline __m256i popcountBytesAvx2(__m256i v) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+                           _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+}
+
+// Sum the byte counts of each 64-bit lane with vpsadbw
+__attribute__((target("avx2")))
+static inline __m256i popcountLanesAvx2(__m256i v) {
+    return _mm256_sad_epu8(popcountBytesAvx2(v), _mm256_setzero_si256());
+}
+
+#define CSA256(high, low, a, b, c)                                                       \
+    do {                                                                                 \
+        __m256i u = _mm256_xor_si256((a), (b));                                          \
+        (high) = _mm256_or_si256(_mm256_and_si256((a), (b)), _mm256_and_si256(u, (c))); \
+        (low) = _mm256_xor_si256(u, (c));                                                \
+    } while (0)
+
+// Harley-Seal over 256-bit registers (Mula, Kurz and Lemire): 16 vectors
+// (64 words) per iteration need one nibble lookup instead of sixteen
+__attribute__((target("avx2")))
+static size_t popcountAvx2(const uint64_t* words, size_t n) {
+    const __m256i* v = (const __m256i*)words;
+    size_t vectors = n / 4;
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256(), twos = ones, fours = ones, eights = ones, sixteens;
+    __m256i twosA, twosB, foursA, foursB, eightsA, eightsB;
+    size_t i = 0;
+    for (; i + 16 <= vectors; i += 16) {
+        CSA256(twosA, ones, ones, _mm256_loadu_si256(v + i + 0), _mm256_loadu_si256(v + i + 1));
+        CSA256(twosB, ones, ones, _mm256_loadu_si256(v + i + 2), _mm256_loadu_si256(v + i + 3));
+        CSA256(foursA, twos, twos, twosA, twosB);
+        CSA256(twosA, ones, ones, _mm256_loadu_si256(v + i + 4), _mm256_loadu_si256(v + i + 5));
+        CSA256(twosB, ones, ones, _mm256_loadu_si256(v + i + 6), _mm256_loadu_si256(v + i + 7));
+        CSA256(foursB, twos, twos, twosA, twosB);
+        CSA256(eightsA, fours, fours, foursA, foursB);
+        CSA256(twosA, ones, ones, _mm256_loadu_si256(v + i + 8), _mm256_loadu_si256(v + i + 9));
+        CSA256(twosB, ones, ones, _mm256_loadu_si256(v + i + 10), _mm256_loadu_si256(v + i + 11));
+        CSA256(foursA, twos, twos, twosA, twosB);
+        CSA256(twosA, ones, ones, _mm256_loadu_si256(v + i + 12), _mm256_loadu_si256(v + i + 13));
+        CSA256(twosB, ones, ones, _mm256_loadu_si256(v + i + 14), _mm256_loadu_si256(v + i + 15));
+        CSA256(foursB, twos, twos, twosA, twosB);
+        CSA256(eightsB, fours, fours, foursA, foursB);
+        CSA256(sixteens, eights, eights, eightsA, eightsB);
+        total = _mm256_add_epi64(total, popcountLanesAvx2(sixteens));
+    }
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcountLanesAvx2(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcountLanesAvx2(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcountLanesAvx2(twos), 1));
+    total = _mm256_add_epi64(total, popcountLanesAvx2(ones));
+    for (; i < vectors; i++) {
+        total = _mm256_add_epi64(total, popcountLanesAvx2(_mm256_loadu_si256(v + i)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    size_t count = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    for (i = vectors * 4; i < n; i++) {
+        count += (size_t)popcount64(words[i]);
+    }
+    return count;
+}
+
+// VPOPCNTDQ counts eight words per instruction; the masked load handles the tail
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t popcountAvx512(const uint64_t* words, size_t n) {
+    __m512i total0 = _mm512_setzero_si512();
+    __m512i total1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        total0 = _mm512_add_epi64(total0, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+        total1 = _mm512_add_epi64(total1, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i + 8)));
+    }
+    for (; i < n; i += 8) {
+        size_t rest = n - i < 8 ? n - i : 8;
+        __mmask8 mask = (__mmask8)((1u << rest) - 1);
+        total0 = _mm512_add_epi64(total0, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(mask, words + i)));
+    }
+    return (size_t)_mm512_reduce_add_epi64(_mm512_add_epi64(total0, total1));
+}
+
+DISPATCH_KERNEL(PopcountFunction, popcountWords,
+    DISPATCH_VARIANT(popcountAvx512, CPU_AVX512F | CPU_AVX512VPOPCNTDQ),
+    DISPATCH_VARIANT(popcountAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(popcountHardware, CPU_POPCNT),
+    DISPATCH_VARIANT(popcountHarleySeal, 0))
+
+// ========== Branchless Array Kernels ==========
+
+// min_no_branch/max_no_branch applied element by element. No branch means
+// no mispredictions on random data, and GCC can vectorize the loop.
+static void arrayMinMaxScalar(const int* arr, size_t n, int* min, int* max) {
+    int low = arr[0];
+    int high = arr[0];
+    for (size_t i = 1; i < n; i++) {
+        int x = arr[i];
+        low = low ^ ((x ^ low) & -(x < low));
+        high = high ^ ((x ^ high) & -(x > high));
+    }
+    *min = low;
+    *max = high;
+}
+
+__attribute__((target("avx2")))
+static void arrayMinMaxAvx2(const int* arr, size_t n, int* min, int* max) {
+    __m256i low = _mm256_set1_epi32(arr[0]);
+    __m256i high = low;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(arr + i));
+        low = _mm256_min_epi32(low, v);
+        high = _mm256_max_epi32(high, v);
+    }
+    int lows[8], highs[8];
+    _mm256_storeu_si256((__m256i*)lows, low);
+    _mm256_storeu_si256((__m256i*)highs, high);
+    int resultLow = lows[0];
+    int resultHigh = highs[0];
+    for (int lane = 1; lane < 8; lane++) {
+        resultLow = lows[lane] < resultLow ? lows[lane] : resultLow;
+        resultHigh = highs[lane] > resultHigh ? highs[lane] : resultHigh;
+    }
+    for (; i < n; i++) {
+        resultLow = arr[i] < resultLow ? arr[i] : resultLow;
+        resultHigh = arr[i] > resultHigh ? arr[i] : resultHigh;
+    }
+    *min = resultLow;
+    *max = resultHigh;
+}
+
+DISPATCH_KERNEL(MinMaxFunction, arrayMinMax,
+    DISPATCH_VARIANT(arrayMinMaxAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(arrayMinMaxScalar, 0))
+
+// abs_no_branch(): mask is 0 or -1. The add is done unsigned so that
+// INT_MIN wraps to itself (like abs() in practice) instead of overflowing.
+static void arrayAbsScalar(const int* in, int* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int mask = in[i] >> 31;
+        out[i] = (int)(((unsigned)in[i] + (unsigned)mask) ^ (unsigned)mask);
+    }
+}
+
+__attribute__((target("avx2")))
+static void arrayAbsAvx2(const int* in, int* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_abs_epi32(v));
+    }
+    arrayAbsScalar(in + i, out + i, n - i);
+}
+
+DISPATCH_KERNEL(AbsFunction, arrayAbs,
+    DISPATCH_VARIANT(arrayAbsAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(arrayAbsScalar, 0))
@@ -0,0 +1,116 @@
+/*
+ * bitset.h - Dynamically Sized Bitsets with Bulk Popcount, Rank and Select
+ *
+ * The tricks in loopholes/03_bitwise_tricks.c work on one int at a time:
+ * count_set_bits() clears one bit per loop iteration. This module applies
+ * the same ideas to whole arrays of 64-bit words:
+ *
+ * - Bitset: any number of bits, set/clear/test inline, AND/OR/XOR/ANDNOT
+ *   into a destination, counts of an intersection without building it
+ * - popcountWords(): Harley-Seal carry-save adders (portable), hardware
+ *   POPCNT, AVX2 vpshufb nibble lookup, AVX-512 VPOPCNTDQ, picked at
+ *   startup through ../dispatch/cpu_dispatch.h
+ * - rank(i) = set bits before i and select(k) = position of the k-th set
+ *   bit, in O(1) and O(log n) with a small index (one counter per 512 bits)
+ * - iteration over set bits with tzcnt: the cost depends on the number of
+ *   set bits, not on the size of the bitset
+ * - array versions of the branchless min/max/abs tricks
+ *
+ * Bits past `bits` in the last word are always kept at 0, so counts never
+ * see garbage. Index arguments are not bounds-checked, like array indexing.
+ *
+ * Compile together with bitset.c and the CPU dispatch layer:
+ *   gcc -O2 -o program program.c bitset.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BITSET_NONE SIZE_MAX   // returned by bitsetNext/bitsetSelect when there is no bit
+
+typedef struct {
+    uint64_t* words;
+    size_t bits;
+    size_t wordCount;
+    uint64_t* rankIndex;   // set bits before each 512-bit block, built on demand
+} Bitset;
+
+// ========== Creation ==========
+
+bool bitsetInit(Bitset* bitset, size_t bits);
+void bitsetDestroy(Bitset* bitset);
+bool bitsetResize(Bitset* bitset, size_t bits);   // new bits are 0
+void bitsetClearAll(Bitset* bitset);
+void bitsetSetAll(Bitset* bitset);
+
+// ========== Single Bits ==========
+
+static inline void bitsetSet(Bitset* bitset, size_t index) {
+    bitset->words[index >> 6] |= 1ULL << (index & 63);
+}
+
+static inline void bitsetClear(Bitset* bitset, size_t index) {
+    bitset->words[index >> 6] &= ~(1ULL << (index & 63));
+}
+
+static inline bool bitsetTest(const Bitset* bitset, size_t index) {
+    return (bitset->words[index >> 6] >> (index & 63)) & 1;
+}
+
+// Set the bit and report whether it was already set (a visited-set check)
+static inline bool bitsetTestAndSet(Bitset* bitset, size_t index) {
+    uint64_t mask = 1ULL << (index & 63);
+    uint64_t old = bitset->words[index >> 6];
+    bitset->words[index >> 6] = old | mask;
+    return (old & mask) != 0;
+}
+
+// ========== Set Operations ==========
+
+// dest = a op b. All three must have the same size; dest may be a or b.
+bool bitsetAnd(Bitset* dest, const Bitset* a, const Bitset* b);
+bool bitsetOr(Bitset* dest, const Bitset* a, const Bitset* b);
+bool bitsetXor(Bitset* dest, const Bitset* a, const Bitset* b);
+bool bitsetAndNot(Bitset* dest, const Bitset* a, const Bitset* b);   // a & ~b
+
+size_t bitsetCount(const Bitset* bitset);
+size_t bitsetAndCount(const Bitset* a, const Bitset* b);   // |a & b| without building it
+bool bitsetEqual(const Bitset* a, const Bitset* b);
+
+// ========== Rank / Select ==========
+
+// Build (or rebuild) the index; call again after changing the bitset
+bool bitsetBuildRank(Bitset* bitset);
+size_t bitsetRank(const Bitset* bitset, size_t index);   // set bits in [0, index)
+size_t bitsetSelect(const Bitset* bitset, size_t k);     // position of set bit k (0-based)
+
+// ========== Iteration ==========
+
+// Visitor callback: return 0 to continue, non-zero to stop
+typedef int (*BitVisitor)(size_t index, void* context);
+
+size_t bitsetNext(const Bitset* bitset, size_t from);   // first set bit >= from
+void bitsetForEach(const Bitset* bitset, BitVisitor visit, void* context);
+size_t bitsetToIndices(const Bitset* bitset, uint32_t* out);   // returns the count
+
+// ========== Bulk Kernels ==========
+
+// Set bits in n words, through the fastest variant for this CPU
+typedef size_t (*PopcountFunction)(const uint64_t* words, size_t n);
+extern PopcountFunction popcountWords;
+
+// Portable variants, also useful as references
+size_t popcountKernighan(const uint64_t* words, size_t n);
+size_t popcountHarleySeal(const uint64_t* words, size_t n);
+
+// Branchless array versions of min_no_branch/max_no_branch/abs_no_branch
+typedef void (*MinMaxFunction)(const int* arr, size_t n, int* min, int* max);   // n > 0
+typedef void (*AbsFunction)(const int* in, int* out, size_t n);                 // out may be in
+extern MinMaxFunction arrayMinMax;
+extern AbsFunction arrayAbs;
+
+#endif
@@ -0,0 +1,441 @@
+/*
+ * Bitset Demo: Set Operations, Rank/Select, Iteration and Bulk Popcount
+ *
+ * Shows the Bitset API on small examples, checks rank/select and iteration
+ * against a bit-by-bit loop, then benchmarks:
+ *
+ * 1. popcount over arrays: count_set_bits()-style Kernighan loop, portable
+ *    Harley-Seal, hardware POPCNT, AVX2 Harley-Seal and AVX-512 VPOPCNTDQ,
+ *    at an L1-sized, an L2-sized and a large (memory-bound) array
+ * 2. visiting set bits with tzcnt vs testing every bit, at several densities
+ * 3. rank/select with the 512-bit block index vs counting from the start
+ * 4. arrayMinMax/arrayAbs vs calling min_no_branch()/abs_no_branch() per element
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o bitset_demo bitset_demo.c bitset.c ../dispatch/cpu_dispatch.c
+ *   ./bitset_demo [bits] [repeats]
+ *   CPU_DISPATCH=scalar ./bitset_demo      (portable kernels only)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bitset.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Tricks from loopholes/03_bitwise_tricks.c, called once per element
+__attribute__((noinline)) static int min_no_branch(int x, int y) {
+    return y ^ ((x ^ y) & -(x < y));
+}
+
+__attribute__((noinline)) static int max_no_branch(int x, int y) {
+    return x ^ ((x ^ y) & -(x < y));
+}
+
+__attribute__((noinline)) static int abs_no_branch(int x) {
+    int mask = x >> 31;
+    return (int)(((unsigned)x + (unsigned)mask) ^ (unsigned)mask);
+}
+
+static void printBits(const char* label, const Bitset* bitset) {
+    printf("%-10s ", label);
+    for (size_t i = 0; i < bitset->bits; i++) {
+        putchar(bitsetTest(bitset, i) ? '1' : '.');
+    }
+    printf("  (%zu set)\n", bitsetCount(bitset));
+}
+
+static int sumVisitor(size_t index, void* context) {
+    *(uint64_t*)context += index;
+    return 0;
+}
+
+static int stopAfterFive(size_t index, void* context) {
+    size_t* seen = (size_t*)context;
+    printf(" %zu", index);
+    return ++*seen == 5;
+}
+
+// Fill with set bits at the given density (percent)
+static void fillRandom(Bitset* bitset, unsigned percent, unsigned* seed) {
+    bitsetClearAll(bitset);
+    for (size_t i = 0; i < bitset->bits; i++) {
+        if (nextRandom(seed) % 100 < percent) {
+            bitsetSet(bitset, i);
+        }
+    }
+}
+
+// ========== Demonstrations ==========
+
+static void demoBasics(void) {
+    printf("=== Bitset Basics ===\n");
+    Bitset twos, threes, result;
+    if (!bitsetInit(&twos, 40) || !bitsetInit(&threes, 40) || !bitsetInit(&result, 40)) {
+        return;
+    }
+    for (size_t i = 0; i < 40; i += 2) bitsetSet(&twos, i);
+    for (size_t i = 0; i < 40; i += 3) bitsetSet(&threes, i);
+    printBits("x % 2 == 0", &twos);
+    printBits("x % 3 == 0", &threes);
+    bitsetAnd(&result, &twos, &threes);
+    printBits("AND", &result);
+    bitsetOr(&result, &twos, &threes);
+    printBits("OR", &result);
+    bitsetXor(&result, &twos, &threes);
+    printBits("XOR", &result);
+    bitsetAndNot(&result, &twos, &threes);
+    printBits("ANDNOT", &result);
+    printf("AND count without a result bitset: %zu\n", bitsetAndCount(&twos, &threes));
+
+    printf("Already set? 4: %s, 7: %s (then 7 is set)\n",
+           bitsetTestAndSet(&result, 4) ? "yes" : "no", bitsetTestAndSet(&result, 7) ? "yes" : "no");
+
+    bitsetResize(&twos, 70);
+    bitsetSetAll(&threes);
+    printf("After resize to 70 bits: %zu set; setAll on 40 bits: %zu set\n",
+           bitsetCount(&twos), bitsetCount(&threes));
+
+    printf("Set bits of x %% 3 == 0 (stop after five):");
+    size_t seen = 0;
+    bitsetClearAll(&threes);
+    for (size_t i = 0; i < 40; i += 3) bitsetSet(&threes, i);
+    bitsetForEach(&threes, stopAfterFive, &seen);
+    printf("\n");
+
+    bitsetBuildRank(&threes);
+    printf("rank(10) = %zu (0, 3, 6, 9 are below 10), select(4) = %zu, next(19) = %zu\n",
+           bitsetRank(&threes, 10), bitsetSelect(&threes, 4), bitsetNext(&threes, 19));
+
+    bitsetDestroy(&twos);
+    bitsetDestroy(&threes);
+    bitsetDestroy(&result);
+}
+
+// Compare rank, select and iteration with a bit-by-bit walk
+static bool checkAgainstNaive(const Bitset* bitset, uint32_t* indices) {
+    size_t count = bitsetToIndices(bitset, indices);
+    size_t rank = 0;
+    size_t next = 0;
+    for (size_t i = 0; i <= bitset->bits; i++) {
+        if (bitsetRank(bitset, i) != rank) {
+            printf("rank(%zu) = %zu, expected %zu\n", i, bitsetRank(bitset, i), rank);
+            return false;
+        }
+        if (i == bitset->bits) {
+            break;
+        }
+        if (bitsetTest(bitset, i)) {
+            if (bitsetSelect(bitset, rank) != i || indices[next] != i) {
+                printf("select(%zu) = %zu, expected %zu\n", rank, bitsetSelect(bitset, rank), i);
+                return false;
+            }
+            rank++;
+            next++;
+        }
+    }
+    return count == rank && bitsetSelect(bitset, rank) == BITSET_NONE &&
+           bitsetCount(bitset) == rank;
+}
+
+static bool demoChecks(unsigned* seed) {
+    printf("\n=== Checks Against a Bit-by-Bit Loop ===\n");
+    // Sizes around word and block boundaries
+    const size_t sizes[] = { 1, 63, 64, 65, 511, 512, 513, 4099, 100000 };
+    const unsigned densities[] = { 0, 1, 50, 100 };
+    bool ok = true;
+    uint32_t* indices = malloc(100000 * sizeof(uint32_t));
+    if (indices == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++) {
+            Bitset bitset;
+            if (!bitsetInit(&bitset, sizes[s])) {
+                free(indices);
+                return false;
+            }
+            fillRandom(&bitset, densities[d], seed);
+            ok = ok && checkAgainstNaive(&bitset, indices);   // linear scans
+            bitsetBuildRank(&bitset);
+            ok = ok && checkAgainstNaive(&bitset, indices);   // indexed
+            bitsetDestroy(&bitset);
+        }
+    }
+
+    // Every popcount variant the CPU can run must agree, at every tail length
+    const DispatchKernel* kernel = dispatchFind("popcountWords");
+    uint64_t words[200];
+    for (size_t i = 0; i < 200; i++) {
+        words[i] = ((uint64_t)nextRandom(seed) << 32) | nextRandom(seed);
+    }
+    for (size_t n = 0; n <= 200; n++) {
+        size_t expected = popcountKernighan(words, n);
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (cpuHas(kernel->variants[v].required) &&
+                ((PopcountFunction)kernel->variants[v].function)(words, n) != expected) {
+                printf("%s wrong for %zu words\n", kernel->variants[v].name, n);
+                ok = false;
+            }
+        }
+    }
+    printf("rank/select/iteration/popcount: %s\n", ok ? "all match" : "MISMATCH");
+    free(indices);
+    return ok;
+}
+
+// ========== Benchmarks ==========
+
+static void benchPopcount(const uint64_t* words, size_t maxWords, int repeats) {
+    const DispatchKernel* kernel = dispatchFind("popcountWords");
+    const size_t sizes[] = { 512, 32768, maxWords };   // 4 KB, 256 KB, large
+    printf("\n=== Popcount Over Arrays (GB/s) ===\n");
+    printf("%-20s %10s %10s %10s\n", "Variant", "4 KB", "256 KB", "large");
+
+    for (int v = kernel->variantCount; v >= 0; v--) {
+        // v == variantCount is the Kernighan loop, then portable to best
+        PopcountFunction function = v == kernel->variantCount ? popcountKernighan
+                                  : (PopcountFunction)kernel->variants[v].function;
+        const char* name = v == kernel->variantCount ? "popcountKernighan" : kernel->variants[v].name;
+        if (v < kernel->variantCount && !cpuHas(kernel->variants[v].required)) {
+            printf("%-20s %10s\n", name, "skipped");
+            continue;
+        }
+        printf("%-20s", name);
+        for (int s = 0; s < 3; s++) {
+            size_t n = sizes[s] < maxWords ? sizes[s] : maxWords;
+            // Same total bytes per size, so small arrays are repeated more
+            int rounds = (int)((size_t)repeats * maxWords / n);
+            if (v == kernel->variantCount) {
+                rounds = rounds / 8 + 1;   // the slow one
+            }
+            volatile size_t sink = 0;
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int r = 0; r < rounds; r++) {
+                sink += function(words, n);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            (void)sink;
+            double bytes = (double)rounds * (double)n * sizeof(uint64_t);
+            printf(" %10.2f", bytes / elapsedSeconds(start, end) / 1e9);
+        }
+        printf("%s\n", v < kernel->variantCount && &kernel->variants[v] == kernel->chosen ? "  <- chosen" : "");
+    }
+}
+
+static void benchIteration(size_t bits, int repeats, unsigned* seed) {
+    printf("\n=== Visiting Set Bits (%zu bits) ===\n", bits);
+    printf("%-8s %12s %14s %14s %8s\n", "density", "set bits", "test each ms", "tzcnt loop ms", "speedup");
+    const unsigned densities[] = { 1, 10, 50 };
+    Bitset bitset;
+    if (!bitsetInit(&bitset, bits)) {
+        return;
+    }
+    for (int d = 0; d < 3; d++) {
+        fillRandom(&bitset, densities[d], seed);
+        uint64_t naiveSum = 0, fastSum = 0;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < repeats; r++) {
+            for (size_t i = 0; i < bits; i++) {
+                if (bitsetTest(&bitset, i)) {
+                    naiveSum += i;
+                }
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double naive = elapsedSeconds(start, end) / repeats;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < repeats; r++) {
+            bitsetForEach(&bitset, sumVisitor, &fastSum);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double fast = elapsedSeconds(start, end) / repeats;
+
+        printf("%6u%% %12zu %14.3f %14.3f %7.1fx%s\n", densities[d], bitsetCount(&bitset),
+               naive * 1e3, fast * 1e3, naive / fast, naiveSum == fastSum ? "" : "  MISMATCH");
+    }
+    bitsetDestroy(&bitset);
+}
+
+static void benchRankSelect(size_t bits, unsigned* seed) {
+    printf("\n=== Rank / Select (%zu bits, 10%% set) ===\n", bits);
+    Bitset bitset;
+    if (!bitsetInit(&bitset, bits)) {
+        return;
+    }
+    fillRandom(&bitset, 10, seed);
+    size_t total = bitsetCount(&bitset);
+    const int queries = 100000;
+    size_t* positions = malloc((size_t)queries * sizeof(size_t));
+    if (positions == NULL) {
+        printf("Memory allocation failed\n");
+        bitsetDestroy(&bitset);
+        return;
+    }
+    for (int q = 0; q < queries; q++) {
+        positions[q] = (size_t)(((uint64_t)nextRandom(seed) << 32 | nextRandom(seed)) % bits);
+    }
+
+    struct timespec start, end;
+    volatile size_t sink = 0;
+    // Without the index both walk the words from the start; time fewer queries
+    int slowQueries = queries / 100;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int q = 0; q < slowQueries; q++) {
+        sink += bitsetRank(&bitset, positions[q]);
+        sink += bitsetSelect(&bitset, positions[q] % total);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double slow = elapsedSeconds(start, end) / slowQueries;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bitsetBuildRank(&bitset);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double build = elapsedSeconds(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int q = 0; q < queries; q++) {
+        sink += bitsetRank(&bitset, positions[q]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double rank = elapsedSeconds(start, end) / queries;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int q = 0; q < queries; q++) {
+        sink += bitsetSelect(&bitset, positions[q] % total);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double select = elapsedSeconds(start, end) / queries;
+    (void)sink;
+
+    printf("Without index: rank + select %.1f us per pair\n", slow * 1e6);
+    printf("Index: %zu bytes (%.1f%% of the bits), built in %.2f ms\n",
+           ((bitset.wordCount + 7) / 8 + 1) * sizeof(uint64_t),
+           100.0 * (double)(((bitset.wordCount + 7) / 8 + 1) * 64) / (double)bits, build * 1e3);
+    printf("With index:    rank %.1f ns, select %.1f ns (select-in-word: %s)\n",
+           rank * 1e9, select * 1e9, dispatchFind("bitsetSelectInWord")->chosen->name);
+    free(positions);
+    bitsetDestroy(&bitset);
+}
+
+static void benchArrays(size_t n, int repeats, unsigned* seed) {
+    printf("\n=== Branchless Min/Max/Abs Over %zu ints (ns per element) ===\n", n);
+    int* values = malloc(n * sizeof(int));
+    int* out = malloc(n * sizeof(int));
+    if (values == NULL || out == NULL) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(out);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        values[i] = (int)nextRandom(seed);
+    }
+
+    struct timespec start, end;
+    int low = 0, high = 0;
+    uint64_t absSum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        low = high = values[0];
+        for (size_t i = 1; i < n; i++) {
+            low = min_no_branch(values[i], low);
+            high = max_no_branch(values[i], high);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double perCallMinMax = elapsedSeconds(start, end) / repeats;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = abs_no_branch(values[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double perCallAbs = elapsedSeconds(start, end) / repeats;
+    for (size_t i = 0; i < n; i++) {
+        absSum += (unsigned)out[i];
+    }
+
+    int arrayLow, arrayHigh;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        arrayMinMax(values, n, &arrayLow, &arrayHigh);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double arrayMinMaxTime = elapsedSeconds(start, end) / repeats;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        arrayAbs(values, out, n);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double arrayAbsTime = elapsedSeconds(start, end) / repeats;
+    uint64_t arrayAbsSum = 0;
+    for (size_t i = 0; i < n; i++) {
+        arrayAbsSum += (unsigned)out[i];
+    }
+
+    printf("%-28s %10s %10s\n", "", "min/max", "abs");
+    printf("%-28s %10.3f %10.3f\n", "per-element calls", perCallMinMax * 1e9 / (double)n,
+           perCallAbs * 1e9 / (double)n);
+    printf("%-28s %10.3f %10.3f\n", "arrayMinMax / arrayAbs", arrayMinMaxTime * 1e9 / (double)n,
+           arrayAbsTime * 1e9 / (double)n);
+    printf("Variants: %s, %s; results %s\n", dispatchFind("arrayMinMax")->chosen->name,
+           dispatchFind("arrayAbs")->chosen->name,
+           low == arrayLow && high == arrayHigh && absSum == arrayAbsSum ? "match" : "MISMATCH");
+    free(values);
+    free(out);
+}
+
+int main(int argc, char* argv[]) {
+    size_t bits = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : (size_t)1 << 24;
+    int repeats = argc > 2 ? atoi(argv[2]) : 10;
+    if (bits < 64 || repeats < 1) {
+        printf("Usage: %s [bits >= 64] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    dispatchPrint(stdout);
+    printf("\n");
+    demoBasics();
+
+    unsigned seed = 2463534242u;
+    bool ok = demoChecks(&seed);
+
+    Bitset large;
+    if (!bitsetInit(&large, bits)) {
+        return 1;
+    }
+    for (size_t i = 0; i < large.wordCount; i++) {
+        large.words[i] = ((uint64_t)nextRandom(&seed) << 32) | nextRandom(&seed);
+    }
+    benchPopcount(large.words, large.wordCount, repeats);
+    bitsetDestroy(&large);
+
+    benchIteration(bits, repeats, &seed);
+    benchRankSelect(bits, &seed);
+    benchArrays(bits / 16, repeats, &seed);
+    return ok ? 0 : 1;
+}
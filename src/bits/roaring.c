@@ -0,0 +1,1255 @@
+/*
+ * roaring.c - Compressed Bitmaps for Sparse Sets of 32-bit IDs (see roaring.h)
+ */
+
+#include "roaring.h"
+#include "bitset.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ROARING_MAGIC 0x314d4252u   // "RBM1" in a little-endian file
+#define CHUNK_BITS 65536u
+
+typedef enum {
+    OP_AND,
+    OP_OR,
+    OP_ANDNOT
+} SetOp;
+
+// ========== Container Storage ==========
+
+static size_t elementSize(int type) {
+    return type == CONTAINER_ARRAY ? sizeof(uint16_t)
+         : type == CONTAINER_BITMAP ? sizeof(uint64_t) : sizeof(RoaringRun);
+}
+
+// Bytes of data in use, which is also the serialized size
+static size_t usedBytes(const RoaringContainer* c) {
+    return c->type == CONTAINER_BITMAP ? ROARING_BITMAP_WORDS * sizeof(uint64_t)
+                                       : (size_t)c->count * elementSize(c->type);
+}
+
+static bool containerCreate(RoaringContainer* c, ContainerType type, int32_t capacity) {
+    if (type == CONTAINER_BITMAP) {
+        capacity = ROARING_BITMAP_WORDS;
+    } else if (capacity < 1) {
+        capacity = 1;
+    }
+    void* data = type == CONTAINER_BITMAP ? calloc(ROARING_BITMAP_WORDS, sizeof(uint64_t))
+                                          : malloc((size_t)capacity * elementSize(type));
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    c->type = (uint8_t)type;
+    c->owned = true;
+    c->cardinality = 0;
+    c->count = 0;
+    c->capacity = capacity;
+    c->values = data;
+    return true;
+}
+
+static void containerFree(RoaringContainer* c) {
+    if (c->owned) {
+        free(c->values);
+    }
+    c->values = NULL;
+}
+
+// Make room for `needed` elements. A container that still points into a
+// mapped file gets its own copy here, before the first write.
+static bool containerReserve(RoaringContainer* c, int32_t needed) {
+    if (c->owned && c->capacity >= needed) {
+        return true;
+    }
+    int32_t capacity = c->capacity;
+    if (capacity < needed) {
+        capacity = capacity * 2 > needed ? capacity * 2 : needed;
+        if (c->type == CONTAINER_ARRAY && capacity > ROARING_ARRAY_MAX && needed <= ROARING_ARRAY_MAX) {
+            capacity = ROARING_ARRAY_MAX;
+        }
+    }
+    size_t bytes = (size_t)capacity * elementSize(c->type);
+    void* data;
+    if (c->owned) {
+        data = realloc(c->values, bytes);
+    } else {
+        data = malloc(bytes);
+        if (data != NULL) {
+            memcpy(data, c->values, usedBytes(c));
+        }
+    }
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    c->values = data;
+    c->capacity = capacity;
+    c->owned = true;
+    return true;
+}
+
+static bool containerMakeOwned(RoaringContainer* c) {
+    return containerReserve(c, c->type == CONTAINER_BITMAP ? ROARING_BITMAP_WORDS : c->count);
+}
+
+static bool containerClone(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, (ContainerType)in->type, in->count)) {
+        return false;
+    }
+    memcpy(out->values, in->values, usedBytes(in));
+    out->cardinality = in->cardinality;
+    out->count = in->count;
+    return true;
+}
+
+// ========== Searching ==========
+
+// First index with values[index] >= key
+static int32_t lowerBound16(const uint16_t* values, int32_t count, uint16_t key) {
+    int32_t low = 0;
+    int32_t high = count;
+    while (low < high) {
+        int32_t mid = (low + high) >> 1;
+        if (values[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Same as lowerBound16 from `position` on, but probes 1, 2, 4, 8... ahead
+// first: cheap when the answer is close, which it is when a small array is
+// intersected with a much larger one
+static int32_t gallop(const uint16_t* values, int32_t count, int32_t position, uint16_t key) {
+    if (position >= count || values[position] >= key) {
+        return position;
+    }
+    int32_t step = 1;
+    int32_t low = position;   // values[low] < key
+    int32_t high = position + 1;
+    while (high < count && values[high] < key) {
+        low = high;
+        step <<= 1;
+        high = position + step;
+    }
+    if (high > count) {
+        high = count;
+    }
+    return low + 1 + lowerBound16(values + low + 1, high - low - 1, key);
+}
+
+// Index of the last run starting at or before value, or -1
+static int32_t findRun(const RoaringRun* runs, int32_t count, uint16_t value) {
+    int32_t low = 0;
+    int32_t high = count;
+    while (low < high) {
+        int32_t mid = (low + high) >> 1;
+        if (runs[mid].start <= value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low - 1;
+}
+
+static uint32_t runEnd(RoaringRun run) {
+    return (uint32_t)run.start + run.length;
+}
+
+static bool isFull(const RoaringContainer* c) {
+    return c->cardinality == (int32_t)CHUNK_BITS;
+}
+
+// ========== Bitmap Helpers ==========
+
+static void setBitRange(uint64_t* words, uint32_t first, uint32_t last) {   // inclusive
+    uint32_t firstWord = first >> 6;
+    uint32_t lastWord = last >> 6;
+    uint64_t firstMask = ~0ULL << (first & 63);
+    uint64_t lastMask = ~0ULL >> (63 - (last & 63));
+    if (firstWord == lastWord) {
+        words[firstWord] |= firstMask & lastMask;
+        return;
+    }
+    words[firstWord] |= firstMask;
+    for (uint32_t w = firstWord + 1; w < lastWord; w++) {
+        words[w] = ~0ULL;
+    }
+    words[lastWord] |= lastMask;
+}
+
+// First set (or clear, with invert = ~0) bit at or after `from`, or 65536
+static uint32_t nextBit(const uint64_t* words, uint32_t from, uint64_t invert) {
+    if (from >= CHUNK_BITS) {
+        return CHUNK_BITS;
+    }
+    uint32_t w = from >> 6;
+    uint64_t bits = (words[w] ^ invert) & (~0ULL << (from & 63));
+    while (bits == 0) {
+        if (++w == ROARING_BITMAP_WORDS) {
+            return CHUNK_BITS;
+        }
+        bits = words[w] ^ invert;
+    }
+    return w * 64 + (uint32_t)__builtin_ctzll(bits);
+}
+
+// ========== Conversions ==========
+
+static bool arrayToBitmap(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_BITMAP, 0)) {
+        return false;
+    }
+    for (int32_t i = 0; i < in->count; i++) {
+        out->words[in->values[i] >> 6] |= 1ULL << (in->values[i] & 63);
+    }
+    out->cardinality = in->cardinality;
+    return true;
+}
+
+static bool bitmapToArray(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_ARRAY, in->cardinality)) {
+        return false;
+    }
+    int32_t n = 0;
+    for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        uint64_t bits = in->words[w];
+        while (bits != 0) {
+            out->values[n++] = (uint16_t)(w * 64 + (uint32_t)__builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+static bool runToBitmap(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_BITMAP, 0)) {
+        return false;
+    }
+    for (int32_t i = 0; i < in->count; i++) {
+        setBitRange(out->words, in->runs[i].start, runEnd(in->runs[i]));
+    }
+    out->cardinality = in->cardinality;
+    return true;
+}
+
+static bool runToArray(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_ARRAY, in->cardinality)) {
+        return false;
+    }
+    int32_t n = 0;
+    for (int32_t i = 0; i < in->count; i++) {
+        for (uint32_t v = in->runs[i].start; v <= runEnd(in->runs[i]); v++) {
+            out->values[n++] = (uint16_t)v;
+        }
+    }
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+static int32_t countRuns(const RoaringContainer* c) {
+    if (c->type == CONTAINER_RUN) {
+        return c->count;
+    }
+    int32_t runs = 0;
+    if (c->type == CONTAINER_ARRAY) {
+        for (int32_t i = 0; i < c->count; i++) {
+            runs += i == 0 || c->values[i] != c->values[i - 1] + 1;
+        }
+        return runs;
+    }
+    // A run starts at every set bit whose lower neighbour is clear
+    uint64_t carry = 0;
+    for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) {
+        uint64_t word = c->words[w];
+        runs += __builtin_popcountll(word & ~((word << 1) | carry));
+        carry = word >> 63;
+    }
+    return runs;
+}
+
+static bool toRuns(const RoaringContainer* in, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_RUN, countRuns(in))) {
+        return false;
+    }
+    int32_t n = 0;
+    if (in->type == CONTAINER_ARRAY) {
+        for (int32_t i = 0; i < in->count; i++) {
+            if (n > 0 && runEnd(out->runs[n - 1]) + 1 == in->values[i]) {
+                out->runs[n - 1].length++;
+            } else {
+                out->runs[n++] = (RoaringRun){ in->values[i], 0 };
+            }
+        }
+    } else if (in->type == CONTAINER_BITMAP) {
+        uint32_t start = nextBit(in->words, 0, 0);
+        while (start < CHUNK_BITS) {
+            uint32_t end = nextBit(in->words, start, ~0ULL);   // first clear bit
+            out->runs[n++] = (RoaringRun){ (uint16_t)start, (uint16_t)(end - start - 1) };
+            start = nextBit(in->words, end, 0);
+        }
+    } else {
+        memcpy(out->runs, in->runs, usedBytes(in));
+        n = in->count;
+    }
+    out->count = n;
+    out->cardinality = in->cardinality;
+    return true;
+}
+
+// Convert in place; the old data is freed
+static bool containerConvert(RoaringContainer* c, ContainerType type) {
+    if (c->type == type) {
+        return true;
+    }
+    RoaringContainer out;
+    bool ok;
+    if (type == CONTAINER_RUN) {
+        ok = toRuns(c, &out);
+    } else if (type == CONTAINER_BITMAP) {
+        ok = c->type == CONTAINER_ARRAY ? arrayToBitmap(c, &out) : runToBitmap(c, &out);
+    } else {
+        ok = c->type == CONTAINER_BITMAP ? bitmapToArray(c, &out) : runToArray(c, &out);
+    }
+    if (!ok) {
+        return false;
+    }
+    containerFree(c);
+    *c = out;
+    return true;
+}
+
+// Array or bitmap by cardinality; runs only if they are smaller
+static ContainerType bestType(const RoaringContainer* c, bool allowRuns) {
+    ContainerType plain = c->cardinality <= ROARING_ARRAY_MAX ? CONTAINER_ARRAY : CONTAINER_BITMAP;
+    if (!allowRuns) {
+        return plain;
+    }
+    size_t plainBytes = plain == CONTAINER_ARRAY ? (size_t)c->cardinality * sizeof(uint16_t)
+                                                 : ROARING_BITMAP_WORDS * sizeof(uint64_t);
+    return (size_t)countRuns(c) * sizeof(RoaringRun) < plainBytes ? CONTAINER_RUN : plain;
+}
+
+// Restore the array/bitmap threshold after an operation; run containers
+// stay runs unless they have become larger than the plain layout
+static bool containerNormalize(RoaringContainer* c) {
+    return containerConvert(c, bestType(c, c->type == CONTAINER_RUN));
+}
+
+// Runs are expanded before combining with other layouts
+static bool runMaterialize(const RoaringContainer* in, RoaringContainer* out) {
+    return in->cardinality <= ROARING_ARRAY_MAX ? runToArray(in, out) : runToBitmap(in, out);
+}
+
+// ========== Single Values ==========
+
+static bool containerContains(const RoaringContainer* c, uint16_t value) {
+    if (c->type == CONTAINER_ARRAY) {
+        int32_t i = lowerBound16(c->values, c->count, value);
+        return i < c->count && c->values[i] == value;
+    }
+    if (c->type == CONTAINER_BITMAP) {
+        return (c->words[value >> 6] >> (value & 63)) & 1;
+    }
+    int32_t i = findRun(c->runs, c->count, value);
+    return i >= 0 && value <= runEnd(c->runs[i]);
+}
+
+static bool containerAdd(RoaringContainer* c, uint16_t value) {
+    if (containerContains(c, value)) {
+        return false;
+    }
+    if (c->type == CONTAINER_ARRAY && c->count == ROARING_ARRAY_MAX &&
+        !containerConvert(c, CONTAINER_BITMAP)) {
+        return false;
+    }
+    if (!containerMakeOwned(c)) {
+        return false;
+    }
+
+    if (c->type == CONTAINER_BITMAP) {
+        c->words[value >> 6] |= 1ULL << (value & 63);
+    } else if (c->type == CONTAINER_ARRAY) {
+        if (!containerReserve(c, c->count + 1)) {
+            return false;
+        }
+        int32_t i = lowerBound16(c->values, c->count, value);
+        memmove(c->values + i + 1, c->values + i, (size_t)(c->count - i) * sizeof(uint16_t));
+        c->values[i] = value;
+        c->count++;
+    } else {
+        int32_t i = findRun(c->runs, c->count, value);
+        bool extendsPrevious = i >= 0 && runEnd(c->runs[i]) + 1 == value;
+        bool extendsNext = i + 1 < c->count && c->runs[i + 1].start == (uint32_t)value + 1;
+        if (extendsPrevious && extendsNext) {
+            // value fills the gap between two runs
+            c->runs[i].length = (uint16_t)(runEnd(c->runs[i + 1]) - c->runs[i].start);
+            memmove(c->runs + i + 1, c->runs + i + 2, (size_t)(c->count - i - 2) * sizeof(RoaringRun));
+            c->count--;
+        } else if (extendsPrevious) {
+            c->runs[i].length++;
+        } else if (extendsNext) {
+            c->runs[i + 1].start--;
+            c->runs[i + 1].length++;
+        } else {
+            if (!containerReserve(c, c->count + 1)) {
+                return false;
+            }
+            memmove(c->runs + i + 2, c->runs + i + 1, (size_t)(c->count - i - 1) * sizeof(RoaringRun));
+            c->runs[i + 1] = (RoaringRun){ value, 0 };
+            c->count++;
+        }
+    }
+    c->cardinality++;
+    return true;
+}
+
+static bool containerRemove(RoaringContainer* c, uint16_t value) {
+    if (!containerContains(c, value) || !containerMakeOwned(c)) {
+        return false;
+    }
+
+    if (c->type == CONTAINER_BITMAP) {
+        c->words[value >> 6] &= ~(1ULL << (value & 63));
+        c->cardinality--;
+        return c->cardinality > ROARING_ARRAY_MAX || containerConvert(c, CONTAINER_ARRAY);
+    }
+    if (c->type == CONTAINER_ARRAY) {
+        int32_t i = lowerBound16(c->values, c->count, value);
+        memmove(c->values + i, c->values + i + 1, (size_t)(c->count - i - 1) * sizeof(uint16_t));
+        c->count--;
+    } else {
+        int32_t i = findRun(c->runs, c->count, value);
+        RoaringRun run = c->runs[i];
+        if (run.length == 0) {
+            memmove(c->runs + i, c->runs + i + 1, (size_t)(c->count - i - 1) * sizeof(RoaringRun));
+            c->count--;
+        } else if (value == run.start) {
+            c->runs[i].start++;
+            c->runs[i].length--;
+        } else if (value == runEnd(run)) {
+            c->runs[i].length--;
+        } else {
+            // Split the run around value
+            if (!containerReserve(c, c->count + 1)) {
+                return false;
+            }
+            memmove(c->runs + i + 2, c->runs + i + 1, (size_t)(c->count - i - 1) * sizeof(RoaringRun));
+            c->runs[i].length = (uint16_t)(value - run.start - 1);
+            c->runs[i + 1] = (RoaringRun){ (uint16_t)(value + 1), (uint16_t)(runEnd(run) - value - 1) };
+            c->count++;
+        }
+    }
+    c->cardinality--;
+    return true;
+}
+
+// ========== Container Operations ==========
+
+static bool arrayAndArray(const RoaringContainer* a, const RoaringContainer* b, RoaringContainer* out) {
+    if (a->count > b->count) {
+        const RoaringContainer* swap = a;
+        a = b;
+        b = swap;
+    }
+    if (!containerCreate(out, CONTAINER_ARRAY, a->count)) {
+        return false;
+    }
+    int32_t n = 0;
+    if (a->count * 64 < b->count) {
+        // Very different sizes: look each small value up in the large array
+        int32_t j = 0;
+        for (int32_t i = 0; i < a->count; i++) {
+            j = gallop(b->values, b->count, j, a->values[i]);
+            if (j == b->count) {
+                break;
+            }
+            if (b->values[j] == a->values[i]) {
+                out->values[n++] = a->values[i];
+            }
+        }
+    } else {
+        // Branchless merge: on random data the three-way if mispredicts often
+        int32_t i = 0, j = 0;
+        while (i < a->count && j < b->count) {
+            uint16_t x = a->values[i];
+            uint16_t y = b->values[j];
+            out->values[n] = x;
+            n += x == y;
+            i += x <= y;
+            j += y <= x;
+        }
+    }
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+static bool arrayOrArray(const RoaringContainer* a, const RoaringContainer* b, RoaringContainer* out) {
+    if (a->count + b->count > ROARING_ARRAY_MAX) {
+        // The result may be too large for an array: set bits, then count
+        if (!containerCreate(out, CONTAINER_BITMAP, 0)) {
+            return false;
+        }
+        for (int32_t i = 0; i < a->count; i++) {
+            out->words[a->values[i] >> 6] |= 1ULL << (a->values[i] & 63);
+        }
+        for (int32_t i = 0; i < b->count; i++) {
+            out->words[b->values[i] >> 6] |= 1ULL << (b->values[i] & 63);
+        }
+        out->cardinality = (int32_t)popcountWords(out->words, ROARING_BITMAP_WORDS);
+        return containerNormalize(out);
+    }
+    if (!containerCreate(out, CONTAINER_ARRAY, a->count + b->count)) {
+        return false;
+    }
+    int32_t i = 0, j = 0, n = 0;
+    while (i < a->count && j < b->count) {
+        uint16_t x = a->values[i];
+        uint16_t y = b->values[j];
+        out->values[n++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    while (i < a->count) out->values[n++] = a->values[i++];
+    while (j < b->count) out->values[n++] = b->values[j++];
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+static bool arrayAndNotArray(const RoaringContainer* a, const RoaringContainer* b, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_ARRAY, a->count)) {
+        return false;
+    }
+    int32_t j = 0, n = 0;
+    for (int32_t i = 0; i < a->count; i++) {
+        j = gallop(b->values, b->count, j, a->values[i]);
+        if (j == b->count || b->values[j] != a->values[i]) {
+            out->values[n++] = a->values[i];
+        }
+    }
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+// Keep array values whose bit is (keep = 1) or is not (keep = 0) set
+static bool arrayFilterBitmap(const RoaringContainer* array, const RoaringContainer* bitmap,
+                              uint64_t keep, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_ARRAY, array->count)) {
+        return false;
+    }
+    int32_t n = 0;
+    for (int32_t i = 0; i < array->count; i++) {
+        uint16_t v = array->values[i];
+        out->values[n] = v;
+        n += ((bitmap->words[v >> 6] >> (v & 63)) & 1) == keep;   // branchless append
+    }
+    out->count = n;
+    out->cardinality = n;
+    return true;
+}
+
+static bool bitmapOrArray(const RoaringContainer* bitmap, const RoaringContainer* array, RoaringContainer* out) {
+    if (!containerClone(bitmap, out)) {
+        return false;
+    }
+    int32_t added = 0;
+    for (int32_t i = 0; i < array->count; i++) {
+        uint16_t v = array->values[i];
+        uint64_t old = out->words[v >> 6];
+        uint64_t updated = old | (1ULL << (v & 63));
+        out->words[v >> 6] = updated;
+        added += old != updated;
+    }
+    out->cardinality += added;
+    return true;
+}
+
+static bool bitmapAndNotArray(const RoaringContainer* bitmap, const RoaringContainer* array, RoaringContainer* out) {
+    if (!containerClone(bitmap, out)) {
+        return false;
+    }
+    int32_t removed = 0;
+    for (int32_t i = 0; i < array->count; i++) {
+        uint16_t v = array->values[i];
+        uint64_t old = out->words[v >> 6];
+        uint64_t updated = old & ~(1ULL << (v & 63));
+        out->words[v >> 6] = updated;
+        removed += old != updated;
+    }
+    out->cardinality -= removed;
+    return containerNormalize(out);
+}
+
+static bool bitmapOpBitmap(const RoaringContainer* a, const RoaringContainer* b, SetOp op, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_BITMAP, 0)) {
+        return false;
+    }
+    const uint64_t* x = a->words;
+    const uint64_t* y = b->words;
+    uint64_t* z = out->words;
+    switch (op) {
+        case OP_AND:
+            for (int i = 0; i < ROARING_BITMAP_WORDS; i++) z[i] = x[i] & y[i];
+            break;
+        case OP_OR:
+            for (int i = 0; i < ROARING_BITMAP_WORDS; i++) z[i] = x[i] | y[i];
+            break;
+        case OP_ANDNOT:
+            for (int i = 0; i < ROARING_BITMAP_WORDS; i++) z[i] = x[i] & ~y[i];
+            break;
+    }
+    out->cardinality = (int32_t)popcountWords(z, ROARING_BITMAP_WORDS);
+    return containerNormalize(out);
+}
+
+static bool runAndRun(const RoaringContainer* a, const RoaringContainer* b, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_RUN, a->count + b->count)) {
+        return false;
+    }
+    int32_t i = 0, j = 0, n = 0, cardinality = 0;
+    while (i < a->count && j < b->count) {
+        uint32_t start = a->runs[i].start > b->runs[j].start ? a->runs[i].start : b->runs[j].start;
+        uint32_t endA = runEnd(a->runs[i]);
+        uint32_t endB = runEnd(b->runs[j]);
+        uint32_t end = endA < endB ? endA : endB;
+        if (start <= end) {
+            out->runs[n++] = (RoaringRun){ (uint16_t)start, (uint16_t)(end - start) };
+            cardinality += (int32_t)(end - start + 1);
+        }
+        if (endA < endB) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+    out->count = n;
+    out->cardinality = cardinality;
+    return containerNormalize(out);
+}
+
+static bool runOrRun(const RoaringContainer* a, const RoaringContainer* b, RoaringContainer* out) {
+    if (!containerCreate(out, CONTAINER_RUN, a->count + b->count)) {
+        return false;
+    }
+    int32_t i = 0, j = 0, n = 0, cardinality = 0;
+    while (i < a->count || j < b->count) {
+        RoaringRun next;
+        if (j == b->count || (i < a->count && a->runs[i].start <= b->runs[j].start)) {
+            next = a->runs[i++];
+        } else {
+            next = b->runs[j++];
+        }
+        if (n > 0 && next.start <= runEnd(out->runs[n - 1]) + 1) {
+            // Overlaps or touches the previous run: extend it
+            uint32_t end = runEnd(next) > runEnd(out->runs[n - 1]) ? runEnd(next) : runEnd(out->runs[n - 1]);
+            out->runs[n - 1].length = (uint16_t)(end - out->runs[n - 1].start);
+        } else {
+            out->runs[n++] = next;
+        }
+    }
+    for (int32_t k = 0; k < n; k++) {
+        cardinality += out->runs[k].length + 1;
+    }
+    out->count = n;
+    out->cardinality = cardinality;
+    return containerNormalize(out);
+}
+
+static bool containerCombine(const RoaringContainer* a, const RoaringContainer* b, SetOp op, RoaringContainer* out) {
+    if (a->type == CONTAINER_RUN || b->type == CONTAINER_RUN) {
+        if (a->type == CONTAINER_RUN && b->type == CONTAINER_RUN && op != OP_ANDNOT) {
+            return op == OP_AND ? runAndRun(a, b, out) : runOrRun(a, b, out);
+        }
+        // Full chunks are common after roaringAddRange
+        if (op == OP_AND && (isFull(a) || isFull(b))) {
+            return containerClone(isFull(a) ? b : a, out);
+        }
+        if (op == OP_OR && (isFull(a) || isFull(b))) {
+            return containerClone(isFull(a) ? a : b, out);
+        }
+        if (op == OP_ANDNOT && isFull(b)) {
+            return containerCreate(out, CONTAINER_ARRAY, 0);
+        }
+        RoaringContainer tempA, tempB;
+        bool expandA = a->type == CONTAINER_RUN;
+        bool expandB = b->type == CONTAINER_RUN;
+        if (expandA && !runMaterialize(a, &tempA)) {
+            return false;
+        }
+        if (expandB && !runMaterialize(b, &tempB)) {
+            if (expandA) containerFree(&tempA);
+            return false;
+        }
+        bool ok = containerCombine(expandA ? &tempA : a, expandB ? &tempB : b, op, out);
+        if (expandA) containerFree(&tempA);
+        if (expandB) containerFree(&tempB);
+        return ok;
+    }
+
+    bool arrayA = a->type == CONTAINER_ARRAY;
+    bool arrayB = b->type == CONTAINER_ARRAY;
+    switch (op) {
+        case OP_AND:
+            if (arrayA && arrayB) return arrayAndArray(a, b, out);
+            if (arrayA) return arrayFilterBitmap(a, b, 1, out);
+            if (arrayB) return arrayFilterBitmap(b, a, 1, out);
+            return bitmapOpBitmap(a, b, op, out);
+        case OP_OR:
+            if (arrayA && arrayB) return arrayOrArray(a, b, out);
+            if (arrayA) return bitmapOrArray(b, a, out);
+            if (arrayB) return bitmapOrArray(a, b, out);
+            return bitmapOpBitmap(a, b, op, out);
+        case OP_ANDNOT:
+            if (arrayA && arrayB) return arrayAndNotArray(a, b, out);
+            if (arrayA) return arrayFilterBitmap(a, b, 0, out);
+            if (arrayB) return bitmapAndNotArray(a, b, out);
+            return bitmapOpBitmap(a, b, op, out);
+    }
+    return false;
+}
+
+// ========== Key Table ==========
+
+void roaringInit(Roaring* roaring) {
+    roaring->keys = NULL;
+    roaring->containers = NULL;
+    roaring->size = 0;
+    roaring->capacity = 0;
+    roaring->mapping = NULL;
+    roaring->mappingSize = 0;
+}
+
+void roaringDestroy(Roaring* roaring) {
+    for (size_t i = 0; i < roaring->size; i++) {
+        containerFree(&roaring->containers[i]);
+    }
+    free(roaring->keys);
+    free(roaring->containers);
+    if (roaring->mapping != NULL) {
+        munmap(roaring->mapping, roaring->mappingSize);
+    }
+    roaringInit(roaring);
+}
+
+static bool roaringReserve(Roaring* roaring, size_t needed) {
+    if (roaring->capacity >= needed) {
+        return true;
+    }
+    size_t capacity = roaring->capacity * 2 > needed ? roaring->capacity * 2 : needed;
+    uint16_t* keys = realloc(roaring->keys, capacity * sizeof(uint16_t));
+    if (keys == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    roaring->keys = keys;
+    RoaringContainer* containers = realloc(roaring->containers, capacity * sizeof(RoaringContainer));
+    if (containers == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    roaring->containers = containers;
+    roaring->capacity = capacity;
+    return true;
+}
+
+// Index of key, or -(insertion point) - 1
+static ptrdiff_t findKey(const Roaring* roaring, uint16_t key) {
+    size_t low = 0;
+    size_t high = roaring->size;
+    while (low < high) {
+        size_t mid = (low + high) >> 1;
+        if (roaring->keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < roaring->size && roaring->keys[low] == key) {
+        return (ptrdiff_t)low;
+    }
+    return -(ptrdiff_t)low - 1;
+}
+
+// Takes ownership of the container
+static bool insertContainer(Roaring* roaring, size_t position, uint16_t key, const RoaringContainer* c) {
+    if (!roaringReserve(roaring, roaring->size + 1)) {
+        return false;
+    }
+    size_t tail = roaring->size - position;
+    memmove(roaring->keys + position + 1, roaring->keys + position, tail * sizeof(uint16_t));
+    memmove(roaring->containers + position + 1, roaring->containers + position, tail * sizeof(RoaringContainer));
+    roaring->keys[position] = key;
+    roaring->containers[position] = *c;
+    roaring->size++;
+    return true;
+}
+
+static void removeContainer(Roaring* roaring, size_t position) {
+    containerFree(&roaring->containers[position]);
+    size_t tail = roaring->size - position - 1;
+    memmove(roaring->keys + position, roaring->keys + position + 1, tail * sizeof(uint16_t));
+    memmove(roaring->containers + position, roaring->containers + position + 1, tail * sizeof(RoaringContainer));
+    roaring->size--;
+}
+
+bool roaringCopy(Roaring* dest, const Roaring* source) {
+    Roaring result;
+    roaringInit(&result);
+    if (!roaringReserve(&result, source->size)) {
+        return false;
+    }
+    for (size_t i = 0; i < source->size; i++) {
+        if (!containerClone(&source->containers[i], &result.containers[i])) {
+            roaringDestroy(&result);
+            return false;
+        }
+        result.keys[i] = source->keys[i];
+        result.size++;
+    }
+    roaringDestroy(dest);
+    *dest = result;
+    return true;
+}
+
+// ========== Single Values ==========
+
+bool roaringAdd(Roaring* roaring, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    ptrdiff_t index = findKey(roaring, key);
+    if (index >= 0) {
+        return containerAdd(&roaring->containers[index], (uint16_t)value);
+    }
+    RoaringContainer c;
+    if (!containerCreate(&c, CONTAINER_ARRAY, 4)) {
+        return false;
+    }
+    c.values[0] = (uint16_t)value;
+    c.count = 1;
+    c.cardinality = 1;
+    if (!insertContainer(roaring, (size_t)(-index - 1), key, &c)) {
+        containerFree(&c);
+        return false;
+    }
+    return true;
+}
+
+bool roaringRemove(Roaring* roaring, uint32_t value) {
+    ptrdiff_t index = findKey(roaring, (uint16_t)(value >> 16));
+    if (index < 0 || !containerRemove(&roaring->containers[index], (uint16_t)value)) {
+        return false;
+    }
+    if (roaring->containers[index].cardinality == 0) {
+        removeContainer(roaring, (size_t)index);
+    }
+    return true;
+}
+
+bool roaringContains(const Roaring* roaring, uint32_t value) {
+    ptrdiff_t index = findKey(roaring, (uint16_t)(value >> 16));
+    return index >= 0 && containerContains(&roaring->containers[index], (uint16_t)value);
+}
+
+bool roaringAddRange(Roaring* roaring, uint64_t low, uint64_t high) {
+    if (high > (1ULL << 32)) {
+        high = 1ULL << 32;
+    }
+    if (low >= high) {
+        return true;
+    }
+    for (uint64_t chunk = low >> 16; chunk <= (high - 1) >> 16; chunk++) {
+        uint32_t first = chunk == low >> 16 ? (uint32_t)(low & 0xffff) : 0;
+        uint32_t last = chunk == (high - 1) >> 16 ? (uint32_t)((high - 1) & 0xffff) : 0xffff;
+        ptrdiff_t index = findKey(roaring, (uint16_t)chunk);
+
+        if (index < 0 || (first == 0 && last == 0xffff)) {
+            // A new or completely covered chunk becomes a single run
+            RoaringContainer c;
+            if (!containerCreate(&c, CONTAINER_RUN, 1)) {
+                return false;
+            }
+            c.runs[0] = (RoaringRun){ (uint16_t)first, (uint16_t)(last - first) };
+            c.count = 1;
+            c.cardinality = (int32_t)(last - first + 1);
+            if (index >= 0) {
+                containerFree(&roaring->containers[index]);
+                roaring->containers[index] = c;
+            } else if (!insertContainer(roaring, (size_t)(-index - 1), (uint16_t)chunk, &c)) {
+                containerFree(&c);
+                return false;
+            }
+            continue;
+        }
+
+        RoaringContainer* c = &roaring->containers[index];
+        if (!containerConvert(c, CONTAINER_BITMAP) || !containerMakeOwned(c)) {
+            return false;
+        }
+        setBitRange(c->words, first, last);
+        c->cardinality = (int32_t)popcountWords(c->words, ROARING_BITMAP_WORDS);
+        if (!containerNormalize(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t roaringRunOptimize(Roaring* roaring) {
+    size_t changed = 0;
+    for (size_t i = 0; i < roaring->size; i++) {
+        RoaringContainer* c = &roaring->containers[i];
+        ContainerType best = bestType(c, true);
+        if (best != c->type && containerConvert(c, best)) {
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// ========== Set Operations ==========
+
+// Merge the two key lists; chunks present on one side only are copied or
+// skipped without looking at their contents
+static bool roaringCombine(Roaring* dest, const Roaring* a, const Roaring* b, SetOp op) {
+    Roaring result;
+    roaringInit(&result);
+    size_t i = 0, j = 0;
+    bool ok = true;
+    while (ok && (i < a->size || j < b->size)) {
+        if (op == OP_AND && (i == a->size || j == b->size)) {
+            break;
+        }
+        if (op == OP_ANDNOT && i == a->size) {
+            break;
+        }
+
+        RoaringContainer c;
+        bool produced = false;
+        uint16_t key;
+        if (j == b->size || (i < a->size && a->keys[i] < b->keys[j])) {
+            key = a->keys[i];
+            if (op != OP_AND) {
+                ok = produced = containerClone(&a->containers[i], &c);
+            }
+            i++;
+        } else if (i == a->size || b->keys[j] < a->keys[i]) {
+            key = b->keys[j];
+            if (op == OP_OR) {
+                ok = produced = containerClone(&b->containers[j], &c);
+            }
+            j++;
+        } else {
+            key = a->keys[i];
+            ok = produced = containerCombine(&a->containers[i], &b->containers[j], op, &c);
+            i++;
+            j++;
+        }
+
+        if (produced) {
+            if (c.cardinality == 0) {
+                containerFree(&c);
+            } else if (!insertContainer(&result, result.size, key, &c)) {
+                containerFree(&c);
+                ok = false;
+            }
+        }
+    }
+    if (!ok) {
+        roaringDestroy(&result);
+        return false;
+    }
+    roaringDestroy(dest);
+    *dest = result;
+    return true;
+}
+
+bool roaringAnd(Roaring* dest, const Roaring* a, const Roaring* b) {
+    return roaringCombine(dest, a, b, OP_AND);
+}
+
+bool roaringOr(Roaring* dest, const Roaring* a, const Roaring* b) {
+    return roaringCombine(dest, a, b, OP_OR);
+}
+
+bool roaringAndNot(Roaring* dest, const Roaring* a, const Roaring* b) {
+    return roaringCombine(dest, a, b, OP_ANDNOT);
+}
+
+uint64_t roaringCardinality(const Roaring* roaring) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < roaring->size; i++) {
+        total += (uint64_t)roaring->containers[i].cardinality;
+    }
+    return total;
+}
+
+size_t roaringSizeInBytes(const Roaring* roaring) {
+    size_t bytes = sizeof(Roaring) + roaring->capacity * (sizeof(uint16_t) + sizeof(RoaringContainer));
+    for (size_t i = 0; i < roaring->size; i++) {
+        const RoaringContainer* c = &roaring->containers[i];
+        if (c->owned) {
+            bytes += (size_t)c->capacity * elementSize(c->type);
+        }
+    }
+    return bytes;
+}
+
+// ========== Iteration ==========
+
+void roaringForEach(const Roaring* roaring, RoaringVisitor visit, void* context) {
+    for (size_t i = 0; i < roaring->size; i++) {
+        const RoaringContainer* c = &roaring->containers[i];
+        uint32_t base = (uint32_t)roaring->keys[i] << 16;
+        if (c->type == CONTAINER_ARRAY) {
+            for (int32_t k = 0; k < c->count; k++) {
+                if (visit(base | c->values[k], context) != 0) {
+                    return;
+                }
+            }
+        } else if (c->type == CONTAINER_BITMAP) {
+            for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) {
+                uint64_t bits = c->words[w];
+                while (bits != 0) {
+                    if (visit(base | (w * 64 + (uint32_t)__builtin_ctzll(bits)), context) != 0) {
+                        return;
+                    }
+                    bits &= bits - 1;
+                }
+            }
+        } else {
+            for (int32_t r = 0; r < c->count; r++) {
+                for (uint32_t v = c->runs[r].start; v <= runEnd(c->runs[r]); v++) {
+                    if (visit(base | v, context) != 0) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+size_t roaringToArray(const Roaring* roaring, uint32_t* out) {
+    size_t n = 0;
+    for (size_t i = 0; i < roaring->size; i++) {
+        const RoaringContainer* c = &roaring->containers[i];
+        uint32_t base = (uint32_t)roaring->keys[i] << 16;
+        if (c->type == CONTAINER_ARRAY) {
+            for (int32_t k = 0; k < c->count; k++) {
+                out[n++] = base | c->values[k];
+            }
+        } else if (c->type == CONTAINER_BITMAP) {
+            for (uint32_t w = 0; w < ROARING_BITMAP_WORDS; w++) {
+                uint64_t bits = c->words[w];
+                while (bits != 0) {
+                    out[n++] = base | (w * 64 + (uint32_t)__builtin_ctzll(bits));
+                    bits &= bits - 1;
+                }
+            }
+        } else {
+            for (int32_t r = 0; r < c->count; r++) {
+                for (uint32_t v = c->runs[r].start; v <= runEnd(c->runs[r]); v++) {
+                    out[n++] = base | v;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// ========== Serialization ==========
+
+// File layout:
+//   header       magic, container count
+//   descriptors  key, type, count, cardinality, offset of the data (16 bytes each)
+//   data         each container's values/words/runs, padded to 8 bytes
+typedef struct {
+    uint32_t magic;
+    uint32_t containerCount;
+} RoaringHeader;
+
+typedef struct {
+    uint16_t key;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t count;
+    uint32_t cardinality;
+    uint32_t offset;
+} RoaringDescriptor;
+
+static size_t align8(size_t bytes) {
+    return (bytes + 7) & ~(size_t)7;
+}
+
+size_t roaringSerializedSize(const Roaring* roaring) {
+    size_t bytes = align8(sizeof(RoaringHeader) + roaring->size * sizeof(RoaringDescriptor));
+    for (size_t i = 0; i < roaring->size; i++) {
+        bytes += align8(usedBytes(&roaring->containers[i]));
+    }
+    return bytes;
+}
+
+size_t roaringSerialize(const Roaring* roaring, void* buffer) {
+    char* out = (char*)buffer;
+    RoaringHeader header = { ROARING_MAGIC, (uint32_t)roaring->size };
+    memcpy(out, &header, sizeof(header));
+
+    size_t offset = align8(sizeof(RoaringHeader) + roaring->size * sizeof(RoaringDescriptor));
+    for (size_t i = 0; i < roaring->size; i++) {
+        const RoaringContainer* c = &roaring->containers[i];
+        RoaringDescriptor descriptor = { roaring->keys[i], c->type, 0, (uint32_t)c->count,
+                                         (uint32_t)c->cardinality, (uint32_t)offset };
+        memcpy(out + sizeof(RoaringHeader) + i * sizeof(RoaringDescriptor), &descriptor, sizeof(descriptor));
+
+        size_t bytes = usedBytes(c);
+        memcpy(out + offset, c->values, bytes);
+        memset(out + offset + bytes, 0, align8(bytes) - bytes);
+        offset += align8(bytes);
+    }
+    return offset;
+}
+
+bool roaringWriteFile(const Roaring* roaring, const char* path) {
+    size_t size = roaringSerializedSize(roaring);
+    void* buffer = malloc(size);
+    if (buffer == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    roaringSerialize(roaring, buffer);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        free(buffer);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Cannot write %s\n", path);
+    }
+    free(buffer);
+    return ok;
+}
+
+// The contents must agree with the descriptor, or converting a container
+// later could write past the end of its new allocation
+static bool validContents(const RoaringContainer* c) {
+    if (c->type == CONTAINER_ARRAY) {
+        for (int32_t i = 1; i < c->count; i++) {
+            if (c->values[i] <= c->values[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (c->type == CONTAINER_BITMAP) {
+        return c->cardinality > ROARING_ARRAY_MAX &&
+               popcountWords(c->words, ROARING_BITMAP_WORDS) == (size_t)c->cardinality;
+    }
+    int64_t cardinality = 0;
+    for (int32_t i = 0; i < c->count; i++) {
+        if (runEnd(c->runs[i]) >= CHUNK_BITS || (i > 0 && c->runs[i].start <= runEnd(c->runs[i - 1]) + 1)) {
+            return false;
+        }
+        cardinality += c->runs[i].length + 1;
+    }
+    return cardinality == c->cardinality;
+}
+
+static bool invalidData(Roaring* view) {
+    printf("Invalid roaring bitmap data\n");
+    roaringDestroy(view);
+    return false;
+}
+
+bool roaringView(Roaring* view, const void* buffer, size_t size) {
+    roaringInit(view);
+    const char* base = (const char*)buffer;
+    RoaringHeader header;
+    if (size < sizeof(header) || ((uintptr_t)buffer & 7) != 0) {
+        return invalidData(view);
+    }
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != ROARING_MAGIC || header.containerCount > 65536 ||
+        size < sizeof(header) + (size_t)header.containerCount * sizeof(RoaringDescriptor)) {
+        return invalidData(view);
+    }
+    if (!roaringReserve(view, header.containerCount)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < header.containerCount; i++) {
+        RoaringDescriptor d;
+        memcpy(&d, base + sizeof(header) + i * sizeof(d), sizeof(d));
+        RoaringContainer* c = &view->containers[i];
+        c->type = d.type;
+        c->count = (int32_t)d.count;
+        size_t bytes = d.type <= CONTAINER_RUN ? usedBytes(c) : 0;
+        // A damaged file must not make a query read or write out of bounds
+        bool valid = d.type <= CONTAINER_RUN && d.offset % 8 == 0 && d.offset <= size &&
+                     bytes <= size - d.offset && d.cardinality >= 1 && d.cardinality <= CHUNK_BITS &&
+                     (i == 0 || d.key > view->keys[i - 1]) &&
+                     (d.type != CONTAINER_ARRAY || (d.count == d.cardinality && d.count <= ROARING_ARRAY_MAX)) &&
+                     (d.type != CONTAINER_RUN || (d.count >= 1 && d.count <= CHUNK_BITS / 2));
+        if (!valid) {
+            return invalidData(view);
+        }
+        c->owned = false;
+        c->cardinality = (int32_t)d.cardinality;
+        c->capacity = d.type == CONTAINER_BITMAP ? ROARING_BITMAP_WORDS : c->count;
+        c->values = (uint16_t*)(base + d.offset);   // never written: copied before the first change
+        view->keys[i] = d.key;
+        view->size++;
+        // One read-only pass over the data; nothing is copied
+        if (!validContents(c)) {
+            return invalidData(view);
+        }
+    }
+    return true;
+}
+
+bool roaringMapFile(Roaring* view, const char* path) {
+    roaringInit(view);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        printf("Cannot read %s\n", path);
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t)info.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);   // the mapping stays valid
+    if (data == MAP_FAILED) {
+        printf("mmap of %s failed\n", path);
+        return false;
+    }
+    if (!roaringView(view, data, size)) {
+        munmap(data, size);
+        return false;
+    }
+    view->mapping = data;
+    view->mappingSize = size;
+    return true;
+}
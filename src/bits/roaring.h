@@ -0,0 +1,118 @@
+/*
+ * roaring.h - Compressed Bitmaps for Sparse Sets of 32-bit IDs
+ *
+ * A Bitset (bitset.h) over every possible ID costs 512 MB for 2^32 IDs,
+ * even when only a thousand are present. A sorted uint32_t array is small
+ * but slow to test and to combine. A roaring bitmap splits the 32-bit space
+ * into 65536 chunks of 65536 values; the high 16 bits pick the chunk and
+ * each non-empty chunk has a container for the low 16 bits, whichever of
+ * three layouts is smallest:
+ *
+ *   array   sorted uint16_t values, up to 4096 of them (at most 8 KB)
+ *   bitmap  1024 words = 65536 bits, always 8 KB, when more than 4096 values
+ *   run     (start, length) pairs for long stretches of consecutive IDs
+ *
+ * Union, intersection and difference work container by container with
+ * the best algorithm for each pair of layouts (merge or galloping search
+ * for arrays, word-wide AND/OR for bitmaps, interval merging for runs).
+ * Missing chunks are skipped entirely.
+ *
+ * The serialized form keeps every container 8-byte aligned, so a file can
+ * be memory-mapped and queried without parsing or copying (roaringMapFile).
+ * Containers of a mapped bitmap are copied on the first write to them.
+ * The format uses the machine's byte order.
+ *
+ * Compile together with roaring.c, bitset.c and the CPU dispatch layer:
+ *   gcc -O2 -o program program.c roaring.c bitset.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef ROARING_H
+#define ROARING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ROARING_ARRAY_MAX 4096      // larger arrays become bitmaps
+#define ROARING_BITMAP_WORDS 1024   // 65536 bits
+
+typedef enum {
+    CONTAINER_ARRAY,
+    CONTAINER_BITMAP,
+    CONTAINER_RUN
+} ContainerType;
+
+typedef struct {
+    uint16_t start;
+    uint16_t length;   // the run covers start .. start + length
+} RoaringRun;
+
+typedef struct {
+    uint8_t type;          // ContainerType
+    bool owned;            // false while the data is still inside a mapped file
+    int32_t cardinality;
+    int32_t count;         // values (array) or runs (run); unused for bitmaps
+    int32_t capacity;
+    union {
+        uint16_t* values;
+        uint64_t* words;
+        RoaringRun* runs;
+    };
+} RoaringContainer;
+
+typedef struct {
+    uint16_t* keys;                 // high 16 bits, sorted
+    RoaringContainer* containers;   // containers[i] holds chunk keys[i]
+    size_t size;
+    size_t capacity;
+    void* mapping;                  // set by roaringMapFile
+    size_t mappingSize;
+} Roaring;
+
+// ========== Creation ==========
+
+void roaringInit(Roaring* roaring);
+void roaringDestroy(Roaring* roaring);   // also unmaps a mapped file
+bool roaringCopy(Roaring* dest, const Roaring* source);   // dest must be initialized; it is replaced
+
+// ========== Single Values ==========
+
+bool roaringAdd(Roaring* roaring, uint32_t value);        // false if present (or out of memory)
+bool roaringRemove(Roaring* roaring, uint32_t value);     // false if absent
+bool roaringContains(const Roaring* roaring, uint32_t value);
+bool roaringAddRange(Roaring* roaring, uint64_t low, uint64_t high);   // [low, high)
+
+// Rewrite containers as runs wherever that is smaller; returns how many changed
+size_t roaringRunOptimize(Roaring* roaring);
+
+// ========== Set Operations ==========
+
+// dest = a op b. dest must be initialized (it may be a or b) and is replaced.
+bool roaringAnd(Roaring* dest, const Roaring* a, const Roaring* b);
+bool roaringOr(Roaring* dest, const Roaring* a, const Roaring* b);
+bool roaringAndNot(Roaring* dest, const Roaring* a, const Roaring* b);   // a minus b
+
+uint64_t roaringCardinality(const Roaring* roaring);
+size_t roaringSizeInBytes(const Roaring* roaring);   // heap memory in use
+
+// ========== Iteration ==========
+
+// Visitor callback: return 0 to continue, non-zero to stop
+typedef int (*RoaringVisitor)(uint32_t value, void* context);
+
+void roaringForEach(const Roaring* roaring, RoaringVisitor visit, void* context);
+size_t roaringToArray(const Roaring* roaring, uint32_t* out);   // ascending; returns the count
+
+// ========== Serialization ==========
+
+size_t roaringSerializedSize(const Roaring* roaring);
+size_t roaringSerialize(const Roaring* roaring, void* buffer);   // buffer must be 8-byte aligned
+bool roaringWriteFile(const Roaring* roaring, const char* path);
+
+// Use serialized data in place: only the key and container tables are
+// allocated. The view is initialized by the call; buffer must stay valid
+// and unchanged while the view is used.
+bool roaringView(Roaring* view, const void* buffer, size_t size);
+bool roaringMapFile(Roaring* view, const char* path);
+
+#endif
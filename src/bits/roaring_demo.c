@@ -0,0 +1,493 @@
+/*
+ * Roaring Bitmap Demo: Compressed ID Sets vs a Dense Bitset and a Sorted Array
+ *
+ * Shows how values land in array, bitmap and run containers, checks every
+ * operation against a dense Bitset, then compares the three representations
+ * on four kinds of ID sets over the same universe:
+ *
+ *   sparse     0.01% of the IDs, random
+ *   medium     1% of the IDs, random
+ *   clustered  runs of consecutive IDs (date ranges, tenant blocks, ...)
+ *   dense      30% of the IDs, random
+ *
+ * For each it reports memory, intersection, union and membership tests.
+ * Finally it writes a bitmap to a file, maps it back and queries it in
+ * place, without reading the file into memory first.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o roaring_demo roaring_demo.c roaring.c bitset.c ../dispatch/cpu_dispatch.c
+ *   ./roaring_demo [universe] [repeats]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "roaring.h"
+#include "bitset.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static const char* containerName(int type) {
+    return type == CONTAINER_ARRAY ? "array" : type == CONTAINER_BITMAP ? "bitmap" : "run";
+}
+
+static void printContainers(const char* label, const Roaring* roaring) {
+    printf("%s: %llu values in %zu containers:", label,
+           (unsigned long long)roaringCardinality(roaring), roaring->size);
+    for (size_t i = 0; i < roaring->size; i++) {
+        printf(" [%u %s %d]", roaring->keys[i], containerName(roaring->containers[i].type),
+               roaring->containers[i].cardinality);
+    }
+    printf("\n");
+}
+
+static int printVisitor(uint32_t value, void* context) {
+    int* left = (int*)context;
+    printf(" %u", value);
+    return --*left == 0;
+}
+
+// ========== Demonstration ==========
+
+static void demoBasics(void) {
+    printf("=== Containers ===\n");
+    Roaring ids;
+    roaringInit(&ids);
+    for (uint32_t i = 0; i < 10; i++) {
+        roaringAdd(&ids, i * 1000);                  // chunk 0: a few values -> array
+    }
+    for (uint32_t i = 0; i < 10000; i++) {
+        roaringAdd(&ids, 65536 + i * 3);              // chunk 1: 10000 values -> bitmap
+    }
+    roaringAddRange(&ids, 5u << 16, (5u << 16) + 50000);   // chunk 5: one range -> run
+    roaringAdd(&ids, 4000000000u);                   // a high ID costs one small container
+    printContainers("Built", &ids);
+
+    printf("contains(3000) = %d, contains(3001) = %d, contains(4000000000) = %d\n",
+           roaringContains(&ids, 3000), roaringContains(&ids, 3001), roaringContains(&ids, 4000000000u));
+
+    for (uint32_t i = 0; i < 7000; i++) {
+        roaringRemove(&ids, 65536 + i * 3);           // back under 4096 values -> array
+    }
+    roaringAddRange(&ids, 100, 5000);                // the array grows past 4096 -> bitmap
+    printContainers("Changed", &ids);
+    size_t before = roaringSizeInBytes(&ids);
+    size_t changed = roaringRunOptimize(&ids);
+    printContainers("Run-optimized", &ids);
+    printf("roaringRunOptimize changed %zu containers: %zu -> %zu bytes\n",
+           changed, before, roaringSizeInBytes(&ids));
+
+    int left = 8;
+    printf("First values:");
+    roaringForEach(&ids, printVisitor, &left);
+    printf("\n");
+    roaringDestroy(&ids);
+}
+
+// ========== Checks ==========
+
+static bool sameValues(const Roaring* roaring, const Bitset* reference, uint32_t* scratchA, uint32_t* scratchB) {
+    size_t count = roaringToArray(roaring, scratchA);
+    size_t expected = bitsetToIndices(reference, scratchB);
+    return count == expected && roaringCardinality(roaring) == count &&
+           memcmp(scratchA, scratchB, count * sizeof(uint32_t)) == 0;
+}
+
+// Random mixture of sparse chunks, dense chunks and ranges
+static void fillMixed(Roaring* roaring, Bitset* reference, unsigned* seed) {
+    uint32_t universe = (uint32_t)reference->bits;
+    for (int i = 0; i < 20000; i++) {
+        uint32_t v = nextRandom(seed) % universe;
+        roaringAdd(roaring, v);
+        bitsetSet(reference, v);
+    }
+    for (int i = 0; i < 3; i++) {
+        uint32_t chunk = nextRandom(seed) % (universe >> 16);
+        for (int k = 0; k < 30000; k++) {
+            uint32_t v = (chunk << 16) | (nextRandom(seed) & 0xffff);
+            roaringAdd(roaring, v);
+            bitsetSet(reference, v);
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        uint32_t start = nextRandom(seed) % universe;
+        uint32_t length = nextRandom(seed) % 200000;
+        uint32_t end = start + length < universe ? start + length : universe;
+        roaringAddRange(roaring, start, end);
+        for (uint32_t v = start; v < end; v++) {
+            bitsetSet(reference, v);
+        }
+    }
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against a Dense Bitset ===\n");
+    const size_t universe = (size_t)1 << 22;
+    Bitset refA, refB, refResult;
+    Roaring a, b, result, view;
+    uint32_t* scratchA = malloc(universe * sizeof(uint32_t));
+    uint32_t* scratchB = malloc(universe * sizeof(uint32_t));
+    if (scratchA == NULL || scratchB == NULL || !bitsetInit(&refA, universe) ||
+        !bitsetInit(&refB, universe) || !bitsetInit(&refResult, universe)) {
+        printf("Memory allocation failed\n");
+        free(scratchA);
+        free(scratchB);
+        return false;
+    }
+    roaringInit(&a);
+    roaringInit(&b);
+    roaringInit(&result);
+    roaringInit(&view);
+
+    bool ok = true;
+    for (int round = 0; round < 4; round++) {
+        roaringDestroy(&a);
+        roaringDestroy(&b);
+        bitsetClearAll(&refA);
+        bitsetClearAll(&refB);
+        fillMixed(&a, &refA, seed);
+        fillMixed(&b, &refB, seed);
+        if (round % 2 == 1) {
+            roaringRunOptimize(&a);   // exercise run containers against the others
+            roaringRunOptimize(&b);
+        }
+        ok = ok && sameValues(&a, &refA, scratchA, scratchB);
+
+        roaringAnd(&result, &a, &b);
+        bitsetAnd(&refResult, &refA, &refB);
+        ok = ok && sameValues(&result, &refResult, scratchA, scratchB);
+        roaringOr(&result, &a, &b);
+        bitsetOr(&refResult, &refA, &refB);
+        ok = ok && sameValues(&result, &refResult, scratchA, scratchB);
+        roaringAndNot(&result, &a, &b);
+        bitsetAndNot(&refResult, &refA, &refB);
+        ok = ok && sameValues(&result, &refResult, scratchA, scratchB);
+
+        // In place: a = a & b
+        roaringAnd(&a, &a, &b);
+        bitsetAnd(&refA, &refA, &refB);
+        ok = ok && sameValues(&a, &refA, scratchA, scratchB);
+
+        // Random removals and re-adds, including inside runs
+        for (int i = 0; i < 50000; i++) {
+            uint32_t v = nextRandom(seed) % (uint32_t)universe;
+            if (bitsetTest(&refB, v) != roaringRemove(&b, v)) {
+                ok = false;
+            }
+            bitsetClear(&refB, v);
+            if (i % 3 == 0) {
+                roaringAdd(&b, v ^ 1);
+                bitsetSet(&refB, v ^ 1);
+            }
+        }
+        ok = ok && sameValues(&b, &refB, scratchA, scratchB);
+    }
+
+    // Serialize, view in place, then modify the view (copy on write)
+    size_t size = roaringSerializedSize(&b);
+    void* buffer = aligned_alloc(8, (size + 7) & ~(size_t)7);
+    if (buffer != NULL) {
+        roaringSerialize(&b, buffer);
+        ok = ok && roaringView(&view, buffer, size) && sameValues(&view, &refB, scratchA, scratchB);
+        for (int i = 0; i < 1000; i++) {
+            uint32_t v = nextRandom(seed) % (uint32_t)universe;
+            roaringAdd(&view, v);
+            bitsetSet(&refB, v);
+        }
+        ok = ok && sameValues(&view, &refB, scratchA, scratchB);
+        roaringDestroy(&view);
+
+        // A corrupted header must be rejected, not trusted
+        ((uint32_t*)buffer)[0] ^= 1;
+        printf("Corrupted data: ");
+        ok = ok && !roaringView(&view, buffer, size);
+        free(buffer);
+    }
+
+    printf("and/or/andnot/add/remove/serialize: %s\n", ok ? "all match" : "MISMATCH");
+    roaringDestroy(&a);
+    roaringDestroy(&b);
+    roaringDestroy(&result);
+    bitsetDestroy(&refA);
+    bitsetDestroy(&refB);
+    bitsetDestroy(&refResult);
+    free(scratchA);
+    free(scratchB);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+// One ID set in all three representations
+typedef struct {
+    Bitset dense;
+    uint32_t* sorted;
+    size_t count;
+    Roaring roaring;
+} IdSet;
+
+static bool buildIdSet(IdSet* set, size_t universe, int kind, unsigned* seed) {
+    if (!bitsetInit(&set->dense, universe)) {
+        return false;
+    }
+    if (kind == 2) {
+        // Runs of 100..2000 IDs separated by gaps of 1000..20000
+        size_t v = nextRandom(seed) % 1000;
+        while (v < universe) {
+            size_t end = v + 100 + nextRandom(seed) % 1900;
+            for (; v < end && v < universe; v++) {
+                bitsetSet(&set->dense, v);
+            }
+            v += 1000 + nextRandom(seed) % 19000;
+        }
+    } else {
+        // Per million: 100 (sparse), 10000 (medium), 300000 (dense)
+        unsigned perMillion = kind == 0 ? 100 : kind == 1 ? 10000 : 300000;
+        for (size_t v = 0; v < universe; v++) {
+            if (nextRandom(seed) % 1000000 < perMillion) {
+                bitsetSet(&set->dense, v);
+            }
+        }
+    }
+
+    set->count = bitsetCount(&set->dense);
+    set->sorted = malloc((set->count ? set->count : 1) * sizeof(uint32_t));
+    if (set->sorted == NULL) {
+        printf("Memory allocation failed\n");
+        bitsetDestroy(&set->dense);
+        return false;
+    }
+    bitsetToIndices(&set->dense, set->sorted);
+    roaringInit(&set->roaring);
+    for (size_t i = 0; i < set->count; i++) {
+        roaringAdd(&set->roaring, set->sorted[i]);
+    }
+    roaringRunOptimize(&set->roaring);
+    return true;
+}
+
+static void destroyIdSet(IdSet* set) {
+    bitsetDestroy(&set->dense);
+    free(set->sorted);
+    roaringDestroy(&set->roaring);
+}
+
+static size_t sortedIntersect(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    size_t i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (a[i] > b[j]) {
+            j++;
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+static size_t sortedUnion(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    size_t i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        uint32_t x = a[i];
+        uint32_t y = b[j];
+        out[n++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    while (i < na) out[n++] = a[i++];
+    while (j < nb) out[n++] = b[j++];
+    return n;
+}
+
+static bool sortedContains(const uint32_t* values, size_t n, uint32_t key) {
+    size_t low = 0, high = n;
+    while (low < high) {
+        size_t mid = (low + high) >> 1;
+        if (values[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < n && values[low] == key;
+}
+
+#define TIME_REPEATED(seconds, repeats, statement)                      \
+    do {                                                                \
+        struct timespec start_, end_;                                   \
+        clock_gettime(CLOCK_MONOTONIC, &start_);                        \
+        for (int r_ = 0; r_ < (repeats); r_++) {                        \
+            statement;                                                  \
+        }                                                               \
+        clock_gettime(CLOCK_MONOTONIC, &end_);                          \
+        (seconds) = elapsedSeconds(start_, end_) / (repeats);           \
+    } while (0)
+
+static bool benchKind(size_t universe, int kind, int repeats, const uint32_t* probes, int probeCount, unsigned* seed) {
+    static const char* kinds[] = { "sparse", "medium", "clustered", "dense" };
+    IdSet a, b;
+    if (!buildIdSet(&a, universe, kind, seed)) {
+        return false;
+    }
+    if (!buildIdSet(&b, universe, kind, seed)) {
+        destroyIdSet(&a);
+        return false;
+    }
+
+    Bitset denseResult;
+    Roaring roaringResult;
+    uint32_t* sortedResult = malloc((a.count + b.count + 1) * sizeof(uint32_t));
+    if (sortedResult == NULL || !bitsetInit(&denseResult, universe)) {
+        printf("Memory allocation failed\n");
+        free(sortedResult);
+        destroyIdSet(&a);
+        destroyIdSet(&b);
+        return false;
+    }
+    roaringInit(&roaringResult);
+
+    double andSeconds[3], orSeconds[3], containsSeconds[3];
+    size_t andCounts[3], orCounts[3], hits[3] = { 0, 0, 0 };
+
+    TIME_REPEATED(andSeconds[0], repeats, bitsetAnd(&denseResult, &a.dense, &b.dense));
+    andCounts[0] = bitsetCount(&denseResult);
+    TIME_REPEATED(orSeconds[0], repeats, bitsetOr(&denseResult, &a.dense, &b.dense));
+    orCounts[0] = bitsetCount(&denseResult);
+    TIME_REPEATED(containsSeconds[0], 1,
+                  for (int p = 0; p < probeCount; p++) hits[0] += bitsetTest(&a.dense, probes[p]));
+
+    TIME_REPEATED(andSeconds[1], repeats, andCounts[1] = sortedIntersect(a.sorted, a.count, b.sorted, b.count, sortedResult));
+    TIME_REPEATED(orSeconds[1], repeats, orCounts[1] = sortedUnion(a.sorted, a.count, b.sorted, b.count, sortedResult));
+    TIME_REPEATED(containsSeconds[1], 1,
+                  for (int p = 0; p < probeCount; p++) hits[1] += sortedContains(a.sorted, a.count, probes[p]));
+
+    TIME_REPEATED(andSeconds[2], repeats, roaringAnd(&roaringResult, &a.roaring, &b.roaring));
+    andCounts[2] = (size_t)roaringCardinality(&roaringResult);
+    TIME_REPEATED(orSeconds[2], repeats, roaringOr(&roaringResult, &a.roaring, &b.roaring));
+    orCounts[2] = (size_t)roaringCardinality(&roaringResult);
+    TIME_REPEATED(containsSeconds[2], 1,
+                  for (int p = 0; p < probeCount; p++) hits[2] += roaringContains(&a.roaring, probes[p]));
+
+    size_t bytes[3] = { a.dense.wordCount * sizeof(uint64_t), a.count * sizeof(uint32_t),
+                        roaringSizeInBytes(&a.roaring) };
+    const char* names[3] = { "dense bitset", "sorted array", "roaring" };
+    size_t types[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < a.roaring.size; i++) {
+        types[a.roaring.containers[i].type]++;
+    }
+
+    printf("\n%s: %zu IDs (%.3f%%), roaring containers: %zu array, %zu bitmap, %zu run\n",
+           kinds[kind], a.count, 100.0 * (double)a.count / (double)universe, types[0], types[1], types[2]);
+    printf("%-14s %12s %12s %12s %14s\n", "", "memory KB", "AND ms", "OR ms", "contains ns");
+    bool ok = true;
+    for (int r = 0; r < 3; r++) {
+        printf("%-14s %12.1f %12.3f %12.3f %14.1f\n", names[r], (double)bytes[r] / 1024.0,
+               andSeconds[r] * 1e3, orSeconds[r] * 1e3, containsSeconds[r] * 1e9 / probeCount);
+        ok = ok && andCounts[r] == andCounts[0] && orCounts[r] == orCounts[0] && hits[r] == hits[0];
+    }
+    if (!ok) {
+        printf("Results differ between representations\n");
+    }
+
+    roaringDestroy(&roaringResult);
+    bitsetDestroy(&denseResult);
+    free(sortedResult);
+    destroyIdSet(&a);
+    destroyIdSet(&b);
+    return ok;
+}
+
+// Write a bitmap, map it back and query it without loading it
+static bool benchMappedFile(size_t universe, int repeats, unsigned* seed) {
+    const char* path = "roaring_demo.bin";
+    IdSet a, b;
+    if (!buildIdSet(&a, universe, 1, seed)) {
+        return false;
+    }
+    if (!buildIdSet(&b, universe, 2, seed)) {
+        destroyIdSet(&a);
+        return false;
+    }
+    printf("\n=== Memory-Mapped File ===\n");
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = roaringWriteFile(&a.roaring, path);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double writeSeconds = elapsedSeconds(start, end);
+
+    Roaring mapped, result;
+    roaringInit(&result);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ok = ok && roaringMapFile(&mapped, path);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double mapSeconds = elapsedSeconds(start, end);
+
+    if (ok) {
+        double inMemory, fromFile;
+        TIME_REPEATED(inMemory, repeats, roaringAnd(&result, &a.roaring, &b.roaring));
+        size_t expected = (size_t)roaringCardinality(&result);
+        TIME_REPEATED(fromFile, repeats, roaringAnd(&result, &mapped, &b.roaring));
+        ok = roaringCardinality(&result) == expected && roaringCardinality(&mapped) == a.count;
+
+        printf("File: %zu bytes, %zu containers, written in %.2f ms\n",
+               roaringSerializedSize(&a.roaring), mapped.size, writeSeconds * 1e3);
+        printf("roaringMapFile: %.3f ms (validates, copies nothing; heap used: %zu bytes)\n",
+               mapSeconds * 1e3, roaringSizeInBytes(&mapped));
+        printf("AND with a clustered set: in memory %.3f ms, mapped %.3f ms, results %s\n",
+               inMemory * 1e3, fromFile * 1e3, ok ? "match" : "DIFFER");
+        roaringDestroy(&mapped);
+    }
+    remove(path);
+    roaringDestroy(&result);
+    destroyIdSet(&a);
+    destroyIdSet(&b);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long long universe = argc > 1 ? strtoull(argv[1], NULL, 10) : 1ULL << 26;
+    int repeats = argc > 2 ? atoi(argv[2]) : 10;
+    if (universe < (1u << 16) || universe > (1ULL << 32) || repeats < 1) {
+        printf("Usage: %s [universe 65536..4294967296] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    demoBasics();
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+
+    const int probeCount = 1000000;
+    uint32_t* probes = malloc(probeCount * sizeof(uint32_t));
+    if (probes == NULL) {
+        printf("Memory allocation failed\n");
+        return 1;
+    }
+    for (int p = 0; p < probeCount; p++) {
+        probes[p] = (uint32_t)(nextRandom(&seed) % universe);
+    }
+
+    printf("\n=== Two Sets of Each Kind over %llu IDs (%d repeats) ===\n", universe, repeats);
+    for (int kind = 0; kind < 4; kind++) {
+        ok = benchKind((size_t)universe, kind, repeats, probes, probeCount, &seed) && ok;
+    }
+    ok = benchMappedFile((size_t)universe, repeats, &seed) && ok;
+
+    free(probes);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,543 @@
+/*
+ * scheduler.c - Work-Stealing Task Scheduler (see scheduler.h)
+ *
+ * Pieces:
+ * - Task pool: every worker recycles Task objects through its own free
+ *   list, so spawning does not call malloc in the steady state
+ * - Chase-Lev deque: the C11 version from Le, Pop, Cohen and Zappa Nardelli
+ *   ("Correct and Efficient Work-Stealing for Weak Memory Models", 2013).
+ *   When a deque grows, the old buffer is kept until shutdown because a
+ *   thief may still be reading from it.
+ * - Parking: a worker that finds nothing after a few steal rounds sleeps on
+ *   a condition variable; taskSpawn() only takes the lock when somebody is
+ *   actually asleep.
+ */
+
+#define _GNU_SOURCE
+#include "scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+#define DEQUE_INITIAL_CAPACITY 256
+#define TASK_CHUNK 256
+#define STEAL_ROUNDS_BEFORE_PARK 64
+
+typedef struct Task {
+    TaskFunction function;
+    void* arg;
+    TaskGroup* group;
+    struct Task* nextFree;
+} Task;
+
+typedef struct DequeBuffer {
+    long capacity;              // power of two
+    struct DequeBuffer* retired;
+    _Atomic(Task*) slots[];
+} DequeBuffer;
+
+typedef struct {
+    alignas(CACHE_LINE) atomic_long top;        // thieves steal here
+    alignas(CACHE_LINE) atomic_long bottom;     // owner pushes/pops here
+    _Atomic(DequeBuffer*) buffer;
+} Deque;
+
+typedef struct TaskChunk {
+    struct TaskChunk* next;
+    Task tasks[TASK_CHUNK];
+} TaskChunk;
+
+typedef struct {
+    Deque deque;
+    alignas(CACHE_LINE) Task* freeTasks;
+    TaskChunk* chunks;
+    uint64_t randomState;
+    pthread_t thread;
+    int index;
+} Worker;
+
+typedef struct {
+    Worker* workers;
+    int workerCount;
+    int pinThreads;
+    atomic_int stop;
+    alignas(CACHE_LINE) atomic_int sleepers;
+    atomic_ulong wakeEpoch;
+    pthread_mutex_t parkLock;
+    pthread_cond_t parkCond;
+#ifdef __linux__
+    cpu_set_t callerCpus;     // the calling thread's mask before it was pinned
+    int callerPinned;
+#endif
+} Scheduler;
+
+static Scheduler scheduler;
+static _Thread_local Worker* currentWorker = NULL;
+
+// ========== Chase-Lev Deque ==========
+
+static DequeBuffer* dequeBufferCreate(long capacity) {
+    DequeBuffer* buffer = (DequeBuffer*)malloc(sizeof(DequeBuffer) +
+                                               (size_t)capacity * sizeof(_Atomic(Task*)));
+    if (buffer == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    buffer->capacity = capacity;
+    buffer->retired = NULL;
+    return buffer;
+}
+
+static int dequeInit(Deque* deque) {
+    DequeBuffer* buffer = dequeBufferCreate(DEQUE_INITIAL_CAPACITY);
+    if (buffer == NULL) {
+        return -1;
+    }
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->buffer, buffer);
+    return 0;
+}
+
+static void dequeDestroy(Deque* deque) {
+    DequeBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    while (buffer != NULL) {
+        DequeBuffer* retired = buffer->retired;
+        free(buffer);
+        buffer = retired;
+    }
+}
+
+// Owner only: double the buffer, keeping the old one alive for thieves
+static DequeBuffer* dequeGrow(Deque* deque, DequeBuffer* old, long top, long bottom) {
+    DequeBuffer* grown = dequeBufferCreate(old->capacity * 2);
+    if (grown == NULL) {
+        return NULL;
+    }
+    for (long i = top; i < bottom; i++) {
+        Task* task = atomic_load_explicit(&old->slots[i & (old->capacity - 1)],
+                                          memory_order_relaxed);
+        atomic_store_explicit(&grown->slots[i & (grown->capacity - 1)], task,
+                              memory_order_relaxed);
+    }
+    grown->retired = old;
+    atomic_store_explicit(&deque->buffer, grown, memory_order_release);
+    return grown;
+}
+
+// Owner only. Returns -1 if the deque could not grow.
+static int dequePush(Deque* deque, Task* task) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    DequeBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+    if (bottom - top > buffer->capacity - 1) {
+        buffer = dequeGrow(deque, buffer, top, bottom);
+        if (buffer == NULL) {
+            return -1;
+        }
+    }
+
+    atomic_store_explicit(&buffer->slots[bottom & (buffer->capacity - 1)], task,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return 0;
+}
+
+// Owner only: pop the newest task, or NULL
+static Task* dequeTake(Deque* deque) {
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    DequeBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    Task* task = atomic_load_explicit(&buffer->slots[bottom & (buffer->capacity - 1)],
+                                      memory_order_relaxed);
+    if (top == bottom) {
+        // Last task: race against thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+// Any thread: take the oldest task, or NULL if empty or the race was lost
+static Task* dequeSteal(Deque* deque) {
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    DequeBuffer* buffer = atomic_load_explicit(&deque->buffer, memory_order_acquire);
+    Task* task = atomic_load_explicit(&buffer->slots[top & (buffer->capacity - 1)],
+                                      memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+static int dequeLooksNonEmpty(Deque* deque) {
+    return atomic_load_explicit(&deque->top, memory_order_relaxed) <
+           atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+}
+
+// ========== Task Pool ==========
+
+static Task* taskAlloc(Worker* worker) {
+    if (worker->freeTasks == NULL) {
+        TaskChunk* chunk = (TaskChunk*)malloc(sizeof(TaskChunk));
+        if (chunk == NULL) {
+            printf("Memory allocation failed\n");
+            return NULL;
+        }
+        chunk->next = worker->chunks;
+        worker->chunks = chunk;
+        for (int i = 0; i < TASK_CHUNK; i++) {
+            chunk->tasks[i].nextFree = worker->freeTasks;
+            worker->freeTasks = &chunk->tasks[i];
+        }
+    }
+
+    Task* task = worker->freeTasks;
+    worker->freeTasks = task->nextFree;
+    return task;
+}
+
+// Tasks are returned to the pool of whichever worker ran them
+static void taskFree(Worker* worker, Task* task) {
+    task->nextFree = worker->freeTasks;
+    worker->freeTasks = task;
+}
+
+// ========== Execution ==========
+
+static void runTask(Worker* worker, Task* task) {
+    TaskGroup* group = task->group;
+    task->function(task->arg);
+    taskFree(worker, task);
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static uint64_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// One pass over all other workers starting at a random victim
+static Task* trySteal(Worker* worker) {
+    int count = scheduler.workerCount;
+    if (count < 2) {
+        return NULL;
+    }
+
+    int start = (int)(nextRandom(&worker->randomState) % (uint64_t)count);
+    for (int i = 0; i < count; i++) {
+        int victim = (start + i) % count;
+        if (victim == worker->index) {
+            continue;
+        }
+        Task* task = dequeSteal(&scheduler.workers[victim].deque);
+        if (task != NULL) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static Task* findTask(Worker* worker) {
+    Task* task = dequeTake(&worker->deque);
+    return (task != NULL) ? task : trySteal(worker);
+}
+
+static int anyWorkVisible(void) {
+    for (int i = 0; i < scheduler.workerCount; i++) {
+        if (dequeLooksNonEmpty(&scheduler.workers[i].deque)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void park(void) {
+    pthread_mutex_lock(&scheduler.parkLock);
+    unsigned long epoch = atomic_load(&scheduler.wakeEpoch);
+    atomic_fetch_add(&scheduler.sleepers, 1);
+
+    // Re-check after announcing ourselves: a spawner that pushed before
+    // seeing sleepers > 0 has made its task visible by now
+    if (!anyWorkVisible() && !atomic_load(&scheduler.stop)) {
+        while (atomic_load(&scheduler.wakeEpoch) == epoch && !atomic_load(&scheduler.stop)) {
+            pthread_cond_wait(&scheduler.parkCond, &scheduler.parkLock);
+        }
+    }
+
+    atomic_fetch_sub(&scheduler.sleepers, 1);
+    pthread_mutex_unlock(&scheduler.parkLock);
+}
+
+static void wakeOne(void) {
+    if (atomic_load(&scheduler.sleepers) > 0) {
+        pthread_mutex_lock(&scheduler.parkLock);
+        atomic_fetch_add(&scheduler.wakeEpoch, 1);
+        pthread_cond_signal(&scheduler.parkCond);
+        pthread_mutex_unlock(&scheduler.parkLock);
+    }
+}
+
+static void pinToCpu(int index) {
+#ifdef __linux__
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cpus, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)index;
+#endif
+}
+
+static void* workerMain(void* arg) {
+    Worker* worker = (Worker*)arg;
+    currentWorker = worker;
+    if (scheduler.pinThreads) {
+        pinToCpu(worker->index);
+    }
+
+    int idleRounds = 0;
+    while (!atomic_load_explicit(&scheduler.stop, memory_order_relaxed)) {
+        Task* task = findTask(worker);
+        if (task != NULL) {
+            runTask(worker, task);
+            idleRounds = 0;
+        } else if (++idleRounds < STEAL_ROUNDS_BEFORE_PARK) {
+            sched_yield();
+        } else {
+            park();
+            idleRounds = 0;
+        }
+    }
+    return NULL;
+}
+
+// ========== Public API ==========
+
+// Stops and joins worker threads 1 .. started-1, frees the deques of
+// workers 0 .. initialized-1 and gives the calling thread its CPU mask back
+static void teardown(int started, int initialized) {
+    pthread_mutex_lock(&scheduler.parkLock);
+    atomic_store(&scheduler.stop, 1);
+    pthread_cond_broadcast(&scheduler.parkCond);
+    pthread_mutex_unlock(&scheduler.parkLock);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(scheduler.workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < initialized; i++) {
+        Worker* worker = &scheduler.workers[i];
+        dequeDestroy(&worker->deque);
+        while (worker->chunks != NULL) {
+            TaskChunk* next = worker->chunks->next;
+            free(worker->chunks);
+            worker->chunks = next;
+        }
+    }
+
+#ifdef __linux__
+    if (scheduler.callerPinned) {
+        pthread_setaffinity_np(pthread_self(), sizeof(scheduler.callerCpus), &scheduler.callerCpus);
+        scheduler.callerPinned = 0;
+    }
+#endif
+    free(scheduler.workers);
+    scheduler.workers = NULL;
+    scheduler.workerCount = 0;
+    currentWorker = NULL;
+    pthread_mutex_destroy(&scheduler.parkLock);
+    pthread_cond_destroy(&scheduler.parkCond);
+}
+
+int schedulerInit(int workerCount, int pinThreads) {
+    if (workerCount <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = (cpus > 0) ? (int)cpus : 1;
+    }
+
+    scheduler.workers = (Worker*)aligned_alloc(CACHE_LINE,
+                                               (size_t)workerCount * sizeof(Worker));
+    if (scheduler.workers == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+
+    scheduler.workerCount = workerCount;
+    scheduler.pinThreads = pinThreads;
+    atomic_init(&scheduler.stop, 0);
+    atomic_init(&scheduler.sleepers, 0);
+    atomic_init(&scheduler.wakeEpoch, 0);
+    pthread_mutex_init(&scheduler.parkLock, NULL);
+    pthread_cond_init(&scheduler.parkCond, NULL);
+
+    for (int i = 0; i < workerCount; i++) {
+        Worker* worker = &scheduler.workers[i];
+        if (dequeInit(&worker->deque) != 0) {
+            teardown(0, i);
+            return -1;
+        }
+        worker->freeTasks = NULL;
+        worker->chunks = NULL;
+        worker->randomState = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        worker->index = i;
+    }
+
+    // The calling thread is worker 0. It is pinned too, so its old mask is
+    // kept for schedulerShutdown to restore.
+    currentWorker = &scheduler.workers[0];
+#ifdef __linux__
+    scheduler.callerPinned = 0;
+    if (pinThreads &&
+        pthread_getaffinity_np(pthread_self(), sizeof(scheduler.callerCpus), &scheduler.callerCpus) == 0) {
+        scheduler.callerPinned = 1;
+        pinToCpu(0);
+    }
+#endif
+    for (int i = 1; i < workerCount; i++) {
+        if (pthread_create(&scheduler.workers[i].thread, NULL, workerMain,
+                           &scheduler.workers[i]) != 0) {
+            printf("Failed to start worker %d\n", i);
+            teardown(i, workerCount);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void schedulerShutdown(void) {
+    teardown(scheduler.workerCount, scheduler.workerCount);
+}
+
+int schedulerWorkerCount(void) {
+    return scheduler.workerCount;
+}
+
+int schedulerCurrentWorker(void) {
+    return (currentWorker != NULL) ? currentWorker->index : -1;
+}
+
+void taskGroupInit(TaskGroup* group) {
+    atomic_init(&group->pending, 0);
+}
+
+void taskSpawn(TaskGroup* group, TaskFunction function, void* arg) {
+    Worker* worker = currentWorker;
+    Task* task = (worker != NULL) ? taskAlloc(worker) : NULL;
+
+    if (task == NULL) {
+        function(arg);   // foreign thread or out of memory: run inline
+        return;
+    }
+
+    task->function = function;
+    task->arg = arg;
+    task->group = group;
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+
+    if (dequePush(&worker->deque, task) != 0) {
+        taskFree(worker, task);
+        function(arg);
+        atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+        return;
+    }
+
+    // Pairs with the re-check in park(): push, then look for sleepers
+    atomic_thread_fence(memory_order_seq_cst);
+    wakeOne();
+}
+
+void taskSync(TaskGroup* group) {
+    Worker* worker = currentWorker;
+    unsigned spins = 0;
+
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        Task* task = (worker != NULL) ? findTask(worker) : NULL;
+        if (task != NULL) {
+            runTask(worker, task);
+            spins = 0;
+        } else if (++spins > 16) {
+            sched_yield();   // the remaining tasks are running elsewhere
+        }
+    }
+}
+
+typedef struct {
+    long begin;
+    long end;
+    long grain;
+    RangeFunction body;
+    void* arg;
+} RangeTask;
+
+static void parallelForTask(void* arg) {
+    RangeTask* range = (RangeTask*)arg;
+    TaskGroup group;
+    taskGroupInit(&group);
+
+    // Keep the left half, hand out the right halves
+    RangeTask halves[64];
+    int spawned = 0;
+    long begin = range->begin;
+    long end = range->end;
+    while (end - begin > range->grain && spawned < 64) {
+        long mid = begin + (end - begin) / 2;
+        halves[spawned] = *range;
+        halves[spawned].begin = mid;
+        halves[spawned].end = end;
+        taskSpawn(&group, parallelForTask, &halves[spawned]);
+        spawned++;
+        end = mid;
+    }
+
+    range->body(begin, end, range->arg);
+    taskSync(&group);
+}
+
+void parallelFor(long begin, long end, long grain, RangeFunction body, void* arg) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+
+    RangeTask range = {begin, end, grain, body, arg};
+    parallelForTask(&range);
+}
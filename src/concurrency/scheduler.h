@@ -0,0 +1,64 @@
+/*
+ * scheduler.h - Work-Stealing Task Scheduler
+ *
+ * One shared runtime for parallel algorithms. Each worker thread owns a
+ * Chase-Lev deque: it pushes and pops its own tasks at the bottom (LIFO,
+ * cache-warm), while idle workers steal from the top of a random victim
+ * (FIFO, usually the biggest remaining piece of work). Workers with nothing
+ * to do park on a condition variable instead of spinning.
+ *
+ * Usage:
+ *   schedulerInit(0, 0);                 // one worker per CPU, no pinning
+ *
+ *   TaskGroup group;
+ *   taskGroupInit(&group);
+ *   taskSpawn(&group, work, &args);      // may run on any worker
+ *   otherWork();
+ *   taskSync(&group);                    // helps run tasks until done
+ *
+ *   parallelFor(0, n, 4096, body, &ctx); // body(begin, end, ctx) per chunk
+ *   schedulerShutdown();
+ *
+ * The thread that calls schedulerInit() becomes worker 0. taskSpawn() from
+ * a thread that is not a worker runs the task immediately instead.
+ *
+ * Compile together with scheduler.c:
+ *   gcc -O2 -pthread -o program program.c scheduler.c
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdatomic.h>
+
+typedef void (*TaskFunction)(void* arg);
+
+// Body of a parallelFor(): processes indices [begin, end)
+typedef void (*RangeFunction)(long begin, long end, void* arg);
+
+// Counts the unfinished tasks spawned into it
+typedef struct {
+    atomic_long pending;
+} TaskGroup;
+
+// workerCount <= 0 means one worker per online CPU. With pinThreads set,
+// worker i is bound to CPU i (modulo the CPU count); worker 0 is the
+// calling thread, and schedulerShutdown (called from the same thread)
+// gives it back its previous CPU mask.
+// Returns 0 on success, -1 on failure, with nothing left running.
+int schedulerInit(int workerCount, int pinThreads);
+void schedulerShutdown(void);
+
+int schedulerWorkerCount(void);
+
+// Index of the calling worker, or -1 for a foreign thread
+int schedulerCurrentWorker(void);
+
+void taskGroupInit(TaskGroup* group);
+void taskSpawn(TaskGroup* group, TaskFunction function, void* arg);
+void taskSync(TaskGroup* group);
+
+// Split [begin, end) recursively until chunks are at most grain long
+void parallelFor(long begin, long end, long grain, RangeFunction body, void* arg);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Work-Stealing Scheduler Demo and Benchmarks
+ *
+ * Measures the runtime in scheduler.c:
+ * 1. Spawn overhead: spawn + sync of empty tasks, in ns per task
+ * 2. Parallel Fibonacci: fine-grained recursive spawn/sync
+ * 3. Parallel quickSort: the quickSort from docs/12-algorithms with the two
+ *    recursive calls running as tasks
+ * 4. parallelFor: sum of squares over a large array
+ *
+ * Each benchmark runs with 1, 2, 4, ... workers up to the maximum.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o scheduler_demo scheduler_demo.c scheduler.c
+ *   ./scheduler_demo            (up to one worker per CPU)
+ *   ./scheduler_demo 8 1        (up to 8 workers, pinned to CPUs)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "scheduler.h"
+
+#define FIB_N 36
+#define FIB_CUTOFF 16
+#define SORT_SIZE 5000000
+#define SORT_CUTOFF 4096
+#define SPAWN_TASKS 1000000
+#define SUM_SIZE 20000000L
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// ========== Spawn Overhead ==========
+
+static void emptyTask(void* arg) {
+    (void)arg;
+}
+
+static double measureSpawnOverhead(void) {
+    struct timespec start, end;
+    TaskGroup group;
+    taskGroupInit(&group);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < SPAWN_TASKS; i++) {
+        taskSpawn(&group, emptyTask, NULL);
+    }
+    taskSync(&group);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsedSeconds(start, end) * 1e9 / SPAWN_TASKS;
+}
+
+// ========== Parallel Fibonacci ==========
+
+static long fibSerial(int n) {
+    return (n < 2) ? n : fibSerial(n - 1) + fibSerial(n - 2);
+}
+
+typedef struct {
+    int n;
+    long result;
+} FibArgs;
+
+static void fibTask(void* arg) {
+    FibArgs* args = (FibArgs*)arg;
+    if (args->n < FIB_CUTOFF) {
+        args->result = fibSerial(args->n);
+        return;
+    }
+
+    FibArgs left = {args->n - 1, 0};
+    FibArgs right = {args->n - 2, 0};
+    TaskGroup group;
+    taskGroupInit(&group);
+    taskSpawn(&group, fibTask, &left);
+    fibTask(&right);
+    taskSync(&group);
+    args->result = left.result + right.result;
+}
+
+// ========== Parallel Quick Sort ==========
+
+static void swap(int* a, int* b) {
+    int temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+// Lomuto partition with a median-of-three pivot
+static int partition(int arr[], int low, int high) {
+    int mid = low + (high - low) / 2;
+    if (arr[mid] < arr[low]) swap(&arr[mid], &arr[low]);
+    if (arr[high] < arr[low]) swap(&arr[high], &arr[low]);
+    if (arr[mid] < arr[high]) swap(&arr[mid], &arr[high]);
+    int pivot = arr[high];
+    int i = low - 1;
+
+    for (int j = low; j < high; j++) {
+        if (arr[j] < pivot) {
+            i++;
+            swap(&arr[i], &arr[j]);
+        }
+    }
+    swap(&arr[i + 1], &arr[high]);
+    return i + 1;
+}
+
+static void quickSort(int arr[], int low, int high) {
+    while (low < high) {
+        int pi = partition(arr, low, high);
+        // Recurse into the smaller side to bound the stack depth
+        if (pi - low < high - pi) {
+            quickSort(arr, low, pi - 1);
+            low = pi + 1;
+        } else {
+            quickSort(arr, pi + 1, high);
+            high = pi - 1;
+        }
+    }
+}
+
+typedef struct {
+    int* arr;
+    int low;
+    int high;
+} SortArgs;
+
+static void quickSortTask(void* arg) {
+    SortArgs* args = (SortArgs*)arg;
+    if (args->high - args->low < SORT_CUTOFF) {
+        quickSort(args->arr, args->low, args->high);
+        return;
+    }
+
+    int pi = partition(args->arr, args->low, args->high);
+    SortArgs left = {args->arr, args->low, pi - 1};
+    SortArgs right = {args->arr, pi + 1, args->high};
+    TaskGroup group;
+    taskGroupInit(&group);
+    taskSpawn(&group, quickSortTask, &left);
+    quickSortTask(&right);
+    taskSync(&group);
+}
+
+// ========== parallelFor ==========
+
+typedef struct {
+    const int* values;
+    long long* partial;   // one slot per worker
+} SumArgs;
+
+static void sumSquaresRange(long begin, long end, void* arg) {
+    SumArgs* args = (SumArgs*)arg;
+    long long sum = 0;
+    for (long i = begin; i < end; i++) {
+        sum += (long long)args->values[i] * args->values[i];
+    }
+    args->partial[schedulerCurrentWorker()] += sum;
+}
+
+int main(int argc, char* argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxWorkers = (argc > 1) ? atoi(argv[1]) : (int)cpus;
+    int pin = (argc > 2) ? atoi(argv[2]) : 0;
+    if (maxWorkers < 1) {
+        maxWorkers = 1;
+    }
+
+    int* original = (int*)malloc(SORT_SIZE * sizeof(int));
+    int* arr = (int*)malloc(SORT_SIZE * sizeof(int));
+    int* values = (int*)malloc(SUM_SIZE * sizeof(int));
+    if (original == NULL || arr == NULL || values == NULL) {
+        printf("Memory allocation failed\n");
+        free(original);
+        free(arr);
+        free(values);
+        return 1;
+    }
+
+    srand(42);
+    for (int i = 0; i < SORT_SIZE; i++) {
+        original[i] = rand();
+    }
+    for (long i = 0; i < SUM_SIZE; i++) {
+        values[i] = (int)(i % 1000);
+    }
+
+    printf("CPUs online: %ld, max workers: %d, pinned: %s\n\n",
+           cpus, maxWorkers, pin ? "yes" : "no");
+    printf("%-8s %14s %14s %14s %14s\n", "workers", "spawn (ns)",
+           "fib(36) (s)", "qsort 5M (s)", "pfor 20M (s)");
+
+    int workers = 1;
+    while (workers <= maxWorkers) {
+        if (schedulerInit(workers, pin) != 0) {
+            break;
+        }
+
+        struct timespec start, end;
+        double spawnNs = measureSpawnOverhead();
+
+        FibArgs fib = {FIB_N, 0};
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        fibTask(&fib);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double fibTime = elapsedSeconds(start, end);
+
+        for (int i = 0; i < SORT_SIZE; i++) {
+            arr[i] = original[i];
+        }
+        SortArgs sort = {arr, 0, SORT_SIZE - 1};
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        quickSortTask(&sort);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double sortTime = elapsedSeconds(start, end);
+
+        int sorted = 1;
+        for (int i = 1; i < SORT_SIZE; i++) {
+            if (arr[i - 1] > arr[i]) {
+                sorted = 0;
+                break;
+            }
+        }
+
+        long long* partial = (long long*)calloc((size_t)workers, sizeof(long long));
+        SumArgs sumArgs = {values, partial};
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        parallelFor(0, SUM_SIZE, 65536, sumSquaresRange, &sumArgs);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double sumTime = elapsedSeconds(start, end);
+        long long total = 0;
+        for (int i = 0; i < workers; i++) {
+            total += partial[i];
+        }
+        free(partial);
+
+        printf("%-8d %14.1f %14.3f %14.3f %14.3f   fib=%ld sorted=%s sum=%lld\n",
+               workers, spawnNs, fibTime, sortTime, sumTime,
+               fib.result, sorted ? "yes" : "NO", total);
+
+        schedulerShutdown();
+
+        // 1, 2, 4, ... and always finish with maxWorkers itself
+        if (workers < maxWorkers && workers * 2 > maxWorkers) {
+            workers = maxWorkers;
+        } else {
+            workers *= 2;
+        }
+    }
+
+    free(original);
+    free(arr);
+    free(values);
+    return 0;
+}
@@ -0,0 +1,646 @@
+/*
+ * Concurrent Queues: SPSC Ring, Bounded MPMC and Unbounded Linked Queue
+ *
+ * The circular Queue in docs/11-data-structures/02-stacks-queues.md holds
+ * 100 ints, can only be used by one thread, and enqueue() fails as soon as
+ * it is full. Pipeline stages running on different threads need queues that
+ * can be shared safely without a lock:
+ *
+ * 1. SpscQueue  - one producer, one consumer. A power-of-two ring where each
+ *                 side owns one index and caches the other side's index, so
+ *                 most operations touch no shared cache line at all.
+ * 2. MpmcQueue  - any number of producers and consumers (Dmitry Vyukov's
+ *                 bounded queue). Every slot carries a sequence number that
+ *                 says whether it is ready to be written or read, so a
+ *                 thread claims a slot with a single compare-and-swap.
+ * 3. LinkedQueue - unbounded Michael-Scott queue. Removed nodes are freed
+ *                 through hazard pointers, so a node is never freed while
+ *                 another thread may still be reading it.
+ *
+ * Head and tail indices live on separate 64-byte cache lines so producers
+ * and consumers do not invalidate each other's lines (false sharing).
+ * Values are intptr_t, so a queue can carry plain ints or pointers.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o concurrent_queues concurrent_queues.c
+ *   ./concurrent_queues               (demo + benchmark, 1M items per run)
+ *   ./concurrent_queues 10000000      (10M items per run)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+
+typedef intptr_t QueueValue;
+
+// Round up to the next power of two (minimum 2)
+static size_t roundUpPowerOfTwo(size_t n) {
+    size_t power = 2;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+// Spin briefly, then give the CPU away while a queue stays full or empty
+static void backoff(unsigned* spins) {
+    if (++*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        sched_yield();
+    }
+}
+
+// ========== 1. SPSC Ring Buffer ==========
+
+typedef struct {
+    alignas(CACHE_LINE) atomic_size_t head;   // next slot to read (consumer)
+    size_t cachedTail;                        // consumer's copy of tail
+    alignas(CACHE_LINE) atomic_size_t tail;   // next slot to write (producer)
+    size_t cachedHead;                        // producer's copy of head
+    alignas(CACHE_LINE) size_t mask;
+    QueueValue* slots;
+} SpscQueue;
+
+SpscQueue* spscCreate(size_t capacity) {
+    SpscQueue* queue = (SpscQueue*)aligned_alloc(CACHE_LINE, sizeof(SpscQueue));
+    if (queue == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    capacity = roundUpPowerOfTwo(capacity);
+    queue->slots = (QueueValue*)malloc(capacity * sizeof(QueueValue));
+    if (queue->slots == NULL) {
+        printf("Memory allocation failed\n");
+        free(queue);
+        return NULL;
+    }
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cachedHead = 0;
+    queue->cachedTail = 0;
+    queue->mask = capacity - 1;
+    return queue;
+}
+
+void spscDestroy(SpscQueue* queue) {
+    if (queue != NULL) {
+        free(queue->slots);
+        free(queue);
+    }
+}
+
+// Producer only. Returns false when the ring is full.
+bool spscTryEnqueue(SpscQueue* queue, QueueValue value) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - queue->cachedHead > queue->mask) {
+        queue->cachedHead = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail - queue->cachedHead > queue->mask) {
+            return false;
+        }
+    }
+
+    queue->slots[tail & queue->mask] = value;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Consumer only. Returns false when the ring is empty.
+bool spscTryDequeue(SpscQueue* queue, QueueValue* value) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == queue->cachedTail) {
+        queue->cachedTail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cachedTail) {
+            return false;
+        }
+    }
+
+    *value = queue->slots[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+// ========== 2. Bounded MPMC Queue (Vyukov) ==========
+
+typedef struct {
+    atomic_size_t sequence;
+    QueueValue value;
+} MpmcCell;
+
+typedef struct {
+    alignas(CACHE_LINE) atomic_size_t enqueuePos;
+    alignas(CACHE_LINE) atomic_size_t dequeuePos;
+    alignas(CACHE_LINE) size_t mask;
+    MpmcCell* cells;
+} MpmcQueue;
+
+MpmcQueue* mpmcCreate(size_t capacity) {
+    MpmcQueue* queue = (MpmcQueue*)aligned_alloc(CACHE_LINE, sizeof(MpmcQueue));
+    if (queue == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    capacity = roundUpPowerOfTwo(capacity);
+    queue->cells = (MpmcCell*)malloc(capacity * sizeof(MpmcCell));
+    if (queue->cells == NULL) {
+        printf("Memory allocation failed\n");
+        free(queue);
+        return NULL;
+    }
+
+    // Slot i is free for the producer that claims position i
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+    }
+    atomic_init(&queue->enqueuePos, 0);
+    atomic_init(&queue->dequeuePos, 0);
+    queue->mask = capacity - 1;
+    return queue;
+}
+
+void mpmcDestroy(MpmcQueue* queue) {
+    if (queue != NULL) {
+        free(queue->cells);
+        free(queue);
+    }
+}
+
+bool mpmcTryEnqueue(MpmcQueue* queue, QueueValue value) {
+    size_t pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+    for (;;) {
+        MpmcCell* cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0) {
+            // Slot is free for this position: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->value = value;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;   // the consumer has not freed this slot yet: full
+        } else {
+            pos = atomic_load_explicit(&queue->enqueuePos, memory_order_relaxed);
+        }
+    }
+}
+
+bool mpmcTryDequeue(MpmcQueue* queue, QueueValue* value) {
+    size_t pos = atomic_load_explicit(&queue->dequeuePos, memory_order_relaxed);
+    for (;;) {
+        MpmcCell* cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeuePos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *value = cell->value;
+                // Hand the slot to the producer one lap ahead
+                atomic_store_explicit(&cell->sequence, pos + queue->mask + 1,
+                                      memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;   // nothing published here yet: empty
+        } else {
+            pos = atomic_load_explicit(&queue->dequeuePos, memory_order_relaxed);
+        }
+    }
+}
+
+// ========== 3. Unbounded Linked Queue (Michael-Scott + hazard pointers) ==========
+
+#define HAZARD_MAX_THREADS 64
+#define HAZARDS_PER_THREAD 2
+#define RETIRE_THRESHOLD (2 * HAZARD_MAX_THREADS * HAZARDS_PER_THREAD)
+
+typedef struct LinkedNode {
+    _Atomic(struct LinkedNode*) next;
+    QueueValue value;
+} LinkedNode;
+
+// One record per registered thread, each on its own cache line
+typedef struct {
+    alignas(CACHE_LINE) _Atomic(LinkedNode*) hazard[HAZARDS_PER_THREAD];
+    atomic_int inUse;
+} HazardRecord;
+
+typedef struct {
+    alignas(CACHE_LINE) _Atomic(LinkedNode*) head;   // dummy node
+    alignas(CACHE_LINE) _Atomic(LinkedNode*) tail;
+    HazardRecord records[HAZARD_MAX_THREADS];
+    pthread_mutex_t orphanLock;
+    LinkedNode** orphans;        // retired nodes left behind by exited threads
+    size_t orphanCount;
+} LinkedQueue;
+
+// Per-thread handle: which hazard record it owns and its retired nodes
+typedef struct {
+    LinkedQueue* queue;
+    HazardRecord* record;
+    LinkedNode* retired[RETIRE_THRESHOLD];
+    size_t retiredCount;
+} LinkedQueueHandle;
+
+LinkedQueue* linkedCreate(void) {
+    LinkedQueue* queue = (LinkedQueue*)aligned_alloc(CACHE_LINE, sizeof(LinkedQueue));
+    LinkedNode* dummy = (LinkedNode*)malloc(sizeof(LinkedNode));
+    if (queue == NULL || dummy == NULL) {
+        printf("Memory allocation failed\n");
+        free(queue);
+        free(dummy);
+        return NULL;
+    }
+
+    atomic_init(&dummy->next, NULL);
+    dummy->value = 0;
+    atomic_init(&queue->head, dummy);
+    atomic_init(&queue->tail, dummy);
+    for (int i = 0; i < HAZARD_MAX_THREADS; i++) {
+        for (int h = 0; h < HAZARDS_PER_THREAD; h++) {
+            atomic_init(&queue->records[i].hazard[h], NULL);
+        }
+        atomic_init(&queue->records[i].inUse, 0);
+    }
+    pthread_mutex_init(&queue->orphanLock, NULL);
+    queue->orphans = NULL;
+    queue->orphanCount = 0;
+    return queue;
+}
+
+// Every thread that touches the queue needs its own handle
+LinkedQueueHandle* linkedRegister(LinkedQueue* queue) {
+    LinkedQueueHandle* handle = (LinkedQueueHandle*)malloc(sizeof(LinkedQueueHandle));
+    if (handle == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < HAZARD_MAX_THREADS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&queue->records[i].inUse, &expected, 1)) {
+            handle->queue = queue;
+            handle->record = &queue->records[i];
+            handle->retiredCount = 0;
+            return handle;
+        }
+    }
+
+    printf("Too many threads registered on the queue\n");
+    free(handle);
+    return NULL;
+}
+
+static bool isHazardous(LinkedQueue* queue, LinkedNode* node) {
+    for (int i = 0; i < HAZARD_MAX_THREADS; i++) {
+        for (int h = 0; h < HAZARDS_PER_THREAD; h++) {
+            if (atomic_load(&queue->records[i].hazard[h]) == node) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Free every retired node that no thread has announced as hazardous
+static void scanRetired(LinkedQueueHandle* handle) {
+    size_t kept = 0;
+    for (size_t i = 0; i < handle->retiredCount; i++) {
+        LinkedNode* node = handle->retired[i];
+        if (isHazardous(handle->queue, node)) {
+            handle->retired[kept++] = node;
+        } else {
+            free(node);
+        }
+    }
+    handle->retiredCount = kept;
+}
+
+static void retireNode(LinkedQueueHandle* handle, LinkedNode* node) {
+    handle->retired[handle->retiredCount++] = node;
+    if (handle->retiredCount == RETIRE_THRESHOLD) {
+        // At most HAZARD_MAX_THREADS * HAZARDS_PER_THREAD nodes can survive
+        scanRetired(handle);
+    }
+}
+
+void linkedUnregister(LinkedQueueHandle* handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+    LinkedQueue* queue = handle->queue;
+    scanRetired(handle);
+    if (handle->retiredCount > 0) {
+        pthread_mutex_lock(&queue->orphanLock);
+        LinkedNode** grown = (LinkedNode**)realloc(queue->orphans,
+            (queue->orphanCount + handle->retiredCount) * sizeof(LinkedNode*));
+        if (grown != NULL) {
+            queue->orphans = grown;
+            for (size_t i = 0; i < handle->retiredCount; i++) {
+                queue->orphans[queue->orphanCount++] = handle->retired[i];
+            }
+        }
+        pthread_mutex_unlock(&queue->orphanLock);
+    }
+
+    atomic_store(&handle->record->inUse, 0);
+    free(handle);
+}
+
+bool linkedEnqueue(LinkedQueueHandle* handle, QueueValue value) {
+    LinkedQueue* queue = handle->queue;
+    LinkedNode* node = (LinkedNode*)malloc(sizeof(LinkedNode));
+    if (node == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    node->value = value;
+    atomic_init(&node->next, NULL);
+
+    for (;;) {
+        LinkedNode* tail = atomic_load(&queue->tail);
+        atomic_store(&handle->record->hazard[0], tail);
+        if (tail != atomic_load(&queue->tail)) {
+            continue;   // tail may already be retired, announce again
+        }
+
+        LinkedNode* next = atomic_load(&tail->next);
+        if (tail != atomic_load(&queue->tail)) {
+            continue;
+        }
+        if (next != NULL) {
+            // Help a slow producer swing the tail forward
+            atomic_compare_exchange_weak(&queue->tail, &tail, next);
+            continue;
+        }
+
+        LinkedNode* expected = NULL;
+        if (atomic_compare_exchange_weak(&tail->next, &expected, node)) {
+            atomic_compare_exchange_strong(&queue->tail, &tail, node);
+            break;
+        }
+    }
+
+    atomic_store(&handle->record->hazard[0], NULL);
+    return true;
+}
+
+bool linkedTryDequeue(LinkedQueueHandle* handle, QueueValue* value) {
+    LinkedQueue* queue = handle->queue;
+    LinkedNode* head;
+
+    for (;;) {
+        head = atomic_load(&queue->head);
+        atomic_store(&handle->record->hazard[0], head);
+        if (head != atomic_load(&queue->head)) {
+            continue;
+        }
+
+        LinkedNode* tail = atomic_load(&queue->tail);
+        LinkedNode* next = atomic_load(&head->next);
+        atomic_store(&handle->record->hazard[1], next);
+        if (head != atomic_load(&queue->head)) {
+            continue;
+        }
+
+        if (next == NULL) {
+            atomic_store(&handle->record->hazard[0], NULL);
+            atomic_store(&handle->record->hazard[1], NULL);
+            return false;
+        }
+        if (head == tail) {
+            atomic_compare_exchange_weak(&queue->tail, &tail, next);
+            continue;
+        }
+
+        *value = next->value;
+        if (atomic_compare_exchange_weak(&queue->head, &head, next)) {
+            break;
+        }
+    }
+
+    // The old dummy is unreachable now; free it once nobody guards it
+    atomic_store(&handle->record->hazard[0], NULL);
+    atomic_store(&handle->record->hazard[1], NULL);
+    retireNode(handle, head);
+    return true;
+}
+
+// Call after every handle has been unregistered
+void linkedDestroy(LinkedQueue* queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    LinkedNode* node = atomic_load(&queue->head);
+    while (node != NULL) {
+        LinkedNode* next = atomic_load(&node->next);
+        free(node);
+        node = next;
+    }
+    for (size_t i = 0; i < queue->orphanCount; i++) {
+        free(queue->orphans[i]);
+    }
+    free(queue->orphans);
+    pthread_mutex_destroy(&queue->orphanLock);
+    free(queue);
+}
+
+// ========== Benchmark ==========
+
+typedef enum { KIND_SPSC, KIND_MPMC, KIND_LINKED } QueueKind;
+
+typedef struct {
+    QueueKind kind;
+    void* queue;
+    long items;                 // items this thread produces
+    long long sum;              // consumer checksum
+    atomic_long* remaining;     // items still to be consumed (shared)
+} WorkerArgs;
+
+static void* producerThread(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    LinkedQueueHandle* handle = NULL;
+    if (args->kind == KIND_LINKED) {
+        handle = linkedRegister((LinkedQueue*)args->queue);
+    }
+
+    for (long i = 1; i <= args->items; i++) {
+        unsigned spins = 0;
+        switch (args->kind) {
+        case KIND_SPSC:
+            while (!spscTryEnqueue((SpscQueue*)args->queue, i)) {
+                backoff(&spins);
+            }
+            break;
+        case KIND_MPMC:
+            while (!mpmcTryEnqueue((MpmcQueue*)args->queue, i)) {
+                backoff(&spins);
+            }
+            break;
+        case KIND_LINKED:
+            linkedEnqueue(handle, i);
+            break;
+        }
+    }
+
+    linkedUnregister(handle);
+    return NULL;
+}
+
+static void* consumerThread(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    LinkedQueueHandle* handle = NULL;
+    if (args->kind == KIND_LINKED) {
+        handle = linkedRegister((LinkedQueue*)args->queue);
+    }
+
+    unsigned spins = 0;
+    while (atomic_load_explicit(args->remaining, memory_order_relaxed) > 0) {
+        QueueValue value;
+        bool ok = false;
+        switch (args->kind) {
+        case KIND_SPSC:
+            ok = spscTryDequeue((SpscQueue*)args->queue, &value);
+            break;
+        case KIND_MPMC:
+            ok = mpmcTryDequeue((MpmcQueue*)args->queue, &value);
+            break;
+        case KIND_LINKED:
+            ok = linkedTryDequeue(handle, &value);
+            break;
+        }
+
+        if (ok) {
+            args->sum += value;
+            atomic_fetch_sub_explicit(args->remaining, 1, memory_order_relaxed);
+            spins = 0;
+        } else {
+            backoff(&spins);
+        }
+    }
+
+    linkedUnregister(handle);
+    return NULL;
+}
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void runBenchmark(QueueKind kind, int producers, int consumers, long totalItems) {
+    static const char* names[] = {"SPSC ring", "MPMC bounded", "linked (HP)"};
+    void* queue = NULL;
+
+    switch (kind) {
+    case KIND_SPSC:   queue = spscCreate(1 << 14); break;
+    case KIND_MPMC:   queue = mpmcCreate(1 << 14); break;
+    case KIND_LINKED: queue = linkedCreate(); break;
+    }
+    if (queue == NULL) {
+        return;
+    }
+
+    long perProducer = totalItems / producers;
+    atomic_long remaining;
+    atomic_init(&remaining, perProducer * producers);
+
+    pthread_t threads[16];
+    WorkerArgs args[16];
+    int threadCount = producers + consumers;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < threadCount; t++) {
+        args[t].kind = kind;
+        args[t].queue = queue;
+        args[t].items = perProducer;
+        args[t].sum = 0;
+        args[t].remaining = &remaining;
+        pthread_create(&threads[t], NULL,
+                       t < producers ? producerThread : consumerThread, &args[t]);
+    }
+    for (int t = 0; t < threadCount; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long long sum = 0;
+    for (int t = producers; t < threadCount; t++) {
+        sum += args[t].sum;
+    }
+    long long expected = (long long)producers * perProducer * (perProducer + 1) / 2;
+    double seconds = elapsedSeconds(start, end);
+
+    printf("%-13s %dP/%dC : %7.2f Mops/s  %s\n", names[kind], producers, consumers,
+           (double)(perProducer * producers) / seconds / 1e6,
+           sum == expected ? "ok" : "CHECKSUM MISMATCH");
+
+    switch (kind) {
+    case KIND_SPSC:   spscDestroy((SpscQueue*)queue); break;
+    case KIND_MPMC:   mpmcDestroy((MpmcQueue*)queue); break;
+    case KIND_LINKED: linkedDestroy((LinkedQueue*)queue); break;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Single-threaded demo: the bounded queues report "full" instead of failing
+    MpmcQueue* queue = mpmcCreate(4);
+    if (queue == NULL) {
+        return 1;
+    }
+
+    printf("Enqueue 1..6 into a 4-slot MPMC queue: ");
+    for (int i = 1; i <= 6; i++) {
+        printf("%s ", mpmcTryEnqueue(queue, i) ? "ok" : "full");
+    }
+    printf("\nDequeue: ");
+    QueueValue value;
+    while (mpmcTryDequeue(queue, &value)) {
+        printf("%ld ", (long)value);
+    }
+    printf("\n");
+    mpmcDestroy(queue);
+
+    long totalItems = (argc > 1) ? atol(argv[1]) : 1000000;
+    if (totalItems <= 0) {
+        return 0;
+    }
+
+    printf("\n=== Throughput (%ld items per run, %ld CPUs online) ===\n",
+           totalItems, (long)sysconf(_SC_NPROCESSORS_ONLN));
+    runBenchmark(KIND_SPSC, 1, 1, totalItems);
+
+    int configs[][2] = {{1, 1}, {2, 2}, {4, 1}, {1, 4}, {4, 4}};
+    int configCount = sizeof(configs) / sizeof(configs[0]);
+    for (int c = 0; c < configCount; c++) {
+        runBenchmark(KIND_MPMC, configs[c][0], configs[c][1], totalItems);
+    }
+    for (int c = 0; c < configCount; c++) {
+        runBenchmark(KIND_LINKED, configs[c][0], configs[c][1], totalItems);
+    }
+
+    return 0;
+}
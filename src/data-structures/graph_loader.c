@@ -0,0 +1,946 @@
+/*
+ * graph_loader.c - Parallel Edge-List Loader, CSR Builder and Graph Snapshots (see graph_loader.h)
+ */
+
+#define _GNU_SOURCE
+#include "graph_loader.h"
+#include "../concurrency/scheduler.h"
+#include "../profiling/instrument.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PARSE_BLOCK_BYTES (1 << 20)   // text per parse task
+#define EDGE_GRAIN (1 << 16)          // edges per task when splitting binary pairs
+#define CHUNK_EDGES (1 << 16)         // edges per chunk of the CSR build, at least
+#define MAX_CHUNKS 256
+#define BUCKET_ENTRIES (1 << 14)      // entries per bucket of the CSR build, on average
+#define MAX_BUCKETS 1024
+#define INSERTION_SORT_LIMIT 24
+
+#define MAX_VERTEX_ID 0xFFFFFFFEu     // so that largest id + 1 fits in uint32_t
+
+#define SNAPSHOT_MAGIC "CSRGRAPH"
+#define BYTE_ORDER_MARK 0x01020304u
+#define SNAPSHOT_ALIGNMENT 64
+
+static void* allocateArray(size_t count, size_t size) {
+    void* array = malloc((count > 0 ? count : 1) * size);
+    if (array == NULL) {
+        printf("Memory allocation failed\n");
+    }
+    return array;
+}
+
+// ========== Text Parsing ==========
+
+typedef struct {
+    size_t begin;         // byte range [begin, end), cut at line starts
+    size_t end;
+    size_t lineCount;
+    size_t firstLine;     // number of its first line, from 1
+    size_t slot;          // its first edge goes to edges[slot]
+    size_t edgeCount;
+    uint32_t maxId;
+    size_t errorLine;     // 0 = parsed cleanly
+} TextBlock;
+
+typedef struct {
+    const char* text;
+    size_t length;
+    TextBlock* blocks;
+    EdgeList* edges;
+    bool weighted;
+} ParseJob;
+
+static inline bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+static inline const char* skipSeparators(const char* p, const char* end) {
+    while (p < end && isSeparator(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static inline bool parseId(const char** cursor, const char* end, uint32_t* id) {
+    const char* p = *cursor;
+    if (p == end || (unsigned)(*p - '0') > 9) {
+        return false;
+    }
+    uint64_t value = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) {
+        value = value * 10 + (unsigned)(*p - '0');
+        if (value > MAX_VERTEX_ID) {
+            return false;
+        }
+        p++;
+    }
+    *id = (uint32_t)value;
+    *cursor = p;
+    return true;
+}
+
+static inline bool parseWeight(const char** cursor, const char* end, int32_t* weight) {
+    const char* p = *cursor;
+    bool negative = (p < end && *p == '-');
+    p += negative;
+    if (p == end || (unsigned)(*p - '0') > 9) {
+        return false;
+    }
+    int64_t value = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) {
+        value = value * 10 + (*p - '0');
+        if (value > (int64_t)INT32_MAX + negative) {
+            return false;
+        }
+        p++;
+    }
+    *weight = (int32_t)(negative ? -value : value);
+    *cursor = p;
+    return true;
+}
+
+// Returns 1 for an edge, 0 for a blank or comment line, -1 for anything else
+static inline int parseLine(const char* p, const char* end, bool weighted,
+                            uint32_t* source, uint32_t* target, int32_t* weight) {
+    p = skipSeparators(p, end);
+    if (p == end || *p == '#' || *p == '%') {
+        return 0;
+    }
+    if (!parseId(&p, end, source)) {
+        return -1;
+    }
+    p = skipSeparators(p, end);
+    if (!parseId(&p, end, target)) {
+        return -1;
+    }
+    p = skipSeparators(p, end);
+    if (weighted) {
+        if (!parseWeight(&p, end, weight)) {
+            return -1;
+        }
+        p = skipSeparators(p, end);
+    }
+    return (p == end) ? 1 : -1;
+}
+
+// Three fields on the first edge line make the whole text weighted
+static bool detectWeights(const char* text, size_t length) {
+    const char* p = text;
+    const char* end = text + length;
+    while (p < end) {
+        const char* lineEnd = memchr(p, '\n', (size_t)(end - p));
+        if (lineEnd == NULL) {
+            lineEnd = end;
+        }
+        const char* q = skipSeparators(p, lineEnd);
+        if (q < lineEnd && *q != '#' && *q != '%') {
+            int fields = 0;
+            while (q < lineEnd) {
+                fields++;
+                while (q < lineEnd && !isSeparator(*q)) {
+                    q++;
+                }
+                q = skipSeparators(q, lineEnd);
+            }
+            return fields == 3;
+        }
+        p = lineEnd + 1;
+    }
+    return false;
+}
+
+static void countLines(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.countLines");
+    ParseJob* job = arg;
+    for (long b = begin; b < end; b++) {
+        TextBlock* block = &job->blocks[b];
+        const char* p = job->text + block->begin;
+        const char* stop = job->text + block->end;
+        size_t lines = 0;
+        while (p < stop) {
+            const char* newline = memchr(p, '\n', (size_t)(stop - p));
+            lines++;   // a last line without '\n' counts too
+            if (newline == NULL) {
+                break;
+            }
+            p = newline + 1;
+        }
+        block->lineCount = lines;
+    }
+}
+
+static void parseBlocks(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.parseBlocks");
+    ParseJob* job = arg;
+    EdgeList* edges = job->edges;
+    for (long b = begin; b < end; b++) {
+        TextBlock* block = &job->blocks[b];
+        const char* p = job->text + block->begin;
+        const char* stop = job->text + block->end;
+        size_t slot = block->slot;
+        size_t line = block->firstLine;
+        uint32_t maxId = 0;
+        int32_t weight = 0;
+
+        while (p < stop) {
+            const char* newline = memchr(p, '\n', (size_t)(stop - p));
+            const char* lineEnd = (newline != NULL) ? newline : stop;
+            uint32_t source, target;
+            int kind = parseLine(p, lineEnd, job->weighted, &source, &target, &weight);
+            if (kind < 0) {
+                block->errorLine = line;
+                break;
+            }
+            if (kind > 0) {
+                edges->sources[slot] = source;
+                edges->targets[slot] = target;
+                if (edges->weights != NULL) {
+                    edges->weights[slot] = weight;
+                }
+                slot++;
+                maxId = (source > maxId) ? source : maxId;
+                maxId = (target > maxId) ? target : maxId;
+            }
+            line++;
+            p = lineEnd + 1;
+        }
+        block->edgeCount = slot - block->slot;
+        block->maxId = maxId;
+    }
+}
+
+bool edgeListParse(EdgeList* edges, const char* text, size_t length) {
+    PROFILE_SCOPE("graph.edgeListParse");
+    memset(edges, 0, sizeof(*edges));
+    ParseJob job = { .text = text, .length = length, .edges = edges };
+    job.weighted = detectWeights(text, length);
+
+    // Cut at the first line start after each even split point
+    size_t blockCount = length / PARSE_BLOCK_BYTES + 1;
+    job.blocks = calloc(blockCount, sizeof(TextBlock));
+    if (job.blocks == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    size_t position = 0;
+    for (size_t b = 0; b < blockCount; b++) {
+        job.blocks[b].begin = position;
+        size_t split = (b + 1 == blockCount) ? length : (b + 1) * (length / blockCount);
+        if (split > position && split < length) {
+            const char* newline = memchr(text + split - 1, '\n', length - (split - 1));
+            split = (newline != NULL) ? (size_t)(newline - text) + 1 : length;
+        }
+        position = (split > position) ? split : position;
+        job.blocks[b].end = position;
+    }
+
+    // Lines bound the edges in each block, so every block knows its slot
+    // in the arrays before any block is parsed
+    parallelFor(0, (long)blockCount, 1, countLines, &job);
+    size_t lines = 0;
+    for (size_t b = 0; b < blockCount; b++) {
+        job.blocks[b].firstLine = lines + 1;
+        job.blocks[b].slot = lines;
+        lines += job.blocks[b].lineCount;
+    }
+    edges->sources = allocateArray(lines, sizeof(uint32_t));
+    edges->targets = allocateArray(lines, sizeof(uint32_t));
+    edges->weights = job.weighted ? allocateArray(lines, sizeof(int32_t)) : NULL;
+    if (edges->sources == NULL || edges->targets == NULL || (job.weighted && edges->weights == NULL)) {
+        edgeListFree(edges);
+        free(job.blocks);
+        return false;
+    }
+    parallelFor(0, (long)blockCount, 1, parseBlocks, &job);
+
+    // Close the gaps left by blank and comment lines
+    size_t count = 0;
+    uint32_t maxId = 0;
+    for (size_t b = 0; b < blockCount; b++) {
+        TextBlock* block = &job.blocks[b];
+        if (block->errorLine != 0) {
+            printf("Malformed edge on line %zu\n", block->errorLine);
+            edgeListFree(edges);
+            free(job.blocks);
+            return false;
+        }
+        if (block->slot != count && block->edgeCount > 0) {
+            memmove(edges->sources + count, edges->sources + block->slot, block->edgeCount * sizeof(uint32_t));
+            memmove(edges->targets + count, edges->targets + block->slot, block->edgeCount * sizeof(uint32_t));
+            if (edges->weights != NULL) {
+                memmove(edges->weights + count, edges->weights + block->slot, block->edgeCount * sizeof(int32_t));
+            }
+        }
+        count += block->edgeCount;
+        maxId = (block->edgeCount > 0 && block->maxId > maxId) ? block->maxId : maxId;
+    }
+    edges->count = count;
+    edges->vertexCount = (count > 0) ? maxId + 1 : 0;
+    free(job.blocks);
+    return true;
+}
+
+// Maps a whole file read-only; an empty file gives a NULL mapping
+static bool mapFile(const char* path, int* fd, void** map, size_t* size) {
+    *fd = open(path, O_RDONLY);
+    if (*fd < 0) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(*fd, &info) != 0) {
+        printf("Cannot open %s\n", path);
+        close(*fd);
+        return false;
+    }
+    *size = (size_t)info.st_size;
+    *map = NULL;
+    if (*size > 0) {
+        *map = mmap(NULL, *size, PROT_READ, MAP_SHARED, *fd, 0);
+        if (*map == MAP_FAILED) {
+            printf("Cannot map %s\n", path);
+            close(*fd);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void unmapFile(int fd, void* map, size_t size) {
+    if (map != NULL) {
+        munmap(map, size);
+    }
+    close(fd);
+}
+
+bool edgeListLoadText(EdgeList* edges, const char* path) {
+    int fd;
+    void* map;
+    size_t size;
+    if (!mapFile(path, &fd, &map, &size)) {
+        memset(edges, 0, sizeof(*edges));
+        return false;
+    }
+    bool ok = edgeListParse(edges, (const char*)map, size);
+    unmapFile(fd, map, size);
+    return ok;
+}
+
+// ========== Binary Edge Lists ==========
+
+typedef struct {
+    const uint32_t* pairs;
+    EdgeList* edges;
+    _Atomic uint32_t maxId;
+    atomic_bool invalid;
+} SplitJob;
+
+static void splitPairs(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.splitPairs");
+    SplitJob* job = arg;
+    uint32_t maxId = 0;
+    for (long i = begin; i < end; i++) {
+        uint32_t source = job->pairs[2 * i];
+        uint32_t target = job->pairs[2 * i + 1];
+        job->edges->sources[i] = source;
+        job->edges->targets[i] = target;
+        maxId = (source > maxId) ? source : maxId;
+        maxId = (target > maxId) ? target : maxId;
+    }
+    if (maxId > MAX_VERTEX_ID) {
+        atomic_store_explicit(&job->invalid, true, memory_order_relaxed);
+    }
+    uint32_t seen = atomic_load_explicit(&job->maxId, memory_order_relaxed);
+    while (maxId > seen &&
+           !atomic_compare_exchange_weak_explicit(&job->maxId, &seen, maxId,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+bool edgeListLoadBinary(EdgeList* edges, const char* path) {
+    memset(edges, 0, sizeof(*edges));
+    int fd;
+    void* map;
+    size_t size;
+    if (!mapFile(path, &fd, &map, &size)) {
+        return false;
+    }
+    if (size % (2 * sizeof(uint32_t)) != 0) {
+        printf("%s is not a list of uint32 pairs\n", path);
+        unmapFile(fd, map, size);
+        return false;
+    }
+    size_t count = size / (2 * sizeof(uint32_t));
+    edges->sources = allocateArray(count, sizeof(uint32_t));
+    edges->targets = allocateArray(count, sizeof(uint32_t));
+    if (edges->sources == NULL || edges->targets == NULL) {
+        edgeListFree(edges);
+        unmapFile(fd, map, size);
+        return false;
+    }
+
+    SplitJob job = { .pairs = map, .edges = edges };
+    atomic_init(&job.maxId, 0);
+    atomic_init(&job.invalid, false);
+    parallelFor(0, (long)count, EDGE_GRAIN, splitPairs, &job);
+    unmapFile(fd, map, size);
+    if (atomic_load(&job.invalid)) {
+        printf("%s has a vertex id above %u\n", path, MAX_VERTEX_ID);
+        edgeListFree(edges);
+        return false;
+    }
+    edges->count = count;
+    edges->vertexCount = (count > 0) ? atomic_load(&job.maxId) + 1 : 0;
+    return true;
+}
+
+void edgeListFree(EdgeList* edges) {
+    free(edges->sources);
+    free(edges->targets);
+    free(edges->weights);
+    memset(edges, 0, sizeof(*edges));
+}
+
+// ========== CSR Construction ==========
+//
+// Scattering every edge straight into its row is a random write per edge,
+// and once the rows outgrow the cache nearly every write is a cache miss.
+// The counting sort runs in two levels instead:
+//
+//   1. the edges are cut into chunks; each chunk counts its entries per
+//      bucket, a bucket being 2^bucketShift consecutive source vertices
+//   2. each chunk copies its entries into the staging area of their bucket,
+//      at most MAX_BUCKETS sequential write streams
+//   3. each bucket, small enough to stay in cache, counts its row lengths,
+//      moves its entries into their rows and sorts the rows if asked
+//
+// The chunk x bucket counts give every chunk its own write position in
+// every bucket, so no step needs atomics and the result does not depend on
+// how the work was scheduled.
+
+typedef struct {
+    const EdgeList* edges;
+    unsigned flags;
+    size_t vertexCount;
+    unsigned bucketShift;
+    size_t bucketCount;
+    size_t chunkCount;
+    size_t chunkEdges;
+    uint64_t* cursors;         // [chunk][bucket]: entry counts, then the next staging slot
+    uint64_t* bucketStarts;    // bucketCount + 1 entries
+    uint64_t* bucketKept;      // entries left in each bucket after deduplication
+    uint32_t* sources;         // staging: the row of each entry
+    uint64_t* offsets;
+    uint32_t* targets;         // staging area first, then the rows
+    int32_t* weights;
+    atomic_bool failed;
+} BuildJob;
+
+static inline bool keepEdge(const BuildJob* job, uint32_t source, uint32_t target) {
+    return source != target || !(job->flags & GRAPH_REMOVE_SELF_LOOPS);
+}
+
+// A self-loop has no separate reverse edge
+static inline bool addReverse(const BuildJob* job, uint32_t source, uint32_t target) {
+    return (job->flags & GRAPH_SYMMETRIZE) && source != target;
+}
+
+static void countBuckets(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.countBuckets");
+    BuildJob* job = arg;
+    const uint32_t* sources = job->edges->sources;
+    const uint32_t* targets = job->edges->targets;
+    for (long c = begin; c < end; c++) {
+        uint64_t* counts = job->cursors + (size_t)c * job->bucketCount;
+        size_t first = (size_t)c * job->chunkEdges;
+        size_t last = (first + job->chunkEdges < job->edges->count) ? first + job->chunkEdges : job->edges->count;
+        for (size_t i = first; i < last; i++) {
+            uint32_t source = sources[i], target = targets[i];
+            if (!keepEdge(job, source, target)) {
+                continue;
+            }
+            counts[source >> job->bucketShift]++;
+            if (addReverse(job, source, target)) {
+                counts[target >> job->bucketShift]++;
+            }
+        }
+    }
+}
+
+static inline void stageEntry(BuildJob* job, uint64_t* cursors, uint32_t source, uint32_t target,
+                              const int32_t* weights, size_t i) {
+    uint64_t slot = cursors[source >> job->bucketShift]++;
+    job->sources[slot] = source;
+    job->targets[slot] = target;
+    if (weights != NULL) {
+        job->weights[slot] = weights[i];
+    }
+}
+
+static void stageEdges(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.stageEdges");
+    BuildJob* job = arg;
+    const uint32_t* sources = job->edges->sources;
+    const uint32_t* targets = job->edges->targets;
+    const int32_t* weights = job->edges->weights;
+    for (long c = begin; c < end; c++) {
+        uint64_t* cursors = job->cursors + (size_t)c * job->bucketCount;
+        size_t first = (size_t)c * job->chunkEdges;
+        size_t last = (first + job->chunkEdges < job->edges->count) ? first + job->chunkEdges : job->edges->count;
+        for (size_t i = first; i < last; i++) {
+            uint32_t source = sources[i], target = targets[i];
+            if (!keepEdge(job, source, target)) {
+                continue;
+            }
+            stageEntry(job, cursors, source, target, weights, i);
+            if (addReverse(job, source, target)) {
+                stageEntry(job, cursors, target, source, weights, i);
+            }
+        }
+    }
+}
+
+// Row entries are sorted as (target << 32 | biased weight); the bias makes
+// signed weights order correctly as unsigned
+static inline uint64_t entryKey(uint32_t target, const int32_t* weights, size_t i) {
+    uint64_t key = (uint64_t)target << 32;
+    return (weights != NULL) ? key | ((uint32_t)weights[i] ^ 0x80000000u) : key;
+}
+
+static inline void swapKeys(uint64_t* keys, size_t i, size_t j) {
+    uint64_t key = keys[i];
+    keys[i] = keys[j];
+    keys[j] = key;
+}
+
+// Quicksort with insertion sort for short ranges: most rows are short
+static void sortKeys(uint64_t* keys, size_t count) {
+    while (count > INSERTION_SORT_LIMIT) {
+        size_t middle = count / 2, last = count - 1;
+        // Median of three moved to the front as the pivot
+        if (keys[middle] < keys[0]) {
+            swapKeys(keys, middle, 0);
+        }
+        if (keys[last] < keys[0]) {
+            swapKeys(keys, last, 0);
+        }
+        if (keys[last] < keys[middle]) {
+            swapKeys(keys, last, middle);
+        }
+        swapKeys(keys, 0, middle);
+        uint64_t pivot = keys[0];
+
+        size_t i = 0, j = count;
+        for (;;) {
+            do { i++; } while (i < count && keys[i] < pivot);
+            do { j--; } while (keys[j] > pivot);
+            if (i >= j) {
+                break;
+            }
+            swapKeys(keys, i, j);
+        }
+        keys[0] = keys[j];
+        keys[j] = pivot;
+
+        // Recurse into the smaller side, loop on the larger
+        if (j < count - j - 1) {
+            sortKeys(keys, j);
+            keys += j + 1;
+            count -= j + 1;
+        } else {
+            sortKeys(keys + j + 1, count - j - 1);
+            count = j;
+        }
+    }
+    for (size_t i = 1; i < count; i++) {
+        uint64_t key = keys[i];
+        size_t j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+typedef struct {
+    uint64_t* keys;
+    size_t capacity;
+} BucketScratch;
+
+// Counting sort of one bucket into its rows, written back over the bucket's
+// staging area. offsets[v] is written for the bucket's own vertices only;
+// the row of its last vertex ends where the bucket's entries end. With
+// GRAPH_DEDUPLICATE the rows come out packed to the front of the bucket.
+static bool sortBucket(BuildJob* job, size_t bucket, BucketScratch* scratch) {
+    size_t firstVertex = bucket << job->bucketShift;
+    size_t lastVertex = ((bucket + 1) << job->bucketShift < job->vertexCount)
+                        ? (bucket + 1) << job->bucketShift : job->vertexCount;
+    uint64_t start = job->bucketStarts[bucket];
+    size_t count = (size_t)(job->bucketStarts[bucket + 1] - start);
+    uint64_t* offsets = job->offsets;
+    if (count > scratch->capacity) {
+        free(scratch->keys);
+        scratch->keys = malloc(count * sizeof(uint64_t));
+        scratch->capacity = (scratch->keys != NULL) ? count : 0;
+        if (scratch->keys == NULL) {
+            return false;
+        }
+    }
+    uint64_t* keys = scratch->keys;
+    const uint32_t* sources = job->sources + start;
+    const uint32_t* targets = job->targets + start;
+    const int32_t* weights = (job->weights != NULL) ? job->weights + start : NULL;
+
+    // Row lengths, then row starts within the bucket
+    for (size_t v = firstVertex; v < lastVertex; v++) {
+        offsets[v] = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        offsets[sources[i]]++;
+    }
+    uint64_t position = 0;
+    for (size_t v = firstVertex; v < lastVertex; v++) {
+        uint64_t length = offsets[v];
+        offsets[v] = position;
+        position += length;
+    }
+    for (size_t i = 0; i < count; i++) {
+        keys[offsets[sources[i]]++] = entryKey(targets[i], weights, i);
+    }
+
+    // offsets[v] is now where row v ends. Sort each row if asked and write
+    // it back; the output never passes the keys still to be read.
+    bool deduplicate = (job->flags & GRAPH_DEDUPLICATE) != 0;
+    bool sort = deduplicate || (job->flags & GRAPH_SORT_ROWS);
+    uint64_t rowStart = 0, written = start;
+    for (size_t v = firstVertex; v < lastVertex; v++) {
+        uint64_t rowEnd = offsets[v];
+        if (sort) {
+            sortKeys(keys + rowStart, (size_t)(rowEnd - rowStart));
+        }
+        offsets[v] = written;
+        for (uint64_t i = rowStart; i < rowEnd; i++) {
+            uint32_t target = (uint32_t)(keys[i] >> 32);
+            // After sorting, the first entry of a target has the smallest weight
+            if (deduplicate && written > offsets[v] && job->targets[written - 1] == target) {
+                continue;
+            }
+            job->targets[written] = target;
+            if (job->weights != NULL) {
+                job->weights[written] = (int32_t)((uint32_t)keys[i] ^ 0x80000000u);
+            }
+            written++;
+        }
+        rowStart = rowEnd;
+    }
+    job->bucketKept[bucket] = written - start;
+    return true;
+}
+
+static void sortBuckets(long begin, long end, void* arg) {
+    PROFILE_SCOPE("graph.sortBuckets");
+    BuildJob* job = arg;
+    BucketScratch scratch = { NULL, 0 };
+    for (long b = begin; b < end; b++) {
+        if (!sortBucket(job, (size_t)b, &scratch)) {
+            atomic_store_explicit(&job->failed, true, memory_order_relaxed);
+            break;
+        }
+    }
+    free(scratch.keys);
+}
+
+// Moves the deduplicated buckets together; buckets only move towards the
+// front, so one pass in bucket order never overwrites one not yet moved
+static uint64_t packBuckets(BuildJob* job) {
+    uint64_t packed = 0;
+    for (size_t b = 0; b < job->bucketCount; b++) {
+        uint64_t start = job->bucketStarts[b], kept = job->bucketKept[b];
+        if (start != packed) {
+            memmove(job->targets + packed, job->targets + start, kept * sizeof(uint32_t));
+            if (job->weights != NULL) {
+                memmove(job->weights + packed, job->weights + start, kept * sizeof(int32_t));
+            }
+            size_t firstVertex = b << job->bucketShift;
+            size_t lastVertex = ((b + 1) << job->bucketShift < job->vertexCount)
+                                ? (b + 1) << job->bucketShift : job->vertexCount;
+            for (size_t v = firstVertex; v < lastVertex; v++) {
+                job->offsets[v] -= start - packed;
+            }
+        }
+        packed += kept;
+    }
+    // Shrinking never fails in practice; keep the larger block if it does
+    uint32_t* targets = realloc(job->targets, (packed > 0 ? packed : 1) * sizeof(uint32_t));
+    job->targets = (targets != NULL) ? targets : job->targets;
+    if (job->weights != NULL) {
+        int32_t* weights = realloc(job->weights, (packed > 0 ? packed : 1) * sizeof(int32_t));
+        job->weights = (weights != NULL) ? weights : job->weights;
+    }
+    return packed;
+}
+
+// The smallest buckets that hold BUCKET_ENTRIES entries on average, with
+// at most MAX_BUCKETS of them; chunks of CHUNK_EDGES edges, at most
+// MAX_CHUNKS of them
+static void planBuckets(BuildJob* job) {
+    size_t vertices = job->vertexCount;
+    size_t entries = job->edges->count * ((job->flags & GRAPH_SYMMETRIZE) ? 2 : 1);
+    job->bucketShift = 0;
+    job->bucketCount = vertices;
+    while (job->bucketCount > 1 && job->bucketShift < 31 &&
+           (job->bucketCount > MAX_BUCKETS || entries / job->bucketCount < BUCKET_ENTRIES)) {
+        job->bucketShift++;
+        job->bucketCount = ((vertices - 1) >> job->bucketShift) + 1;
+    }
+
+    size_t count = job->edges->count;
+    job->chunkEdges = (count / MAX_CHUNKS >= CHUNK_EDGES) ? count / MAX_CHUNKS + 1 : CHUNK_EDGES;
+    job->chunkCount = (count + job->chunkEdges - 1) / job->chunkEdges;
+}
+
+bool csrBuild(CsrGraph* graph, const EdgeList* edges, unsigned flags) {
+    PROFILE_SCOPE("graph.csrBuild");
+    memset(graph, 0, sizeof(*graph));
+    BuildJob job = { .edges = edges, .flags = flags, .vertexCount = edges->vertexCount };
+    atomic_init(&job.failed, false);
+    planBuckets(&job);
+    job.cursors = calloc(job.chunkCount * job.bucketCount + 1, sizeof(uint64_t));
+    job.bucketStarts = allocateArray(job.bucketCount + 1, sizeof(uint64_t));
+    job.bucketKept = allocateArray(job.bucketCount, sizeof(uint64_t));
+    job.offsets = allocateArray(job.vertexCount + 1, sizeof(uint64_t));
+    bool ok = job.cursors != NULL && job.bucketStarts != NULL && job.bucketKept != NULL && job.offsets != NULL;
+    if (job.cursors == NULL) {
+        printf("Memory allocation failed\n");
+    }
+
+    uint64_t total = 0;
+    if (ok) {
+        parallelFor(0, (long)job.chunkCount, 1, countBuckets, &job);
+        // Bucket by bucket, chunk by chunk: each chunk's slots in each bucket
+        for (size_t b = 0; b < job.bucketCount; b++) {
+            job.bucketStarts[b] = total;
+            for (size_t c = 0; c < job.chunkCount; c++) {
+                uint64_t count = job.cursors[c * job.bucketCount + b];
+                job.cursors[c * job.bucketCount + b] = total;
+                total += count;
+            }
+        }
+        job.bucketStarts[job.bucketCount] = total;
+        job.sources = allocateArray(total, sizeof(uint32_t));
+        job.targets = allocateArray(total, sizeof(uint32_t));
+        job.weights = (edges->weights != NULL) ? allocateArray(total, sizeof(int32_t)) : NULL;
+        ok = job.sources != NULL && job.targets != NULL && (edges->weights == NULL || job.weights != NULL);
+    }
+    if (ok) {
+        parallelFor(0, (long)job.chunkCount, 1, stageEdges, &job);
+        free(job.cursors);
+        job.cursors = NULL;
+        parallelFor(0, (long)job.bucketCount, 1, sortBuckets, &job);
+        ok = !atomic_load(&job.failed);
+        if (!ok) {
+            printf("Memory allocation failed\n");
+        }
+    }
+    if (ok && (flags & GRAPH_DEDUPLICATE)) {
+        total = packBuckets(&job);
+    }
+    free(job.cursors);
+    free(job.bucketStarts);
+    free(job.bucketKept);
+    free(job.sources);
+    if (!ok) {
+        free(job.offsets);
+        free(job.targets);
+        free(job.weights);
+        return false;
+    }
+
+    job.offsets[job.vertexCount] = total;
+    graph->vertexCount = (uint32_t)job.vertexCount;
+    graph->edgeCount = total;
+    graph->offsets = job.offsets;
+    graph->targets = job.targets;
+    graph->weights = job.weights;
+    return true;
+}
+
+void csrFree(CsrGraph* graph) {
+    if (graph->mapping != NULL) {
+        munmap(graph->mapping, graph->mappingSize);
+    } else {
+        free((void*)graph->offsets);
+        free((void*)graph->targets);
+        free((void*)graph->weights);
+    }
+    memset(graph, 0, sizeof(*graph));
+}
+
+// ========== Snapshots ==========
+//
+//   SnapshotHeader | offsets[vertexCount + 1] | targets[edgeCount] | weights[edgeCount]
+//
+// Each array starts on a 64-byte boundary. Only the header is checksummed:
+// checking the arrays would mean reading all of them on open.
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t vertexCount;
+    uint64_t edgeCount;
+    uint64_t offsetsOffset;
+    uint64_t targetsOffset;
+    uint64_t weightsOffset;   // 0 = unweighted
+    uint64_t fileSize;
+    uint64_t checksum;        // of the fields above
+} SnapshotHeader;
+
+// FNV-1a over 64 bits
+static uint64_t checksumBytes(const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// pwrite until everything is written: it may write less than asked
+static bool writeAt(int fd, const void* data, size_t length, uint64_t offset) {
+    const uint8_t* bytes = data;
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Write failed\n");
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+    return true;
+}
+
+bool csrSave(const CsrGraph* graph, const char* path) {
+    SnapshotHeader header = { .version = CSR_SNAPSHOT_VERSION, .byteOrder = BYTE_ORDER_MARK,
+                              .vertexCount = graph->vertexCount, .edgeCount = graph->edgeCount };
+    memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+    header.offsetsOffset = alignUp(sizeof(header), SNAPSHOT_ALIGNMENT);
+    header.targetsOffset = alignUp(header.offsetsOffset + (graph->vertexCount + 1ull) * sizeof(uint64_t),
+                                   SNAPSHOT_ALIGNMENT);
+    header.fileSize = header.targetsOffset + graph->edgeCount * sizeof(uint32_t);
+    if (graph->weights != NULL) {
+        header.weightsOffset = alignUp(header.fileSize, SNAPSHOT_ALIGNMENT);
+        header.fileSize = header.weightsOffset + graph->edgeCount * sizeof(int32_t);
+    }
+    header.checksum = checksumBytes(&header, offsetof(SnapshotHeader, checksum));
+
+    size_t length = strlen(path);
+    char* temporary = malloc(length + 5);
+    if (temporary == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", 5);
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Cannot create %s\n", temporary);
+        free(temporary);
+        return false;
+    }
+
+    bool ok = ftruncate(fd, (off_t)header.fileSize) == 0 &&
+              writeAt(fd, &header, sizeof(header), 0) &&
+              writeAt(fd, graph->offsets, (graph->vertexCount + 1ull) * sizeof(uint64_t), header.offsetsOffset) &&
+              writeAt(fd, graph->targets, graph->edgeCount * sizeof(uint32_t), header.targetsOffset) &&
+              (graph->weights == NULL ||
+               writeAt(fd, graph->weights, graph->edgeCount * sizeof(int32_t), header.weightsOffset)) &&
+              fdatasync(fd) == 0;
+    close(fd);
+    if (ok && rename(temporary, path) != 0) {
+        printf("Cannot rename %s to %s\n", temporary, path);
+        ok = false;
+    }
+    if (!ok) {
+        remove(temporary);
+    }
+    free(temporary);
+    return ok;
+}
+
+bool csrOpenSnapshot(CsrGraph* graph, const char* path) {
+    PROFILE_SCOPE("graph.openSnapshot");
+    memset(graph, 0, sizeof(*graph));
+    int fd;
+    void* map;
+    size_t size;
+    if (!mapFile(path, &fd, &map, &size)) {
+        return false;
+    }
+    close(fd);   // the mapping stays valid
+
+    const SnapshotHeader* header = map;
+    uint64_t vertexCount = 0, edgeCount = 0;
+    bool valid = size >= sizeof(SnapshotHeader) &&
+                 memcmp(header->magic, SNAPSHOT_MAGIC, 8) == 0 &&
+                 header->version == CSR_SNAPSHOT_VERSION && header->byteOrder == BYTE_ORDER_MARK &&
+                 header->checksum == checksumBytes(header, offsetof(SnapshotHeader, checksum)) &&
+                 header->fileSize == size;
+    if (valid) {
+        vertexCount = header->vertexCount;
+        edgeCount = header->edgeCount;
+        valid = vertexCount <= MAX_VERTEX_ID + 1ull &&
+                header->offsetsOffset % SNAPSHOT_ALIGNMENT == 0 &&
+                header->targetsOffset % SNAPSHOT_ALIGNMENT == 0 &&
+                header->weightsOffset % SNAPSHOT_ALIGNMENT == 0 &&
+                header->offsetsOffset >= sizeof(SnapshotHeader) &&
+                header->offsetsOffset + (vertexCount + 1) * sizeof(uint64_t) <= header->targetsOffset &&
+                header->targetsOffset + edgeCount * sizeof(uint32_t) <= size &&
+                (header->weightsOffset == 0 ||
+                 (header->weightsOffset >= header->targetsOffset + edgeCount * sizeof(uint32_t) &&
+                  header->weightsOffset + edgeCount * sizeof(int32_t) <= size));
+    }
+    // The last offset must close the last row: one more page touched
+    if (valid) {
+        const uint64_t* offsets = (const uint64_t*)((const char*)map + header->offsetsOffset);
+        valid = offsets[0] == 0 && offsets[vertexCount] == edgeCount;
+    }
+    if (!valid) {
+        printf("%s is not a version %d graph snapshot of this byte order\n", path, CSR_SNAPSHOT_VERSION);
+        if (map != NULL) {
+            munmap(map, size);
+        }
+        return false;
+    }
+
+    const char* base = map;
+    graph->vertexCount = (uint32_t)vertexCount;
+    graph->edgeCount = edgeCount;
+    graph->offsets = (const uint64_t*)(base + header->offsetsOffset);
+    graph->targets = (const uint32_t*)(base + header->targetsOffset);
+    graph->weights = (header->weightsOffset != 0) ? (const int32_t*)(base + header->weightsOffset) : NULL;
+    graph->mapping = map;
+    graph->mappingSize = size;
+    return true;
+}
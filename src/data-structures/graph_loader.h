@@ -0,0 +1,97 @@
+/*
+ * graph_loader.h - Parallel Edge-List Loader, CSR Builder and Graph Snapshots
+ *
+ * docs/11-data-structures/04-graphs.md builds graphs one edge at a time:
+ * addEdge() writes into a V x V int matrix, and addEdgeList() mallocs one
+ * AdjListNode per edge and direction. For graphs with 100M edges that is
+ * gigabytes of scattered nodes, and loading takes longer than the queries.
+ * This module:
+ *
+ * - parses edge-list text ("u v" or "u v weight" per line) in parallel:
+ *   the text is cut into blocks at line boundaries, each block counts its
+ *   lines, then each block parses straight into its slot of the edge arrays
+ * - also reads binary edge lists (pairs of uint32 ids)
+ * - builds compressed sparse row (CSR) form with a parallel counting sort
+ *   by source vertex, in two levels so that the scattered writes stay in
+ *   cache (see graph_loader.c)
+ * - can add the reverse of every edge (undirected graphs), sort each row,
+ *   drop duplicate edges and drop self-loops while building
+ * - saves a CSR graph as a binary snapshot that csrOpenSnapshot() maps
+ *   back with mmap(2) without reading or parsing it
+ *
+ * The parallel steps run on ../concurrency/scheduler.h when it is
+ * initialized (serially when not). Vertex ids are 0 .. 2^32 - 2.
+ *
+ * Text format: fields separated by spaces, tabs or commas; lines starting
+ * with '#' or '%' and blank lines are skipped; "\r\n" line ends are
+ * accepted. The file is weighted if its first edge has three fields, and
+ * then every edge must have a weight.
+ *
+ * Compile together with graph_loader.c and the scheduler:
+ *   gcc -O2 -pthread -o program program.c graph_loader.c ../concurrency/scheduler.c
+ *
+ * With -DINSTRUMENT and ../profiling/instrument.c, every parse and build
+ * phase is timed per task (see ../profiling/instrument.h).
+ */
+
+#ifndef GRAPH_LOADER_H
+#define GRAPH_LOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CSR_SNAPSHOT_VERSION 1
+
+// Edge i goes from sources[i] to targets[i]
+typedef struct {
+    uint32_t* sources;
+    uint32_t* targets;
+    int32_t* weights;        // NULL when the input has no weights
+    size_t count;
+    uint32_t vertexCount;    // largest id + 1
+} EdgeList;
+
+typedef enum {
+    GRAPH_SYMMETRIZE = 1 << 0,          // add v -> u for every u -> v
+    GRAPH_SORT_ROWS = 1 << 1,           // neighbours in increasing order (then by weight)
+    GRAPH_DEDUPLICATE = 1 << 2,         // one u -> v per pair, with the smallest weight; sorts rows
+    GRAPH_REMOVE_SELF_LOOPS = 1 << 3    // drop v -> v
+} GraphBuildFlags;
+
+// The neighbours of v are targets[offsets[v]] .. targets[offsets[v + 1] - 1].
+// Unless sorted, a row lists its edges in input order, the reverse of edge
+// i (with GRAPH_SYMMETRIZE) in the place of edge i. The result does not
+// depend on the number of workers.
+typedef struct {
+    uint32_t vertexCount;
+    uint64_t edgeCount;
+    const uint64_t* offsets;     // vertexCount + 1 entries
+    const uint32_t* targets;
+    const int32_t* weights;      // NULL for unweighted graphs
+    void* mapping;               // the snapshot, when opened with csrOpenSnapshot()
+    size_t mappingSize;
+} CsrGraph;
+
+// ========== Edge Lists ==========
+
+bool edgeListParse(EdgeList* edges, const char* text, size_t length);
+bool edgeListLoadText(EdgeList* edges, const char* path);
+bool edgeListLoadBinary(EdgeList* edges, const char* path);
+void edgeListFree(EdgeList* edges);
+
+// ========== CSR Graphs ==========
+
+// flags: GraphBuildFlags combined with |
+bool csrBuild(CsrGraph* graph, const EdgeList* edges, unsigned flags);
+void csrFree(CsrGraph* graph);
+
+static inline uint64_t csrDegree(const CsrGraph* graph, uint32_t vertex) {
+    return graph->offsets[vertex + 1] - graph->offsets[vertex];
+}
+
+// Snapshots are written under a temporary name and renamed into place
+bool csrSave(const CsrGraph* graph, const char* path);
+bool csrOpenSnapshot(CsrGraph* graph, const char* path);
+
+#endif
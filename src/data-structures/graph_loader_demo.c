@@ -0,0 +1,584 @@
+/*
+ * Graph Loader Demo: Edge Lists into CSR Instead of addEdgeList
+ *
+ * Loads the weighted example graph of docs/11-data-structures/04-graphs.md
+ * from edge-list text, checks the parser, the CSR builder (every
+ * combination of symmetrize, sort, deduplicate and self-loop removal) and
+ * snapshots against simple references, then loads a random graph of N
+ * million edges with fscanf + addEdgeList as in the docs and with the
+ * parallel loader. Each loader runs in a freshly exec'd copy of this
+ * program, which reports its own VmHWM (peak resident memory) from
+ * /proc/self/status. A plain fork() would not do: the child shares every
+ * page the parent has touched, and those count toward its resident size.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o graph_loader_demo graph_loader_demo.c graph_loader.c ../concurrency/scheduler.c
+ *   ./graph_loader_demo [millions of edges] [workers, 0 = one per CPU]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "graph_loader.h"
+#include "../concurrency/scheduler.h"
+
+#define DEMO_TEXT "graph_loader_demo.txt"
+#define DEMO_BINARY "graph_loader_demo.bin"
+#define DEMO_SNAPSHOT "graph_loader_demo.csr"
+#define LOADER_FLAG "--run-loader"   // argv[1] of the child processes
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== Adjacency List from the Docs ==========
+
+typedef struct AdjListNode {
+    int dest;
+    int weight;
+    struct AdjListNode* next;
+} AdjListNode;
+
+typedef struct {
+    AdjListNode* head;
+} AdjList;
+
+typedef struct {
+    int vertices;
+    AdjList* array;
+    bool directed;
+} GraphList;
+
+static AdjListNode* createAdjListNode(int dest, int weight) {
+    AdjListNode* newNode = (AdjListNode*)malloc(sizeof(AdjListNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    newNode->dest = dest;
+    newNode->weight = weight;
+    newNode->next = NULL;
+    return newNode;
+}
+
+static GraphList* createGraphList(int vertices, bool directed) {
+    GraphList* graph = (GraphList*)malloc(sizeof(GraphList));
+    if (graph == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    graph->vertices = vertices;
+    graph->directed = directed;
+    graph->array = (AdjList*)malloc(vertices * sizeof(AdjList));
+    if (graph->array == NULL) {
+        printf("Memory allocation failed\n");
+        free(graph);
+        return NULL;
+    }
+    for (int i = 0; i < vertices; i++) {
+        graph->array[i].head = NULL;
+    }
+    return graph;
+}
+
+static void addEdgeList(GraphList* graph, int src, int dest, int weight) {
+    if (src >= 0 && src < graph->vertices &&
+        dest >= 0 && dest < graph->vertices) {
+        AdjListNode* newNode = createAdjListNode(dest, weight);
+        newNode->next = graph->array[src].head;
+        graph->array[src].head = newNode;
+        if (!graph->directed) {
+            newNode = createAdjListNode(src, weight);
+            newNode->next = graph->array[dest].head;
+            graph->array[dest].head = newNode;
+        }
+    }
+}
+
+static void freeGraphList(GraphList* graph) {
+    for (int i = 0; i < graph->vertices; i++) {
+        AdjListNode* current = graph->array[i].head;
+        while (current != NULL) {
+            AdjListNode* temp = current;
+            current = current->next;
+            free(temp);
+        }
+    }
+    free(graph->array);
+    free(graph);
+}
+
+static void printCsr(const CsrGraph* graph) {
+    printf("Adjacency List:\n");
+    for (uint32_t v = 0; v < graph->vertexCount; v++) {
+        printf("Vertex %u: ", v);
+        for (uint64_t e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+            printf("-> %u (w:%d) ", graph->targets[e], graph->weights[e]);
+        }
+        printf("\n");
+    }
+}
+
+// ========== Checks ==========
+
+typedef struct {
+    uint32_t source;
+    uint32_t target;
+    int32_t weight;
+    size_t order;   // 0 when sorting rows, else the position in the input
+} Edge;
+
+static int compareEdges(const void* a, const void* b) {
+    const Edge* x = a;
+    const Edge* y = b;
+    if (x->source != y->source) {
+        return x->source < y->source ? -1 : 1;
+    }
+    if (x->order != y->order) {
+        return x->order < y->order ? -1 : 1;
+    }
+    if (x->target != y->target) {
+        return x->target < y->target ? -1 : 1;
+    }
+    return (x->weight > y->weight) - (x->weight < y->weight);
+}
+
+// What csrBuild() should produce, by sorting a copy of every edge
+static bool matchesReference(const CsrGraph* graph, const EdgeList* edges, unsigned flags) {
+    Edge* all = malloc((2 * edges->count + 1) * sizeof(Edge));
+    if (all == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    bool sorted = (flags & (GRAPH_SORT_ROWS | GRAPH_DEDUPLICATE)) != 0;
+    size_t count = 0;
+    for (size_t i = 0; i < edges->count; i++) {
+        uint32_t source = edges->sources[i], target = edges->targets[i];
+        int32_t weight = (edges->weights != NULL) ? edges->weights[i] : 0;
+        if (source == target && (flags & GRAPH_REMOVE_SELF_LOOPS)) {
+            continue;
+        }
+        all[count++] = (Edge){ source, target, weight, sorted ? 0 : i };
+        if ((flags & GRAPH_SYMMETRIZE) && source != target) {
+            all[count++] = (Edge){ target, source, weight, sorted ? 0 : i };
+        }
+    }
+    qsort(all, count, sizeof(Edge), compareEdges);
+    if (flags & GRAPH_DEDUPLICATE) {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (kept == 0 || all[i].source != all[kept - 1].source || all[i].target != all[kept - 1].target) {
+                all[kept++] = all[i];
+            }
+        }
+        count = kept;
+    }
+
+    bool ok = graph->vertexCount == edges->vertexCount && graph->edgeCount == count &&
+              (graph->weights != NULL) == (edges->weights != NULL) && graph->offsets[0] == 0;
+    for (uint32_t v = 0; ok && v < graph->vertexCount; v++) {
+        for (uint64_t e = graph->offsets[v]; ok && e < graph->offsets[v + 1]; e++) {
+            ok = e < count && all[e].source == v && all[e].target == graph->targets[e] &&
+                 (graph->weights == NULL || all[e].weight == graph->weights[e]);
+        }
+    }
+    ok = ok && graph->offsets[graph->vertexCount] == count;
+    free(all);
+    return ok;
+}
+
+static bool sameGraph(const CsrGraph* a, const CsrGraph* b) {
+    return a->vertexCount == b->vertexCount && a->edgeCount == b->edgeCount &&
+           (a->weights != NULL) == (b->weights != NULL) &&
+           memcmp(a->offsets, b->offsets, (a->vertexCount + 1ull) * sizeof(uint64_t)) == 0 &&
+           memcmp(a->targets, b->targets, a->edgeCount * sizeof(uint32_t)) == 0 &&
+           (a->weights == NULL || memcmp(a->weights, b->weights, a->edgeCount * sizeof(int32_t)) == 0);
+}
+
+static bool parsesTo(const char* text, size_t count, const uint32_t* pairs, const int32_t* weights) {
+    EdgeList edges;
+    if (!edgeListParse(&edges, text, strlen(text))) {
+        return false;
+    }
+    uint32_t maxId = 0;
+    bool ok = edges.count == count && (edges.weights != NULL) == (weights != NULL);
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = edges.sources[i] == pairs[2 * i] && edges.targets[i] == pairs[2 * i + 1] &&
+             (weights == NULL || edges.weights[i] == weights[i]);
+        maxId = pairs[2 * i] > maxId ? pairs[2 * i] : maxId;
+        maxId = pairs[2 * i + 1] > maxId ? pairs[2 * i + 1] : maxId;
+    }
+    ok = ok && edges.vertexCount == (count > 0 ? maxId + 1 : 0);
+    edgeListFree(&edges);
+    return ok;
+}
+
+static bool checkParser(void) {
+    const uint32_t plain[] = { 0, 1, 2, 3, 4, 5 };
+    const uint32_t weighted[] = { 0, 1, 1, 2 };
+    const int32_t weights[] = { -5, 2147483647 };
+    bool ok = parsesTo("# comment\n\n0 1\r\n  2,3\n% another\n4\t5", 3, plain, NULL) &&
+              parsesTo("0 1 -5\n1 2 2147483647\n", 2, weighted, weights) &&
+              parsesTo("", 0, NULL, NULL) && parsesTo("# only comments\n\n", 0, NULL, NULL);
+
+    const char* malformed[] = { "0 1\n1 x\n", "0 1 2\n3 4\n", "0 1\n2 3 4\n", "4294967295 0\n", "0 1 2147483648\n" };
+    EdgeList edges;
+    for (int i = 0; i < 5; i++) {
+        printf("(the next message is expected) ");
+        ok = !edgeListParse(&edges, malformed[i], strlen(malformed[i])) && ok;
+    }
+    return ok;
+}
+
+// Random edge list with duplicates and self-loops
+static bool randomEdges(EdgeList* edges, size_t count, uint32_t vertices, bool weighted, unsigned* seed) {
+    memset(edges, 0, sizeof(*edges));
+    edges->sources = malloc((count + 1) * sizeof(uint32_t));
+    edges->targets = malloc((count + 1) * sizeof(uint32_t));
+    edges->weights = weighted ? malloc((count + 1) * sizeof(int32_t)) : NULL;
+    if (edges->sources == NULL || edges->targets == NULL || (weighted && edges->weights == NULL)) {
+        printf("Memory allocation failed\n");
+        edgeListFree(edges);
+        return false;
+    }
+    uint32_t maxId = 0;
+    for (size_t i = 0; i < count; i++) {
+        edges->sources[i] = nextRandom(seed) % vertices;
+        edges->targets[i] = (nextRandom(seed) % 8 == 0) ? edges->sources[i] : nextRandom(seed) % vertices;
+        if (weighted) {
+            edges->weights[i] = (int32_t)(nextRandom(seed) % 21) - 10;
+        }
+        maxId = edges->sources[i] > maxId ? edges->sources[i] : maxId;
+        maxId = edges->targets[i] > maxId ? edges->targets[i] : maxId;
+    }
+    edges->count = count;
+    edges->vertexCount = count > 0 ? maxId + 1 : 0;
+    return true;
+}
+
+static bool checkBuilder(unsigned* seed) {
+    bool ok = true;
+    for (int trial = 0; trial < 200 && ok; trial++) {
+        size_t count = (trial < 10) ? (size_t)trial : nextRandom(seed) % 3000;
+        uint32_t vertices = 1 + nextRandom(seed) % ((trial % 3 == 0) ? 5 : 300);
+        EdgeList edges;
+        if (!randomEdges(&edges, count, vertices, trial % 2 == 0, seed)) {
+            return false;
+        }
+        for (unsigned flags = 0; flags < 16 && ok; flags++) {
+            CsrGraph graph;
+            ok = csrBuild(&graph, &edges, flags) && matchesReference(&graph, &edges, flags);
+            csrFree(&graph);
+        }
+        edgeListFree(&edges);
+    }
+    return ok;
+}
+
+// Text of several parse blocks and a vertex range of several scan blocks,
+// loaded from text and from binary
+static bool checkLargeFiles(unsigned* seed) {
+    EdgeList edges;
+    if (!randomEdges(&edges, 300000, 200000, true, seed)) {
+        return false;
+    }
+    FILE* text = fopen(DEMO_TEXT, "w");
+    FILE* binary = fopen(DEMO_BINARY, "wb");
+    if (text == NULL || binary == NULL) {
+        printf("Cannot open %s\n", text == NULL ? DEMO_TEXT : DEMO_BINARY);
+        if (text != NULL) {
+            fclose(text);
+        }
+        if (binary != NULL) {
+            fclose(binary);
+        }
+        edgeListFree(&edges);
+        return false;
+    }
+    fprintf(text, "# %zu edges\n", edges.count);
+    for (size_t i = 0; i < edges.count; i++) {
+        fprintf(text, (i % 1000 == 0) ? "%u\t%u\t%d\r\n\n" : "%u %u %d\n",
+                edges.sources[i], edges.targets[i], edges.weights[i]);
+        uint32_t pair[2] = { edges.sources[i], edges.targets[i] };
+        fwrite(pair, sizeof(pair), 1, binary);
+    }
+    fclose(text);
+    fclose(binary);
+
+    EdgeList fromText, fromBinary;
+    bool ok = edgeListLoadText(&fromText, DEMO_TEXT) && fromText.count == edges.count &&
+              fromText.vertexCount == edges.vertexCount &&
+              memcmp(fromText.sources, edges.sources, edges.count * sizeof(uint32_t)) == 0 &&
+              memcmp(fromText.targets, edges.targets, edges.count * sizeof(uint32_t)) == 0 &&
+              memcmp(fromText.weights, edges.weights, edges.count * sizeof(int32_t)) == 0;
+    ok = edgeListLoadBinary(&fromBinary, DEMO_BINARY) && ok && fromBinary.count == edges.count &&
+         fromBinary.weights == NULL &&
+         memcmp(fromBinary.sources, edges.sources, edges.count * sizeof(uint32_t)) == 0 &&
+         memcmp(fromBinary.targets, edges.targets, edges.count * sizeof(uint32_t)) == 0;
+
+    const unsigned flags = GRAPH_SYMMETRIZE | GRAPH_DEDUPLICATE;
+    CsrGraph graph;
+    ok = ok && csrBuild(&graph, &fromText, flags) && matchesReference(&graph, &edges, flags);
+    csrFree(&graph);
+    ok = ok && csrBuild(&graph, &fromBinary, flags) && matchesReference(&graph, &fromBinary, flags);
+    csrFree(&graph);
+    edgeListFree(&fromText);
+    edgeListFree(&fromBinary);
+    edgeListFree(&edges);
+    remove(DEMO_TEXT);
+    remove(DEMO_BINARY);
+    return ok;
+}
+
+static bool checkSnapshots(unsigned* seed) {
+    bool ok = true;
+    for (int weighted = 0; weighted < 2 && ok; weighted++) {
+        EdgeList edges;
+        if (!randomEdges(&edges, 5000, 1000, weighted, seed)) {
+            return false;
+        }
+        CsrGraph built, opened;
+        ok = csrBuild(&built, &edges, GRAPH_SYMMETRIZE) && csrSave(&built, DEMO_SNAPSHOT) &&
+             csrOpenSnapshot(&opened, DEMO_SNAPSHOT) && sameGraph(&built, &opened) && opened.mapping != NULL;
+        csrFree(&opened);
+        csrFree(&built);
+        edgeListFree(&edges);
+    }
+
+    // A flipped header byte and a truncated file are refused
+    FILE* file = fopen(DEMO_SNAPSHOT, "r+b");
+    if (file == NULL) {
+        printf("Cannot open %s\n", DEMO_SNAPSHOT);
+        return false;
+    }
+    fseek(file, 20, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, 20, SEEK_SET);
+    fputc(byte ^ 1, file);
+    fclose(file);
+    CsrGraph graph;
+    printf("(the next message is expected) ");
+    ok = !csrOpenSnapshot(&graph, DEMO_SNAPSHOT) && ok;
+    if (truncate(DEMO_SNAPSHOT, 100) != 0) {
+        return false;
+    }
+    printf("(the next message is expected) ");
+    ok = !csrOpenSnapshot(&graph, DEMO_SNAPSHOT) && ok;
+    remove(DEMO_SNAPSHOT);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static void writeGraph(size_t count, uint32_t vertices, unsigned* seed) {
+    FILE* text = fopen(DEMO_TEXT, "w");
+    FILE* binary = fopen(DEMO_BINARY, "wb");
+    if (text == NULL || binary == NULL) {
+        printf("Cannot open %s\n", text == NULL ? DEMO_TEXT : DEMO_BINARY);
+        exit(1);
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pair[2] = { nextRandom(seed) % vertices, nextRandom(seed) % vertices };
+        fprintf(text, "%u %u %u\n", pair[0], pair[1], 1 + nextRandom(seed) % 100);
+        fwrite(pair, sizeof(pair), 1, binary);
+    }
+    fclose(text);
+    fclose(binary);
+}
+
+typedef enum { LOAD_DOCS, LOAD_TEXT, LOAD_TEXT_DEDUPLICATED, LOAD_BINARY, OPEN_SNAPSHOT, SCAN_SNAPSHOT } LoadMethod;
+
+// Peak resident memory of this process in MB, or -1 when it cannot be read
+static double peakMegabytes(void) {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == NULL) {
+        return -1;
+    }
+    char line[256];
+    long kilobytes = -1;
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (sscanf(line, "VmHWM: %ld kB", &kilobytes) == 1) {
+            break;
+        }
+    }
+    fclose(status);
+    return kilobytes < 0 ? -1 : kilobytes / 1024.0;
+}
+
+// Runs in the exec'd child (see measureLoader) and prints its whole row
+static void runLoader(LoadMethod method, uint32_t vertices, int workers) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = true;
+    if (method == LOAD_DOCS) {
+        GraphList* graph = createGraphList((int)vertices, false);
+        FILE* file = fopen(DEMO_TEXT, "r");
+        ok = graph != NULL && file != NULL;
+        int src, dest, weight;
+        while (ok && fscanf(file, "%d %d %d", &src, &dest, &weight) == 3) {
+            addEdgeList(graph, src, dest, weight);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("%-42s%10.4f s", "fscanf + addEdgeList (docs)", elapsedSeconds(start, end));
+        if (file != NULL) {
+            fclose(file);
+        }
+        if (graph != NULL) {
+            freeGraphList(graph);
+        }
+    } else if (method == OPEN_SNAPSHOT || method == SCAN_SNAPSHOT) {
+        CsrGraph graph;
+        ok = csrOpenSnapshot(&graph, DEMO_SNAPSHOT);
+        int64_t sum = 0;
+        if (ok && method == SCAN_SNAPSHOT) {
+            for (uint64_t e = 0; e < graph.edgeCount; e++) {
+                sum += graph.targets[e] + graph.weights[e];
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("%-42s%10.4f s", method == OPEN_SNAPSHOT ? "open snapshot" : "open snapshot + read every edge",
+               elapsedSeconds(start, end));
+        if (sum == 42) {
+            printf(" ");   // keeps the scan from being optimized away
+        }
+        csrFree(&graph);
+    } else {
+        schedulerInit(workers, 0);
+        EdgeList edges;
+        ok = (method == LOAD_BINARY) ? edgeListLoadBinary(&edges, DEMO_BINARY) : edgeListLoadText(&edges, DEMO_TEXT);
+        struct timespec parsed;
+        clock_gettime(CLOCK_MONOTONIC, &parsed);
+        unsigned flags = GRAPH_SYMMETRIZE;
+        if (method == LOAD_TEXT_DEDUPLICATED) {
+            flags |= GRAPH_DEDUPLICATE | GRAPH_REMOVE_SELF_LOOPS;
+        }
+        CsrGraph graph;
+        ok = ok && csrBuild(&graph, &edges, flags);
+        edgeListFree(&edges);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        const char* names[] = { "", "text -> CSR", "text -> CSR, deduplicated", "binary -> CSR" };
+        char label[64];
+        snprintf(label, sizeof(label), "%s (%.2f + %.2f)", names[method],
+                 elapsedSeconds(start, parsed), elapsedSeconds(parsed, end));
+        printf("%-42s%10.4f s", label, elapsedSeconds(start, end));
+        if (ok && method == LOAD_TEXT) {
+            ok = csrSave(&graph, DEMO_SNAPSHOT);
+        }
+        if (ok) {
+            csrFree(&graph);
+        }
+        schedulerShutdown();
+    }
+    printf("%9.0f MB\n", peakMegabytes());
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
+
+// Each loader in a new process image, so the peak memory is its own: after
+// fork() alone the child would still map all of the parent's pages, and
+// ru_maxrss keeps the high-water mark from before an exec
+static bool measureLoader(LoadMethod method, uint32_t vertices, int workers) {
+    char arguments[3][16];
+    snprintf(arguments[0], sizeof(arguments[0]), "%d", (int)method);
+    snprintf(arguments[1], sizeof(arguments[1]), "%u", vertices);
+    snprintf(arguments[2], sizeof(arguments[2]), "%d", workers);
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        printf("fork failed\n");
+        return false;
+    }
+    if (child == 0) {
+        execl("/proc/self/exe", "graph_loader_demo", LOADER_FLAG, arguments[0], arguments[1], arguments[2],
+              (char*)NULL);
+        printf("Cannot run /proc/self/exe\n");
+        _exit(1);
+    }
+    int status;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("  FAILED\n");
+        return false;
+    }
+    return true;
+}
+
+static void benchmark(size_t count, int workers, unsigned* seed) {
+    uint32_t vertices = (uint32_t)(count / 10);   // average degree 20 once symmetrized
+    printf("\n=== Loading %zu million random weighted edges, %u vertices, undirected ===\n",
+           count / 1000000, vertices);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    writeGraph(count, vertices, seed);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("(writing the text and binary edge lists took %.1f s)\n", elapsedSeconds(start, end));
+    printf("%-42s%12s%12s\n", "Loader (parse + build)", "time", "peak RSS");
+
+    bool ok = measureLoader(LOAD_DOCS, vertices, workers);
+    for (LoadMethod method = LOAD_TEXT; ok && method <= SCAN_SNAPSHOT; method++) {
+        ok = measureLoader(method, vertices, workers);
+    }
+    remove(DEMO_TEXT);
+    remove(DEMO_BINARY);
+    remove(DEMO_SNAPSHOT);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 5 && strcmp(argv[1], LOADER_FLAG) == 0) {
+        runLoader((LoadMethod)atoi(argv[2]), (uint32_t)strtoul(argv[3], NULL, 10), atoi(argv[4]));
+    }
+    long millions = argc > 1 ? atol(argv[1]) : 10;
+    int workers = argc > 2 ? atoi(argv[2]) : 0;
+    if (millions < 1 || millions > 100 || workers < 0) {
+        printf("Usage: %s [millions of edges, 1 to 100] [workers, 0 = one per CPU]\n", argv[0]);
+        return 1;
+    }
+
+    if (schedulerInit(workers, 0) != 0) {
+        printf("Cannot start the scheduler\n");
+        return 1;
+    }
+    printf("=== Example: the weighted graph of the docs, undirected ===\n");
+    const char* text = "# source destination weight\n"
+                       "0 1 2\n0 2 4\n1 2 1\n1 3 7\n2 3 3\n2 4 5\n3 4 1\n";
+    EdgeList edges;
+    CsrGraph graph;
+    if (!edgeListParse(&edges, text, strlen(text)) || !csrBuild(&graph, &edges, GRAPH_SYMMETRIZE | GRAPH_SORT_ROWS)) {
+        return 1;
+    }
+    printCsr(&graph);
+    printf("%u vertices, %llu directed edges, %zu bytes in CSR arrays\n", graph.vertexCount,
+           (unsigned long long)graph.edgeCount,
+           (graph.vertexCount + 1) * sizeof(uint64_t) + graph.edgeCount * (sizeof(uint32_t) + sizeof(int32_t)));
+    csrFree(&graph);
+    edgeListFree(&edges);
+
+    unsigned seed = 2463534242u;
+    printf("\n=== Checks (%d workers) ===\n", schedulerWorkerCount());
+    bool parserOk = checkParser();
+    printf("Comments, blank lines, CRLF, commas, weights, bad lines: %s\n", parserOk ? "all match" : "MISMATCH");
+    bool builderOk = checkBuilder(&seed);
+    printf("CSR of 200 random edge lists, all 16 flag combinations: %s\n", builderOk ? "all match" : "MISMATCH");
+    bool filesOk = checkLargeFiles(&seed);
+    printf("300000 edges from text and binary files: %s\n", filesOk ? "all match" : "MISMATCH");
+    bool snapshotOk = checkSnapshots(&seed);
+    printf("Snapshot round trip, damaged and truncated snapshots: %s\n", snapshotOk ? "all match" : "MISMATCH");
+    schedulerShutdown();
+
+    // The loaders run in their own processes and start their own scheduler
+    benchmark((size_t)millions * 1000000, workers, &seed);
+    return parserOk && builderOk && filesOk && snapshotOk ? 0 : 1;
+}
@@ -0,0 +1,951 @@
+/*
+ * membership_filter.c - Bloom, Cuckoo and Binary Fuse Filters for Negative Lookups (see membership_filter.h)
+ */
+
+#include "membership_filter.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+#define CACHE_LINE 64
+#define BLOOM_PREFETCH_DISTANCE 16      // keys looked ahead by bloomContainsBatch
+#define BLOOM_MAX_BITS_PER_KEY 64.0
+#define CUCKOO_MAX_LOAD 0.95
+#define CUCKOO_MAX_KICKS 500
+#define FUSE_MAX_SEGMENT_LENGTH 262144
+#define FUSE_MAX_ATTEMPTS 100
+
+#define FORMAT_VERSION 1u
+#define BYTE_ORDER_MARK 0x01020304u
+
+// A bijection on 64-bit values (the MurmurHash3 finalizer): distinct keys
+// keep distinct hashes, and every output bit depends on every input bit
+static inline uint64_t mixKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+// hash * range / 2^64: maps a hash onto 0 .. range-1 without a division
+static inline uint64_t scaleHash(uint64_t hash, uint64_t range) {
+    return (uint64_t)(((unsigned __int128)hash * range) >> 64);
+}
+
+// ========== Blocked Bloom Filter ==========
+//
+// The block comes from the high bits of the hash. Lane i of the block gets
+// bit (low32 * salt[i]) >> 27: eight multiplies by odd constants give eight
+// roughly independent 5-bit positions from one 32-bit value, and all eight
+// run as one vector multiply.
+
+static const uint32_t bloomSalts[BLOOM_BLOCK_LANES] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+static inline const uint32_t* bloomBlock(const uint32_t* lanes, uint64_t blockCount, uint64_t hash) {
+    return lanes + scaleHash(hash, blockCount) * BLOOM_BLOCK_LANES;
+}
+
+typedef void (*BloomBatchFunction)(const uint32_t* lanes, uint64_t blockCount, const uint64_t* keys,
+                                   size_t count, bool* results);
+
+static inline bool probeScalar(const uint32_t* block, uint32_t hash) {
+    uint32_t missing = 0;
+    for (int i = 0; i < BLOOM_BLOCK_LANES; i++) {
+        missing |= ~block[i] & (1u << ((hash * bloomSalts[i]) >> 27));
+    }
+    return missing == 0;
+}
+
+static void bloomBatchScalar(const uint32_t* lanes, uint64_t blockCount, const uint64_t* keys,
+                             size_t count, bool* results) {
+    for (size_t i = 0; i < count; i++) {
+        if (i + BLOOM_PREFETCH_DISTANCE < count) {
+            __builtin_prefetch(bloomBlock(lanes, blockCount, mixKey(keys[i + BLOOM_PREFETCH_DISTANCE])));
+        }
+        uint64_t hash = mixKey(keys[i]);
+        results[i] = probeScalar(bloomBlock(lanes, blockCount, hash), (uint32_t)hash);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i bloomBitsAvx2(uint32_t hash) {
+    __m256i salts = _mm256_loadu_si256((const __m256i*)bloomSalts);
+    __m256i positions = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)hash), salts), 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), positions);
+}
+
+__attribute__((target("avx2")))
+static inline bool probeAvx2(const uint32_t* block, uint32_t hash) {
+    // testc: every bit of the mask is set in the block
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i*)block), bloomBitsAvx2(hash));
+}
+
+__attribute__((target("avx2")))
+static void bloomBatchAvx2(const uint32_t* lanes, uint64_t blockCount, const uint64_t* keys,
+                           size_t count, bool* results) {
+    for (size_t i = 0; i < count; i++) {
+        if (i + BLOOM_PREFETCH_DISTANCE < count) {
+            __builtin_prefetch(bloomBlock(lanes, blockCount, mixKey(keys[i + BLOOM_PREFETCH_DISTANCE])));
+        }
+        uint64_t hash = mixKey(keys[i]);
+        results[i] = probeAvx2(bloomBlock(lanes, blockCount, hash), (uint32_t)hash);
+    }
+}
+
+// Two keys per 512-bit vector: their blocks side by side, one multiply,
+// shift and test for both
+__attribute__((target("avx512f")))
+static void bloomBatchAvx512(const uint32_t* lanes, uint64_t blockCount, const uint64_t* keys,
+                             size_t count, bool* results) {
+    __m512i salts = _mm512_broadcast_i64x4(_mm256_loadu_si256((const __m256i*)bloomSalts));
+    __m512i one = _mm512_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        if (i + BLOOM_PREFETCH_DISTANCE + 1 < count) {
+            __builtin_prefetch(bloomBlock(lanes, blockCount, mixKey(keys[i + BLOOM_PREFETCH_DISTANCE])));
+            __builtin_prefetch(bloomBlock(lanes, blockCount, mixKey(keys[i + BLOOM_PREFETCH_DISTANCE + 1])));
+        }
+        uint64_t hash0 = mixKey(keys[i]);
+        uint64_t hash1 = mixKey(keys[i + 1]);
+        __m512i hashes = _mm512_inserti64x4(_mm512_castsi256_si512(_mm256_set1_epi32((int)(uint32_t)hash0)),
+                                            _mm256_set1_epi32((int)(uint32_t)hash1), 1);
+        __m512i blocks = _mm512_inserti64x4(
+            _mm512_castsi256_si512(_mm256_load_si256((const __m256i*)bloomBlock(lanes, blockCount, hash0))),
+            _mm256_load_si256((const __m256i*)bloomBlock(lanes, blockCount, hash1)), 1);
+        __m512i bits = _mm512_sllv_epi32(one, _mm512_srli_epi32(_mm512_mullo_epi32(hashes, salts), 27));
+        __m512i absent = _mm512_andnot_si512(blocks, bits);
+        __mmask16 missing = _mm512_test_epi32_mask(absent, absent);
+        results[i] = (missing & 0xFF) == 0;
+        results[i + 1] = (missing >> 8) == 0;
+    }
+    if (i < count) {
+        uint64_t hash = mixKey(keys[i]);
+        results[i] = probeAvx2(bloomBlock(lanes, blockCount, hash), (uint32_t)hash);
+    }
+}
+
+DISPATCH_KERNEL(BloomBatchFunction, bloomBatchKernel,
+    DISPATCH_VARIANT(bloomBatchAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(bloomBatchAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(bloomBatchScalar, 0))
+
+// A key's lane bit is set by another key with probability 1/32, and blocks
+// hold a Poisson number of keys with mean 256 / bitsPerKey:
+//   rate = sum over j of P(j keys in the block) * (1 - (31/32)^j)^8
+static double splitBlockRate(double keysPerBlock) {
+    double probability = exp(-keysPerBlock);   // P(0 keys)
+    double rate = 0.0;
+    int last = (int)(keysPerBlock * 4) + 64;
+    for (int j = 0; j <= last; j++) {
+        rate += probability * pow(1.0 - pow(31.0 / 32.0, j), BLOOM_BLOCK_LANES);
+        probability *= keysPerBlock / (j + 1);
+    }
+    return rate;
+}
+
+static bool allocateBloom(BloomFilter* filter, uint64_t blockCount) {
+    size_t bytes = blockCount * BLOOM_BLOCK_LANES * sizeof(uint32_t);
+    filter->lanes = (uint32_t*)aligned_alloc(CACHE_LINE, (bytes + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1));
+    if (filter->lanes == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    memset(filter->lanes, 0, bytes);
+    filter->blockCount = blockCount;
+    filter->count = 0;
+    return true;
+}
+
+bool bloomInit(BloomFilter* filter, size_t expectedKeys, double falsePositiveRate) {
+    memset(filter, 0, sizeof(*filter));
+    if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0)) {
+        printf("False-positive rate must be between 0 and 1\n");
+        return false;
+    }
+    double bitsPerKey = 2.0;
+    while (bitsPerKey < BLOOM_MAX_BITS_PER_KEY &&
+           splitBlockRate(BLOOM_BLOCK_LANES * 32 / bitsPerKey) > falsePositiveRate) {
+        bitsPerKey += 0.25;
+    }
+    uint64_t blockCount = (uint64_t)ceil((double)expectedKeys * bitsPerKey / (BLOOM_BLOCK_LANES * 32));
+    return allocateBloom(filter, blockCount > 0 ? blockCount : 1);
+}
+
+void bloomDestroy(BloomFilter* filter) {
+    free(filter->lanes);
+    memset(filter, 0, sizeof(*filter));
+}
+
+void bloomAdd(BloomFilter* filter, uint64_t key) {
+    uint64_t hash = mixKey(key);
+    uint32_t* block = (uint32_t*)bloomBlock(filter->lanes, filter->blockCount, hash);
+    for (int i = 0; i < BLOOM_BLOCK_LANES; i++) {
+        block[i] |= 1u << (((uint32_t)hash * bloomSalts[i]) >> 27);
+    }
+    filter->count++;
+}
+
+bool bloomContains(const BloomFilter* filter, uint64_t key) {
+    bool result;
+    bloomBatchKernel(filter->lanes, filter->blockCount, &key, 1, &result);
+    return result;
+}
+
+void bloomContainsBatch(const BloomFilter* filter, const uint64_t* keys, size_t count, bool* results) {
+    bloomBatchKernel(filter->lanes, filter->blockCount, keys, count, results);
+}
+
+double bloomFalsePositiveRate(const BloomFilter* filter) {
+    return splitBlockRate((double)filter->count / (double)filter->blockCount);
+}
+
+size_t bloomSizeInBytes(const BloomFilter* filter) {
+    return filter->blockCount * BLOOM_BLOCK_LANES * sizeof(uint32_t);
+}
+
+// ========== Cuckoo Filter ==========
+//
+// A key's fingerprint goes in bucket i1 (from the hash) or i2 = h(fp) - i1
+// (mod bucketCount), and i1 = h(fp) - i2 as well, so a fingerprint can move
+// to its other bucket without knowing its key. Unlike the usual i1 ^ h(fp),
+// this works for any bucket count, not only powers of two. When both buckets are full, a random
+// fingerprint is evicted to its other bucket, and so on. After
+// CUCKOO_MAX_KICKS moves the last evicted fingerprint is kept aside as
+// the victim, so no key is lost, and the filter reports full.
+
+static inline uint32_t cuckooFingerprint(const CuckooFilter* filter, uint64_t hash) {
+    uint32_t fingerprint = (uint32_t)(hash >> 32);
+    if (filter->fingerprintBits < 32) {
+        fingerprint &= (1u << filter->fingerprintBits) - 1;
+    }
+    return fingerprint != 0 ? fingerprint : 1;   // 0 marks an empty slot
+}
+
+// The fingerprint comes from the high half of the hash, so the bucket is
+// scaled from the low half: otherwise keys in one bucket would share
+// their leading fingerprint bits and collide more often
+static inline uint64_t firstBucket(const CuckooFilter* filter, uint64_t hash) {
+    return scaleHash((hash << 32) | (hash >> 32), filter->bucketCount);
+}
+
+static inline uint64_t otherBucket(const CuckooFilter* filter, uint64_t bucket, uint32_t fingerprint) {
+    uint64_t offset = scaleHash(mixKey(fingerprint), filter->bucketCount);
+    return offset >= bucket ? offset - bucket : offset + filter->bucketCount - bucket;
+}
+
+static inline uint32_t slotGet(const CuckooFilter* filter, uint64_t slot) {
+    switch (filter->fingerprintBits) {
+    case 8:
+        return ((const uint8_t*)filter->slots)[slot];
+    case 16:
+        return ((const uint16_t*)filter->slots)[slot];
+    default:
+        return ((const uint32_t*)filter->slots)[slot];
+    }
+}
+
+static inline void slotSet(CuckooFilter* filter, uint64_t slot, uint32_t fingerprint) {
+    switch (filter->fingerprintBits) {
+    case 8:
+        ((uint8_t*)filter->slots)[slot] = (uint8_t)fingerprint;
+        break;
+    case 16:
+        ((uint16_t*)filter->slots)[slot] = (uint16_t)fingerprint;
+        break;
+    default:
+        ((uint32_t*)filter->slots)[slot] = fingerprint;
+        break;
+    }
+}
+
+// All four slots compared at once: XOR with the fingerprint in every
+// slot turns a match into a zero slot, and (x - 0x01..) & ~x & 0x80..
+// is non-zero exactly when some slot of x is zero
+static inline bool bucketHolds(const CuckooFilter* filter, uint64_t bucket, uint32_t fingerprint) {
+    const uint8_t* base = (const uint8_t*)filter->slots + bucket * CUCKOO_BUCKET_SLOTS * (filter->fingerprintBits / 8);
+    if (filter->fingerprintBits == 8) {
+        uint32_t word;
+        memcpy(&word, base, sizeof(word));
+        word ^= fingerprint * 0x01010101u;
+        return ((word - 0x01010101u) & ~word & 0x80808080u) != 0;
+    }
+    if (filter->fingerprintBits == 16) {
+        uint64_t word;
+        memcpy(&word, base, sizeof(word));
+        word ^= fingerprint * 0x0001000100010001ull;
+        return ((word - 0x0001000100010001ull) & ~word & 0x8000800080008000ull) != 0;
+    }
+    uint32_t slots[CUCKOO_BUCKET_SLOTS];
+    memcpy(slots, base, sizeof(slots));
+    return (slots[0] == fingerprint) | (slots[1] == fingerprint) | (slots[2] == fingerprint) |
+           (slots[3] == fingerprint);
+}
+
+// Puts the fingerprint in a free slot of the bucket, if there is one
+static bool bucketInsert(CuckooFilter* filter, uint64_t bucket, uint32_t fingerprint) {
+    for (int s = 0; s < CUCKOO_BUCKET_SLOTS; s++) {
+        if (slotGet(filter, bucket * CUCKOO_BUCKET_SLOTS + s) == 0) {
+            slotSet(filter, bucket * CUCKOO_BUCKET_SLOTS + s, fingerprint);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool bucketRemove(CuckooFilter* filter, uint64_t bucket, uint32_t fingerprint) {
+    for (int s = 0; s < CUCKOO_BUCKET_SLOTS; s++) {
+        if (slotGet(filter, bucket * CUCKOO_BUCKET_SLOTS + s) == fingerprint) {
+            slotSet(filter, bucket * CUCKOO_BUCKET_SLOTS + s, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool allocateCuckoo(CuckooFilter* filter, uint64_t bucketCount, int fingerprintBits) {
+    filter->slots = calloc(bucketCount * CUCKOO_BUCKET_SLOTS, (size_t)fingerprintBits / 8);
+    if (filter->slots == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    filter->bucketCount = bucketCount;
+    filter->fingerprintBits = fingerprintBits;
+    filter->count = 0;
+    filter->victim = 0;
+    filter->victimBucket = 0;
+    filter->randomState = 0x9e3779b97f4a7c15ull;
+    return true;
+}
+
+// A lookup compares against 8 slots, each holding a random non-zero
+// fingerprint with probability load
+static double cuckooRate(int fingerprintBits, double load) {
+    double values = (double)((1ull << fingerprintBits) - 1);
+    return 1.0 - pow(1.0 - 1.0 / values, 2.0 * CUCKOO_BUCKET_SLOTS * load);
+}
+
+bool cuckooInit(CuckooFilter* filter, size_t expectedKeys, double falsePositiveRate) {
+    memset(filter, 0, sizeof(*filter));
+    if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0)) {
+        printf("False-positive rate must be between 0 and 1\n");
+        return false;
+    }
+    int fingerprintBits = 8;
+    while (fingerprintBits < 32 && cuckooRate(fingerprintBits, CUCKOO_MAX_LOAD) > falsePositiveRate) {
+        fingerprintBits *= 2;
+    }
+    uint64_t bucketCount = (uint64_t)ceil((double)expectedKeys / (CUCKOO_BUCKET_SLOTS * CUCKOO_MAX_LOAD));
+    return allocateCuckoo(filter, bucketCount > 2 ? bucketCount : 2, fingerprintBits);
+}
+
+void cuckooDestroy(CuckooFilter* filter) {
+    free(filter->slots);
+    memset(filter, 0, sizeof(*filter));
+}
+
+bool cuckooAdd(CuckooFilter* filter, uint64_t key) {
+    if (filter->victim != 0) {
+        return false;   // full
+    }
+    uint64_t hash = mixKey(key);
+    uint32_t fingerprint = cuckooFingerprint(filter, hash);
+    uint64_t bucket = firstBucket(filter, hash);
+    uint64_t other = otherBucket(filter, bucket, fingerprint);
+    if (bucketInsert(filter, bucket, fingerprint) || bucketInsert(filter, other, fingerprint)) {
+        filter->count++;
+        return true;
+    }
+
+    // Evict, starting from either bucket
+    filter->randomState ^= filter->randomState << 13;
+    filter->randomState ^= filter->randomState >> 7;
+    filter->randomState ^= filter->randomState << 17;
+    bucket = (filter->randomState & 1) ? other : bucket;
+    for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+        filter->randomState ^= filter->randomState << 13;
+        filter->randomState ^= filter->randomState >> 7;
+        filter->randomState ^= filter->randomState << 17;
+        uint64_t slot = bucket * CUCKOO_BUCKET_SLOTS + (filter->randomState >> 62);
+        uint32_t evicted = slotGet(filter, slot);
+        slotSet(filter, slot, fingerprint);
+        fingerprint = evicted;
+        bucket = otherBucket(filter, bucket, fingerprint);
+        if (bucketInsert(filter, bucket, fingerprint)) {
+            filter->count++;
+            return true;
+        }
+    }
+    filter->victim = fingerprint;
+    filter->victimBucket = bucket;
+    filter->count++;
+    return true;
+}
+
+bool cuckooRemove(CuckooFilter* filter, uint64_t key) {
+    uint64_t hash = mixKey(key);
+    uint32_t fingerprint = cuckooFingerprint(filter, hash);
+    uint64_t bucket = firstBucket(filter, hash);
+    uint64_t other = otherBucket(filter, bucket, fingerprint);
+    if (filter->victim == fingerprint && (filter->victimBucket == bucket || filter->victimBucket == other)) {
+        filter->victim = 0;
+        filter->count--;
+        return true;
+    }
+    if (!bucketRemove(filter, bucket, fingerprint) && !bucketRemove(filter, other, fingerprint)) {
+        return false;
+    }
+    filter->count--;
+    // The freed slot may take the victim back
+    if (filter->victim != 0) {
+        uint64_t victimOther = otherBucket(filter, filter->victimBucket, filter->victim);
+        if (bucketInsert(filter, filter->victimBucket, filter->victim) ||
+            bucketInsert(filter, victimOther, filter->victim)) {
+            filter->victim = 0;
+        }
+    }
+    return true;
+}
+
+bool cuckooContains(const CuckooFilter* filter, uint64_t key) {
+    uint64_t hash = mixKey(key);
+    uint32_t fingerprint = cuckooFingerprint(filter, hash);
+    uint64_t bucket = firstBucket(filter, hash);
+    uint64_t other = otherBucket(filter, bucket, fingerprint);
+    bool victim = filter->victim == fingerprint &&
+                  (filter->victimBucket == bucket || filter->victimBucket == other);
+    return bucketHolds(filter, bucket, fingerprint) || bucketHolds(filter, other, fingerprint) || victim;
+}
+
+double cuckooFalsePositiveRate(const CuckooFilter* filter) {
+    double load = (double)filter->count / (double)(filter->bucketCount * CUCKOO_BUCKET_SLOTS);
+    return cuckooRate(filter->fingerprintBits, load);
+}
+
+size_t cuckooSizeInBytes(const CuckooFilter* filter) {
+    return filter->bucketCount * CUCKOO_BUCKET_SLOTS * (size_t)(filter->fingerprintBits / 8);
+}
+
+// ========== Binary Fuse Filter ==========
+//
+// The array is cut into segments. A key maps to three positions in three
+// consecutive segments, and the fingerprints there are chosen so that
+// their XOR equals the key's fingerprint. Building peels the key set: a
+// position used by only one key can be solved last for that key, which
+// removes the key and may leave another position with a single key. The
+// keys are then assigned in the reverse of peeling order. With the
+// segment sizes below, peeling succeeds with high probability; otherwise
+// the seed changes and it starts again (after removing repeated keys).
+
+typedef struct {
+    uint32_t h0;
+    uint32_t h1;
+    uint32_t h2;
+} FusePositions;
+
+static inline FusePositions fusePositions(const FuseFilter* filter, uint64_t hash) {
+    uint32_t mask = filter->segmentLength - 1;
+    FusePositions p;
+    p.h0 = (uint32_t)scaleHash(hash, (uint64_t)filter->segmentCount * filter->segmentLength);
+    p.h1 = (p.h0 + filter->segmentLength) ^ ((uint32_t)(hash >> 18) & mask);
+    p.h2 = (p.h0 + 2 * filter->segmentLength) ^ ((uint32_t)hash & mask);
+    return p;
+}
+
+static inline uint32_t fuseFingerprint(const FuseFilter* filter, uint64_t hash) {
+    uint64_t fingerprint = hash ^ (hash >> 32);
+    return filter->fingerprintBits == 32 ? (uint32_t)fingerprint
+                                         : (uint32_t)fingerprint & ((1u << filter->fingerprintBits) - 1);
+}
+
+static inline uint32_t fuseGet(const FuseFilter* filter, uint32_t position) {
+    switch (filter->fingerprintBits) {
+    case 8:
+        return ((const uint8_t*)filter->fingerprints)[position];
+    case 16:
+        return ((const uint16_t*)filter->fingerprints)[position];
+    default:
+        return ((const uint32_t*)filter->fingerprints)[position];
+    }
+}
+
+static inline void fuseSet(FuseFilter* filter, uint32_t position, uint32_t fingerprint) {
+    switch (filter->fingerprintBits) {
+    case 8:
+        ((uint8_t*)filter->fingerprints)[position] = (uint8_t)fingerprint;
+        break;
+    case 16:
+        ((uint16_t*)filter->fingerprints)[position] = (uint16_t)fingerprint;
+        break;
+    default:
+        ((uint32_t*)filter->fingerprints)[position] = fingerprint;
+        break;
+    }
+}
+
+// Segment length and array size for a number of keys, as measured by
+// Graf and Lemire for three-wise binary fuse filters
+static void fuseLayout(FuseFilter* filter, size_t count) {
+    uint32_t segmentLength = 4;
+    if (count > 1) {
+        segmentLength = 1u << (int)floor(log((double)count) / log(3.33) + 2.25);
+    }
+    if (segmentLength > FUSE_MAX_SEGMENT_LENGTH) {
+        segmentLength = FUSE_MAX_SEGMENT_LENGTH;
+    }
+    double sizeFactor = count > 1 ? fmax(1.125, 0.875 + 0.25 * log(1000000.0) / log((double)count)) : 0.0;
+    double capacity = round((double)count * sizeFactor);
+    long segmentCount = (long)ceil(capacity / segmentLength) - 2;
+    filter->segmentLength = segmentLength;
+    filter->segmentCount = (uint32_t)(segmentCount > 0 ? segmentCount : 1);
+    filter->arrayLength = (filter->segmentCount + 2) * segmentLength;
+}
+
+static bool allocateFingerprints(FuseFilter* filter) {
+    filter->fingerprints = calloc(filter->arrayLength, (size_t)filter->fingerprintBits / 8);
+    if (filter->fingerprints == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// One peeling attempt with filter->seed; false if some keys stay unpeeled
+static bool fusePeel(FuseFilter* filter, const uint64_t* keys, size_t count, uint32_t* degree,
+                     uint64_t* hashXor, uint32_t* queue, uint64_t* stackHash, uint32_t* stackPosition) {
+    memset(degree, 0, filter->arrayLength * sizeof(uint32_t));
+    memset(hashXor, 0, filter->arrayLength * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++) {
+        uint64_t hash = mixKey(keys[i] + filter->seed);
+        FusePositions p = fusePositions(filter, hash);
+        degree[p.h0]++;
+        degree[p.h1]++;
+        degree[p.h2]++;
+        hashXor[p.h0] ^= hash;
+        hashXor[p.h1] ^= hash;
+        hashXor[p.h2] ^= hash;
+    }
+
+    size_t queued = 0;
+    for (uint32_t position = 0; position < filter->arrayLength; position++) {
+        if (degree[position] == 1) {
+            queue[queued++] = position;
+        }
+    }
+    size_t peeled = 0;
+    while (queued > 0) {
+        uint32_t position = queue[--queued];
+        if (degree[position] != 1) {
+            continue;   // its key was peeled through another position
+        }
+        uint64_t hash = hashXor[position];   // the only key left here
+        stackHash[peeled] = hash;
+        stackPosition[peeled] = position;
+        peeled++;
+        FusePositions p = fusePositions(filter, hash);
+        uint32_t positions[3] = { p.h0, p.h1, p.h2 };
+        for (int j = 0; j < 3; j++) {
+            degree[positions[j]]--;
+            hashXor[positions[j]] ^= hash;
+            if (degree[positions[j]] == 1) {
+                queue[queued++] = positions[j];
+            }
+        }
+    }
+    return peeled == count;
+}
+
+bool fuseBuild(FuseFilter* filter, const uint64_t* keys, size_t count, double falsePositiveRate) {
+    memset(filter, 0, sizeof(*filter));
+    if (!(falsePositiveRate > 0.0 && falsePositiveRate < 1.0)) {
+        printf("False-positive rate must be between 0 and 1\n");
+        return false;
+    }
+    if (count >= (1u << 31)) {
+        printf("Too many keys for a fuse filter\n");
+        return false;
+    }
+    filter->fingerprintBits = 8;
+    while (filter->fingerprintBits < 32 && ldexp(1.0, -filter->fingerprintBits) > falsePositiveRate) {
+        filter->fingerprintBits *= 2;
+    }
+    fuseLayout(filter, count);
+
+    uint32_t* degree = malloc(filter->arrayLength * sizeof(uint32_t));
+    uint64_t* hashXor = malloc(filter->arrayLength * sizeof(uint64_t));
+    uint32_t* queue = malloc(filter->arrayLength * sizeof(uint32_t));
+    uint64_t* stackHash = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    uint32_t* stackPosition = malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    uint64_t* distinct = NULL;   // sorted copy without repeats, made on the first failure
+    bool ok = degree != NULL && hashXor != NULL && queue != NULL && stackHash != NULL && stackPosition != NULL;
+    if (!ok) {
+        printf("Memory allocation failed\n");
+    }
+
+    uint64_t seedState = 0x726b2b9d438b9d4dull;
+    bool built = false;
+    for (int attempt = 0; ok && !built && attempt < FUSE_MAX_ATTEMPTS; attempt++) {
+        seedState += 0x9e3779b97f4a7c15ull;
+        filter->seed = mixKey(seedState);
+        built = fusePeel(filter, keys, count, degree, hashXor, queue, stackHash, stackPosition);
+        if (!built && distinct == NULL) {
+            // A repeated key never peels: its positions always hold two keys
+            distinct = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+            if (distinct == NULL) {
+                printf("Memory allocation failed\n");
+                ok = false;
+                break;
+            }
+            memcpy(distinct, keys, count * sizeof(uint64_t));
+            qsort(distinct, count, sizeof(uint64_t), compareKeys);
+            size_t unique = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (unique == 0 || distinct[i] != distinct[unique - 1]) {
+                    distinct[unique++] = distinct[i];
+                }
+            }
+            keys = distinct;
+            if (unique != count) {
+                uint32_t allocated = filter->arrayLength;
+                count = unique;
+                fuseLayout(filter, count);
+                if (filter->arrayLength > allocated) {
+                    free(degree);
+                    free(hashXor);
+                    free(queue);
+                    degree = malloc(filter->arrayLength * sizeof(uint32_t));
+                    hashXor = malloc(filter->arrayLength * sizeof(uint64_t));
+                    queue = malloc(filter->arrayLength * sizeof(uint32_t));
+                    if (degree == NULL || hashXor == NULL || queue == NULL) {
+                        printf("Memory allocation failed\n");
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    if (ok && !built) {
+        printf("Fuse filter construction failed\n");
+    }
+    ok = ok && built && allocateFingerprints(filter);
+
+    if (ok) {
+        // Reverse peeling order: the other two positions of each key are
+        // already final, so its own position makes the XOR come out right
+        for (size_t i = count; i-- > 0;) {
+            uint64_t hash = stackHash[i];
+            FusePositions p = fusePositions(filter, hash);
+            uint32_t value = fuseFingerprint(filter, hash) ^ fuseGet(filter, p.h0) ^ fuseGet(filter, p.h1) ^
+                             fuseGet(filter, p.h2);   // its own position still holds 0
+            fuseSet(filter, stackPosition[i], value);
+        }
+        filter->count = count;
+    }
+    free(degree);
+    free(hashXor);
+    free(queue);
+    free(stackHash);
+    free(stackPosition);
+    free(distinct);
+    if (!ok) {
+        fuseDestroy(filter);
+    }
+    return ok;
+}
+
+void fuseDestroy(FuseFilter* filter) {
+    free(filter->fingerprints);
+    memset(filter, 0, sizeof(*filter));
+}
+
+bool fuseContains(const FuseFilter* filter, uint64_t key) {
+    uint64_t hash = mixKey(key + filter->seed);
+    FusePositions p = fusePositions(filter, hash);
+    return (fuseFingerprint(filter, hash) ^ fuseGet(filter, p.h0) ^ fuseGet(filter, p.h1) ^
+            fuseGet(filter, p.h2)) == 0;
+}
+
+double fuseFalsePositiveRate(const FuseFilter* filter) {
+    return ldexp(1.0, -filter->fingerprintBits);
+}
+
+size_t fuseSizeInBytes(const FuseFilter* filter) {
+    return (size_t)filter->arrayLength * (size_t)(filter->fingerprintBits / 8);
+}
+
+// ========== Serialization ==========
+//
+// Each format is a fixed header followed by the filter's array, in the
+// machine's byte order. The header's magic names the filter type.
+
+typedef struct {
+    char magic[8];            // "BLOOMFLT"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t blockCount;
+    uint64_t count;
+} BloomHeader;
+
+typedef struct {
+    char magic[8];            // "CUCKOOFL"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t bucketCount;
+    uint64_t count;
+    uint64_t victimBucket;
+    uint64_t randomState;
+    uint32_t victim;
+    uint32_t fingerprintBits;
+} CuckooHeader;
+
+typedef struct {
+    char magic[8];            // "BFUSEFLT"
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t seed;
+    uint64_t count;
+    uint32_t segmentLength;
+    uint32_t segmentCount;
+    uint32_t arrayLength;
+    uint32_t fingerprintBits;
+} FuseHeader;
+
+static bool invalidData(const char* type) {
+    printf("Invalid %s filter data\n", type);
+    return false;
+}
+
+static bool writeFile(const char* path, const void* buffer, size_t size) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Cannot write %s\n", path);
+    }
+    return ok;
+}
+
+// The whole file in a malloc'd buffer, or NULL
+static void* readFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return NULL;
+    }
+    void* buffer = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        length = ftell(file);
+    }
+    if (length >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        buffer = malloc(length > 0 ? (size_t)length : 1);
+        if (buffer == NULL) {
+            printf("Memory allocation failed\n");
+        } else if (fread(buffer, 1, (size_t)length, file) != (size_t)length) {
+            free(buffer);
+            buffer = NULL;
+        }
+    }
+    if (buffer == NULL && length >= 0) {
+        printf("Cannot read %s\n", path);
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return buffer;
+}
+
+// Serialize into a temporary buffer and write it out
+#define WRITE_SERIALIZED(prefix, filter, path)                     \
+    do {                                                           \
+        size_t size = prefix##SerializedSize(filter);              \
+        void* buffer = malloc(size);                               \
+        if (buffer == NULL) {                                      \
+            printf("Memory allocation failed\n");                  \
+            return false;                                          \
+        }                                                          \
+        prefix##Serialize(filter, buffer);                         \
+        bool ok = writeFile(path, buffer, size);                   \
+        free(buffer);                                              \
+        return ok;                                                 \
+    } while (0)
+
+#define READ_SERIALIZED(prefix, filter, path)                      \
+    do {                                                           \
+        size_t size;                                               \
+        void* buffer = readFile(path, &size);                      \
+        if (buffer == NULL) {                                      \
+            memset(filter, 0, sizeof(*filter));                    \
+            return false;                                          \
+        }                                                          \
+        bool ok = prefix##Deserialize(filter, buffer, size);       \
+        free(buffer);                                              \
+        return ok;                                                 \
+    } while (0)
+
+size_t bloomSerializedSize(const BloomFilter* filter) {
+    return sizeof(BloomHeader) + bloomSizeInBytes(filter);
+}
+
+size_t bloomSerialize(const BloomFilter* filter, void* buffer) {
+    BloomHeader header = { .version = FORMAT_VERSION, .byteOrder = BYTE_ORDER_MARK,
+                           .blockCount = filter->blockCount, .count = filter->count };
+    memcpy(header.magic, "BLOOMFLT", 8);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy((char*)buffer + sizeof(header), filter->lanes, bloomSizeInBytes(filter));
+    return bloomSerializedSize(filter);
+}
+
+bool bloomDeserialize(BloomFilter* filter, const void* buffer, size_t size) {
+    memset(filter, 0, sizeof(*filter));
+    BloomHeader header;
+    if (size < sizeof(header)) {
+        return invalidData("bloom");
+    }
+    memcpy(&header, buffer, sizeof(header));
+    size_t blockBytes = BLOOM_BLOCK_LANES * sizeof(uint32_t);
+    if (memcmp(header.magic, "BLOOMFLT", 8) != 0 || header.version != FORMAT_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK || header.blockCount == 0 ||
+        header.blockCount != (size - sizeof(header)) / blockBytes || (size - sizeof(header)) % blockBytes != 0) {
+        return invalidData("bloom");
+    }
+    if (!allocateBloom(filter, header.blockCount)) {
+        return false;
+    }
+    memcpy(filter->lanes, (const char*)buffer + sizeof(header), bloomSizeInBytes(filter));
+    filter->count = header.count;
+    return true;
+}
+
+bool bloomWriteFile(const BloomFilter* filter, const char* path) {
+    WRITE_SERIALIZED(bloom, filter, path);
+}
+
+bool bloomReadFile(BloomFilter* filter, const char* path) {
+    READ_SERIALIZED(bloom, filter, path);
+}
+
+size_t cuckooSerializedSize(const CuckooFilter* filter) {
+    return sizeof(CuckooHeader) + cuckooSizeInBytes(filter);
+}
+
+size_t cuckooSerialize(const CuckooFilter* filter, void* buffer) {
+    CuckooHeader header = { .version = FORMAT_VERSION, .byteOrder = BYTE_ORDER_MARK,
+                            .bucketCount = filter->bucketCount, .count = filter->count,
+                            .victimBucket = filter->victimBucket, .randomState = filter->randomState,
+                            .victim = filter->victim, .fingerprintBits = (uint32_t)filter->fingerprintBits };
+    memcpy(header.magic, "CUCKOOFL", 8);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy((char*)buffer + sizeof(header), filter->slots, cuckooSizeInBytes(filter));
+    return cuckooSerializedSize(filter);
+}
+
+bool cuckooDeserialize(CuckooFilter* filter, const void* buffer, size_t size) {
+    memset(filter, 0, sizeof(*filter));
+    CuckooHeader header;
+    if (size < sizeof(header)) {
+        return invalidData("cuckoo");
+    }
+    memcpy(&header, buffer, sizeof(header));
+    uint32_t bits = header.fingerprintBits;
+    bool valid = memcmp(header.magic, "CUCKOOFL", 8) == 0 && header.version == FORMAT_VERSION &&
+                 header.byteOrder == BYTE_ORDER_MARK && (bits == 8 || bits == 16 || bits == 32) &&
+                 header.bucketCount >= 2 &&
+                 header.bucketCount <= (size - sizeof(header)) / (CUCKOO_BUCKET_SLOTS * bits / 8) &&
+                 size - sizeof(header) == header.bucketCount * CUCKOO_BUCKET_SLOTS * bits / 8 &&
+                 header.victimBucket < header.bucketCount &&
+                 (bits == 32 || header.victim < (1u << bits)) && header.randomState != 0;
+    if (!valid) {
+        return invalidData("cuckoo");
+    }
+    if (!allocateCuckoo(filter, header.bucketCount, (int)bits)) {
+        return false;
+    }
+    memcpy(filter->slots, (const char*)buffer + sizeof(header), cuckooSizeInBytes(filter));
+    filter->count = header.count;
+    filter->victim = header.victim;
+    filter->victimBucket = header.victimBucket;
+    filter->randomState = header.randomState;
+    return true;
+}
+
+bool cuckooWriteFile(const CuckooFilter* filter, const char* path) {
+    WRITE_SERIALIZED(cuckoo, filter, path);
+}
+
+bool cuckooReadFile(CuckooFilter* filter, const char* path) {
+    READ_SERIALIZED(cuckoo, filter, path);
+}
+
+size_t fuseSerializedSize(const FuseFilter* filter) {
+    return sizeof(FuseHeader) + fuseSizeInBytes(filter);
+}
+
+size_t fuseSerialize(const FuseFilter* filter, void* buffer) {
+    FuseHeader header = { .version = FORMAT_VERSION, .byteOrder = BYTE_ORDER_MARK,
+                          .seed = filter->seed, .count = filter->count,
+                          .segmentLength = filter->segmentLength, .segmentCount = filter->segmentCount,
+                          .arrayLength = filter->arrayLength, .fingerprintBits = (uint32_t)filter->fingerprintBits };
+    memcpy(header.magic, "BFUSEFLT", 8);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy((char*)buffer + sizeof(header), filter->fingerprints, fuseSizeInBytes(filter));
+    return fuseSerializedSize(filter);
+}
+
+bool fuseDeserialize(FuseFilter* filter, const void* buffer, size_t size) {
+    memset(filter, 0, sizeof(*filter));
+    FuseHeader header;
+    if (size < sizeof(header)) {
+        return invalidData("fuse");
+    }
+    memcpy(&header, buffer, sizeof(header));
+    uint32_t bits = header.fingerprintBits;
+    uint64_t length = header.segmentLength;
+    // Positions are computed from these fields: they must stay inside the array
+    bool valid = memcmp(header.magic, "BFUSEFLT", 8) == 0 && header.version == FORMAT_VERSION &&
+                 header.byteOrder == BYTE_ORDER_MARK && (bits == 8 || bits == 16 || bits == 32) &&
+                 length >= 1 && length <= FUSE_MAX_SEGMENT_LENGTH && (length & (length - 1)) == 0 &&
+                 header.segmentCount >= 1 &&
+                 ((uint64_t)header.segmentCount + 2) * length == header.arrayLength &&
+                 size - sizeof(header) == (uint64_t)header.arrayLength * (bits / 8);
+    if (!valid) {
+        return invalidData("fuse");
+    }
+    filter->fingerprintBits = (int)bits;
+    filter->seed = header.seed;
+    filter->segmentLength = header.segmentLength;
+    filter->segmentCount = header.segmentCount;
+    filter->arrayLength = header.arrayLength;
+    if (!allocateFingerprints(filter)) {
+        memset(filter, 0, sizeof(*filter));
+        return false;
+    }
+    memcpy(filter->fingerprints, (const char*)buffer + sizeof(header), fuseSizeInBytes(filter));
+    filter->count = header.count;
+    return true;
+}
+
+bool fuseWriteFile(const FuseFilter* filter, const char* path) {
+    WRITE_SERIALIZED(fuse, filter, path);
+}
+
+bool fuseReadFile(FuseFilter* filter, const char* path) {
+    READ_SERIALIZED(fuse, filter, path);
+}
@@ -0,0 +1,141 @@
+/*
+ * membership_filter.h - Bloom, Cuckoo and Binary Fuse Filters for Negative Lookups
+ *
+ * search() on the hash table in docs/12-algorithms/02-searching-algorithms.md
+ * probes until it reaches an empty slot, searchByValue() in
+ * docs/11-data-structures/01-linked-lists.md walks the whole list, and
+ * searchNode() in docs/11-data-structures/03-trees.md walks to a leaf, all
+ * to answer "not present". When most lookups miss, a small filter in front
+ * answers most of them from one or two cache lines. A filter can say
+ * "maybe present" for a key that is absent (a false positive, at the rate
+ * you configure), but never "absent" for a key that was added:
+ *
+ *   BloomFilter   blocked (split-block) Bloom filter. Each key sets one
+ *                 bit in each of the eight 32-bit lanes of one 256-bit
+ *                 block, so a lookup reads a single cache line and tests
+ *                 all eight bits with one AVX2 (or AVX-512, two keys at a
+ *                 time) compare. Keys can be added at any time, never
+ *                 removed.
+ *   CuckooFilter  buckets of four 8-, 16- or 32-bit fingerprints; each key
+ *                 has two candidate buckets. Supports removal of keys that
+ *                 were added. Adding fails once the table is about 95% full.
+ *   FuseFilter    binary fuse filter: built once from a fixed key set; the
+ *                 smallest of the three (about 1.13 fingerprints per key)
+ *                 and a lookup XORs three fingerprints.
+ *
+ * The false-positive rate passed to the constructors sets the size: the
+ * Bloom filter picks its bits per key from it; the other two pick the
+ * narrowest fingerprint (8, 16 or 32 bits) that meets it.
+ *
+ * Keys are uint64_t; pass ints as (uint64_t)(uint32_t)key or use a hash of
+ * a string. Lookups may run on many threads at once; changes may not run
+ * alongside anything else. Every filter serializes to a buffer or a file
+ * (machine byte order, checked on load).
+ *
+ * The Bloom lookup kernel is picked at startup (see ../dispatch/cpu_dispatch.h).
+ * Compile together with membership_filter.c and the CPU dispatch layer:
+ *   gcc -O2 -o program program.c membership_filter.c ../dispatch/cpu_dispatch.c -lm
+ */
+
+#ifndef MEMBERSHIP_FILTER_H
+#define MEMBERSHIP_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BLOOM_BLOCK_LANES 8        // 32-bit lanes per 256-bit block
+#define CUCKOO_BUCKET_SLOTS 4
+
+// ========== Blocked Bloom Filter ==========
+
+typedef struct {
+    uint32_t* lanes;        // blockCount * 8, 64-byte aligned
+    uint64_t blockCount;
+    uint64_t count;         // keys added (repeats included)
+} BloomFilter;
+
+// Sized for expectedKeys at falsePositiveRate (0 < rate < 1)
+bool bloomInit(BloomFilter* filter, size_t expectedKeys, double falsePositiveRate);
+void bloomDestroy(BloomFilter* filter);
+void bloomAdd(BloomFilter* filter, uint64_t key);
+bool bloomContains(const BloomFilter* filter, uint64_t key);
+
+// results[i] = bloomContains(filter, keys[i]). Faster per key than single
+// lookups on large filters: blocks are prefetched a few keys ahead.
+void bloomContainsBatch(const BloomFilter* filter, const uint64_t* keys, size_t count, bool* results);
+
+// Expected rate with the keys added so far
+double bloomFalsePositiveRate(const BloomFilter* filter);
+size_t bloomSizeInBytes(const BloomFilter* filter);
+
+// ========== Cuckoo Filter ==========
+
+typedef struct {
+    void* slots;                // bucketCount * 4 fingerprints; 0 = empty
+    uint64_t bucketCount;
+    int fingerprintBits;        // 8, 16 or 32
+    uint64_t count;
+    uint32_t victim;            // a fingerprint evicted from a full table, 0 if none
+    uint64_t victimBucket;
+    uint64_t randomState;       // picks which fingerprint to evict
+} CuckooFilter;
+
+bool cuckooInit(CuckooFilter* filter, size_t expectedKeys, double falsePositiveRate);
+void cuckooDestroy(CuckooFilter* filter);
+
+// false when the filter is full; the filter is unchanged then. A key added
+// twice is stored twice and has to be removed twice.
+bool cuckooAdd(CuckooFilter* filter, uint64_t key);
+
+// Only remove keys that were added: removing any other key that happens to
+// share a fingerprint removes that key instead. false if not found.
+bool cuckooRemove(CuckooFilter* filter, uint64_t key);
+bool cuckooContains(const CuckooFilter* filter, uint64_t key);
+double cuckooFalsePositiveRate(const CuckooFilter* filter);
+size_t cuckooSizeInBytes(const CuckooFilter* filter);
+
+// ========== Binary Fuse Filter ==========
+
+typedef struct {
+    void* fingerprints;         // arrayLength of them
+    int fingerprintBits;        // 8, 16 or 32
+    uint64_t seed;
+    uint32_t segmentLength;     // a power of two
+    uint32_t segmentCount;
+    uint32_t arrayLength;       // (segmentCount + 2) * segmentLength
+    uint64_t count;             // distinct keys
+} FuseFilter;
+
+// Builds the filter for keys[0 .. count-1]; repeated keys are allowed
+bool fuseBuild(FuseFilter* filter, const uint64_t* keys, size_t count, double falsePositiveRate);
+void fuseDestroy(FuseFilter* filter);
+bool fuseContains(const FuseFilter* filter, uint64_t key);
+double fuseFalsePositiveRate(const FuseFilter* filter);
+size_t fuseSizeInBytes(const FuseFilter* filter);
+
+// ========== Serialization ==========
+//
+// Serialize writes SerializedSize bytes to buffer. Deserialize initializes
+// the filter with its own copy of the data; it rejects data of another
+// filter type, format version or byte order, and damaged sizes.
+
+size_t bloomSerializedSize(const BloomFilter* filter);
+size_t bloomSerialize(const BloomFilter* filter, void* buffer);
+bool bloomDeserialize(BloomFilter* filter, const void* buffer, size_t size);
+bool bloomWriteFile(const BloomFilter* filter, const char* path);
+bool bloomReadFile(BloomFilter* filter, const char* path);
+
+size_t cuckooSerializedSize(const CuckooFilter* filter);
+size_t cuckooSerialize(const CuckooFilter* filter, void* buffer);
+bool cuckooDeserialize(CuckooFilter* filter, const void* buffer, size_t size);
+bool cuckooWriteFile(const CuckooFilter* filter, const char* path);
+bool cuckooReadFile(CuckooFilter* filter, const char* path);
+
+size_t fuseSerializedSize(const FuseFilter* filter);
+size_t fuseSerialize(const FuseFilter* filter, void* buffer);
+bool fuseDeserialize(FuseFilter* filter, const void* buffer, size_t size);
+bool fuseWriteFile(const FuseFilter* filter, const char* path);
+bool fuseReadFile(FuseFilter* filter, const char* path);
+
+#endif
@@ -0,0 +1,663 @@
+/*
+ * Membership Filter Demo: Answering Misses Before the Hash Table, List and BST
+ *
+ * Checks the three filters of membership_filter.h: no false negatives, the
+ * measured false-positive rate against the configured one, removal from
+ * the cuckoo filter, repeated keys in the fuse filter, every Bloom kernel
+ * variant, and serialization to a buffer and a file. Then it puts each
+ * filter in front of search() (hash table with linear probing),
+ * searchNode() (BST) and searchByValue() (linked list) from the docs and
+ * measures lookups per second when most lookups miss.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o membership_filter_demo membership_filter_demo.c membership_filter.c \
+ *       ../dispatch/cpu_dispatch.c -lm
+ *   ./membership_filter_demo [keys in millions] [miss percent]
+ *   CPU_DISPATCH=scalar ./membership_filter_demo      (no SIMD)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include "membership_filter.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#define BATCH 1024                 // keys per bloomContainsBatch call
+#define LIST_KEYS 20000            // the list is walked to the end on every miss
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Keys that are added are odd, keys that are never added are even
+static uint64_t presentKey(unsigned* seed) {
+    return (nextRandom(seed) & 0x7FFFFFFFu) | 1;
+}
+
+static uint64_t absentKey(unsigned* seed) {
+    return nextRandom(seed) & 0x7FFFFFFEu;
+}
+
+// ========== Structures from the Docs ==========
+
+// Hash table with linear probing (searching algorithms), sized by the caller
+typedef struct {
+    int key;
+    int value;
+    bool occupied;
+} HashEntry;
+
+typedef struct {
+    HashEntry* table;
+    int size;
+} HashTable;
+
+static int hash(HashTable* ht, int key) {
+    return key % ht->size;
+}
+
+static bool createHashTable(HashTable* ht, int size) {
+    ht->table = (HashEntry*)calloc(size, sizeof(HashEntry));
+    ht->size = size;
+    return ht->table != NULL;
+}
+
+static void insert(HashTable* ht, int key, int value) {
+    int index = hash(ht, key);
+    int originalIndex = index;
+    do {
+        if (!ht->table[index].occupied) {
+            ht->table[index].key = key;
+            ht->table[index].value = value;
+            ht->table[index].occupied = true;
+            return;
+        }
+        index = (index + 1) % ht->size;
+    } while (index != originalIndex);
+    printf("Hash table is full\n");
+}
+
+static int search(HashTable* ht, int key) {
+    int index = hash(ht, key);
+    int originalIndex = index;
+    do {
+        if (ht->table[index].occupied && ht->table[index].key == key) {
+            return ht->table[index].value;
+        }
+        index = (index + 1) % ht->size;
+    } while (index != originalIndex && ht->table[index].occupied);
+    return -1;   // Not found
+}
+
+// Binary search tree (trees)
+typedef struct TreeNode {
+    int data;
+    struct TreeNode* left;
+    struct TreeNode* right;
+} TreeNode;
+
+static TreeNode* createNode(int data) {
+    TreeNode* newNode = (TreeNode*)malloc(sizeof(TreeNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    newNode->data = data;
+    newNode->left = NULL;
+    newNode->right = NULL;
+    return newNode;
+}
+
+// Iterative, so that a degenerate tree cannot overflow the stack
+static TreeNode* insertNode(TreeNode* root, int data) {
+    TreeNode** link = &root;
+    while (*link != NULL) {
+        if (data < (*link)->data) {
+            link = &(*link)->left;
+        } else if (data > (*link)->data) {
+            link = &(*link)->right;
+        } else {
+            return root;
+        }
+    }
+    *link = createNode(data);
+    return root;
+}
+
+static TreeNode* searchNode(TreeNode* root, int data) {
+    if (root == NULL || root->data == data) {
+        return root;
+    }
+    if (data < root->data) {
+        return searchNode(root->left, data);
+    }
+    return searchNode(root->right, data);
+}
+
+static void freeTree(TreeNode* root) {
+    while (root != NULL) {
+        if (root->left != NULL) {   // rotate the left child up, then continue
+            TreeNode* left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            TreeNode* right = root->right;
+            free(root);
+            root = right;
+        }
+    }
+}
+
+// Singly linked list (linked lists)
+typedef struct Node {
+    int data;
+    struct Node* next;
+} Node;
+
+typedef struct {
+    Node* head;
+    int size;
+} LinkedList;
+
+static Node* searchByValue(LinkedList* list, int value) {
+    Node* current = list->head;
+    while (current != NULL) {
+        if (current->data == value) {
+            return current;
+        }
+        current = current->next;
+    }
+    return NULL;   // Not found
+}
+
+static void freeList(LinkedList* list) {
+    while (list->head != NULL) {
+        Node* next = list->head->next;
+        free(list->head);
+        list->head = next;
+    }
+}
+
+// ========== Checks ==========
+
+static bool checkRates(unsigned* seed) {
+    printf("\n=== False-Positive Rates (200000 keys, 2000000 absent lookups) ===\n");
+    printf("%-8s %9s %10s %10s %10s %8s\n", "filter", "target", "expected", "measured", "bits/key", "result");
+    size_t keyCount = 200000;
+    size_t probes = 2000000;
+    uint64_t* keys = malloc(keyCount * sizeof(uint64_t));
+    if (keys == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < keyCount; i++) {
+        keys[i] = presentKey(seed);
+    }
+
+    bool ok = true;
+    double targets[] = { 0.05, 0.01, 0.001, 0.00001 };
+    for (int t = 0; t < 4; t++) {
+        BloomFilter bloom;
+        CuckooFilter cuckoo;
+        FuseFilter fuse;
+        if (!bloomInit(&bloom, keyCount, targets[t]) || !cuckooInit(&cuckoo, keyCount, targets[t]) ||
+            !fuseBuild(&fuse, keys, keyCount, targets[t])) {
+            return false;
+        }
+        bool noFalseNegatives = true;
+        for (size_t i = 0; i < keyCount; i++) {
+            bloomAdd(&bloom, keys[i]);
+            noFalseNegatives = cuckooAdd(&cuckoo, keys[i]) && noFalseNegatives;
+        }
+        for (size_t i = 0; i < keyCount; i++) {
+            noFalseNegatives = noFalseNegatives && bloomContains(&bloom, keys[i]) &&
+                               cuckooContains(&cuckoo, keys[i]) && fuseContains(&fuse, keys[i]);
+        }
+
+        size_t positives[3] = { 0, 0, 0 };
+        for (size_t i = 0; i < probes; i++) {
+            uint64_t key = absentKey(seed);
+            positives[0] += bloomContains(&bloom, key);
+            positives[1] += cuckooContains(&cuckoo, key);
+            positives[2] += fuseContains(&fuse, key);
+        }
+        const char* names[] = { "bloom", "cuckoo", "fuse" };
+        double expected[] = { bloomFalsePositiveRate(&bloom), cuckooFalsePositiveRate(&cuckoo),
+                              fuseFalsePositiveRate(&fuse) };
+        size_t bytes[] = { bloomSizeInBytes(&bloom), cuckooSizeInBytes(&cuckoo), fuseSizeInBytes(&fuse) };
+        for (int f = 0; f < 3; f++) {
+            double measured = (double)positives[f] / (double)probes;
+            // Allow for sampling noise: 4 standard deviations
+            double allowed = targets[t] + 4.0 * sqrt(targets[t] / probes) + 4.0 / probes;
+            bool within = noFalseNegatives && measured <= allowed;
+            ok = ok && within;
+            printf("%-8s %9.5f %10.6f %10.6f %10.1f %8s\n", names[f], targets[t], expected[f], measured,
+                   bytes[f] * 8.0 / keyCount, within ? "ok" : "TOO HIGH");
+        }
+        bloomDestroy(&bloom);
+        cuckooDestroy(&cuckoo);
+        fuseDestroy(&fuse);
+    }
+    free(keys);
+    return ok;
+}
+
+static bool checkBloomVariants(unsigned* seed) {
+    size_t keyCount = 100000;
+    size_t queryCount = 50000;
+    BloomFilter bloom;
+    uint64_t* queries = malloc(queryCount * sizeof(uint64_t));
+    bool* expected = malloc(queryCount * sizeof(bool));
+    bool* results = malloc(queryCount * sizeof(bool));
+    if (queries == NULL || expected == NULL || results == NULL || !bloomInit(&bloom, keyCount, 0.01)) {
+        printf("Memory allocation failed\n");
+        free(queries);
+        free(expected);
+        free(results);
+        return false;
+    }
+    for (size_t i = 0; i < keyCount; i++) {
+        uint64_t key = presentKey(seed);
+        bloomAdd(&bloom, key);
+        if (i < queryCount / 2) {
+            queries[2 * i] = key;
+            queries[2 * i + 1] = absentKey(seed);
+        }
+    }
+
+    const DispatchKernel* kernel = dispatchFind("bloomBatchKernel");
+    dispatchUseVariant(kernel, kernel->variantCount - 1);   // scalar
+    for (size_t i = 0; i < queryCount; i++) {
+        expected[i] = bloomContains(&bloom, queries[i]);
+    }
+    bool ok = true;
+    for (int v = 0; v < kernel->variantCount; v++) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        bool same = true;
+        // Every batch length up to 40 for the tails, then the whole array
+        for (size_t length = 0; length <= 40; length++) {
+            bloomContainsBatch(&bloom, queries + length, length, results);
+            same = same && memcmp(results, expected + length, length * sizeof(bool)) == 0;
+        }
+        bloomContainsBatch(&bloom, queries, queryCount, results);
+        same = same && memcmp(results, expected, queryCount * sizeof(bool)) == 0;
+        for (size_t i = 0; i < queryCount; i += 7) {
+            same = same && bloomContains(&bloom, queries[i]) == expected[i];
+        }
+        if (!same) {
+            printf("  %s differs\n", kernel->variants[v].name);
+        }
+        ok = ok && same;
+    }
+    dispatchRestore(kernel);
+    printf("bloom kernels, batches of 0..40 and %zu keys: %s\n", queryCount, ok ? "all match" : "MISMATCH");
+    bloomDestroy(&bloom);
+    free(queries);
+    free(expected);
+    free(results);
+    return ok;
+}
+
+static bool checkCuckoo(unsigned* seed) {
+    CuckooFilter cuckoo;
+    size_t capacity = 1 << 15;
+    uint64_t* keys = malloc(capacity * sizeof(uint64_t));
+    if (keys == NULL || !cuckooInit(&cuckoo, 10000, 0.001)) {
+        printf("Memory allocation failed\n");
+        free(keys);
+        return false;
+    }
+    // Fill until an add fails: it must leave the filter unchanged
+    size_t added = 0;
+    while (added < capacity) {
+        keys[added] = presentKey(seed);
+        if (!cuckooAdd(&cuckoo, keys[added])) {
+            break;
+        }
+        added++;
+    }
+    bool ok = added < capacity && cuckoo.count == added;
+    for (size_t i = 0; i < added; i++) {
+        ok = ok && cuckooContains(&cuckoo, keys[i]);
+    }
+    double load = (double)added / (double)(cuckoo.bucketCount * CUCKOO_BUCKET_SLOTS);
+    printf("cuckoo filled to %.1f%% (%zu keys) before an add failed, all found: %s\n", 100.0 * load, added,
+           ok ? "yes" : "NO");
+
+    // Remove every other key: the rest must stay, most removed keys go
+    size_t stillFound = 0;
+    bool removeOk = true;
+    for (size_t i = 0; i < added; i += 2) {
+        removeOk = cuckooRemove(&cuckoo, keys[i]) && removeOk;
+    }
+    for (size_t i = 0; i < added; i++) {
+        if (i % 2 == 1) {
+            removeOk = removeOk && cuckooContains(&cuckoo, keys[i]);
+        } else {
+            stillFound += cuckooContains(&cuckoo, keys[i]);
+        }
+    }
+    removeOk = removeOk && cuckoo.count == added / 2 && stillFound < added / 100;
+    // Space freed by removal is usable again, up to 90% load
+    size_t refill = (size_t)(0.9 * (double)(cuckoo.bucketCount * CUCKOO_BUCKET_SLOTS));
+    for (size_t i = 0; i < added && cuckoo.count < refill; i += 2) {
+        removeOk = removeOk && cuckooAdd(&cuckoo, keys[i]) && cuckooContains(&cuckoo, keys[i]);
+    }
+    removeOk = removeOk && cuckoo.count == refill;
+    printf("cuckoo removal of every other key (%zu removed keys still reported), refill to 90%%: %s\n",
+           stillFound, removeOk ? "all match" : "MISMATCH");
+    cuckooDestroy(&cuckoo);
+    free(keys);
+    return ok && removeOk;
+}
+
+static bool checkFuse(unsigned* seed) {
+    bool ok = true;
+    size_t counts[] = { 0, 1, 2, 3, 10, 100, 1000, 100000 };
+    uint64_t* keys = malloc(3 * 100000 * sizeof(uint64_t));
+    if (keys == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (int c = 0; c < 8 && ok; c++) {
+        // Every (distinct) key three times, in shuffled order
+        for (size_t i = 0; i < counts[c]; i++) {
+            keys[i] = keys[counts[c] + i] = keys[2 * counts[c] + i] = ((uint64_t)i << 32) | presentKey(seed);
+        }
+        size_t total = 3 * counts[c];
+        for (size_t i = total; i > 1; i--) {
+            size_t j = nextRandom(seed) % i;
+            uint64_t swap = keys[i - 1];
+            keys[i - 1] = keys[j];
+            keys[j] = swap;
+        }
+        FuseFilter fuse;
+        ok = fuseBuild(&fuse, keys, total, 0.001) && fuse.count == counts[c];
+        for (size_t i = 0; i < total && ok; i++) {
+            ok = fuseContains(&fuse, keys[i]);
+        }
+        fuseDestroy(&fuse);
+    }
+    printf("fuse filters of 0 to 100000 keys, each key repeated: %s\n", ok ? "all match" : "MISMATCH");
+    free(keys);
+    return ok;
+}
+
+// Round trip through a buffer and through a file, then damaged data: cut
+// short, a wrong magic, and a flipped bit in the size field at sizeField
+#define CHECK_ROUND_TRIP(prefix, Type, original, keys, count, path, sizeField, ok)           \
+    do {                                                                                     \
+        size_t size = prefix##SerializedSize(original);                                     \
+        char* buffer = malloc(size);                                                         \
+        Type copy, loaded;                                                                   \
+        bool roundTrip = buffer != NULL && prefix##Serialize(original, buffer) == size &&    \
+                         prefix##Deserialize(&copy, buffer, size);                           \
+        roundTrip = roundTrip && prefix##WriteFile(original, path) && prefix##ReadFile(&loaded, path); \
+        for (size_t i = 0; i < (count) && roundTrip; i++) {                                  \
+            bool expected = prefix##Contains(original, (keys)[i]);                           \
+            roundTrip = prefix##Contains(&copy, (keys)[i]) == expected &&                    \
+                        prefix##Contains(&loaded, (keys)[i]) == expected;                    \
+        }                                                                                    \
+        if (buffer != NULL && roundTrip) {                                                   \
+            prefix##Destroy(&copy);                                                          \
+            prefix##Destroy(&loaded);                                                        \
+            printf("  (damaged data, expect three rejections)\n");                           \
+            roundTrip = !prefix##Deserialize(&copy, buffer, size - 1);                       \
+            buffer[0] ^= 1;                                                                  \
+            roundTrip = !prefix##Deserialize(&copy, buffer, size) && roundTrip;              \
+            buffer[0] ^= 1;                                                                  \
+            buffer[sizeField] ^= 0x40;                                                       \
+            roundTrip = !prefix##Deserialize(&copy, buffer, size) && roundTrip;              \
+        }                                                                                    \
+        remove(path);                                                                        \
+        free(buffer);                                                                        \
+        printf("%-7s serialized (%zu bytes), read back: %s\n", #prefix, size,               \
+               roundTrip ? "all match" : "MISMATCH");                                        \
+        ok = ok && roundTrip;                                                                \
+    } while (0)
+
+static bool checkSerialization(unsigned* seed) {
+    size_t keyCount = 50000;
+    uint64_t* keys = malloc(2 * keyCount * sizeof(uint64_t));
+    BloomFilter bloom;
+    CuckooFilter cuckoo;
+    FuseFilter fuse;
+    if (keys == NULL || !bloomInit(&bloom, keyCount, 0.01) || !cuckooInit(&cuckoo, keyCount, 0.01)) {
+        printf("Memory allocation failed\n");
+        free(keys);
+        return false;
+    }
+    for (size_t i = 0; i < keyCount; i++) {
+        keys[2 * i] = presentKey(seed);
+        keys[2 * i + 1] = absentKey(seed);
+        bloomAdd(&bloom, keys[2 * i]);
+        cuckooAdd(&cuckoo, keys[2 * i]);
+    }
+    bool ok = fuseBuild(&fuse, keys, keyCount, 0.01);   // the first half of the keys
+    CHECK_ROUND_TRIP(bloom, BloomFilter, &bloom, keys, 2 * keyCount, "membership_filter_demo.bin", 16, ok);
+    CHECK_ROUND_TRIP(cuckoo, CuckooFilter, &cuckoo, keys, 2 * keyCount, "membership_filter_demo.bin", 16, ok);
+    CHECK_ROUND_TRIP(fuse, FuseFilter, &fuse, keys, 2 * keyCount, "membership_filter_demo.bin", 32, ok);
+    bloomDestroy(&bloom);
+    cuckooDestroy(&cuckoo);
+    fuseDestroy(&fuse);
+    free(keys);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+typedef bool (*Lookup)(void* structure, uint64_t key);
+
+static bool lookupTable(void* structure, uint64_t key) {
+    return search((HashTable*)structure, (int)key) != -1;
+}
+
+static bool lookupTree(void* structure, uint64_t key) {
+    return searchNode((TreeNode*)structure, (int)key) != NULL;
+}
+
+static bool lookupList(void* structure, uint64_t key) {
+    return searchByValue((LinkedList*)structure, (int)key) != NULL;
+}
+
+typedef struct {
+    BloomFilter bloom;
+    CuckooFilter cuckoo;
+    FuseFilter fuse;
+} Filters;
+
+// Million lookups per second for: no filter, bloom, batched bloom, cuckoo, fuse
+static void timeLookups(const char* label, Lookup lookup, void* structure, const Filters* filters,
+                        const uint64_t* queries, size_t queryCount) {
+    printf("%-26s", label);
+    size_t found[5] = { 0, 0, 0, 0, 0 };
+    bool maybe[BATCH];
+    for (int method = 0; method < 5; method++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t begin = 0; begin < queryCount; begin += BATCH) {
+            size_t length = queryCount - begin < BATCH ? queryCount - begin : BATCH;
+            const uint64_t* keys = queries + begin;
+            if (method == 2) {
+                bloomContainsBatch(&filters->bloom, keys, length, maybe);
+            }
+            for (size_t i = 0; i < length; i++) {
+                bool pass = method == 0 || (method == 1 && bloomContains(&filters->bloom, keys[i])) ||
+                            (method == 2 && maybe[i]) ||
+                            (method == 3 && cuckooContains(&filters->cuckoo, keys[i])) ||
+                            (method == 4 && fuseContains(&filters->fuse, keys[i]));
+                found[method] += pass && lookup(structure, keys[i]);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf(" %10.2f", queryCount / elapsedSeconds(start, end) / 1e6);
+    }
+    bool same = found[1] == found[0] && found[2] == found[0] && found[3] == found[0] && found[4] == found[0];
+    printf("%s\n", same ? "" : "  MISMATCH");
+}
+
+static bool buildFilters(Filters* filters, const uint64_t* keys, size_t count) {
+    if (!bloomInit(&filters->bloom, count, 0.01) || !cuckooInit(&filters->cuckoo, count, 0.01) ||
+        !fuseBuild(&filters->fuse, keys, count, 0.01)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bloomAdd(&filters->bloom, keys[i]);
+        if (!cuckooAdd(&filters->cuckoo, keys[i])) {
+            printf("Cuckoo filter is full\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static void destroyFilters(Filters* filters) {
+    bloomDestroy(&filters->bloom);
+    cuckooDestroy(&filters->cuckoo);
+    fuseDestroy(&filters->fuse);
+}
+
+// queries[i]: an absent key with probability missPercent, else one of keys[]
+static void makeQueries(uint64_t* queries, size_t queryCount, const uint64_t* keys, size_t keyCount,
+                        int missPercent, unsigned* seed) {
+    for (size_t i = 0; i < queryCount; i++) {
+        if ((int)(nextRandom(seed) % 100) < missPercent) {
+            queries[i] = absentKey(seed);
+        } else {
+            queries[i] = keys[nextRandom(seed) % keyCount];
+        }
+    }
+}
+
+static void benchmark(size_t keyCount, int missPercent) {
+    unsigned seed = 12345;
+    uint64_t* keys = malloc(keyCount * sizeof(uint64_t));
+    uint64_t* queries = malloc(keyCount * sizeof(uint64_t));
+    HashTable table = { NULL, 0 };
+    // The docs' table at 75% load; an odd size spreads the odd keys evenly
+    if (keys == NULL || queries == NULL || !createHashTable(&table, (int)(keyCount * 4 / 3) | 1)) {
+        printf("Memory allocation failed\n");
+        free(keys);
+        free(queries);
+        free(table.table);
+        return;
+    }
+    TreeNode* root = NULL;
+    for (size_t i = 0; i < keyCount; i++) {
+        keys[i] = presentKey(&seed);
+        insert(&table, (int)keys[i], (int)i);
+        root = insertNode(root, (int)keys[i]);
+    }
+
+    Filters filters;
+    if (!buildFilters(&filters, keys, keyCount)) {
+        free(keys);
+        free(queries);
+        free(table.table);
+        freeTree(root);
+        return;
+    }
+    printf("\n=== %zu Keys, %d%% of Lookups Miss, Million Lookups/s ===\n", keyCount, missPercent);
+    printf("Filters at 1%%: bloom %.1f, cuckoo %.1f, fuse %.1f bits per key\n",
+           bloomSizeInBytes(&filters.bloom) * 8.0 / keyCount, cuckooSizeInBytes(&filters.cuckoo) * 8.0 / keyCount,
+           fuseSizeInBytes(&filters.fuse) * 8.0 / keyCount);
+    printf("%-26s %10s %10s %10s %10s %10s\n", "", "no filter", "bloom", "batched", "cuckoo", "fuse");
+    makeQueries(queries, keyCount, keys, keyCount, missPercent, &seed);
+    timeLookups("hash table search()", lookupTable, &table, &filters, queries, keyCount);
+    timeLookups("BST searchNode()", lookupTree, root, &filters, queries, keyCount);
+    destroyFilters(&filters);
+
+    // The list gets fewer keys: a miss walks all of it
+    size_t listKeys = keyCount < LIST_KEYS ? keyCount : LIST_KEYS;
+    LinkedList list = { NULL, 0 };
+    for (size_t i = 0; i < listKeys; i++) {
+        Node* node = malloc(sizeof(Node));
+        if (node == NULL) {
+            printf("Memory allocation failed\n");
+            break;
+        }
+        node->data = (int)keys[i];
+        node->next = list.head;
+        list.head = node;
+        list.size++;
+    }
+    if (buildFilters(&filters, keys, listKeys)) {
+        makeQueries(queries, listKeys, keys, listKeys, missPercent, &seed);
+        char label[64];
+        snprintf(label, sizeof(label), "list searchByValue() (%zuK)", listKeys / 1000);
+        timeLookups(label, lookupList, &list, &filters, queries, listKeys);
+        destroyFilters(&filters);
+    }
+
+    freeList(&list);
+    freeTree(root);
+    free(table.table);
+    free(keys);
+    free(queries);
+}
+
+int main(int argc, char* argv[]) {
+    double millions = argc > 1 ? atof(argv[1]) : 1.0;
+    int missPercent = argc > 2 ? atoi(argv[2]) : 90;
+    if (!(millions >= 0.01 && millions <= 100) || missPercent < 0 || missPercent > 100) {
+        printf("Usage: %s [keys in millions, 0.01 to 100] [miss percent, 0 to 100]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Examples ===\n");
+    int arr[] = { 64, 34, 25, 12, 22, 11, 90, 45, 78, 33 };
+    uint64_t keys[10];
+    BloomFilter bloom;
+    CuckooFilter cuckoo;
+    FuseFilter fuse;
+    for (int i = 0; i < 10; i++) {
+        keys[i] = (uint64_t)arr[i];
+    }
+    if (!bloomInit(&bloom, 10, 0.01) || !cuckooInit(&cuckoo, 10, 0.01) || !fuseBuild(&fuse, keys, 10, 0.01)) {
+        return 1;
+    }
+    for (int i = 0; i < 10; i++) {
+        bloomAdd(&bloom, keys[i]);
+        cuckooAdd(&cuckoo, keys[i]);
+    }
+    int targets[] = { 22, 99 };
+    for (int t = 0; t < 2; t++) {
+        printf("%d: bloom %s, cuckoo %s, fuse %s\n", targets[t],
+               bloomContains(&bloom, (uint64_t)targets[t]) ? "maybe present" : "absent",
+               cuckooContains(&cuckoo, (uint64_t)targets[t]) ? "maybe present" : "absent",
+               fuseContains(&fuse, (uint64_t)targets[t]) ? "maybe present" : "absent");
+    }
+    cuckooRemove(&cuckoo, 22);
+    printf("after cuckooRemove(22): cuckoo %s\n", cuckooContains(&cuckoo, 22) ? "maybe present" : "absent");
+    bloomDestroy(&bloom);
+    cuckooDestroy(&cuckoo);
+    fuseDestroy(&fuse);
+
+    unsigned seed = 2463534242u;
+    bool ok = checkRates(&seed);
+    printf("\n=== Checks ===\n");
+    ok = checkBloomVariants(&seed) && ok;
+    ok = checkCuckoo(&seed) && ok;
+    ok = checkFuse(&seed) && ok;
+    ok = checkSerialization(&seed) && ok;
+
+    benchmark((size_t)(millions * 1000000), missPercent);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,766 @@
+/*
+ * Static (Implicit) Search Trees for Read-Mostly Lookups
+ *
+ * searchNode() in docs/11-data-structures/03-trees.md follows left/right
+ * pointers, and every hop lands on a node that was malloc'd somewhere else
+ * in the heap. For lookup tables that are built once and queried millions
+ * of times, a "frozen" tree stored in an array is much faster:
+ *
+ * - Eytzinger (BFS) layout: the root is at index 1 and the children of
+ *   index k are at 2k and 2k+1. No pointers are stored, the keys are the
+ *   nodes, and the first levels of the tree share a few cache lines.
+ *   The search loop is branch-free and prefetches 4 levels ahead
+ *   (16 keys = one 64-byte cache line).
+ * - van Emde Boas layout: the tree is split recursively into a top half
+ *   and bottom subtrees that are stored contiguously, so each subtree
+ *   of about sqrt(n) keys is close together at every scale. Tables built
+ *   once per tree height give each search step its array position in O(1).
+ *
+ * The Eytzinger set supports search, lower bound, predecessor and range
+ * queries. A LookupTable wrapper holds two versions of the set: a
+ * background thread rebuilds the inactive copy and publishes it with one
+ * atomic store, while readers keep using the old copy until they release it.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -pthread -o static_search_tree static_search_tree.c
+ *   ./static_search_tree               (demo + 1M-key benchmark)
+ *   ./static_search_tree 100000000     (benchmark with 100M keys, ~3.5 GB)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+#define KEYS_PER_LINE (CACHE_LINE / sizeof(int))
+
+// ========== Eytzinger Layout ==========
+
+typedef struct {
+    int* keys;      // keys[1..size] in BFS order, keys[0] unused
+    size_t size;
+} StaticSet;
+
+// Place sorted[] into BFS order with an inorder walk of the implicit tree.
+// Recursion depth is the tree height (about log2(n)), never n.
+static size_t eytzingerFill(const int* sorted, int* keys, size_t next,
+                            size_t k, size_t size) {
+    if (k <= size) {
+        next = eytzingerFill(sorted, keys, next, 2 * k, size);
+        keys[k] = sorted[next++];
+        next = eytzingerFill(sorted, keys, next, 2 * k + 1, size);
+    }
+    return next;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Build from keys in any order; the input array is sorted and deduplicated
+// in place
+StaticSet* staticSetBuild(int* input, size_t count) {
+    StaticSet* set = (StaticSet*)malloc(sizeof(StaticSet));
+    if (set == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    qsort(input, count, sizeof(int), compareInts);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (unique == 0 || input[i] != input[unique - 1]) {
+            input[unique++] = input[i];
+        }
+    }
+
+    // Round the allocation up so the whole array is cache-line aligned
+    size_t bytes = (unique + 1) * sizeof(int);
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    set->keys = (int*)aligned_alloc(CACHE_LINE, bytes);
+    if (set->keys == NULL) {
+        printf("Memory allocation failed\n");
+        free(set);
+        return NULL;
+    }
+
+    set->size = unique;
+    set->keys[0] = 0;
+    eytzingerFill(input, set->keys, 0, 1, unique);
+    return set;
+}
+
+void staticSetDestroy(StaticSet* set) {
+    if (set != NULL) {
+        free(set->keys);
+        free(set);
+    }
+}
+
+// Index of the first key >= x, or 0 if every key is smaller
+static inline size_t staticSetLowerBound(const StaticSet* set, int x) {
+    const int* keys = set->keys;
+    size_t k = 1;
+    while (k <= set->size) {
+        __builtin_prefetch(keys + k * KEYS_PER_LINE);
+        k = 2 * k + (keys[k] < x);
+    }
+    // Undo the trailing "went right" steps plus the final "went left" step
+    k >>= __builtin_ffsll((long long)~k);
+    return k;
+}
+
+// Index of the first key > x, or 0 if there is none
+static inline size_t staticSetUpperBound(const StaticSet* set, int x) {
+    const int* keys = set->keys;
+    size_t k = 1;
+    while (k <= set->size) {
+        __builtin_prefetch(keys + k * KEYS_PER_LINE);
+        k = 2 * k + (keys[k] <= x);
+    }
+    k >>= __builtin_ffsll((long long)~k);
+    return k;
+}
+
+int staticSetContains(const StaticSet* set, int x) {
+    size_t k = staticSetLowerBound(set, x);
+    return k != 0 && set->keys[k] == x;
+}
+
+// Inorder successor of index k in the implicit tree (0 = none)
+static size_t eytzingerNext(size_t k, size_t size) {
+    if (2 * k + 1 <= size) {
+        k = 2 * k + 1;
+        while (2 * k <= size) {
+            k = 2 * k;
+        }
+        return k;
+    }
+    while (k & 1) {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+// Inorder predecessor of index k in the implicit tree (0 = none)
+static size_t eytzingerPrev(size_t k, size_t size) {
+    if (2 * k <= size) {
+        k = 2 * k;
+        while (2 * k + 1 <= size) {
+            k = 2 * k + 1;
+        }
+        return k;
+    }
+    while (k > 1 && !(k & 1)) {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+// Largest key <= x; returns 0 if there is none
+int staticSetPredecessor(const StaticSet* set, int x, int* result) {
+    if (set->size == 0) {
+        return 0;
+    }
+
+    size_t k = staticSetUpperBound(set, x);
+    if (k == 0) {
+        // Every key is <= x: the answer is the maximum (rightmost node)
+        k = 1;
+        while (2 * k + 1 <= set->size) {
+            k = 2 * k + 1;
+        }
+    } else {
+        k = eytzingerPrev(k, set->size);
+        if (k == 0) {
+            return 0;
+        }
+    }
+    *result = set->keys[k];
+    return 1;
+}
+
+// Copy keys in [lo, hi] (ascending) into out[0..maxOut-1] and return how
+// many keys are in the range in total
+size_t staticSetRange(const StaticSet* set, int lo, int hi, int* out, size_t maxOut) {
+    size_t found = 0;
+    if (lo > hi) {
+        return 0;
+    }
+
+    for (size_t k = staticSetLowerBound(set, lo);
+         k != 0 && set->keys[k] <= hi;
+         k = eytzingerNext(k, set->size)) {
+        if (found < maxOut) {
+            out[found] = set->keys[k];
+        }
+        found++;
+    }
+    return found;
+}
+
+// ========== van Emde Boas Layout ==========
+
+#define VEB_MAX_HEIGHT 64
+
+typedef struct {
+    int* keys;      // perfect tree of 2^height - 1 slots, padded with INT_MAX
+    int height;
+    int hasMax;     // padding hides a real INT_MAX key, so remember it here
+    // Per depth d > 0, from the recursive split that makes depth d the root
+    // level of bottom subtrees: the top block above them starts at depth
+    // topDepth[d] and holds topSize[d] keys, and each bottom subtree holds
+    // bottomSize[d] keys. A lookup then finds each node in O(1).
+    size_t topSize[VEB_MAX_HEIGHT];
+    size_t bottomSize[VEB_MAX_HEIGHT];
+    int topDepth[VEB_MAX_HEIGHT];
+} VebSet;
+
+// Position of BFS index i (1-based) of a perfect tree of the given height
+// inside its van Emde Boas layout: the top height/2 levels are stored first
+// as one recursive block, followed by each bottom subtree in order.
+static size_t vebPosition(size_t i, int height) {
+    size_t offset = 0;
+    while (height > 1) {
+        int topHeight = height / 2;
+        int bottomHeight = height - topHeight;
+        int depth = 63 - __builtin_clzll(i);
+
+        if (depth < topHeight) {
+            height = topHeight;
+            continue;
+        }
+
+        int below = depth - topHeight;
+        size_t subtree = (i >> below) - ((size_t)1 << topHeight);
+        offset += (((size_t)1 << topHeight) - 1) +
+                  subtree * (((size_t)1 << bottomHeight) - 1);
+        i = ((size_t)1 << below) | (i & (((size_t)1 << below) - 1));
+        height = bottomHeight;
+    }
+    return offset;
+}
+
+static size_t vebFill(const int* sorted, size_t count, int* keys, size_t next,
+                      size_t i, int height, int depth) {
+    if (depth < height) {
+        next = vebFill(sorted, count, keys, next, 2 * i, height, depth + 1);
+        keys[vebPosition(i, height)] = (next < count) ? sorted[next] : INT_MAX;
+        next++;
+        next = vebFill(sorted, count, keys, next, 2 * i + 1, height, depth + 1);
+    }
+    return next;
+}
+
+// Fill the per-depth tables for the levels [depth, depth + height), split
+// the same way as vebPosition
+static void vebSplit(VebSet* set, int depth, int height) {
+    if (height <= 1) {
+        return;
+    }
+    int topHeight = height / 2;
+    int bottomHeight = height - topHeight;
+    set->topSize[depth + topHeight] = ((size_t)1 << topHeight) - 1;
+    set->bottomSize[depth + topHeight] = ((size_t)1 << bottomHeight) - 1;
+    set->topDepth[depth + topHeight] = depth;
+    vebSplit(set, depth, topHeight);
+    vebSplit(set, depth + topHeight, bottomHeight);
+}
+
+// Build from sorted, duplicate-free keys
+VebSet* vebSetBuild(const int* sorted, size_t count) {
+    VebSet* set = (VebSet*)malloc(sizeof(VebSet));
+    if (set == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    int height = 1;
+    while ((((size_t)1 << height) - 1) < count) {
+        height++;
+    }
+
+    size_t slots = ((size_t)1 << height) - 1;
+    size_t bytes = (slots * sizeof(int) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    set->keys = (int*)aligned_alloc(CACHE_LINE, bytes);
+    if (set->keys == NULL) {
+        printf("Memory allocation failed\n");
+        free(set);
+        return NULL;
+    }
+
+    set->height = height;
+    set->hasMax = count > 0 && sorted[count - 1] == INT_MAX;
+    vebSplit(set, 0, height);
+    vebFill(sorted, count, set->keys, 0, 1, height, 0);
+    return set;
+}
+
+void vebSetDestroy(VebSet* set) {
+    if (set != NULL) {
+        free(set->keys);
+        free(set);
+    }
+}
+
+int vebSetContains(const VebSet* set, int x) {
+    if (x == INT_MAX) {
+        return set->hasMax;
+    }
+
+    // position[d] is where the node visited at depth d is stored. The
+    // bottom subtree holding the next node hangs below the top block that
+    // starts at position[topDepth], and the low bits of the BFS index i say
+    // which of its subtrees it is.
+    size_t position[VEB_MAX_HEIGHT];
+    size_t i = 1;
+    int found = 0;
+    position[0] = 0;
+    for (int depth = 0; depth < set->height; depth++) {
+        if (depth > 0) {
+            size_t top = set->topSize[depth];
+            position[depth] = position[set->topDepth[depth]] + top + (i & top) * set->bottomSize[depth];
+        }
+        int key = set->keys[position[depth]];
+        found |= key == x;
+        i = 2 * i + (key < x);
+    }
+    return found;
+}
+
+// ========== Atomically Swappable Lookup Table ==========
+
+// Two slots; readers pin the active slot, a rebuild fills the other slot
+// and publishes it by flipping `active`
+typedef struct {
+    StaticSet* slots[2];
+    atomic_int active;
+    atomic_int readers[2];
+    pthread_mutex_t rebuildLock;
+    pthread_t worker;
+    int workerRunning;
+    int* pendingKeys;
+    size_t pendingCount;
+} LookupTable;
+
+LookupTable* lookupTableCreate(int* keys, size_t count) {
+    LookupTable* table = (LookupTable*)malloc(sizeof(LookupTable));
+    if (table == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    table->slots[0] = staticSetBuild(keys, count);
+    if (table->slots[0] == NULL) {
+        free(table);
+        return NULL;
+    }
+    table->slots[1] = NULL;
+    atomic_init(&table->active, 0);
+    atomic_init(&table->readers[0], 0);
+    atomic_init(&table->readers[1], 0);
+    pthread_mutex_init(&table->rebuildLock, NULL);
+    table->workerRunning = 0;
+    table->pendingKeys = NULL;
+    table->pendingCount = 0;
+    return table;
+}
+
+// Pin the current version; pass the returned slot to lookupTableRelease()
+const StaticSet* lookupTableAcquire(LookupTable* table, int* slot) {
+    for (;;) {
+        int index = atomic_load(&table->active);
+        atomic_fetch_add(&table->readers[index], 1);
+        if (atomic_load(&table->active) == index) {
+            *slot = index;
+            return table->slots[index];
+        }
+        // A swap happened in between: back off and retry on the new slot
+        atomic_fetch_sub(&table->readers[index], 1);
+    }
+}
+
+void lookupTableRelease(LookupTable* table, int slot) {
+    atomic_fetch_sub(&table->readers[slot], 1);
+}
+
+static void* lookupTableRebuildWorker(void* arg) {
+    LookupTable* table = (LookupTable*)arg;
+    StaticSet* fresh = staticSetBuild(table->pendingKeys, table->pendingCount);
+    if (fresh == NULL) {
+        return NULL;
+    }
+
+    int old = atomic_load(&table->active);
+    int spare = 1 - old;
+
+    // Readers that raced with the previous swap may still hold the spare slot
+    while (atomic_load(&table->readers[spare]) != 0) {
+        sched_yield();
+    }
+    staticSetDestroy(table->slots[spare]);
+    table->slots[spare] = fresh;
+    atomic_store(&table->active, spare);
+    return NULL;
+}
+
+// Start rebuilding from new keys in the background (keys are sorted in
+// place and must stay valid until lookupTableWait() returns)
+int lookupTableRebuildAsync(LookupTable* table, int* keys, size_t count) {
+    pthread_mutex_lock(&table->rebuildLock);
+    if (table->workerRunning) {
+        pthread_join(table->worker, NULL);
+        table->workerRunning = 0;
+    }
+
+    table->pendingKeys = keys;
+    table->pendingCount = count;
+    if (pthread_create(&table->worker, NULL, lookupTableRebuildWorker, table) != 0) {
+        pthread_mutex_unlock(&table->rebuildLock);
+        printf("Failed to start rebuild thread\n");
+        return -1;
+    }
+    table->workerRunning = 1;
+    pthread_mutex_unlock(&table->rebuildLock);
+    return 0;
+}
+
+void lookupTableWait(LookupTable* table) {
+    pthread_mutex_lock(&table->rebuildLock);
+    if (table->workerRunning) {
+        pthread_join(table->worker, NULL);
+        table->workerRunning = 0;
+    }
+    pthread_mutex_unlock(&table->rebuildLock);
+}
+
+void lookupTableDestroy(LookupTable* table) {
+    if (table != NULL) {
+        lookupTableWait(table);
+        staticSetDestroy(table->slots[0]);
+        staticSetDestroy(table->slots[1]);
+        pthread_mutex_destroy(&table->rebuildLock);
+        free(table);
+    }
+}
+
+// ========== Pointer BST (from the trees doc, for comparison) ==========
+
+typedef struct TreeNode {
+    int data;
+    struct TreeNode* left;
+    struct TreeNode* right;
+} TreeNode;
+
+TreeNode* createNode(int data) {
+    TreeNode* newNode = (TreeNode*)malloc(sizeof(TreeNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    newNode->data = data;
+    newNode->left = NULL;
+    newNode->right = NULL;
+    return newNode;
+}
+
+// Iterative insert so large benchmarks cannot overflow the stack
+TreeNode* insertNode(TreeNode* root, int data) {
+    TreeNode** link = &root;
+    while (*link != NULL) {
+        if (data < (*link)->data) {
+            link = &(*link)->left;
+        } else if (data > (*link)->data) {
+            link = &(*link)->right;
+        } else {
+            return root;
+        }
+    }
+    *link = createNode(data);
+    return root;
+}
+
+TreeNode* searchNode(TreeNode* root, int data) {
+    while (root != NULL && root->data != data) {
+        root = (data < root->data) ? root->left : root->right;
+    }
+    return root;
+}
+
+// Freeze a pointer tree into a static set (iterative inorder walk)
+StaticSet* staticSetFromTree(TreeNode* root, size_t nodeCount) {
+    int* sorted = (int*)malloc((nodeCount ? nodeCount : 1) * sizeof(int));
+    TreeNode** stack = (TreeNode**)malloc((nodeCount ? nodeCount : 1) * sizeof(TreeNode*));
+    if (sorted == NULL || stack == NULL) {
+        printf("Memory allocation failed\n");
+        free(sorted);
+        free(stack);
+        return NULL;
+    }
+
+    size_t count = 0;
+    size_t top = 0;
+    TreeNode* current = root;
+    while ((current != NULL || top > 0) && count < nodeCount) {
+        while (current != NULL) {
+            stack[top++] = current;
+            current = current->left;
+        }
+        current = stack[--top];
+        sorted[count++] = current->data;
+        current = current->right;
+    }
+
+    StaticSet* set = staticSetBuild(sorted, count);
+    free(stack);
+    free(sorted);
+    return set;
+}
+
+void freeTree(TreeNode* root) {
+    // Iterative: rotate left children into the right spine, then free
+    while (root != NULL) {
+        if (root->left != NULL) {
+            TreeNode* left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            TreeNode* right = root->right;
+            free(root);
+            root = right;
+        }
+    }
+}
+
+// ========== Benchmark ==========
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static uint64_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int binarySearch(const int* sorted, size_t count, int x) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (sorted[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count && sorted[lo] == x;
+}
+
+static void runBenchmark(size_t keyCount, size_t queryCount) {
+    struct timespec start, end;
+    uint64_t seed = 88172645463325252ULL;
+
+    printf("\n=== Benchmark: %zu keys, %zu lookups (50%% hits) ===\n",
+           keyCount, queryCount);
+
+    // Even keys only, so odd queries are guaranteed misses
+    int* keys = (int*)malloc(keyCount * sizeof(int));
+    int* queries = (int*)malloc(queryCount * sizeof(int));
+    if (keys == NULL || queries == NULL) {
+        printf("Memory allocation failed\n");
+        free(keys);
+        free(queries);
+        return;
+    }
+    for (size_t i = 0; i < keyCount; i++) {
+        keys[i] = (int)(2 * i);
+    }
+    for (size_t i = 0; i < queryCount; i++) {
+        queries[i] = (int)(nextRandom(&seed) % (2 * keyCount));
+    }
+
+    // Pointer BST built by inserting the keys in random order
+    for (size_t i = keyCount - 1; i > 0; i--) {
+        size_t j = nextRandom(&seed) % (i + 1);
+        int temp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = temp;
+    }
+    TreeNode* root = NULL;
+    for (size_t i = 0; i < keyCount; i++) {
+        root = insertNode(root, keys[i]);
+    }
+
+    StaticSet* eytzinger = staticSetBuild(keys, keyCount);   // sorts keys
+    VebSet* veb = vebSetBuild(keys, keyCount);
+    if (eytzinger == NULL || veb == NULL) {
+        staticSetDestroy(eytzinger);
+        vebSetDestroy(veb);
+        freeTree(root);
+        free(keys);
+        free(queries);
+        return;
+    }
+
+    size_t hits;
+    double seconds;
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < queryCount; i++) {
+        hits += searchNode(root, queries[i]) != NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("pointer BST      : %7.1f ns/lookup (%zu hits)\n", seconds * 1e9 / queryCount, hits);
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < queryCount; i++) {
+        hits += binarySearch(keys, keyCount, queries[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("sorted array     : %7.1f ns/lookup (%zu hits)\n", seconds * 1e9 / queryCount, hits);
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < queryCount; i++) {
+        hits += staticSetContains(eytzinger, queries[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("Eytzinger        : %7.1f ns/lookup (%zu hits)\n", seconds * 1e9 / queryCount, hits);
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < queryCount; i++) {
+        hits += vebSetContains(veb, queries[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("van Emde Boas    : %7.1f ns/lookup (%zu hits)\n", seconds * 1e9 / queryCount, hits);
+
+    staticSetDestroy(eytzinger);
+    vebSetDestroy(veb);
+    freeTree(root);
+    free(keys);
+    free(queries);
+}
+
+// ========== Demo ==========
+
+typedef struct {
+    LookupTable* table;
+    atomic_int stop;
+    long lookups;
+} ReaderArgs;
+
+static void* readerThread(void* arg) {
+    ReaderArgs* args = (ReaderArgs*)arg;
+    while (!atomic_load(&args->stop)) {
+        int slot;
+        const StaticSet* set = lookupTableAcquire(args->table, &slot);
+        staticSetContains(set, (int)(args->lookups % 1000));
+        lookupTableRelease(args->table, slot);
+        args->lookups++;
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    int values[] = {50, 30, 70, 20, 40, 60, 80, 30, 10};
+    size_t count = sizeof(values) / sizeof(values[0]);
+
+    TreeNode* root = NULL;
+    for (size_t i = 0; i < count; i++) {
+        root = insertNode(root, values[i]);
+    }
+    StaticSet* set = staticSetFromTree(root, count);
+    freeTree(root);
+    if (set == NULL) {
+        return 1;
+    }
+
+    printf("Eytzinger order: ");
+    for (size_t k = 1; k <= set->size; k++) {
+        printf("%d ", set->keys[k]);
+    }
+    printf("\n");
+
+    int probes[] = {5, 10, 45, 60, 85};
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        int pred;
+        printf("x=%2d contains=%d predecessor=", probes[i], staticSetContains(set, probes[i]));
+        if (staticSetPredecessor(set, probes[i], &pred)) {
+            printf("%d\n", pred);
+        } else {
+            printf("none\n");
+        }
+    }
+
+    int range[8];
+    size_t inRange = staticSetRange(set, 25, 65, range, 8);
+    printf("Keys in [25, 65]: ");
+    for (size_t i = 0; i < inRange; i++) {
+        printf("%d ", range[i]);
+    }
+    printf("(%zu keys)\n", inRange);
+    staticSetDestroy(set);
+
+    // Background rebuild while a reader keeps querying
+    int first[1000], second[2000];
+    for (int i = 0; i < 1000; i++) {
+        first[i] = i;
+    }
+    for (int i = 0; i < 2000; i++) {
+        second[i] = 2 * i;
+    }
+
+    LookupTable* table = lookupTableCreate(first, 1000);
+    if (table == NULL) {
+        return 1;
+    }
+
+    ReaderArgs args;
+    args.table = table;
+    atomic_init(&args.stop, 0);
+    args.lookups = 0;
+    pthread_t reader;
+    pthread_create(&reader, NULL, readerThread, &args);
+
+    lookupTableRebuildAsync(table, second, 2000);
+    lookupTableWait(table);
+    atomic_store(&args.stop, 1);
+    pthread_join(reader, NULL);
+
+    int slot;
+    const StaticSet* current = lookupTableAcquire(table, &slot);
+    printf("After rebuild: %zu keys, contains 3998=%d, contains 999=%d (reader did %ld lookups)\n",
+           current->size, staticSetContains(current, 3998),
+           staticSetContains(current, 999), args.lookups);
+    lookupTableRelease(table, slot);
+    lookupTableDestroy(table);
+
+    size_t keyCount = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t queryCount = (argc > 2) ? strtoull(argv[2], NULL, 10) : 2000000;
+    if (keyCount > 0 && keyCount <= INT_MAX / 2 && queryCount > 0) {
+        runBenchmark(keyCount, queryCount);
+    }
+
+    return 0;
+}
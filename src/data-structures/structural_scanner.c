@@ -0,0 +1,311 @@
+/*
+ * structural_scanner.c - Two-Stage SIMD Bracket Validation for Large Documents (see structural_scanner.h)
+ */
+
+#include "structural_scanner.h"
+#include "../dispatch/cpu_dispatch.h"
+#include "../profiling/instrument.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+// ========== Stage One: Bitmasks ==========
+
+// Bit i of each mask describes byte i of a 64-byte block
+typedef struct {
+    uint64_t open;
+    uint64_t close;
+    uint64_t quote;
+    uint64_t backslash;
+} BlockMasks;
+
+// Each class is one byte of the table entry, so the entries of 8 input
+// bytes shifted by 0..7 and ORed give the four 8-bit masks side by side
+enum { CLASS_OPEN = 1, CLASS_CLOSE = 1 << 8, CLASS_QUOTE = 1 << 16, CLASS_BACKSLASH = 1 << 24 };
+
+static uint32_t classTable[256];
+
+__attribute__((constructor)) static void buildClassTable(void) {
+    classTable['('] = classTable['['] = classTable['{'] = CLASS_OPEN;
+    classTable[')'] = classTable[']'] = classTable['}'] = CLASS_CLOSE;
+    classTable['"'] = CLASS_QUOTE;
+    classTable['\\'] = CLASS_BACKSLASH;
+}
+
+static inline void masksScalar(const uint8_t* block, BlockMasks* masks) {
+    uint64_t open = 0, close = 0, quote = 0, backslash = 0;
+    for (int i = 0; i < 64; i += 8) {
+        uint32_t bits = 0;
+        for (int j = 0; j < 8; j++) {
+            bits |= classTable[block[i + j]] << j;
+        }
+        open |= (uint64_t)(bits & 0xFF) << i;
+        close |= (uint64_t)((bits >> 8) & 0xFF) << i;
+        quote |= (uint64_t)((bits >> 16) & 0xFF) << i;
+        backslash |= (uint64_t)(bits >> 24) << i;
+    }
+    masks->open = open;
+    masks->close = close;
+    masks->quote = quote;
+    masks->backslash = backslash;
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t equalMaskAvx2(__m256i low, __m256i high, char c) {
+    __m256i value = _mm256_set1_epi8(c);
+    uint32_t lowBits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, value));
+    uint32_t highBits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, value));
+    return ((uint64_t)highBits << 32) | lowBits;
+}
+
+__attribute__((target("avx2")))
+static inline void masksAvx2(const uint8_t* block, BlockMasks* masks) {
+    __m256i low = _mm256_loadu_si256((const __m256i*)block);
+    __m256i high = _mm256_loadu_si256((const __m256i*)(block + 32));
+    masks->open = equalMaskAvx2(low, high, '(') | equalMaskAvx2(low, high, '[') | equalMaskAvx2(low, high, '{');
+    masks->close = equalMaskAvx2(low, high, ')') | equalMaskAvx2(low, high, ']') | equalMaskAvx2(low, high, '}');
+    masks->quote = equalMaskAvx2(low, high, '"');
+    masks->backslash = equalMaskAvx2(low, high, '\\');
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void masksAvx512(const uint8_t* block, BlockMasks* masks) {
+    __m512i v = _mm512_loadu_si512((const void*)block);
+    masks->open = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('(')) |
+                  _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('[')) |
+                  _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('{'));
+    masks->close = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(')')) |
+                   _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(']')) |
+                   _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('}'));
+    masks->quote = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'));
+    masks->backslash = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+}
+
+// ========== Stage One: Strings ==========
+
+// Bytes that follow an odd run of backslashes. A run that starts on an even
+// bit ends on an odd bit exactly when its length is odd, so adding the
+// run starts to the backslash mask (the carry runs off the end of each run)
+// and looking at the parity of where each carry lands finds the odd runs
+// for all 64 bytes at once. *oddBackslash carries a run over the block edge.
+static inline uint64_t escapedBytes(uint64_t backslash, uint64_t* oddBackslash) {
+    const uint64_t evenBits = 0x5555555555555555ull;
+    const uint64_t oddBits = ~evenBits;
+    uint64_t starts = backslash & ~(backslash << 1);
+    // An odd run left over from the previous block shifts the parity of bit 0
+    uint64_t evenStartMask = evenBits ^ *oddBackslash;
+    uint64_t evenStarts = starts & evenStartMask;
+    uint64_t oddStarts = starts & ~evenStartMask;
+    uint64_t evenCarries = backslash + evenStarts;
+    uint64_t oddCarries;
+    bool endsOdd = __builtin_add_overflow(backslash, oddStarts, &oddCarries);
+    oddCarries |= *oddBackslash;
+    *oddBackslash = endsOdd;
+    uint64_t evenCarryEnds = evenCarries & ~backslash;
+    uint64_t oddCarryEnds = oddCarries & ~backslash;
+    return (evenCarryEnds & oddBits) | (oddCarryEnds & evenBits);
+}
+
+// Bit i = XOR of bits 0..i: set from an opening quote up to, not including,
+// its closing quote
+static inline uint64_t prefixXorShifts(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// The same in one instruction: a carry-less multiply by all ones adds
+// (XORs) every shifted copy of `bits` at once
+__attribute__((target("pclmul")))
+static inline uint64_t prefixXorClmul(uint64_t bits) {
+    __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)bits), _mm_set1_epi8((char)0xFF), 0);
+    return (uint64_t)_mm_cvtsi128_si64(product);
+}
+
+// Brackets of one block outside strings; updates the string state
+static inline uint64_t structuralBits(const BlockMasks* masks, uint64_t inStringPrefix, ScanState* state) {
+    uint64_t inString = inStringPrefix ^ state->inString;
+    state->inString = (uint64_t)((int64_t)inString >> 63);
+    return (masks->open | masks->close) & ~inString;
+}
+
+static inline uint64_t unescapedQuotes(const BlockMasks* masks, ScanState* state, size_t position) {
+    uint64_t quotes = masks->quote;
+    if ((masks->backslash | state->oddBackslash) != 0) {
+        quotes &= ~escapedBytes(masks->backslash, &state->oddBackslash);
+    }
+    if (quotes != 0) {
+        state->lastQuote = position + 63 - (size_t)__builtin_clzll(quotes);
+    }
+    return quotes;
+}
+
+// Positions are written eight at a time whether or not the mask has that
+// many bits, so the loop branches once per eight brackets instead of once
+// per bracket; the extra entries are overwritten by the next block
+static inline size_t writeIndices(uint64_t bits, uint32_t base, uint32_t* indices) {
+    size_t count = (size_t)__builtin_popcountll(bits);
+    for (size_t k = 0; k < count; k += 8) {
+        for (int j = 0; j < 8; j++) {
+            indices[k + j] = base + (uint32_t)__builtin_ctzll(bits | (1ull << 63));
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
+// A short last block is padded with spaces, which are never structural
+#define STRUCTURAL_INDEX(name, attributes, loadMasks, prefixXor)                                \
+    attributes                                                                                 \
+    static size_t name(const char* text, size_t length, bool quotedStrings,                    \
+                       ScanState* state, uint32_t* indices) {                                  \
+        PROFILE_SCOPE("scanner.structuralIndex");                                              \
+        size_t count = 0;                                                                      \
+        for (size_t i = 0; i < length; i += 64) {                                              \
+            BlockMasks masks;                                                                  \
+            if (length - i >= 64) {                                                            \
+                loadMasks((const uint8_t*)text + i, &masks);                                   \
+            } else {                                                                           \
+                uint8_t padded[64];                                                            \
+                memset(padded, ' ', sizeof(padded));                                           \
+                memcpy(padded, text + i, length - i);                                          \
+                loadMasks(padded, &masks);                                                     \
+            }                                                                                  \
+            uint64_t bits = masks.open | masks.close;                                          \
+            if (quotedStrings) {                                                               \
+                uint64_t quotes = unescapedQuotes(&masks, state, state->offset + i);           \
+                bits = structuralBits(&masks, prefixXor(quotes), state);                       \
+            }                                                                                  \
+            count += writeIndices(bits, (uint32_t)i, indices + count);                         \
+        }                                                                                      \
+        state->offset += length;                                                               \
+        return count;                                                                          \
+    }
+
+STRUCTURAL_INDEX(structuralIndexScalar, , masksScalar, prefixXorShifts)
+STRUCTURAL_INDEX(structuralIndexAvx2, __attribute__((target("avx2,pclmul"))), masksAvx2, prefixXorClmul)
+STRUCTURAL_INDEX(structuralIndexAvx512, __attribute__((target("avx512f,avx512bw,pclmul"))),
+                 masksAvx512, prefixXorClmul)
+
+DISPATCH_KERNEL(StructuralIndexFunction, structuralIndex,
+    DISPATCH_VARIANT(structuralIndexAvx512, CPU_AVX512F | CPU_AVX512BW | CPU_PCLMUL),
+    DISPATCH_VARIANT(structuralIndexAvx2, CPU_AVX2 | CPU_PCLMUL),
+    DISPATCH_VARIANT(structuralIndexScalar, 0))
+
+// ========== Stage Two: Matching ==========
+
+// The closing bracket each opening bracket expects; 0 for everything else
+static char closingFor[256];
+
+__attribute__((constructor)) static void buildClosingTable(void) {
+    closingFor['('] = ')';
+    closingFor['['] = ']';
+    closingFor['{'] = '}';
+}
+
+// Open brackets sit at 1..depth of the two stacks; entry 0 expects no
+// closing bracket at all, so a close with nothing open is caught by the
+// same compare as a mismatch. Whether a bracket opens or closes is not
+// predictable in real documents, so it only moves depth up or down and the
+// one branch taken per bracket is the (rare) error.
+BracketResult scanBrackets(const char* text, size_t length, bool quotedStrings) {
+    PROFILE_SCOPE("scanner.scanBrackets");
+    BracketResult result = { BRACKETS_OK, 0, 0, 0, 0 };
+    size_t window = (length < SCAN_WINDOW) ? length : SCAN_WINDOW;
+    uint32_t* indices = malloc((window + 8) * sizeof(uint32_t));
+    size_t capacity = 64;
+    size_t* opened = malloc(capacity * sizeof(size_t));   // offsets of the open brackets
+    char* expected = malloc(capacity);                    // and the brackets that close them
+    if (indices == NULL || opened == NULL || expected == NULL) {
+        printf("Memory allocation failed\n");
+        free(indices);
+        free(opened);
+        free(expected);
+        result.status = BRACKETS_OUT_OF_MEMORY;
+        return result;
+    }
+
+    ScanState state = { 0, 0, 0, 0 };
+    size_t depth = 0, maxDepth = 0, processed = 0;
+    expected[0] = 0;
+    for (size_t start = 0; start < length && result.status == BRACKETS_OK; start += SCAN_WINDOW) {
+        size_t count = structuralIndex(text + start, (length - start < SCAN_WINDOW) ? length - start : SCAN_WINDOW,
+                                       quotedStrings, &state, indices);
+        for (size_t k = 0; k < count; k++) {
+            if (depth + 1 == capacity) {
+                size_t* grownOpened = realloc(opened, 2 * capacity * sizeof(size_t));
+                char* grownExpected = grownOpened == NULL ? NULL : realloc(expected, 2 * capacity);
+                if (grownExpected == NULL) {
+                    printf("Memory allocation failed\n");
+                    opened = grownOpened == NULL ? opened : grownOpened;
+                    result.status = BRACKETS_OUT_OF_MEMORY;
+                    result.offset = start + indices[k];
+                    processed += k;
+                    break;
+                }
+                opened = grownOpened;
+                expected = grownExpected;
+                capacity *= 2;
+            }
+            size_t position = start + indices[k];
+            char c = text[position];
+            char closes = closingFor[(unsigned char)c];
+            size_t isOpen = (closes != 0);
+            // Nonzero for a close that does not match; computed with
+            // arithmetic so the compiler does not branch on isOpen
+            if (((isOpen - 1) & (size_t)(unsigned char)(c ^ expected[depth])) != 0) {
+                result.status = (depth == 0) ? BRACKETS_UNEXPECTED_CLOSE : BRACKETS_MISMATCH;
+                result.offset = position;
+                result.openOffset = (depth == 0) ? 0 : opened[depth];
+                processed += k;
+                break;
+            }
+            // Written either way: above the top they are dead after a close
+            opened[depth + 1] = position;
+            expected[depth + 1] = closes;
+            depth = depth - 1 + 2 * isOpen;
+            maxDepth = (depth > maxDepth) ? depth : maxDepth;
+        }
+        if (result.status == BRACKETS_OK) {
+            processed += count;
+        }
+    }
+    result.maxDepth = maxDepth;
+    result.bracketCount = processed;
+
+    if (result.status == BRACKETS_OK && state.inString != 0) {
+        result.status = BRACKETS_UNTERMINATED_STRING;
+        result.offset = length;
+        result.openOffset = state.lastQuote;
+    } else if (result.status == BRACKETS_OK && depth > 0) {
+        result.status = BRACKETS_UNCLOSED;
+        result.offset = length;
+        result.openOffset = opened[depth];
+    }
+    free(indices);
+    free(opened);
+    free(expected);
+    return result;
+}
+
+bool bracketsBalanced(const char* expression) {
+    return scanBrackets(expression, strlen(expression), false).status == BRACKETS_OK;
+}
+
+const char* bracketStatusName(BracketStatus status) {
+    switch (status) {
+        case BRACKETS_OK: return "balanced";
+        case BRACKETS_UNEXPECTED_CLOSE: return "closing bracket with nothing open";
+        case BRACKETS_MISMATCH: return "mismatched closing bracket";
+        case BRACKETS_UNCLOSED: return "unclosed bracket";
+        case BRACKETS_UNTERMINATED_STRING: return "unterminated string";
+        case BRACKETS_OUT_OF_MEMORY: return "out of memory";
+    }
+    return "unknown";
+}
@@ -0,0 +1,85 @@
+/*
+ * structural_scanner.h - Two-Stage SIMD Bracket Validation for Large Documents
+ *
+ * isBalanced() in docs/11-data-structures/02-stacks-queues.md pushes every
+ * bracket through the fixed 100-slot Stack, one byte at a time: nesting
+ * deeper than 100 overflows it, brackets inside quoted strings count as
+ * structure, and it cannot say where the document goes wrong. This module
+ * checks documents of any size and depth in two stages:
+ *
+ * - stage one (structuralIndex) turns each 64-byte block into bitmasks of
+ *   opening brackets, closing brackets, quotes and backslashes with SIMD
+ *   compares. Quotes after an odd run of backslashes are escaped; the
+ *   remaining quotes become an "inside a string" mask with one carry-less
+ *   multiply (PCLMULQDQ) by all ones, a prefix XOR. Brackets inside strings
+ *   are dropped and the positions of the rest are written out
+ * - stage two (scanBrackets) walks only those positions with a stack that
+ *   grows as needed, and stops at the first error
+ *
+ * The input is scanned in windows of SCAN_WINDOW bytes, so the positions of
+ * stage one stay in cache and stage two runs right behind it. Brackets are
+ * ( ) [ ] { }; strings are "..." with backslash escapes, as in JSON and C.
+ *
+ * The fastest variant of stage one for the CPU is picked at startup (see
+ * ../dispatch/cpu_dispatch.h). Compile together with structural_scanner.c:
+ *   gcc -O2 -o program program.c structural_scanner.c ../dispatch/cpu_dispatch.c
+ *
+ * With -DINSTRUMENT and ../profiling/instrument.c, stage one is timed per
+ * window and scanBrackets() per call (see ../profiling/instrument.h).
+ */
+
+#ifndef STRUCTURAL_SCANNER_H
+#define STRUCTURAL_SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCAN_WINDOW (64 * 1024)
+
+typedef enum {
+    BRACKETS_OK,
+    BRACKETS_UNEXPECTED_CLOSE,     // a closing bracket with nothing open
+    BRACKETS_MISMATCH,             // a closing bracket of another kind than the open one
+    BRACKETS_UNCLOSED,             // the input ends with brackets open
+    BRACKETS_UNTERMINATED_STRING,  // the input ends inside a string
+    BRACKETS_OUT_OF_MEMORY
+} BracketStatus;
+
+typedef struct {
+    BracketStatus status;
+    size_t offset;           // where the error was found: the bracket, or the length at the end
+    size_t openOffset;       // the open bracket (or quote) the error refers to
+    size_t maxDepth;
+    size_t bracketCount;     // brackets outside strings, up to the error
+} BracketResult;
+
+// Carried from one call of structuralIndex() to the next
+typedef struct {
+    uint64_t inString;       // all ones when the text so far ends inside a string
+    uint64_t oddBackslash;   // 1 when it ends with an odd run of backslashes
+    size_t offset;           // bytes scanned so far
+    size_t lastQuote;        // offset of the last unescaped quote
+} ScanState;
+
+// ========== Kernels (resolved for this CPU at startup) ==========
+
+// Writes the positions (from text) of the brackets in text[0 .. length),
+// leaving out those inside strings when quotedStrings is set, and returns
+// how many. indices needs room for length + 8 entries; length < 2^32. To scan
+// a text in pieces, pass multiples of 64 bytes in every call but the last.
+typedef size_t (*StructuralIndexFunction)(const char* text, size_t length, bool quotedStrings,
+                                          ScanState* state, uint32_t* indices);
+
+extern StructuralIndexFunction structuralIndex;
+
+// ========== Validation ==========
+
+BracketResult scanBrackets(const char* text, size_t length, bool quotedStrings);
+
+// isBalanced() of the docs without the depth limit
+bool bracketsBalanced(const char* expression);
+
+const char* bracketStatusName(BracketStatus status);
+
+#endif
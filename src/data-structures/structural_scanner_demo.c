@@ -0,0 +1,386 @@
+/*
+ * Structural Scanner Demo: isBalanced for Large and Deep Documents
+ *
+ * Runs the expressions of docs/11-data-structures/02-stacks-queues.md and a
+ * few JSON documents through scanBrackets(), checks every variant of stage
+ * one against a byte-at-a-time scanner on random documents (escaped quotes,
+ * backslash runs and windows cut at every kind of byte), then measures
+ * throughput on a generated JSON document against the isBalanced() of the
+ * docs.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o structural_scanner_demo structural_scanner_demo.c structural_scanner.c ../dispatch/cpu_dispatch.c
+ *   ./structural_scanner_demo [document MB]
+ *   CPU_DISPATCH=scalar ./structural_scanner_demo      (no SIMD)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "structural_scanner.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== isBalanced from the Docs ==========
+
+#define MAX_SIZE 100
+
+typedef struct {
+    int data[MAX_SIZE];
+    int top;
+} Stack;
+
+static void initializeStack(Stack* stack) {
+    stack->top = -1;
+}
+
+static bool isEmpty(Stack* stack) {
+    return stack->top == -1;
+}
+
+static bool isFull(Stack* stack) {
+    return stack->top == MAX_SIZE - 1;
+}
+
+static bool push(Stack* stack, int value) {
+    if (isFull(stack)) {
+        printf("Stack overflow\n");
+        return false;
+    }
+    stack->data[++stack->top] = value;
+    return true;
+}
+
+static bool pop(Stack* stack, int* value) {
+    if (isEmpty(stack)) {
+        printf("Stack underflow\n");
+        return false;
+    }
+    *value = stack->data[stack->top--];
+    return true;
+}
+
+static bool isBalanced(char* expression) {
+    Stack stack;
+    initializeStack(&stack);
+
+    for (int i = 0; expression[i]; i++) {
+        if (expression[i] == '(' || expression[i] == '{' || expression[i] == '[') {
+            push(&stack, expression[i]);
+        } else if (expression[i] == ')' || expression[i] == '}' || expression[i] == ']') {
+            if (isEmpty(&stack)) {
+                return false;
+            }
+
+            int top;   // the docs use char, which pop() cannot take
+            pop(&stack, &top);
+
+            if ((expression[i] == ')' && top != '(') ||
+                (expression[i] == '}' && top != '{') ||
+                (expression[i] == ']' && top != '[')) {
+                return false;
+            }
+        }
+    }
+
+    return isEmpty(&stack);
+}
+
+// ========== Byte-at-a-Time Reference ==========
+
+// The same rules one byte at a time: a quote after an odd run of
+// backslashes neither opens nor closes a string
+static BracketResult scanReference(const char* text, size_t length, bool quotedStrings) {
+    BracketResult result = { BRACKETS_OK, 0, 0, 0, 0 };
+    size_t* opened = malloc((length + 1) * sizeof(size_t));
+    if (opened == NULL) {
+        printf("Memory allocation failed\n");
+        result.status = BRACKETS_OUT_OF_MEMORY;
+        return result;
+    }
+    size_t depth = 0, lastQuote = 0;
+    bool inString = false, escaped = false;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (quotedStrings) {
+            if (c == '"' && !escaped) {
+                inString = !inString;
+                lastQuote = i;
+            }
+            escaped = (c == '\\') && !escaped;
+            if (inString) {
+                continue;
+            }
+        }
+        if (c == '(' || c == '[' || c == '{') {
+            opened[depth++] = i;
+            result.maxDepth = depth > result.maxDepth ? depth : result.maxDepth;
+        } else if (c == ')' || c == ']' || c == '}') {
+            char expected = depth == 0 ? 0 : (text[opened[depth - 1]] == '(' ? ')' : text[opened[depth - 1]] + 2);
+            if (depth == 0 || c != expected) {
+                result.status = depth == 0 ? BRACKETS_UNEXPECTED_CLOSE : BRACKETS_MISMATCH;
+                result.offset = i;
+                result.openOffset = depth == 0 ? 0 : opened[depth - 1];
+                free(opened);
+                return result;
+            }
+            depth--;
+        } else {
+            continue;
+        }
+        result.bracketCount++;
+    }
+    if (inString) {
+        result.status = BRACKETS_UNTERMINATED_STRING;
+        result.offset = length;
+        result.openOffset = lastQuote;
+    } else if (depth > 0) {
+        result.status = BRACKETS_UNCLOSED;
+        result.offset = length;
+        result.openOffset = opened[depth - 1];
+    }
+    free(opened);
+    return result;
+}
+
+static bool sameResult(BracketResult a, BracketResult b) {
+    return a.status == b.status && a.offset == b.offset && a.openOffset == b.openOffset &&
+           a.maxDepth == b.maxDepth && a.bracketCount == b.bracketCount;
+}
+
+static void printResult(const char* label, BracketResult result) {
+    printf("%-40s %s", label, bracketStatusName(result.status));
+    if (result.status == BRACKETS_OK) {
+        printf(" (depth %zu)\n", result.maxDepth);
+    } else if (result.status == BRACKETS_UNEXPECTED_CLOSE) {
+        printf(" at offset %zu\n", result.offset);
+    } else {
+        printf(" at offset %zu, opened at %zu\n", result.offset, result.openOffset);
+    }
+}
+
+// ========== Documents ==========
+
+// JSON-like text: objects, arrays, numbers and strings with escaped quotes
+// and backslashes; the first four strings also hold brackets
+static size_t writeValue(char* out, size_t capacity, int depth, int maxDepth, bool bracketsInStrings,
+                         unsigned* seed) {
+    static const char* strings[] = {
+        "\"(note)\"", "\"say \\\"hi\\\" (twice\"", "\"}]) closers\"", "\"\\\\\\\"[\"",
+        "\"plain\"", "\"C:\\\\temp\\\\\"", "\"a \\\"quoted\\\" word\"", "\"\""
+    };
+    size_t used = 0;
+    unsigned kind = depth >= maxDepth ? 2 + nextRandom(seed) % 2 : nextRandom(seed) % 4;
+    if (kind < 2 && capacity > 64) {
+        char open = kind == 0 ? '{' : '[';
+        out[used++] = open;
+        unsigned members = nextRandom(seed) % 5;
+        for (unsigned m = 0; m < members && used + 64 < capacity; m++) {
+            if (m > 0) {
+                out[used++] = ',';
+                out[used++] = ' ';
+            }
+            if (open == '{') {
+                used += (size_t)snprintf(out + used, capacity - used, "\"key%u\": ", nextRandom(seed) % 100);
+            }
+            used += writeValue(out + used, capacity - used - 2, depth + 1, maxDepth, bracketsInStrings, seed);
+        }
+        out[used++] = open == '{' ? '}' : ']';
+    } else if (kind == 2 && capacity > 32) {
+        const char* s = bracketsInStrings ? strings[nextRandom(seed) % 8] : strings[4 + nextRandom(seed) % 4];
+        size_t n = strlen(s);
+        memcpy(out + used, s, n);
+        used += n;
+    } else if (capacity > 16) {
+        used += (size_t)snprintf(out + used, capacity - used, "%u", nextRandom(seed) % 100000);
+    }
+    return used;
+}
+
+// A balanced JSON document of about `length` bytes (array of records)
+static size_t makeDocument(char* text, size_t length, int maxDepth, bool bracketsInStrings, unsigned* seed) {
+    size_t used = 0;
+    text[used++] = '[';
+    while (used + 4096 < length) {
+        used += writeValue(text + used, 4096, 0, maxDepth, bracketsInStrings, seed);
+        text[used++] = ',';
+        text[used++] = '\n';
+    }
+    text[used++] = '0';
+    text[used++] = ']';
+    text[used] = '\0';
+    return used;
+}
+
+// ========== Checks ==========
+
+// Every variant of stage one, through scanBrackets(), in both modes
+static bool checkText(const char* text, size_t length) {
+    const DispatchKernel* kernel = dispatchFind("structuralIndex");
+    bool ok = true;
+    for (int mode = 0; mode < 2; mode++) {
+        BracketResult expected = scanReference(text, length, mode == 1);
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (!dispatchUseVariant(kernel, v)) {
+                continue;
+            }
+            if (!sameResult(scanBrackets(text, length, mode == 1), expected)) {
+                if (ok) {
+                    printf("  %s differs (length %zu, %s)\n", kernel->variants[v].name, length,
+                           mode == 1 ? "strings" : "plain");
+                }
+                ok = false;
+            }
+        }
+    }
+    dispatchRestore(kernel);
+    return ok;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against a Byte-at-a-Time Scanner ===\n");
+    const char alphabet[] = "()[]{}\"\"\"\\\\\\ab ";
+    const size_t maxLength = 3 * SCAN_WINDOW + 100;
+    char* text = malloc(maxLength + 1);
+    if (text == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+
+    // Random bytes: mostly errors, but every escape and string edge case
+    bool ok = true;
+    for (int trial = 0; trial < 3000 && ok; trial++) {
+        size_t length = trial < 300 ? (size_t)trial : nextRandom(seed) % 400;
+        for (size_t i = 0; i < length; i++) {
+            text[i] = alphabet[nextRandom(seed) % (sizeof(alphabet) - 1)];
+        }
+        ok = checkText(text, length);
+    }
+    printf("random bytes, lengths 0..399: %s\n", ok ? "all match" : "MISMATCH");
+
+    // Balanced documents across windows, then with one byte changed
+    bool documentsOk = true;
+    for (int trial = 0; trial < 200 && documentsOk; trial++) {
+        size_t length = makeDocument(text, 5000 + nextRandom(seed) % (maxLength - 5000), 6, true, seed);
+        documentsOk = checkText(text, length) && scanBrackets(text, length, true).status == BRACKETS_OK;
+        size_t position = nextRandom(seed) % length;
+        char saved = text[position];
+        text[position] = alphabet[nextRandom(seed) % (sizeof(alphabet) - 1)];
+        documentsOk = documentsOk && checkText(text, length);
+        text[position] = saved;
+    }
+    printf("documents up to 3 windows, one byte changed: %s\n", documentsOk ? "all match" : "MISMATCH");
+
+    // Deep nesting, and a backslash run across a block and window edge
+    bool deepOk = true;
+    size_t depth = maxLength / 2;
+    memset(text, '[', depth);
+    memset(text + depth, ']', depth);
+    BracketResult deep = scanBrackets(text, 2 * depth, true);
+    deepOk = deep.status == BRACKETS_OK && deep.maxDepth == depth && checkText(text, 2 * depth);
+    for (size_t run = 1; run < 200 && deepOk; run++) {
+        size_t start = SCAN_WINDOW - run / 2;
+        memset(text, ' ', SCAN_WINDOW + 200);
+        text[0] = '"';
+        memset(text + start, '\\', run);
+        text[start + run] = '"';
+        text[start + run + 1] = '(';
+        deepOk = checkText(text, SCAN_WINDOW + 200);
+    }
+    printf("nesting %zu deep, backslash runs across windows: %s\n", depth, deepOk ? "all match" : "MISMATCH");
+    free(text);
+    return ok && documentsOk && deepOk;
+}
+
+// ========== Benchmark ==========
+
+static void benchmark(size_t length, unsigned* seed) {
+    char* text = malloc(length + 1);
+    if (text == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    // No brackets inside strings, so the docs' isBalanced() gets to the end
+    length = makeDocument(text, length, 6, false, seed);
+    BracketResult summary = scanBrackets(text, length, true);
+    printf("\n=== Throughput on %.0f MB of JSON (%zu brackets outside strings, depth %zu) ===\n",
+           length / 1e6, summary.bracketCount, summary.maxDepth);
+    printf("%-36s %10s %8s\n", "", "result", "GB/s");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool balanced = isBalanced(text);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-36s %10s %8.2f\n", "isBalanced (docs, no strings)", balanced ? "balanced" : "not", length / elapsedSeconds(start, end) / 1e9);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    BracketResult reference = scanReference(text, length, true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-36s %10s %8.2f\n", "byte at a time, strings", reference.status == BRACKETS_OK ? "balanced" : "not",
+           length / elapsedSeconds(start, end) / 1e9);
+
+    const DispatchKernel* kernel = dispatchFind("structuralIndex");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        for (int mode = 0; mode < 2; mode++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            BracketResult result = scanBrackets(text, length, mode == 1);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            char label[64];
+            snprintf(label, sizeof(label), "scanBrackets %s, %s", kernel->variants[v].name + strlen("structuralIndex"),
+                     mode == 1 ? "strings" : "no strings");
+            printf("%-36s %10s %8.2f%s\n", label, result.status == BRACKETS_OK ? "balanced" : "not",
+                   length / elapsedSeconds(start, end) / 1e9,
+                   mode == 1 && !sameResult(result, reference) ? "  MISMATCH" : "");
+        }
+    }
+    dispatchRestore(kernel);
+    free(text);
+}
+
+int main(int argc, char* argv[]) {
+    long megabytes = argc > 1 ? atol(argv[1]) : 256;
+    if (megabytes < 1 || megabytes > 4096) {
+        printf("Usage: %s [document MB, 1 to 4096]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Examples ===\n");
+    const char* expressions[] = { "{[()]}", "{[(])}", "{{[[(())]]}}" };
+    for (int i = 0; i < 3; i++) {
+        printf("Expression: %s -> %s\n", expressions[i], bracketsBalanced(expressions[i]) ? "Balanced" : "Not Balanced");
+    }
+    const char* documents[] = {
+        "{\"name\": \"say \\\"hi\\\" (\", \"list\": [1, 2]}",
+        "{\"list\": [1, 2}, \"text\": \"]\"}",
+        "{\"list\": [1, 2], \"text\": \"unterminated}",
+        "[[1, 2], [3, 4]]]"
+    };
+    for (int i = 0; i < 4; i++) {
+        printf("%s\n", documents[i]);
+        printResult("  as JSON:", scanBrackets(documents[i], strlen(documents[i]), true));
+        printResult("  brackets only (as the docs):", scanBrackets(documents[i], strlen(documents[i]), false));
+    }
+
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+    benchmark((size_t)megabytes * 1000000, &seed);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,562 @@
+/*
+ * Arena-backed Binary Search Tree
+ *
+ * The tree in docs/11-data-structures/03-trees.md mallocs every node and
+ * uses recursion for freeTree, inorderTraversal and getHeight. That is fine
+ * for learning, but:
+ *
+ * - every node is a separate heap block, so neighbouring nodes end up far
+ *   apart in memory and a traversal misses the cache on almost every hop
+ * - freeing a tree costs one free() per node
+ * - a degenerate (sorted-input) tree of a few hundred thousand nodes
+ *   overflows the call stack
+ *
+ * This version keeps all nodes of a tree in one growable array (the arena):
+ *
+ * - children are 32-bit indices into the arena instead of 64-bit pointers,
+ *   so a node is 12 bytes instead of 24 and indices stay valid after the
+ *   arena grows with realloc()
+ * - index 0 is a reserved sentinel, so TREE_NIL (0) plays the role of NULL
+ * - arenaReset() throws away the whole tree in O(1), ready for reuse
+ * - every traversal is iterative (explicit stack, queue or Morris threading),
+ *   so tree depth never touches the call stack
+ * - traversals report nodes through a visitor callback instead of printf
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o tree_arena tree_arena.c
+ *   ./tree_arena                    (demo + small benchmark)
+ *   ./tree_arena 100000 64          (benchmark: 100000 trees of 64 nodes)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define TREE_NIL 0u
+#define ARENA_MIN_CAPACITY 64u
+
+// Node structure: children are arena indices, not pointers
+typedef struct {
+    int data;
+    uint32_t left;
+    uint32_t right;
+} ArenaNode;
+
+// Arena owning every node of one tree plus a reusable scratch buffer
+typedef struct {
+    ArenaNode* nodes;
+    uint32_t count;       // slots in use, including the sentinel at index 0
+    uint32_t capacity;
+    uint32_t* scratch;    // stack/queue storage for the iterative traversals
+    uint32_t scratchCapacity;
+    uint32_t root;
+} TreeArena;
+
+// Visitor callback: return 0 to continue, non-zero to stop the traversal
+typedef int (*TreeVisitor)(int data, void* context);
+
+// ========== Arena Management ==========
+
+TreeArena* arenaCreate(uint32_t capacity) {
+    TreeArena* arena = (TreeArena*)malloc(sizeof(TreeArena));
+    if (arena == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    if (capacity < ARENA_MIN_CAPACITY) {
+        capacity = ARENA_MIN_CAPACITY;
+    }
+
+    arena->nodes = (ArenaNode*)malloc((size_t)capacity * sizeof(ArenaNode));
+    if (arena->nodes == NULL) {
+        printf("Memory allocation failed\n");
+        free(arena);
+        return NULL;
+    }
+
+    arena->nodes[TREE_NIL].data = 0;
+    arena->nodes[TREE_NIL].left = TREE_NIL;
+    arena->nodes[TREE_NIL].right = TREE_NIL;
+    arena->count = 1;
+    arena->capacity = capacity;
+    arena->scratch = NULL;
+    arena->scratchCapacity = 0;
+    arena->root = TREE_NIL;
+    return arena;
+}
+
+// Drop every node at once; the memory is kept for the next tree
+void arenaReset(TreeArena* arena) {
+    arena->count = 1;
+    arena->root = TREE_NIL;
+}
+
+void arenaDestroy(TreeArena* arena) {
+    if (arena != NULL) {
+        free(arena->nodes);
+        free(arena->scratch);
+        free(arena);
+    }
+}
+
+// Returns the index of a fresh node, or TREE_NIL if the arena cannot grow
+uint32_t arenaAllocNode(TreeArena* arena, int data) {
+    if (arena->count == arena->capacity) {
+        if (arena->capacity > UINT32_MAX / 2) {
+            printf("Tree arena is full\n");
+            return TREE_NIL;
+        }
+        uint32_t newCapacity = arena->capacity * 2;
+        ArenaNode* grown = (ArenaNode*)realloc(arena->nodes,
+                                               (size_t)newCapacity * sizeof(ArenaNode));
+        if (grown == NULL) {
+            printf("Memory allocation failed\n");
+            return TREE_NIL;
+        }
+        arena->nodes = grown;
+        arena->capacity = newCapacity;
+    }
+
+    uint32_t index = arena->count++;
+    arena->nodes[index].data = data;
+    arena->nodes[index].left = TREE_NIL;
+    arena->nodes[index].right = TREE_NIL;
+    return index;
+}
+
+// The scratch buffer never needs more slots than there are nodes
+static uint32_t* arenaScratch(TreeArena* arena) {
+    if (arena->scratchCapacity < arena->count) {
+        uint32_t* grown = (uint32_t*)realloc(arena->scratch,
+                                             (size_t)arena->capacity * sizeof(uint32_t));
+        if (grown == NULL) {
+            printf("Memory allocation failed\n");
+            return NULL;
+        }
+        arena->scratch = grown;
+        arena->scratchCapacity = arena->capacity;
+    }
+    return arena->scratch;
+}
+
+// ========== Basic Operations ==========
+
+// Iterative insert; duplicates are ignored like in insertNode()
+int arenaInsert(TreeArena* arena, int data) {
+    ArenaNode* nodes = arena->nodes;
+    uint32_t parent = TREE_NIL;
+    uint32_t current = arena->root;
+
+    while (current != TREE_NIL) {
+        parent = current;
+        if (data < nodes[current].data) {
+            current = nodes[current].left;
+        } else if (data > nodes[current].data) {
+            current = nodes[current].right;
+        } else {
+            return 0;
+        }
+    }
+
+    uint32_t index = arenaAllocNode(arena, data);
+    if (index == TREE_NIL) {
+        return -1;
+    }
+
+    // arenaAllocNode may have moved the node array
+    nodes = arena->nodes;
+    if (parent == TREE_NIL) {
+        arena->root = index;
+    } else if (data < nodes[parent].data) {
+        nodes[parent].left = index;
+    } else {
+        nodes[parent].right = index;
+    }
+    return 1;
+}
+
+uint32_t arenaSearch(const TreeArena* arena, int data) {
+    const ArenaNode* nodes = arena->nodes;
+    uint32_t current = arena->root;
+
+    while (current != TREE_NIL && nodes[current].data != data) {
+        current = (data < nodes[current].data) ? nodes[current].left
+                                                : nodes[current].right;
+    }
+    return current;
+}
+
+// Number of nodes in the tree (no traversal needed)
+uint32_t arenaSize(const TreeArena* arena) {
+    return arena->count - 1;
+}
+
+// ========== Traversals ==========
+
+// Morris inorder traversal: O(1) extra memory. Threads are temporarily
+// written into empty right links and always removed again, even when the
+// visitor stops early, so the tree is unchanged afterwards.
+void arenaInorder(TreeArena* arena, TreeVisitor visit, void* context) {
+    ArenaNode* nodes = arena->nodes;
+    uint32_t current = arena->root;
+    int stopped = 0;
+
+    while (current != TREE_NIL) {
+        if (nodes[current].left == TREE_NIL) {
+            if (!stopped && visit(nodes[current].data, context)) {
+                stopped = 1;
+            }
+            current = nodes[current].right;
+            continue;
+        }
+
+        // Find the inorder predecessor of current
+        uint32_t predecessor = nodes[current].left;
+        while (nodes[predecessor].right != TREE_NIL &&
+               nodes[predecessor].right != current) {
+            predecessor = nodes[predecessor].right;
+        }
+
+        if (nodes[predecessor].right == TREE_NIL) {
+            if (stopped) {
+                // Nothing threaded below here yet, skip the left subtree
+                current = nodes[current].right;
+                continue;
+            }
+            nodes[predecessor].right = current;   // create thread
+            current = nodes[current].left;
+        } else {
+            nodes[predecessor].right = TREE_NIL;  // remove thread
+            if (!stopped && visit(nodes[current].data, context)) {
+                stopped = 1;
+            }
+            current = nodes[current].right;
+        }
+    }
+}
+
+// Iterative preorder with an explicit stack
+int arenaPreorder(TreeArena* arena, TreeVisitor visit, void* context) {
+    if (arena->root == TREE_NIL) {
+        return 0;
+    }
+
+    uint32_t* stack = arenaScratch(arena);
+    if (stack == NULL) {
+        return -1;
+    }
+
+    const ArenaNode* nodes = arena->nodes;
+    uint32_t top = 0;
+    stack[top++] = arena->root;
+
+    while (top > 0) {
+        uint32_t current = stack[--top];
+        if (visit(nodes[current].data, context)) {
+            break;
+        }
+        if (nodes[current].right != TREE_NIL) {
+            stack[top++] = nodes[current].right;
+        }
+        if (nodes[current].left != TREE_NIL) {
+            stack[top++] = nodes[current].left;
+        }
+    }
+    return 0;
+}
+
+// Iterative postorder with one stack and a "last visited" marker
+int arenaPostorder(TreeArena* arena, TreeVisitor visit, void* context) {
+    uint32_t* stack = arenaScratch(arena);
+    if (stack == NULL) {
+        return -1;
+    }
+
+    const ArenaNode* nodes = arena->nodes;
+    uint32_t top = 0;
+    uint32_t current = arena->root;
+    uint32_t lastVisited = TREE_NIL;
+
+    while (current != TREE_NIL || top > 0) {
+        if (current != TREE_NIL) {
+            stack[top++] = current;
+            current = nodes[current].left;
+            continue;
+        }
+
+        uint32_t peek = stack[top - 1];
+        if (nodes[peek].right != TREE_NIL && nodes[peek].right != lastVisited) {
+            current = nodes[peek].right;
+        } else {
+            if (visit(nodes[peek].data, context)) {
+                break;
+            }
+            lastVisited = peek;
+            top--;
+        }
+    }
+    return 0;
+}
+
+// Level order: every node is enqueued exactly once, so a plain array of
+// arenaSize() slots is a queue that can never overflow
+int arenaLevelOrder(TreeArena* arena, TreeVisitor visit, void* context) {
+    if (arena->root == TREE_NIL) {
+        return 0;
+    }
+
+    uint32_t* queue = arenaScratch(arena);
+    if (queue == NULL) {
+        return -1;
+    }
+
+    const ArenaNode* nodes = arena->nodes;
+    uint32_t front = 0;
+    uint32_t rear = 0;
+    queue[rear++] = arena->root;
+
+    while (front < rear) {
+        uint32_t current = queue[front++];
+        if (visit(nodes[current].data, context)) {
+            break;
+        }
+        if (nodes[current].left != TREE_NIL) {
+            queue[rear++] = nodes[current].left;
+        }
+        if (nodes[current].right != TREE_NIL) {
+            queue[rear++] = nodes[current].right;
+        }
+    }
+    return 0;
+}
+
+// Height by counting BFS levels; -1 for an empty tree like getHeight()
+int arenaHeight(TreeArena* arena) {
+    if (arena->root == TREE_NIL) {
+        return -1;
+    }
+
+    uint32_t* queue = arenaScratch(arena);
+    if (queue == NULL) {
+        return -2;
+    }
+
+    const ArenaNode* nodes = arena->nodes;
+    uint32_t front = 0;
+    uint32_t rear = 0;
+    int height = -1;
+    queue[rear++] = arena->root;
+
+    while (front < rear) {
+        uint32_t levelEnd = rear;
+        while (front < levelEnd) {
+            uint32_t current = queue[front++];
+            if (nodes[current].left != TREE_NIL) {
+                queue[rear++] = nodes[current].left;
+            }
+            if (nodes[current].right != TREE_NIL) {
+                queue[rear++] = nodes[current].right;
+            }
+        }
+        height++;
+    }
+    return height;
+}
+
+// ========== Classic malloc-per-node tree (for comparison) ==========
+
+typedef struct TreeNode {
+    int data;
+    struct TreeNode* left;
+    struct TreeNode* right;
+} TreeNode;
+
+TreeNode* createNode(int data) {
+    TreeNode* newNode = (TreeNode*)malloc(sizeof(TreeNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    newNode->data = data;
+    newNode->left = NULL;
+    newNode->right = NULL;
+    return newNode;
+}
+
+TreeNode* insertNode(TreeNode* root, int data) {
+    if (root == NULL) {
+        return createNode(data);
+    }
+
+    if (data < root->data) {
+        root->left = insertNode(root->left, data);
+    } else if (data > root->data) {
+        root->right = insertNode(root->right, data);
+    }
+
+    return root;
+}
+
+long long sumTree(TreeNode* root) {
+    if (root == NULL) {
+        return 0;
+    }
+    return root->data + sumTree(root->left) + sumTree(root->right);
+}
+
+void freeTree(TreeNode* root) {
+    if (root != NULL) {
+        freeTree(root->left);
+        freeTree(root->right);
+        free(root);
+    }
+}
+
+// ========== Demo Helpers ==========
+
+static int printVisitor(int data, void* context) {
+    (void)context;
+    printf("%d ", data);
+    return 0;
+}
+
+static int sumVisitor(int data, void* context) {
+    *(long long*)context += data;
+    return 0;
+}
+
+typedef struct {
+    int limit;
+    int seen;
+} FirstN;
+
+static int firstNVisitor(int data, void* context) {
+    FirstN* first = (FirstN*)context;
+    printf("%d ", data);
+    return ++first->seen >= first->limit;
+}
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Small xorshift generator so both benchmarks see identical keys
+static uint32_t nextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void runBenchmark(int trees, int nodesPerTree) {
+    struct timespec start, end;
+    long long checksum = 0;
+    uint32_t seed;
+
+    printf("\n=== Benchmark: %d trees x %d nodes (build, sum, free) ===\n",
+           trees, nodesPerTree);
+
+    seed = 12345;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < trees; t++) {
+        TreeNode* root = NULL;
+        for (int i = 0; i < nodesPerTree; i++) {
+            root = insertNode(root, (int)(nextRandom(&seed) % 1000000));
+        }
+        checksum += sumTree(root);
+        freeTree(root);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double mallocTime = elapsedSeconds(start, end);
+    printf("malloc per node : %.3f s (checksum %lld)\n", mallocTime, checksum);
+
+    TreeArena* arena = arenaCreate((uint32_t)nodesPerTree + 1);
+    if (arena == NULL) {
+        return;
+    }
+
+    checksum = 0;
+    seed = 12345;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < trees; t++) {
+        for (int i = 0; i < nodesPerTree; i++) {
+            arenaInsert(arena, (int)(nextRandom(&seed) % 1000000));
+        }
+        arenaInorder(arena, sumVisitor, &checksum);
+        arenaReset(arena);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double arenaTime = elapsedSeconds(start, end);
+    printf("arena + reset   : %.3f s (checksum %lld)\n", arenaTime, checksum);
+    printf("speedup         : %.2fx\n", mallocTime / arenaTime);
+
+    arenaDestroy(arena);
+}
+
+int main(int argc, char* argv[]) {
+    int values[] = {50, 30, 70, 20, 40, 60, 80};
+    int count = sizeof(values) / sizeof(values[0]);
+
+    TreeArena* arena = arenaCreate(16);
+    if (arena == NULL) {
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        arenaInsert(arena, values[i]);
+    }
+
+    printf("Inorder (Morris): ");
+    arenaInorder(arena, printVisitor, NULL);
+    printf("\nPreorder:         ");
+    arenaPreorder(arena, printVisitor, NULL);
+    printf("\nPostorder:        ");
+    arenaPostorder(arena, printVisitor, NULL);
+    printf("\nLevel order:      ");
+    arenaLevelOrder(arena, printVisitor, NULL);
+    printf("\nFirst 3 inorder:  ");
+    FirstN first = {3, 0};
+    arenaInorder(arena, firstNVisitor, &first);
+    printf("\nInorder again:    ");
+    arenaInorder(arena, printVisitor, NULL);
+    printf("\n");
+
+    printf("Height: %d, size: %u, bytes per node: %zu (pointer node: %zu)\n",
+           arenaHeight(arena), arenaSize(arena), sizeof(ArenaNode), sizeof(TreeNode));
+    printf("Search 60: %s\n", arenaSearch(arena, 60) != TREE_NIL ? "found" : "not found");
+    printf("Search 65: %s\n", arenaSearch(arena, 65) != TREE_NIL ? "found" : "not found");
+
+    // A degenerate tree this deep would overflow the stack with recursion
+    arenaReset(arena);
+    const int depth = 1000000;
+    for (int i = 0; i < depth; i++) {
+        uint32_t index = arenaAllocNode(arena, i);
+        if (index == TREE_NIL) {
+            break;
+        }
+        if (i == 0) {
+            arena->root = index;
+        } else {
+            arena->nodes[index - 1].right = index;
+        }
+    }
+    long long total = 0;
+    arenaInorder(arena, sumVisitor, &total);
+    printf("\nDegenerate tree of %u nodes: height %d, sum %lld\n",
+           arenaSize(arena), arenaHeight(arena), total);
+    arenaDestroy(arena);
+
+    int trees = (argc > 1) ? atoi(argv[1]) : 20000;
+    int nodesPerTree = (argc > 2) ? atoi(argv[2]) : 64;
+    if (trees > 0 && nodesPerTree > 0) {
+        runBenchmark(trees, nodesPerTree);
+    }
+
+    return 0;
+}
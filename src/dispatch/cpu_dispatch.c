@@ -0,0 +1,244 @@
+/*
+ * cpu_dispatch.c - CPU Feature Detection and Kernel Registry (see cpu_dispatch.h)
+ */
+
+#include "cpu_dispatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define DISPATCH_X86 1
+#endif
+
+static const char* featureNames[CPU_FEATURE_COUNT] = {
+    "sse2", "ssse3", "sse41", "sse42", "popcnt", "pclmul", "avx", "avx2", "fma",
+    "bmi1", "bmi2", "avx512f", "avx512dq", "avx512bw", "avx512vl", "avx512vbmi",
+    "avx512vpopcntdq", "avx512bitalg"
+};
+
+// ========== Detection ==========
+
+#ifdef DISPATCH_X86
+// XCR0 says which register sets the OS saves on a context switch
+static unsigned long long readXcr0(void) {
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+}
+#endif
+
+unsigned cpuDetectedFeatures(void) {
+    static int detected = 0;
+    static unsigned features = 0;
+    if (detected) {
+        return features;
+    }
+
+#ifdef DISPATCH_X86
+    unsigned eax, ebx, ecx, edx;
+    unsigned result = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        if (edx & (1u << 26)) result |= CPU_SSE2;
+        if (ecx & (1u << 9))  result |= CPU_SSSE3;
+        if (ecx & (1u << 19)) result |= CPU_SSE41;
+        if (ecx & (1u << 20)) result |= CPU_SSE42;
+        if (ecx & (1u << 23)) result |= CPU_POPCNT;
+        if (ecx & (1u << 1))  result |= CPU_PCLMUL;
+
+        int osSavesAvx = 0;
+        int osSavesAvx512 = 0;
+        if (ecx & (1u << 27)) {   // OSXSAVE: xgetbv is available
+            unsigned long long xcr0 = readXcr0();
+            osSavesAvx = (xcr0 & 0x6) == 0x6;        // XMM + YMM state
+            osSavesAvx512 = (xcr0 & 0xe6) == 0xe6;   // + opmask, ZMM0-15, ZMM16-31
+        }
+        if (osSavesAvx && (ecx & (1u << 28))) result |= CPU_AVX;
+        if (osSavesAvx && (ecx & (1u << 12))) result |= CPU_FMA;
+
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            if (ebx & (1u << 3)) result |= CPU_BMI1;
+            if (ebx & (1u << 8)) result |= CPU_BMI2;
+            if (osSavesAvx && (ebx & (1u << 5))) result |= CPU_AVX2;
+            if (osSavesAvx512) {
+                if (ebx & (1u << 16)) result |= CPU_AVX512F;
+                if (ebx & (1u << 17)) result |= CPU_AVX512DQ;
+                if (ebx & (1u << 30)) result |= CPU_AVX512BW;
+                if (ebx & (1u << 31)) result |= CPU_AVX512VL;
+                if (ecx & (1u << 1))  result |= CPU_AVX512VBMI;
+                if (ecx & (1u << 14)) result |= CPU_AVX512VPOPCNTDQ;
+                if (ecx & (1u << 12)) result |= CPU_AVX512BITALG;
+            }
+        }
+    }
+    features = result;
+#endif
+
+    detected = 1;
+    return features;
+}
+
+// ========== CPU_DISPATCH Override ==========
+
+// Each feature builds on an older one; removing "avx" must also remove
+// avx2 and AVX-512, or a kernel could be chosen for an unusable register set
+static unsigned withPrerequisites(unsigned features) {
+    static const struct { unsigned feature; unsigned needs; } rules[] = {
+        { CPU_SSSE3, CPU_SSE2 },       { CPU_SSE41, CPU_SSSE3 },     { CPU_SSE42, CPU_SSE41 },
+        { CPU_AVX, CPU_SSE42 },        { CPU_AVX2, CPU_AVX },        { CPU_FMA, CPU_AVX },
+        { CPU_AVX512F, CPU_AVX2 },     { CPU_AVX512DQ, CPU_AVX512F }, { CPU_AVX512BW, CPU_AVX512F },
+        { CPU_AVX512VL, CPU_AVX512F }, { CPU_AVX512VBMI, CPU_AVX512BW },
+        { CPU_AVX512VPOPCNTDQ, CPU_AVX512F }, { CPU_AVX512BITALG, CPU_AVX512BW },
+    };
+    // Rules are ordered so that one pass settles every chain
+    for (size_t i = 0; i < sizeof(rules) / sizeof(rules[0]); i++) {
+        if (!(features & rules[i].needs)) {
+            features &= ~rules[i].feature;
+        }
+    }
+    return features;
+}
+
+static int featureIndex(const char* name, size_t length) {
+    for (int i = 0; i < CPU_FEATURE_COUNT; i++) {
+        if (strlen(featureNames[i]) == length && strncmp(featureNames[i], name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// "scalar"/"none" clears everything, "-name" removes one feature, and
+// plain names form an allow-list. Unknown names are reported and skipped.
+unsigned cpuParseFeatureMask(const char* spec, unsigned detected) {
+    unsigned allowed = 0;
+    unsigned removed = 0;
+    int hasAllowList = 0;
+
+    while (*spec != '\0') {
+        size_t length = strcspn(spec, ", ");
+        if (length > 0) {
+            int remove = spec[0] == '-';
+            const char* name = spec + remove;
+            size_t nameLength = length - (size_t)remove;
+
+            if ((nameLength == 6 && strncmp(name, "scalar", 6) == 0) ||
+                (nameLength == 4 && strncmp(name, "none", 4) == 0)) {
+                hasAllowList = 1;
+            } else {
+                int index = featureIndex(name, nameLength);
+                if (index < 0) {
+                    fprintf(stderr, "CPU_DISPATCH: unknown feature '%.*s'\n", (int)nameLength, name);
+                } else if (remove) {
+                    removed |= 1u << index;
+                } else {
+                    allowed |= 1u << index;
+                    hasAllowList = 1;
+                }
+            }
+        }
+        spec += length;
+        spec += strspn(spec, ", ");
+    }
+
+    unsigned features = hasAllowList ? (detected & allowed) : detected;
+    return withPrerequisites(features & ~removed);
+}
+
+static int overrideActive = 0;
+static unsigned activeFeatures = 0;
+
+unsigned cpuFeatures(void) {
+    if (!overrideActive) {
+        const char* spec = getenv("CPU_DISPATCH");
+        unsigned detected = cpuDetectedFeatures();
+        activeFeatures = spec != NULL ? cpuParseFeatureMask(spec, detected) : detected;
+        overrideActive = 1;
+    }
+    return activeFeatures;
+}
+
+void cpuFeatureNames(unsigned features, char* buffer, size_t size) {
+    size_t used = 0;
+    buffer[0] = '\0';
+    for (int i = 0; i < CPU_FEATURE_COUNT; i++) {
+        if ((features & (1u << i)) && used < size) {
+            int written = snprintf(buffer + used, size - used, "%s%s", used ? " " : "", featureNames[i]);
+            used += written > 0 ? (size_t)written : 0;
+        }
+    }
+    if (used == 0) {
+        snprintf(buffer, size, "(none)");
+    }
+}
+
+// ========== Kernel Registry ==========
+
+static DispatchKernel* kernels = NULL;
+
+static void resolve(DispatchKernel* kernel) {
+    unsigned features = cpuFeatures();
+    kernel->chosen = NULL;
+    for (int i = 0; i < kernel->variantCount; i++) {
+        const DispatchVariant* variant = &kernel->variants[i];
+        if ((features & variant->required) == variant->required) {
+            kernel->chosen = variant;
+            break;
+        }
+    }
+    if (kernel->chosen == NULL) {
+        // The last variant is the portable fallback
+        kernel->chosen = &kernel->variants[kernel->variantCount - 1];
+    }
+    kernel->assign(kernel->chosen->function);
+}
+
+void dispatchRegister(DispatchKernel* kernel) {
+    kernel->next = kernels;
+    kernels = kernel;
+    resolve(kernel);
+}
+
+void dispatchResolveAll(void) {
+    for (DispatchKernel* kernel = kernels; kernel != NULL; kernel = kernel->next) {
+        resolve(kernel);
+    }
+}
+
+void dispatchSetFeatures(unsigned features) {
+    cpuFeatures();   // make sure CPU_DISPATCH has been read, so it is not reapplied
+    activeFeatures = withPrerequisites(features & cpuDetectedFeatures());
+    dispatchResolveAll();
+}
+
+const DispatchKernel* dispatchFind(const char* name) {
+    for (DispatchKernel* kernel = kernels; kernel != NULL; kernel = kernel->next) {
+        if (strcmp(kernel->name, name) == 0) {
+            return kernel;
+        }
+    }
+    return NULL;
+}
+
+int dispatchUseVariant(const DispatchKernel* kernel, int index) {
+    if (index < 0 || index >= kernel->variantCount || !cpuHas(kernel->variants[index].required)) {
+        return 0;
+    }
+    kernel->assign(kernel->variants[index].function);
+    return 1;
+}
+
+void dispatchRestore(const DispatchKernel* kernel) {
+    kernel->assign(kernel->chosen->function);
+}
+
+void dispatchPrint(FILE* out) {
+    char names[256];
+    cpuFeatureNames(cpuFeatures(), names, sizeof(names));
+    fprintf(out, "CPU features in use: %s\n", names);
+    for (const DispatchKernel* kernel = kernels; kernel != NULL; kernel = kernel->next) {
+        fprintf(out, "  %-24s -> %s\n", kernel->name, kernel->chosen->name);
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * cpu_dispatch.h - Pick the Fastest Kernel Variant for This CPU at Startup
+ *
+ * A portable binary is compiled for baseline x86-64 (SSE2), so without help
+ * it never uses POPCNT, AVX2 or AVX-512 even when the CPU has them. This
+ * layer lets one binary carry several versions of a hot function:
+ *
+ * 1. cpuFeatures() runs cpuid once. It also checks with xgetbv that the OS
+ *    saves the AVX/AVX-512 registers, since a CPU flag alone is not enough.
+ * 2. Each kernel is a function pointer plus a list of variants, best first.
+ *    Every variant names the features it needs, and the last one must need
+ *    none. The pointer is set to the first variant the CPU supports.
+ * 3. The CPU_DISPATCH environment variable restricts the features, so every
+ *    path can be tested on one machine:
+ *      CPU_DISPATCH=scalar          baseline only
+ *      CPU_DISPATCH=-avx512f        everything except AVX-512
+ *      CPU_DISPATCH=sse42,popcnt    only these (if the CPU has them)
+ *
+ * Declaring a kernel (variants are compiled with __attribute__((target))):
+ *
+ *   typedef size_t (*CountFunction)(const uint64_t*, size_t);
+ *   DISPATCH_KERNEL(CountFunction, countBits,
+ *       DISPATCH_VARIANT(countBitsAvx512, CPU_AVX512F | CPU_AVX512VPOPCNTDQ),
+ *       DISPATCH_VARIANT(countBitsPopcnt, CPU_POPCNT),
+ *       DISPATCH_VARIANT(countBitsScalar, 0))
+ *
+ *   total = countBits(words, n);   // an ordinary indirect call
+ *
+ * The kernel is resolved by a constructor before main() runs. Compile
+ * together with cpu_dispatch.c:
+ *   gcc -O2 -o program program.c cpu_dispatch.c
+ */
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <stdio.h>
+
+typedef enum {
+    CPU_SSE2            = 1u << 0,
+    CPU_SSSE3           = 1u << 1,
+    CPU_SSE41           = 1u << 2,
+    CPU_SSE42           = 1u << 3,
+    CPU_POPCNT          = 1u << 4,
+    CPU_PCLMUL          = 1u << 5,
+    CPU_AVX             = 1u << 6,
+    CPU_AVX2            = 1u << 7,
+    CPU_FMA             = 1u << 8,
+    CPU_BMI1            = 1u << 9,
+    CPU_BMI2            = 1u << 10,
+    CPU_AVX512F         = 1u << 11,
+    CPU_AVX512DQ        = 1u << 12,
+    CPU_AVX512BW        = 1u << 13,
+    CPU_AVX512VL        = 1u << 14,
+    CPU_AVX512VBMI      = 1u << 15,
+    CPU_AVX512VPOPCNTDQ = 1u << 16,
+    CPU_AVX512BITALG    = 1u << 17
+} CpuFeature;
+
+#define CPU_FEATURE_COUNT 18
+
+// Detected features, restricted by CPU_DISPATCH (computed once)
+unsigned cpuFeatures(void);
+
+// Features the hardware and OS support, ignoring CPU_DISPATCH
+unsigned cpuDetectedFeatures(void);
+
+static inline int cpuHas(unsigned required) {
+    return (cpuFeatures() & required) == required;
+}
+
+// Parse a CPU_DISPATCH-style string against `detected`
+unsigned cpuParseFeatureMask(const char* spec, unsigned detected);
+
+// Write names like "sse2 popcnt avx2" into buffer
+void cpuFeatureNames(unsigned features, char* buffer, size_t size);
+
+// ========== Kernel Registry ==========
+
+typedef void (*DispatchFunction)(void);
+
+typedef struct {
+    const char* name;
+    unsigned required;
+    DispatchFunction function;
+} DispatchVariant;
+
+typedef struct DispatchKernel {
+    const char* name;
+    void (*assign)(DispatchFunction function);   // stores into the typed pointer
+    const DispatchVariant* variants;
+    int variantCount;
+    const DispatchVariant* chosen;
+    struct DispatchKernel* next;
+} DispatchKernel;
+
+void dispatchRegister(DispatchKernel* kernel);
+
+// Override the feature set (e.g. to benchmark each variant) and re-resolve
+// every registered kernel. Not thread-safe: call before starting threads.
+void dispatchSetFeatures(unsigned features);
+void dispatchResolveAll(void);
+
+const DispatchKernel* dispatchFind(const char* name);
+void dispatchPrint(FILE* out);
+
+// Point one kernel at variants[index], to check or time every variant through
+// the public functions that call it. Returns 0, changing nothing, when this
+// CPU (or CPU_DISPATCH) lacks the variant's features. dispatchRestore() puts
+// the chosen variant back. Same rule as dispatchSetFeatures: no threads.
+int dispatchUseVariant(const DispatchKernel* kernel, int index);
+void dispatchRestore(const DispatchKernel* kernel);
+
+#define DISPATCH_VARIANT(function, required) \
+    { #function, (required), (DispatchFunction)(function) }
+
+#define DISPATCH_KERNEL(Type, pointer, ...)                                          \
+    Type pointer;                                                                    \
+    static void pointer##Assign(DispatchFunction function) {                        \
+        pointer = (Type)function;                                                    \
+    }                                                                                \
+    static const DispatchVariant pointer##Variants[] = { __VA_ARGS__ };              \
+    static DispatchKernel pointer##Kernel = {                                        \
+        #pointer, pointer##Assign, pointer##Variants,                                \
+        (int)(sizeof(pointer##Variants) / sizeof(pointer##Variants[0])), NULL, NULL  \
+    };                                                                               \
+    __attribute__((constructor)) static void pointer##Register(void) {              \
+        dispatchRegister(&pointer##Kernel);                                          \
+    }
+
+#endif
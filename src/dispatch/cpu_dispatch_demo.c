@@ -0,0 +1,354 @@
+/*
+ * CPU Dispatch Demo: Kernels from the Repo with Scalar and SIMD Variants
+ *
+ * Registers four hot loops, each with a portable version taken from the
+ * repo and faster versions for newer CPUs:
+ *
+ *   countBits     count_set_bits() (loopholes/03_bitwise_tricks.c) over an
+ *                 array: Kernighan loop, POPCNT, AVX2 nibble lookup,
+ *                 AVX-512 VPOPCNTDQ
+ *   stringLength  strlen-style scan: byte loop, SSE2, AVX2
+ *   countEqual    linearSearch-style count of a key: loop, AVX2, AVX-512
+ *   absArray      abs_no_branch() over an array: scalar, AVX2
+ *
+ * It prints which variant each kernel resolved to, checks that every
+ * variant the CPU can run gives the same answer, and times each one.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o cpu_dispatch_demo cpu_dispatch_demo.c cpu_dispatch.c
+ *   ./cpu_dispatch_demo                          (best variants)
+ *   CPU_DISPATCH=scalar ./cpu_dispatch_demo      (portable code only)
+ *   CPU_DISPATCH=-avx512f ./cpu_dispatch_demo    (as on a CPU without AVX-512)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <immintrin.h>
+#include "cpu_dispatch.h"
+
+// ========== countBits ==========
+
+static size_t countBitsScalar(const uint64_t* words, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t word = words[i];
+        while (word) {
+            word &= word - 1;   // Clears the least significant set bit
+            count++;
+        }
+    }
+    return count;
+}
+
+__attribute__((target("popcnt")))
+static size_t countBitsPopcnt(const uint64_t* words, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += (size_t)__builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+// Look up the bit count of each 4-bit nibble with vpshufb, then sum the
+// bytes of each 64-bit lane with vpsadbw
+__attribute__((target("avx2")))
+static size_t countBitsAvx2(const uint64_t* words, size_t n) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(words + i));
+        __m256i counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+            _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    size_t count = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    for (; i < n; i++) {
+        count += (size_t)__builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t countBitsAvx512(const uint64_t* words, size_t n) {
+    __m512i total = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+    }
+    __mmask8 rest = (__mmask8)((1u << (n - i)) - 1);
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(rest, words + i)));
+    return (size_t)_mm512_reduce_add_epi64(total);
+}
+
+typedef size_t (*CountBitsFunction)(const uint64_t* words, size_t n);
+DISPATCH_KERNEL(CountBitsFunction, countBits,
+    DISPATCH_VARIANT(countBitsAvx512, CPU_AVX512F | CPU_AVX512VPOPCNTDQ),
+    DISPATCH_VARIANT(countBitsAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(countBitsPopcnt, CPU_POPCNT),
+    DISPATCH_VARIANT(countBitsScalar, 0))
+
+// ========== stringLength ==========
+
+static size_t stringLengthScalar(const char* s) {
+    const char* p = s;
+    while (*p) {
+        p++;
+    }
+    return (size_t)(p - s);
+}
+
+// Aligned loads never cross into the next page, so reading a few bytes
+// past the terminator cannot fault. The sanitizer cannot know that.
+__attribute__((target("sse2"), no_sanitize_address))
+static size_t stringLengthSse2(const char* s) {
+    uintptr_t misalign = (uintptr_t)s & 15;
+    const __m128i* block = (const __m128i*)(s - misalign);
+    const __m128i zero = _mm_setzero_si128();
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero)) >> misalign;
+    if (mask != 0) {
+        return (size_t)__builtin_ctz(mask);
+    }
+    for (;;) {
+        block++;
+        mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero));
+        if (mask != 0) {
+            return (size_t)((const char*)block - s) + (size_t)__builtin_ctz(mask);
+        }
+    }
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+static size_t stringLengthAvx2(const char* s) {
+    uintptr_t misalign = (uintptr_t)s & 31;
+    const __m256i* block = (const __m256i*)(s - misalign);
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero)) >> misalign;
+    if (mask != 0) {
+        return (size_t)__builtin_ctz(mask);
+    }
+    for (;;) {
+        block++;
+        mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(block), zero));
+        if (mask != 0) {
+            return (size_t)((const char*)block - s) + (size_t)__builtin_ctz(mask);
+        }
+    }
+}
+
+typedef size_t (*StringLengthFunction)(const char* s);
+DISPATCH_KERNEL(StringLengthFunction, stringLength,
+    DISPATCH_VARIANT(stringLengthAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(stringLengthSse2, CPU_SSE2),
+    DISPATCH_VARIANT(stringLengthScalar, 0))
+
+// ========== countEqual ==========
+
+static size_t countEqualScalar(const int* arr, size_t n, int key) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] == key) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// A comparison gives -1 per matching lane; subtracting it counts matches
+__attribute__((target("avx2")))
+static size_t countEqualAvx2(const int* arr, size_t n, int key) {
+    const __m256i needle = _mm256_set1_epi32(key);
+    __m256i counts = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(arr + i));
+        counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(v, needle));
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, counts);
+    size_t count = 0;
+    for (int lane = 0; lane < 8; lane++) {
+        count += (size_t)(unsigned)lanes[lane];
+    }
+    return count + countEqualScalar(arr + i, n - i, key);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static size_t countEqualAvx512(const int* arr, size_t n, int key) {
+    const __m512i needle = _mm512_set1_epi32(key);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 match = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(arr + i), needle);
+        count += (size_t)__builtin_popcount(match);
+    }
+    __mmask16 rest = (__mmask16)((1u << (n - i)) - 1);
+    __mmask16 match = _mm512_mask_cmpeq_epi32_mask(rest, _mm512_maskz_loadu_epi32(rest, arr + i), needle);
+    return count + (size_t)__builtin_popcount(match);
+}
+
+typedef size_t (*CountEqualFunction)(const int* arr, size_t n, int key);
+DISPATCH_KERNEL(CountEqualFunction, countEqual,
+    DISPATCH_VARIANT(countEqualAvx512, CPU_AVX512F | CPU_POPCNT),
+    DISPATCH_VARIANT(countEqualAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(countEqualScalar, 0))
+
+// ========== absArray ==========
+
+static void absArrayScalar(int* arr, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int mask = arr[i] >> 31;   // 0 for positive, -1 for negative
+        arr[i] = (arr[i] + mask) ^ mask;
+    }
+}
+
+__attribute__((target("avx2")))
+static void absArrayAvx2(int* arr, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(arr + i));
+        _mm256_storeu_si256((__m256i*)(arr + i), _mm256_abs_epi32(v));
+    }
+    absArrayScalar(arr + i, n - i);
+}
+
+typedef void (*AbsArrayFunction)(int* arr, size_t n);
+DISPATCH_KERNEL(AbsArrayFunction, absArray,
+    DISPATCH_VARIANT(absArrayAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(absArrayScalar, 0))
+
+// ========== Checks and Benchmark ==========
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+typedef struct {
+    uint64_t* words;
+    char* text;
+    int* values;
+    int* scratch;
+    size_t n;
+} Inputs;
+
+// Run variant `v` of `kernel` once and return a checksum of its result
+static uint64_t runVariant(const DispatchKernel* kernel, int v, const Inputs* in) {
+    DispatchFunction function = kernel->variants[v].function;
+    if (strcmp(kernel->name, "countBits") == 0) {
+        return ((CountBitsFunction)function)(in->words, in->n);
+    }
+    if (strcmp(kernel->name, "stringLength") == 0) {
+        return ((StringLengthFunction)function)(in->text);
+    }
+    if (strcmp(kernel->name, "countEqual") == 0) {
+        return ((CountEqualFunction)function)(in->values, in->n, 7);
+    }
+    memcpy(in->scratch, in->values, in->n * sizeof(int));
+    ((AbsArrayFunction)function)(in->scratch, in->n);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < in->n; i++) {
+        sum += (uint64_t)in->scratch[i];
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1u << 20;
+    int repeats = argc > 2 ? atoi(argv[2]) : 50;
+    if (n == 0 || repeats < 1) {
+        printf("Usage: %s [elements] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    char detected[256];
+    cpuFeatureNames(cpuDetectedFeatures(), detected, sizeof(detected));
+    printf("=== CPU Dispatch ===\n");
+    printf("CPU features detected: %s\n", detected);
+    dispatchPrint(stdout);
+
+    Inputs in;
+    in.n = n;
+    in.words = (uint64_t*)malloc(n * sizeof(uint64_t));
+    in.text = (char*)malloc(n + 1);
+    in.values = (int*)malloc(n * sizeof(int));
+    in.scratch = (int*)malloc(n * sizeof(int));
+    if (in.words == NULL || in.text == NULL || in.values == NULL || in.scratch == NULL) {
+        printf("Memory allocation failed\n");
+        free(in.words); free(in.text); free(in.values); free(in.scratch);
+        return 1;
+    }
+    unsigned seed = 2463534242u;
+    for (size_t i = 0; i < n; i++) {
+        in.words[i] = ((uint64_t)nextRandom(&seed) << 32) | nextRandom(&seed);
+        in.text[i] = (char)('a' + nextRandom(&seed) % 26);
+        in.values[i] = (int)(nextRandom(&seed) % 2001) - 1000;
+    }
+    in.text[n] = '\0';
+
+    printf("\nQuick check: countBits of {7, 255} = %zu, stringLength(\"dispatch\") = %zu\n",
+           countBits((const uint64_t[]){ 7, 255 }, 2), stringLength("dispatch"));
+
+    printf("\n=== Variants (%zu elements x %d repeats) ===\n", n, repeats);
+    printf("%-14s %-20s %10s %10s %8s\n", "Kernel", "Variant", "ns/elem", "speedup", "result");
+
+    const char* names[] = { "countBits", "stringLength", "countEqual", "absArray" };
+    bool allMatch = true;
+    for (int k = 0; k < 4; k++) {
+        const DispatchKernel* kernel = dispatchFind(names[k]);
+        uint64_t expected = runVariant(kernel, kernel->variantCount - 1, &in);
+        double scalarTime = 0;
+
+        // Portable variant first, then the faster ones
+        for (int v = kernel->variantCount - 1; v >= 0; v--) {
+            const DispatchVariant* variant = &kernel->variants[v];
+            if (!cpuHas(variant->required)) {
+                printf("%-14s %-20s %10s\n", kernel->name, variant->name, "skipped");
+                continue;
+            }
+
+            struct timespec start, end;
+            uint64_t result = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int r = 0; r < repeats; r++) {
+                result = runVariant(kernel, v, &in);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double seconds = elapsedSeconds(start, end) / repeats;
+            if (v == kernel->variantCount - 1) {
+                scalarTime = seconds;
+            }
+
+            bool match = result == expected;
+            allMatch = allMatch && match;
+            printf("%-14s %-20s %10.3f %9.1fx %8s%s\n", kernel->name, variant->name,
+                   seconds * 1e9 / (double)n, scalarTime / seconds, match ? "ok" : "WRONG",
+                   variant == kernel->chosen ? "  <- chosen" : "");
+        }
+    }
+    printf("All variants agree: %s\n", allMatch ? "yes" : "no");
+
+    free(in.words);
+    free(in.text);
+    free(in.values);
+    free(in.scratch);
+    return allMatch ? 0 : 1;
+}
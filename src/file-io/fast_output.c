@@ -0,0 +1,553 @@
+/*
+ * fast_output.c - Buffered Output with Fast Number Formatting (see fast_output.h)
+ */
+
+#include "fast_output.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+typedef unsigned __int128 uint128;
+
+// ========== Integers ==========
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint64_t POWERS_OF_10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+// Digits of value: log10 estimated from the bit length (1233/4096 is just
+// above log10(2)), then corrected by one comparison; 0 counts as 1 digit
+static inline int decimalLength(uint64_t value) {
+    value |= 1;
+    int bits = 64 - __builtin_clzll(value);
+    int guess = (bits * 1233) >> 12;
+    return guess + (value >= POWERS_OF_10[guess]);
+}
+
+// Write `length` digits of value ending at text + length, two at a time
+static inline void writeDigits(char* text, int length, uint64_t value) {
+    char* end = text + length;
+    while (value >= 100) {
+        uint64_t pair = value % 100;
+        value /= 100;
+        end -= 2;
+        memcpy(end, DIGIT_PAIRS + 2 * pair, 2);
+    }
+    if (value >= 10) {
+        memcpy(end - 2, DIGIT_PAIRS + 2 * value, 2);
+    } else {
+        end[-1] = (char)('0' + value);
+    }
+}
+
+int formatUnsigned(char* text, uint64_t value) {
+    int length = decimalLength(value);
+    writeDigits(text, length, value);
+    return length;
+}
+
+int formatInt(char* text, int64_t value) {
+    if (value < 0) {
+        *text = '-';
+        // Negate as unsigned so INT64_MIN works
+        return 1 + formatUnsigned(text + 1, 0 - (uint64_t)value);
+    }
+    return formatUnsigned(text, (uint64_t)value);
+}
+
+// ========== Shortest Doubles (Ryu) ==========
+//
+// A double is m2 * 2^e2. Ryu computes the decimal interval of numbers that
+// round back to it, scaled by a power of 10 so the ends are integers
+// (vm < vr < vp), then removes digits while the ends still differ. The
+// scaling multiplies by 5^i or 2^k / 5^q as 125-bit fixed-point numbers.
+// The tables are computed once at startup from exact big integers.
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_BIAS 1023
+#define POW5_BITCOUNT 125
+#define POW5_INV_BITCOUNT 125
+#define POW5_TABLE_SIZE 326
+#define POW5_INV_TABLE_SIZE 342
+
+static uint64_t pow5Split[POW5_TABLE_SIZE][2];         // 5^i, top 125 bits
+static uint64_t pow5InvSplit[POW5_INV_TABLE_SIZE][2];  // 2^(bits(5^q) - 1 + 125) / 5^q + 1
+
+// Bit length of 5^e: ceil(e * log2(5)), and 1 for e = 0
+static inline int pow5bits(int e) {
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+static inline uint32_t log10Pow2(int e) {   // floor(e * log10(2))
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+static inline uint32_t log10Pow5(int e) {   // floor(e * log10(5))
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+// Little-endian big integer, enough words for 5^341 (792 bits)
+#define BIG_WORDS 26
+
+typedef struct {
+    uint32_t words[BIG_WORDS];
+} BigInt;
+
+static int bigBitLength(const BigInt* a) {
+    for (int w = BIG_WORDS - 1; w >= 0; w--) {
+        if (a->words[w] != 0) {
+            return 32 * w + 32 - __builtin_clz(a->words[w]);
+        }
+    }
+    return 0;
+}
+
+static int bigBit(const BigInt* a, int bit) {
+    return bit >= 0 && bit < 32 * BIG_WORDS ? (a->words[bit >> 5] >> (bit & 31)) & 1 : 0;
+}
+
+static void bigMultiply5(BigInt* a) {
+    uint64_t carry = 0;
+    for (int w = 0; w < BIG_WORDS; w++) {
+        uint64_t product = (uint64_t)a->words[w] * 5 + carry;
+        a->words[w] = (uint32_t)product;
+        carry = product >> 32;
+    }
+}
+
+static int bigCompare(const BigInt* a, const BigInt* b) {
+    for (int w = BIG_WORDS - 1; w >= 0; w--) {
+        if (a->words[w] != b->words[w]) {
+            return a->words[w] < b->words[w] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void bigSubtract(BigInt* a, const BigInt* b) {
+    int64_t borrow = 0;
+    for (int w = 0; w < BIG_WORDS; w++) {
+        int64_t difference = (int64_t)a->words[w] - b->words[w] - borrow;
+        borrow = difference < 0;
+        a->words[w] = (uint32_t)difference;
+    }
+}
+
+static void bigShiftLeft1(BigInt* a) {
+    for (int w = BIG_WORDS - 1; w > 0; w--) {
+        a->words[w] = a->words[w] << 1 | a->words[w - 1] >> 31;
+    }
+    a->words[0] <<= 1;
+}
+
+// Bits [low, low + 128) of a, as two 64-bit halves
+static void bigExtract(const BigInt* a, int low, uint64_t out[2]) {
+    out[0] = out[1] = 0;
+    for (int b = 0; b < 128; b++) {
+        out[b >> 6] |= (uint64_t)bigBit(a, low + b) << (b & 63);
+    }
+}
+
+__attribute__((constructor)) static void buildPowerTables(void) {
+    BigInt power;
+    memset(&power, 0, sizeof(power));
+    power.words[0] = 1;
+    for (int i = 0; i < POW5_INV_TABLE_SIZE; i++) {
+        int length = bigBitLength(&power);
+        if (i < POW5_TABLE_SIZE) {
+            // Top 125 bits; for small powers this reads zeros below bit 0
+            bigExtract(&power, length - POW5_BITCOUNT, pow5Split[i]);
+        }
+        // floor(2^(length - 1 + 125) / 5^i) by long division. The quotient
+        // has 126 bits at most, and the remainder starts at 2^(length - 2)
+        uint64_t quotient[2] = { 0, 0 };
+        if (i == 0) {
+            quotient[1] = 1ull << (POW5_INV_BITCOUNT - 64);
+        } else {
+            BigInt remainder;
+            memset(&remainder, 0, sizeof(remainder));
+            remainder.words[(length - 2) >> 5] = 1u << ((length - 2) & 31);
+            for (int bit = POW5_INV_BITCOUNT; bit >= 0; bit--) {
+                bigShiftLeft1(&remainder);
+                if (bigCompare(&remainder, &power) >= 0) {
+                    bigSubtract(&remainder, &power);
+                    quotient[bit >> 6] |= 1ull << (bit & 63);
+                }
+            }
+        }
+        // + 1
+        quotient[0]++;
+        quotient[1] += quotient[0] == 0;
+        pow5InvSplit[i][0] = quotient[0];
+        pow5InvSplit[i][1] = quotient[1];
+        bigMultiply5(&power);
+    }
+}
+
+static inline uint32_t pow5Factor(uint64_t value) {
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count;
+}
+
+static inline bool multipleOfPowerOf5(uint64_t value, uint32_t p) {
+    return pow5Factor(value) >= p;
+}
+
+static inline bool multipleOfPowerOf2(uint64_t value, uint32_t p) {
+    return (value & ((1ull << p) - 1)) == 0;
+}
+
+// (m * mul) >> j for a 128-bit mul and j >= 64
+static inline uint64_t mulShift64(uint64_t m, const uint64_t mul[2], int j) {
+    uint128 low = (uint128)m * mul[0];
+    uint128 high = (uint128)m * mul[1];
+    return (uint64_t)(((low >> 64) + high) >> (j - 64));
+}
+
+typedef struct {
+    uint64_t mantissa;   // decimal digits, no trailing zeros needed
+    int exponent;        // value = mantissa * 10^exponent
+} DecimalDouble;
+
+static DecimalDouble shortestDecimal(uint64_t ieeeMantissa, uint32_t ieeeExponent) {
+    int e2;
+    uint64_t m2;
+    if (ieeeExponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieeeMantissa;
+    } else {
+        e2 = (int)ieeeExponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (1ull << DOUBLE_MANTISSA_BITS) | ieeeMantissa;
+    }
+    bool acceptBounds = (m2 & 1) == 0;   // round-half-even reads the ends back to this value
+
+    // The interval is [4*m2 - 1 - mmShift, 4*m2 + 2] * 2^e2; the lower gap
+    // is half as wide at powers of two
+    uint64_t mv = 4 * m2;
+    uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+
+    uint64_t vr, vp, vm;
+    int e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    if (e2 >= 0) {
+        uint32_t q = log10Pow2(e2) - (e2 > 3);
+        e10 = (int)q;
+        int k = POW5_INV_BITCOUNT + pow5bits((int)q) - 1;
+        int i = -e2 + (int)q + k;
+        vr = mulShift64(4 * m2, pow5InvSplit[q], i);
+        vp = mulShift64(4 * m2 + 2, pow5InvSplit[q], i);
+        vm = mulShift64(4 * m2 - 1 - mmShift, pow5InvSplit[q], i);
+        if (q <= 21) {
+            // Only here can the scaled ends be exact integers
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = multipleOfPowerOf5(mv, q);
+            } else if (acceptBounds) {
+                vmIsTrailingZeros = multipleOfPowerOf5(mv - 1 - mmShift, q);
+            } else {
+                vp -= multipleOfPowerOf5(mv + 2, q);
+            }
+        }
+    } else {
+        uint32_t q = log10Pow5(-e2) - (-e2 > 1);
+        e10 = (int)q + e2;
+        int i = -e2 - (int)q;
+        int k = pow5bits(i) - POW5_BITCOUNT;
+        int j = (int)q - k;
+        vr = mulShift64(4 * m2, pow5Split[i], j);
+        vp = mulShift64(4 * m2 + 2, pow5Split[i], j);
+        vm = mulShift64(4 * m2 - 1 - mmShift, pow5Split[i], j);
+        if (q <= 1) {
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = mmShift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vrIsTrailingZeros = multipleOfPowerOf2(mv, q);
+        }
+    }
+
+    // Remove digits while vm and vp still differ
+    int removed = 0;
+    uint8_t lastRemovedDigit = 0;
+    uint64_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        // Exact ends (rare): track trailing zeros for correct ties
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            lastRemovedDigit = 4;   // exactly halfway: round to even
+        }
+        output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+    } else {
+        // Common case: two digits at a time first
+        bool roundUp = false;
+        if (vp / 100 > vm / 100) {
+            roundUp = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            roundUp = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || roundUp);
+    }
+    return (DecimalDouble){ output, e10 + removed };
+}
+
+int formatDouble(char* text, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    bool negative = bits >> 63;
+    uint64_t ieeeMantissa = bits & ((1ull << DOUBLE_MANTISSA_BITS) - 1);
+    uint32_t ieeeExponent = (uint32_t)(bits >> DOUBLE_MANTISSA_BITS) & 0x7FF;
+
+    char* start = text;
+    if (ieeeExponent == 0x7FF) {
+        if (ieeeMantissa != 0) {
+            memcpy(text, "nan", 3);
+            return 3;
+        }
+        if (negative) {
+            *text++ = '-';
+        }
+        memcpy(text, "inf", 3);
+        return (int)(text - start) + 3;
+    }
+    if (negative) {
+        *text++ = '-';
+    }
+    if (ieeeExponent == 0 && ieeeMantissa == 0) {
+        *text = '0';
+        return (int)(text - start) + 1;
+    }
+
+    DecimalDouble decimal = shortestDecimal(ieeeMantissa, ieeeExponent);
+    int digits = decimalLength(decimal.mantissa);
+    int scientific = decimal.exponent + digits - 1;   // value = d.ddd * 10^scientific
+    char digitText[20];
+    writeDigits(digitText, digits, decimal.mantissa);
+
+    if (scientific >= -5 && scientific <= 16) {
+        if (decimal.exponent >= 0) {
+            // Integer: digits then zeros
+            memcpy(text, digitText, digits);
+            memset(text + digits, '0', decimal.exponent);
+            text += digits + decimal.exponent;
+        } else if (scientific >= 0) {
+            // Point inside the digits
+            int whole = scientific + 1;
+            memcpy(text, digitText, whole);
+            text[whole] = '.';
+            memcpy(text + whole + 1, digitText + whole, digits - whole);
+            text += digits + 1;
+        } else {
+            // 0.000ddd
+            int zeros = -scientific - 1;
+            memcpy(text, "0.", 2);
+            memset(text + 2, '0', zeros);
+            memcpy(text + 2 + zeros, digitText, digits);
+            text += 2 + zeros + digits;
+        }
+        return (int)(text - start);
+    }
+
+    *text++ = digitText[0];
+    if (digits > 1) {
+        *text++ = '.';
+        memcpy(text, digitText + 1, digits - 1);
+        text += digits - 1;
+    }
+    *text++ = 'e';
+    *text++ = scientific < 0 ? '-' : '+';
+    int magnitude = scientific < 0 ? -scientific : scientific;
+    if (magnitude >= 100) {
+        *text++ = (char)('0' + magnitude / 100);
+        magnitude %= 100;
+    }
+    memcpy(text, DIGIT_PAIRS + 2 * magnitude, 2);
+    return (int)(text - start) + 2;
+}
+
+// ========== Buffer ==========
+
+bool outputInit(Output* out, int fd, size_t capacity) {
+    out->fd = fd;
+    // Room for at least one formatted number
+    out->capacity = capacity > 64 ? capacity : (capacity == 0 ? OUTPUT_BUFFER : 64);
+    out->used = 0;
+    out->written = 0;
+    out->failed = false;
+    out->data = malloc(out->capacity);
+    if (out->data == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+// Write all iovecs, continuing after partial writes and interrupts
+static bool writeAll(Output* out, struct iovec* parts, int count) {
+    while (count > 0) {
+        ssize_t written = writev(out->fd, parts, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            out->failed = true;
+            return false;
+        }
+        out->written += (size_t)written;
+        size_t left = (size_t)written;
+        while (count > 0 && left >= parts->iov_len) {
+            left -= parts->iov_len;
+            parts++;
+            count--;
+        }
+        if (count > 0) {
+            parts->iov_base = (char*)parts->iov_base + left;
+            parts->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+bool outputFlush(Output* out) {
+    if (out->used > 0 && !out->failed) {
+        struct iovec part = { out->data, out->used };
+        writeAll(out, &part, 1);
+    }
+    out->used = 0;
+    return !out->failed;
+}
+
+bool outputClose(Output* out) {
+    bool ok = outputFlush(out);
+    free(out->data);
+    out->data = NULL;
+    return ok;
+}
+
+// Make sure `length` bytes fit, flushing if needed
+static inline char* reserve(Output* out, size_t length) {
+    if (out->capacity - out->used < length) {
+        outputFlush(out);
+    }
+    return out->data + out->used;
+}
+
+void outputBytes(Output* out, const void* data, size_t length) {
+    if (length <= out->capacity - out->used) {
+        memcpy(out->data + out->used, data, length);
+        out->used += length;
+        return;
+    }
+    if (length < out->capacity / 2) {
+        outputFlush(out);
+        memcpy(out->data, data, length);
+        out->used = length;
+        return;
+    }
+    // Large block: buffer and block leave in one writev(2), no copy
+    if (!out->failed) {
+        struct iovec parts[2] = { { out->data, out->used }, { (void*)data, length } };
+        writeAll(out, parts, 2);
+    }
+    out->used = 0;
+}
+
+void outputString(Output* out, const char* text) {
+    outputBytes(out, text, strlen(text));
+}
+
+void outputChar(Output* out, char c) {
+    *reserve(out, 1) = c;
+    out->used++;
+}
+
+void outputInt(Output* out, int64_t value) {
+    out->used += formatInt(reserve(out, FORMAT_INT_MAX), value);
+}
+
+void outputUnsigned(Output* out, uint64_t value) {
+    out->used += formatUnsigned(reserve(out, FORMAT_INT_MAX), value);
+}
+
+void outputDouble(Output* out, double value) {
+    out->used += formatDouble(reserve(out, FORMAT_DOUBLE_MAX), value);
+}
+
+// ========== Arrays ==========
+
+// The buffer check runs once per run of values that surely fit, not per value
+#define OUTPUT_ARRAY(out, values, count, separator, maxLength, format)                           \
+    do {                                                                                         \
+        size_t index = 0;                                                                        \
+        while (index < (count)) {                                                                \
+            size_t fit = ((out)->capacity - (out)->used) / ((maxLength) + 1);                   \
+            if (fit == 0) {                                                                      \
+                outputFlush(out);                                                                \
+                continue;                                                                        \
+            }                                                                                    \
+            size_t stop = (count) - index < fit ? (count) : index + fit;                        \
+            char* text = (out)->data + (out)->used;                                              \
+            for (; index < stop; index++) {                                                      \
+                text += format(text, (values)[index]);                                           \
+                *text++ = (separator);                                                           \
+            }                                                                                    \
+            (out)->used = (size_t)(text - (out)->data);                                          \
+        }                                                                                        \
+    } while (0)
+
+void outputInts(Output* out, const int* values, size_t count, char separator) {
+    OUTPUT_ARRAY(out, values, count, separator, FORMAT_INT_MAX, formatInt);
+}
+
+void outputLongs(Output* out, const int64_t* values, size_t count, char separator) {
+    OUTPUT_ARRAY(out, values, count, separator, FORMAT_INT_MAX, formatInt);
+}
+
+void outputDoubles(Output* out, const double* values, size_t count, char separator) {
+    OUTPUT_ARRAY(out, values, count, separator, FORMAT_DOUBLE_MAX, formatDouble);
+}
@@ -0,0 +1,80 @@
+/*
+ * fast_output.h - Buffered Output with Fast Integer and Shortest Double Formatting
+ *
+ * printArray() in the sorting and searching docs, displayList() and
+ * displayQueue() in the data structure docs, and the factorial dump in
+ * "6. array/factorials with array and recursion.c" call printf() once per
+ * element. Each call parses the format string, goes through the locale and
+ * takes the stdout lock; for large arrays that is where the time goes. This
+ * module:
+ *
+ * - collects output in one large user-space buffer (1 MB by default) and
+ *   hands it to the kernel with writev(2); a large block of raw bytes goes
+ *   out in the same system call as the buffer, without being copied into it
+ * - converts integers to decimal two digits at a time from a 200-byte table
+ *   of digit pairs, after computing the digit count without a loop
+ * - formats doubles with the fewest digits that read back to the same
+ *   value (the Ryu algorithm): 0.1 prints as "0.1", not
+ *   "0.10000000000000001" as with "%.17g", and nothing is lost as with "%e"
+ * - writes whole arrays with one call (outputInts, outputDoubles)
+ *
+ * Doubles use "%g"-like notation: plain digits when the decimal exponent is
+ * in [-5, 16], otherwise "1.2345e+20". NaN and infinities print as "nan",
+ * "inf" and "-inf".
+ *
+ * Compile together with fast_output.c:
+ *   gcc -O2 -o program program.c fast_output.c
+ */
+
+#ifndef FAST_OUTPUT_H
+#define FAST_OUTPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OUTPUT_BUFFER (1024 * 1024)
+
+// Longest results of the format functions, without a terminating '\0'
+#define FORMAT_INT_MAX 20      // "-9223372036854775808"
+#define FORMAT_DOUBLE_MAX 24   // "-2.2250738585072014e-308"
+
+typedef struct {
+    int fd;
+    char* data;
+    size_t capacity;
+    size_t used;
+    size_t written;   // bytes handed to the kernel so far
+    bool failed;      // a write failed; later output is dropped
+} Output;
+
+// ========== Setup ==========
+
+// Buffer of `capacity` bytes, or OUTPUT_BUFFER when 0. The descriptor is
+// not closed by outputClose().
+bool outputInit(Output* out, int fd, size_t capacity);
+bool outputFlush(Output* out);     // false if any write has failed
+bool outputClose(Output* out);     // flush and free the buffer
+
+// ========== Formatting into Memory ==========
+
+// Write the decimal text to `text` (no '\0') and return its length
+int formatUnsigned(char* text, uint64_t value);
+int formatInt(char* text, int64_t value);
+int formatDouble(char* text, double value);
+
+// ========== Writing ==========
+
+void outputBytes(Output* out, const void* data, size_t length);
+void outputString(Output* out, const char* text);
+void outputChar(Output* out, char c);
+void outputInt(Output* out, int64_t value);
+void outputUnsigned(Output* out, uint64_t value);
+void outputDouble(Output* out, double value);
+
+// Every value followed by `separator`, e.g. ' ' for printArray or '\n'
+void outputInts(Output* out, const int* values, size_t count, char separator);
+void outputLongs(Output* out, const int64_t* values, size_t count, char separator);
+void outputDoubles(Output* out, const double* values, size_t count, char separator);
+
+#endif
@@ -0,0 +1,408 @@
+/*
+ * Fast Output Demo: Dumping Millions of Numbers
+ *
+ * Prints the printArray() example and the factorial table of
+ * "6. array/factorials with array and recursion.c" through fast_output.h,
+ * checks the integer text against snprintf("%lld") and every double
+ * against strtod() and the shortest "%.*e" that reads back exactly, then
+ * times fprintf() against outputInt() and outputInts()/outputDoubles() when
+ * writing to /dev/null.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o fast_output_demo fast_output_demo.c fast_output.c
+ *   ./fast_output_demo [millions of numbers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fast_output.h"
+
+#define DEMO_FILE "fast_output_demo.txt"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint64_t nextRandom64(unsigned* state) {
+    uint64_t high = nextRandom(state);
+    return high << 32 | nextRandom(state);
+}
+
+static double fact(int n) {
+    return n == 1 ? 1 : n * fact(n - 1);
+}
+
+// ========== Checks ==========
+
+// Significant digits of a number in any of the notations, without leading
+// or trailing zeros, and the decimal exponent of the first digit
+static void significantDigits(const char* text, char* digits, int* exponent) {
+    int count = 0;
+    int pointPosition = -1;
+    int position = 0;
+    int firstDigit = -1;
+    for (const char* c = text; *c != '\0' && *c != 'e'; c++) {
+        if (*c == '.') {
+            pointPosition = position;
+        } else if (*c >= '0' && *c <= '9') {
+            if (firstDigit < 0 && *c != '0') {
+                firstDigit = position;
+            }
+            if (firstDigit >= 0) {
+                digits[count++] = *c;
+            }
+            position++;
+        }
+    }
+    while (count > 1 && digits[count - 1] == '0') {
+        count--;
+    }
+    digits[count] = '\0';
+    if (pointPosition < 0) {
+        pointPosition = position;
+    }
+    const char* e = strchr(text, 'e');
+    *exponent = pointPosition - firstDigit - 1 + (e != NULL ? atoi(e + 1) : 0);
+}
+
+static bool checkDouble(double value) {
+    char text[FORMAT_DOUBLE_MAX + 1];
+    text[formatDouble(text, value)] = '\0';
+    if (strtod(text, NULL) != value) {
+        printf("%.17g printed as %s, which reads back as %.17g\n", value, text, strtod(text, NULL));
+        return false;
+    }
+    // The shortest correctly rounded %e that still reads back. Just above a
+    // power of 2 the interval of values that read back is lopsided, and a
+    // shorter or not nearest result can be right; elsewhere both must agree.
+    char reference[40];
+    for (int precision = 0; precision < 17; precision++) {
+        snprintf(reference, sizeof(reference), "%.*e", precision, value);
+        if (strtod(reference, NULL) == value) {
+            break;
+        }
+    }
+    char digits[24], referenceDigits[24];
+    int exponent, referenceExponent;
+    significantDigits(text, digits, &exponent);
+    significantDigits(reference, referenceDigits, &referenceExponent);
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    bool powerOf2 = (bits & 0xFFFFFFFFFFFFFull) == 0;
+    bool same = strcmp(digits, referenceDigits) == 0 && exponent == referenceExponent;
+    if (!same && !(powerOf2 && strlen(digits) <= strlen(referenceDigits))) {
+        printf("%.17g printed as %s, shortest is %s\n", value, text, reference);
+        return false;
+    }
+    return true;
+}
+
+static bool checkInt(int64_t value) {
+    char text[FORMAT_INT_MAX + 1], reference[32];
+    text[formatInt(text, value)] = '\0';
+    snprintf(reference, sizeof(reference), "%lld", (long long)value);
+    if (strcmp(text, reference) != 0) {
+        printf("%s printed as %s\n", reference, text);
+        return false;
+    }
+    return true;
+}
+
+static double bitsToDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, 8);
+    return value;
+}
+
+// Write numbers through a tiny buffer and a large raw block, then compare
+// the file with the same text built by snprintf()
+static bool checkFile(unsigned* seed) {
+    size_t count = 200000;
+    int* values = malloc(count * sizeof(int));
+    char* expected = malloc(count * 16 + (1 << 20));
+    char* actual = malloc(count * 16 + (1 << 20) + 1);
+    if (values == NULL || expected == NULL || actual == NULL) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(expected);
+        free(actual);
+        return false;
+    }
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (int)nextRandom(seed) >> (nextRandom(seed) % 32);
+        length += (size_t)sprintf(expected + length, "%d ", values[i]);
+    }
+    size_t blockStart = length;
+    for (int i = 0; i < 1 << 20; i++) {
+        expected[length++] = (char)('a' + i % 26);
+    }
+
+    bool ok = false;
+    int fd = open(DEMO_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    Output out;
+    if (fd >= 0 && outputInit(&out, fd, 100)) {
+        outputInts(&out, values, count / 2, ' ');
+        for (size_t i = count / 2; i < count; i++) {
+            outputInt(&out, values[i]);
+            outputChar(&out, ' ');
+        }
+        outputBytes(&out, expected + blockStart, 1 << 20);   // larger than the buffer: writev
+        ok = outputClose(&out) && out.written == length;
+        close(fd);
+        FILE* file = fopen(DEMO_FILE, "rb");
+        if (file != NULL) {
+            ok = ok && fread(actual, 1, length + 1, file) == length &&
+                 memcmp(actual, expected, length) == 0;
+            fclose(file);
+        }
+    }
+    remove(DEMO_FILE);
+    free(values);
+    free(expected);
+    free(actual);
+    return ok;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks ===\n");
+    bool intsOk = true;
+    const int64_t extremes[] = { 0, 1, -1, 9, 10, 99, 100, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN };
+    for (size_t i = 0; i < sizeof(extremes) / sizeof(extremes[0]); i++) {
+        intsOk = intsOk && checkInt(extremes[i]);
+    }
+    for (int digits = 1; digits <= 19; digits++) {
+        int64_t power = 1;
+        for (int k = 1; k < digits; k++) {
+            power *= 10;
+        }
+        intsOk = intsOk && checkInt(power) && checkInt(power - 1) && checkInt(-power);
+    }
+    for (int i = 0; i < 1000000; i++) {
+        intsOk = intsOk && checkInt((int64_t)nextRandom64(seed) >> (nextRandom(seed) % 64));
+    }
+    printf("Integers vs snprintf(\"%%lld\"), 1M random and every length: %s\n",
+           intsOk ? "all match" : "MISMATCH");
+
+    bool doublesOk = true;
+    const double specials[] = { 0.1, 0.2, 0.3, 1.0 / 3, 2.0 / 3, 1e23, 9007199254740993.0, 5e-324,
+                                DBL_MIN, DBL_MAX, 123456.0, 1e16, 1e17, 1e-5, 1e-6, 1.5e-5 };
+    for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+        doublesOk = doublesOk && checkDouble(specials[i]) && checkDouble(-specials[i]);
+    }
+    for (int e = -1074; e <= 1023; e++) {
+        uint64_t bits = e >= -1022 ? (uint64_t)(e + 1023) << 52 : 1ull << (e + 1074);
+        doublesOk = doublesOk && checkDouble(bitsToDouble(bits));
+    }
+    for (int i = 1; i <= 100000; i++) {
+        doublesOk = doublesOk && checkDouble(i) && checkDouble(i / 1000.0);
+    }
+    for (int i = 0; i < 1000000; i++) {
+        uint64_t bits = nextRandom64(seed);
+        if (i % 10 == 0) {
+            bits &= 0x800FFFFFFFFFFFFFull;   // subnormal
+        }
+        double value = bitsToDouble(bits);
+        if (value == value && value - value == 0) {   // skip NaN and infinities
+            doublesOk = doublesOk && checkDouble(value);
+        }
+    }
+    char text[FORMAT_DOUBLE_MAX + 1];
+    text[formatDouble(text, -0.0)] = '\0';
+    doublesOk = doublesOk && strcmp(text, "-0") == 0;
+    printf("Doubles round-trip and are the shortest, 1M random bit patterns, "
+           "all powers of 2: %s\n", doublesOk ? "all match" : "MISMATCH");
+
+    bool fileOk = checkFile(seed);
+    printf("File written through a 100-byte buffer and writev(): %s\n",
+           fileOk ? "all match" : "MISMATCH");
+    return intsOk && doublesOk && fileOk;
+}
+
+// ========== Benchmark ==========
+
+typedef struct {
+    const char* name;
+    size_t (*write)(FILE* file, Output* out, const void* values, size_t count);   // bytes
+} Writer;
+
+static size_t intsFprintf(FILE* file, Output* out, const void* values, size_t count) {
+    (void)out;
+    const int* ints = values;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += (size_t)fprintf(file, "%d\n", ints[i]);
+    }
+    fflush(file);
+    return bytes;
+}
+
+static size_t intsOutputInt(FILE* file, Output* out, const void* values, size_t count) {
+    (void)file;
+    size_t before = out->written;
+    const int* ints = values;
+    for (size_t i = 0; i < count; i++) {
+        outputInt(out, ints[i]);
+        outputChar(out, '\n');
+    }
+    outputFlush(out);
+    return out->written - before;
+}
+
+static size_t intsOutputInts(FILE* file, Output* out, const void* values, size_t count) {
+    (void)file;
+    size_t before = out->written;
+    outputInts(out, values, count, '\n');
+    outputFlush(out);
+    return out->written - before;
+}
+
+static size_t doublesFprintfG17(FILE* file, Output* out, const void* values, size_t count) {
+    (void)out;
+    const double* doubles = values;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += (size_t)fprintf(file, "%.17g\n", doubles[i]);
+    }
+    fflush(file);
+    return bytes;
+}
+
+static size_t doublesFprintfE(FILE* file, Output* out, const void* values, size_t count) {
+    (void)out;
+    const double* doubles = values;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += (size_t)fprintf(file, "%e\n", doubles[i]);
+    }
+    fflush(file);
+    return bytes;
+}
+
+static size_t doublesOutputDoubles(FILE* file, Output* out, const void* values, size_t count) {
+    (void)file;
+    size_t before = out->written;
+    outputDoubles(out, values, count, '\n');
+    outputFlush(out);
+    return out->written - before;
+}
+
+static void timeWriters(const Writer* writers, int writerCount, const void* values, size_t count) {
+    FILE* file = fopen("/dev/null", "w");
+    if (file == NULL) {
+        printf("Cannot open /dev/null\n");
+        return;
+    }
+    Output out;
+    if (!outputInit(&out, fileno(file), 0)) {
+        fclose(file);
+        return;
+    }
+    printf("%-34s %8s %10s %8s\n", "", "seconds", "Mnumbers/s", "MB/s");
+    double baseline = 0;
+    for (int w = 0; w < writerCount; w++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t bytes = writers[w].write(file, &out, values, count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        if (w == 0) {
+            baseline = seconds;
+        }
+        printf("%-34s %8.2f %10.1f %8.0f  %.1fx\n", writers[w].name, seconds,
+               count / seconds / 1e6, bytes / seconds / 1e6, baseline / seconds);
+    }
+    outputClose(&out);
+    fclose(file);
+}
+
+static void benchmark(size_t count, unsigned* seed) {
+    int* ints = malloc(count * sizeof(int));
+    double* doubles = malloc(count * sizeof(double));
+    if (ints == NULL || doubles == NULL) {
+        printf("Memory allocation failed\n");
+        free(ints);
+        free(doubles);
+        return;
+    }
+    const double scales[] = { 0.001, 0.01, 0.1, 1, 10, 100, 1000 };
+    for (size_t i = 0; i < count; i++) {
+        ints[i] = (int)nextRandom(seed) >> (nextRandom(seed) % 24);
+        // Measurements: 0.001 to 1000, full precision
+        doubles[i] = (nextRandom(seed) / 4294967296.0) * scales[nextRandom(seed) % 7];
+    }
+
+    printf("\n=== %zu ints, one per line, to /dev/null ===\n", count);
+    const Writer intWriters[] = {
+        { "fprintf(\"%d\\n\")", intsFprintf },
+        { "outputInt() + outputChar()", intsOutputInt },
+        { "outputInts()", intsOutputInts },
+    };
+    timeWriters(intWriters, 3, ints, count);
+
+    printf("\n=== %zu doubles, one per line, to /dev/null ===\n", count);
+    const Writer doubleWriters[] = {
+        { "fprintf(\"%.17g\\n\") (exact)", doublesFprintfG17 },
+        { "fprintf(\"%e\\n\") (7 digits, lossy)", doublesFprintfE },
+        { "outputDoubles() (shortest, exact)", doublesOutputDoubles },
+    };
+    timeWriters(doubleWriters, 3, doubles, count);
+    free(ints);
+    free(doubles);
+}
+
+int main(int argc, char* argv[]) {
+    long millions = argc > 1 ? atol(argv[1]) : 20;
+    if (millions < 1) {
+        printf("Usage: %s [millions of numbers]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Example: printArray ===\n");
+    int arr[] = { 64, 34, 25, 12, 22, 11, 90, -7 };
+    fflush(stdout);   // keep order with the printf() output
+    Output out;
+    if (!outputInit(&out, STDOUT_FILENO, 0)) {
+        return 1;
+    }
+    outputString(&out, "Sorted array: ");
+    outputInts(&out, arr, 8, ' ');
+    outputChar(&out, '\n');
+
+    outputString(&out, "\n=== Example: factorial table, %e vs shortest ===\n");
+    for (int i = 1; i <= 25; i += 6) {
+        char lossy[32];
+        snprintf(lossy, sizeof(lossy), "%e", fact(i));
+        outputString(&out, "factorial[");
+        outputInt(&out, i);
+        outputString(&out, "] = ");
+        outputString(&out, lossy);
+        outputString(&out, "  ->  ");
+        outputDouble(&out, fact(i));
+        outputChar(&out, '\n');
+    }
+    outputString(&out, "0.1 + 0.2 = ");
+    outputDouble(&out, 0.1 + 0.2);
+    outputChar(&out, '\n');
+    outputClose(&out);
+
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+    benchmark((size_t)millions * 1000000, &seed);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+/*
+ * line_reader.c - Buffered Zero-Copy Line and Record Reader (see line_reader.h)
+ */
+
+#include "line_reader.h"
+#include "../dispatch/cpu_dispatch.h"
+#include "../profiling/instrument.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <immintrin.h>
+
+// ========== Delimiter Masks ==========
+
+// Bit i set when block[i] == delimiter, for 64 bytes
+typedef uint64_t (*DelimiterMaskFunction)(const char* block, char delimiter);
+
+// SWAR: a byte of x is zero exactly when adding 0x7F to its low 7 bits and
+// OR-ing in the byte itself leaves bit 7 clear
+static uint64_t delimiterMaskScalar(const char* block, char delimiter) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+    const uint64_t spread = 0x0101010101010101ull * (uint8_t)delimiter;
+    uint64_t mask = 0;
+    for (int w = 0; w < 8; w++) {
+        uint64_t word;
+        memcpy(&word, block + 8 * w, 8);
+        uint64_t x = word ^ spread;
+        uint64_t zero = ~(((x & low7) + low7) | x | low7);   // 0x80 in each matching byte
+        // Gather bit 7 of each byte into 8 adjacent bits
+        mask |= (((zero >> 7) * 0x0102040810204080ull) >> 56) << (8 * w);
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t delimiterMaskAvx2(const char* block, char delimiter) {
+    const __m256i spread = _mm256_set1_epi8(delimiter);
+    __m256i low = _mm256_loadu_si256((const __m256i*)block);
+    __m256i high = _mm256_loadu_si256((const __m256i*)(block + 32));
+    uint32_t lowMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, spread));
+    uint32_t highMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, spread));
+    return (uint64_t)highMask << 32 | lowMask;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t delimiterMaskAvx512(const char* block, char delimiter) {
+    return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(block), _mm512_set1_epi8(delimiter));
+}
+
+DISPATCH_KERNEL(DelimiterMaskFunction, delimiterMask,
+    DISPATCH_VARIANT(delimiterMaskAvx512, CPU_AVX512F | CPU_AVX512BW),
+    DISPATCH_VARIANT(delimiterMaskAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(delimiterMaskScalar, 0))
+
+// First delimiter in [from, to), or NULL. The mask of the current block is
+// kept, so short lines cost a tzcnt each instead of a new scan; the last
+// bytes before `to` (less than a block) go through memchr().
+static const char* findDelimiter(LineReader* reader, const char* from, const char* to) {
+    const char* block = reader->maskBlock;
+    uint64_t mask = reader->mask;
+    if (block == NULL || from < block || from >= block + 64) {
+        if (to - from < 64) {
+            reader->maskBlock = NULL;
+            return memchr(from, reader->delimiter, (size_t)(to - from));
+        }
+        block = from;
+        mask = delimiterMask(block, reader->delimiter);
+    }
+    for (;;) {
+        uint64_t rest = mask & (~0ULL << (from - block));
+        if (rest != 0) {
+            reader->maskBlock = block;
+            reader->mask = mask;
+            return block + __builtin_ctzll(rest);
+        }
+        block += 64;
+        from = block;
+        if (to - block < 64) {
+            break;
+        }
+        mask = delimiterMask(block, reader->delimiter);
+    }
+    reader->maskBlock = NULL;
+    return memchr(from, reader->delimiter, (size_t)(to - from));
+}
+
+// ========== Opening and Closing ==========
+
+bool lineReaderOpenFd(LineReader* reader, int fd, size_t bufferSize) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = fd;
+    reader->delimiter = '\n';
+    reader->capacity = bufferSize > 0 ? bufferSize : LINE_READER_BUFFER;
+    reader->buffer = malloc(reader->capacity);
+    if (reader->buffer == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+bool lineReaderOpen(LineReader* reader, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);   // the mapping stays valid
+            madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+            memset(reader, 0, sizeof(*reader));
+            reader->fd = -1;
+            reader->delimiter = '\n';
+            reader->mapped = data;
+            reader->mappedSize = (size_t)info.st_size;
+            return true;
+        }
+    }
+    // Empty files, pipes and anything mmap refuses
+    if (!lineReaderOpenFd(reader, fd, 0)) {
+        close(fd);
+        return false;
+    }
+    reader->ownsFd = true;
+    return true;
+}
+
+void lineReaderClose(LineReader* reader) {
+    if (reader->mapped != NULL) {
+        munmap((void*)reader->mapped, reader->mappedSize);
+    }
+    if (reader->ownsFd) {
+        close(reader->fd);
+    }
+    free(reader->buffer);
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+// ========== Reading ==========
+
+static int nextMapped(LineReader* reader, LineView* line) {
+    if (reader->start >= reader->mappedSize) {
+        return 0;
+    }
+    const char* from = reader->mapped + reader->start;
+    const char* to = reader->mapped + reader->mappedSize;
+    const char* found = findDelimiter(reader, from, to);
+    const char* lineEnd = found != NULL ? found : to;
+    line->data = from;
+    line->length = (size_t)(lineEnd - from);
+    reader->start = (size_t)(lineEnd - reader->mapped) + (found != NULL);
+    reader->lineNumber++;
+    return 1;
+}
+
+// Make room at the end of the buffer: move the partial line to the front,
+// and double the buffer only when the line fills most of it. Keeping a
+// quarter free means every read(2) asks for a large block.
+static bool makeRoom(LineReader* reader) {
+    size_t unread = reader->end - reader->start;
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, unread);
+        reader->start = 0;
+        reader->end = unread;
+    }
+    if (reader->capacity - reader->end <= reader->capacity / 4) {
+        char* grown = realloc(reader->buffer, reader->capacity * 2);
+        if (grown == NULL) {
+            printf("Memory allocation failed\n");
+            return false;
+        }
+        reader->buffer = grown;
+        reader->capacity *= 2;
+        reader->grows++;
+    }
+    reader->maskBlock = NULL;   // the bytes have moved
+    return true;
+}
+
+int lineReaderNext(LineReader* reader, LineView* line) {
+    if (reader->mapped != NULL) {
+        return nextMapped(reader, line);
+    }
+    for (;;) {
+        const char* from = reader->buffer + reader->start;
+        const char* to = reader->buffer + reader->end;
+        const char* found = findDelimiter(reader, from + reader->scanned, to);
+        if (found != NULL) {
+            line->data = from;
+            line->length = (size_t)(found - from);
+            reader->start = (size_t)(found - reader->buffer) + 1;
+            reader->scanned = 0;
+            reader->lineNumber++;
+            return 1;
+        }
+        reader->scanned = reader->end - reader->start;
+        if (reader->endOfInput) {
+            if (reader->start == reader->end) {
+                return 0;
+            }
+            // Last line without a delimiter
+            line->data = from;
+            line->length = reader->end - reader->start;
+            reader->start = reader->end;
+            reader->scanned = 0;
+            reader->lineNumber++;
+            return 1;
+        }
+        if (reader->capacity - reader->end <= reader->capacity / 4 && !makeRoom(reader)) {
+            return -1;
+        }
+        PROFILE_SCOPE("lineReader.read");
+        ssize_t got = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Read error: %s\n", strerror(errno));
+            return -1;
+        }
+        if (got == 0) {
+            reader->endOfInput = true;
+        }
+        reader->end += (size_t)got;
+    }
+}
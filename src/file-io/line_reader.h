@@ -0,0 +1,86 @@
+/*
+ * line_reader.h - Buffered Zero-Copy Line and Record Reader
+ *
+ * The input examples in this repo read lines with gets(text)
+ * (src/strings/gets.c), scanf("%[^\n]*%c", ...) (src/strings/scanset.c,
+ * strrev.c) and fgets(line, 256, file) (docs/09-file-io/01-file-handling.md).
+ * gets() and the scanset have no length limit and overflow the array;
+ * fgets() splits every line longer than its buffer, and all of them copy
+ * each line out of the stdio buffer. This module:
+ *
+ * - returns each line as a LineView (pointer + length) into its own buffer,
+ *   with no copy and no limit on the line length
+ * - reads a large buffer at a time with read(2) (stdin, pipes, sockets,
+ *   files) or maps a whole file with mmap(2)
+ * - grows the buffer only when a single line does not fit, and keeps a
+ *   partial line by moving just that line to the front before refilling
+ * - finds delimiters 64 bytes at a time with AVX-512BW, AVX2 or 8-byte
+ *   SWAR masks (see ../dispatch/cpu_dispatch.h); one mask serves every
+ *   line that ends in the same 64-byte block
+ *
+ * Views do not include the delimiter and are not NUL-terminated (print them
+ * with "%.*s"). In read mode a view is valid until the next call; in mmap
+ * mode until lineReaderClose(). The last line may lack a delimiter. '\r'
+ * before '\n' is kept. Set `delimiter` after opening to read other records,
+ * e.g. '\0' for `find -print0` output.
+ *
+ * Compile together with line_reader.c:
+ *   gcc -O2 -o program program.c line_reader.c ../dispatch/cpu_dispatch.c
+ *
+ * With -DINSTRUMENT and ../profiling/instrument.c, every read(2) is timed
+ * (see ../profiling/instrument.h).
+ */
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LINE_READER_BUFFER (256 * 1024)   // default read(2) buffer
+
+typedef struct {
+    const char* data;
+    size_t length;
+} LineView;
+
+typedef struct {
+    int fd;
+    bool ownsFd;
+    char delimiter;
+
+    // Read mode: unread bytes are buffer[start .. end)
+    char* buffer;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    size_t scanned;         // bytes after start already known to hold no delimiter
+    bool endOfInput;
+
+    // mmap mode: the whole file, next line at mapped[start]
+    const char* mapped;
+    size_t mappedSize;
+
+    // Delimiter bits of the 64-byte block at maskBlock (NULL = none)
+    const char* maskBlock;
+    uint64_t mask;
+
+    size_t lineNumber;      // lines returned so far
+    size_t grows;           // times a long line made the buffer grow
+} LineReader;
+
+// Map a regular file; falls back to read(2) for pipes, FIFOs and devices
+bool lineReaderOpen(LineReader* reader, const char* path);
+
+// Read from an open descriptor (0 for stdin) with a buffer of bufferSize
+// bytes, or LINE_READER_BUFFER when 0. The descriptor is not closed.
+bool lineReaderOpenFd(LineReader* reader, int fd, size_t bufferSize);
+
+void lineReaderClose(LineReader* reader);
+
+// 1 with the next line in *line, 0 at the end of the input, -1 on a read
+// or allocation error
+int lineReaderNext(LineReader* reader, LineView* line);
+
+#endif
@@ -0,0 +1,400 @@
+/*
+ * Line Reader Demo: Zero-Copy Lines from Files, Pipes and stdin
+ *
+ * Reads a generated file with fgets(line, 256) as in
+ * docs/09-file-io/01-file-handling.md, with getline() and with
+ * line_reader.h (read(2) and mmap modes). Checks the reader against a
+ * simple split for awkward inputs (empty lines, lines of 63/64/65 bytes, a
+ * 1 MB line, no final newline, '\0' inside lines) with tiny buffers, a pipe
+ * fed in random pieces and every delimiter kernel, then times all of them.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o line_reader_demo line_reader_demo.c line_reader.c ../dispatch/cpu_dispatch.c
+ *   ./line_reader_demo [megabytes]        (writes and removes line_reader_demo.txt)
+ *   cat big.log | ./line_reader_demo -    (count lines on stdin)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "line_reader.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#define DEMO_FILE "line_reader_demo.txt"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Lines and bytes seen, plus a checksum over line lengths and first bytes
+typedef struct {
+    size_t lines;
+    size_t bytes;
+    size_t longest;
+    uint64_t checksum;
+} LineStats;
+
+static void addLine(LineStats* stats, const char* data, size_t length) {
+    stats->lines++;
+    stats->bytes += length;
+    if (length > stats->longest) {
+        stats->longest = length;
+    }
+    stats->checksum = stats->checksum * 31 + length + (length > 0 ? (unsigned char)data[0] : 0);
+}
+
+static bool sameStats(LineStats a, LineStats b) {
+    return a.lines == b.lines && a.bytes == b.bytes && a.checksum == b.checksum;
+}
+
+static bool writeFile(const char* path, const char* data, size_t length) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(data, 1, length, file) == length;
+    fclose(file);
+    return ok;
+}
+
+// ========== Reference and stdio Versions ==========
+
+// Split with memchr(): the lines the reader should return
+static LineStats splitLines(const char* data, size_t length, char delimiter) {
+    LineStats stats = { 0, 0, 0, 0 };
+    size_t position = 0;
+    while (position < length) {
+        const char* found = memchr(data + position, delimiter, length - position);
+        size_t end = found != NULL ? (size_t)(found - data) : length;
+        addLine(&stats, data + position, end - position);
+        position = end + 1;
+    }
+    return stats;
+}
+
+// The docs loop: longer lines come back in 255-byte pieces
+static LineStats readFgets(const char* path) {
+    LineStats stats = { 0, 0, 0, 0 };
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return stats;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\n') {
+            length--;
+        }
+        addLine(&stats, line, length);
+    }
+    fclose(file);
+    return stats;
+}
+
+static LineStats readGetline(const char* path) {
+    LineStats stats = { 0, 0, 0, 0 };
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return stats;
+    }
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, file)) >= 0) {
+        if (length > 0 && line[length - 1] == '\n') {
+            length--;
+        }
+        addLine(&stats, line, (size_t)length);
+    }
+    free(line);
+    fclose(file);
+    return stats;
+}
+
+static LineStats readAll(LineReader* reader) {
+    LineStats stats = { 0, 0, 0, 0 };
+    LineView line;
+    while (lineReaderNext(reader, &line) == 1) {
+        addLine(&stats, line.data, line.length);
+    }
+    return stats;
+}
+
+// bufferSize 0 = mmap through lineReaderOpen()
+static LineStats readWithReader(const char* path, size_t bufferSize, char delimiter) {
+    LineStats stats = { 0, 0, 0, 0 };
+    LineReader reader;
+    if (bufferSize == 0) {
+        if (!lineReaderOpen(&reader, path)) {
+            return stats;
+        }
+    } else {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0 || !lineReaderOpenFd(&reader, fd, bufferSize)) {
+            printf("Cannot open %s\n", path);
+            return stats;
+        }
+        reader.ownsFd = true;
+    }
+    reader.delimiter = delimiter;
+    stats = readAll(&reader);
+    lineReaderClose(&reader);
+    return stats;
+}
+
+// A child process writes the data into a pipe in random pieces
+static LineStats readFromPipe(const char* data, size_t length, size_t bufferSize, unsigned seed) {
+    LineStats stats = { 0, 0, 0, 0 };
+    int ends[2];
+    if (pipe(ends) != 0) {
+        printf("Cannot create pipe\n");
+        return stats;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        close(ends[0]);
+        size_t position = 0;
+        while (position < length) {
+            size_t piece = 1 + nextRandom(&seed) % 5000;
+            if (piece > length - position) {
+                piece = length - position;
+            }
+            ssize_t written = write(ends[1], data + position, piece);
+            if (written <= 0) {
+                _exit(1);
+            }
+            position += (size_t)written;
+        }
+        _exit(0);
+    }
+    close(ends[1]);
+    LineReader reader;
+    if (lineReaderOpenFd(&reader, ends[0], bufferSize)) {
+        stats = readAll(&reader);
+        lineReaderClose(&reader);
+    }
+    close(ends[0]);
+    waitpid(child, NULL, 0);
+    return stats;
+}
+
+// ========== Checks ==========
+
+static size_t makeAwkwardInput(char* data, unsigned* seed) {
+    size_t used = 0;
+    const size_t lengths[] = { 0, 0, 1, 63, 64, 65, 127, 128, 129, 255, 256, 257, 4095, 1 << 20 };
+    for (int round = 0; round < 3; round++) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            for (size_t k = 0; k < lengths[i]; k++) {
+                unsigned r = nextRandom(seed) % 100;
+                data[used++] = r == 0 ? '\0' : r == 1 ? '\r' : (char)('a' + r % 26);
+            }
+            data[used++] = '\n';
+        }
+        for (int line = 0; line < 2000; line++) {
+            size_t length = nextRandom(seed) % 90;
+            for (size_t k = 0; k < length; k++) {
+                data[used++] = (char)('a' + nextRandom(seed) % 26);
+            }
+            data[used++] = line % 7 == 0 ? '\0' : '\n';
+        }
+    }
+    memcpy(data + used, "no newline at the end", 21);
+    return used + 21;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against a memchr() Split ===\n");
+    char* data = malloc(4 << 20);
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    size_t length = makeAwkwardInput(data, seed);
+    if (!writeFile(DEMO_FILE, data, length)) {
+        free(data);
+        return false;
+    }
+
+    bool ok = true;
+    const DispatchKernel* kernel = dispatchFind("delimiterMask");
+    const size_t bufferSizes[] = { 0, 1, 7, 64, 4096, LINE_READER_BUFFER };
+    for (int v = 0; v < kernel->variantCount; v++) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        for (char delimiter = '\0'; delimiter <= '\n'; delimiter += '\n') {
+            LineStats expected = splitLines(data, length, delimiter);
+            for (size_t b = 0; b < sizeof(bufferSizes) / sizeof(bufferSizes[0]); b++) {
+                ok = ok && sameStats(readWithReader(DEMO_FILE, bufferSizes[b], delimiter), expected);
+            }
+        }
+        LineStats expected = splitLines(data, length, '\n');
+        ok = ok && sameStats(readFromPipe(data, length, 100, *seed), expected);
+        ok = ok && sameStats(readFromPipe(data, length, 0, *seed), expected);
+    }
+    dispatchRestore(kernel);
+
+    // The empty file: no lines at all
+    writeFile(DEMO_FILE, "", 0);
+    ok = ok && readWithReader(DEMO_FILE, 0, '\n').lines == 0;
+    printf("%zu bytes, mmap/read/pipe, buffers of 1 byte to 256 KB, every kernel: %s\n",
+           length, ok ? "all match" : "MISMATCH");
+    free(data);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static size_t makeLog(char* data, size_t size, unsigned* seed) {
+    static const char* words[] = { "GET", "POST", "/api/v1/items", "200", "404", "user=alice",
+                                   "latency_ms=12", "cache=miss", "region=eu-west-1", "ok" };
+    size_t used = 0;
+    while (used + 200000 < size) {
+        if (nextRandom(seed) % 20000 == 0) {
+            // A rare huge line, such as a JSON blob: fgets(256) cuts it apart
+            size_t length = 20000 + nextRandom(seed) % 100000;
+            memset(data + used, 'x', length);
+            used += length;
+        } else {
+            int wordCount = 2 + nextRandom(seed) % 14;
+            for (int w = 0; w < wordCount; w++) {
+                const char* word = words[nextRandom(seed) % 10];
+                size_t n = strlen(word);
+                memcpy(data + used, word, n);
+                used += n;
+                data[used++] = ' ';
+            }
+        }
+        data[used++] = '\n';
+    }
+    return used;
+}
+
+typedef LineStats (*ReadFunction)(const char* path);
+
+static LineStats readReaderRead(const char* path) {
+    return readWithReader(path, LINE_READER_BUFFER, '\n');
+}
+
+static LineStats readReaderMmap(const char* path) {
+    return readWithReader(path, 0, '\n');
+}
+
+static void timeRead(const char* name, ReadFunction function, size_t bytes, LineStats expected) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LineStats stats = function(DEMO_FILE);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsedSeconds(start, end);
+    printf("%-30s %8.2f %8.1f %10zu  %s\n", name, bytes / seconds / 1e9,
+           stats.lines / seconds / 1e6, stats.lines,
+           sameStats(stats, expected) ? "ok" : "lines split or different");
+}
+
+static void benchmark(size_t megabytes, unsigned* seed) {
+    size_t size = megabytes << 20;
+    char* data = malloc(size);
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    size_t length = makeLog(data, size, seed);
+    if (!writeFile(DEMO_FILE, data, length)) {
+        free(data);
+        return;
+    }
+    LineStats expected = splitLines(data, length, '\n');
+    free(data);
+    readGetline(DEMO_FILE);   // warm the page cache
+
+    printf("\n=== Reading a %.0f MB file, %zu lines, longest %zu bytes ===\n",
+           length / 1048576.0, expected.lines, expected.longest);
+    printf("%-30s %8s %8s %10s\n", "", "GB/s", "Mlines/s", "lines");
+    timeRead("fgets(line, 256) (docs)", readFgets, length, expected);
+    timeRead("getline()", readGetline, length, expected);
+    timeRead("lineReader, read(2) 256 KB", readReaderRead, length, expected);
+
+    const DispatchKernel* kernel = dispatchFind("delimiterMask");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        const DispatchVariant* variant = &kernel->variants[v];
+        char name[64];
+        snprintf(name, sizeof(name), "lineReader, mmap, %s", variant->name + strlen("delimiterMask"));
+        if (!dispatchUseVariant(kernel, v)) {
+            printf("%-30s %8s\n", name, "skipped");
+            continue;
+        }
+        timeRead(name, readReaderMmap, length, expected);
+    }
+    dispatchRestore(kernel);
+}
+
+// Count the lines on stdin (a pipe, a file or the terminal)
+static int countStdin(void) {
+    LineReader reader;
+    if (!lineReaderOpenFd(&reader, STDIN_FILENO, 0)) {
+        return 1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LineStats stats = { 0, 0, 0, 0 };
+    LineView line;
+    int status;
+    while ((status = lineReaderNext(&reader, &line)) == 1) {
+        addLine(&stats, line.data, line.length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsedSeconds(start, end);
+    printf("%zu lines, %zu bytes, longest %zu, buffer grew %zu times, %.2f GB/s\n", stats.lines,
+           stats.bytes, stats.longest, reader.grows, (stats.bytes + stats.lines) / seconds / 1e9);
+    lineReaderClose(&reader);
+    return status < 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "-") == 0) {
+        return countStdin();
+    }
+    long megabytes = argc > 1 ? atol(argv[1]) : 256;
+    if (megabytes < 1) {
+        printf("Usage: %s [megabytes]   or   %s - < input\n", argv[0], argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Example ===\n");
+    const char* text = "first line\n\nthird line, after an empty one\nlast line without newline";
+    writeFile(DEMO_FILE, text, strlen(text));
+    LineReader reader;
+    if (lineReaderOpen(&reader, DEMO_FILE)) {
+        LineView line;
+        while (lineReaderNext(&reader, &line) == 1) {
+            printf("Line %zu: %.*s\n", reader.lineNumber, (int)line.length, line.data);
+        }
+        lineReaderClose(&reader);
+    }
+
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+    benchmark((size_t)megabytes, &seed);
+    remove(DEMO_FILE);
+    return ok ? 0 : 1;
+}
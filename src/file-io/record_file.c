@@ -0,0 +1,540 @@
+/*
+ * record_file.c - Memory-Mapped Binary Record File with a Key Index (see record_file.h)
+ */
+
+#define _GNU_SOURCE
+#include "record_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FILE_MAGIC "CRECFILE"
+#define FOOTER_MAGIC "CRECFOOT"
+#define BYTE_ORDER_MARK 0x01020304u   // reads back as 0x04030201 on the other byte order
+#define SLOT_OFFSET(slot) (512 * ((slot) + 1))   // 512 and 1024: different disk sectors
+
+// ========== On-Disk Layout ==========
+//
+//   page 0:  FileHeader at 0, FileSlot 0 at 512, FileSlot 1 at 1024
+//   then per append, starting on a page boundary:
+//            records | keys[n] | offsets[n] | extents[] | FileFooter
+//
+// A slot names the footer of one append; the valid slot with the highest
+// generation is the current state of the file.
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t recordSize;
+    uint32_t keyOffset;
+    uint32_t keySize;
+    uint32_t pageSize;
+} FileHeader;
+
+typedef struct {
+    uint64_t generation;     // 0 = never written
+    uint64_t footerOffset;
+    uint64_t fileSize;
+    uint64_t checksum;       // of the three fields above
+} FileSlot;
+
+typedef struct {
+    char magic[8];
+    uint64_t generation;
+    uint64_t recordCount;
+    uint64_t extentCount;
+    uint64_t extentsOffset;
+    uint64_t keysOffset;
+    uint64_t offsetsOffset;
+    uint64_t checksum;       // of the fields above and the extents
+} FileFooter;
+
+// FNV-1a over 64 bits, continuing from `hash`
+static uint64_t checksumBytes(uint64_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+#define CHECKSUM_START 14695981039346656037ull
+
+static uint64_t slotChecksum(const FileSlot* slot) {
+    return checksumBytes(CHECKSUM_START, slot, offsetof(FileSlot, checksum));
+}
+
+static uint64_t footerChecksum(const FileFooter* footer, const RecordExtent* extents) {
+    uint64_t hash = checksumBytes(CHECKSUM_START, footer, offsetof(FileFooter, checksum));
+    return checksumBytes(hash, extents, footer->extentCount * sizeof(RecordExtent));
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// pwrite until everything is written: it may write less than asked
+static bool writeAt(int fd, const void* data, size_t length, uint64_t offset) {
+    const uint8_t* bytes = data;
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Write failed\n");
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+    return true;
+}
+
+// Writes keys, offsets, extents and a footer from `position` (records end
+// there) and fills in `slot`; nothing is flushed
+static bool writeIndex(int fd, uint64_t position, uint64_t generation, const int64_t* keys,
+                       const uint64_t* offsets, uint64_t count, const RecordExtent* extents,
+                       uint64_t extentCount, FileSlot* slot) {
+    FileFooter footer;
+    memcpy(footer.magic, FOOTER_MAGIC, 8);
+    footer.generation = generation;
+    footer.recordCount = count;
+    footer.extentCount = extentCount;
+    footer.keysOffset = alignUp(position, 64);
+    footer.offsetsOffset = footer.keysOffset + count * sizeof(int64_t);
+    footer.extentsOffset = footer.offsetsOffset + count * sizeof(uint64_t);
+    uint64_t footerOffset = footer.extentsOffset + extentCount * sizeof(RecordExtent);
+    footer.checksum = footerChecksum(&footer, extents);
+    if (!writeAt(fd, keys, count * sizeof(int64_t), footer.keysOffset) ||
+        !writeAt(fd, offsets, count * sizeof(uint64_t), footer.offsetsOffset) ||
+        !writeAt(fd, extents, extentCount * sizeof(RecordExtent), footer.extentsOffset) ||
+        !writeAt(fd, &footer, sizeof(footer), footerOffset)) {
+        return false;
+    }
+    slot->generation = generation;
+    slot->footerOffset = footerOffset;
+    slot->fileSize = footerOffset + sizeof(footer);
+    slot->checksum = slotChecksum(slot);
+    return true;
+}
+
+// ========== Creating and Opening ==========
+
+// Written under a temporary name and renamed, so `path` is either the old
+// file or a complete new one
+bool recordFileCreate(const char* path, uint32_t recordSize, uint32_t keyOffset, uint32_t keySize) {
+    if (recordSize == 0 || (keySize != 4 && keySize != 8) || keyOffset + keySize > recordSize) {
+        printf("Invalid record layout\n");
+        return false;
+    }
+    size_t length = strlen(path);
+    char* temporary = malloc(length + 5);
+    if (temporary == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", 5);
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Cannot create %s\n", temporary);
+        free(temporary);
+        return false;
+    }
+
+    uint8_t page[RECORD_FILE_PAGE] = { 0 };
+    FileHeader header = { .version = RECORD_FILE_VERSION, .byteOrder = BYTE_ORDER_MARK,
+                          .recordSize = recordSize, .keyOffset = keyOffset, .keySize = keySize,
+                          .pageSize = RECORD_FILE_PAGE };
+    memcpy(header.magic, FILE_MAGIC, 8);
+    memcpy(page, &header, sizeof(header));
+    FileSlot slot;
+    bool ok = writeIndex(fd, RECORD_FILE_PAGE, 1, NULL, NULL, 0, NULL, 0, &slot);
+    memcpy(page + SLOT_OFFSET(0), &slot, sizeof(slot));
+    ok = ok && writeAt(fd, page, sizeof(page), 0) && fdatasync(fd) == 0;
+    close(fd);
+    if (ok && rename(temporary, path) != 0) {
+        printf("Cannot rename %s to %s\n", temporary, path);
+        ok = false;
+    }
+    if (!ok) {
+        remove(temporary);
+    }
+    free(temporary);
+    return ok;
+}
+
+// Whether [start, end) holds exactly `count` items of `size` bytes. Written
+// with subtraction and division so that no value read from the file can
+// wrap a sum past the checks.
+static bool spansExactly(uint64_t start, uint64_t end, uint64_t count, uint64_t size) {
+    return start <= end && (end - start) % size == 0 && (end - start) / size == count;
+}
+
+// The footer a slot names, if the slot and the footer are both intact and
+// everything they point at lies inside the mapping. The checksums only catch
+// torn writes, not deliberate edits, so every offset and count is bounded
+// here before anything is read through it.
+static const FileFooter* validFooter(const RecordFile* file, const FileSlot* slot) {
+    if (slot->generation == 0 || slot->checksum != slotChecksum(slot) ||
+        slot->fileSize > file->mapSize || slot->fileSize < RECORD_FILE_PAGE + sizeof(FileFooter) ||
+        slot->footerOffset != slot->fileSize - sizeof(FileFooter) || slot->footerOffset % 8 != 0) {
+        return NULL;
+    }
+    const FileFooter* footer = (const FileFooter*)(file->map + slot->footerOffset);
+    uint64_t count = footer->recordCount;
+    if (memcmp(footer->magic, FOOTER_MAGIC, 8) != 0 || footer->generation != slot->generation ||
+        !spansExactly(footer->extentsOffset, slot->footerOffset, footer->extentCount, sizeof(RecordExtent)) ||
+        !spansExactly(footer->offsetsOffset, footer->extentsOffset, count, sizeof(uint64_t)) ||
+        !spansExactly(footer->keysOffset, footer->offsetsOffset, count, sizeof(int64_t)) ||
+        footer->keysOffset < RECORD_FILE_PAGE || footer->keysOffset % 8 != 0) {
+        return NULL;
+    }
+    const RecordExtent* extents = (const RecordExtent*)(file->map + footer->extentsOffset);
+    if (footer->checksum != footerChecksum(footer, extents)) {
+        return NULL;
+    }
+    // Extents number the records 0 .. count-1 in order and lie between the
+    // header page and the index
+    uint64_t first = 0;
+    for (uint64_t e = 0; e < footer->extentCount; e++) {
+        const RecordExtent* extent = &extents[e];
+        if (extent->first != first || extent->count > count - first ||
+            extent->offset < RECORD_FILE_PAGE || extent->offset > footer->keysOffset ||
+            extent->count > (footer->keysOffset - extent->offset) / file->recordSize) {
+            return NULL;
+        }
+        first += extent->count;
+    }
+    if (first != count) {
+        return NULL;
+    }
+    return footer;
+}
+
+// Maps the file and makes the newest intact footer current
+static bool loadState(RecordFile* file) {
+    struct stat info;
+    if (fstat(file->fd, &info) != 0 || (uint64_t)info.st_size < RECORD_FILE_PAGE) {
+        printf("Not a record file\n");
+        return false;
+    }
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (map == MAP_FAILED) {
+        printf("Cannot map the record file\n");
+        return false;
+    }
+    file->map = map;
+    file->mapSize = (size_t)info.st_size;
+
+    const FileFooter* footer = NULL;
+    for (int s = 0; s < 2; s++) {
+        const FileSlot* slot = (const FileSlot*)(file->map + SLOT_OFFSET(s));
+        const FileFooter* candidate = validFooter(file, slot);
+        if (candidate != NULL && (footer == NULL || slot->generation > file->generation)) {
+            footer = candidate;
+            file->slot = s;
+            file->generation = slot->generation;
+            file->fileSize = slot->fileSize;
+        }
+    }
+    if (footer == NULL) {
+        printf("No intact footer in the record file\n");
+        return false;
+    }
+    file->recordCount = footer->recordCount;
+    file->extentCount = footer->extentCount;
+    file->extents = (const RecordExtent*)(file->map + footer->extentsOffset);
+    file->keys = (const int64_t*)(file->map + footer->keysOffset);
+    file->offsets = (const uint64_t*)(file->map + footer->offsetsOffset);
+    return true;
+}
+
+bool recordFileOpen(RecordFile* file, const char* path, uint32_t recordSize, bool writable) {
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+    if (recordSize == 0) {
+        printf("Invalid record size\n");
+        return false;
+    }
+    // Extents are bounded using the caller's record size; the header must
+    // agree with it below
+    file->recordSize = recordSize;
+    file->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (file->fd < 0) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    file->writable = writable;
+    if (!loadState(file)) {
+        recordFileClose(file);
+        return false;
+    }
+    const FileHeader* header = (const FileHeader*)file->map;
+    if (memcmp(header->magic, FILE_MAGIC, 8) != 0 || header->version != RECORD_FILE_VERSION ||
+        header->byteOrder != BYTE_ORDER_MARK || header->pageSize != RECORD_FILE_PAGE ||
+        (header->keySize != 4 && header->keySize != 8) || header->keyOffset > header->recordSize ||
+        header->keySize > header->recordSize - header->keyOffset) {
+        printf("%s is not a version %d record file of this byte order\n", path, RECORD_FILE_VERSION);
+        recordFileClose(file);
+        return false;
+    }
+    if (header->recordSize != recordSize) {
+        printf("%s holds %u-byte records, not %u\n", path, header->recordSize, recordSize);
+        recordFileClose(file);
+        return false;
+    }
+    file->recordSize = header->recordSize;
+    file->keyOffset = header->keyOffset;
+    file->keySize = header->keySize;
+    return true;
+}
+
+void recordFileClose(RecordFile* file) {
+    if (file->map != NULL) {
+        munmap((void*)file->map, file->mapSize);
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+    }
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+}
+
+// ========== Lookup ==========
+
+const void* recordFileGet(const RecordFile* file, uint64_t index) {
+    if (index >= file->recordCount) {
+        return NULL;
+    }
+    // Last extent starting at or before `index`
+    uint64_t low = 0, high = file->extentCount - 1;
+    while (low < high) {
+        uint64_t middle = (low + high + 1) / 2;
+        if (file->extents[middle].first <= index) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    const RecordExtent* extent = &file->extents[low];
+    return file->map + extent->offset + (index - extent->first) * file->recordSize;
+}
+
+// Branch-free lower bound: the loop runs log2(n) times whatever the key,
+// and the compiler turns the step into a conditional move
+const void* recordFileFind(const RecordFile* file, int64_t key) {
+    const int64_t* base = file->keys;
+    uint64_t length = file->recordCount;
+    if (length == 0) {
+        return NULL;
+    }
+    while (length > 1) {
+        uint64_t half = length / 2;
+        base = base[half - 1] < key ? base + half : base;
+        length -= half;
+    }
+    if (*base != key) {
+        return NULL;
+    }
+    // Offsets are not checked on open (that would read the whole index), so
+    // each one is bounded when it is used
+    uint64_t offset = file->offsets[base - file->keys];
+    if (offset < RECORD_FILE_PAGE || offset > file->fileSize - file->recordSize) {
+        return NULL;
+    }
+    return file->map + offset;
+}
+
+// ========== Appending ==========
+
+typedef struct {
+    int64_t key;
+    uint64_t offset;
+} KeyEntry;
+
+static int compareEntries(const void* a, const void* b) {
+    const KeyEntry* x = a;
+    const KeyEntry* y = b;
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    }
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static int64_t recordKey(const RecordFile* file, const uint8_t* record) {
+    if (file->keySize == 4) {
+        int32_t key;
+        memcpy(&key, record + file->keyOffset, 4);
+        return key;
+    }
+    int64_t key;
+    memcpy(&key, record + file->keyOffset, 8);
+    return key;
+}
+
+bool recordFileAppend(RecordFile* file, const void* records, size_t count) {
+    if (!file->writable) {
+        printf("Record file is not open for writing\n");
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    const uint8_t* bytes = records;
+    uint64_t start = alignUp(file->fileSize, RECORD_FILE_PAGE);
+    uint64_t oldCount = file->recordCount;
+    uint64_t total = oldCount + count;
+
+    // New keys sorted by (key, offset); records arriving in key order, the
+    // common case for ids, skip the sort
+    KeyEntry* entries = malloc(count * sizeof(KeyEntry));
+    int64_t* keys = malloc(total * sizeof(int64_t));
+    uint64_t* offsets = malloc(total * sizeof(uint64_t));
+    RecordExtent* extents = malloc((file->extentCount + 1) * sizeof(RecordExtent));
+    bool ok = entries != NULL && keys != NULL && offsets != NULL && extents != NULL;
+    if (!ok) {
+        printf("Memory allocation failed\n");
+    }
+    if (ok) {
+        bool sorted = true;
+        for (size_t i = 0; i < count; i++) {
+            entries[i].key = recordKey(file, bytes + i * file->recordSize);
+            entries[i].offset = start + i * file->recordSize;
+            sorted = sorted && (i == 0 || entries[i - 1].key <= entries[i].key);
+        }
+        if (!sorted) {
+            qsort(entries, count, sizeof(KeyEntry), compareEntries);
+        }
+        // Merge with the mapped index; on equal keys the older record first
+        uint64_t i = 0, j = 0, k = 0;
+        while (i < oldCount || j < count) {
+            if (j == count || (i < oldCount && file->keys[i] <= entries[j].key)) {
+                keys[k] = file->keys[i];
+                offsets[k++] = file->offsets[i++];
+            } else {
+                keys[k] = entries[j].key;
+                offsets[k++] = entries[j++].offset;
+            }
+        }
+        memcpy(extents, file->extents, file->extentCount * sizeof(RecordExtent));
+        extents[file->extentCount] = (RecordExtent){ start, oldCount, count };
+
+        // Data and index first, then the slot that makes them current
+        FileSlot slot;
+        int newSlot = 1 - file->slot;
+        ok = writeAt(file->fd, bytes, count * file->recordSize, start) &&
+             writeIndex(file->fd, start + count * file->recordSize, file->generation + 1, keys, offsets,
+                        total, extents, file->extentCount + 1, &slot) &&
+             fdatasync(file->fd) == 0 &&
+             writeAt(file->fd, &slot, sizeof(slot), SLOT_OFFSET(newSlot)) &&
+             fdatasync(file->fd) == 0;
+    }
+    free(entries);
+    free(keys);
+    free(offsets);
+    free(extents);
+    if (!ok) {
+        return false;
+    }
+    munmap((void*)file->map, file->mapSize);
+    file->map = NULL;
+    return loadState(file);
+}
+
+// ========== Compaction ==========
+
+uint64_t recordFileDeadBytes(const RecordFile* file) {
+    uint64_t live = RECORD_FILE_PAGE + file->recordCount * file->recordSize +
+                    file->recordCount * (sizeof(int64_t) + sizeof(uint64_t)) +
+                    file->extentCount * sizeof(RecordExtent) + sizeof(FileFooter);
+    return file->fileSize > live ? file->fileSize - live : 0;
+}
+
+// Record number of the record at file offset `offset`
+static uint64_t recordNumber(const RecordFile* file, uint64_t offset) {
+    // Extents lie in the file in record order: last one starting at or
+    // before `offset`
+    uint64_t low = 0, high = file->extentCount - 1;
+    while (low < high) {
+        uint64_t middle = (low + high + 1) / 2;
+        if (file->extents[middle].offset <= offset) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    const RecordExtent* extent = &file->extents[low];
+    return extent->first + (offset - extent->offset) / file->recordSize;
+}
+
+bool recordFileCompact(RecordFile* file, const char* path) {
+    if (!file->writable) {
+        printf("Record file is not open for writing\n");
+        return false;
+    }
+    size_t length = strlen(path);
+    char* temporary = malloc(length + 5);
+    uint64_t* offsets = malloc((file->recordCount > 0 ? file->recordCount : 1) * sizeof(uint64_t));
+    if (temporary == NULL || offsets == NULL) {
+        printf("Memory allocation failed\n");
+        free(temporary);
+        free(offsets);
+        return false;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", 5);
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Cannot create %s\n", temporary);
+        free(temporary);
+        free(offsets);
+        return false;
+    }
+
+    // Records in record order from the end of the header page; the keys
+    // keep their order, since record numbers grow with file offsets
+    bool ok = true;
+    uint64_t position = RECORD_FILE_PAGE;
+    for (uint64_t e = 0; ok && e < file->extentCount; e++) {
+        const RecordExtent* extent = &file->extents[e];
+        ok = writeAt(fd, file->map + extent->offset, extent->count * file->recordSize, position);
+        position += extent->count * file->recordSize;
+    }
+    for (uint64_t i = 0; i < file->recordCount; i++) {
+        offsets[i] = RECORD_FILE_PAGE + recordNumber(file, file->offsets[i]) * file->recordSize;
+    }
+    RecordExtent extent = { RECORD_FILE_PAGE, 0, file->recordCount };
+    FileSlot slot = { 0 };
+    ok = ok && writeIndex(fd, position, file->generation + 1, file->keys, offsets, file->recordCount, &extent,
+                          file->recordCount > 0 ? 1 : 0, &slot);
+
+    uint8_t page[RECORD_FILE_PAGE] = { 0 };
+    memcpy(page, file->map, sizeof(FileHeader));
+    memcpy(page + SLOT_OFFSET(0), &slot, sizeof(slot));
+    ok = ok && writeAt(fd, page, sizeof(page), 0) && fdatasync(fd) == 0;
+    close(fd);
+    free(offsets);
+    if (ok && rename(temporary, path) != 0) {
+        printf("Cannot rename %s to %s\n", temporary, path);
+        ok = false;
+    }
+    if (!ok) {
+        remove(temporary);
+        free(temporary);
+        return false;
+    }
+    free(temporary);
+    uint32_t recordSize = file->recordSize;
+    recordFileClose(file);
+    return recordFileOpen(file, path, recordSize, true);
+}
@@ -0,0 +1,103 @@
+/*
+ * record_file.h - Memory-Mapped Binary Record File with a Key Index
+ *
+ * docs/09-file-io/01-file-handling.md saves records with
+ * fwrite(students, sizeof(struct Student), 3, file) and reads all of them
+ * back with fread before use; finding one record is a scan. The file has
+ * no header, so a reader cannot tell a different struct layout or byte
+ * order from valid data. This format:
+ *
+ * - starts with a versioned header page: magic, version, byte-order mark,
+ *   record size and where the key lives inside each record
+ * - keeps records at a fixed width in page-aligned extents, one per append
+ * - ends each append with a sorted key index (keys and record offsets in
+ *   two arrays) and a checksummed footer
+ * - is opened with mmap(2): startup reads the header and one footer,
+ *   whatever the file size, and records are read in place on first touch
+ * - looks keys up by binary search over the mapped index
+ *
+ * Appends never overwrite data a reader may use. The new records, index
+ * and footer go past the end of the file and are flushed with fdatasync;
+ * then one of two checksummed slots in the header, alternating, is pointed
+ * at the new footer and flushed again. A crash at any point leaves the
+ * previous footer valid. Every append writes a whole new index and leaves
+ * the old one behind as dead space, and each append starts on a fresh page,
+ * so n appends of a file with r records leave O(n * r) dead bytes. Append
+ * in batches, and call recordFileCompact() when recordFileDeadBytes()
+ * grows past the live data: it rewrites the file with one extent and one
+ * index.
+ *
+ * Keys are signed 4- or 8-byte integers at keyOffset in each record.
+ * Records are stored as given, in the byte order of the machine that wrote
+ * them; the byte-order mark makes a machine of the other order refuse the
+ * file instead of misreading it. Use fixed-width fields (int32_t, not int)
+ * in the record struct. Duplicate keys are allowed; recordFileFind()
+ * returns the first record appended with the key.
+ *
+ * Compile together with record_file.c:
+ *   gcc -O2 -o program program.c record_file.c
+ */
+
+#ifndef RECORD_FILE_H
+#define RECORD_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RECORD_FILE_VERSION 1
+#define RECORD_FILE_PAGE 4096
+
+typedef struct {
+    uint64_t offset;    // file offset of the first record
+    uint64_t first;     // number of the first record
+    uint64_t count;
+} RecordExtent;
+
+typedef struct {
+    int fd;
+    bool writable;
+    const uint8_t* map;           // the whole file, read-only
+    size_t mapSize;
+    uint32_t recordSize;
+    uint32_t keyOffset;
+    uint32_t keySize;
+    int slot;                     // header slot naming the current footer
+    uint64_t generation;          // appends so far
+    uint64_t fileSize;            // bytes in use, up to the end of the footer
+    uint64_t recordCount;
+    uint64_t extentCount;
+    const RecordExtent* extents;  // into map
+    const int64_t* keys;          // sorted, into map
+    const uint64_t* offsets;      // file offset of the record of keys[i]
+} RecordFile;
+
+// A new empty file (replacing any existing one) for records of recordSize
+// bytes with a keySize-byte key at keyOffset
+bool recordFileCreate(const char* path, uint32_t recordSize, uint32_t keyOffset, uint32_t keySize);
+
+// Fails when the file is not a record file of this version and byte order,
+// or holds records of another size
+bool recordFileOpen(RecordFile* file, const char* path, uint32_t recordSize, bool writable);
+void recordFileClose(RecordFile* file);
+
+// Pointers into the mapping, valid until the next append or close
+const void* recordFileGet(const RecordFile* file, uint64_t index);
+const void* recordFileFind(const RecordFile* file, int64_t key);
+
+// Appends `count` records of recordSize bytes each; requires writable
+bool recordFileAppend(RecordFile* file, const void* records, size_t count);
+
+// Bytes of fileSize that hold neither the header page, a record nor the
+// current index: old indexes and padding left by earlier appends
+uint64_t recordFileDeadBytes(const RecordFile* file);
+
+// Rewrites the file at `path` (the one `file` was opened from) with every
+// record in one extent and a single index, then reopens `file` on it.
+// Record numbers, keys and lookups are unchanged. The new file replaces the
+// old one with rename(2), so a crash leaves one of the two; programs that
+// still have the old file open keep reading the old copy. Requires writable;
+// if the rewritten file cannot be reopened, `file` is left closed.
+bool recordFileCompact(RecordFile* file, const char* path);
+
+#endif
@@ -0,0 +1,362 @@
+/*
+ * Record File Demo: Student Records Opened with mmap Instead of fread
+ *
+ * Stores the students of docs/09-file-io/01-file-handling.md in a record
+ * file, checks lookups by number and key against an in-memory copy over
+ * several appends, checks that torn appends and a damaged header slot fall
+ * back to the previous state and that compaction keeps the file size
+ * bounded over many small appends, then compares startup and lookups with the
+ * fwrite/fread file of the docs for N million students.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o record_file_demo record_file_demo.c record_file.c
+ *   ./record_file_demo [millions of students]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "record_file.h"
+
+#define DEMO_FILE "record_file_demo.bin"
+#define FREAD_FILE "record_file_demo_fwrite.bin"
+
+// struct Student of the docs with a fixed-width id
+typedef struct {
+    int32_t id;
+    char name[50];
+    float gpa;
+} Student;
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void makeStudent(Student* student, int32_t id, unsigned* seed) {
+    memset(student, 0, sizeof(*student));
+    student->id = id;
+    snprintf(student->name, sizeof(student->name), "student-%u", nextRandom(seed) % 1000000);
+    student->gpa = (float)(nextRandom(seed) % 401) / 100.0f;
+}
+
+static bool createStudentFile(const char* path) {
+    return recordFileCreate(path, sizeof(Student), offsetof(Student, id), sizeof(int32_t));
+}
+
+// ========== Checks ==========
+
+// Every record by number, every key present (first appended wins) and a
+// few keys that are absent
+static bool matchesCopy(const RecordFile* file, const Student* copy, size_t count) {
+    if (file->recordCount != count || recordFileGet(file, count) != NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const Student* record = recordFileGet(file, i);
+        if (record == NULL || memcmp(record, &copy[i], sizeof(Student)) != 0) {
+            return false;
+        }
+        const Student* found = recordFileFind(file, copy[i].id);
+        size_t first = 0;
+        while (copy[first].id != copy[i].id) {
+            first++;
+        }
+        if (found == NULL || memcmp(found, &copy[first], sizeof(Student)) != 0) {
+            return false;
+        }
+    }
+    const int32_t absent[] = { -5, 0, 2000000, INT32_MIN, INT32_MAX };
+    for (int a = 0; a < 5; a++) {
+        if (recordFileFind(file, absent[a]) != NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkAppends(unsigned* seed) {
+    const size_t batches[] = { 1, 1000, 0, 5000, 2, 3000 };
+    Student* copy = malloc(9003 * sizeof(Student));
+    RecordFile file;
+    if (copy == NULL || !createStudentFile(DEMO_FILE) || !recordFileOpen(&file, DEMO_FILE, sizeof(Student), true)) {
+        free(copy);
+        return false;
+    }
+    bool ok = matchesCopy(&file, copy, 0);
+    size_t count = 0;
+    for (int b = 0; b < 6 && ok; b++) {
+        // Odd batches in id order, even ones random with repeated ids
+        for (size_t i = 0; i < batches[b]; i++) {
+            int32_t id = b % 2 == 1 ? (int32_t)(1000 + count + i) : (int32_t)(1 + nextRandom(seed) % 20000);
+            makeStudent(&copy[count + i], id, seed);
+        }
+        ok = recordFileAppend(&file, copy + count, batches[b]);
+        count += batches[b];
+        ok = ok && matchesCopy(&file, copy, count);
+    }
+    recordFileClose(&file);
+    ok = ok && recordFileOpen(&file, DEMO_FILE, sizeof(Student), false) && matchesCopy(&file, copy, count);
+    printf("  (the next message is expected)\n  ");
+    ok = ok && !recordFileAppend(&file, copy, 1);   // read-only
+    recordFileClose(&file);
+    free(copy);
+    return ok;
+}
+
+// Appends that stopped half-way and a damaged slot must leave the last
+// complete state readable
+static bool checkRecovery(unsigned* seed) {
+    Student students[200];
+    for (int i = 0; i < 200; i++) {
+        makeStudent(&students[i], 5000 - i, seed);
+    }
+    RecordFile file;
+    bool ok = createStudentFile(DEMO_FILE) && recordFileOpen(&file, DEMO_FILE, sizeof(Student), true) &&
+              recordFileAppend(&file, students, 100) && recordFileAppend(&file, students + 100, 50);
+    recordFileClose(&file);
+
+    // A torn append: records and half an index past the end, slot untouched
+    int fd = open(DEMO_FILE, O_WRONLY | O_APPEND);
+    char junk[10000];
+    memset(junk, 0x5A, sizeof(junk));
+    ok = ok && fd >= 0 && write(fd, junk, sizeof(junk)) == (ssize_t)sizeof(junk);
+    if (fd >= 0) {
+        close(fd);
+    }
+    ok = ok && recordFileOpen(&file, DEMO_FILE, sizeof(Student), true) && matchesCopy(&file, students, 150) &&
+         recordFileAppend(&file, students + 150, 50) && matchesCopy(&file, students, 200);
+    int currentSlot = file.slot;
+    recordFileClose(&file);
+
+    // A torn slot write: the slot of the last append (at 512 or 1024) is
+    // damaged, so the file opens in the state before that append
+    char damage = 0x77;
+    fd = open(DEMO_FILE, O_WRONLY);
+    ok = ok && fd >= 0 && pwrite(fd, &damage, 1, 512 * (currentSlot + 1) + 3) == 1;
+    if (fd >= 0) {
+        close(fd);
+    }
+    ok = ok && recordFileOpen(&file, DEMO_FILE, sizeof(Student), false) && matchesCopy(&file, students, 150);
+    recordFileClose(&file);
+
+    // Other record sizes and files that are not record files are refused
+    printf("  (the next two messages are expected)\n  ");
+    ok = ok && !recordFileOpen(&file, DEMO_FILE, sizeof(Student) + 4, false);
+    FILE* other = fopen(FREAD_FILE, "wb");
+    ok = ok && other != NULL && fwrite(students, sizeof(Student), 200, other) == 200;
+    if (other != NULL) {
+        fclose(other);
+    }
+    printf("  ");
+    ok = ok && !recordFileOpen(&file, FREAD_FILE, sizeof(Student), false);
+    remove(FREAD_FILE);
+    return ok;
+}
+
+// Many small appends, compacting whenever the dead space passes the live
+// data: the file must stay within a small multiple of the live data, while
+// without compaction it grows with appends x records. Returns the largest
+// sizes seen through *compacted and *uncompacted.
+static bool checkCompaction(unsigned* seed, uint64_t* compacted, uint64_t* uncompacted) {
+    enum { APPENDS = 200, BATCH = 50 };
+    Student* copy = malloc(APPENDS * BATCH * sizeof(Student));
+    if (copy == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (size_t i = 0; i < APPENDS * BATCH; i++) {
+        makeStudent(&copy[i], (int32_t)(1 + nextRandom(seed) % 5000), seed);
+    }
+    bool ok = true;
+    for (int compact = 0; compact < 2 && ok; compact++) {
+        RecordFile file;
+        uint64_t largest = 0;
+        ok = createStudentFile(DEMO_FILE) && recordFileOpen(&file, DEMO_FILE, sizeof(Student), true);
+        for (size_t a = 0; a < APPENDS && ok; a++) {
+            ok = recordFileAppend(&file, copy + a * BATCH, BATCH);
+            largest = file.fileSize > largest ? file.fileSize : largest;
+            uint64_t dead = recordFileDeadBytes(&file);
+            if (ok && compact == 1 && dead > file.fileSize - dead) {
+                ok = recordFileCompact(&file, DEMO_FILE) && recordFileDeadBytes(&file) < 64 &&
+                     matchesCopy(&file, copy, (a + 1) * BATCH);
+            }
+            // Never more than the live data twice over plus one append's waste
+            uint64_t live = file.fileSize - recordFileDeadBytes(&file);
+            ok = ok && (compact == 0 || file.fileSize <= 3 * live);
+        }
+        ok = ok && matchesCopy(&file, copy, APPENDS * BATCH);
+        recordFileClose(&file);
+        *(compact == 1 ? compacted : uncompacted) = largest;
+    }
+    free(copy);
+    return ok && *compacted * 4 < *uncompacted;
+}
+
+// ========== Benchmark ==========
+
+static void benchmark(size_t count, unsigned* seed) {
+    struct timespec start, end;
+    printf("\n=== %zu students (%zu bytes each) ===\n", count, sizeof(Student));
+    Student* students = malloc(count * sizeof(Student));
+    if (students == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        makeStudent(&students[i], (int32_t)(1000 + i), seed);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    FILE* file = fopen(FREAD_FILE, "wb");
+    if (file == NULL) {
+        printf("Error opening file\n");
+        free(students);
+        return;
+    }
+    fwrite(students, sizeof(Student), count, file);
+    fflush(file);
+    fdatasync(fileno(file));
+    fclose(file);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Write: fwrite %.2f s", elapsedSeconds(start, end));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RecordFile records;
+    bool ok = createStudentFile(DEMO_FILE) && recordFileOpen(&records, DEMO_FILE, sizeof(Student), true) &&
+              recordFileAppend(&records, students, count);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf(", record file %.2f s (with index, %.0f MB)\n", elapsedSeconds(start, end),
+           ok ? records.fileSize / 1e6 : 0.0);
+    recordFileClose(&records);
+    free(students);
+    if (!ok) {
+        return;
+    }
+
+    // Startup: the docs read every record before the first lookup
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    file = fopen(FREAD_FILE, "rb");
+    Student* loaded = malloc(count * sizeof(Student));
+    size_t read = file != NULL && loaded != NULL ? fread(loaded, sizeof(Student), count, file) : 0;
+    if (file != NULL) {
+        fclose(file);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double freadStartup = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ok = recordFileOpen(&records, DEMO_FILE, sizeof(Student), false);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double openStartup = elapsedSeconds(start, end);
+    printf("Startup: fread %.3f s, recordFileOpen %.3f ms (%.0fx)\n", freadStartup, openStartup * 1e3,
+           freadStartup / openStartup);
+    if (!ok || read != count) {
+        free(loaded);
+        return;
+    }
+
+    // Lookups by id: a scan per key vs binary search in the mapped index
+    const int scans = 20, lookups = 1000000;
+    int32_t* ids = malloc(lookups * sizeof(int32_t));
+    if (ids == NULL) {
+        printf("Memory allocation failed\n");
+        free(loaded);
+        recordFileClose(&records);
+        return;
+    }
+    for (int i = 0; i < lookups; i++) {
+        ids[i] = (int32_t)(1000 + nextRandom(seed) % (count + count / 10));   // about 9% absent
+    }
+    size_t found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < scans; i++) {
+        for (size_t j = 0; j < count; j++) {
+            if (loaded[j].id == ids[i]) {
+                found++;
+                break;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double scanEach = elapsedSeconds(start, end) / scans;
+    size_t scanFound = found;
+    found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < lookups; i++) {
+        found += recordFileFind(&records, ids[i]) != NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double findEach = elapsedSeconds(start, end) / lookups;
+    size_t expectedFound = 0;
+    for (int i = 0; i < scans; i++) {
+        expectedFound += recordFileFind(&records, ids[i]) != NULL;
+    }
+    printf("Lookup: linear scan %.3f ms, recordFileFind %.3f us (%.0fx)%s\n", scanEach * 1e3,
+           findEach * 1e6, scanEach / findEach, expectedFound == scanFound ? "" : "  MISMATCH");
+    printf("Time to the first 1000 lookups, from the times above: fread + scans %.1f s, open + finds %.3f ms\n",
+           freadStartup + 1000 * scanEach, (openStartup + 1000 * findEach) * 1e3);
+
+    free(ids);
+    free(loaded);
+    recordFileClose(&records);
+    remove(DEMO_FILE);
+    remove(FREAD_FILE);
+}
+
+int main(int argc, char* argv[]) {
+    long millions = argc > 1 ? atol(argv[1]) : 10;
+    if (millions < 1 || millions > 30) {
+        printf("Usage: %s [millions of students, 1 to 30]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Example: the students of the docs ===\n");
+    const Student students[] = { { 1001, "Alice", 3.8f }, { 1002, "Bob", 3.5f }, { 1003, "Charlie", 3.9f } };
+    RecordFile file;
+    if (!createStudentFile(DEMO_FILE) || !recordFileOpen(&file, DEMO_FILE, sizeof(Student), true) ||
+        !recordFileAppend(&file, students, 3)) {
+        return 1;
+    }
+    recordFileClose(&file);
+    if (!recordFileOpen(&file, DEMO_FILE, sizeof(Student), false)) {
+        return 1;
+    }
+    for (uint64_t i = 0; i < file.recordCount; i++) {
+        const Student* student = recordFileGet(&file, i);
+        printf("ID: %d, Name: %s, GPA: %.2f\n", student->id, student->name, student->gpa);
+    }
+    const Student* bob = recordFileFind(&file, 1002);
+    printf("Find 1002: %s; find 1004: %s\n", bob != NULL ? bob->name : "none",
+           recordFileFind(&file, 1004) != NULL ? "found" : "none");
+    recordFileClose(&file);
+
+    unsigned seed = 2463534242u;
+    printf("\n=== Checks ===\n");
+    bool appendOk = checkAppends(&seed);
+    printf("Get and find over 6 appends, reopened read-only: %s\n", appendOk ? "all match" : "MISMATCH");
+    bool recoveryOk = checkRecovery(&seed);
+    printf("Torn append, damaged slot, wrong size, not a record file: %s\n",
+           recoveryOk ? "all match" : "MISMATCH");
+    uint64_t compacted = 0, uncompacted = 0;
+    bool compactOk = checkCompaction(&seed, &compacted, &uncompacted);
+    printf("200 appends of 50 students, largest file: %llu KB compacted, %llu KB not: %s\n",
+           (unsigned long long)compacted / 1024, (unsigned long long)uncompacted / 1024,
+           compactOk ? "all match" : "MISMATCH");
+    remove(DEMO_FILE);
+
+    benchmark((size_t)millions * 1000000, &seed);
+    return appendOk && recoveryOk && compactOk ? 0 : 1;
+}
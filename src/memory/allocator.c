@@ -0,0 +1,607 @@
+/*
+ * allocator.c - Pluggable Memory Allocators (see allocator.h)
+ */
+
+#include "allocator.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ALLOC_ALIGNMENT 16
+
+static size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+// ========== malloc ==========
+
+static void* mallocAllocate(Allocator* self, size_t size, const char* file, int line) {
+    (void)self;
+    (void)file;
+    (void)line;
+    return malloc(size);
+}
+
+static void mallocRelease(Allocator* self, void* ptr, size_t size) {
+    (void)self;
+    (void)size;
+    free(ptr);
+}
+
+static Allocator mallocInstance = {mallocAllocate, mallocRelease, "malloc"};
+
+Allocator* mallocAllocator(void) {
+    return &mallocInstance;
+}
+
+// ========== Arena ==========
+
+#define ARENA_HEADER alignUp(sizeof(ArenaChunk), ALLOC_ALIGNMENT)
+
+static ArenaChunk* arenaNewChunk(size_t capacity) {
+    ArenaChunk* chunk = (ArenaChunk*)malloc(ARENA_HEADER + capacity);
+    if (chunk == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void* arenaAllocate(Allocator* self, size_t size, const char* file, int line) {
+    Arena* arena = (Arena*)self;
+    (void)file;
+    (void)line;
+
+    size = alignUp(size ? size : 1, ALLOC_ALIGNMENT);
+    ArenaChunk* chunk = arena->current;
+
+    if (chunk == NULL || chunk->used + size > chunk->capacity) {
+        // Reuse a chunk kept by an earlier reset if it is big enough,
+        // otherwise insert a new one right after the current chunk
+        ArenaChunk* next = (chunk != NULL) ? chunk->next : arena->first;
+        if (next != NULL && next->capacity >= size) {
+            next->used = 0;
+            chunk = next;
+        } else {
+            ArenaChunk* fresh = arenaNewChunk(size > arena->chunkSize ? size : arena->chunkSize);
+            if (fresh == NULL) {
+                return NULL;
+            }
+            fresh->next = next;
+            if (chunk != NULL) {
+                chunk->next = fresh;
+            } else {
+                arena->first = fresh;
+            }
+            chunk = fresh;
+        }
+        arena->current = chunk;
+    }
+
+    void* ptr = (char*)chunk + ARENA_HEADER + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+// Individual frees are ignored; memory comes back with a reset
+static void arenaRelease(Allocator* self, void* ptr, size_t size) {
+    (void)self;
+    (void)ptr;
+    (void)size;
+}
+
+void arenaInit(Arena* arena, size_t chunkSize) {
+    arena->base.allocate = arenaAllocate;
+    arena->base.release = arenaRelease;
+    arena->base.name = "arena";
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->chunkSize = chunkSize ? chunkSize : 64 * 1024;
+}
+
+ArenaMark arenaMark(const Arena* arena) {
+    ArenaMark mark;
+    mark.chunk = arena->current;
+    mark.used = (arena->current != NULL) ? arena->current->used : 0;
+    return mark;
+}
+
+void arenaResetTo(Arena* arena, ArenaMark mark) {
+    arena->current = mark.chunk;
+    if (mark.chunk != NULL) {
+        mark.chunk->used = mark.used;
+    }
+}
+
+void arenaReset(Arena* arena) {
+    arena->current = NULL;
+}
+
+void arenaDestroy(Arena* arena) {
+    ArenaChunk* chunk = arena->first;
+    while (chunk != NULL) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+size_t arenaBytesReserved(const Arena* arena) {
+    size_t total = 0;
+    for (const ArenaChunk* chunk = arena->first; chunk != NULL; chunk = chunk->next) {
+        total += chunk->capacity;
+    }
+    return total;
+}
+
+// ========== Pool ==========
+
+static void* poolAllocate(Allocator* self, size_t size, const char* file, int line) {
+    Pool* pool = (Pool*)self;
+    (void)file;
+    (void)line;
+
+    if (size > pool->objectSize) {
+        printf("Pool object size is %zu, requested %zu\n", pool->objectSize, size);
+        return NULL;
+    }
+
+    if (pool->freeList == NULL) {
+        size_t header = alignUp(sizeof(PoolChunk), ALLOC_ALIGNMENT);
+        PoolChunk* chunk = (PoolChunk*)malloc(header + pool->objectSize * pool->objectsPerChunk);
+        if (chunk == NULL) {
+            printf("Memory allocation failed\n");
+            return NULL;
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+
+        // Thread the new objects onto the free list in address order
+        char* base = (char*)chunk + header;
+        for (size_t i = pool->objectsPerChunk; i > 0; i--) {
+            void* object = base + (i - 1) * pool->objectSize;
+            *(void**)object = pool->freeList;
+            pool->freeList = object;
+        }
+    }
+
+    void* object = pool->freeList;
+    pool->freeList = *(void**)object;
+    return object;
+}
+
+static void poolRelease(Allocator* self, void* ptr, size_t size) {
+    Pool* pool = (Pool*)self;
+    (void)size;
+    if (ptr != NULL) {
+        *(void**)ptr = pool->freeList;
+        pool->freeList = ptr;
+    }
+}
+
+void poolInit(Pool* pool, size_t objectSize, size_t objectsPerChunk) {
+    pool->base.allocate = poolAllocate;
+    pool->base.release = poolRelease;
+    pool->base.name = "pool";
+    // Every free object must be able to hold the free-list link
+    if (objectSize < sizeof(void*)) {
+        objectSize = sizeof(void*);
+    }
+    pool->objectSize = alignUp(objectSize, sizeof(void*));
+    pool->objectsPerChunk = objectsPerChunk ? objectsPerChunk : 1024;
+    pool->freeList = NULL;
+    pool->chunks = NULL;
+}
+
+void poolDestroy(Pool* pool) {
+    while (pool->chunks != NULL) {
+        PoolChunk* next = pool->chunks->next;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+    pool->freeList = NULL;
+}
+
+// ========== Size-class allocator ==========
+
+#define SIZE_CLASS_MAX 4096
+#define SIZE_CLASS_COUNT 24
+#define SPAN_BYTES (64 * 1024)
+
+// 16-byte steps up to 256, then roughly 1.5x steps up to 4096
+static const size_t classSizes[SIZE_CLASS_COUNT] = {
+    16, 32, 48, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, 224, 240, 256,
+    384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+typedef struct FreeObject {
+    struct FreeObject* next;
+} FreeObject;
+
+typedef struct {
+    pthread_mutex_t lock;
+    FreeObject* freeList;
+    size_t freeCount;
+} CentralList;
+
+typedef struct {
+    FreeObject* freeList[SIZE_CLASS_COUNT];
+    size_t count[SIZE_CLASS_COUNT];
+} ThreadCache;
+
+static CentralList central[SIZE_CLASS_COUNT];
+static unsigned char classOfSize[SIZE_CLASS_MAX / ALLOC_ALIGNMENT + 1];
+static size_t batchSize[SIZE_CLASS_COUNT];
+static pthread_once_t sizeClassOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadCacheKey;
+static _Thread_local ThreadCache* threadCache = NULL;
+
+// Central spans are never returned to the system, like most real allocators
+static void* allocateSpan(size_t bytes) {
+    return malloc(bytes);
+}
+
+// Give every cached object back to the central lists when a thread exits
+static void threadCacheDestroy(void* arg) {
+    ThreadCache* cache = (ThreadCache*)arg;
+    for (int c = 0; c < SIZE_CLASS_COUNT; c++) {
+        FreeObject* object = cache->freeList[c];
+        while (object != NULL) {
+            FreeObject* next = object->next;
+            pthread_mutex_lock(&central[c].lock);
+            object->next = central[c].freeList;
+            central[c].freeList = object;
+            central[c].freeCount++;
+            pthread_mutex_unlock(&central[c].lock);
+            object = next;
+        }
+    }
+    free(cache);
+}
+
+static void sizeClassSetup(void) {
+    int c = 0;
+    for (size_t slot = 0; slot <= SIZE_CLASS_MAX / ALLOC_ALIGNMENT; slot++) {
+        size_t size = slot * ALLOC_ALIGNMENT;
+        while (classSizes[c] < size) {
+            c++;
+        }
+        classOfSize[slot] = (unsigned char)c;
+    }
+
+    for (c = 0; c < SIZE_CLASS_COUNT; c++) {
+        pthread_mutex_init(&central[c].lock, NULL);
+        central[c].freeList = NULL;
+        central[c].freeCount = 0;
+        // Move about 8 KB per batch, between 4 and 64 objects
+        size_t batch = 8192 / classSizes[c];
+        batchSize[c] = batch < 4 ? 4 : (batch > 64 ? 64 : batch);
+    }
+    pthread_key_create(&threadCacheKey, threadCacheDestroy);
+}
+
+static ThreadCache* getThreadCache(void) {
+    if (threadCache == NULL) {
+        threadCache = (ThreadCache*)calloc(1, sizeof(ThreadCache));
+        if (threadCache != NULL) {
+            pthread_setspecific(threadCacheKey, threadCache);
+        }
+    }
+    return threadCache;
+}
+
+// Move one batch from the central list (carving a new span if needed)
+static int refillThreadCache(ThreadCache* cache, int c) {
+    CentralList* list = &central[c];
+    size_t wanted = batchSize[c];
+
+    pthread_mutex_lock(&list->lock);
+    if (list->freeCount < wanted) {
+        size_t objects = SPAN_BYTES / classSizes[c];
+        char* span = (char*)allocateSpan(objects * classSizes[c]);
+        if (span == NULL) {
+            pthread_mutex_unlock(&list->lock);
+            return 0;
+        }
+        for (size_t i = 0; i < objects; i++) {
+            FreeObject* object = (FreeObject*)(span + i * classSizes[c]);
+            object->next = list->freeList;
+            list->freeList = object;
+        }
+        list->freeCount += objects;
+    }
+
+    for (size_t i = 0; i < wanted; i++) {
+        FreeObject* object = list->freeList;
+        list->freeList = object->next;
+        object->next = cache->freeList[c];
+        cache->freeList[c] = object;
+    }
+    list->freeCount -= wanted;
+    pthread_mutex_unlock(&list->lock);
+
+    cache->count[c] += wanted;
+    return 1;
+}
+
+// Return one batch when a thread frees much more than it allocates
+static void flushThreadCache(ThreadCache* cache, int c) {
+    size_t moving = batchSize[c];
+    FreeObject* first = cache->freeList[c];
+    FreeObject* last = first;
+    for (size_t i = 1; i < moving; i++) {
+        last = last->next;
+    }
+    cache->freeList[c] = last->next;
+    cache->count[c] -= moving;
+
+    pthread_mutex_lock(&central[c].lock);
+    last->next = central[c].freeList;
+    central[c].freeList = first;
+    central[c].freeCount += moving;
+    pthread_mutex_unlock(&central[c].lock);
+}
+
+static void* sizeClassAllocate(Allocator* self, size_t size, const char* file, int line) {
+    (void)self;
+    (void)file;
+    (void)line;
+
+    if (size > SIZE_CLASS_MAX) {
+        return malloc(size);
+    }
+
+    ThreadCache* cache = getThreadCache();
+    if (cache == NULL) {
+        return malloc(size);
+    }
+
+    int c = classOfSize[(size + ALLOC_ALIGNMENT - 1) / ALLOC_ALIGNMENT];
+    if (cache->freeList[c] == NULL && !refillThreadCache(cache, c)) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    FreeObject* object = cache->freeList[c];
+    cache->freeList[c] = object->next;
+    cache->count[c]--;
+    return object;
+}
+
+static void sizeClassRelease(Allocator* self, void* ptr, size_t size) {
+    (void)self;
+    if (ptr == NULL) {
+        return;
+    }
+    if (size > SIZE_CLASS_MAX) {
+        free(ptr);
+        return;
+    }
+
+    ThreadCache* cache = getThreadCache();
+    int c = classOfSize[(size + ALLOC_ALIGNMENT - 1) / ALLOC_ALIGNMENT];
+    if (cache == NULL) {
+        // No cache for this thread: hand the object straight to the central list
+        pthread_mutex_lock(&central[c].lock);
+        ((FreeObject*)ptr)->next = central[c].freeList;
+        central[c].freeList = (FreeObject*)ptr;
+        central[c].freeCount++;
+        pthread_mutex_unlock(&central[c].lock);
+        return;
+    }
+
+    FreeObject* object = (FreeObject*)ptr;
+    object->next = cache->freeList[c];
+    cache->freeList[c] = object;
+    if (++cache->count[c] > 2 * batchSize[c]) {
+        flushThreadCache(cache, c);
+    }
+}
+
+static Allocator sizeClassInstance = {sizeClassAllocate, sizeClassRelease, "size-class"};
+
+Allocator* sizeClassAllocator(void) {
+    pthread_once(&sizeClassOnce, sizeClassSetup);
+    return &sizeClassInstance;
+}
+
+// ========== Debug layer ==========
+
+#define DEBUG_TOMBSTONE ((void*)(uintptr_t)1)
+
+static size_t hashPointer(const void* ptr, size_t capacity) {
+    uint64_t x = (uint64_t)(uintptr_t)ptr;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t)x & (capacity - 1);
+}
+
+// Rebuilds the table without tombstones, at newCapacity slots
+static int debugRehash(DebugAllocator* debug, size_t newCapacity) {
+    DebugRecord* records = (DebugRecord*)calloc(newCapacity, sizeof(DebugRecord));
+    if (records == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < debug->capacity; i++) {
+        DebugRecord* record = &debug->records[i];
+        if (record->ptr != NULL && record->ptr != DEBUG_TOMBSTONE) {
+            size_t slot = hashPointer(record->ptr, newCapacity);
+            while (records[slot].ptr != NULL) {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+            records[slot] = *record;
+        }
+    }
+
+    free(debug->records);
+    debug->records = records;
+    debug->capacity = newCapacity;
+    debug->tombstones = 0;
+    return 0;
+}
+
+static void* debugAllocate(Allocator* self, size_t size, const char* file, int line) {
+    DebugAllocator* debug = (DebugAllocator*)self;
+    void* ptr = debug->inner->allocate(debug->inner, size, file, line);
+    if (ptr == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&debug->lock);
+    if ((debug->count + debug->tombstones + 1) * 2 > debug->capacity) {
+        // Mostly tombstones: clear them at the same size. The table then
+        // follows the number of live blocks, not of all allocations.
+        size_t newCapacity = (debug->count + 1) * 4 > debug->capacity ? debug->capacity * 2 : debug->capacity;
+        if (debugRehash(debug, newCapacity) != 0) {
+            pthread_mutex_unlock(&debug->lock);
+            debug->inner->release(debug->inner, ptr, size);
+            return NULL;
+        }
+    }
+
+    size_t slot = hashPointer(ptr, debug->capacity);
+    while (debug->records[slot].ptr != NULL && debug->records[slot].ptr != DEBUG_TOMBSTONE) {
+        slot = (slot + 1) & (debug->capacity - 1);
+    }
+    if (debug->records[slot].ptr == DEBUG_TOMBSTONE) {
+        debug->tombstones--;
+    }
+    debug->records[slot].ptr = ptr;
+    debug->records[slot].size = size;
+    debug->records[slot].file = file;
+    debug->records[slot].line = line;
+    debug->count++;
+    debug->totalAllocations++;
+    debug->liveBytes += size;
+    if (debug->liveBytes > debug->peakBytes) {
+        debug->peakBytes = debug->liveBytes;
+    }
+    pthread_mutex_unlock(&debug->lock);
+    return ptr;
+}
+
+static void debugRelease(Allocator* self, void* ptr, size_t size) {
+    DebugAllocator* debug = (DebugAllocator*)self;
+    if (ptr == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&debug->lock);
+    size_t slot = hashPointer(ptr, debug->capacity);
+    while (debug->records[slot].ptr != NULL && debug->records[slot].ptr != ptr) {
+        slot = (slot + 1) & (debug->capacity - 1);
+    }
+
+    if (debug->records[slot].ptr != ptr) {
+        debug->badFrees++;
+        pthread_mutex_unlock(&debug->lock);
+        printf("DEBUG: free of unknown pointer %p (double free?)\n", ptr);
+        return;
+    }
+    if (debug->records[slot].size != size) {
+        printf("DEBUG: %p allocated with %zu bytes at %s:%d but freed with %zu\n",
+               ptr, debug->records[slot].size, debug->records[slot].file,
+               debug->records[slot].line, size);
+        size = debug->records[slot].size;
+    }
+
+    debug->records[slot].ptr = DEBUG_TOMBSTONE;
+    debug->tombstones++;
+    debug->count--;
+    debug->liveBytes -= size;
+    pthread_mutex_unlock(&debug->lock);
+
+    debug->inner->release(debug->inner, ptr, size);
+}
+
+int debugAllocatorInit(DebugAllocator* debug, Allocator* inner) {
+    debug->base.allocate = debugAllocate;
+    debug->base.release = debugRelease;
+    debug->base.name = "debug";
+    debug->inner = inner;
+    debug->capacity = 1024;
+    debug->records = (DebugRecord*)calloc(debug->capacity, sizeof(DebugRecord));
+    if (debug->records == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    debug->count = 0;
+    debug->tombstones = 0;
+    debug->liveBytes = 0;
+    debug->peakBytes = 0;
+    debug->totalAllocations = 0;
+    debug->badFrees = 0;
+    pthread_mutex_init(&debug->lock, NULL);
+    return 0;
+}
+
+typedef struct {
+    const char* file;
+    int line;
+    size_t blocks;
+    size_t bytes;
+} LeakSite;
+
+static int compareLeakSites(const void* a, const void* b) {
+    const LeakSite* x = (const LeakSite*)a;
+    const LeakSite* y = (const LeakSite*)b;
+    return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+// Summary plus live (leaked) allocations grouped by call site, largest first
+void debugAllocatorReport(DebugAllocator* debug, FILE* out) {
+    pthread_mutex_lock(&debug->lock);
+    fprintf(out, "[%s over %s] allocations: %zu, live: %zu blocks / %zu bytes, "
+            "peak: %zu bytes, bad frees: %zu\n",
+            debug->base.name, debug->inner->name, debug->totalAllocations,
+            debug->count, debug->liveBytes, debug->peakBytes, debug->badFrees);
+
+    LeakSite* sites = (LeakSite*)malloc((debug->count ? debug->count : 1) * sizeof(LeakSite));
+    size_t siteCount = 0;
+    for (size_t i = 0; sites != NULL && i < debug->capacity; i++) {
+        DebugRecord* record = &debug->records[i];
+        if (record->ptr == NULL || record->ptr == DEBUG_TOMBSTONE) {
+            continue;
+        }
+
+        size_t s = 0;
+        while (s < siteCount && (sites[s].line != record->line ||
+                                 strcmp(sites[s].file, record->file) != 0)) {
+            s++;
+        }
+        if (s == siteCount) {
+            sites[s].file = record->file;
+            sites[s].line = record->line;
+            sites[s].blocks = 0;
+            sites[s].bytes = 0;
+            siteCount++;
+        }
+        sites[s].blocks++;
+        sites[s].bytes += record->size;
+    }
+
+    if (sites != NULL) {
+        qsort(sites, siteCount, sizeof(LeakSite), compareLeakSites);
+        for (size_t s = 0; s < siteCount; s++) {
+            fprintf(out, "  leak: %zu bytes in %zu blocks allocated at %s:%d\n",
+                    sites[s].bytes, sites[s].blocks, sites[s].file, sites[s].line);
+        }
+        free(sites);
+    }
+    pthread_mutex_unlock(&debug->lock);
+}
+
+void debugAllocatorDestroy(DebugAllocator* debug) {
+    free(debug->records);
+    debug->records = NULL;
+    pthread_mutex_destroy(&debug->lock);
+}
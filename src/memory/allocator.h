@@ -0,0 +1,134 @@
+/*
+ * allocator.h - Pluggable Memory Allocators
+ *
+ * Data structures that take an Allocator* instead of calling malloc/free
+ * directly can switch allocation strategy without changing their code:
+ *
+ *   Allocator        When to use it
+ *   ---------------  --------------------------------------------------------
+ *   mallocAllocator  default; plain malloc/free
+ *   Arena            many objects with one lifetime; free is a no-op and
+ *                    arenaReset()/arenaResetTo() release everything at once
+ *   Pool             many objects of one size (list/tree/graph nodes)
+ *   sizeClass        general purpose; per-thread caches of size classes,
+ *                    so most malloc/free pairs never take a lock
+ *   DebugAllocator   wraps any allocator and tracks live bytes, peak usage
+ *                    and leaked allocations per call site
+ *
+ * Frees are sized: the caller passes the same size it allocated. Pools and
+ * size classes use it to avoid a per-object header.
+ *
+ *   Pool pool;
+ *   poolInit(&pool, sizeof(Node), 1024);
+ *   Node* node = ALLOCATOR_ALLOC(&pool.base, sizeof(Node));
+ *   ALLOCATOR_FREE(&pool.base, node, sizeof(Node));
+ *   poolDestroy(&pool);
+ *
+ * Compile together with allocator.c:
+ *   gcc -O2 -pthread -o program program.c allocator.c
+ */
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+typedef struct Allocator Allocator;
+
+struct Allocator {
+    void* (*allocate)(Allocator* self, size_t size, const char* file, int line);
+    void (*release)(Allocator* self, void* ptr, size_t size);
+    const char* name;
+};
+
+// The call site is recorded so the debug layer can report where leaks come from
+#define ALLOCATOR_ALLOC(allocator, size) \
+    ((allocator)->allocate((allocator), (size), __FILE__, __LINE__))
+#define ALLOCATOR_FREE(allocator, ptr, size) \
+    ((allocator)->release((allocator), (ptr), (size)))
+
+// ========== malloc ==========
+
+Allocator* mallocAllocator(void);
+
+// ========== Arena (bump allocator) ==========
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t capacity;
+    size_t used;
+    // data follows the header
+} ArenaChunk;
+
+typedef struct {
+    Allocator base;
+    ArenaChunk* first;
+    ArenaChunk* current;
+    size_t chunkSize;
+} Arena;
+
+// Position to roll back to with arenaResetTo()
+typedef struct {
+    ArenaChunk* chunk;
+    size_t used;
+} ArenaMark;
+
+void arenaInit(Arena* arena, size_t chunkSize);
+ArenaMark arenaMark(const Arena* arena);
+void arenaResetTo(Arena* arena, ArenaMark mark);
+void arenaReset(Arena* arena);          // keeps the chunks for reuse
+void arenaDestroy(Arena* arena);        // returns the chunks to the system
+size_t arenaBytesReserved(const Arena* arena);
+
+// ========== Fixed-size object pool ==========
+
+typedef struct PoolChunk {
+    struct PoolChunk* next;
+} PoolChunk;
+
+typedef struct {
+    Allocator base;
+    size_t objectSize;
+    size_t objectsPerChunk;
+    void* freeList;
+    PoolChunk* chunks;
+} Pool;
+
+void poolInit(Pool* pool, size_t objectSize, size_t objectsPerChunk);
+void poolDestroy(Pool* pool);
+
+// ========== Thread-caching size-class allocator ==========
+
+// Process-wide instance; requests above 4096 bytes go to malloc
+Allocator* sizeClassAllocator(void);
+
+// ========== Debug / accounting layer ==========
+
+typedef struct {
+    void* ptr;
+    size_t size;
+    const char* file;
+    int line;
+} DebugRecord;
+
+typedef struct {
+    Allocator base;
+    Allocator* inner;
+    pthread_mutex_t lock;
+    DebugRecord* records;       // open-addressing hash table keyed by ptr
+    size_t capacity;
+    size_t count;
+    size_t tombstones;
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t totalAllocations;
+    size_t badFrees;
+} DebugAllocator;
+
+int debugAllocatorInit(DebugAllocator* debug, Allocator* inner);
+void debugAllocatorReport(DebugAllocator* debug, FILE* out);
+void debugAllocatorDestroy(DebugAllocator* debug);
+
+#endif
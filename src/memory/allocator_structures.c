@@ -0,0 +1,149 @@
+/*
+ * allocator_structures.c - List, Tree and Graph on a Pluggable Allocator (see allocator_structures.h)
+ */
+
+#include "allocator_structures.h"
+
+#include <stdio.h>
+
+// ========== Linked List ==========
+
+void initList(LinkedList* list, Allocator* allocator) {
+    list->head = NULL;
+    list->size = 0;
+    list->allocator = allocator;
+}
+
+void insertAtBeginning(LinkedList* list, int data) {
+    Node* newNode = (Node*)ALLOCATOR_ALLOC(list->allocator, sizeof(Node));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    newNode->data = data;
+    newNode->next = list->head;
+    list->head = newNode;
+    list->size++;
+}
+
+void freeList(LinkedList* list) {
+    while (list->head != NULL) {
+        Node* next = list->head->next;
+        ALLOCATOR_FREE(list->allocator, list->head, sizeof(Node));
+        list->head = next;
+    }
+    list->size = 0;
+}
+
+// ========== Binary Search Tree ==========
+
+void initTree(BinaryTree* tree, Allocator* allocator) {
+    tree->root = NULL;
+    tree->size = 0;
+    tree->allocator = allocator;
+}
+
+void insertNode(BinaryTree* tree, int data) {
+    TreeNode** link = &tree->root;
+    while (*link != NULL) {
+        if (data < (*link)->data) {
+            link = &(*link)->left;
+        } else if (data > (*link)->data) {
+            link = &(*link)->right;
+        } else {
+            return;
+        }
+    }
+
+    TreeNode* newNode = (TreeNode*)ALLOCATOR_ALLOC(tree->allocator, sizeof(TreeNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    newNode->data = data;
+    newNode->left = NULL;
+    newNode->right = NULL;
+    *link = newNode;
+    tree->size++;
+}
+
+// Iterative teardown: rotate left children away, then free the root
+void freeTree(BinaryTree* tree) {
+    TreeNode* root = tree->root;
+    while (root != NULL) {
+        if (root->left != NULL) {
+            TreeNode* left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            TreeNode* right = root->right;
+            ALLOCATOR_FREE(tree->allocator, root, sizeof(TreeNode));
+            root = right;
+        }
+    }
+    tree->root = NULL;
+    tree->size = 0;
+}
+
+// ========== Adjacency-List Graph ==========
+
+GraphList* createGraphList(int vertices, bool directed, Allocator* allocator, Allocator* edgeAllocator) {
+    GraphList* graph = (GraphList*)ALLOCATOR_ALLOC(allocator, sizeof(GraphList));
+    if (graph == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    graph->array = (AdjList*)ALLOCATOR_ALLOC(allocator, (size_t)vertices * sizeof(AdjList));
+    if (graph->array == NULL) {
+        printf("Memory allocation failed\n");
+        ALLOCATOR_FREE(allocator, graph, sizeof(GraphList));
+        return NULL;
+    }
+
+    for (int i = 0; i < vertices; i++) {
+        graph->array[i].head = NULL;
+    }
+    graph->vertices = vertices;
+    graph->directed = directed;
+    graph->allocator = allocator;
+    graph->edgeAllocator = edgeAllocator != NULL ? edgeAllocator : allocator;
+    return graph;
+}
+
+static void pushAdjListNode(GraphList* graph, int src, int dest, int weight) {
+    AdjListNode* newNode = (AdjListNode*)ALLOCATOR_ALLOC(graph->edgeAllocator, sizeof(AdjListNode));
+    if (newNode == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    newNode->dest = dest;
+    newNode->weight = weight;
+    newNode->next = graph->array[src].head;
+    graph->array[src].head = newNode;
+}
+
+void addEdgeList(GraphList* graph, int src, int dest, int weight) {
+    if (src >= 0 && src < graph->vertices && dest >= 0 && dest < graph->vertices) {
+        pushAdjListNode(graph, src, dest, weight);
+        if (!graph->directed) {
+            pushAdjListNode(graph, dest, src, weight);
+        }
+    }
+}
+
+void freeGraphList(GraphList* graph) {
+    Allocator* allocator = graph->allocator;
+    for (int i = 0; i < graph->vertices; i++) {
+        AdjListNode* current = graph->array[i].head;
+        while (current != NULL) {
+            AdjListNode* next = current->next;
+            ALLOCATOR_FREE(graph->edgeAllocator, current, sizeof(AdjListNode));
+            current = next;
+        }
+    }
+    ALLOCATOR_FREE(allocator, graph->array, (size_t)graph->vertices * sizeof(AdjList));
+    ALLOCATOR_FREE(allocator, graph, sizeof(GraphList));
+}
@@ -0,0 +1,98 @@
+/*
+ * allocator_structures.h - List, Tree and Graph on a Pluggable Allocator
+ *
+ * The linked list, binary search tree and adjacency-list graph of
+ * docs/11-data-structures, with an Allocator* (see allocator.h) stored in
+ * each structure. They never call malloc/free themselves, so the same code
+ * runs on malloc, a Pool, an Arena, the size-class allocator or a
+ * DebugAllocator wrapped around any of them:
+ *
+ *   Pool pool;
+ *   poolInit(&pool, sizeof(Node), 1024);
+ *   LinkedList list;
+ *   initList(&list, &pool.base);
+ *   insertAtBeginning(&list, 42);
+ *   freeList(&list);
+ *   poolDestroy(&pool);
+ *
+ * Nodes have the sizes sizeof(Node), sizeof(TreeNode) and
+ * sizeof(AdjListNode), so a Pool of that object size serves them. The graph
+ * also allocates itself and its array of vertex lists, which a Pool cannot
+ * serve, so it takes a second allocator for the edge nodes alone:
+ *
+ *   Pool edges;
+ *   poolInit(&edges, sizeof(AdjListNode), 4096);
+ *   GraphList* graph = createGraphList(1000, false, mallocAllocator(), &edges.base);
+ *
+ * Compile together with allocator_structures.c and allocator.c:
+ *   gcc -O2 -pthread -o program program.c allocator_structures.c allocator.c
+ */
+
+#ifndef ALLOCATOR_STRUCTURES_H
+#define ALLOCATOR_STRUCTURES_H
+
+#include <stdbool.h>
+#include "allocator.h"
+
+// ========== Linked List ==========
+
+typedef struct Node {
+    int data;
+    struct Node* next;
+} Node;
+
+typedef struct {
+    Node* head;
+    int size;
+    Allocator* allocator;
+} LinkedList;
+
+void initList(LinkedList* list, Allocator* allocator);
+void insertAtBeginning(LinkedList* list, int data);
+void freeList(LinkedList* list);
+
+// ========== Binary Search Tree ==========
+
+typedef struct TreeNode {
+    int data;
+    struct TreeNode* left;
+    struct TreeNode* right;
+} TreeNode;
+
+typedef struct {
+    TreeNode* root;
+    int size;
+    Allocator* allocator;
+} BinaryTree;
+
+void initTree(BinaryTree* tree, Allocator* allocator);
+void insertNode(BinaryTree* tree, int data);     // duplicates are ignored
+void freeTree(BinaryTree* tree);
+
+// ========== Adjacency-List Graph ==========
+
+typedef struct AdjListNode {
+    int dest;
+    int weight;
+    struct AdjListNode* next;
+} AdjListNode;
+
+typedef struct {
+    AdjListNode* head;
+} AdjList;
+
+typedef struct {
+    int vertices;
+    AdjList* array;
+    bool directed;
+    Allocator* allocator;       // the GraphList and the array
+    Allocator* edgeAllocator;   // every AdjListNode
+} GraphList;
+
+// The graph and its array come from allocator, the edge nodes from
+// edgeAllocator (NULL = allocator as well)
+GraphList* createGraphList(int vertices, bool directed, Allocator* allocator, Allocator* edgeAllocator);
+void addEdgeList(GraphList* graph, int src, int dest, int weight);
+void freeGraphList(GraphList* graph);
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * large_buffer.c - Huge-Page and NUMA-Aware Allocation (see large_buffer.h)
+ */
+
+#define _GNU_SOURCE
+#include "large_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+static size_t roundUp(size_t size, size_t unit) {
+    return (size + unit - 1) / unit * unit;
+}
+
+const char* pagePolicyName(PagePolicy policy) {
+    switch (policy) {
+    case PAGES_DEFAULT:     return "default";
+    case PAGES_TRANSPARENT: return "transparent";
+    case PAGES_EXPLICIT:    return "explicit";
+    }
+    return "unknown";
+}
+
+// Map 2 MB-aligned memory by over-allocating and trimming both ends
+static void* mapAligned(size_t bytes) {
+    size_t padded = bytes + HUGE_PAGE_SIZE;
+    char* raw = (char*)mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+
+    char* aligned = (char*)roundUp((uintptr_t)raw, HUGE_PAGE_SIZE);
+    size_t head = (size_t)(aligned - raw);
+    size_t tail = padded - head - bytes;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (tail > 0) {
+        munmap(aligned + bytes, tail);
+    }
+    return aligned;
+}
+
+int largeBufferAlloc(LargeBuffer* buffer, size_t bytes, PagePolicy policy) {
+    buffer->data = NULL;
+    buffer->bytes = bytes;
+    buffer->requested = policy;
+
+    if (policy == PAGES_EXPLICIT) {
+        size_t mapped = roundUp(bytes, HUGE_PAGE_SIZE);
+        void* data = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+        if (data != MAP_FAILED) {
+            buffer->data = data;
+            buffer->mappedBytes = mapped;
+            buffer->obtained = PAGES_EXPLICIT;
+            return 0;
+        }
+        // No reserved huge pages: try transparent huge pages instead
+        policy = PAGES_TRANSPARENT;
+    }
+
+    if (policy == PAGES_TRANSPARENT) {
+        size_t mapped = roundUp(bytes, HUGE_PAGE_SIZE);
+        void* data = mapAligned(mapped);
+        if (data != NULL) {
+            buffer->data = data;
+            buffer->mappedBytes = mapped;
+#ifdef MADV_HUGEPAGE
+            buffer->obtained = (madvise(data, mapped, MADV_HUGEPAGE) == 0)
+                               ? PAGES_TRANSPARENT : PAGES_DEFAULT;
+#else
+            buffer->obtained = PAGES_DEFAULT;
+#endif
+            return 0;
+        }
+    }
+
+    size_t mapped = roundUp(bytes, (size_t)sysconf(_SC_PAGESIZE));
+    void* data = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+#ifdef MADV_NOHUGEPAGE
+    // Keep the baseline honest when THP is set to "always"
+    madvise(data, mapped, MADV_NOHUGEPAGE);
+#endif
+    buffer->data = data;
+    buffer->mappedBytes = mapped;
+    buffer->obtained = PAGES_DEFAULT;
+    return 0;
+}
+
+void largeBufferFree(LargeBuffer* buffer) {
+    if (buffer->data != NULL) {
+        munmap(buffer->data, buffer->mappedBytes);
+        buffer->data = NULL;
+    }
+}
+
+void largeBufferSlice(size_t elements, int slices, int index, size_t* begin, size_t* end) {
+    size_t base = elements / (size_t)slices;
+    size_t extra = elements % (size_t)slices;
+    size_t i = (size_t)index;
+    *begin = i * base + (i < extra ? i : extra);
+    *end = *begin + base + (i < extra ? 1 : 0);
+}
+
+typedef struct {
+    char* data;
+    size_t begin;
+    size_t end;
+    int cpu;
+    int pin;
+} TouchArgs;
+
+static void pinToCpu(int cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % cpus, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+}
+
+static void* touchSlice(void* arg) {
+    TouchArgs* args = (TouchArgs*)arg;
+    if (args->pin) {
+        pinToCpu(args->cpu);
+    }
+    memset(args->data + args->begin, 0, args->end - args->begin);
+    return NULL;
+}
+
+// First touch needs a fixed slice-to-thread mapping that matches the later
+// computation, so this uses plain threads rather than a work-stealing pool
+void largeBufferFirstTouch(LargeBuffer* buffer, int threads, int pin) {
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    pthread_t* ids = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    TouchArgs* args = (TouchArgs*)malloc((size_t)threads * sizeof(TouchArgs));
+    if (ids == NULL || args == NULL) {
+        free(ids);
+        free(args);
+        memset(buffer->data, 0, buffer->bytes);
+        return;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        args[t].data = (char*)buffer->data;
+        largeBufferSlice(buffer->bytes, threads, t, &args[t].begin, &args[t].end);
+        args[t].cpu = t;
+        args[t].pin = pin;
+        if (pthread_create(&ids[t], NULL, touchSlice, &args[t]) != 0) {
+            touchSlice(&args[t]);
+            ids[t] = 0;
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        if (ids[t] != 0) {
+            pthread_join(ids[t], NULL);
+        }
+    }
+
+    free(ids);
+    free(args);
+}
+
+// Sum the smaps entries that overlap the buffer
+static void readSmaps(const LargeBuffer* buffer, PageReport* report) {
+    FILE* file = fopen("/proc/self/smaps", "r");
+    if (file == NULL) {
+        return;
+    }
+
+    char line[512];
+    int inRange = 0;
+    uintptr_t target = (uintptr_t)buffer->data;
+    uintptr_t targetEnd = target + buffer->mappedBytes;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            inRange = start < targetEnd && end > target;
+            continue;
+        }
+        if (!inRange) {
+            continue;
+        }
+
+        size_t value;
+        if (sscanf(line, "KernelPageSize: %zu kB", &value) == 1) {
+            report->kernelPageSize = value;
+        } else if (sscanf(line, "Rss: %zu kB", &value) == 1) {
+            report->residentKB += value;
+        } else if (sscanf(line, "AnonHugePages: %zu kB", &value) == 1) {
+            report->hugeKB += value;
+        }
+    }
+    fclose(file);
+
+    // The kernel merges neighbouring anonymous mappings into one entry, so
+    // clamp to this buffer; hugetlb pages are not counted in AnonHugePages
+    size_t mappedKB = buffer->mappedBytes / 1024;
+    if (report->residentKB > mappedKB) {
+        report->residentKB = mappedKB;
+    }
+    if (report->hugeKB > mappedKB) {
+        report->hugeKB = mappedKB;
+    }
+    if (report->kernelPageSize >= 2048 && report->hugeKB == 0) {
+        report->hugeKB = report->residentKB;
+    }
+}
+
+// Ask the kernel which node holds a sample of pages (move_pages with
+// nodes == NULL only queries, it does not move anything)
+static void sampleNumaNodes(const LargeBuffer* buffer, PageReport* report) {
+#ifdef SYS_move_pages
+    enum { SAMPLES = 64 };
+    void* pages[SAMPLES];
+    int status[SAMPLES];
+    size_t step = buffer->mappedBytes / SAMPLES;
+    if (step == 0) {
+        step = 1;
+    }
+
+    int count = 0;
+    for (size_t offset = 0; offset < buffer->mappedBytes && count < SAMPLES; offset += step) {
+        pages[count++] = (char*)buffer->data + offset;
+    }
+    if (syscall(SYS_move_pages, 0, (unsigned long)count, pages, NULL, status, 0) != 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (status[i] >= 0 && status[i] < 8) {
+            report->numaNodes[status[i]]++;
+            report->numaSamples++;
+        }
+    }
+#else
+    (void)buffer;
+    (void)report;
+#endif
+}
+
+void largeBufferReport(const LargeBuffer* buffer, PageReport* report) {
+    memset(report, 0, sizeof(*report));
+    readSmaps(buffer, report);
+    sampleNumaNodes(buffer, report);
+}
@@ -0,0 +1,63 @@
+/*
+ * large_buffer.h - Huge-Page and NUMA-Aware Allocation for Large Arrays
+ *
+ * A malloc'd array of many gigabytes is backed by 4 KB pages: a full scan
+ * needs one TLB entry per 4 KB, and on a multi-socket machine all pages sit
+ * on the node of the thread that happened to touch them first. This module:
+ *
+ * - asks for 2 MB pages, explicitly (MAP_HUGETLB, needs a reserved pool in
+ *   /proc/sys/vm/nr_hugepages) or transparently (madvise(MADV_HUGEPAGE)),
+ *   and falls back step by step down to normal pages
+ * - reports the page size the kernel actually used, read from
+ *   /proc/self/smaps after the memory has been touched
+ * - places pages with first-touch NUMA policy: largeBufferFirstTouch()
+ *   zeroes the buffer from `threads` pinned threads, each touching the
+ *   same contiguous slice it will later compute on (see largeBufferSlice)
+ *
+ * Linux only. Compile together with large_buffer.c:
+ *   gcc -O2 -pthread -o program program.c large_buffer.c
+ */
+
+#ifndef LARGE_BUFFER_H
+#define LARGE_BUFFER_H
+
+#include <stddef.h>
+
+typedef enum {
+    PAGES_DEFAULT,       // plain anonymous mapping, 4 KB pages
+    PAGES_TRANSPARENT,   // madvise(MADV_HUGEPAGE), 2 MB aligned
+    PAGES_EXPLICIT       // MAP_HUGETLB, falls back to PAGES_TRANSPARENT
+} PagePolicy;
+
+typedef struct {
+    void* data;
+    size_t bytes;            // requested size
+    size_t mappedBytes;      // size of the mapping (rounded up)
+    PagePolicy requested;
+    PagePolicy obtained;     // policy that actually succeeded
+} LargeBuffer;
+
+// Returns 0 on success, -1 if even the fallback mapping failed
+int largeBufferAlloc(LargeBuffer* buffer, size_t bytes, PagePolicy policy);
+void largeBufferFree(LargeBuffer* buffer);
+
+// Zero the buffer in parallel so each thread's slice lands on its NUMA
+// node; with pin set, thread t runs on CPU t (modulo the CPU count)
+void largeBufferFirstTouch(LargeBuffer* buffer, int threads, int pin);
+
+// [begin, end) element range of slice `index` out of `slices`
+void largeBufferSlice(size_t elements, int slices, int index, size_t* begin, size_t* end);
+
+typedef struct {
+    size_t kernelPageSize;   // base page size of the mapping (KB), 4 even with THP
+    size_t residentKB;
+    size_t hugeKB;           // memory backed by 2 MB pages (THP or hugetlb)
+    int numaNodes[8];        // sampled pages per NUMA node (nodes 0..7)
+    int numaSamples;
+} PageReport;
+
+// Inspect the mapping after it has been touched
+void largeBufferReport(const LargeBuffer* buffer, PageReport* report);
+const char* pagePolicyName(PagePolicy policy);
+
+#endif
@@ -0,0 +1,283 @@
+/*
+ * batch_calculator.c - Scalar and SIMD Kernels for batch_calculator.h
+ *
+ * The SIMD kernels are written once with GCC vector extensions and
+ * instantiated three times with __attribute__((target(...))): 16-byte
+ * vectors for SSE2, 32 for AVX2 and 64 for AVX-512. The compiler emits the
+ * instructions of that level inside the function only, and the table at
+ * the bottom picks the function the CPU can run, using the feature bits from
+ * ../dispatch/cpu_dispatch.c.
+ *
+ * x86 has no SIMD integer division. int32 division goes through double
+ * (exact for every 32-bit quotient). int64 division uses the scalar kernel
+ * at every level, still with the branch-free zero mask.
+ */
+
+#include "batch_calculator.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// ========== Scalar Kernels ==========
+
+#define SCALAR_KERNEL(name, T, expression)                                   \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        const T* a = (const T*)va;                                           \
+        const T* b = (const T*)vb;                                           \
+        T* out = (T*)vout;                                                   \
+        for (size_t i = 0; i < n; i++) {                                     \
+            T x = a[i];                                                      \
+            T y = b[i];                                                      \
+            out[i] = (expression);                                           \
+        }                                                                    \
+        return 0;                                                            \
+    }
+
+// Integer add/subtract/multiply wrap around instead of overflowing
+SCALAR_KERNEL(scalarAddInt32, int32_t, (int32_t)((uint32_t)x + (uint32_t)y))
+SCALAR_KERNEL(scalarSubInt32, int32_t, (int32_t)((uint32_t)x - (uint32_t)y))
+SCALAR_KERNEL(scalarMulInt32, int32_t, (int32_t)((uint32_t)x * (uint32_t)y))
+SCALAR_KERNEL(scalarAddInt64, int64_t, (int64_t)((uint64_t)x + (uint64_t)y))
+SCALAR_KERNEL(scalarSubInt64, int64_t, (int64_t)((uint64_t)x - (uint64_t)y))
+SCALAR_KERNEL(scalarMulInt64, int64_t, (int64_t)((uint64_t)x * (uint64_t)y))
+SCALAR_KERNEL(scalarAddFloat, float, x + y)
+SCALAR_KERNEL(scalarSubFloat, float, x - y)
+SCALAR_KERNEL(scalarMulFloat, float, x * y)
+SCALAR_KERNEL(scalarAddDouble, double, x + y)
+SCALAR_KERNEL(scalarSubDouble, double, x - y)
+SCALAR_KERNEL(scalarMulDouble, double, x * y)
+
+// Division: `zero` is 1 where the divisor is 0. Those lanes divide by 1
+// and are then masked to 0, so there is no branch and no trap. MIN / -1
+// is computed as a wrapping negation for the same reason.
+#define SCALAR_INT_DIVIDE(name, T, UT)                                       \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        const T* a = (const T*)va;                                           \
+        const T* b = (const T*)vb;                                           \
+        T* out = (T*)vout;                                                   \
+        size_t zeros = 0;                                                    \
+        for (size_t i = 0; i < n; i++) {                                     \
+            T zero = (T)(b[i] == 0);                                         \
+            T divisor = (T)(b[i] + zero);                                    \
+            T quotient = divisor == -1 ? (T)(0 - (UT)a[i]) : a[i] / divisor; \
+            out[i] = quotient & (T)(zero - 1);                               \
+            zeros += (size_t)zero;                                           \
+        }                                                                    \
+        return zeros;                                                        \
+    }
+
+#define SCALAR_FLOAT_DIVIDE(name, T)                                         \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        const T* a = (const T*)va;                                           \
+        const T* b = (const T*)vb;                                           \
+        T* out = (T*)vout;                                                   \
+        size_t zeros = 0;                                                    \
+        for (size_t i = 0; i < n; i++) {                                     \
+            int zero = b[i] == 0;                                            \
+            T quotient = a[i] / (b[i] + (T)zero);                            \
+            out[i] = zero ? (T)0 : quotient;                                 \
+            zeros += (size_t)zero;                                           \
+        }                                                                    \
+        return zeros;                                                        \
+    }
+
+SCALAR_INT_DIVIDE(scalarDivInt32, int32_t, uint32_t)
+SCALAR_INT_DIVIDE(scalarDivInt64, int64_t, uint64_t)
+SCALAR_FLOAT_DIVIDE(scalarDivFloat, float)
+SCALAR_FLOAT_DIVIDE(scalarDivDouble, double)
+
+// ========== SIMD Kernels ==========
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CALC_HAVE_SIMD 1
+
+// V is a vector of T filling one register. Loads and stores go through a
+// typedef with the alignment of T, so the arrays need no extra alignment.
+// The scalar kernel finishes the last n % lanes elements. Integer kernels
+// use unsigned T so that overflow wraps like the scalar ones.
+#define SIMD_ARITHMETIC(name, isa, bytes, T, tail, expression)           \
+    __attribute__((target(isa)))                                          \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        typedef T V __attribute__((vector_size(bytes), aligned(sizeof(T))));  \
+        const T* a = (const T*)va;                                           \
+        const T* b = (const T*)vb;                                           \
+        T* out = (T*)vout;                                                   \
+        const size_t lanes = (bytes) / sizeof(T);                            \
+        size_t i = 0;                                                        \
+        for (; i + lanes <= n; i += lanes) {                                 \
+            V x = *(const V*)(a + i);                                        \
+            V y = *(const V*)(b + i);                                        \
+            *(V*)(out + i) = (expression);                                   \
+        }                                                                    \
+        return tail(a + i, b + i, out + i, n - i);                           \
+    }
+
+// A comparison returns an integer vector M with -1 in every lane where it
+// holds. Zero divisors become 1 (y - (-1)), and the quotient is cleared
+// with ~mask. Subtracting the mask also counts the zero lanes.
+#define SIMD_FLOAT_DIVIDE(name, isa, bytes, T, M_T, tail)                \
+    __attribute__((target(isa)))                                          \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        typedef T V __attribute__((vector_size(bytes), aligned(sizeof(T))));  \
+        typedef M_T M __attribute__((vector_size(bytes)));                    \
+        const T* a = (const T*)va;                                           \
+        const T* b = (const T*)vb;                                           \
+        T* out = (T*)vout;                                                   \
+        const size_t lanes = (bytes) / sizeof(T);                            \
+        M zeros = { 0 };                                                     \
+        size_t i = 0;                                                        \
+        for (; i + lanes <= n; i += lanes) {                                 \
+            V x = *(const V*)(a + i);                                        \
+            V y = *(const V*)(b + i);                                        \
+            M zero = (M)(y == 0);                                            \
+            V quotient = x / (y - __builtin_convertvector(zero, V));         \
+            *(V*)(out + i) = (V)((M)quotient & ~zero);                       \
+            zeros -= zero;                                                   \
+        }                                                                    \
+        size_t count = tail(a + i, b + i, out + i, n - i);                   \
+        for (size_t lane = 0; lane < lanes; lane++) {                        \
+            count += (size_t)zeros[lane];                                    \
+        }                                                                    \
+        return count;                                                        \
+    }
+
+// int32 division in double precision: both operands convert exactly and
+// truncating the double quotient gives the C result. INT32_MIN / -1
+// converts out of range, which x86 turns into INT32_MIN (the wrapped value).
+#define SIMD_INT32_DIVIDE(name, isa, bytes)                               \
+    __attribute__((target(isa)))                                          \
+    static size_t name(const void* va, const void* vb, void* vout, size_t n) { \
+        typedef int32_t V __attribute__((vector_size(bytes), aligned(4)));    \
+        typedef double W __attribute__((vector_size(bytes * 2)));             \
+        const int32_t* a = (const int32_t*)va;                               \
+        const int32_t* b = (const int32_t*)vb;                               \
+        int32_t* out = (int32_t*)vout;                                       \
+        const size_t lanes = (bytes) / sizeof(int32_t);                      \
+        V zeros = { 0 };                                                     \
+        size_t i = 0;                                                        \
+        for (; i + lanes <= n; i += lanes) {                                 \
+            V x = *(const V*)(a + i);                                        \
+            V y = *(const V*)(b + i);                                        \
+            V zero = y == 0;                                                 \
+            W quotient = __builtin_convertvector(x, W) /                     \
+                         __builtin_convertvector(y - zero, W);               \
+            *(V*)(out + i) = __builtin_convertvector(quotient, V) & ~zero;   \
+            zeros -= zero;                                                   \
+        }                                                                    \
+        size_t count = scalarDivInt32(a + i, b + i, out + i, n - i);         \
+        for (size_t lane = 0; lane < lanes; lane++) {                        \
+            count += (size_t)zeros[lane];                                    \
+        }                                                                    \
+        return count;                                                        \
+    }
+
+// Instantiate every kernel for one instruction set
+#define SIMD_LEVEL(suffix, isa, bytes)                                                         \
+    SIMD_ARITHMETIC(addInt32##suffix, isa, bytes, uint32_t, scalarAddInt32, x + y)             \
+    SIMD_ARITHMETIC(subInt32##suffix, isa, bytes, uint32_t, scalarSubInt32, x - y)             \
+    SIMD_ARITHMETIC(mulInt32##suffix, isa, bytes, uint32_t, scalarMulInt32, x * y)             \
+    SIMD_INT32_DIVIDE(divInt32##suffix, isa, bytes)                                            \
+    SIMD_ARITHMETIC(addInt64##suffix, isa, bytes, uint64_t, scalarAddInt64, x + y)             \
+    SIMD_ARITHMETIC(subInt64##suffix, isa, bytes, uint64_t, scalarSubInt64, x - y)             \
+    SIMD_ARITHMETIC(mulInt64##suffix, isa, bytes, uint64_t, scalarMulInt64, x * y)             \
+    SIMD_ARITHMETIC(addFloat##suffix, isa, bytes, float, scalarAddFloat, x + y)                \
+    SIMD_ARITHMETIC(subFloat##suffix, isa, bytes, float, scalarSubFloat, x - y)                \
+    SIMD_ARITHMETIC(mulFloat##suffix, isa, bytes, float, scalarMulFloat, x * y)                \
+    SIMD_FLOAT_DIVIDE(divFloat##suffix, isa, bytes, float, int32_t, scalarDivFloat)            \
+    SIMD_ARITHMETIC(addDouble##suffix, isa, bytes, double, scalarAddDouble, x + y)             \
+    SIMD_ARITHMETIC(subDouble##suffix, isa, bytes, double, scalarSubDouble, x - y)             \
+    SIMD_ARITHMETIC(mulDouble##suffix, isa, bytes, double, scalarMulDouble, x * y)             \
+    SIMD_FLOAT_DIVIDE(divDouble##suffix, isa, bytes, double, int64_t, scalarDivDouble)
+
+SIMD_LEVEL(Sse2, "sse2", 16)
+SIMD_LEVEL(Avx2, "avx2", 32)
+SIMD_LEVEL(Avx512, "avx512f,avx512dq", 64)
+
+#define LEVEL_ROW(suffix) {                                                          \
+    { addInt32##suffix,  subInt32##suffix,  mulInt32##suffix,  divInt32##suffix },  \
+    { addInt64##suffix,  subInt64##suffix,  mulInt64##suffix,  scalarDivInt64 },    \
+    { addFloat##suffix,  subFloat##suffix,  mulFloat##suffix,  divFloat##suffix },  \
+    { addDouble##suffix, subDouble##suffix, mulDouble##suffix, divDouble##suffix }, \
+}
+#endif
+
+// ========== Dispatch ==========
+
+#define SCALAR_ROW {                                                            \
+    { scalarAddInt32,  scalarSubInt32,  scalarMulInt32,  scalarDivInt32 },     \
+    { scalarAddInt64,  scalarSubInt64,  scalarMulInt64,  scalarDivInt64 },     \
+    { scalarAddFloat,  scalarSubFloat,  scalarMulFloat,  scalarDivFloat },     \
+    { scalarAddDouble, scalarSubDouble, scalarMulDouble, scalarDivDouble },    \
+}
+
+static const BatchKernel kernelTable[CALC_LEVEL_COUNT][CALC_TYPE_COUNT][CALC_OP_COUNT] = {
+#ifdef CALC_HAVE_SIMD
+    SCALAR_ROW, LEVEL_ROW(Sse2), LEVEL_ROW(Avx2), LEVEL_ROW(Avx512)
+#else
+    SCALAR_ROW, SCALAR_ROW, SCALAR_ROW, SCALAR_ROW
+#endif
+};
+
+static atomic_int activeLevel = -1;
+
+// Uses the shared feature detection, so CPU_DISPATCH (e.g. "-avx512f")
+// also limits the calculator
+CalcLevel batchDetectLevel(void) {
+#ifdef CALC_HAVE_SIMD
+    if (cpuHas(CPU_AVX512F | CPU_AVX512DQ)) {
+        return CALC_AVX512;
+    }
+    if (cpuHas(CPU_AVX2)) {
+        return CALC_AVX2;
+    }
+    if (cpuHas(CPU_SSE2)) {
+        return CALC_SSE2;
+    }
+#endif
+    return CALC_SCALAR;
+}
+
+CalcLevel batchActiveLevel(void) {
+    int level = atomic_load_explicit(&activeLevel, memory_order_relaxed);
+    if (level < 0) {
+        level = (int)batchDetectLevel();
+        atomic_store_explicit(&activeLevel, level, memory_order_relaxed);
+    }
+    return (CalcLevel)level;
+}
+
+int batchSetLevel(CalcLevel level) {
+    if (level < CALC_SCALAR || level > batchDetectLevel()) {
+        return -1;
+    }
+    atomic_store_explicit(&activeLevel, (int)level, memory_order_relaxed);
+    return 0;
+}
+
+BatchKernel batchKernel(CalcOp op, CalcType type) {
+    if ((unsigned)op >= CALC_OP_COUNT || (unsigned)type >= CALC_TYPE_COUNT) {
+        return NULL;
+    }
+    return kernelTable[batchActiveLevel()][type][op];
+}
+
+size_t batchCompute(CalcOp op, CalcType type, const void* a, const void* b, void* out, size_t n) {
+    BatchKernel kernel = batchKernel(op, type);
+    return kernel != NULL ? kernel(a, b, out, n) : 0;
+}
+
+const char* calcLevelName(CalcLevel level) {
+    static const char* names[] = { "scalar", "sse2", "avx2", "avx512" };
+    return (unsigned)level < CALC_LEVEL_COUNT ? names[level] : "unknown";
+}
+
+const char* calcTypeName(CalcType type) {
+    static const char* names[] = { "int32", "int64", "float", "double" };
+    return (unsigned)type < CALC_TYPE_COUNT ? names[type] : "unknown";
+}
+
+size_t calcTypeSize(CalcType type) {
+    static const size_t sizes[] = { sizeof(int32_t), sizeof(int64_t), sizeof(float), sizeof(double) };
+    return (unsigned)type < CALC_TYPE_COUNT ? sizes[type] : 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * batch_calculator.h - Array-at-a-Time Arithmetic Through a Kernel Table
+ *
+ * temp_function_pointer.c calls `int (*operation)(int, int)` once per pair
+ * of numbers. Over a large array that is one indirect call per element,
+ * and the compiler cannot vectorize across it. This API moves the function
+ * pointer one level up: the kernel for (operation, element type) is looked
+ * up once, and the kernel processes the whole array with SIMD.
+ *
+ * - Operations: add, subtract, multiply, divide
+ * - Types: int32, int64, float, double
+ * - Kernels: scalar, SSE2, AVX2 and AVX-512, the best one the CPU supports
+ *   is chosen at runtime (CPU_DISPATCH can restrict it, see
+ *   ../dispatch/cpu_dispatch.h), so one binary runs on any x86-64 machine
+ * - Division by zero is handled per lane with a mask, not a branch: the
+ *   result is 0 (like divide() in temp_function_pointer.c) and the kernel
+ *   returns how many divisors were zero
+ *
+ * Compile together with batch_calculator.c and the shared CPU detection:
+ *   gcc -O2 -o program program.c batch_calculator.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef BATCH_CALCULATOR_H
+#define BATCH_CALCULATOR_H
+
+#include <stddef.h>
+
+typedef enum {
+    CALC_ADD,
+    CALC_SUBTRACT,
+    CALC_MULTIPLY,
+    CALC_DIVIDE,
+    CALC_OP_COUNT
+} CalcOp;
+
+typedef enum {
+    CALC_INT32,
+    CALC_INT64,
+    CALC_FLOAT,
+    CALC_DOUBLE,
+    CALC_TYPE_COUNT
+} CalcType;
+
+typedef enum {
+    CALC_SCALAR,
+    CALC_SSE2,
+    CALC_AVX2,
+    CALC_AVX512,
+    CALC_LEVEL_COUNT
+} CalcLevel;
+
+// out[i] = a[i] op b[i] for i < n; returns the number of zero divisors
+// (always 0 for add/subtract/multiply). out may alias a or b.
+typedef size_t (*BatchKernel)(const void* a, const void* b, void* out, size_t n);
+
+// Best level this CPU supports
+CalcLevel batchDetectLevel(void);
+
+// Level used by batchKernel/batchCompute (detected on first use)
+CalcLevel batchActiveLevel(void);
+
+// Force a level, e.g. to compare them; returns -1 if the CPU lacks it
+int batchSetLevel(CalcLevel level);
+
+// Look up the kernel once, then call it for every batch
+BatchKernel batchKernel(CalcOp op, CalcType type);
+size_t batchCompute(CalcOp op, CalcType type, const void* a, const void* b, void* out, size_t n);
+
+const char* calcLevelName(CalcLevel level);
+const char* calcTypeName(CalcType type);
+size_t calcTypeSize(CalcType type);
+
+#endif
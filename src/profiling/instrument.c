@@ -0,0 +1,561 @@
+/*
+ * instrument.c - Scoped Timers, Latency Histograms and Hardware Counters (see instrument.h)
+ */
+
+#define _GNU_SOURCE
+#include "instrument.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CALIBRATION_NS 10000000   // shortest interval to compare ticks against the clock
+#define OVERHEAD_ROUNDS 100000
+
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static ProfileRegion* firstRegion = NULL;
+static ProfileRegion* lastRegion = NULL;
+
+static _Atomic uint64_t usedThreadIndices[PROFILE_MAX_THREADS / 64];
+static atomic_ullong droppedCalls;     // from threads beyond PROFILE_MAX_THREADS
+static pthread_key_t threadKey;
+static _Thread_local int threadIndex = -1;
+
+static _Thread_local int counterFds[PROFILE_EVENT_COUNT] = { -2, -2, -2, -2 };   // -2: not opened yet
+static atomic_int countersOpened;      // threads that opened their counters
+static atomic_int counterError;        // errno of the first failure
+
+static uint64_t baseTicks;
+static struct timespec baseTime;
+static char* outputPath = NULL;
+
+// ========== Threads ==========
+
+static void closeCounters(void) {
+    for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+        if (counterFds[e] >= 0) {
+            close(counterFds[e]);
+        }
+        counterFds[e] = -2;
+    }
+}
+
+// Runs when a thread that recorded exits: its slots go to the next thread
+static void releaseThreadIndex(void* value) {
+    int index = (int)(intptr_t)value - 1;
+    closeCounters();
+    atomic_fetch_and(&usedThreadIndices[index / 64], ~(1ull << (index % 64)));
+}
+
+static int acquireThreadIndex(void) {
+    for (int w = 0; w < PROFILE_MAX_THREADS / 64; w++) {
+        uint64_t used = atomic_load(&usedThreadIndices[w]);
+        while (used != UINT64_MAX) {
+            int bit = __builtin_ctzll(~used);
+            if (atomic_compare_exchange_weak(&usedThreadIndices[w], &used, used | (1ull << bit))) {
+                threadIndex = w * 64 + bit;
+                pthread_setspecific(threadKey, (void*)(intptr_t)(threadIndex + 1));
+                return threadIndex;
+            }
+        }
+    }
+    threadIndex = PROFILE_MAX_THREADS;   // all taken: this thread is not recorded
+    return threadIndex;
+}
+
+// ========== Recording ==========
+
+// Values below 32 have a bucket each; above, every power of two is split
+// into 32 buckets by the 5 bits below the leading one
+static inline size_t bucketIndex(uint64_t ticks) {
+    if (ticks < (1u << PROFILE_SUB_BITS)) {
+        return (size_t)ticks;
+    }
+    int magnitude = 63 - __builtin_clzll(ticks);
+    int shift = magnitude - PROFILE_SUB_BITS;
+    if (shift >= PROFILE_MAGNITUDES) {
+        return PROFILE_BUCKETS - 1;
+    }
+    return ((size_t)(shift + 1) << PROFILE_SUB_BITS) + ((ticks >> shift) & ((1u << PROFILE_SUB_BITS) - 1));
+}
+
+// The largest value that lands in bucket `index`
+static uint64_t bucketLimit(size_t index) {
+    if (index < (1u << PROFILE_SUB_BITS)) {
+        return index;
+    }
+    int shift = (int)(index >> PROFILE_SUB_BITS) - 1;
+    uint64_t sub = index & ((1u << PROFILE_SUB_BITS) - 1);
+    return (((1ull << PROFILE_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+// Only the owning thread writes a slot, so a load and a store suffice
+static inline void addTo(_Atomic uint64_t* field, uint64_t value) {
+    atomic_store_explicit(field, atomic_load_explicit(field, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static void registerRegion(ProfileRegion* region) {
+    pthread_mutex_lock(&registryLock);
+    if (!atomic_load(&region->registered)) {
+        if (lastRegion == NULL) {
+            firstRegion = region;
+        } else {
+            lastRegion->next = region;
+        }
+        lastRegion = region;
+        atomic_store_explicit(&region->registered, true, memory_order_release);
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+static ProfileSlot* createSlot(ProfileRegion* region, int index) {
+    ProfileSlot* slot = calloc(1, sizeof(ProfileSlot));
+    if (slot == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    atomic_init(&slot->minTicks, UINT64_MAX);
+    atomic_store_explicit(&region->slots[index], slot, memory_order_release);
+    return slot;
+}
+
+void profileRecord(ProfileRegion* region, uint64_t ticks, const uint64_t* events) {
+    if (!atomic_load_explicit(&region->registered, memory_order_acquire)) {
+        registerRegion(region);
+    }
+    int index = (threadIndex >= 0) ? threadIndex : acquireThreadIndex();
+    if (index == PROFILE_MAX_THREADS) {
+        atomic_fetch_add_explicit(&droppedCalls, 1, memory_order_relaxed);
+        return;
+    }
+    ProfileSlot* slot = atomic_load_explicit(&region->slots[index], memory_order_relaxed);
+    if (slot == NULL && (slot = createSlot(region, index)) == NULL) {
+        return;
+    }
+
+    addTo(&slot->calls, 1);
+    addTo(&slot->totalTicks, ticks);
+    if (ticks < atomic_load_explicit(&slot->minTicks, memory_order_relaxed)) {
+        atomic_store_explicit(&slot->minTicks, ticks, memory_order_relaxed);
+    }
+    if (ticks > atomic_load_explicit(&slot->maxTicks, memory_order_relaxed)) {
+        atomic_store_explicit(&slot->maxTicks, ticks, memory_order_relaxed);
+    }
+    addTo(&slot->buckets[bucketIndex(ticks)], 1);
+    if (events != NULL) {
+        addTo(&slot->countedCalls, 1);
+        for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+            addTo(&slot->events[e], events[e]);
+        }
+    }
+}
+
+// ========== Hardware Counters ==========
+
+static const uint64_t eventConfigs[PROFILE_EVENT_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static const char* eventNames[PROFILE_EVENT_COUNT] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+// One group per thread, counting this thread in user space only, so it
+// works with the default perf_event_paranoid = 2
+static void openCounters(void) {
+    for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = eventConfigs[e];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        int groupFd = (e == 0) ? -1 : counterFds[0];
+        counterFds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+        if (counterFds[e] < 0) {
+            int expected = 0;
+            atomic_compare_exchange_strong(&counterError, &expected, errno);
+            closeCounters();
+            counterFds[0] = -1;   // do not try again on this thread
+            return;
+        }
+    }
+    atomic_fetch_add(&countersOpened, 1);
+}
+
+bool profileReadCounters(uint64_t* events) {
+    if (counterFds[0] == -2) {
+        openCounters();
+    }
+    if (counterFds[0] < 0) {
+        return false;
+    }
+    struct {
+        uint64_t count;
+        uint64_t values[PROFILE_EVENT_COUNT];
+    } group;
+    if (read(counterFds[0], &group, sizeof(group)) != (ssize_t)sizeof(group)) {
+        return false;
+    }
+    memcpy(events, group.values, sizeof(group.values));
+    return true;
+}
+
+const char* profileCounterStatus(void) {
+    static char message[160];
+    int error = atomic_load(&counterError);
+    if (atomic_load(&countersOpened) > 0) {
+        return "available";
+    }
+    if (error == 0) {
+        return "not used";
+    }
+    snprintf(message, sizeof(message), "unavailable: %s (see /proc/sys/kernel/perf_event_paranoid)", strerror(error));
+    return message;
+}
+
+// ========== Calibration ==========
+
+static double nanosecondsSince(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+}
+
+// Ticks are compared with the clock over the whole run so far, so the
+// longer the program runs the more exact the conversion becomes
+double profileTicksPerNs(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec now;
+    uint64_t ticks;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ticks = profileTicks();
+    } while (nanosecondsSince(baseTime, now) < CALIBRATION_NS);
+    return (double)(ticks - baseTicks) / nanosecondsSince(baseTime, now);
+#else
+    return 1.0;
+#endif
+}
+
+double profileTimerOverheadNs(void) {
+    static ProfileRegion overhead = { .name = "overhead", .registered = true };   // never listed
+    uint64_t start = profileTicks();
+    for (int i = 0; i < OVERHEAD_ROUNDS; i++) {
+        ProfileTimer timer = profileTimerBegin(&overhead);
+        profileTimerEnd(&timer);
+    }
+    uint64_t ticks = profileTicks() - start;
+    return (double)ticks / OVERHEAD_ROUNDS / profileTicksPerNs();
+}
+
+// ========== Results ==========
+
+typedef struct {
+    const char* name;
+    bool counters;
+    uint64_t calls;
+    uint64_t totalTicks;
+    uint64_t minTicks;
+    uint64_t maxTicks;
+    uint64_t countedCalls;
+    uint64_t events[PROFILE_EVENT_COUNT];
+    uint64_t buckets[PROFILE_BUCKETS];
+} Aggregate;
+
+static void mergeSlot(Aggregate* aggregate, ProfileSlot* slot) {
+    aggregate->calls += atomic_load_explicit(&slot->calls, memory_order_relaxed);
+    aggregate->totalTicks += atomic_load_explicit(&slot->totalTicks, memory_order_relaxed);
+    uint64_t minTicks = atomic_load_explicit(&slot->minTicks, memory_order_relaxed);
+    uint64_t maxTicks = atomic_load_explicit(&slot->maxTicks, memory_order_relaxed);
+    aggregate->minTicks = (minTicks < aggregate->minTicks) ? minTicks : aggregate->minTicks;
+    aggregate->maxTicks = (maxTicks > aggregate->maxTicks) ? maxTicks : aggregate->maxTicks;
+    aggregate->countedCalls += atomic_load_explicit(&slot->countedCalls, memory_order_relaxed);
+    for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+        aggregate->events[e] += atomic_load_explicit(&slot->events[e], memory_order_relaxed);
+    }
+    for (size_t b = 0; b < PROFILE_BUCKETS; b++) {
+        aggregate->buckets[b] += atomic_load_explicit(&slot->buckets[b], memory_order_relaxed);
+    }
+}
+
+// Every region merged by name, in order of first use; NULL with *count 0
+// when nothing was recorded
+static Aggregate* aggregateRegions(size_t* count) {
+    *count = 0;
+    pthread_mutex_lock(&registryLock);
+    size_t regionCount = 0;
+    for (ProfileRegion* region = firstRegion; region != NULL; region = region->next) {
+        regionCount++;
+    }
+    Aggregate* aggregates = (regionCount > 0) ? calloc(regionCount, sizeof(Aggregate)) : NULL;
+    if (regionCount > 0 && aggregates == NULL) {
+        printf("Memory allocation failed\n");
+    }
+    for (ProfileRegion* region = firstRegion; region != NULL && aggregates != NULL; region = region->next) {
+        size_t a = 0;
+        while (a < *count && strcmp(aggregates[a].name, region->name) != 0) {
+            a++;
+        }
+        if (a == *count) {
+            aggregates[a].name = region->name;
+            aggregates[a].minTicks = UINT64_MAX;
+            (*count)++;
+        }
+        aggregates[a].counters |= region->counters;
+        for (int t = 0; t < PROFILE_MAX_THREADS; t++) {
+            ProfileSlot* slot = atomic_load_explicit(&region->slots[t], memory_order_acquire);
+            if (slot != NULL) {
+                mergeSlot(&aggregates[a], slot);
+            }
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+    return aggregates;
+}
+
+// The smallest bucket limit with at least q of the calls at or below it
+static uint64_t quantileTicks(const Aggregate* aggregate, double q) {
+    uint64_t rank = (uint64_t)(q * (double)aggregate->calls + 0.999999);
+    rank = (rank == 0) ? 1 : rank;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < PROFILE_BUCKETS; b++) {
+        seen += aggregate->buckets[b];
+        if (seen >= rank) {
+            uint64_t limit = bucketLimit(b);
+            return (limit < aggregate->maxTicks) ? limit : aggregate->maxTicks;
+        }
+    }
+    return aggregate->maxTicks;
+}
+
+static void summarize(const Aggregate* aggregate, double ticksPerNs, ProfileSummary* summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->name = aggregate->name;
+    summary->counters = aggregate->counters;
+    summary->calls = aggregate->calls;
+    summary->countedCalls = aggregate->countedCalls;
+    memcpy(summary->events, aggregate->events, sizeof(summary->events));
+    if (aggregate->calls == 0) {
+        return;
+    }
+    summary->totalNs = (double)aggregate->totalTicks / ticksPerNs;
+    summary->meanNs = summary->totalNs / (double)aggregate->calls;
+    summary->minNs = (double)aggregate->minTicks / ticksPerNs;
+    summary->maxNs = (double)aggregate->maxTicks / ticksPerNs;
+    summary->p50Ns = (double)quantileTicks(aggregate, 0.50) / ticksPerNs;
+    summary->p90Ns = (double)quantileTicks(aggregate, 0.90) / ticksPerNs;
+    summary->p99Ns = (double)quantileTicks(aggregate, 0.99) / ticksPerNs;
+    summary->p999Ns = (double)quantileTicks(aggregate, 0.999) / ticksPerNs;
+}
+
+size_t profileSummaries(ProfileSummary* summaries, size_t capacity) {
+    size_t count;
+    Aggregate* aggregates = aggregateRegions(&count);
+    double ticksPerNs = profileTicksPerNs();
+    size_t written = (count < capacity) ? count : capacity;
+    for (size_t a = 0; a < written; a++) {
+        summarize(&aggregates[a], ticksPerNs, &summaries[a]);
+    }
+    free(aggregates);
+    return written;
+}
+
+double profileQuantile(const char* name, double q) {
+    size_t count;
+    Aggregate* aggregates = aggregateRegions(&count);
+    double result = -1;
+    for (size_t a = 0; a < count; a++) {
+        if (strcmp(aggregates[a].name, name) == 0 && aggregates[a].calls > 0) {
+            result = (double)quantileTicks(&aggregates[a], q) / profileTicksPerNs();
+        }
+    }
+    free(aggregates);
+    return result;
+}
+
+void profileReset(void) {
+    pthread_mutex_lock(&registryLock);
+    for (ProfileRegion* region = firstRegion; region != NULL; region = region->next) {
+        for (int t = 0; t < PROFILE_MAX_THREADS; t++) {
+            ProfileSlot* slot = atomic_load_explicit(&region->slots[t], memory_order_acquire);
+            if (slot == NULL) {
+                continue;
+            }
+            atomic_store_explicit(&slot->calls, 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->totalTicks, 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->minTicks, UINT64_MAX, memory_order_relaxed);
+            atomic_store_explicit(&slot->maxTicks, 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->countedCalls, 0, memory_order_relaxed);
+            for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+                atomic_store_explicit(&slot->events[e], 0, memory_order_relaxed);
+            }
+            for (size_t b = 0; b < PROFILE_BUCKETS; b++) {
+                atomic_store_explicit(&slot->buckets[b], 0, memory_order_relaxed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+    atomic_store(&droppedCalls, 0);
+}
+
+// ========== Output ==========
+
+// "812 ns", "12.4 us", "3.21 ms", "1.20 s"
+static const char* formatNs(double ns, char* buffer, size_t size) {
+    if (ns < 1e3) {
+        snprintf(buffer, size, "%.0f ns", ns);
+    } else if (ns < 1e6) {
+        snprintf(buffer, size, "%.3g us", ns / 1e3);
+    } else if (ns < 1e9) {
+        snprintf(buffer, size, "%.3g ms", ns / 1e6);
+    } else {
+        snprintf(buffer, size, "%.3g s", ns / 1e9);
+    }
+    return buffer;
+}
+
+static void writeJsonString(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+void profilePrint(FILE* out) {
+    size_t count;
+    Aggregate* aggregates = aggregateRegions(&count);
+    double ticksPerNs = profileTicksPerNs();
+    bool anyCounted = false;
+    for (size_t a = 0; a < count; a++) {
+        anyCounted |= aggregates[a].countedCalls > 0;
+    }
+
+    fprintf(out, "%-26s %10s %10s %10s %10s %10s %10s", "Region", "calls", "total", "mean", "p50", "p99", "max");
+    fprintf(out, anyCounted ? " %6s %12s %12s\n" : "\n", "IPC", "cache miss", "branch miss");
+    for (size_t a = 0; a < count; a++) {
+        ProfileSummary s;
+        summarize(&aggregates[a], ticksPerNs, &s);
+        char total[16], mean[16], p50[16], p99[16], max[16];
+        fprintf(out, "%-26s %10llu %10s %10s %10s %10s %10s", s.name, (unsigned long long)s.calls,
+                formatNs(s.totalNs, total, sizeof(total)), formatNs(s.meanNs, mean, sizeof(mean)),
+                formatNs(s.p50Ns, p50, sizeof(p50)), formatNs(s.p99Ns, p99, sizeof(p99)),
+                formatNs(s.maxNs, max, sizeof(max)));
+        if (s.countedCalls > 0 && s.events[PROFILE_CYCLES] > 0) {
+            // misses per call
+            fprintf(out, " %6.2f %12.1f %12.1f", (double)s.events[PROFILE_INSTRUCTIONS] / (double)s.events[PROFILE_CYCLES],
+                    (double)s.events[PROFILE_CACHE_MISSES] / (double)s.countedCalls,
+                    (double)s.events[PROFILE_BRANCH_MISSES] / (double)s.countedCalls);
+        }
+        fprintf(out, "\n");
+    }
+    if (atomic_load(&droppedCalls) > 0) {
+        fprintf(out, "(%llu calls from threads beyond %d not recorded)\n",
+                (unsigned long long)atomic_load(&droppedCalls), PROFILE_MAX_THREADS);
+    }
+    free(aggregates);
+}
+
+void profileWriteJson(FILE* out) {
+    size_t count;
+    Aggregate* aggregates = aggregateRegions(&count);
+    double ticksPerNs = profileTicksPerNs();
+    fprintf(out, "{\n  \"ticks_per_ns\": %.6f,\n  \"counters\": ", ticksPerNs);
+    writeJsonString(out, profileCounterStatus());
+    fprintf(out, ",\n  \"dropped_calls\": %llu,\n  \"regions\": [", (unsigned long long)atomic_load(&droppedCalls));
+    for (size_t a = 0; a < count; a++) {
+        ProfileSummary s;
+        summarize(&aggregates[a], ticksPerNs, &s);
+        fprintf(out, "%s\n    {\"name\": ", a == 0 ? "" : ",");
+        writeJsonString(out, s.name);
+        fprintf(out, ", \"calls\": %llu, \"total_ns\": %.1f, \"mean_ns\": %.1f, \"min_ns\": %.1f, "
+                "\"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"p999_ns\": %.1f, \"max_ns\": %.1f",
+                (unsigned long long)s.calls, s.totalNs, s.meanNs, s.minNs, s.p50Ns, s.p90Ns, s.p99Ns, s.p999Ns, s.maxNs);
+        if (s.counters) {
+            fprintf(out, ", \"counted_calls\": %llu", (unsigned long long)s.countedCalls);
+            for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+                fprintf(out, ", \"%s\": %llu", eventNames[e], (unsigned long long)s.events[e]);
+            }
+        }
+        // [upper limit in ns, calls] for every non-empty bucket
+        fprintf(out, ",\n     \"histogram\": [");
+        bool first = true;
+        for (size_t b = 0; b < PROFILE_BUCKETS; b++) {
+            if (aggregates[a].buckets[b] > 0) {
+                fprintf(out, "%s[%.1f, %llu]", first ? "" : ", ", (double)bucketLimit(b) / ticksPerNs,
+                        (unsigned long long)aggregates[a].buckets[b]);
+                first = false;
+            }
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    free(aggregates);
+}
+
+void profileWriteCsv(FILE* out) {
+    size_t count;
+    Aggregate* aggregates = aggregateRegions(&count);
+    double ticksPerNs = profileTicksPerNs();
+    fprintf(out, "region,calls,total_ns,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,counted_calls");
+    for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+        fprintf(out, ",%s", eventNames[e]);
+    }
+    fprintf(out, "\n");
+    for (size_t a = 0; a < count; a++) {
+        ProfileSummary s;
+        summarize(&aggregates[a], ticksPerNs, &s);
+        fprintf(out, "\"%s\",%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%llu", s.name, (unsigned long long)s.calls,
+                s.totalNs, s.meanNs, s.minNs, s.p50Ns, s.p90Ns, s.p99Ns, s.p999Ns, s.maxNs,
+                (unsigned long long)s.countedCalls);
+        for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+            fprintf(out, ",%llu", (unsigned long long)s.events[e]);
+        }
+        fprintf(out, "\n");
+    }
+    free(aggregates);
+}
+
+bool profileWriteFile(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    const char* extension = strrchr(path, '.');
+    if (extension != NULL && strcmp(extension, ".json") == 0) {
+        profileWriteJson(out);
+    } else if (extension != NULL && strcmp(extension, ".csv") == 0) {
+        profileWriteCsv(out);
+    } else {
+        profilePrint(out);
+    }
+    return fclose(out) == 0;
+}
+
+static void writeOutputAtExit(void) {
+    profileWriteFile(outputPath);
+}
+
+__attribute__((constructor)) static void profileInit(void) {
+    clock_gettime(CLOCK_MONOTONIC, &baseTime);
+    baseTicks = profileTicks();
+    pthread_key_create(&threadKey, releaseThreadIndex);
+    const char* path = getenv("PROFILE_OUTPUT");
+    if (path != NULL && path[0] != '\0' && (outputPath = strdup(path)) != NULL) {
+        atexit(writeOutputAtExit);
+    }
+}
@@ -0,0 +1,212 @@
+/*
+ * instrument.h - Scoped Timers, Latency Histograms and Hardware Counters
+ *
+ * The programs in this repo time themselves with clock_gettime() around a
+ * whole benchmark, which says how long a run took but not which phase got
+ * slower, or whether a slow call was one outlier or every call. This module
+ * puts named regions into library code:
+ *
+ * - PROFILE_SCOPE("name") at the start of a block times the rest of it
+ *   with the time-stamp counter (two rdtsc, ~25 cycles each on bare metal,
+ *   more in some VMs), converted to nanoseconds against CLOCK_MONOTONIC
+ *   over the whole run
+ * - every region keeps an HDR-style latency histogram: 32 buckets per
+ *   power of two, so any percentile is within 3% of the true value, for
+ *   latencies from one cycle to hours, in fixed memory
+ * - each thread records into its own slot of the region with plain stores
+ *   (no locked instructions, no shared cache lines); slots are merged when
+ *   results are read
+ * - PROFILE_SCOPE_COUNTERS("name") also counts cycles, instructions, cache
+ *   misses and branch misses with perf_event_open(2), one group per thread.
+ *   Reading them is a system call, so use it on regions of a few
+ *   microseconds or more; without permission the timer still works
+ * - results are printed as a table, or written as JSON or CSV; setting
+ *   PROFILE_OUTPUT=path.json (or .csv) writes them when the program exits
+ *
+ * The macros compile to nothing unless INSTRUMENT is defined, so library
+ * code keeps its regions in release builds at no cost:
+ *
+ *   void csrBuildPhase(...) {
+ *       PROFILE_SCOPE("graph.sortBuckets");
+ *       ...
+ *   }
+ *
+ *   gcc -O2 -DINSTRUMENT -pthread -o program program.c library.c instrument.c
+ *   PROFILE_OUTPUT=profile.json ./program
+ *
+ * A region is a static variable at its call site and registers itself on
+ * first use; sites with the same name are merged in the results. Linux and
+ * GCC/Clang (__attribute__((cleanup))). Compile together with instrument.c:
+ *   gcc -O2 -DINSTRUMENT -pthread -o program program.c instrument.c
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define PROFILE_MAX_THREADS 256      // threads recording at once; exited threads free their slot
+#define PROFILE_SUB_BITS 5           // 2^5 buckets per power of two
+#define PROFILE_MAGNITUDES 44        // up to 2^49 ticks (two days at 3 GHz)
+#define PROFILE_BUCKETS ((PROFILE_MAGNITUDES + 1) << PROFILE_SUB_BITS)
+
+typedef enum {
+    PROFILE_CYCLES,
+    PROFILE_INSTRUCTIONS,
+    PROFILE_CACHE_MISSES,
+    PROFILE_BRANCH_MISSES,
+    PROFILE_EVENT_COUNT
+} ProfileEvent;
+
+// One thread's measurements of one region. Only the owning thread writes
+// it, with relaxed loads and stores, so readers never see torn values.
+typedef struct {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t totalTicks;
+    _Atomic uint64_t minTicks;
+    _Atomic uint64_t maxTicks;
+    _Atomic uint64_t countedCalls;                 // calls that read the counters
+    _Atomic uint64_t events[PROFILE_EVENT_COUNT];
+    _Atomic uint64_t buckets[PROFILE_BUCKETS];
+} ProfileSlot;
+
+typedef struct ProfileRegion {
+    const char* name;
+    bool counters;
+    atomic_bool registered;
+    _Atomic(ProfileSlot*) slots[PROFILE_MAX_THREADS];
+    struct ProfileRegion* next;
+} ProfileRegion;
+
+typedef struct {
+    ProfileRegion* region;
+    uint64_t start;
+} ProfileTimer;
+
+typedef struct {
+    ProfileRegion* region;
+    uint64_t start;
+    uint64_t events[PROFILE_EVENT_COUNT];
+    bool valid;
+} ProfileCounterTimer;
+
+// ========== Recording ==========
+
+static inline uint64_t profileTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// Adds one measurement of `ticks` (and counter deltas, if not NULL)
+void profileRecord(ProfileRegion* region, uint64_t ticks, const uint64_t* events);
+
+// Reads this thread's counters; false when they cannot be opened
+bool profileReadCounters(uint64_t* events);
+
+static inline ProfileTimer profileTimerBegin(ProfileRegion* region) {
+    ProfileTimer timer = { region, profileTicks() };
+    return timer;
+}
+
+static inline void profileTimerEnd(ProfileTimer* timer) {
+    profileRecord(timer->region, profileTicks() - timer->start, NULL);
+}
+
+static inline ProfileCounterTimer profileCounterTimerBegin(ProfileRegion* region) {
+    ProfileCounterTimer timer;
+    timer.region = region;
+    timer.valid = profileReadCounters(timer.events);
+    timer.start = profileTicks();
+    return timer;
+}
+
+static inline void profileCounterTimerEnd(ProfileCounterTimer* timer) {
+    uint64_t ticks = profileTicks() - timer->start;
+    uint64_t events[PROFILE_EVENT_COUNT];
+    if (timer->valid && profileReadCounters(events)) {
+        for (int e = 0; e < PROFILE_EVENT_COUNT; e++) {
+            events[e] -= timer->events[e];
+        }
+        profileRecord(timer->region, ticks, events);
+    } else {
+        profileRecord(timer->region, ticks, NULL);
+    }
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef INSTRUMENT
+
+// Times the rest of the enclosing block (one per line)
+#define PROFILE_SCOPE(regionName)                                                          \
+    static ProfileRegion PROFILE_CONCAT(profileRegion, __LINE__) = { .name = (regionName) }; \
+    __attribute__((cleanup(profileTimerEnd))) ProfileTimer PROFILE_CONCAT(profileTimer, __LINE__) = \
+        profileTimerBegin(&PROFILE_CONCAT(profileRegion, __LINE__))
+
+// The same, plus hardware counters
+#define PROFILE_SCOPE_COUNTERS(regionName)                                                 \
+    static ProfileRegion PROFILE_CONCAT(profileRegion, __LINE__) =                         \
+        { .name = (regionName), .counters = true };                                        \
+    __attribute__((cleanup(profileCounterTimerEnd))) ProfileCounterTimer                   \
+        PROFILE_CONCAT(profileTimer, __LINE__) = profileCounterTimerBegin(&PROFILE_CONCAT(profileRegion, __LINE__))
+
+#else
+
+#define PROFILE_SCOPE(regionName) ((void)0)
+#define PROFILE_SCOPE_COUNTERS(regionName) ((void)0)
+
+#endif
+
+// ========== Results ==========
+
+typedef struct {
+    const char* name;
+    bool counters;
+    uint64_t calls;
+    double totalNs;
+    double minNs;
+    double meanNs;
+    double p50Ns;
+    double p90Ns;
+    double p99Ns;
+    double p999Ns;
+    double maxNs;
+    uint64_t countedCalls;
+    uint64_t events[PROFILE_EVENT_COUNT];   // totals over countedCalls
+} ProfileSummary;
+
+// Regions merged by name, in order of first use; returns how many were
+// written (at most capacity)
+size_t profileSummaries(ProfileSummary* summaries, size_t capacity);
+
+// Latency of quantile q (0..1) of a region, in nanoseconds; -1 if unknown
+double profileQuantile(const char* name, double q);
+
+double profileTicksPerNs(void);
+double profileTimerOverheadNs(void);     // an empty PROFILE_SCOPE
+const char* profileCounterStatus(void);  // "available", "not used" or why not
+
+void profilePrint(FILE* out);
+void profileWriteJson(FILE* out);        // summaries plus the non-empty histogram buckets
+void profileWriteCsv(FILE* out);
+bool profileWriteFile(const char* path); // .json, .csv, or a table otherwise
+
+// Zero every region. Measurements taken while it runs may be lost.
+void profileReset(void);
+
+#endif
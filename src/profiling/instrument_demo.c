@@ -0,0 +1,370 @@
+/*
+ * Instrumentation Demo: Where the Time Goes
+ *
+ * Times the sorts of docs/12-algorithms/01-sorting-algorithms.md with
+ * PROFILE_SCOPE_COUNTERS, runs the graph loader, the structural scanner and
+ * the line reader with their built-in regions, and prints the profile (and
+ * writes it as JSON or CSV when a path is given). Then checks histogram
+ * percentiles against exact ones, checks concurrent recording from several
+ * threads, and measures what a region costs.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -DINSTRUMENT -pthread -o instrument_demo instrument_demo.c instrument.c \
+ *       ../data-structures/graph_loader.c ../data-structures/structural_scanner.c \
+ *       ../file-io/line_reader.c ../concurrency/scheduler.c ../dispatch/cpu_dispatch.c -lm
+ *   ./instrument_demo [profile.json | profile.csv]
+ *   PROFILE_OUTPUT=profile.json ./instrument_demo   (written at exit)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "instrument.h"
+#include "../data-structures/graph_loader.h"
+#include "../data-structures/structural_scanner.h"
+#include "../file-io/line_reader.h"
+#include "../concurrency/scheduler.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== Sorts from the Docs ==========
+
+static void insertionSort(int arr[], int n) {
+    for (int i = 1; i < n; i++) {
+        int key = arr[i];
+        int j = i - 1;
+
+        // Move elements greater than key one position ahead
+        while (j >= 0 && arr[j] > key) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+static void swap(int* a, int* b) {
+    int temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+static int partition(int arr[], int low, int high) {
+    int pivot = arr[high];
+    int i = low - 1;
+
+    for (int j = low; j < high; j++) {
+        if (arr[j] <= pivot) {
+            i++;
+            swap(&arr[i], &arr[j]);
+        }
+    }
+    swap(&arr[i + 1], &arr[high]);
+    return i + 1;
+}
+
+static void quickSort(int arr[], int low, int high) {
+    if (low < high) {
+        int pi = partition(arr, low, high);
+
+        // Sort elements before and after partition
+        quickSort(arr, low, pi - 1);
+        quickSort(arr, pi + 1, high);
+    }
+}
+
+static void heapify(int arr[], int n, int i) {
+    int largest = i;
+    int left = 2 * i + 1;
+    int right = 2 * i + 2;
+
+    if (left < n && arr[left] > arr[largest]) {
+        largest = left;
+    }
+    if (right < n && arr[right] > arr[largest]) {
+        largest = right;
+    }
+    if (largest != i) {
+        swap(&arr[i], &arr[largest]);
+        heapify(arr, n, largest);
+    }
+}
+
+static void heapSort(int arr[], int n) {
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        heapify(arr, n, i);
+    }
+    for (int i = n - 1; i > 0; i--) {
+        swap(&arr[0], &arr[i]);
+        heapify(arr, i, 0);
+    }
+}
+
+// The instrumented entry points: one region each, with counters
+static void profiledInsertionSort(int arr[], int n) {
+    PROFILE_SCOPE_COUNTERS("sort.insertionSort");
+    insertionSort(arr, n);
+}
+
+static void profiledQuickSort(int arr[], int n) {
+    PROFILE_SCOPE_COUNTERS("sort.quickSort");
+    quickSort(arr, 0, n - 1);
+}
+
+static void profiledHeapSort(int arr[], int n) {
+    PROFILE_SCOPE_COUNTERS("sort.heapSort");
+    heapSort(arr, n);
+}
+
+// ========== Examples ==========
+
+static void runSorts(unsigned* seed) {
+    int n = 20000;
+    int* values = malloc(n * sizeof(int));
+    int* work = malloc(n * sizeof(int));
+    if (values == NULL || work == NULL) {
+        printf("Memory allocation failed\n");
+        free(values);
+        free(work);
+        return;
+    }
+    for (int round = 0; round < 40; round++) {
+        for (int i = 0; i < n; i++) {
+            values[i] = (int)(nextRandom(seed) % 1000000);
+        }
+        memcpy(work, values, n * sizeof(int));
+        profiledQuickSort(work, n);
+        memcpy(work, values, n * sizeof(int));
+        profiledHeapSort(work, n);
+        // Insertion sort on the small pieces it is meant for
+        for (int i = 0; i + 64 <= n; i += 64) {
+            profiledInsertionSort(values + i, 64);
+        }
+    }
+    free(values);
+    free(work);
+}
+
+static void runGraphLoader(unsigned* seed) {
+    size_t edgeCount = 2000000;
+    size_t capacity = edgeCount * 24;
+    char* text = malloc(capacity);
+    if (text == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    size_t length = 0;
+    for (size_t e = 0; e < edgeCount; e++) {
+        length += (size_t)snprintf(text + length, capacity - length, "%u %u\n",
+                                   nextRandom(seed) % 100000, nextRandom(seed) % 100000);
+    }
+    EdgeList edges;
+    CsrGraph graph;
+    if (edgeListParse(&edges, text, length)) {
+        if (csrBuild(&graph, &edges, GRAPH_DEDUPLICATE)) {
+            csrFree(&graph);
+        }
+        edgeListFree(&edges);
+    }
+    free(text);
+}
+
+static void runScanner(void) {
+    const char record[] = "{\"id\": 12, \"tags\": [\"a\", \"b\"], \"note\": \"say \\\"(hi)\\\"\"},\n";
+    size_t recordLength = strlen(record);
+    size_t count = 32 * 1000000 / recordLength;
+    char* text = malloc(count * recordLength + 2);
+    if (text == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    size_t length = 0;
+    text[length++] = '[';
+    for (size_t r = 0; r < count; r++) {
+        memcpy(text + length, record, recordLength);
+        length += recordLength;
+    }
+    text[length - 2] = ']';   // replaces the last comma
+    scanBrackets(text, length - 1, true);
+    free(text);
+}
+
+static void runLineReader(unsigned* seed) {
+    char path[] = "/tmp/instrument_demo_XXXXXX";
+    int fd = mkstemp(path);
+    FILE* file = fd < 0 ? NULL : fdopen(fd, "w");
+    if (file == NULL) {
+        printf("Cannot open %s\n", path);
+        return;
+    }
+    for (int i = 0; i < 1000000; i++) {
+        fprintf(file, "line %d value %u\n", i, nextRandom(seed));
+    }
+    fclose(file);
+
+    // A descriptor (not a path) so the reader uses read(2) and not mmap
+    LineReader reader;
+    fd = open(path, O_RDONLY);
+    if (fd >= 0 && lineReaderOpenFd(&reader, fd, 64 * 1024)) {
+        LineView line;
+        while (lineReaderNext(&reader, &line) > 0) {
+        }
+        lineReaderClose(&reader);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    unlink(path);
+}
+
+// ========== Checks ==========
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Log-uniform latencies from 10 ns to 10 ms; every percentile of the
+// histogram must be within one bucket (1/32) of the exact one
+static bool checkPercentiles(unsigned* seed) {
+    static ProfileRegion region = { .name = "check.percentiles" };
+    int n = 200000;
+    double* samples = malloc(n * sizeof(double));
+    if (samples == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    double ticksPerNs = profileTicksPerNs();
+    for (int i = 0; i < n; i++) {
+        double exponent = 1.0 + 6.0 * (nextRandom(seed) / 4294967296.0);
+        uint64_t ticks = (uint64_t)(pow(10.0, exponent) * ticksPerNs);
+        profileRecord(&region, ticks, NULL);
+        samples[i] = (double)ticks;
+    }
+    qsort(samples, n, sizeof(double), compareDoubles);
+    double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+    double worst = 0;
+    for (int q = 0; q < 5; q++) {
+        double exact = samples[(int)ceil(quantiles[q] * n) - 1];
+        // Ticks per ns moves a little between calls; compare in ticks
+        double estimate = profileQuantile("check.percentiles", quantiles[q]) * profileTicksPerNs();
+        double error = fabs(estimate - exact) / exact;
+        worst = error > worst ? error : worst;
+    }
+    free(samples);
+    printf("percentiles of 200,000 latencies, worst error %.2f%%: %s\n", 100 * worst,
+           worst <= 1.0 / 32 + 0.001 ? "all match" : "MISMATCH");
+    return worst <= 1.0 / 32 + 0.001;
+}
+
+#define CHECK_THREADS 8
+#define CHECK_CALLS 200000
+
+static void* recordMany(void* arg) {
+    (void)arg;
+    for (int i = 0; i < CHECK_CALLS; i++) {
+        PROFILE_SCOPE("check.threads");
+    }
+    return NULL;
+}
+
+// Threads that exit hand their slot to later threads, so 3 rounds of 8
+// threads never run out of slots, and no call is lost
+static bool checkThreads(void) {
+    for (int round = 0; round < 3; round++) {
+        pthread_t threads[CHECK_THREADS];
+        for (int t = 0; t < CHECK_THREADS; t++) {
+            pthread_create(&threads[t], NULL, recordMany, NULL);
+        }
+        for (int t = 0; t < CHECK_THREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    ProfileSummary summaries[64];
+    size_t count = profileSummaries(summaries, 64);
+    uint64_t calls = 0;
+    for (size_t s = 0; s < count; s++) {
+        calls = strcmp(summaries[s].name, "check.threads") == 0 ? summaries[s].calls : calls;
+    }
+    bool ok = calls == 3ull * CHECK_THREADS * CHECK_CALLS;
+    printf("3 x %d threads x %d calls, %llu recorded: %s\n", CHECK_THREADS, CHECK_CALLS,
+           (unsigned long long)calls, ok ? "all match" : "MISMATCH");
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static volatile unsigned sink;
+
+__attribute__((noinline)) static void plainCall(unsigned value) {
+    sink = value;
+}
+
+__attribute__((noinline)) static void profiledCall(unsigned value) {
+    PROFILE_SCOPE("bench.profiledCall");
+    sink = value;
+}
+
+__attribute__((noinline)) static void countedCall(unsigned value) {
+    PROFILE_SCOPE_COUNTERS("bench.countedCall");
+    sink = value;
+}
+
+static double nsPerCall(void (*call)(unsigned), int calls) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < calls; i++) {
+        call((unsigned)i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec)) / calls;
+}
+
+int main(int argc, char* argv[]) {
+    dispatchPrint(stdout);
+    schedulerInit(0, 0);
+    unsigned seed = 2463534242u;
+
+    printf("\n=== Profile of the Instrumented Algorithms ===\n");
+    runSorts(&seed);
+    runGraphLoader(&seed);
+    runScanner();
+    runLineReader(&seed);
+    printf("ticks per ns: %.3f, timer overhead: %.1f ns, hardware counters: %s\n\n", profileTicksPerNs(),
+           profileTimerOverheadNs(), profileCounterStatus());
+    profilePrint(stdout);
+    if (argc > 1) {
+        if (profileWriteFile(argv[1])) {
+            printf("written to %s\n", argv[1]);
+        }
+    }
+
+    printf("\n=== Checks ===\n");
+    bool ok = checkPercentiles(&seed);
+    ok = checkThreads() && ok;
+
+    printf("\n=== Cost of a Region ===\n");
+    int calls = 10000000;
+    double plain = nsPerCall(plainCall, calls);
+    printf("%-32s %8.1f ns/call\n", "no region", plain);
+    printf("%-32s %8.1f ns/call\n", "PROFILE_SCOPE", nsPerCall(profiledCall, calls) - plain);
+    printf("%-32s %8.1f ns/call  (counters %s)\n", "PROFILE_SCOPE_COUNTERS",
+           nsPerCall(countedCall, calls / 10) - plain, profileCounterStatus());
+
+    schedulerShutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,383 @@
+/*
+ * char_class.c - Table-Driven and SIMD Character Classification (see char_class.h)
+ */
+
+#include "char_class.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <string.h>
+#include <immintrin.h>
+
+uint8_t charClassTable[256];
+static uint8_t lowerTable[256];      // 'A'..'Z' -> 'a'..'z', every other byte unchanged
+static uint8_t identityTable[256];   // every byte unchanged
+
+// Built once before main() runs, from the definitions rather than from the
+// locale, so the result is the same everywhere
+__attribute__((constructor)) static void buildTables(void) {
+    for (int c = 0; c < 256; c++) {
+        uint8_t bits = 0;
+        int lower = c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+        if (lower >= 'a' && lower <= 'z') {
+            bits |= strchr("aeiou", lower) != NULL ? CHAR_VOWEL : CHAR_CONSONANT;
+            bits |= c == lower ? CHAR_LOWER : CHAR_UPPER;
+        } else if (c >= '0' && c <= '9') {
+            bits |= CHAR_DIGIT;
+        } else if (c == ' ' || (c >= '\t' && c <= '\r')) {
+            bits |= CHAR_SPACE;
+        } else if (c > ' ' && c < 0x7f) {
+            bits |= CHAR_PUNCTUATION;
+        }
+        charClassTable[c] = bits;
+        lowerTable[c] = (uint8_t)lower;
+        identityTable[c] = (uint8_t)c;
+    }
+}
+
+// ========== Nibble Lookup ==========
+
+// pshufb looks up 16-entry tables, so one byte is classified by two lookups:
+// table A by its low nibble, table B by its high nibble. Each bit of
+// A[low] & B[high] is one rectangle of the 16x16 byte grid:
+//
+//   bit  high nibble  low nibble      meaning
+//   0x01    4, 6        1..F          letters A-O, a-o
+//   0x02    5, 7        0..A          letters P-Z, p-z
+//   0x04    4, 6        1,5,9,F       vowels A E I O, a e i o
+//   0x08    5, 7        5             vowels U, u
+//   0x10    3           0..9          digits
+//   0x20    2           0             ' '
+//   0x40    0           9..D          \t \n \v \f \r
+//   0x80    4, 5        any           upper half of the letter rows
+//
+// Bytes >= 0x80 have a high nibble of 8..F, where table B is all zero.
+#define NIBBLE_LOW_TABLE  0xB2, 0x97, 0x93, 0x93, 0x93, 0x9F, 0x93, 0x93, \
+                          0x93, 0xD7, 0xC3, 0xC1, 0xC1, 0xC1, 0x81, 0x85
+#define NIBBLE_HIGH_TABLE 0x40, 0x00, 0x20, 0x10, 0x85, 0x8A, 0x05, 0x0A, \
+                          0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+
+#define CLASS_LETTER 0x03
+#define CLASS_VOWEL  0x0C
+#define CLASS_DIGIT  0x10
+#define CLASS_SPACE  0x60
+
+// The SIMD loops count letters, vowels, digits, spaces, upper-case letters
+// and printable characters (0x21..0x7E); the rest follows by subtraction
+static CharCounts finishCounts(size_t letters, size_t vowels, size_t digits, size_t spaces,
+                               size_t upper, size_t printable, size_t total) {
+    CharCounts counts;
+    counts.vowels = vowels;
+    counts.consonants = letters - vowels;
+    counts.digits = digits;
+    counts.spaces = spaces;
+    counts.upper = upper;
+    counts.lower = letters - upper;
+    counts.punctuation = printable - letters - digits;
+    counts.other = total - printable - spaces;
+    counts.total = total;
+    return counts;
+}
+
+// ========== Histograms ==========
+
+// Four sub-histograms: consecutive equal bytes (runs of spaces, "ll", ...)
+// would otherwise wait on the previous increment of the same counter
+static void addHistogram(const uint8_t* bytes, size_t length, const uint8_t* map, uint32_t out[256]) {
+    if (length < 256) {
+        // Short strings: clearing 4 KB would cost more than the stalls
+        for (size_t i = 0; i < length; i++) {
+            out[map[bytes[i]]]++;
+        }
+        return;
+    }
+    uint32_t partial[4][256];
+    memset(partial, 0, sizeof(partial));
+    size_t i = 0;
+    // One 8-byte load per step instead of eight byte loads
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        partial[0][map[word & 0xFF]]++;
+        partial[1][map[(word >> 8) & 0xFF]]++;
+        partial[2][map[(word >> 16) & 0xFF]]++;
+        partial[3][map[(word >> 24) & 0xFF]]++;
+        partial[0][map[(word >> 32) & 0xFF]]++;
+        partial[1][map[(word >> 40) & 0xFF]]++;
+        partial[2][map[(word >> 48) & 0xFF]]++;
+        partial[3][map[word >> 56]]++;
+    }
+    for (; i < length; i++) {
+        partial[0][map[bytes[i]]]++;
+    }
+    for (int b = 0; b < 256; b++) {
+        out[b] += partial[0][b] + partial[1][b] + partial[2][b] + partial[3][b];
+    }
+}
+
+void byteHistogram(const char* text, size_t length, bool foldCase, ByteHistogram* out) {
+    memset(out->counts, 0, sizeof(out->counts));
+    addHistogram((const uint8_t*)text, length, foldCase ? lowerTable : identityTable, out->counts);
+}
+
+static bool histogramEqualScalar(const ByteHistogram* a, const ByteHistogram* b) {
+    uint32_t difference = 0;
+    for (int i = 0; i < 256; i++) {
+        difference |= a->counts[i] ^ b->counts[i];
+    }
+    return difference == 0;
+}
+
+// XOR 8 counters at a time and OR the differences together: no branch
+// until the end, and 32 iterations for the whole 1 KB histogram
+__attribute__((target("avx2")))
+static bool histogramEqualAvx2(const ByteHistogram* a, const ByteHistogram* b) {
+    __m256i difference = _mm256_setzero_si256();
+    for (int i = 0; i < 256; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a->counts + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b->counts + i));
+        difference = _mm256_or_si256(difference, _mm256_xor_si256(x, y));
+    }
+    return _mm256_testz_si256(difference, difference);
+}
+
+__attribute__((target("avx512f")))
+static bool histogramEqualAvx512(const ByteHistogram* a, const ByteHistogram* b) {
+    __m512i difference = _mm512_setzero_si512();
+    for (int i = 0; i < 256; i += 16) {
+        difference = _mm512_or_si512(difference, _mm512_xor_si512(_mm512_loadu_si512(a->counts + i),
+                                                                  _mm512_loadu_si512(b->counts + i)));
+    }
+    return _mm512_test_epi32_mask(difference, difference) == 0;
+}
+
+DISPATCH_KERNEL(HistogramEqualFunction, histogramEqual,
+    DISPATCH_VARIANT(histogramEqualAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(histogramEqualAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(histogramEqualScalar, 0))
+
+bool isAnagram(const char* a, size_t lengthA, const char* b, size_t lengthB) {
+    if (lengthA != lengthB) {
+        return false;   // equal multisets have equal sizes
+    }
+    ByteHistogram histogramA, histogramB;
+    byteHistogram(a, lengthA, true, &histogramA);
+    byteHistogram(b, lengthB, true, &histogramB);
+    return histogramEqual(&histogramA, &histogramB);
+}
+
+// ========== countCharacters ==========
+
+// One table lookup per byte, every class bit added without a branch
+static CharCounts countCharactersShort(const uint8_t* bytes, size_t length) {
+    CharCounts counts = { 0, 0, 0, 0, 0, 0, 0, 0, length };
+    for (size_t i = 0; i < length; i++) {
+        unsigned bits = charClassTable[bytes[i]];
+        counts.vowels += bits & 1;
+        counts.consonants += (bits >> 1) & 1;
+        counts.digits += (bits >> 2) & 1;
+        counts.spaces += (bits >> 3) & 1;
+        counts.upper += (bits >> 4) & 1;
+        counts.lower += (bits >> 5) & 1;
+        counts.punctuation += (bits >> 6) & 1;
+        counts.other += bits == 0;
+    }
+    return counts;
+}
+
+// Long text: histogram first, then one table lookup per byte value instead
+// of per byte
+static CharCounts countCharactersScalar(const char* text, size_t length) {
+    if (length < 4096) {
+        return countCharactersShort((const uint8_t*)text, length);
+    }
+    size_t classTotals[8] = { 0 };
+    size_t other = 0;
+    const size_t chunk = (size_t)1 << 30;   // keeps the 32-bit counters from overflowing
+    for (size_t start = 0; start < length; start += chunk) {
+        uint32_t histogram[256] = { 0 };
+        size_t n = length - start < chunk ? length - start : chunk;
+        addHistogram((const uint8_t*)text + start, n, identityTable, histogram);
+        for (int b = 0; b < 256; b++) {
+            uint8_t bits = charClassTable[b];
+            for (int k = 0; k < 7; k++) {
+                classTotals[k] += (bits >> k) & 1 ? histogram[b] : 0;
+            }
+            other += bits & (CHAR_VOWEL | CHAR_CONSONANT | CHAR_DIGIT | CHAR_SPACE | CHAR_PUNCTUATION)
+                     ? 0 : histogram[b];
+        }
+    }
+    CharCounts counts;
+    counts.vowels = classTotals[0];
+    counts.consonants = classTotals[1];
+    counts.digits = classTotals[2];
+    counts.spaces = classTotals[3];
+    counts.upper = classTotals[4];
+    counts.lower = classTotals[5];
+    counts.punctuation = classTotals[6];
+    counts.other = other;
+    counts.total = length;
+    return counts;
+}
+
+__attribute__((target("avx2,popcnt")))
+static CharCounts countCharactersAvx2(const char* text, size_t length) {
+    const __m256i lowTable = _mm256_setr_epi8(NIBBLE_LOW_TABLE, NIBBLE_LOW_TABLE);
+    const __m256i highTable = _mm256_setr_epi8(NIBBLE_HIGH_TABLE, NIBBLE_HIGH_TABLE);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t letters = 0, vowels = 0, digits = 0, spaces = 0, upper = 0, printable = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i classes = _mm256_and_si256(
+            _mm256_shuffle_epi8(lowTable, _mm256_and_si256(v, nibble)),
+            _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+
+        // A lane is in a class when (classes & bits) != 0
+#define CLASS_MASK(bits) \
+        ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(classes, _mm256_set1_epi8(bits)), zero))
+        uint32_t letterMask = CLASS_MASK(CLASS_LETTER);
+        letters += (size_t)_mm_popcnt_u32(letterMask);
+        vowels += (size_t)_mm_popcnt_u32(CLASS_MASK(CLASS_VOWEL));
+        digits += (size_t)_mm_popcnt_u32(CLASS_MASK(CLASS_DIGIT));
+        spaces += (size_t)_mm_popcnt_u32(CLASS_MASK(CLASS_SPACE));
+#undef CLASS_MASK
+        upper += (size_t)_mm_popcnt_u32(letterMask & (uint32_t)_mm256_movemask_epi8(classes));
+
+        // 0x21..0x7E: v - 0x21 <= 0x5D as an unsigned byte
+        __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(0x21));
+        __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(0x5d)), shifted);
+        printable += (size_t)_mm_popcnt_u32((uint32_t)_mm256_movemask_epi8(inRange));
+    }
+
+    CharCounts counts = finishCounts(letters, vowels, digits, spaces, upper, printable, i);
+    if (i < length) {
+        CharCounts rest = countCharactersShort((const uint8_t*)text + i, length - i);
+        counts.vowels += rest.vowels;
+        counts.consonants += rest.consonants;
+        counts.digits += rest.digits;
+        counts.spaces += rest.spaces;
+        counts.upper += rest.upper;
+        counts.lower += rest.lower;
+        counts.punctuation += rest.punctuation;
+        counts.other += rest.other;
+        counts.total += rest.total;
+    }
+    return counts;
+}
+
+// AVX-512BW compares straight into 64-bit mask registers, and the masked
+// load handles the tail without a scalar loop
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static CharCounts countCharactersAvx512(const char* text, size_t length) {
+    const __m512i lowTable = _mm512_broadcast_i32x4(_mm_setr_epi8(NIBBLE_LOW_TABLE));
+    const __m512i highTable = _mm512_broadcast_i32x4(_mm_setr_epi8(NIBBLE_HIGH_TABLE));
+    const __m512i nibble = _mm512_set1_epi8(0x0f);
+    size_t letters = 0, vowels = 0, digits = 0, spaces = 0, upper = 0, printable = 0;
+    for (size_t i = 0; i < length; i += 64) {
+        __mmask64 valid = length - i >= 64 ? ~0ULL : (1ULL << (length - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi8(valid, text + i);
+        __m512i classes = _mm512_and_si512(
+            _mm512_shuffle_epi8(lowTable, _mm512_and_si512(v, nibble)),
+            _mm512_shuffle_epi8(highTable, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble)));
+
+        __mmask64 letterMask = _mm512_test_epi8_mask(classes, _mm512_set1_epi8(CLASS_LETTER));
+        letters += (size_t)_mm_popcnt_u64(letterMask);
+        vowels += (size_t)_mm_popcnt_u64(_mm512_test_epi8_mask(classes, _mm512_set1_epi8(CLASS_VOWEL)));
+        digits += (size_t)_mm_popcnt_u64(_mm512_test_epi8_mask(classes, _mm512_set1_epi8(CLASS_DIGIT)));
+        spaces += (size_t)_mm_popcnt_u64(_mm512_test_epi8_mask(classes, _mm512_set1_epi8(CLASS_SPACE)));
+        upper += (size_t)_mm_popcnt_u64(letterMask & _mm512_movepi8_mask(classes));
+        // Zero bytes past the end are not printable, so no extra masking is needed
+        __m512i shifted = _mm512_sub_epi8(v, _mm512_set1_epi8(0x21));
+        printable += (size_t)_mm_popcnt_u64(_mm512_cmple_epu8_mask(shifted, _mm512_set1_epi8(0x5d)));
+    }
+    return finishCounts(letters, vowels, digits, spaces, upper, printable, length);
+}
+
+DISPATCH_KERNEL(CountCharactersFunction, countCharacters,
+    DISPATCH_VARIANT(countCharactersAvx512, CPU_AVX512F | CPU_AVX512BW | CPU_POPCNT),
+    DISPATCH_VARIANT(countCharactersAvx2, CPU_AVX2 | CPU_POPCNT),
+    DISPATCH_VARIANT(countCharactersScalar, 0))
+
+// ========== Case Folding ==========
+
+// (unsigned)(c - 'A') < 26 is one compare for 'A' <= c <= 'Z'; flipping
+// bit 5 (0x20) switches between the cases
+// SWAR: 8 bytes per step. Adding to the low 7 bits of each byte cannot carry
+// into the next byte, so bit 7 of (b + 0x80 - first) says b >= first and bit 7
+// of (b + 0x80 - first - 26) says b >= first + 26; letters are between the two
+static inline uint64_t caseFlipMask(uint64_t word, unsigned first) {
+    const uint64_t ones = 0x0101010101010101ull;
+    uint64_t low = word & (ones * 0x7F);
+    uint64_t atLeastFirst = low + ones * (0x80 - first);
+    uint64_t pastLast = low + ones * (0x80 - first - 26);
+    return ((atLeastFirst ^ pastLast) & ~word & (ones * 0x80)) >> 2;
+}
+
+static void caseScalar(char* text, size_t length, unsigned first) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, text + i, 8);
+        word ^= caseFlipMask(word, first);
+        memcpy(text + i, &word, 8);
+    }
+    for (; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        text[i] = (char)(c ^ (((unsigned)(c - first) < 26) << 5));
+    }
+}
+
+static void toLowerCaseScalar(char* text, size_t length) {
+    caseScalar(text, length, 'A');
+}
+
+static void toUpperCaseScalar(char* text, size_t length) {
+    caseScalar(text, length, 'a');
+}
+
+// Adding 0x80 - first moves the 26 letters to the bottom of the signed
+// byte range (-128..-103), so one signed compare finds them
+#define CASE_AVX2(name, first)                                                                   \
+    __attribute__((target("avx2")))                                                              \
+    static void name##Avx2(char* text, size_t length) {                                          \
+        const __m256i offset = _mm256_set1_epi8((char)(0x80 - (first)));                         \
+        const __m256i limit = _mm256_set1_epi8((char)(-128 + 26));                               \
+        const __m256i flip = _mm256_set1_epi8(0x20);                                             \
+        size_t i = 0;                                                                            \
+        for (; i + 32 <= length; i += 32) {                                                      \
+            __m256i v = _mm256_loadu_si256((const __m256i*)(text + i));                          \
+            __m256i isLetter = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, offset));             \
+            _mm256_storeu_si256((__m256i*)(text + i),                                            \
+                                _mm256_xor_si256(v, _mm256_and_si256(isLetter, flip)));          \
+        }                                                                                        \
+        name##Scalar(text + i, length - i);                                                      \
+    }
+
+#define CASE_AVX512(name, first)                                                                 \
+    __attribute__((target("avx512f,avx512bw")))                                                  \
+    static void name##Avx512(char* text, size_t length) {                                        \
+        const __m512i flip = _mm512_set1_epi8(0x20);                                             \
+        for (size_t i = 0; i < length; i += 64) {                                                \
+            __mmask64 valid = length - i >= 64 ? ~0ULL : (1ULL << (length - i)) - 1;             \
+            __m512i v = _mm512_maskz_loadu_epi8(valid, text + i);                                \
+            __mmask64 isLetter = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(v, _mm512_set1_epi8(first)), \
+                                                        _mm512_set1_epi8(26));                   \
+            _mm512_mask_storeu_epi8(text + i, isLetter & valid, _mm512_xor_si512(v, flip));      \
+        }                                                                                        \
+    }
+
+CASE_AVX2(toLowerCase, 'A')
+CASE_AVX2(toUpperCase, 'a')
+CASE_AVX512(toLowerCase, 'A')
+CASE_AVX512(toUpperCase, 'a')
+
+DISPATCH_KERNEL(CaseFunction, toLowerCase,
+    DISPATCH_VARIANT(toLowerCaseAvx512, CPU_AVX512F | CPU_AVX512BW),
+    DISPATCH_VARIANT(toLowerCaseAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(toLowerCaseScalar, 0))
+
+DISPATCH_KERNEL(CaseFunction, toUpperCase,
+    DISPATCH_VARIANT(toUpperCaseAvx512, CPU_AVX512F | CPU_AVX512BW),
+    DISPATCH_VARIANT(toUpperCaseAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(toUpperCaseScalar, 0))
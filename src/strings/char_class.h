@@ -0,0 +1,84 @@
+/*
+ * char_class.h - Table-Driven and SIMD Character Classification
+ *
+ * countCharacters(), toUpperCase(), toLowerCase() and isAnagram() in
+ * docs/05-strings/01-string-handling.md call isalpha()/tolower() once per
+ * byte. Those go through the C locale tables, and the compiler cannot turn
+ * the loop into vector code. This module does the same work for ASCII text:
+ *
+ * - charClassTable: the class bits of every byte value, built once at startup
+ * - countCharacters(): returns a CharCounts struct instead of printing. The
+ *   SIMD variants classify 32 (AVX2) or 64 (AVX-512BW) bytes at a time with
+ *   two pshufb lookups, one on the low nibble and one on the high nibble
+ * - toUpperCase()/toLowerCase(): ASCII case folding in place, 32/64 bytes at a time
+ * - byteHistogram()/histogramEqual(): 256-bucket byte counts compared with
+ *   SIMD, and isAnagram() on top of them
+ *
+ * Only ASCII letters are letters: bytes >= 0x80 (UTF-8 sequences) count as
+ * "other" and are never changed by case folding. Strings are passed with a
+ * length, so they may contain '\0'.
+ *
+ * The fastest variant for the CPU is picked at startup (see
+ * ../dispatch/cpu_dispatch.h). Compile together with char_class.c:
+ *   gcc -O2 -o program program.c char_class.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    CHAR_VOWEL       = 1 << 0,   // aeiouAEIOU
+    CHAR_CONSONANT   = 1 << 1,   // other ASCII letters
+    CHAR_DIGIT       = 1 << 2,
+    CHAR_SPACE       = 1 << 3,   // ' ', \t, \n, \v, \f, \r (as isspace)
+    CHAR_UPPER       = 1 << 4,
+    CHAR_LOWER       = 1 << 5,
+    CHAR_PUNCTUATION = 1 << 6    // printable ASCII that is not a letter or digit
+} CharClass;
+
+extern uint8_t charClassTable[256];   // CharClass bits per byte value
+
+static inline unsigned charClass(char c) {
+    return charClassTable[(unsigned char)c];
+}
+
+typedef struct {
+    size_t vowels;
+    size_t consonants;
+    size_t digits;
+    size_t spaces;
+    size_t upper;
+    size_t lower;
+    size_t punctuation;
+    size_t other;   // control characters and bytes >= 0x80
+    size_t total;
+} CharCounts;
+
+typedef struct {
+    uint32_t counts[256];
+} ByteHistogram;
+
+// ========== Kernels (resolved for this CPU at startup) ==========
+
+typedef CharCounts (*CountCharactersFunction)(const char* text, size_t length);
+typedef void (*CaseFunction)(char* text, size_t length);
+typedef bool (*HistogramEqualFunction)(const ByteHistogram* a, const ByteHistogram* b);
+
+extern CountCharactersFunction countCharacters;
+extern CaseFunction toUpperCase;
+extern CaseFunction toLowerCase;
+extern HistogramEqualFunction histogramEqual;
+
+// ========== Histograms ==========
+
+// Count every byte value; with foldCase, 'A'..'Z' are counted as 'a'..'z'
+void byteHistogram(const char* text, size_t length, bool foldCase, ByteHistogram* out);
+
+// Same letters with the same multiplicities, ignoring ASCII case
+bool isAnagram(const char* a, size_t lengthA, const char* b, size_t lengthB);
+
+#endif
@@ -0,0 +1,374 @@
+/*
+ * Character Class Demo: countCharacters, Case Folding and isAnagram
+ *
+ * Runs the examples from docs/05-strings/01-string-handling.md through the
+ * table/SIMD versions in char_class.h, checks every variant against the
+ * <ctype.h> versions for all 256 byte values and many lengths, then times
+ * them on a generated document (English words, digits, punctuation and
+ * some UTF-8).
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o char_class_demo char_class_demo.c char_class.c ../dispatch/cpu_dispatch.c
+ *   ./char_class_demo [document bytes] [repeats]
+ *   CPU_DISPATCH=scalar ./char_class_demo      (table-driven code only)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "char_class.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== The Versions from the Docs ==========
+
+// countCharacters() from the docs, returning the counts instead of printing
+static CharCounts countCharactersCtype(const char* str, size_t length) {
+    CharCounts counts;
+    memset(&counts, 0, sizeof(counts));
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)str[i];
+        int ch = tolower(c);
+        if (ch == 'a' || ch == 'e' || ch == 'i' || ch == 'o' || ch == 'u') {
+            counts.vowels++;
+        } else if (isalpha(ch)) {
+            counts.consonants++;
+        } else if (isdigit(c)) {
+            counts.digits++;
+        } else if (isspace(c)) {
+            counts.spaces++;
+        } else if (ispunct(c)) {
+            counts.punctuation++;
+        } else {
+            counts.other++;
+        }
+        counts.upper += isupper(c) != 0;
+        counts.lower += islower(c) != 0;
+    }
+    counts.total = length;
+    return counts;
+}
+
+static void toLowerCaseCtype(char* str) {
+    for (int i = 0; str[i] != '\0'; i++) {
+        str[i] = (char)tolower((unsigned char)str[i]);
+    }
+}
+
+static int isAnagramCtype(const char* str1, const char* str2) {
+    int count[256] = {0};
+    for (int i = 0; str1[i] != '\0'; i++) {
+        count[tolower((unsigned char)str1[i])]++;
+    }
+    for (int i = 0; str2[i] != '\0'; i++) {
+        count[tolower((unsigned char)str2[i])]--;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (count[i] != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static bool sameCounts(CharCounts a, CharCounts b) {
+    return a.vowels == b.vowels && a.consonants == b.consonants && a.digits == b.digits &&
+           a.spaces == b.spaces && a.upper == b.upper && a.lower == b.lower &&
+           a.punctuation == b.punctuation && a.other == b.other && a.total == b.total;
+}
+
+static void printCounts(const char* text, CharCounts counts) {
+    printf("\"%s\": vowels %zu, consonants %zu, digits %zu, spaces %zu, "
+           "upper %zu, lower %zu, punctuation %zu, other %zu\n", text, counts.vowels,
+           counts.consonants, counts.digits, counts.spaces, counts.upper, counts.lower,
+           counts.punctuation, counts.other);
+}
+
+// ========== Checks ==========
+
+// Every variant of every kernel on one input, compared with <ctype.h>
+static bool checkInput(char* text, size_t length, char* scratch) {
+    bool ok = true;
+    CharCounts expected = countCharactersCtype(text, length);
+    const DispatchKernel* kernel = dispatchFind("countCharacters");
+    for (int v = 0; v < kernel->variantCount; v++) {
+        if (cpuHas(kernel->variants[v].required)) {
+            CharCounts counts = ((CountCharactersFunction)kernel->variants[v].function)(text, length);
+            ok = ok && sameCounts(counts, expected);
+        }
+    }
+
+    const char* cases[] = { "toLowerCase", "toUpperCase" };
+    for (int c = 0; c < 2; c++) {
+        kernel = dispatchFind(cases[c]);
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (!cpuHas(kernel->variants[v].required)) {
+                continue;
+            }
+            memcpy(scratch, text, length + 1);
+            ((CaseFunction)kernel->variants[v].function)(scratch, length);
+            for (size_t i = 0; i < length; i++) {
+                unsigned char in = (unsigned char)text[i];
+                // <ctype.h> in the "C" locale only maps ASCII letters, like the kernels
+                int want = c == 0 ? tolower(in) : toupper(in);
+                ok = ok && (unsigned char)scratch[i] == want;
+            }
+            ok = ok && scratch[length] == text[length];   // nothing written past the end
+        }
+    }
+    return ok;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against <ctype.h> ===\n");
+    bool ok = true;
+    char all[257];
+    for (int b = 0; b < 256; b++) {
+        all[b] = (char)(b == 0 ? 1 : b);
+    }
+    all[256] = '\0';
+
+    char* scratch = malloc(1025);
+    char* text = malloc(1025);
+    if (scratch == NULL || text == NULL) {
+        printf("Memory allocation failed\n");
+        free(scratch);
+        free(text);
+        return false;
+    }
+    ok = ok && checkInput(all, 256, scratch);
+
+    // Every length up to 1024, so each tail size is covered
+    for (size_t length = 0; length <= 1024; length++) {
+        for (size_t i = 0; i < length; i++) {
+            text[i] = (char)(nextRandom(seed) % 255 + 1);
+        }
+        text[length] = '\0';
+        ok = ok && checkInput(text, length, scratch);
+    }
+
+    // Anagrams: shuffled and case-flipped copies must match, changed ones not
+    const DispatchKernel* kernel = dispatchFind("histogramEqual");
+    for (int round = 0; round < 200; round++) {
+        size_t length = nextRandom(seed) % 1024;
+        for (size_t i = 0; i < length; i++) {
+            text[i] = (char)(nextRandom(seed) % 255 + 1);
+        }
+        text[length] = '\0';
+        memcpy(scratch, text, length + 1);
+        for (size_t i = length; i > 1; i--) {
+            size_t j = nextRandom(seed) % i;
+            char swap = scratch[i - 1];
+            scratch[i - 1] = scratch[j];
+            scratch[j] = swap;
+        }
+        toUpperCase(scratch, length / 2);
+        if (round % 2 == 1 && length > 0) {
+            scratch[nextRandom(seed) % length] ^= 0x40;
+        }
+        ByteHistogram a, b;
+        byteHistogram(text, length, true, &a);
+        byteHistogram(scratch, length, true, &b);
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (cpuHas(kernel->variants[v].required)) {
+                bool equal = ((HistogramEqualFunction)kernel->variants[v].function)(&a, &b);
+                ok = ok && equal == (isAnagramCtype(text, scratch) != 0);
+            }
+        }
+        ok = ok && isAnagram(text, length, scratch, length) == (isAnagramCtype(text, scratch) != 0);
+    }
+    printf("all 256 bytes, lengths 0..1024, anagrams: %s\n", ok ? "all match" : "MISMATCH");
+    free(scratch);
+    free(text);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static void makeDocument(char* text, size_t length, unsigned* seed) {
+    static const char* words[] = {
+        "the", "quick", "brown", "fox", "Jumps", "over", "a", "lazy", "dog", "Document",
+        "ingest", "pipeline", "2024", "42", "id:", "(draft)", "e-mail", "naïve", "café", "ÜBER"
+    };
+    size_t i = 0;
+    while (i < length) {
+        const char* word = words[nextRandom(seed) % 20];
+        size_t n = strlen(word);
+        for (size_t k = 0; k < n && i < length; k++) {
+            text[i++] = word[k];
+        }
+        if (i < length) {
+            unsigned r = nextRandom(seed) % 16;
+            text[i++] = r == 0 ? '\n' : r == 1 ? ',' : r == 2 ? '.' : ' ';
+        }
+    }
+    text[length] = '\0';
+}
+
+static void benchCount(const char* text, size_t length, int repeats) {
+    printf("\n=== countCharacters over %zu bytes (GB/s) ===\n", length);
+    struct timespec start, end;
+    CharCounts expected;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        expected = countCharactersCtype(text, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end) / repeats;
+    printf("%-26s %8.2f\n", "<ctype.h> per byte (docs)", (double)length / baseline / 1e9);
+
+    const DispatchKernel* kernel = dispatchFind("countCharacters");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        const DispatchVariant* variant = &kernel->variants[v];
+        if (!cpuHas(variant->required)) {
+            printf("%-26s %8s\n", variant->name, "skipped");
+            continue;
+        }
+        CharCounts counts;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r = 0; r < repeats; r++) {
+            counts = ((CountCharactersFunction)variant->function)(text, length);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end) / repeats;
+        printf("%-26s %8.2f %7.1fx %s%s\n", variant->name, (double)length / seconds / 1e9,
+               baseline / seconds, sameCounts(counts, expected) ? "ok" : "WRONG",
+               variant == kernel->chosen ? "  <- chosen" : "");
+    }
+}
+
+static void benchCase(const char* text, size_t length, int repeats, char* scratch) {
+    printf("\n=== toLowerCase over %zu bytes (GB/s) ===\n", length);
+    struct timespec start, end;
+    double total = 0;
+    for (int r = 0; r < repeats; r++) {
+        memcpy(scratch, text, length + 1);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        toLowerCaseCtype(scratch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsedSeconds(start, end);
+    }
+    double baseline = total / repeats;
+    printf("%-26s %8.2f\n", "<ctype.h> per byte (docs)", (double)length / baseline / 1e9);
+
+    char* expected = malloc(length + 1);
+    if (expected == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    memcpy(expected, scratch, length + 1);
+
+    const DispatchKernel* kernel = dispatchFind("toLowerCase");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        const DispatchVariant* variant = &kernel->variants[v];
+        if (!cpuHas(variant->required)) {
+            printf("%-26s %8s\n", variant->name, "skipped");
+            continue;
+        }
+        total = 0;
+        for (int r = 0; r < repeats; r++) {
+            memcpy(scratch, text, length + 1);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ((CaseFunction)variant->function)(scratch, length);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            total += elapsedSeconds(start, end);
+        }
+        double seconds = total / repeats;
+        printf("%-26s %8.2f %7.1fx %s%s\n", variant->name, (double)length / seconds / 1e9,
+               baseline / seconds, memcmp(scratch, expected, length) == 0 ? "ok" : "WRONG",
+               variant == kernel->chosen ? "  <- chosen" : "");
+    }
+    free(expected);
+}
+
+static void benchAnagram(const char* text, size_t length, int repeats, char* scratch, unsigned* seed) {
+    // A shuffled, partly upper-cased copy is an anagram of the original
+    memcpy(scratch, text, length + 1);
+    for (size_t i = length; i > 1; i--) {
+        size_t j = nextRandom(seed) % i;
+        char swap = scratch[i - 1];
+        scratch[i - 1] = scratch[j];
+        scratch[j] = swap;
+    }
+    toUpperCase(scratch, length / 3);
+
+    // Called through a volatile pointer so the pure loop is not hoisted out
+    int (*volatile reference)(const char*, const char*) = isAnagramCtype;
+    struct timespec start, end;
+    int expected = 0;
+    bool result = false;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        expected = reference(text, scratch);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end) / repeats;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < repeats; r++) {
+        result = isAnagram(text, length, scratch, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsedSeconds(start, end) / repeats;
+
+    printf("\n=== isAnagram of two %zu-byte documents ===\n", length);
+    printf("<ctype.h> count[256] (docs): %.2f ms\n", baseline * 1e3);
+    printf("byteHistogram + %s: %.2f ms (%.1fx), results %s\n",
+           dispatchFind("histogramEqual")->chosen->name, seconds * 1e3, baseline / seconds,
+           result == (expected != 0) ? "match" : "DIFFER");
+}
+
+int main(int argc, char* argv[]) {
+    size_t length = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : (size_t)16 << 20;
+    int repeats = argc > 2 ? atoi(argv[2]) : 10;
+    if (length == 0 || repeats < 1) {
+        printf("Usage: %s [document bytes] [repeats]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Examples from the Docs ===\n");
+    char hello[] = "Hello World 123";
+    printCounts(hello, countCharacters(hello, strlen(hello)));
+    char mixed[] = "Hello World";
+    toUpperCase(mixed, strlen(mixed));
+    printf("Uppercase: %s\n", mixed);
+    toLowerCase(mixed, strlen(mixed));
+    printf("Lowercase: %s\n", mixed);
+    printf("isAnagram(\"Listen\", \"Silent\") = %d, isAnagram(\"Listen\", \"Silence\") = %d\n",
+           isAnagram("Listen", 6, "Silent", 6), isAnagram("Listen", 6, "Silence", 7));
+
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+
+    char* text = malloc(length + 1);
+    char* scratch = malloc(length + 1);
+    if (text == NULL || scratch == NULL) {
+        printf("Memory allocation failed\n");
+        free(text);
+        free(scratch);
+        return 1;
+    }
+    makeDocument(text, length, &seed);
+    benchCount(text, length, repeats);
+    benchCase(text, length, repeats, scratch);
+    benchAnagram(text, length, repeats, scratch, &seed);
+
+    free(text);
+    free(scratch);
+    return ok ? 0 : 1;
+}
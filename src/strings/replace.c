@@ -0,0 +1,699 @@
+/*
+ * replace.c - Streaming Multi-Pattern Search and Replace (see replace.h)
+ */
+
+#include "replace.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <immintrin.h>
+
+#define REPLACE_FILE_BUFFER (64 * 1024)
+
+// ========== Building the Trie ==========
+
+typedef struct {
+    const uint8_t* bytes;
+    size_t length;
+    int index;
+} SortedPattern;
+
+// Byte order, then shorter first, then pair order (so the first duplicate wins)
+static int comparePatterns(const void* a, const void* b) {
+    const SortedPattern* x = a;
+    const SortedPattern* y = b;
+    size_t common = x->length < y->length ? x->length : y->length;
+    int order = memcmp(x->bytes, y->bytes, common);
+    if (order != 0) {
+        return order;
+    }
+    if (x->length != y->length) {
+        return x->length < y->length ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+typedef struct {
+    uint32_t node;
+    int low;
+    int high;
+    size_t depth;
+} BuildTask;
+
+// Breadth-first over the sorted patterns: the patterns in [low, high) share
+// their first `depth` bytes, which spell the path to `node`. Each task lays
+// out all children of its node next to each other, then queues them.
+static void buildTrie(Replacer* replacer, const SortedPattern* sorted, BuildTask* queue) {
+    size_t head = 0;
+    size_t tail = 0;
+    uint32_t childUsed = 0;
+    queue[tail++] = (BuildTask){ 0, 0, replacer->pairCount, 0 };
+    replacer->nodeCount = 1;
+
+    while (head < tail) {
+        BuildTask task = queue[head++];
+        int i = task.low;
+        while (i < task.high && sorted[i].length == task.depth) {
+            if (replacer->pairOf[task.node] < 0) {
+                replacer->pairOf[task.node] = sorted[i].index;
+            }
+            i++;
+        }
+        replacer->childStart[task.node] = childUsed;
+        while (i < task.high) {
+            uint8_t byte = sorted[i].bytes[task.depth];
+            int end = i;
+            while (end < task.high && sorted[end].bytes[task.depth] == byte) {
+                end++;
+            }
+            uint32_t child = (uint32_t)replacer->nodeCount++;
+            replacer->childBytes[childUsed] = byte;
+            replacer->childNodes[childUsed] = child;
+            childUsed++;
+            replacer->childCount[task.node]++;
+            if (task.node == 0) {
+                replacer->rootChild[byte] = child;
+            }
+            queue[tail++] = (BuildTask){ child, i, end, task.depth + 1 };
+            i = end;
+        }
+    }
+}
+
+// Shufti-style byte-set filter: byte b is in the set when
+// low[b & 15] & high[b >> 4] is not 0. High nibbles with the same set of low
+// nibbles share one of the 8 bucket bits; past 8 distinct sets buckets are
+// shared and give false positives, which the exact tables remove.
+static void buildNibbleFilter(const uint8_t set[256], uint8_t low[16], uint8_t high[16]) {
+    uint16_t lowSet[16] = { 0 };
+    for (int b = 0; b < 256; b++) {
+        if (set[b]) {
+            lowSet[b >> 4] |= (uint16_t)(1u << (b & 15));
+        }
+    }
+    uint16_t bucketSet[8];
+    int buckets = 0;
+    for (int h = 0; h < 16; h++) {
+        if (lowSet[h] == 0) {
+            continue;
+        }
+        int bucket = 0;
+        while (bucket < buckets && bucketSet[bucket] != lowSet[h]) {
+            bucket++;
+        }
+        if (bucket == buckets) {
+            if (buckets < 8) {
+                bucketSet[buckets++] = lowSet[h];
+            } else {
+                bucket = h % 8;
+            }
+        }
+        high[h] |= (uint8_t)(1u << bucket);
+        for (int l = 0; l < 16; l++) {
+            if (lowSet[h] & (1u << l)) {
+                low[l] |= (uint8_t)(1u << bucket);
+            }
+        }
+    }
+}
+
+static inline bool testBit(const uint8_t* bits, unsigned index) {
+    return (bits[index >> 3] >> (index & 7)) & 1;
+}
+
+static inline void setBit(uint8_t* bits, unsigned index) {
+    bits[index >> 3] |= (uint8_t)(1u << (index & 7));
+}
+
+static inline unsigned quadHash(const uint8_t* bytes) {
+    uint32_t quad;
+    memcpy(&quad, bytes, 4);
+    return (quad * 0x9E3779B1u) >> 16;
+}
+
+// First bytes, second bytes, byte pairs and 4-byte prefixes that begin some
+// pattern. A one-byte pattern lets any byte follow its first byte.
+static void buildStartFilter(Replacer* replacer, const ReplacePair* pairs, int count) {
+    uint8_t secondBytes[256] = { 0 };
+    for (int i = 0; i < count; i++) {
+        const uint8_t* pattern = (const uint8_t*)pairs[i].pattern;
+        replacer->startsPattern[pattern[0]] = 1;
+        for (unsigned second = 0; second < 256; second++) {
+            if (pairs[i].patternLength == 1 || second == pattern[1]) {
+                unsigned pair = (unsigned)pattern[0] << 8 | second;
+                setBit(replacer->pairStarts, pair);
+                if (pairs[i].patternLength < 4) {
+                    setBit(replacer->shortPairs, pair);
+                }
+                secondBytes[second] = 1;
+            }
+        }
+        if (pairs[i].patternLength >= 4) {
+            setBit(replacer->quadStarts, quadHash(pattern));
+        }
+    }
+    for (int b = 0; b < 256; b++) {
+        if (replacer->startsPattern[b]) {
+            replacer->distinctStarts++;
+            replacer->onlyStart = (unsigned char)b;
+        }
+    }
+    buildNibbleFilter(replacer->startsPattern, replacer->lowNibbleBuckets[0], replacer->highNibbleBuckets[0]);
+    buildNibbleFilter(secondBytes, replacer->lowNibbleBuckets[1], replacer->highNibbleBuckets[1]);
+}
+
+bool replacerInit(Replacer* replacer, const ReplacePair* pairs, int count) {
+    memset(replacer, 0, sizeof(*replacer));
+    size_t totalBytes = 0;
+    for (int i = 0; i < count; i++) {
+        if (pairs[i].patternLength == 0) {
+            printf("Empty pattern in pair %d\n", i);
+            return false;
+        }
+        totalBytes += pairs[i].patternLength;
+    }
+
+    size_t maxNodes = totalBytes + 1;
+    replacer->pairCount = count;
+    replacer->childStart = calloc(maxNodes, sizeof(uint32_t));
+    replacer->childCount = calloc(maxNodes, sizeof(uint16_t));
+    replacer->pairOf = malloc(maxNodes * sizeof(int32_t));
+    replacer->childBytes = malloc(maxNodes);
+    replacer->childNodes = malloc(maxNodes * sizeof(uint32_t));
+    replacer->replacements = calloc(count > 0 ? count : 1, sizeof(char*));
+    replacer->replacementLengths = calloc(count > 0 ? count : 1, sizeof(size_t));
+    SortedPattern* sorted = malloc((count > 0 ? count : 1) * sizeof(SortedPattern));
+    BuildTask* queue = malloc(maxNodes * sizeof(BuildTask));
+    if (replacer->childStart == NULL || replacer->childCount == NULL || replacer->pairOf == NULL ||
+        replacer->childBytes == NULL || replacer->childNodes == NULL ||
+        replacer->replacements == NULL || replacer->replacementLengths == NULL ||
+        sorted == NULL || queue == NULL) {
+        printf("Memory allocation failed\n");
+        free(sorted);
+        free(queue);
+        replacerDestroy(replacer);
+        return false;
+    }
+
+    for (size_t n = 0; n < maxNodes; n++) {
+        replacer->pairOf[n] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        // +1 so a zero-length replacement still gets a valid pointer
+        replacer->replacements[i] = malloc(pairs[i].replacementLength + 1);
+        if (replacer->replacements[i] == NULL) {
+            printf("Memory allocation failed\n");
+            free(sorted);
+            free(queue);
+            replacerDestroy(replacer);
+            return false;
+        }
+        memcpy(replacer->replacements[i], pairs[i].replacement, pairs[i].replacementLength);
+        replacer->replacementLengths[i] = pairs[i].replacementLength;
+        sorted[i] = (SortedPattern){ (const uint8_t*)pairs[i].pattern, pairs[i].patternLength, i };
+        if (pairs[i].patternLength > replacer->longestPattern) {
+            replacer->longestPattern = pairs[i].patternLength;
+        }
+    }
+    qsort(sorted, count, sizeof(SortedPattern), comparePatterns);
+    buildTrie(replacer, sorted, queue);
+    buildStartFilter(replacer, pairs, count);
+    free(sorted);
+    free(queue);
+    return true;
+}
+
+void replacerDestroy(Replacer* replacer) {
+    if (replacer->replacements != NULL) {
+        for (int i = 0; i < replacer->pairCount; i++) {
+            free(replacer->replacements[i]);
+        }
+    }
+    free(replacer->replacements);
+    free(replacer->replacementLengths);
+    free(replacer->childStart);
+    free(replacer->childCount);
+    free(replacer->pairOf);
+    free(replacer->childBytes);
+    free(replacer->childNodes);
+    memset(replacer, 0, sizeof(*replacer));
+}
+
+// ========== Finding Start Positions ==========
+
+// Position k may start a pattern. Bytes are only looked at before `to`;
+// near the end the first byte or the first two have to do.
+static inline bool mayStart(const Replacer* replacer, const uint8_t* bytes, size_t k, size_t to) {
+    if (k + 1 >= to) {
+        return replacer->startsPattern[bytes[k]];
+    }
+    unsigned pair = (unsigned)bytes[k] << 8 | bytes[k + 1];
+    if (!testBit(replacer->pairStarts, pair)) {
+        return false;
+    }
+    // "path" is not "password": most near misses end here, before the trie
+    return k + 4 > to || testBit(replacer->shortPairs, pair) ||
+           testBit(replacer->quadStarts, quadHash(bytes + k));
+}
+
+// mayStart() for every candidate of a block at once. No branch depends on
+// the text, so a block full of near misses costs no mispredictions.
+static inline uint64_t refineCandidates(const Replacer* replacer, const uint8_t* bytes, size_t block,
+                                        uint64_t candidates, size_t length) {
+    uint64_t kept = 0;
+    if (block + 67 > length) {
+        // Near the end: the 4-byte check would read past the text
+        for (; candidates != 0; candidates &= candidates - 1) {
+            unsigned bit = (unsigned)__builtin_ctzll(candidates);
+            kept |= (uint64_t)mayStart(replacer, bytes, block + bit, length) << bit;
+        }
+        return kept;
+    }
+    for (; candidates != 0; candidates &= candidates - 1) {
+        unsigned bit = (unsigned)__builtin_ctzll(candidates);
+        const uint8_t* at = bytes + block + bit;
+        unsigned pair = (unsigned)at[0] << 8 | at[1];
+        unsigned keep = testBit(replacer->pairStarts, pair) &
+                        (testBit(replacer->shortPairs, pair) | testBit(replacer->quadStarts, quadHash(at)));
+        kept |= (uint64_t)keep << bit;
+    }
+    return kept;
+}
+
+// Bit k is set when position k of the block may start a pattern (the SIMD
+// versions allow false positives). Reads 65 bytes: 64 positions and the
+// byte after the last one.
+typedef uint64_t (*StartMaskFunction)(const Replacer* replacer, const char* block);
+
+static uint64_t startMaskScalar(const Replacer* replacer, const char* block) {
+    const uint8_t* bytes = (const uint8_t*)block;
+    uint64_t mask = 0;
+    for (int k = 0; k < 64; k++) {
+        unsigned pair = (unsigned)bytes[k] << 8 | bytes[k + 1];
+        mask |= (uint64_t)testBit(replacer->pairStarts, pair) << k;
+    }
+    return mask;
+}
+
+// One nibble lookup per byte set: lanes whose byte may be in the set are not 0
+#define NIBBLE_LOOKUP_AVX2(bytes, lowTable, highTable, nibble)                                   \
+    _mm256_and_si256(_mm256_shuffle_epi8(lowTable, _mm256_and_si256(bytes, nibble)),              \
+                     _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble)))
+
+__attribute__((target("avx2")))
+static uint64_t startMaskAvx2(const Replacer* replacer, const char* block) {
+    const __m256i firstLow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)replacer->lowNibbleBuckets[0]));
+    const __m256i firstHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)replacer->highNibbleBuckets[0]));
+    const __m256i secondLow = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)replacer->lowNibbleBuckets[1]));
+    const __m256i secondHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)replacer->highNibbleBuckets[1]));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t mask = 0;
+    for (int half = 0; half < 2; half++) {
+        __m256i first = _mm256_loadu_si256((const __m256i*)(block + 32 * half));
+        __m256i second = _mm256_loadu_si256((const __m256i*)(block + 32 * half + 1));
+        // The two lookups use different bucket bits, so each is tested on its own
+        __m256i firstMiss = _mm256_cmpeq_epi8(NIBBLE_LOOKUP_AVX2(first, firstLow, firstHigh, nibble), zero);
+        __m256i secondMiss = _mm256_cmpeq_epi8(NIBBLE_LOOKUP_AVX2(second, secondLow, secondHigh, nibble), zero);
+        uint32_t hits = ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(firstMiss, secondMiss));
+        mask |= (uint64_t)hits << (32 * half);
+    }
+    return mask;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t startMaskAvx512(const Replacer* replacer, const char* block) {
+    const __m512i firstLow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)replacer->lowNibbleBuckets[0]));
+    const __m512i firstHigh = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)replacer->highNibbleBuckets[0]));
+    const __m512i secondLow = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)replacer->lowNibbleBuckets[1]));
+    const __m512i secondHigh = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)replacer->highNibbleBuckets[1]));
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    __m512i first = _mm512_loadu_si512(block);
+    __m512i second = _mm512_loadu_si512(block + 1);
+    __mmask64 firstHit = _mm512_test_epi8_mask(
+        _mm512_shuffle_epi8(firstLow, _mm512_and_si512(first, nibble)),
+        _mm512_shuffle_epi8(firstHigh, _mm512_and_si512(_mm512_srli_epi16(first, 4), nibble)));
+    return _mm512_mask_test_epi8_mask(firstHit,
+        _mm512_shuffle_epi8(secondLow, _mm512_and_si512(second, nibble)),
+        _mm512_shuffle_epi8(secondHigh, _mm512_and_si512(_mm512_srli_epi16(second, 4), nibble)));
+}
+
+DISPATCH_KERNEL(StartMaskFunction, replaceStartMask,
+    DISPATCH_VARIANT(startMaskAvx512, CPU_AVX512F | CPU_AVX512BW),
+    DISPATCH_VARIANT(startMaskAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(startMaskScalar, 0))
+
+// ========== Matching ==========
+
+// Longest pattern starting at text[position]. Returns the pair or -1 and
+// its length in *matchLength. *needMore is set when text ended while a
+// longer pattern could still match.
+static int longestMatch(const Replacer* replacer, const uint8_t* text, size_t position,
+                        size_t length, size_t* matchLength, bool* needMore) {
+    uint32_t node = replacer->rootChild[text[position]];
+    int best = -1;
+    size_t i = position + 1;
+    *needMore = false;
+    while (node != 0) {
+        if (replacer->pairOf[node] >= 0) {
+            best = replacer->pairOf[node];
+            *matchLength = i - position;
+        }
+        int count = replacer->childCount[node];
+        if (count == 0) {
+            break;
+        }
+        if (i == length) {
+            *needMore = true;
+            break;
+        }
+        // Children are sorted by byte; most nodes have one or two
+        const uint8_t* bytes = replacer->childBytes + replacer->childStart[node];
+        uint32_t next = 0;
+        for (int k = 0; k < count && bytes[k] <= text[i]; k++) {
+            if (bytes[k] == text[i]) {
+                next = replacer->childNodes[replacer->childStart[node] + k];
+                break;
+            }
+        }
+        node = next;
+        i++;
+    }
+    return best;
+}
+
+typedef struct {
+    const Replacer* replacer;
+    const char* text;
+    size_t length;
+    bool final;
+    ReplaceSink sink;
+    void* context;
+    size_t* matches;
+    size_t emitted;   // output has been sent for text[0 .. emitted)
+    int status;
+} Scan;
+
+#define SCAN_STOP SIZE_MAX
+
+// Replace the longest match at `position`, if any. Returns its length, 0
+// for no match, or SCAN_STOP when more text is needed or the sink failed.
+static size_t replaceAt(Scan* scan, size_t position) {
+    size_t matchLength = 0;
+    bool needMore;
+    int pair = longestMatch(scan->replacer, (const uint8_t*)scan->text, position, scan->length,
+                            &matchLength, &needMore);
+    if (needMore && !scan->final) {
+        return SCAN_STOP;
+    }
+    if (pair < 0) {
+        return 0;
+    }
+    if (position > scan->emitted &&
+        (scan->status = scan->sink(scan->context, scan->text + scan->emitted, position - scan->emitted)) != 0) {
+        return SCAN_STOP;
+    }
+    scan->emitted = position + matchLength;
+    scan->status = scan->sink(scan->context, scan->replacer->replacements[pair],
+                              scan->replacer->replacementLengths[pair]);
+    if (scan->status != 0) {
+        return SCAN_STOP;
+    }
+    (*scan->matches)++;
+    return matchLength;
+}
+
+// Replace the matches that start in [from, limit); a match may run past
+// limit up to length. Without `final`, stops at a position whose longest
+// match might continue past length. Everything before the returned
+// position has been sent to the sink; a sink error is left in *status.
+static size_t scanText(const Replacer* replacer, const char* text, size_t from, size_t limit,
+                       size_t length, bool final, ReplaceSink sink, void* context,
+                       size_t* matches, int* status) {
+    Scan scan = { replacer, text, length, final, sink, context, matches, from, 0 };
+    const uint8_t* bytes = (const uint8_t*)text;
+    size_t position = from;
+    if (replacer->distinctStarts == 0) {
+        position = limit;
+    }
+    bool stopped = false;
+    while (position < limit && !stopped) {
+        if (position + 65 <= limit) {
+            // 64 positions per kernel call; matches clear the bits they cover
+            size_t block = position;
+            uint64_t candidates = refineCandidates(replacer, bytes, block,
+                                                   replaceStartMask(replacer, text + block), length);
+            position = block + 64;
+            while (candidates != 0) {
+                size_t k = block + (size_t)__builtin_ctzll(candidates);
+                candidates &= candidates - 1;
+                size_t matched = replaceAt(&scan, k);
+                if (matched == SCAN_STOP) {
+                    if (scan.status != 0) {
+                        *status = scan.status;
+                        return scan.emitted;
+                    }
+                    position = k;
+                    stopped = true;
+                    break;
+                }
+                if (matched > 0) {
+                    size_t end = k + matched;
+                    if (end >= block + 64) {
+                        position = end;
+                        break;
+                    }
+                    candidates &= ~0ULL << (end - block);
+                }
+            }
+            continue;
+        }
+        // The last 64 positions, one at a time
+        size_t matched = mayStart(replacer, bytes, position, length) ? replaceAt(&scan, position) : 0;
+        if (matched == SCAN_STOP) {
+            if (scan.status != 0) {
+                *status = scan.status;
+                return scan.emitted;
+            }
+            break;
+        }
+        position += matched > 0 ? matched : 1;
+    }
+    if (position > scan.emitted) {
+        scan.status = sink(context, text + scan.emitted, position - scan.emitted);
+    }
+    *status = scan.status;
+    return position;
+}
+
+// ========== Whole Strings ==========
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} GrowBuffer;
+
+static int appendToBuffer(void* context, const char* data, size_t length) {
+    GrowBuffer* buffer = context;
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t capacity = buffer->capacity * 2;
+        while (capacity < buffer->length + length + 1) {
+            capacity *= 2;
+        }
+        char* grown = realloc(buffer->data, capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    return 0;
+}
+
+char* replaceAll(const Replacer* replacer, const char* text, size_t length, size_t* outLength) {
+    // Redaction usually keeps the size close to the input
+    GrowBuffer buffer = { malloc(length + length / 8 + 16), 0, length + length / 8 + 16 };
+    if (buffer.data == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    size_t matches = 0;
+    int status;
+    scanText(replacer, text, 0, length, length, true, appendToBuffer, &buffer, &matches, &status);
+    if (status != 0) {
+        printf("Memory allocation failed\n");
+        free(buffer.data);
+        return NULL;
+    }
+    buffer.data[buffer.length] = '\0';
+    if (outLength != NULL) {
+        *outLength = buffer.length;
+    }
+    return buffer.data;
+}
+
+static int discardOutput(void* context, const char* data, size_t length) {
+    (void)context;
+    (void)data;
+    (void)length;
+    return 0;
+}
+
+size_t replaceCount(const Replacer* replacer, const char* text, size_t length) {
+    size_t matches = 0;
+    int status;
+    scanText(replacer, text, 0, length, length, true, discardOutput, NULL, &matches, &status);
+    return matches;
+}
+
+// ========== Streaming ==========
+
+bool replaceStreamInit(ReplaceStream* stream, const Replacer* replacer, ReplaceSink sink, void* context) {
+    stream->replacer = replacer;
+    stream->sink = sink;
+    stream->context = context;
+    stream->carryLength = 0;
+    stream->matches = 0;
+    // Held-back bytes (< longest) plus up to `longest` bytes of the next piece
+    stream->carry = malloc(2 * replacer->longestPattern + 1);
+    if (stream->carry == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+void replaceStreamDestroy(ReplaceStream* stream) {
+    free(stream->carry);
+    stream->carry = NULL;
+}
+
+int replaceStreamWrite(ReplaceStream* stream, const char* data, size_t length) {
+    const Replacer* replacer = stream->replacer;
+    size_t offset = 0;
+    int status;
+    if (stream->carryLength > 0) {
+        // Matches starting in the held-back bytes end within `longest` bytes
+        // of the new piece, so only that much is copied behind them
+        size_t held = stream->carryLength;
+        size_t take = length < replacer->longestPattern ? length : replacer->longestPattern;
+        memcpy(stream->carry + held, data, take);
+        size_t reached = scanText(replacer, stream->carry, 0, held, held + take, false,
+                                  stream->sink, stream->context, &stream->matches, &status);
+        if (status != 0) {
+            return status;
+        }
+        if (reached < held) {
+            // Still undecided, which means the whole piece fit behind the carry
+            memmove(stream->carry, stream->carry + reached, held + take - reached);
+            stream->carryLength = held + take - reached;
+            return 0;
+        }
+        offset = reached - held;
+        stream->carryLength = 0;
+    }
+    size_t reached = scanText(replacer, data, offset, length, length, false,
+                              stream->sink, stream->context, &stream->matches, &status);
+    if (status != 0) {
+        return status;
+    }
+    if (reached < length) {
+        memcpy(stream->carry, data + reached, length - reached);
+        stream->carryLength = length - reached;
+    }
+    return 0;
+}
+
+int replaceStreamFinish(ReplaceStream* stream) {
+    int status;
+    scanText(stream->replacer, stream->carry, 0, stream->carryLength, stream->carryLength, true,
+             stream->sink, stream->context, &stream->matches, &status);
+    stream->carryLength = 0;
+    return status;
+}
+
+// ========== File Descriptors ==========
+
+typedef struct {
+    int fd;
+    char* data;
+    size_t used;
+} FileWriter;
+
+static int writeFully(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+// Small pieces are gathered into one write(2); large ones go straight out
+static int writeToFile(void* context, const char* data, size_t length) {
+    FileWriter* writer = context;
+    if (writer->used + length > REPLACE_FILE_BUFFER) {
+        if (writeFully(writer->fd, writer->data, writer->used) != 0) {
+            return -1;
+        }
+        writer->used = 0;
+        if (length >= REPLACE_FILE_BUFFER) {
+            return writeFully(writer->fd, data, length);
+        }
+    }
+    memcpy(writer->data + writer->used, data, length);
+    writer->used += length;
+    return 0;
+}
+
+long long replaceFile(const Replacer* replacer, int inFd, int outFd) {
+    char* input = malloc(REPLACE_FILE_BUFFER);
+    FileWriter writer = { outFd, malloc(REPLACE_FILE_BUFFER), 0 };
+    ReplaceStream stream;
+    if (input == NULL || writer.data == NULL ||
+        !replaceStreamInit(&stream, replacer, writeToFile, &writer)) {
+        free(input);
+        free(writer.data);
+        return -1;
+    }
+
+    int status = 0;
+    while (status == 0) {
+        ssize_t got = read(inFd, input, REPLACE_FILE_BUFFER);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = -1;
+            break;
+        }
+        if (got == 0) {
+            break;
+        }
+        status = replaceStreamWrite(&stream, input, (size_t)got);
+    }
+    if (status == 0) {
+        status = replaceStreamFinish(&stream);
+    }
+    if (status == 0) {
+        status = writeFully(outFd, writer.data, writer.used);
+    }
+    long long matches = status == 0 ? (long long)stream.matches : -1;
+    replaceStreamDestroy(&stream);
+    free(input);
+    free(writer.data);
+    return matches;
+}
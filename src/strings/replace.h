@@ -0,0 +1,115 @@
+/*
+ * replace.h - Streaming Multi-Pattern Search and Replace
+ *
+ * replaceString() in docs/05-strings/01-string-handling.md replaces only the
+ * first match, memmove()s the rest of the string for every replacement and
+ * writes past the caller's buffer when the new text is longer. This module
+ * replaces every match of many patterns in one pass:
+ *
+ * - Replacer: the (pattern -> replacement) pairs, compiled once into a trie
+ * - replaceAll(): whole text in, new malloc'd string out
+ * - ReplaceStream: text in pieces of any size, output to a ReplaceSink
+ *   callback. Only the bytes of a match that may continue in the next piece
+ *   are held back (fewer than the longest pattern), so memory stays constant
+ * - replaceFile(): read(2) from one descriptor, write(2) to another, for
+ *   filtering logs or pipes of any length
+ *
+ * Matching is leftmost-longest and non-overlapping: at each position the
+ * longest pattern that matches wins, and scanning resumes after it, so the
+ * result does not depend on the order of the pairs and replacements are
+ * never rescanned. Patterns and replacements are byte strings with lengths
+ * (ReplacePair); patterns may not be empty.
+ *
+ * Positions where no pattern can start are skipped 64 at a time: pshufb
+ * nibble lookups (AVX2 or AVX-512BW, see ../dispatch/cpu_dispatch.h) test
+ * the byte at each position and the byte after it, so a pattern that starts
+ * with a common letter only stops the scan where its first two bytes appear.
+ *
+ * Compile together with replace.c:
+ *   gcc -O2 -o program program.c replace.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef REPLACE_H
+#define REPLACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    const char* pattern;
+    size_t patternLength;
+    const char* replacement;
+    size_t replacementLength;
+} ReplacePair;
+
+// Receives output in order. Return 0 to continue, anything else to stop;
+// the value is passed back to the caller of the write/finish function.
+typedef int (*ReplaceSink)(void* context, const char* data, size_t length);
+
+typedef struct {
+    // Trie: node 0 is the root; the children of a node are
+    // childBytes/childNodes[childStart .. childStart + childCount)
+    uint32_t* childStart;
+    uint16_t* childCount;
+    int32_t* pairOf;          // pair that ends at this node, or -1
+    uint8_t* childBytes;
+    uint32_t* childNodes;
+    uint32_t rootChild[256];  // root children by byte, 0 = none
+    int nodeCount;
+
+    char** replacements;
+    size_t* replacementLengths;
+    int pairCount;
+    size_t longestPattern;
+
+    // Start filter: the first two bytes of some pattern. Exact tables for
+    // one byte and for byte pairs (a bit per pair), a hashed check of the
+    // first four bytes, and the nibble tables the SIMD scan uses for the
+    // first and the second byte
+    uint8_t startsPattern[256];
+    uint8_t pairStarts[65536 / 8];
+    uint8_t shortPairs[65536 / 8];   // pairs that start a pattern of 1-3 bytes
+    uint8_t quadStarts[65536 / 8];   // hashed first 4 bytes of the longer ones
+    uint8_t lowNibbleBuckets[2][16];
+    uint8_t highNibbleBuckets[2][16];
+    int distinctStarts;
+    unsigned char onlyStart;  // the start byte when distinctStarts == 1
+} Replacer;
+
+// ========== Creation ==========
+
+// Copies the pairs; for duplicate patterns the first pair wins. Returns
+// false for an empty pattern or allocation failure.
+bool replacerInit(Replacer* replacer, const ReplacePair* pairs, int count);
+void replacerDestroy(Replacer* replacer);
+
+// ========== Whole Strings ==========
+
+// New NUL-terminated string (free() it); *outLength gets its length
+char* replaceAll(const Replacer* replacer, const char* text, size_t length, size_t* outLength);
+
+// Number of matches that replaceAll() would replace
+size_t replaceCount(const Replacer* replacer, const char* text, size_t length);
+
+// ========== Streaming ==========
+
+typedef struct {
+    const Replacer* replacer;
+    ReplaceSink sink;
+    void* context;
+    char* carry;              // held-back bytes, then the start of the next piece
+    size_t carryLength;
+    size_t matches;
+} ReplaceStream;
+
+bool replaceStreamInit(ReplaceStream* stream, const Replacer* replacer, ReplaceSink sink, void* context);
+int replaceStreamWrite(ReplaceStream* stream, const char* data, size_t length);
+int replaceStreamFinish(ReplaceStream* stream);   // flushes the held-back bytes
+void replaceStreamDestroy(ReplaceStream* stream);
+
+// Whole descriptor to descriptor with fixed-size buffers. Returns the number
+// of matches, or -1 on a read/write/allocation error.
+long long replaceFile(const Replacer* replacer, int inFd, int outFd);
+
+#endif
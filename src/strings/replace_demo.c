@@ -0,0 +1,431 @@
+/*
+ * Replace Demo: Multi-Pattern Replace-All, Streaming and File Filtering
+ *
+ * Runs the replaceString() example from docs/05-strings/01-string-handling.md
+ * through replace.h, checks replaceAll(), ReplaceStream (split into random
+ * pieces) and replaceFile() against a naive position-by-position version for
+ * every start-byte scanner, then times log redaction on a generated log.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o replace_demo replace_demo.c replace.c ../dispatch/cpu_dispatch.c
+ *   ./replace_demo [log megabytes]
+ *   CPU_DISPATCH=scalar ./replace_demo      (table scan only)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "replace.h"
+#include "../dispatch/cpu_dispatch.h"
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ========== Reference Versions ==========
+
+// replaceString() from the docs
+static void replaceString(char* str, const char* old, const char* new) {
+    char* pos = strstr(str, old);
+    if (pos != NULL) {
+        int oldLen = strlen(old);
+        int newLen = strlen(new);
+        if (newLen > oldLen) {
+            memmove(pos + newLen, pos + oldLen, strlen(pos + oldLen) + 1);
+        }
+        memcpy(pos, new, newLen);
+    }
+}
+
+// Try every pattern at every position: longest wins, then the first pair
+static char* replaceNaive(const ReplacePair* pairs, int count, const char* text, size_t length,
+                          size_t* outLength) {
+    size_t capacity = length + 16;
+    size_t used = 0;
+    char* out = malloc(capacity);
+    if (out == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    size_t position = 0;
+    while (position < length) {
+        int best = -1;
+        for (int i = 0; i < count; i++) {
+            size_t n = pairs[i].patternLength;
+            if (n <= length - position && memcmp(text + position, pairs[i].pattern, n) == 0 &&
+                (best < 0 || n > pairs[best].patternLength)) {
+                best = i;
+            }
+        }
+        const char* piece = best < 0 ? text + position : pairs[best].replacement;
+        size_t pieceLength = best < 0 ? 1 : pairs[best].replacementLength;
+        if (used + pieceLength + 1 > capacity) {
+            capacity = (used + pieceLength + 1) * 2;
+            char* grown = realloc(out, capacity);
+            if (grown == NULL) {
+                printf("Memory allocation failed\n");
+                free(out);
+                return NULL;
+            }
+            out = grown;
+        }
+        memcpy(out + used, piece, pieceLength);
+        used += pieceLength;
+        position += best < 0 ? 1 : pairs[best].patternLength;
+    }
+    out[used] = '\0';
+    *outLength = used;
+    return out;
+}
+
+static ReplacePair pair(const char* pattern, const char* replacement) {
+    return (ReplacePair){ pattern, strlen(pattern), replacement, strlen(replacement) };
+}
+
+// ========== Examples ==========
+
+static void showExamples(void) {
+    printf("\n=== Examples ===\n");
+    char str[100] = "Hello World";
+    replaceString(str, "World", "C Programming");
+    printf("docs replaceString: %s\n", str);
+
+    Replacer replacer;
+    ReplacePair pairs[] = { pair("World", "C Programming"), pair("o", "0") };
+    if (replacerInit(&replacer, pairs, 2)) {
+        char* result = replaceAll(&replacer, "Hello World, hello world", 24, NULL);
+        printf("replaceAll:         %s\n", result);
+        free(result);
+        replacerDestroy(&replacer);
+    }
+
+    // Leftmost-longest: "secret_key" wins over "secret" at the same position
+    ReplacePair redact[] = {
+        pair("secret", "[REDACTED]"), pair("secret_key=", "secret_key=[KEY]"),
+        pair("alice@example.com", "<email>"), pair("4111-1111-1111-1111", "<card>")
+    };
+    if (replacerInit(&replacer, redact, 4)) {
+        const char* line = "user=alice@example.com secret_key=abc card=4111-1111-1111-1111 secret";
+        char* result = replaceAll(&replacer, line, strlen(line), NULL);
+        printf("in:  %s\nout: %s\n", line, result);
+        free(result);
+        replacerDestroy(&replacer);
+    }
+}
+
+// ========== Checks ==========
+
+typedef struct {
+    char* data;
+    size_t length;
+} Collected;
+
+static int collect(void* context, const char* data, size_t length) {
+    Collected* out = context;
+    memcpy(out->data + out->length, data, length);
+    out->length += length;
+    return 0;
+}
+
+// replaceAll, a randomly split stream and replaceFile, all against replaceNaive
+static bool checkOne(const Replacer* replacer, const ReplacePair* pairs, int count,
+                     const char* text, size_t length, unsigned* seed) {
+    size_t expectedLength, gotLength;
+    char* expected = replaceNaive(pairs, count, text, length, &expectedLength);
+    char* got = replaceAll(replacer, text, length, &gotLength);
+    bool ok = expected != NULL && got != NULL && gotLength == expectedLength &&
+              memcmp(got, expected, gotLength) == 0;
+    free(got);
+
+    // Pieces of 0..40 bytes, so matches straddle piece boundaries
+    Collected streamed = { malloc(expectedLength + 1), 0 };
+    ReplaceStream stream;
+    if (streamed.data != NULL && replaceStreamInit(&stream, replacer, collect, &streamed)) {
+        size_t position = 0;
+        while (position < length) {
+            size_t piece = nextRandom(seed) % 41;
+            if (piece > length - position) {
+                piece = length - position;
+            }
+            replaceStreamWrite(&stream, text + position, piece);
+            position += piece;
+        }
+        replaceStreamFinish(&stream);
+        replaceStreamDestroy(&stream);
+        ok = ok && streamed.length == expectedLength &&
+             memcmp(streamed.data, expected, expectedLength) == 0;
+    } else {
+        ok = false;
+    }
+    free(streamed.data);
+    free(expected);
+    return ok;
+}
+
+static bool checkFile(const Replacer* replacer, const ReplacePair* pairs, int count,
+                      const char* text, size_t length) {
+    FILE* in = tmpfile();
+    FILE* out = tmpfile();
+    if (in == NULL || out == NULL) {
+        printf("Cannot open temporary file\n");
+        return false;
+    }
+    fwrite(text, 1, length, in);
+    fflush(in);
+    rewind(in);
+    long long matches = replaceFile(replacer, fileno(in), fileno(out));
+
+    size_t expectedLength;
+    char* expected = replaceNaive(pairs, count, text, length, &expectedLength);
+    char* got = malloc(expectedLength + 1);
+    rewind(out);
+    size_t gotLength = got != NULL ? fread(got, 1, expectedLength + 1, out) : 0;
+    bool ok = expected != NULL && got != NULL && gotLength == expectedLength &&
+              memcmp(got, expected, expectedLength) == 0 &&
+              matches == (long long)replaceCount(replacer, text, length);
+    free(expected);
+    free(got);
+    fclose(in);
+    fclose(out);
+    return ok;
+}
+
+static bool runChecks(unsigned* seed) {
+    printf("\n=== Checks Against the Naive Version ===\n");
+    // Patterns over a small alphabet overlap and share prefixes a lot; the
+    // "wide" sets start with bytes in all 16 high nibbles (more than the 8
+    // filter buckets) so the SIMD filter has false positives to remove
+    const char alphabet[] = "abcab\x80\xff ";
+    char text[600];
+    char patterns[12][8];
+    char replacements[12][8];
+    ReplacePair pairs[12];
+    const DispatchKernel* kernel = dispatchFind("replaceStartMask");
+    bool ok = true;
+    int sets = 0;
+
+    for (int round = 0; round < 300; round++) {
+        int count = 1 + nextRandom(seed) % 12;
+        bool wide = round % 3 == 2;
+        for (int i = 0; i < count; i++) {
+            size_t n = 1 + nextRandom(seed) % 6;
+            for (size_t k = 0; k < n; k++) {
+                patterns[i][k] = wide && k == 0 ? (char)(nextRandom(seed) % 256)
+                                               : alphabet[nextRandom(seed) % 8];
+            }
+            if (patterns[i][0] == '\0') {
+                patterns[i][0] = 'a';
+            }
+            size_t r = nextRandom(seed) % 5;
+            memset(replacements[i], 'X' + i % 3, r);
+            pairs[i] = (ReplacePair){ patterns[i], n, replacements[i], r };
+        }
+        size_t length = nextRandom(seed) % sizeof(text);
+        for (size_t k = 0; k < length; k++) {
+            text[k] = alphabet[nextRandom(seed) % 8];
+            if (wide && nextRandom(seed) % 4 == 0) {
+                text[k] = (char)(nextRandom(seed) % 256);
+            }
+        }
+
+        Replacer replacer;
+        if (!replacerInit(&replacer, pairs, count)) {
+            return false;
+        }
+        for (int v = 0; v < kernel->variantCount; v++) {
+            if (dispatchUseVariant(kernel, v)) {
+                ok = ok && checkOne(&replacer, pairs, count, text, length, seed);
+            }
+        }
+        dispatchRestore(kernel);
+        if (round % 50 == 0) {
+            ok = ok && checkFile(&replacer, pairs, count, text, length);
+        }
+        replacerDestroy(&replacer);
+        sets++;
+    }
+
+    Replacer replacer;
+    ReplacePair empty = pair("", "x");
+    printf("empty pattern rejected: %s\n", replacerInit(&replacer, &empty, 1) ? "no" : "yes");
+    printf("%d random pattern sets, every scanner, stream and file: %s\n", sets,
+           ok ? "all match" : "MISMATCH");
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+static const char* users[] = { "alice", "bob", "carol", "dave", "erin", "frank" };
+
+static size_t makeLog(char* log, size_t size, unsigned* seed) {
+    size_t used = 0;
+    while (used + 200 < size) {
+        unsigned r = nextRandom(seed);
+        const char* user = users[r % 6];
+        int n;
+        if (r % 50 == 0) {
+            n = sprintf(log + used, "2024-05-01T12:%02u:%02u INFO login user=%s@example.com "
+                        "password=hunter2 from 10.0.%u.%u\n", r % 60, (r >> 8) % 60, user,
+                        (r >> 4) % 256, (r >> 12) % 256);
+        } else if (r % 50 == 1) {
+            n = sprintf(log + used, "2024-05-01T12:%02u:%02u INFO payment card=4111-1111-1111-1111 "
+                        "amount=%u.%02u user=%s\n", r % 60, (r >> 8) % 60, r % 1000, r % 100, user);
+        } else {
+            n = sprintf(log + used, "2024-05-01T12:%02u:%02u DEBUG request id=%08x path=/api/v1/items/%u "
+                        "status=200 latency_ms=%u user=%s\n", r % 60, (r >> 8) % 60, r, r % 10000,
+                        r % 500, user);
+        }
+        used += (size_t)n;
+    }
+    return used;
+}
+
+static int discard(void* context, const char* data, size_t length) {
+    (void)data;
+    *(size_t*)context += length;
+    return 0;
+}
+
+static void benchmark(size_t megabytes, unsigned* seed) {
+    size_t size = megabytes << 20;
+    char* log = malloc(size + 1);
+    if (log == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    size_t length = makeLog(log, size, seed);
+    log[length] = '\0';
+
+    ReplacePair pairs[] = {
+        pair("password=hunter2", "password=***"),
+        pair("4111-1111-1111-1111", "****-****-****-1111"),
+        pair("alice@example.com", "<user>"), pair("bob@example.com", "<user>"),
+        pair("carol@example.com", "<user>"), pair("dave@example.com", "<user>"),
+        pair("erin@example.com", "<user>"), pair("frank@example.com", "<user>"),
+        pair("10.0.", "x.x."), pair("Bearer ", "Bearer <token> "),
+        pair("ssn=", "ssn=<redacted>"), pair("api_key=", "api_key=<redacted>")
+    };
+    int count = sizeof(pairs) / sizeof(pairs[0]);
+    Replacer replacer;
+    if (!replacerInit(&replacer, pairs, count)) {
+        free(log);
+        return;
+    }
+    printf("\n=== Redacting a %.1f MB log with %d pairs (GB/s) ===\n", length / 1048576.0, count);
+
+    struct timespec start, end;
+    size_t expectedLength;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    char* expected = replaceNaive(pairs, count, log, length, &expectedLength);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end);
+    printf("%-34s %7.2f\n", "every pattern at every position", length / baseline / 1e9);
+
+    const DispatchKernel* kernel = dispatchFind("replaceStartMask");
+    for (int v = kernel->variantCount - 1; v >= 0; v--) {
+        const DispatchVariant* variant = &kernel->variants[v];
+        if (!dispatchUseVariant(kernel, v)) {
+            printf("replaceAll, %-22s %7s\n", variant->name, "skipped");
+            continue;
+        }
+        size_t gotLength;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        char* got = replaceAll(&replacer, log, length, &gotLength);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        bool same = got != NULL && expected != NULL && gotLength == expectedLength &&
+                    memcmp(got, expected, gotLength) == 0;
+        printf("replaceAll, %-22s %7.2f %6.1fx %s%s\n", variant->name, length / seconds / 1e9,
+               baseline / seconds, same ? "ok" : "WRONG", variant == kernel->chosen ? "  <- chosen" : "");
+        free(got);
+    }
+    dispatchRestore(kernel);
+
+    // Streaming in 64 KB pieces, output counted and dropped
+    size_t streamedBytes = 0;
+    ReplaceStream stream;
+    if (replaceStreamInit(&stream, &replacer, discard, &streamedBytes)) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t position = 0; position < length; position += 65536) {
+            size_t piece = length - position < 65536 ? length - position : 65536;
+            replaceStreamWrite(&stream, log + position, piece);
+        }
+        replaceStreamFinish(&stream);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        printf("%-34s %7.2f %6.1fx %s (%zu matches)\n", "ReplaceStream, 64 KB pieces", length / seconds / 1e9,
+               baseline / seconds, streamedBytes == expectedLength ? "ok" : "WRONG", stream.matches);
+        replaceStreamDestroy(&stream);
+    }
+
+    // File to /dev/null through read(2)/write(2)
+    FILE* in = tmpfile();
+    FILE* out = fopen("/dev/null", "w");
+    if (in != NULL && out != NULL) {
+        fwrite(log, 1, length, in);
+        fflush(in);
+        rewind(in);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long long matches = replaceFile(&replacer, fileno(in), fileno(out));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        printf("%-34s %7.2f %6.1fx (%lld matches)\n", "replaceFile, tmpfile -> /dev/null",
+               length / seconds / 1e9, baseline / seconds, matches);
+    }
+    if (in != NULL) {
+        fclose(in);
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+
+    // The docs version, looped until no match is left. Each call starts
+    // over at the beginning and moves the whole tail, so only 256 KB.
+    size_t small = length < (256 << 10) ? length : (256 << 10);
+    char* copy = malloc(small + 1);
+    if (copy != NULL) {
+        memcpy(copy, log, small);
+        copy[small] = '\0';
+        int replaced = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (strstr(copy, "password=hunter2") != NULL) {
+            replaceString(copy, "password=hunter2", "password=***");
+            replaced++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsedSeconds(start, end);
+        printf("%-34s %7.3f  (1 pattern, 256 KB, %d matches)\n", "docs replaceString in a loop",
+               small / seconds / 1e9, replaced);
+        free(copy);
+    }
+
+    free(expected);
+    replacerDestroy(&replacer);
+    free(log);
+}
+
+int main(int argc, char* argv[]) {
+    long megabytes = argc > 1 ? atol(argv[1]) : 64;
+    if (megabytes < 1) {
+        printf("Usage: %s [log megabytes]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+    showExamples();
+    unsigned seed = 2463534242u;
+    bool ok = runChecks(&seed);
+    benchmark((size_t)megabytes, &seed);
+    return ok ? 0 : 1;
+}
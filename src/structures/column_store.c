@@ -0,0 +1,732 @@
+/*
+ * column_store.c - Columnar (Struct-of-Arrays) Record Store (see column_store.h)
+ */
+
+#include "column_store.h"
+#include "../dispatch/cpu_dispatch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+#define CACHE_LINE 64
+#define SELECTION_SLACK 16   // a full AVX-512 vector of row numbers past the end
+
+// ========== String Dictionary ==========
+
+static uint32_t hashString(const char* s) {
+    uint32_t hash = 2166136261u;   // FNV-1a
+    while (*s != '\0') {
+        hash = (hash ^ (unsigned char)*s++) * 16777619u;
+    }
+    return hash;
+}
+
+static bool dictionaryInit(StringDictionary* d) {
+    d->arenaCapacity = 4096;
+    d->arenaUsed = 0;
+    d->arena = malloc(d->arenaCapacity);
+    d->capacity = 64;
+    d->count = 0;
+    d->offsets = malloc(d->capacity * sizeof(uint32_t));
+    d->slotMask = 127;
+    d->slots = calloc(d->slotMask + 1, sizeof(uint32_t));
+    if (d->arena == NULL || d->offsets == NULL || d->slots == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+static void dictionaryFree(StringDictionary* d) {
+    free(d->arena);
+    free(d->offsets);
+    free(d->slots);
+}
+
+static const char* dictionaryString(const StringDictionary* d, uint32_t code) {
+    return d->arena + d->offsets[code];
+}
+
+// Slot holding `value`, or the empty slot where it would go
+static uint32_t* dictionarySlot(const StringDictionary* d, const char* value) {
+    uint32_t i = hashString(value) & d->slotMask;
+    while (d->slots[i] != 0 && strcmp(dictionaryString(d, d->slots[i] - 1), value) != 0) {
+        i = (i + 1) & d->slotMask;
+    }
+    return &d->slots[i];
+}
+
+static bool dictionaryGrowSlots(StringDictionary* d) {
+    uint32_t* old = d->slots;
+    uint32_t oldSize = d->slotMask + 1;
+    d->slots = calloc((size_t)oldSize * 2, sizeof(uint32_t));
+    if (d->slots == NULL) {
+        printf("Memory allocation failed\n");
+        d->slots = old;
+        return false;
+    }
+    d->slotMask = oldSize * 2 - 1;
+    for (uint32_t i = 0; i < oldSize; i++) {
+        if (old[i] != 0) {
+            *dictionarySlot(d, dictionaryString(d, old[i] - 1)) = old[i];
+        }
+    }
+    free(old);
+    return true;
+}
+
+// Code of `value`, added if new; UINT32_MAX when memory runs out
+static uint32_t dictionaryIntern(StringDictionary* d, const char* value) {
+    uint32_t* slot = dictionarySlot(d, value);
+    if (*slot != 0) {
+        return *slot - 1;
+    }
+    size_t length = strlen(value) + 1;
+    if (d->arenaUsed + length > d->arenaCapacity) {
+        size_t capacity = d->arenaCapacity * 2 > d->arenaUsed + length ? d->arenaCapacity * 2 : d->arenaUsed + length;
+        char* arena = realloc(d->arena, capacity);
+        if (arena == NULL) {
+            printf("Memory allocation failed\n");
+            return UINT32_MAX;
+        }
+        d->arena = arena;
+        d->arenaCapacity = capacity;
+    }
+    if (d->count == d->capacity) {
+        uint32_t* offsets = realloc(d->offsets, (size_t)d->capacity * 2 * sizeof(uint32_t));
+        if (offsets == NULL) {
+            printf("Memory allocation failed\n");
+            return UINT32_MAX;
+        }
+        d->offsets = offsets;
+        d->capacity *= 2;
+    }
+    uint32_t code = d->count++;
+    d->offsets[code] = (uint32_t)d->arenaUsed;
+    memcpy(d->arena + d->arenaUsed, value, length);
+    d->arenaUsed += length;
+    *slot = code + 1;
+    // Keep the table at most half full
+    if ((size_t)d->count * 2 > (size_t)d->slotMask + 1 && !dictionaryGrowSlots(d)) {
+        return UINT32_MAX;
+    }
+    return code;
+}
+
+static uint32_t dictionaryFind(const StringDictionary* d, const char* value) {
+    uint32_t slot = *dictionarySlot(d, value);
+    return slot != 0 ? slot - 1 : UINT32_MAX;
+}
+
+// ========== Building ==========
+
+bool storeInit(ColumnStore* store, const FieldSpec* schema, int fieldCount) {
+    store->columns = calloc(fieldCount > 0 ? fieldCount : 1, sizeof(Column));
+    store->columnCount = 0;
+    store->rowCount = 0;
+    store->capacity = 0;
+    if (store->columns == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    for (int c = 0; c < fieldCount; c++) {
+        Column* column = &store->columns[c];
+        snprintf(column->name, sizeof(column->name), "%s", schema[c].name);
+        column->type = schema[c].type;
+        store->columnCount++;
+        if (column->type == COLUMN_STRING) {
+            column->dictionary = calloc(1, sizeof(StringDictionary));
+            if (column->dictionary == NULL) {
+                printf("Memory allocation failed\n");
+                storeFree(store);
+                return false;
+            }
+            if (!dictionaryInit(column->dictionary) ||
+                dictionaryIntern(column->dictionary, "") != 0) {
+                storeFree(store);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void storeFree(ColumnStore* store) {
+    for (int c = 0; c < store->columnCount; c++) {
+        free(store->columns[c].values);
+        if (store->columns[c].dictionary != NULL) {
+            dictionaryFree(store->columns[c].dictionary);
+            free(store->columns[c].dictionary);
+        }
+    }
+    free(store->columns);
+    store->columns = NULL;
+    store->columnCount = 0;
+    store->rowCount = store->capacity = 0;
+}
+
+int storeFindColumn(const ColumnStore* store, const char* name) {
+    for (int c = 0; c < store->columnCount; c++) {
+        if (strcmp(store->columns[c].name, name) == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// Every column type is 4 bytes wide, and 0 bits mean 0, 0.0f and code 0 ("")
+bool storeAddRows(ColumnStore* store, size_t count) {
+    if (count == 0) {
+        return true;   // a new store has no column arrays to touch yet
+    }
+    if (count >= UINT32_MAX - store->rowCount) {
+        printf("Too many rows for 32-bit row numbers\n");
+        return false;
+    }
+    size_t rows = store->rowCount + count;
+    if (rows > store->capacity) {
+        size_t capacity = store->capacity * 2 > rows ? store->capacity * 2 : rows;
+        capacity = (capacity + 15) & ~(size_t)15;   // whole cache lines
+        for (int c = 0; c < store->columnCount; c++) {
+            void* values = aligned_alloc(CACHE_LINE, capacity * sizeof(uint32_t));
+            if (values == NULL) {
+                printf("Memory allocation failed\n");
+                return false;
+            }
+            if (store->columns[c].values != NULL) {
+                memcpy(values, store->columns[c].values, store->rowCount * sizeof(uint32_t));
+                free(store->columns[c].values);
+            }
+            store->columns[c].values = values;
+        }
+        store->capacity = capacity;
+    }
+    for (int c = 0; c < store->columnCount; c++) {
+        memset((uint32_t*)store->columns[c].values + store->rowCount, 0, count * sizeof(uint32_t));
+    }
+    store->rowCount = rows;
+    return true;
+}
+
+void storeSetInt(ColumnStore* store, int column, size_t row, int32_t value) {
+    ((int32_t*)store->columns[column].values)[row] = value;
+}
+
+void storeSetFloat(ColumnStore* store, int column, size_t row, float value) {
+    ((float*)store->columns[column].values)[row] = value;
+}
+
+bool storeSetString(ColumnStore* store, int column, size_t row, const char* value) {
+    uint32_t code = dictionaryIntern(store->columns[column].dictionary, value);
+    if (code == UINT32_MAX) {
+        return false;
+    }
+    ((uint32_t*)store->columns[column].values)[row] = code;
+    return true;
+}
+
+int32_t storeGetInt(const ColumnStore* store, int column, size_t row) {
+    return ((const int32_t*)store->columns[column].values)[row];
+}
+
+float storeGetFloat(const ColumnStore* store, int column, size_t row) {
+    return ((const float*)store->columns[column].values)[row];
+}
+
+const char* storeGetString(const ColumnStore* store, int column, size_t row) {
+    const Column* c = &store->columns[column];
+    return dictionaryString(c->dictionary, ((const uint32_t*)c->values)[row]);
+}
+
+uint32_t storeDistinctCount(const ColumnStore* store, int column) {
+    return store->columns[column].dictionary->count;
+}
+
+const char* storeDistinctString(const ColumnStore* store, int column, uint32_t code) {
+    return dictionaryString(store->columns[column].dictionary, code);
+}
+
+// ========== Filter Kernels ==========
+//
+// Each kernel writes the index of every value with low <= value <= high
+// (or outside that range, for COMPARE_NE) to rows[] and returns how many.
+// Vector variants compute a match mask per vector and store the row numbers
+// of the matching lanes packed together: a full vector is written and the
+// output advances by the number of matches, so rows[] needs SELECTION_SLACK
+// spare entries.
+
+typedef size_t (*FilterInt32Function)(const int32_t* values, size_t count, int32_t low, int32_t high,
+                                      bool outside, uint32_t* rows);
+typedef size_t (*FilterFloatFunction)(const float* values, size_t count, float low, float high,
+                                      bool outside, uint32_t* rows);
+
+// low <= v <= high as one unsigned compare: v - low wraps above high - low
+// when v < low
+static size_t filterInt32From(const int32_t* values, size_t i, size_t count, int32_t low, int32_t high,
+                              bool outside, uint32_t* rows, size_t n) {
+    uint32_t span = (uint32_t)high - (uint32_t)low;
+    for (; i < count; i++) {
+        rows[n] = (uint32_t)i;
+        n += ((uint32_t)values[i] - (uint32_t)low <= span) != outside;
+    }
+    return n;
+}
+
+static size_t filterInt32Scalar(const int32_t* values, size_t count, int32_t low, int32_t high,
+                                bool outside, uint32_t* rows) {
+    return filterInt32From(values, 0, count, low, high, outside, rows, 0);
+}
+
+static size_t filterFloatFrom(const float* values, size_t i, size_t count, float low, float high,
+                              bool outside, uint32_t* rows, size_t n) {
+    for (; i < count; i++) {
+        rows[n] = (uint32_t)i;
+        n += (values[i] >= low && values[i] <= high) != outside;
+    }
+    return n;
+}
+
+static size_t filterFloatScalar(const float* values, size_t count, float low, float high,
+                                bool outside, uint32_t* rows) {
+    return filterFloatFrom(values, 0, count, low, high, outside, rows, 0);
+}
+
+// compressTable[mask] = the lanes set in an 8-bit mask, packed to the front
+static uint8_t compressTable[256][8];
+
+__attribute__((constructor)) static void buildCompressTable(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int n = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) {
+                compressTable[mask][n++] = (uint8_t)lane;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline size_t compressRowsAvx2(uint32_t* rows, size_t n, __m256i index, unsigned mask) {
+    __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)compressTable[mask]));
+    _mm256_storeu_si256((__m256i*)(rows + n), _mm256_permutevar8x32_epi32(index, lanes));
+    return n + (size_t)__builtin_popcount(mask);
+}
+
+// AVX2 has no unsigned compare: x <= span exactly when min(x, span) == x
+__attribute__((target("avx2")))
+static size_t filterInt32Avx2(const int32_t* values, size_t count, int32_t low, int32_t high,
+                              bool outside, uint32_t* rows) {
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i span = _mm256_set1_epi32((int32_t)((uint32_t)high - (uint32_t)low));
+    const __m256i step = _mm256_set1_epi32(8);
+    const unsigned flip = outside ? 0xFF : 0;
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0, n = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(values + i)), lowVector);
+        __m256i inside = _mm256_cmpeq_epi32(_mm256_min_epu32(x, span), x);
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(inside)) ^ flip;
+        n = compressRowsAvx2(rows, n, index, mask);
+        index = _mm256_add_epi32(index, step);
+    }
+    return filterInt32From(values, i, count, low, high, outside, rows, n);
+}
+
+__attribute__((target("avx2")))
+static size_t filterFloatAvx2(const float* values, size_t count, float low, float high,
+                              bool outside, uint32_t* rows) {
+    const __m256 lowVector = _mm256_set1_ps(low);
+    const __m256 highVector = _mm256_set1_ps(high);
+    const __m256i step = _mm256_set1_epi32(8);
+    const unsigned flip = outside ? 0xFF : 0;
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0, n = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(values + i);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x, lowVector, _CMP_GE_OQ),
+                                      _mm256_cmp_ps(x, highVector, _CMP_LE_OQ));
+        unsigned mask = (unsigned)_mm256_movemask_ps(inside) ^ flip;
+        n = compressRowsAvx2(rows, n, index, mask);
+        index = _mm256_add_epi32(index, step);
+    }
+    return filterFloatFrom(values, i, count, low, high, outside, rows, n);
+}
+
+// vpcompressd packs the lanes in a register; a plain store afterwards is
+// faster than the memory form of the instruction on some CPUs
+__attribute__((target("avx512f")))
+static size_t filterInt32Avx512(const int32_t* values, size_t count, int32_t low, int32_t high,
+                                bool outside, uint32_t* rows) {
+    const __m512i lowVector = _mm512_set1_epi32(low);
+    const __m512i span = _mm512_set1_epi32((int32_t)((uint32_t)high - (uint32_t)low));
+    const __m512i step = _mm512_set1_epi32(16);
+    const __mmask16 flip = outside ? 0xFFFF : 0;
+    __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t i = 0, n = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_sub_epi32(_mm512_loadu_si512(values + i), lowVector);
+        __mmask16 mask = _mm512_cmple_epu32_mask(x, span) ^ flip;
+        _mm512_storeu_si512(rows + n, _mm512_maskz_compress_epi32(mask, index));
+        n += (size_t)__builtin_popcount(mask);
+        index = _mm512_add_epi32(index, step);
+    }
+    return filterInt32From(values, i, count, low, high, outside, rows, n);
+}
+
+__attribute__((target("avx512f")))
+static size_t filterFloatAvx512(const float* values, size_t count, float low, float high,
+                                bool outside, uint32_t* rows) {
+    const __m512 lowVector = _mm512_set1_ps(low);
+    const __m512 highVector = _mm512_set1_ps(high);
+    const __m512i step = _mm512_set1_epi32(16);
+    const __mmask16 flip = outside ? 0xFFFF : 0;
+    __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t i = 0, n = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_loadu_ps(values + i);
+        __mmask16 mask = (_mm512_cmp_ps_mask(x, lowVector, _CMP_GE_OQ) &
+                          _mm512_cmp_ps_mask(x, highVector, _CMP_LE_OQ)) ^ flip;
+        _mm512_storeu_si512(rows + n, _mm512_maskz_compress_epi32(mask, index));
+        n += (size_t)__builtin_popcount(mask);
+        index = _mm512_add_epi32(index, step);
+    }
+    return filterFloatFrom(values, i, count, low, high, outside, rows, n);
+}
+
+DISPATCH_KERNEL(FilterInt32Function, filterInt32,
+    DISPATCH_VARIANT(filterInt32Avx512, CPU_AVX512F),
+    DISPATCH_VARIANT(filterInt32Avx2, CPU_AVX2),
+    DISPATCH_VARIANT(filterInt32Scalar, 0))
+
+DISPATCH_KERNEL(FilterFloatFunction, filterFloat,
+    DISPATCH_VARIANT(filterFloatAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(filterFloatAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(filterFloatScalar, 0))
+
+// ========== Sum Kernels ==========
+
+typedef int64_t (*SumInt32Function)(const int32_t* values, size_t count);
+typedef double (*SumFloatFunction)(const float* values, size_t count);
+
+static int64_t sumInt32Scalar(const int32_t* values, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+// Floats are added as doubles, so a sum over 50M rows keeps its low digits
+static double sumFloatScalar(const float* values, size_t count) {
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+// Each int32 lane widened to int64 before adding: no overflow before 2^32 rows
+__attribute__((target("avx2")))
+static int64_t sumInt32Avx2(const int32_t* values, size_t count) {
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        sum0 = _mm256_add_epi64(sum0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+        sum1 = _mm256_add_epi64(sum1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(sum0, sum1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumInt32Scalar(values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static double sumFloatAvx2(const float* values, size_t count) {
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(values + i);
+        sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumFloatScalar(values + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static int64_t sumInt32Avx512(const int32_t* values, size_t count) {
+    __m512i sum0 = _mm512_setzero_si512(), sum1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_loadu_si512(values + i);
+        sum0 = _mm512_add_epi64(sum0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+        sum1 = _mm512_add_epi64(sum1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+    }
+    return _mm512_reduce_add_epi64(_mm512_add_epi64(sum0, sum1)) + sumInt32Scalar(values + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static double sumFloatAvx512(const float* values, size_t count) {
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 x = _mm512_loadu_ps(values + i);
+        sum0 = _mm512_add_pd(sum0, _mm512_cvtps_pd(_mm512_castps512_ps256(x)));
+        sum1 = _mm512_add_pd(sum1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1))));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1)) + sumFloatScalar(values + i, count - i);
+}
+
+DISPATCH_KERNEL(SumInt32Function, sumInt32,
+    DISPATCH_VARIANT(sumInt32Avx512, CPU_AVX512F),
+    DISPATCH_VARIANT(sumInt32Avx2, CPU_AVX2),
+    DISPATCH_VARIANT(sumInt32Scalar, 0))
+
+DISPATCH_KERNEL(SumFloatFunction, sumFloat,
+    DISPATCH_VARIANT(sumFloatAvx512, CPU_AVX512F),
+    DISPATCH_VARIANT(sumFloatAvx2, CPU_AVX2),
+    DISPATCH_VARIANT(sumFloatScalar, 0))
+
+// ========== Queries ==========
+
+bool selectionInit(Selection* selection, size_t capacity) {
+    selection->rows = malloc((capacity + SELECTION_SLACK) * sizeof(uint32_t));
+    selection->count = 0;
+    selection->capacity = capacity;
+    if (selection->rows == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+void selectionFree(Selection* selection) {
+    free(selection->rows);
+    selection->rows = NULL;
+    selection->count = selection->capacity = 0;
+}
+
+static bool selectionReserve(Selection* selection, size_t capacity) {
+    if (capacity <= selection->capacity) {
+        return true;
+    }
+    uint32_t* rows = realloc(selection->rows, (capacity + SELECTION_SLACK) * sizeof(uint32_t));
+    if (rows == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    selection->rows = rows;
+    selection->capacity = capacity;
+    return true;
+}
+
+// Refining keeps the rows of `within` that match. Writing never overtakes
+// reading, so `result` may be `within`.
+static bool selectRange(const ColumnStore* store, int column, int32_t low, int32_t high, bool outside,
+                        const Selection* within, Selection* result) {
+    const int32_t* values = store->columns[column].values;
+    if (within == NULL) {
+        if (!selectionReserve(result, store->rowCount)) {
+            return false;
+        }
+        result->count = filterInt32(values, store->rowCount, low, high, outside, result->rows);
+        return true;
+    }
+    if (!selectionReserve(result, within->count)) {
+        return false;
+    }
+    uint32_t span = (uint32_t)high - (uint32_t)low;
+    size_t n = 0;
+    for (size_t i = 0; i < within->count; i++) {
+        uint32_t row = within->rows[i];
+        result->rows[n] = row;
+        n += ((uint32_t)values[row] - (uint32_t)low <= span) != outside;
+    }
+    result->count = n;
+    return true;
+}
+
+static bool selectNothing(Selection* result) {
+    result->count = 0;
+    return true;
+}
+
+static bool selectEverything(const ColumnStore* store, const Selection* within, Selection* result) {
+    if (!selectionReserve(result, within != NULL ? within->count : store->rowCount)) {
+        return false;
+    }
+    if (within == NULL) {
+        for (size_t i = 0; i < store->rowCount; i++) {
+            result->rows[i] = (uint32_t)i;
+        }
+        result->count = store->rowCount;
+    } else if (within != result) {
+        memcpy(result->rows, within->rows, within->count * sizeof(uint32_t));
+        result->count = within->count;
+    }
+    return true;
+}
+
+// Every comparison becomes an inclusive range [low, high], or its outside
+// for COMPARE_NE
+bool storeSelectInt(const ColumnStore* store, int column, CompareOp op, int32_t value,
+                    const Selection* within, Selection* result) {
+    int32_t low = INT32_MIN, high = INT32_MAX;
+    switch (op) {
+        case COMPARE_EQ:
+        case COMPARE_NE:
+            low = high = value;
+            break;
+        case COMPARE_LT:
+            if (value == INT32_MIN) {
+                return selectNothing(result);
+            }
+            high = value - 1;
+            break;
+        case COMPARE_LE:
+            high = value;
+            break;
+        case COMPARE_GT:
+            if (value == INT32_MAX) {
+                return selectNothing(result);
+            }
+            low = value + 1;
+            break;
+        case COMPARE_GE:
+            low = value;
+            break;
+    }
+    return selectRange(store, column, low, high, op == COMPARE_NE, within, result);
+}
+
+bool storeSelectFloat(const ColumnStore* store, int column, CompareOp op, float value,
+                      const Selection* within, Selection* result) {
+    float low = -INFINITY, high = INFINITY;
+    switch (op) {
+        case COMPARE_EQ:
+        case COMPARE_NE:
+            low = high = value;
+            break;
+        case COMPARE_LT:
+            if (value == -INFINITY) {
+                return selectNothing(result);
+            }
+            high = nextafterf(value, -INFINITY);
+            break;
+        case COMPARE_LE:
+            high = value;
+            break;
+        case COMPARE_GT:
+            if (value == INFINITY) {
+                return selectNothing(result);
+            }
+            low = nextafterf(value, INFINITY);
+            break;
+        case COMPARE_GE:
+            low = value;
+            break;
+    }
+    const float* values = store->columns[column].values;
+    bool outside = op == COMPARE_NE;
+    if (within == NULL) {
+        if (!selectionReserve(result, store->rowCount)) {
+            return false;
+        }
+        result->count = filterFloat(values, store->rowCount, low, high, outside, result->rows);
+        return true;
+    }
+    if (!selectionReserve(result, within->count)) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < within->count; i++) {
+        uint32_t row = within->rows[i];
+        result->rows[n] = row;
+        n += (values[row] >= low && values[row] <= high) != outside;
+    }
+    result->count = n;
+    return true;
+}
+
+// Codes are below 2^31, so the int32 kernel compares them directly
+bool storeSelectString(const ColumnStore* store, int column, CompareOp op, const char* value,
+                       const Selection* within, Selection* result) {
+    if (op != COMPARE_EQ && op != COMPARE_NE) {
+        printf("String columns support only COMPARE_EQ and COMPARE_NE\n");
+        return false;
+    }
+    uint32_t code = dictionaryFind(store->columns[column].dictionary, value);
+    if (code == UINT32_MAX) {
+        return op == COMPARE_EQ ? selectNothing(result) : selectEverything(store, within, result);
+    }
+    return selectRange(store, column, (int32_t)code, (int32_t)code, op == COMPARE_NE, within, result);
+}
+
+int64_t storeSumInt(const ColumnStore* store, int column, const Selection* within) {
+    const int32_t* values = store->columns[column].values;
+    if (within == NULL) {
+        return sumInt32(values, store->rowCount);
+    }
+    int64_t sum = 0;
+    for (size_t i = 0; i < within->count; i++) {
+        sum += values[within->rows[i]];
+    }
+    return sum;
+}
+
+double storeSumFloat(const ColumnStore* store, int column, const Selection* within) {
+    const float* values = store->columns[column].values;
+    if (within == NULL) {
+        return sumFloat(values, store->rowCount);
+    }
+    double sum = 0;
+    for (size_t i = 0; i < within->count; i++) {
+        sum += values[within->rows[i]];
+    }
+    return sum;
+}
+
+// Four interleaved count arrays, so runs of the same code do not wait on
+// each other's increments
+bool storeGroupCount(const ColumnStore* store, int column, const Selection* within, uint64_t* counts) {
+    const uint32_t* codes = store->columns[column].values;
+    uint32_t distinct = storeDistinctCount(store, column);
+    uint64_t* partial = calloc((size_t)distinct * 4, sizeof(uint64_t));
+    if (partial == NULL) {
+        printf("Memory allocation failed\n");
+        return false;
+    }
+    size_t count = within != NULL ? within->count : store->rowCount;
+    size_t i = 0;
+    if (within == NULL) {
+        for (; i + 4 <= count; i += 4) {
+            partial[codes[i] * 4]++;
+            partial[codes[i + 1] * 4 + 1]++;
+            partial[codes[i + 2] * 4 + 2]++;
+            partial[codes[i + 3] * 4 + 3]++;
+        }
+        for (; i < count; i++) {
+            partial[codes[i] * 4]++;
+        }
+    } else {
+        const uint32_t* rows = within->rows;
+        for (; i + 4 <= count; i += 4) {
+            partial[codes[rows[i]] * 4]++;
+            partial[codes[rows[i + 1]] * 4 + 1]++;
+            partial[codes[rows[i + 2]] * 4 + 2]++;
+            partial[codes[rows[i + 3]] * 4 + 3]++;
+        }
+        for (; i < count; i++) {
+            partial[codes[rows[i]] * 4]++;
+        }
+    }
+    for (uint32_t code = 0; code < distinct; code++) {
+        counts[code] = partial[code * 4] + partial[code * 4 + 1] + partial[code * 4 + 2] + partial[code * 4 + 3];
+    }
+    free(partial);
+    return true;
+}
@@ -0,0 +1,134 @@
+/*
+ * column_store.h - Columnar (Struct-of-Arrays) Record Store
+ *
+ * "9. structure/structure.c" keeps a profile {name[10], address[10], age}
+ * per record, and docs/09-file-io/01-file-handling.md writes arrays of
+ * struct Student as they are in memory. Scanning one field of an array of
+ * structs reads every other field too: summing the ages of 24-byte profiles
+ * uses 4 bytes of every 24 loaded. This module stores the same records by
+ * column:
+ *
+ * - a schema of named, typed fields declared once with storeInit()
+ * - one 64-byte-aligned array per field: int32, float, or a string column
+ *   holding 32-bit codes into a per-column dictionary, where each distinct
+ *   string is kept once in an arena
+ * - filters (age > 60, address == "bbsr") that compare 8 (AVX2) or 16
+ *   (AVX-512) values per instruction and write the matching row numbers to
+ *   a selection vector; a filter can also refine an earlier selection
+ * - sums and per-string group counts over all rows or over a selection
+ *
+ * Row numbers are 32-bit, so a store holds fewer than 2^32 rows. String
+ * filters support COMPARE_EQ and COMPARE_NE only.
+ *
+ * The fastest variant for the CPU is picked at startup (see
+ * ../dispatch/cpu_dispatch.h). Compile together with column_store.c:
+ *   gcc -O2 -o program program.c column_store.c ../dispatch/cpu_dispatch.c
+ */
+
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    COLUMN_INT32,
+    COLUMN_FLOAT,
+    COLUMN_STRING
+} ColumnType;
+
+typedef struct {
+    const char* name;
+    ColumnType type;
+} FieldSpec;
+
+// Every distinct string of a column once, numbered in order of first use.
+// Code 0 is the empty string.
+typedef struct {
+    char* arena;              // the strings, '\0'-terminated, back to back
+    size_t arenaUsed;
+    size_t arenaCapacity;
+    uint32_t* offsets;        // offsets[code] = start of the string in arena
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* slots;          // hash table of code + 1, 0 = empty
+    uint32_t slotMask;
+} StringDictionary;
+
+typedef struct {
+    char name[32];
+    ColumnType type;
+    void* values;             // int32_t, float or uint32_t codes, one per row
+    StringDictionary* dictionary;   // COLUMN_STRING only
+} Column;
+
+typedef struct {
+    Column* columns;
+    int columnCount;
+    size_t rowCount;
+    size_t capacity;
+} ColumnStore;
+
+// Row numbers in increasing order. Filters keep room for 16 extra entries
+// past `count`, where the vector kernels may write.
+typedef struct {
+    uint32_t* rows;
+    size_t count;
+    size_t capacity;
+} Selection;
+
+typedef enum {
+    COMPARE_EQ,
+    COMPARE_NE,
+    COMPARE_LT,
+    COMPARE_LE,
+    COMPARE_GT,
+    COMPARE_GE
+} CompareOp;
+
+// ========== Building ==========
+
+bool storeInit(ColumnStore* store, const FieldSpec* schema, int fieldCount);
+void storeFree(ColumnStore* store);
+int storeFindColumn(const ColumnStore* store, const char* name);   // -1 if absent
+
+// Appends `count` rows set to 0, 0.0f and ""
+bool storeAddRows(ColumnStore* store, size_t count);
+
+void storeSetInt(ColumnStore* store, int column, size_t row, int32_t value);
+void storeSetFloat(ColumnStore* store, int column, size_t row, float value);
+bool storeSetString(ColumnStore* store, int column, size_t row, const char* value);
+
+int32_t storeGetInt(const ColumnStore* store, int column, size_t row);
+float storeGetFloat(const ColumnStore* store, int column, size_t row);
+// Valid until the next storeSetString() on the same column
+const char* storeGetString(const ColumnStore* store, int column, size_t row);
+
+// Dictionary of a string column: codes 0 .. storeDistinctCount() - 1
+uint32_t storeDistinctCount(const ColumnStore* store, int column);
+const char* storeDistinctString(const ColumnStore* store, int column, uint32_t code);
+
+// ========== Queries ==========
+
+bool selectionInit(Selection* selection, size_t capacity);
+void selectionFree(Selection* selection);
+
+// result = rows (all rows if `within` is NULL) whose value compares true
+// against `value`. `result` may be the same Selection as `within`.
+bool storeSelectInt(const ColumnStore* store, int column, CompareOp op, int32_t value,
+                    const Selection* within, Selection* result);
+bool storeSelectFloat(const ColumnStore* store, int column, CompareOp op, float value,
+                      const Selection* within, Selection* result);
+bool storeSelectString(const ColumnStore* store, int column, CompareOp op, const char* value,
+                       const Selection* within, Selection* result);
+
+// Over all rows if `within` is NULL
+int64_t storeSumInt(const ColumnStore* store, int column, const Selection* within);
+double storeSumFloat(const ColumnStore* store, int column, const Selection* within);
+
+// counts[code] = rows holding each string of the column's dictionary;
+// `counts` has storeDistinctCount() entries
+bool storeGroupCount(const ColumnStore* store, int column, const Selection* within, uint64_t* counts);
+
+#endif
@@ -0,0 +1,448 @@
+/*
+ * Column Store Demo: Profiles as Columns Instead of an Array of Structs
+ *
+ * Stores the profile records of "9. structure/structure.c", checks every
+ * filter and sum variant against plain loops (all six comparisons, edge
+ * values, NaN, refined selections), then runs the same queries over N
+ * profiles as an array of structs and as columns.
+ *
+ * Compile and run:
+ *   gcc -O2 -Wall -Wextra -o column_store_demo column_store_demo.c column_store.c ../dispatch/cpu_dispatch.c -lm
+ *   ./column_store_demo [rows in millions]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "column_store.h"
+#include "../dispatch/cpu_dispatch.h"
+
+// The struct of "9. structure/structure.c"
+typedef struct {
+    char name[10];
+    char address[10];
+    int age;
+} profile;
+
+static const char* cities[] = { "bbsr", "cuttack", "puri", "delhi", "mumbai", "kolkata", "chennai", "pune",
+                                "hyderabad", "jaipur", "lucknow", "patna", "bhopal", "indore", "surat", "nagpur" };
+#define CITY_COUNT 16
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (double)(end.tv_sec - start.tv_sec) +
+           (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static unsigned nextRandom(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool compareInt(int32_t x, CompareOp op, int32_t value) {
+    switch (op) {
+        case COMPARE_EQ: return x == value;
+        case COMPARE_NE: return x != value;
+        case COMPARE_LT: return x < value;
+        case COMPARE_LE: return x <= value;
+        case COMPARE_GT: return x > value;
+        case COMPARE_GE: return x >= value;
+    }
+    return false;
+}
+
+static bool compareFloat(float x, CompareOp op, float value) {
+    switch (op) {
+        case COMPARE_EQ: return x == value;
+        case COMPARE_NE: return x != value;
+        case COMPARE_LT: return x < value;
+        case COMPARE_LE: return x <= value;
+        case COMPARE_GT: return x > value;
+        case COMPARE_GE: return x >= value;
+    }
+    return false;
+}
+
+// ========== Checks ==========
+
+// A store of `rows` random records with an int, a float and a string
+// column, including the extreme values the range conversion must handle
+static bool buildCheckStore(ColumnStore* store, size_t rows, unsigned* seed) {
+    const FieldSpec schema[] = { { "id", COLUMN_INT32 }, { "gpa", COLUMN_FLOAT }, { "city", COLUMN_STRING } };
+    const int32_t specialInts[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX };
+    const float specialFloats[] = { -INFINITY, -0.0f, 0.0f, NAN, INFINITY, 1e-45f, 3.5f };
+    if (!storeInit(store, schema, 3) || !storeAddRows(store, rows)) {
+        return false;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        unsigned r = nextRandom(seed);
+        storeSetInt(store, 0, i, r % 8 == 0 ? specialInts[r / 8 % 7] : (int32_t)(r % 200) - 100);
+        storeSetFloat(store, 1, i, r % 16 == 1 ? specialFloats[r / 16 % 7] : (float)(r % 41) / 10.0f);
+        if (!storeSetString(store, 2, i, cities[r / 64 % CITY_COUNT])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameRows(const Selection* selection, const uint32_t* expected, size_t count) {
+    return selection->count == count && memcmp(selection->rows, expected, count * sizeof(uint32_t)) == 0;
+}
+
+// Every variant of one kernel must give the same selection as a plain loop
+static bool checkFilters(const ColumnStore* store, const char* kernelName, bool floats) {
+    const int32_t intValues[] = { INT32_MIN, INT32_MIN + 1, -50, -1, 0, 7, 99, INT32_MAX - 1, INT32_MAX };
+    const float floatValues[] = { -INFINITY, -0.0f, 0.0f, 1e-45f, 2.0f, 3.5f, 4.1f, INFINITY, NAN };
+    const DispatchKernel* kernel = dispatchFind(kernelName);
+    uint32_t* expected = malloc(store->rowCount * sizeof(uint32_t));
+    Selection selection, refined;
+    if (expected == NULL || !selectionInit(&selection, 0) || !selectionInit(&refined, 0)) {
+        free(expected);
+        return false;
+    }
+    bool ok = true;
+    for (int v = 0; v < kernel->variantCount && ok; v++) {
+        if (!dispatchUseVariant(kernel, v)) {
+            continue;
+        }
+        for (int op = COMPARE_EQ; op <= COMPARE_GE && ok; op++) {
+            for (int k = 0; k < 9 && ok; k++) {
+                size_t count = 0;
+                for (size_t row = 0; row < store->rowCount; row++) {
+                    bool match = floats ? compareFloat(storeGetFloat(store, 1, row), op, floatValues[k])
+                                        : compareInt(storeGetInt(store, 0, row), op, intValues[k]);
+                    if (match) {
+                        expected[count++] = (uint32_t)row;
+                    }
+                }
+                ok = (floats ? storeSelectFloat(store, 1, op, floatValues[k], NULL, &selection)
+                             : storeSelectInt(store, 0, op, intValues[k], NULL, &selection)) &&
+                     sameRows(&selection, expected, count);
+                // Refining "city != bbsr" by the same comparison
+                size_t refinedCount = 0;
+                for (size_t i = 0; i < count; i++) {
+                    if (strcmp(storeGetString(store, 2, expected[i]), "bbsr") != 0) {
+                        expected[refinedCount++] = expected[i];
+                    }
+                }
+                ok = ok && storeSelectString(store, 2, COMPARE_NE, "bbsr", NULL, &refined) &&
+                     (floats ? storeSelectFloat(store, 1, op, floatValues[k], &refined, &refined)
+                             : storeSelectInt(store, 0, op, intValues[k], &refined, &refined)) &&
+                     sameRows(&refined, expected, refinedCount);
+            }
+        }
+        if (!ok) {
+            printf("  %s differs\n", kernel->variants[v].name);
+        }
+    }
+    dispatchRestore(kernel);
+    selectionFree(&selection);
+    selectionFree(&refined);
+    free(expected);
+    return ok;
+}
+
+static bool checkAggregates(const ColumnStore* store) {
+    int64_t expectedSum = 0;
+    double expectedFloatSum = 0;
+    uint64_t expectedCounts[CITY_COUNT + 1] = { 0 };
+    uint64_t counts[CITY_COUNT + 1];
+    for (size_t row = 0; row < store->rowCount; row++) {
+        expectedSum += storeGetInt(store, 0, row);
+        float gpa = storeGetFloat(store, 1, row);
+        expectedFloatSum += isfinite(gpa) ? gpa : 0;
+    }
+    bool ok = storeDistinctCount(store, 2) == CITY_COUNT + 1 &&
+              strcmp(storeDistinctString(store, 2, 0), "") == 0;
+    for (size_t row = 0; row < store->rowCount && ok; row++) {
+        const char* city = storeGetString(store, 2, row);
+        for (uint32_t code = 1; code <= CITY_COUNT; code++) {
+            if (strcmp(storeDistinctString(store, 2, code), city) == 0) {
+                expectedCounts[code]++;
+            }
+        }
+    }
+    ok = ok && storeGroupCount(store, 2, NULL, counts) && memcmp(counts, expectedCounts, sizeof(counts)) == 0;
+
+    // The float column holds infinities and NaN: sum only the finite rows
+    Selection finite;
+    if (!selectionInit(&finite, 0)) {
+        return false;
+    }
+    ok = ok && storeSelectFloat(store, 1, COMPARE_GE, -1e30f, NULL, &finite) &&
+         storeSelectFloat(store, 1, COMPARE_LE, 1e30f, &finite, &finite);
+    ok = ok && fabs(storeSumFloat(store, 1, &finite) - expectedFloatSum) < 1e-9 * fabs(expectedFloatSum);
+    const DispatchKernel* kernel = dispatchFind("sumInt32");
+    for (int v = 0; v < kernel->variantCount && ok; v++) {
+        if (dispatchUseVariant(kernel, v)) {
+            ok = storeSumInt(store, 0, NULL) == expectedSum;
+            if (!ok) {
+                printf("  %s differs\n", kernel->variants[v].name);
+            }
+        }
+    }
+    dispatchRestore(kernel);
+    selectionFree(&finite);
+    return ok;
+}
+
+// The whole-column float sum, which goes through the dispatched kernel
+static bool checkFloatSumAllRows(unsigned* seed) {
+    const FieldSpec schema[] = { { "gpa", COLUMN_FLOAT } };
+    ColumnStore store;
+    const size_t rows = 100003;
+    if (!storeInit(&store, schema, 1) || !storeAddRows(&store, rows)) {
+        return false;
+    }
+    double expected = 0;
+    for (size_t i = 0; i < rows; i++) {
+        float gpa = (float)(nextRandom(seed) % 401) / 100.0f;
+        storeSetFloat(&store, 0, i, gpa);
+        expected += gpa;
+    }
+    const DispatchKernel* kernel = dispatchFind("sumFloat");
+    bool ok = true;
+    for (int v = 0; v < kernel->variantCount && ok; v++) {
+        if (dispatchUseVariant(kernel, v)) {
+            ok = fabs(storeSumFloat(&store, 0, NULL) - expected) < 1e-9 * expected;
+            if (!ok) {
+                printf("  %s differs\n", kernel->variants[v].name);
+            }
+        }
+    }
+    dispatchRestore(kernel);
+    storeFree(&store);
+    return ok;
+}
+
+// ========== Benchmark ==========
+
+// Row number of each city name in an array-of-structs scan: a small hash
+// table keyed by the first bytes, as a hand-written group-by would use
+typedef struct {
+    int slots[64];
+} CityIndex;
+
+static unsigned cityHash(const char* s) {
+    unsigned hash = 2166136261u;
+    while (*s != '\0') {
+        hash = (hash ^ (unsigned char)*s++) * 16777619u;
+    }
+    return hash & 63;
+}
+
+static void cityIndexInit(CityIndex* index) {
+    memset(index->slots, -1, sizeof(index->slots));
+    for (int c = 0; c < CITY_COUNT; c++) {
+        unsigned slot = cityHash(cities[c]);
+        while (index->slots[slot] >= 0) {
+            slot = (slot + 1) & 63;
+        }
+        index->slots[slot] = c;
+    }
+}
+
+static int cityLookup(const CityIndex* index, const char* name) {
+    unsigned slot = cityHash(name);
+    while (index->slots[slot] >= 0 && strcmp(cities[index->slots[slot]], name) != 0) {
+        slot = (slot + 1) & 63;
+    }
+    return index->slots[slot];
+}
+
+static void benchmark(size_t rows, unsigned* seed) {
+    struct timespec start, end;
+    printf("\n=== %zu profiles: array of structs (%zu bytes each) vs columns ===\n", rows, sizeof(profile));
+    profile* people = malloc(rows * sizeof(profile));
+    uint32_t* matches = malloc(rows * sizeof(uint32_t));
+    const FieldSpec schema[] = { { "name", COLUMN_STRING }, { "address", COLUMN_STRING }, { "age", COLUMN_INT32 } };
+    ColumnStore store;
+    Selection selection;
+    if (people == NULL || matches == NULL || !storeInit(&store, schema, 3) ||
+        !storeAddRows(&store, rows) || !selectionInit(&selection, rows)) {
+        printf("Memory allocation failed\n");
+        free(people);
+        free(matches);
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        unsigned r = nextRandom(seed);
+        snprintf(people[i].name, sizeof(people[i].name), "p%u", r % 100000);
+        strcpy(people[i].address, cities[r % CITY_COUNT]);
+        people[i].age = 18 + (int)(nextRandom(seed) % 63);
+    }
+    int nameColumn = storeFindColumn(&store, "name");
+    int addressColumn = storeFindColumn(&store, "address");
+    int ageColumn = storeFindColumn(&store, "age");
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < rows; i++) {
+        storeSetString(&store, nameColumn, i, people[i].name);
+        storeSetString(&store, addressColumn, i, people[i].address);
+        storeSetInt(&store, ageColumn, i, people[i].age);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Loading the columns: %.2f s, %u distinct names, %u addresses; %.0f MB vs %.0f MB\n",
+           elapsedSeconds(start, end), storeDistinctCount(&store, nameColumn) - 1,
+           storeDistinctCount(&store, addressColumn) - 1,
+           rows * 3 * sizeof(uint32_t) / 1e6, rows * sizeof(profile) / 1e6);
+    printf("%-34s %12s %12s %8s\n", "query", "structs", "columns", "speedup");
+
+    // age > 60
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t count = 0;
+    for (size_t i = 0; i < rows; i++) {
+        matches[count] = (uint32_t)i;
+        count += people[i].age > 60;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double baseline = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    storeSelectInt(&store, ageColumn, COMPARE_GT, 60, NULL, &selection);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsedSeconds(start, end);
+    printf("%-34s %9.1f ms %9.1f ms %7.1fx%s\n", "select age > 60", baseline * 1e3, seconds * 1e3,
+           baseline / seconds, sameRows(&selection, matches, count) ? "" : "  MISMATCH");
+
+    // sum(age)
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t sum = 0;
+    for (size_t i = 0; i < rows; i++) {
+        sum += people[i].age;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    baseline = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t columnSum = storeSumInt(&store, ageColumn, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("%-34s %9.1f ms %9.1f ms %7.1fx%s\n", "sum(age)", baseline * 1e3, seconds * 1e3,
+           baseline / seconds, sum == columnSum ? "" : "  MISMATCH");
+
+    // address == "bbsr"
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    count = 0;
+    for (size_t i = 0; i < rows; i++) {
+        matches[count] = (uint32_t)i;
+        count += strcmp(people[i].address, "bbsr") == 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    baseline = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    storeSelectString(&store, addressColumn, COMPARE_EQ, "bbsr", NULL, &selection);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("%-34s %9.1f ms %9.1f ms %7.1fx%s\n", "select address == \"bbsr\"", baseline * 1e3,
+           seconds * 1e3, baseline / seconds, sameRows(&selection, matches, count) ? "" : "  MISMATCH");
+
+    // sum(age) where address == "bbsr" and age > 60, refining the selection above
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sum = 0;
+    for (size_t i = 0; i < rows; i++) {
+        if (strcmp(people[i].address, "bbsr") == 0 && people[i].age > 60) {
+            sum += people[i].age;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    baseline = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    storeSelectString(&store, addressColumn, COMPARE_EQ, "bbsr", NULL, &selection);
+    storeSelectInt(&store, ageColumn, COMPARE_GT, 60, &selection, &selection);
+    columnSum = storeSumInt(&store, ageColumn, &selection);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    printf("%-34s %9.1f ms %9.1f ms %7.1fx%s\n", "sum(age) bbsr and age > 60", baseline * 1e3,
+           seconds * 1e3, baseline / seconds, sum == columnSum ? "" : "  MISMATCH");
+
+    // count(*) group by address
+    CityIndex index;
+    cityIndexInit(&index);
+    uint64_t structCounts[CITY_COUNT] = { 0 };
+    uint64_t* columnCounts = malloc(storeDistinctCount(&store, addressColumn) * sizeof(uint64_t));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < rows; i++) {
+        structCounts[cityLookup(&index, people[i].address)]++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    baseline = elapsedSeconds(start, end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = columnCounts != NULL && storeGroupCount(&store, addressColumn, NULL, columnCounts);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = elapsedSeconds(start, end);
+    for (int c = 0; c < CITY_COUNT && ok; c++) {
+        uint32_t code = 0;
+        while (strcmp(storeDistinctString(&store, addressColumn, code), cities[c]) != 0) {
+            code++;
+        }
+        ok = columnCounts[code] == structCounts[c];
+    }
+    printf("%-34s %9.1f ms %9.1f ms %7.1fx%s\n", "count(*) group by address", baseline * 1e3,
+           seconds * 1e3, baseline / seconds, ok ? "" : "  MISMATCH");
+
+    free(columnCounts);
+    free(people);
+    free(matches);
+    selectionFree(&selection);
+    storeFree(&store);
+}
+
+int main(int argc, char* argv[]) {
+    long long millions = argc > 1 ? atoll(argv[1]) : 50;
+    if (millions < 1 || millions > 1000) {
+        printf("Usage: %s [rows in millions, 1 to 1000]\n", argv[0]);
+        return 1;
+    }
+    dispatchPrint(stdout);
+
+    printf("\n=== Example: profiles as columns ===\n");
+    const FieldSpec schema[] = { { "name", COLUMN_STRING }, { "address", COLUMN_STRING }, { "age", COLUMN_INT32 } };
+    const profile people[] = { { "sinaya", "bbsr", 19 }, { "ravi", "cuttack", 64 },
+                               { "meera", "bbsr", 71 }, { "arjun", "puri", 35 }, { "kavya", "bbsr", 62 } };
+    ColumnStore store;
+    Selection selection;
+    if (!storeInit(&store, schema, 3) || !storeAddRows(&store, 5) || !selectionInit(&selection, 0)) {
+        return 1;
+    }
+    for (size_t i = 0; i < 5; i++) {
+        storeSetString(&store, 0, i, people[i].name);
+        storeSetString(&store, 1, i, people[i].address);
+        storeSetInt(&store, 2, i, people[i].age);
+    }
+    storeSelectString(&store, 1, COMPARE_EQ, "bbsr", NULL, &selection);
+    storeSelectInt(&store, 2, COMPARE_GT, 60, &selection, &selection);
+    printf("address == \"bbsr\" and age > 60:");
+    for (size_t i = 0; i < selection.count; i++) {
+        printf(" %s (%d)", storeGetString(&store, 0, selection.rows[i]), storeGetInt(&store, 2, selection.rows[i]));
+    }
+    printf(", sum(age) = %lld\n", (long long)storeSumInt(&store, 2, &selection));
+    uint64_t counts[4];
+    storeGroupCount(&store, 1, NULL, counts);
+    printf("count(*) group by address:");
+    for (uint32_t code = 1; code < storeDistinctCount(&store, 1); code++) {
+        printf(" %s %llu", storeDistinctString(&store, 1, code), (unsigned long long)counts[code]);
+    }
+    printf("\n");
+    selectionFree(&selection);
+    storeFree(&store);
+
+    unsigned seed = 2463534242u;
+    printf("\n=== Checks ===\n");
+    ColumnStore checkStore;
+    if (!buildCheckStore(&checkStore, 10007, &seed)) {
+        return 1;
+    }
+    bool intOk = checkFilters(&checkStore, "filterInt32", false);
+    printf("Int filters, 6 comparisons x 9 values, plain and refined: %s\n", intOk ? "all match" : "MISMATCH");
+    bool floatOk = checkFilters(&checkStore, "filterFloat", true);
+    printf("Float filters with +-0, infinities and NaN: %s\n", floatOk ? "all match" : "MISMATCH");
+    bool aggregateOk = checkAggregates(&checkStore) && checkFloatSumAllRows(&seed);
+    printf("Sums and group counts vs loops: %s\n", aggregateOk ? "all match" : "MISMATCH");
+    storeFree(&checkStore);
+
+    benchmark((size_t)millions * 1000000, &seed);
+    return intOk && floatOk && aggregateOk ? 0 : 1;
+}